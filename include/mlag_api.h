@@ -48,6 +48,18 @@
 #else
 #define EXTERN_API
 #endif
+
+/* FDB cursor, opaque to the caller */
+struct mlag_fdb_cursor;
+
+/* Notification subscription, opaque to the caller */
+struct mlag_notify_subscriber;
+
+/* Call queued by mlag_api_async_submit, returns its error code */
+typedef int (*mlag_api_async_call_t)(void *arg);
+
+/* Completion callback of an asynchronous call */
+typedef void (*mlag_api_async_cb_t)(int err, void *cookie);
 /************************************************
  *  Global variables
  ***********************************************/
@@ -297,6 +309,27 @@ mlag_api_counters_get(const unsigned int *ipl_ids,
 int
 mlag_api_counters_clear(void);
 
+/**
+ * Gets the queue delay and handler time histograms of the opcodes
+ * dispatched by MLAG since start or the last counters clear. The
+ * histograms are filled only when MLAG is built with
+ * --enable-event-latency.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[out] latency_list - Latency per opcode. Pointer to an already
+ *                            allocated memory structure.
+ * @param[in,out] latency_cnt - List size. On return, the number of entries
+ *                              retrieved.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_event_latency_get(struct mlag_event_latency *latency_list,
+                           unsigned int *latency_cnt);
+
 /**
  * Specifies the maximum period of time that MLAG ports are disabled after restarting
  * the feature.
@@ -367,6 +400,111 @@ mlag_api_keepalive_interval_set(const unsigned int sec);
 int
 mlag_api_keepalive_interval_get(unsigned int *sec);
 
+/**
+ * Specifies the keep-alive interval in milliseconds and the detection
+ * multiplier. Peer failure is detected after interval * multiplier
+ * milliseconds, where the interval is the slower of the local and
+ * remote intervals.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ *
+ * @param[in] params - Keep-alive timers.
+ *          Interval ranges from 50 to 30000 msec, inclusive.
+ *          Multiplier ranges from 2 to 255, inclusive.
+ *          Default is 1000 msec with multiplier 3.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_keepalive_params_set(const struct mlag_keepalive_params *params);
+
+/**
+ * Populates params with the current keep-alive interval in milliseconds
+ * and detection multiplier.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[out] params - Keep-alive timers.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_keepalive_params_get(struct mlag_keepalive_params *params);
+
+/**
+ * Sets the scheduling of the heartbeat thread. The thread serves
+ * keep-alive Tx, Rx and timeouts, running it with a real time priority
+ * and pinning it keeps peer failure detection on time under load.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] params - Heartbeat thread priority and CPU.
+ *          Priority ranges from 0 (default policy) to 99, inclusive.
+ *          CPU ranges from -1 (not pinned) to 1023, inclusive.
+ *          Default is priority 0, not pinned.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_heartbeat_thread_params_set(
+    const struct mlag_heartbeat_thread_params *params);
+
+/**
+ * Populates params with the current scheduling of the heartbeat thread.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[out] params - Heartbeat thread priority and CPU.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_heartbeat_thread_params_get(
+    struct mlag_heartbeat_thread_params *params);
+
+/**
+ * Sets the suppression of IGMP packets tunneled to the peer. Reports for
+ * the same group, VLAN and port are forwarded once per suppression window,
+ * and each IGMP type is rate limited.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ *
+ * @param[in] params - Suppression window and rate limit.
+ *          Window ranges from 0 to 60000 msec, inclusive.
+ *          Rate limit ranges from 0 to 65535 packets per second, inclusive.
+ *          0 selects the default, 1000 for both.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_igmp_params_set(const struct mlag_igmp_params *params);
+
+/**
+ * Populates params with the tunneled IGMP suppression parameters in use.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[out] params - Suppression window and rate limit.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_igmp_params_get(struct mlag_igmp_params *params);
+
 /**
  * Adds/deletes MLAG port.
  * This function works asynchronously. After verifying its arguments are valid,
@@ -384,6 +522,47 @@ int
 mlag_api_port_set(const enum access_cmd access_cmd,
                   const unsigned long port_id);
 
+/**
+ * Adds/deletes several MLAG ports in one operation.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately. The progress of each port
+ * is retrieved with mlag_api_ports_cfg_state_get. Ports that do not fit in
+ * one API message are sent in several messages, each queued as an operation
+ * of its own, so an error may leave the earlier ones queued.
+ *
+ * @param[in] access_cmd - Add/Delete.
+ * @param[in] ports - Interface indexes of ports. Must represent MLAG ports.
+ * @param[in] ports_cnt - Number of ports, up to the maximum number of
+ *                        MLAG ports.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - Too many port operations are still pending.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_ports_set(const enum access_cmd access_cmd,
+                   const unsigned long *ports,
+                   const unsigned int ports_cnt);
+
+/**
+ * Populates the add/delete progress of the given ports.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in,out] ports_cfg - Ports to query. In: port_id of each entry.
+ *                            Out: state of each entry.
+ * @param[in] ports_cnt - Number of entries in ports_cfg.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_ports_cfg_state_get(struct mlag_port_cfg_info *ports_cfg,
+                             const unsigned int ports_cnt);
+
 /**
  * Creates/deletes an IPL.
  * This function works synchronously and blocks until the operation is completed.
@@ -650,6 +829,151 @@ mlag_api_fdb_uc_mac_addr_get(const enum access_cmd access_cmd,
                              struct fdb_uc_mac_addr_params *mac_list,
                              unsigned short *data_cnt);
 
+/**
+ * Opens a cursor on the SW FDB table. The cursor is read page by page
+ * until it returns no more entries, the entries are passed through
+ * shared memory so a full table takes a handful of calls.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] key_filter - Filter types used on the entries -
+ *                         vid / logical port.
+ * @param[out] cursor - Cursor, to be closed by mlag_api_fdb_cursor_close.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - Too many cursors are open.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_fdb_cursor_open(const struct fdb_uc_key_filter *key_filter,
+                         struct mlag_fdb_cursor **cursor);
+
+/**
+ * Reads the next MAC entries of an FDB cursor.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] cursor - Cursor.
+ * @param[out] mac_list - Mac record array. Pointer to an already allocated memory
+ *                        structure.
+ * @param[in,out] data_cnt - Number of macs to retrieve. On return, the number of
+ *                           macs retrieved, 0 when the cursor reached the end.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOENT - Cursor was closed by MLAG after being idle.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_fdb_cursor_read(struct mlag_fdb_cursor *cursor,
+                         struct fdb_uc_mac_addr_params *mac_list,
+                         unsigned int *data_cnt);
+
+/**
+ * Closes an FDB cursor and frees it.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] cursor - Cursor.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ */
+int
+mlag_api_fdb_cursor_close(struct mlag_fdb_cursor *cursor);
+
+/**
+ * Subscribes to MLAG notifications. Notifications of the types in the
+ * interest mask are pushed by MLAG to a ring in shared memory, and the
+ * returned eventfd becomes readable when the ring gets notifications,
+ * so the caller can poll it with its other descriptors instead of
+ * polling MLAG.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] interest_mask - Notification types, MLAG_NOTIFY_MASK bits.
+ * @param[out] subscriber - Subscription, to be ended by
+ *                          mlag_api_notify_unsubscribe.
+ * @param[out] event_fd - Descriptor to poll for readability.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - Too many subscribers.
+ * @return -EIO - Network problem or operation failure.
+ */
+int
+mlag_api_notify_subscribe(unsigned int interest_mask,
+                          struct mlag_notify_subscriber **subscriber,
+                          int *event_fd);
+
+/**
+ * Reads the pending notifications of a subscription. It does not
+ * block, it is called when the eventfd of the subscription is readable
+ * and again until it returns no notifications.
+ *
+ * @param[in] subscriber - Subscription.
+ * @param[out] notification_list - Notification array. Pointer to an
+ *                                 already allocated memory structure.
+ * @param[in,out] data_cnt - Number of notifications to retrieve. On
+ *                           return, the number of notifications retrieved.
+ * @param[out] dropped - Optional, notifications dropped so far because
+ *                       the subscriber did not read them in time.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ */
+int
+mlag_api_notify_read(struct mlag_notify_subscriber *subscriber,
+                     struct mlag_notification *notification_list,
+                     unsigned int *data_cnt,
+                     unsigned long long *dropped);
+
+/**
+ * Ends a subscription, closes its eventfd and frees it.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] subscriber - Subscription.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ */
+int
+mlag_api_notify_unsubscribe(struct mlag_notify_subscriber *subscriber);
+
+/**
+ * Queues a call of the MLAG API to run asynchronously. Calls run in
+ * parallel by a pool of workers, each on its own connection, so several
+ * requests are in flight at the same time, and each one reports its
+ * result to its completion callback.
+ * This function works asynchronously. It blocks only while the queue is full.
+ *
+ * @param[in] call - Call to run, it makes one or more MLAG API calls and
+ *                   returns the error code to be reported.
+ * @param[in] arg - Argument of the call.
+ * @param[in] done_cb - Optional completion callback, called from a
+ *                      worker thread with the call result.
+ * @param[in] cookie - Argument of the completion callback.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Operation failure.
+ */
+int
+mlag_api_async_submit(mlag_api_async_call_t call, void *arg,
+                      mlag_api_async_cb_t done_cb, void *cookie);
+
+/**
+ * Waits until all asynchronous calls queued so far, and their
+ * completion callbacks, are done. Must not be called from a completion
+ * callback.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @return 0 - Operation completed successfully.
+ */
+int
+mlag_api_async_flush(void);
+
 /**
  * Initializes the control learning library.
  * This function works synchronously and blocks until the operation is completed.
@@ -796,6 +1120,29 @@ mlag_api_lacp_selection_request(const enum access_cmd access_cmd,
                                 const unsigned int partner_key,
                                 const unsigned char force);
 
+/**
+ * Triggers aggregator selection queries of several ports in one operation.
+ * Since MLAG is distributed, this request may involve a remote peer, so
+ * this function works asynchronously. Selections are decided together, up
+ * to as many as fit in one API message, and the response of each one is
+ * guaranteed and issued as a notification, the same as for
+ * mlag_api_lacp_selection_request. Force is not yet supported, and should
+ * be set to 0.
+ *
+ * @param[in] selections - selection queries, request_id of each one will
+ *                         appear in its reply.
+ * @param[in] selections_cnt - Number of selections, up to the maximum number
+ *                             of MLAG ports.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_lacp_selections_request(const struct lacp_selection_info *selections,
+                                 const unsigned int selections_cnt);
+
 /**
  * Sets the local system ID for LACP PDUs. This API should be called before
  * starting mlag protocol when LACP is enabled.
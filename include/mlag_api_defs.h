@@ -50,8 +50,25 @@
 #define MLAG_KEEPALIVE_INTERVAL_MIN 1
 #define MLAG_KEEPALIVE_INTERVAL_MAX 30
 /* if change value, then update the validations occur in mlag_api.c and mlag_internal_api.c */
+#define MLAG_KEEPALIVE_INTERVAL_MSEC_MIN 50
+#define MLAG_KEEPALIVE_INTERVAL_MSEC_MAX (MLAG_KEEPALIVE_INTERVAL_MAX * 1000)
+#define MLAG_KEEPALIVE_MULTIPLIER_MIN 2
+#define MLAG_KEEPALIVE_MULTIPLIER_MAX 255
+/* if change value, then update the validations occur in mlag_api.c and mlag_internal_api.c */
+#define MLAG_HEARTBEAT_THREAD_RT_PRIO_MAX 99
+#define MLAG_HEARTBEAT_THREAD_CPU_MAX 1023
+/* if change value, then update the validations occur in mlag_api.c and mlag_internal_api.c */
 #define MLAG_VLAN_ID_MIN 1
 #define MLAG_VLAN_ID_MAX 4095
+/* if change value, then update the validations occur in mlag_api.c and mlag_internal_api.c */
+#define MLAG_IGMP_SUPPRESS_WINDOW_MSEC_DEFAULT 1000
+#define MLAG_IGMP_SUPPRESS_WINDOW_MSEC_MAX 60000
+#define MLAG_IGMP_RATE_LIMIT_DEFAULT 1000
+#define MLAG_IGMP_RATE_LIMIT_MAX 65535
+/* Event latency histogram buckets, bucket 0 counts samples under 1 usec,
+ * bucket i counts samples of [2^(i-1), 2^i) usec, the last one counts
+ * all longer samples */
+#define MLAG_EVENT_LATENCY_BUCKETS 24
 
 #define ACCESS_COMMAND_STR(index) ((ACCESS_CMD_LAST > \
                                     index) ? access_command_str[index] : \
@@ -64,11 +81,61 @@
  *  Type definitions
  ***********************************************/
 
+/**
+ * Keep-alive timers. Peers exchange their desired interval and
+ * each pair runs at the slower one, a peer is declared down after
+ * multiplier intervals without keep-alive messages.
+ */
+struct mlag_keepalive_params {
+    unsigned int interval_msec;
+    unsigned int multiplier;
+};
+
+/**
+ * Heartbeat thread scheduling. A positive rt_priority runs the thread
+ * with SCHED_FIFO at that priority, 0 with the default policy. A
+ * non negative cpu pins the thread to that CPU, -1 leaves it unpinned.
+ */
+struct mlag_heartbeat_thread_params {
+    int rt_priority;
+    int cpu;
+};
+
+/**
+ * Tunneled IGMP suppression. Reports for the same group, VLAN and port
+ * within suppress_window_msec are forwarded to the peer once, and at
+ * most rate_limit packets per second of each IGMP type are forwarded.
+ * A member set to 0 selects its default.
+ */
+struct mlag_igmp_params {
+    unsigned int suppress_window_msec;
+    unsigned int rate_limit;
+};
+
 struct port_state_info {
     enum oes_port_oper_state port_state;
     unsigned long port_id;
 };
 
+/**
+ * Progress of a port add/delete requested by mlag_api_ports_set.
+ */
+enum mlag_port_cfg_state {
+    MLAG_PORT_CFG_STATE_NONE = 0, /* no request known for the port */
+    MLAG_PORT_CFG_STATE_ADD_PENDING,
+    MLAG_PORT_CFG_STATE_ADDED,
+    MLAG_PORT_CFG_STATE_DELETE_PENDING,
+    MLAG_PORT_CFG_STATE_DELETED,
+    MLAG_PORT_CFG_STATE_FAILED,
+
+    MLAG_PORT_CFG_STATE_LAST
+};
+
+struct mlag_port_cfg_info {
+    unsigned long port_id;
+    enum mlag_port_cfg_state state;
+};
+
 enum vlan_state {
     VLAN_UP = 0,
     VLAN_DOWN,
@@ -228,6 +295,162 @@ enum mlag_port_mode {
     MLAG_PORT_MODE_LAST
 };
 
+/**
+ * One aggregator selection of a batch requested by
+ * mlag_api_lacp_selections_request.
+ */
+struct lacp_selection_info {
+    unsigned int request_id;
+    unsigned long port_id;
+    unsigned long long partner_sys_id;
+    unsigned int partner_key;
+    unsigned char force;
+};
+
+
+/**
+ * mlag_notification_type enum is used to define
+ * possible notifications coming from MLAG protocol
+ */
+enum mlag_notification_type {
+    MLAG_NOTIFY_AGGREGATOR_RESPONSE,
+    MLAG_NOTIFY_AGGREGATOR_RELEASE,
+    MLAG_NOTIFY_LACP_SYSTEM_ID_CHANGE,
+    MLAG_NOTIFY_PORT_OPER_STATE_CHANGE,
+    MLAG_NOTIFY_PEER_STATE_CHANGE,
+    MLAG_NOTIFY_ROLE_CHANGE,
+    MLAG_NOTIFY_MAC_SYNC_MILESTONE,
+    MLAG_NOTIFY_LAST
+};
+
+/* Interest mask bit of a notification type */
+#define MLAG_NOTIFY_MASK(type) (1U << (type))
+#define MLAG_NOTIFY_MASK_ALL   (MLAG_NOTIFY_MASK(MLAG_NOTIFY_LAST) - 1)
+
+/**
+ * mlag_lacp_aggregator_response struct contains
+ * response information for LACP aggregator requests
+ * issued
+ */
+struct mlag_lacp_aggregator_response {
+    unsigned int request_id;
+    unsigned int response;
+    unsigned long req_port_id;
+    unsigned long long req_partner_id;
+    unsigned int req_partner_key;
+};
+
+/**
+ * mlag_lacp_aggregator_release struct is
+ * used for notifying aggregator information
+ * for a certain port is no longer valid
+ */
+struct mlag_lacp_aggregator_release {
+    unsigned long port_id;
+};
+
+/**
+ * mlag_lacp_aggregator_release struct is
+ * used for notifying aggregator information
+ * for a certain port is no longer valid
+ */
+struct mlag_lacp_sys_id_change {
+    unsigned char active;
+    unsigned long long system_id;
+};
+
+/**
+ * mlag_port_oper_state_change struct is used for notifying
+ * the operational state of a port after its global state changed
+ */
+struct mlag_port_oper_state_change {
+    unsigned long port_id;
+    enum mlag_port_oper_state port_oper_state;
+};
+
+/**
+ * mlag_peer_state_change struct is used for notifying
+ * a peer state change
+ */
+struct mlag_peer_state_change {
+    unsigned int mlag_id;
+    enum mlag_peer_state peer_state;
+};
+
+/**
+ * mlag_role_change struct is used for notifying
+ * a system role change
+ */
+struct mlag_role_change {
+    enum system_role_state previous_role;
+    enum system_role_state role;
+};
+
+/**
+ * MAC sync progress of a peer.
+ */
+enum mlag_mac_sync_milestone {
+    MLAG_MAC_SYNC_PEER_START = 0,
+    MLAG_MAC_SYNC_PEER_DONE,
+};
+
+/**
+ * mlag_mac_sync_milestone_info struct is used for notifying
+ * MAC sync progress
+ */
+struct mlag_mac_sync_milestone_info {
+    unsigned int mlag_id;
+    enum mlag_mac_sync_milestone milestone;
+};
+
+/**
+ * mlag_notification_info union contains
+ * different types of notification data fields
+ */
+union mlag_notification_info {
+    struct mlag_lacp_aggregator_response agg_response;
+    struct mlag_lacp_aggregator_release agg_release;
+    struct mlag_lacp_sys_id_change sys_id_change;
+    struct mlag_port_oper_state_change port_state;
+    struct mlag_peer_state_change peer_state;
+    struct mlag_role_change role_change;
+    struct mlag_mac_sync_milestone_info mac_sync;
+};
+
+/**
+ * mlag_notification struct contains
+ * MLAG notifications attributes
+ */
+struct mlag_notification {
+    enum mlag_notification_type notification_type;
+    union mlag_notification_info notification_info;
+};
+
+/**
+ * Source of a dispatched command.
+ */
+enum mlag_event_latency_source {
+    MLAG_EVENT_LATENCY_SYS_EVENT = 0,
+    MLAG_EVENT_LATENCY_IPL_MSG,
+    MLAG_EVENT_LATENCY_SOURCE_NUM
+};
+
+/**
+ * mlag_event_latency struct holds the latency histograms of one opcode.
+ * Queue delay of a system event is the time from its generation until
+ * its handler starts. Queue delay of an IPL message is the time from
+ * its send on the peer until its handler starts, and includes the
+ * clock offset between the peers.
+ */
+struct mlag_event_latency {
+    unsigned short opcode;
+    enum mlag_event_latency_source source;
+    unsigned long long count;
+    unsigned long long queue_max_usec;
+    unsigned long long handler_max_usec;
+    unsigned long long queue_hist[MLAG_EVENT_LATENCY_BUCKETS];
+    unsigned long long handler_hist[MLAG_EVENT_LATENCY_BUCKETS];
+};
 
 /************************************************
  *  Global variables
@@ -0,0 +1,187 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MLAG_SNAPSHOT_H_
+#define MLAG_SNAPSHOT_H_
+
+#include <stdint.h>
+#include "mlag_api_defs.h"
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* Shared memory region MLAG publishes its state in */
+#define MLAG_SNAPSHOT_SHM_NAME      "/mlag_snapshot"
+#define MLAG_SNAPSHOT_MAGIC         0x4d4c5353
+/* Changed when the layout below changes */
+#define MLAG_SNAPSHOT_VERSION       1
+
+/* Peers and ports, MLAG_MAX_PEERS times MLAG_MAX_PORTS_LIMIT */
+#define MLAG_SNAPSHOT_MAX_PEERS     2
+#define MLAG_SNAPSHOT_MAX_PORTS     (MLAG_SNAPSHOT_MAX_PEERS * 4096)
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+/**
+ * mlag_snapshot_state structure holds the state MLAG publishes,
+ * as the getters of mlag_api.h return it
+ */
+struct mlag_snapshot_state {
+    unsigned long long publish_count;
+    enum protocol_oper_state protocol_oper_state;
+    enum system_role_state system_role_state;
+    unsigned int peers_num;
+    struct peer_state peers[MLAG_SNAPSHOT_MAX_PEERS];
+    struct mlag_counters counters;
+    unsigned int ports_num;
+    struct mlag_port_info ports[MLAG_SNAPSHOT_MAX_PORTS];
+};
+
+/**
+ * mlag_snapshot structure is the layout of the shared memory region.
+ * The state is protected by a sequence lock, seq is odd while MLAG
+ * updates it.
+ */
+struct mlag_snapshot {
+    uint32_t magic;
+    uint32_t version;
+    volatile uint32_t seq;
+    struct mlag_snapshot_state state;
+};
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ * Maps the state snapshot published by MLAG. The getters below read
+ * the mapping and make no system call.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - MLAG does not publish a snapshot.
+ * @return -EPROTO - Snapshot layout version differs.
+ * @return -EIO - Operation failure.
+ */
+int
+mlag_snapshot_open(void);
+
+/**
+ * Unmaps the state snapshot.
+ *
+ * @return 0 - Operation completed successfully.
+ */
+int
+mlag_snapshot_close(void);
+
+/**
+ * Gets a consistent copy of the whole published state.
+ *
+ * @param[out] state - MLAG state, ports beyond ports_num are not copied.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Snapshot is not open.
+ * @return -EAGAIN - MLAG did not publish yet.
+ */
+int
+mlag_snapshot_state_get(struct mlag_snapshot_state *state);
+
+/**
+ * Gets the mlag ports state, as mlag_api_ports_state_get.
+ *
+ * @param[out] mlag_ports_information - Mlag ports. Pointer to an already allocated
+ *                                      memory structure.
+ * @param[in,out] mlag_ports_cnt - Number of ports to retrieve. On return, the
+ *                                 number of ports retrieved.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Snapshot is not open.
+ * @return -EAGAIN - MLAG did not publish yet.
+ */
+int
+mlag_snapshot_ports_state_get(struct mlag_port_info *mlag_ports_information,
+                              unsigned int *mlag_ports_cnt);
+
+/**
+ * Gets the peers state, as mlag_api_peers_state_list_get.
+ *
+ * @param[out] peers_list - Peers list state. Pointer to an already allocated
+ *                          memory structure.
+ * @param[in,out] peers_list_cnt - Number of peers to retrieve. On return, the
+ *                                 number of peers retrieved.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Snapshot is not open.
+ * @return -EAGAIN - MLAG did not publish yet.
+ */
+int
+mlag_snapshot_peers_state_list_get(struct peer_state *peers_list,
+                                   unsigned int *peers_list_cnt);
+
+/**
+ * Gets the protocol operational state and the system role, as
+ * mlag_api_protocol_oper_state_get and mlag_api_system_role_state_get.
+ *
+ * @param[out] protocol_oper_state - Protocol operational state.
+ * @param[out] system_role_state - System role state.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Snapshot is not open.
+ * @return -EAGAIN - MLAG did not publish yet.
+ */
+int
+mlag_snapshot_oper_state_get(enum protocol_oper_state *protocol_oper_state,
+                             enum system_role_state *system_role_state);
+
+/**
+ * Gets the mlag protocol counters, as mlag_api_counters_get.
+ *
+ * @param[out] counters - Mlag protocol counters.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Snapshot is not open.
+ * @return -EAGAIN - MLAG did not publish yet.
+ */
+int
+mlag_snapshot_counters_get(struct mlag_counters *counters);
+
+#endif /* MLAG_SNAPSHOT_H_ */
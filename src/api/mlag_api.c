@@ -26,6 +26,12 @@
  */
 
 #include <stdlib.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <complib/sx_rpc.h>
 #include <complib/cl_mem.h>
 #include "mlag_api.h"
@@ -41,6 +47,17 @@
 #undef  __MODULE__
 #define __MODULE__ MLAG_API
 
+/* Concurrent calls, one RPC socket each */
+#ifndef MLAG_API_HANDLE_POOL_SIZE
+#define MLAG_API_HANDLE_POOL_SIZE 8
+#endif
+
+/* Asynchronous calls run by worker threads, each one holds a handle
+ * of the pool while it runs a call
+ */
+#define MLAG_API_ASYNC_WORKERS     MLAG_API_HANDLE_POOL_SIZE
+#define MLAG_API_ASYNC_QUEUE_SIZE  256
+
 /************************************************
  *  Local Macros
  ***********************************************/
@@ -49,6 +66,63 @@
  *  Local Type definitions
  ***********************************************/
 #define NA 0
+
+/* Handle to RPC operations, used by one thread at a time */
+struct handle_pool_entry {
+    mlag_handle_t handle;
+    int is_open;
+    int busy;
+};
+
+struct handle_pool {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct handle_pool_entry entries[MLAG_API_HANDLE_POOL_SIZE];
+};
+
+/* Asynchronous call waiting for a worker */
+struct async_call {
+    mlag_api_async_call_t call;
+    void *arg;
+    mlag_api_async_cb_t done_cb;
+    void *cookie;
+};
+
+struct async_queue {
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    pthread_cond_t idle;
+    struct async_call calls[MLAG_API_ASYNC_QUEUE_SIZE];
+    unsigned int head;
+    unsigned int queued;
+    /* queued and running calls */
+    unsigned int pending;
+    int started;
+    int stop;
+    pthread_t workers[MLAG_API_ASYNC_WORKERS];
+};
+
+/* Client side of an FDB cursor, entries of the current page are taken
+ * from the mapped cursor page until it is consumed
+ */
+struct mlag_fdb_cursor {
+    unsigned int cursor_id;
+    struct fdb_uc_mac_addr_params *page;
+    unsigned int capacity;
+    unsigned int page_cnt;
+    unsigned int page_pos;
+    int eof;
+};
+
+/* Client side of a notification subscription, the subscriber is the
+ * only writer of the ring tail
+ */
+struct mlag_notify_subscriber {
+    unsigned int subscriber_id;
+    struct mlag_notify_ring *ring;
+    int event_fd;
+};
 /************************************************
  *  Global variables
  ***********************************************/
@@ -58,6 +132,18 @@ EXTERN_API int (*g_connector_api_deinit_func)(void);
  ***********************************************/
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
 
+static struct handle_pool handle_pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static struct async_queue async_queue = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .not_empty = PTHREAD_COND_INITIALIZER,
+    .not_full = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+};
+
 static const char *access_command_str[ACCESS_CMD_LAST] = {
     "Add",
     "Delete",
@@ -69,6 +155,7 @@ static const char *access_command_str[ACCESS_CMD_LAST] = {
 /************************************************
  *  Local function declarations
  ***********************************************/
+static void put_handle(int slot, int broken);
 
 /*
  * Populates handle with a new open channel to RPC operations.
@@ -102,36 +189,115 @@ bail:
 }
 
 /*
- * Gets the handle to RPC operations.
- * This function works synchronously and blocks until the operation is completed.
+ * Closes an RPC handle.
  *
- * @param[out] mlag_handle - RPC handle.
+ * @param[in] handle - RPC handle.
  *
  * @return 0 - Operation completed successfully.
  * @return -EINVAL - If an input parameter is invalid.
  * @return -EIO - Operation failure.
  */
 static int
-get_handle(mlag_handle_t *mlag_handle)
+release_handle(mlag_handle_t *handle)
 {
     int err = 0;
-    static mlag_handle_t handle = 0; /* The connection handle */
-    static int is_initalize = FALSE;
 
-    if (is_initalize == FALSE) {
-        err = open_handle(&handle);
+    err = sx_rpc_close((sx_rpc_handle_t *)handle);
+    if (err == SX_RPC_STATUS_PARAM_NULL) {
+        err = -EINVAL;
+    }
+    else if (err == SX_RPC_STATUS_ERROR) {
+        err = -EIO;
+    }
+    MLAG_BAIL_ERROR_MSG(err,
+                        "Failed to close RPC socket\n");
+
+bail:
+    return err;
+}
+
+/*
+ * Takes a handle to RPC operations from the pool. The handle is used
+ * by the calling thread only, until it is put back. When all handles
+ * are in use, it waits for one to be put back.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[out] slot - Index of the handle in the pool.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Operation failure.
+ */
+static int
+get_handle(int *slot)
+{
+    int err = 0;
+    int i;
+    struct handle_pool_entry *entry = NULL;
+
+    pthread_mutex_lock(&handle_pool.mutex);
+    while (entry == NULL) {
+        /* prefer an open handle */
+        for (i = 0; i < MLAG_API_HANDLE_POOL_SIZE; i++) {
+            if (!handle_pool.entries[i].busy) {
+                if (handle_pool.entries[i].is_open) {
+                    entry = &handle_pool.entries[i];
+                    break;
+                }
+                if (entry == NULL) {
+                    entry = &handle_pool.entries[i];
+                }
+            }
+        }
+        if (entry == NULL) {
+            pthread_cond_wait(&handle_pool.cond, &handle_pool.mutex);
+        }
+    }
+    entry->busy = TRUE;
+    pthread_mutex_unlock(&handle_pool.mutex);
+
+    /* connect outside the lock, the entry is ours now */
+    if (!entry->is_open) {
+        err = open_handle(&entry->handle);
+        if (err) {
+            put_handle(entry - handle_pool.entries, FALSE);
+        }
         MLAG_BAIL_ERROR_MSG(err,
                             "Failed to open a handle\n");
-
-        is_initalize = TRUE;
+        entry->is_open = TRUE;
     }
 
-    *mlag_handle = handle;
+    *slot = entry - handle_pool.entries;
 
 bail:
     return err;
 }
 
+/*
+ * Puts back a handle taken by get_handle.
+ *
+ * @param[in] slot - Index of the handle in the pool.
+ * @param[in] broken - TRUE if the handle failed, it is closed and the
+ *                     next user opens it again.
+ *
+ * @return void
+ */
+static void
+put_handle(int slot, int broken)
+{
+    struct handle_pool_entry *entry = &handle_pool.entries[slot];
+
+    if (broken && entry->is_open) {
+        release_handle(&entry->handle);
+        entry->is_open = FALSE;
+    }
+
+    pthread_mutex_lock(&handle_pool.mutex);
+    entry->busy = FALSE;
+    pthread_cond_signal(&handle_pool.cond);
+    pthread_mutex_unlock(&handle_pool.mutex);
+}
+
 /*
  * Sends command wrapper.
  * This function works synchronously and blocks until the operation is completed.
@@ -157,7 +323,7 @@ mlag_api_send_command_wrapper(uint32_t opcode,
     sx_rpc_api_command_head_t cmd_head;
     sx_rpc_api_reply_head_t reply_head;
     uint32_t get_msg_body = 0;
-    mlag_handle_t handle = 0;
+    int slot = -1;
 
     memset(&reply_head, 0, sizeof(reply_head));
     memset(&cmd_head, 0, sizeof(cmd_head));
@@ -166,14 +332,14 @@ mlag_api_send_command_wrapper(uint32_t opcode,
     cmd_head.version = 1;
     cmd_head.msg_size = sizeof(sx_rpc_api_command_head_t) + cmd_size;
 
-    err = get_handle(&handle);
+    err = get_handle(&slot);
     MLAG_BAIL_ERROR_MSG(err, "Failed to get handle\n")
 
     MLAG_LOG(MLAG_LOG_DEBUG,
              "Send command wrapper. The command is [%u]\n",
              opcode);
 
-    err = sx_rpc_send_command_decoupled(handle,
+    err = sx_rpc_send_command_decoupled(handle_pool.entries[slot].handle,
                                         &cmd_head,
                                         cmd_body_p,
                                         &reply_head,
@@ -182,6 +348,9 @@ mlag_api_send_command_wrapper(uint32_t opcode,
     if ((err != SX_RPC_STATUS_SUCCESS) && (err > 0)) {
         /* mlag api return codes is based on -errno */
         err = -EIO;
+        /* the reply may still be on the way, don't reuse the socket */
+        put_handle(slot, TRUE);
+        slot = -1;
 
         MLAG_BAIL_ERROR_MSG(err,
                             "sx_rpc_send_command_decoupled failed. Error code %d returned\n",
@@ -199,45 +368,158 @@ mlag_api_send_command_wrapper(uint32_t opcode,
     }
 
 bail:
+    if (slot >= 0) {
+        put_handle(slot, FALSE);
+    }
     return err;
 }
 
 /*
- * Closes the open channel to RPC operations.
+ * Closes the open channels to RPC operations.
  * This function works synchronously and blocks until the operation is completed.
  *
- * @param[in] handle - RPC handle.
- *
  * @return 0 - Operation completed successfully.
  * @return -EINVAL - If an input parameter is invalid.
  * @return -EIO - Operation failure.
  */
-
 static int
 close_handle()
 {
     int err = 0;
-    mlag_handle_t handle;
+    int i;
+    struct handle_pool_entry *entry;
+
+    pthread_mutex_lock(&handle_pool.mutex);
+    for (i = 0; i < MLAG_API_HANDLE_POOL_SIZE; i++) {
+        entry = &handle_pool.entries[i];
+        /* a busy handle is closed by its user when it fails */
+        if (entry->is_open && !entry->busy) {
+            err = release_handle(&entry->handle);
+            if (err) {
+                break;
+            }
+            entry->is_open = FALSE;
+        }
+    }
+    pthread_mutex_unlock(&handle_pool.mutex);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to close the RPC handles\n");
 
-    err = get_handle(&handle);
-    MLAG_BAIL_ERROR_MSG(err, "Failed to get handle\n")
+    MLAG_LOG(MLAG_LOG_DEBUG, "Closed RPC socket\n");
 
-    err = sx_rpc_close((sx_rpc_handle_t *)&handle);
-    if (err == SX_RPC_STATUS_PARAM_NULL) {
-        err = -EINVAL;
-    }
-    else if (err == SX_RPC_STATUS_ERROR) {
-        err = -EIO;
+bail:
+    return err;
+}
+
+/*
+ * Runs asynchronous calls until the queue is stopped and drained.
+ *
+ * @param[in] data - unused
+ *
+ * @return NULL
+ */
+static void *
+async_worker(void *data)
+{
+    int err;
+    struct async_call call;
+
+    UNUSED_PARAM(data);
+
+    pthread_mutex_lock(&async_queue.mutex);
+    for (;;) {
+        while ((async_queue.queued == 0) && !async_queue.stop) {
+            pthread_cond_wait(&async_queue.not_empty, &async_queue.mutex);
+        }
+        if (async_queue.queued == 0) {
+            break;
+        }
+        call = async_queue.calls[async_queue.head];
+        async_queue.head = (async_queue.head + 1) % MLAG_API_ASYNC_QUEUE_SIZE;
+        async_queue.queued--;
+        pthread_cond_signal(&async_queue.not_full);
+        pthread_mutex_unlock(&async_queue.mutex);
+
+        err = call.call(call.arg);
+        if (call.done_cb != NULL) {
+            call.done_cb(err, call.cookie);
+        }
+
+        pthread_mutex_lock(&async_queue.mutex);
+        async_queue.pending--;
+        if (async_queue.pending == 0) {
+            pthread_cond_broadcast(&async_queue.idle);
+        }
     }
-    MLAG_BAIL_ERROR_MSG(err,
-                        "Failed to close RPC socket\n");
+    pthread_mutex_unlock(&async_queue.mutex);
 
-    MLAG_LOG(MLAG_LOG_DEBUG, "Closed RPC socket\n");
+    return NULL;
+}
+
+/*
+ * Starts the asynchronous call workers, called with the queue locked.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EIO - Operation failure.
+ */
+static int
+async_workers_start(void)
+{
+    int err = 0;
+    int i;
+
+    async_queue.stop = FALSE;
+    for (i = 0; i < MLAG_API_ASYNC_WORKERS; i++) {
+        if (pthread_create(&async_queue.workers[i], NULL, async_worker,
+                           NULL) != 0) {
+            err = -EIO;
+            break;
+        }
+    }
+    if (err) {
+        /* workers started so far exit on stop */
+        async_queue.stop = TRUE;
+        pthread_cond_broadcast(&async_queue.not_empty);
+        pthread_mutex_unlock(&async_queue.mutex);
+        while (i-- > 0) {
+            pthread_join(async_queue.workers[i], NULL);
+        }
+        pthread_mutex_lock(&async_queue.mutex);
+        MLAG_BAIL_ERROR_MSG(err, "Failed to start async API workers\n");
+    }
+    async_queue.started = TRUE;
 
 bail:
     return err;
 }
 
+/*
+ * Stops the asynchronous call workers once the queued calls are done.
+ *
+ * @return void
+ */
+static void
+async_workers_stop(void)
+{
+    int i;
+
+    pthread_mutex_lock(&async_queue.mutex);
+    if (!async_queue.started) {
+        pthread_mutex_unlock(&async_queue.mutex);
+        return;
+    }
+    async_queue.stop = TRUE;
+    pthread_cond_broadcast(&async_queue.not_empty);
+    pthread_mutex_unlock(&async_queue.mutex);
+
+    for (i = 0; i < MLAG_API_ASYNC_WORKERS; i++) {
+        pthread_join(async_queue.workers[i], NULL);
+    }
+
+    pthread_mutex_lock(&async_queue.mutex);
+    async_queue.started = FALSE;
+    pthread_mutex_unlock(&async_queue.mutex);
+}
+
 /************************************************
  *  Function implementations
  ***********************************************/
@@ -263,6 +545,9 @@ mlag_api_deinit(enum mlag_connector_type connector_type)
 
     MLAG_LOG(MLAG_LOG_DEBUG, "De-Initialize the mlag protocol\n");
 
+    /* let queued asynchronous calls complete */
+    async_workers_stop();
+
     /* close the RPC handle */
     err = close_handle();
     MLAG_BAIL_ERROR_MSG(err, "Failed to close the handle\n");
@@ -850,6 +1135,83 @@ bail:
     return err;
 }
 
+/**
+ * Gets the queue delay and handler time histograms of the opcodes
+ * dispatched by MLAG since start or the last counters clear. Entries
+ * are retrieved in chunks that fit the RPC message size limit.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[out] latency_list - Latency per opcode. Pointer to an already
+ *                            allocated memory structure.
+ * @param[in,out] latency_cnt - List size. On return, the number of entries
+ *                              retrieved.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_event_latency_get(struct mlag_event_latency *latency_list,
+                           unsigned int *latency_cnt)
+{
+    int err = 0;
+    struct mlag_api_event_latency_get_params *cmd_body = NULL;
+    unsigned int chunk_max = (MLAG_RPC_API_MESSAGE_SIZE_LIMIT -
+                              sizeof(*cmd_body)) /
+                             sizeof(struct mlag_event_latency);
+    unsigned int chunk;
+    unsigned int filled = 0;
+    unsigned int size = 0;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(latency_list != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(latency_cnt != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(*latency_cnt > 0, -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "Get event latency. Entries number is [%u]\n",
+             *latency_cnt);
+
+    size = sizeof(struct mlag_api_event_latency_get_params) +
+           chunk_max * sizeof(struct mlag_event_latency);
+    cmd_body = (struct mlag_api_event_latency_get_params *)cl_malloc(size);
+    if (cmd_body == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate cmd_body memory\n");
+    }
+
+    while (filled < *latency_cnt) {
+        chunk = *latency_cnt - filled;
+        if (chunk > chunk_max) {
+            chunk = chunk_max;
+        }
+        cmd_body->start = filled;
+        cmd_body->latency_cnt = chunk;
+        size = sizeof(struct mlag_api_event_latency_get_params) +
+               chunk * sizeof(struct mlag_event_latency);
+
+        err = mlag_api_send_command_wrapper(
+            MLAG_INTERNAL_API_CMD_EVENT_LATENCY_GET, (uint8_t*)cmd_body,
+            size, NA);
+        MLAG_BAIL_CHECK_NO_MSG(err);
+
+        memcpy(&latency_list[filled], cmd_body->latency_list,
+               cmd_body->latency_cnt * sizeof(struct mlag_event_latency));
+        filled += cmd_body->latency_cnt;
+        if (cmd_body->latency_cnt < chunk) {
+            break;
+        }
+    }
+    *latency_cnt = filled;
+
+bail:
+    if (cmd_body) {
+        cl_free(cmd_body);
+    }
+    return err;
+}
+
 /**
  * Specifies the maximum period of time that MLAG ports are disabled after restarting
  * the feature.
@@ -997,6 +1359,251 @@ bail:
     return err;
 }
 
+/**
+ * Specifies the keep-alive interval in milliseconds and the detection
+ * multiplier. Peer failure is detected after interval * multiplier
+ * milliseconds, where the interval is the slower of the local and
+ * remote intervals.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ *
+ * @param[in] params - Keep-alive timers.
+ *          Interval ranges from 50 to 30000 msec, inclusive.
+ *          Multiplier ranges from 2 to 255, inclusive.
+ *          Default is 1000 msec with multiplier 3.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_keepalive_params_set(const struct mlag_keepalive_params *params)
+{
+    int err = 0;
+
+    /* validate parameter */
+    MLAG_BAIL_CHECK(params != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((params->interval_msec >=
+                     MLAG_KEEPALIVE_INTERVAL_MSEC_MIN) &&
+                    (params->interval_msec <=
+                     MLAG_KEEPALIVE_INTERVAL_MSEC_MAX), -EINVAL);
+    MLAG_BAIL_CHECK((params->multiplier >= MLAG_KEEPALIVE_MULTIPLIER_MIN) &&
+                    (params->multiplier <= MLAG_KEEPALIVE_MULTIPLIER_MAX),
+                    -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "Keep-alive params set. msec [%u] multiplier [%u]\n",
+             params->interval_msec, params->multiplier);
+
+    err = mlag_api_send_command_wrapper(
+        MLAG_INTERNAL_API_CMD_KEEPALIVE_PARAMS_SET,
+        (uint8_t*)params,
+        sizeof(*params),
+        NA);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+bail:
+    return err;
+}
+
+/**
+ * Populates params with the current keep-alive interval in milliseconds
+ * and detection multiplier.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[out] params - Keep-alive timers.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_keepalive_params_get(struct mlag_keepalive_params *params)
+{
+    int err = 0;
+
+    /* validate parameter */
+    MLAG_BAIL_CHECK(params != NULL, -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Get keep-alive params\n");
+
+    err = mlag_api_send_command_wrapper(
+        MLAG_INTERNAL_API_CMD_KEEPALIVE_PARAMS_GET,
+        (uint8_t*)params,
+        sizeof(*params),
+        sizeof(*params));
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "Keepalive params msec [%u] multiplier [%u]\n",
+             params->interval_msec, params->multiplier);
+
+bail:
+    return err;
+}
+
+/**
+ * Sets the scheduling of the heartbeat thread. The thread serves
+ * keep-alive Tx, Rx and timeouts, running it with a real time priority
+ * and pinning it keeps peer failure detection on time under load.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] params - Heartbeat thread priority and CPU.
+ *          Priority ranges from 0 (default policy) to 99, inclusive.
+ *          CPU ranges from -1 (not pinned) to 1023, inclusive.
+ *          Default is priority 0, not pinned.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_heartbeat_thread_params_set(
+    const struct mlag_heartbeat_thread_params *params)
+{
+    int err = 0;
+
+    /* validate parameter */
+    MLAG_BAIL_CHECK(params != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((params->rt_priority >= 0) &&
+                    (params->rt_priority <=
+                     MLAG_HEARTBEAT_THREAD_RT_PRIO_MAX), -EINVAL);
+    MLAG_BAIL_CHECK((params->cpu >= -1) &&
+                    (params->cpu <= MLAG_HEARTBEAT_THREAD_CPU_MAX), -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "Heartbeat thread params set. priority [%d] cpu [%d]\n",
+             params->rt_priority, params->cpu);
+
+    err = mlag_api_send_command_wrapper(
+        MLAG_INTERNAL_API_CMD_HEARTBEAT_THREAD_PARAMS_SET,
+        (uint8_t*)params,
+        sizeof(*params),
+        NA);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+bail:
+    return err;
+}
+
+/**
+ * Populates params with the current scheduling of the heartbeat thread.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[out] params - Heartbeat thread priority and CPU.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_heartbeat_thread_params_get(
+    struct mlag_heartbeat_thread_params *params)
+{
+    int err = 0;
+
+    /* validate parameter */
+    MLAG_BAIL_CHECK(params != NULL, -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Get heartbeat thread params\n");
+
+    err = mlag_api_send_command_wrapper(
+        MLAG_INTERNAL_API_CMD_HEARTBEAT_THREAD_PARAMS_GET,
+        (uint8_t*)params,
+        sizeof(*params),
+        sizeof(*params));
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "Heartbeat thread params priority [%d] cpu [%d]\n",
+             params->rt_priority, params->cpu);
+
+bail:
+    return err;
+}
+
+/**
+ * Sets the suppression of IGMP packets tunneled to the peer. Reports for
+ * the same group, VLAN and port are forwarded once per suppression window,
+ * and each IGMP type is rate limited.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ *
+ * @param[in] params - Suppression window and rate limit.
+ *          Window ranges from 0 to 60000 msec, inclusive.
+ *          Rate limit ranges from 0 to 65535 packets per second, inclusive.
+ *          0 selects the default, 1000 for both.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_igmp_params_set(const struct mlag_igmp_params *params)
+{
+    int err = 0;
+
+    /* validate parameter */
+    MLAG_BAIL_CHECK(params != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((params->suppress_window_msec <=
+                     MLAG_IGMP_SUPPRESS_WINDOW_MSEC_MAX), -EINVAL);
+    MLAG_BAIL_CHECK((params->rate_limit <= MLAG_IGMP_RATE_LIMIT_MAX),
+                    -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "IGMP params set. suppress window [%u] rate limit [%u]\n",
+             params->suppress_window_msec, params->rate_limit);
+
+    err = mlag_api_send_command_wrapper(MLAG_INTERNAL_API_CMD_IGMP_PARAMS_SET,
+                                        (uint8_t*)params,
+                                        sizeof(*params),
+                                        NA);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+bail:
+    return err;
+}
+
+/**
+ * Populates params with the tunneled IGMP suppression parameters in use.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[out] params - Suppression window and rate limit.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_igmp_params_get(struct mlag_igmp_params *params)
+{
+    int err = 0;
+
+    /* validate parameter */
+    MLAG_BAIL_CHECK(params != NULL, -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Get IGMP params\n");
+
+    err = mlag_api_send_command_wrapper(MLAG_INTERNAL_API_CMD_IGMP_PARAMS_GET,
+                                        (uint8_t*)params,
+                                        sizeof(*params),
+                                        sizeof(*params));
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "IGMP params suppress window [%u] rate limit [%u]\n",
+             params->suppress_window_msec, params->rate_limit);
+
+bail:
+    return err;
+}
+
 /**
  * Adds/deletes MLAG port.
  * This function works asynchronously. After verifying its arguments are valid,
@@ -1034,6 +1641,155 @@ bail:
     return err;
 }
 
+/**
+ * Adds/deletes several MLAG ports in one operation.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately. The progress of each port
+ * is retrieved with mlag_api_ports_cfg_state_get. Ports that do not fit in
+ * one API message are sent in several messages, each queued as an operation
+ * of its own, so an error may leave the earlier ones queued.
+ *
+ * @param[in] access_cmd - Add/Delete.
+ * @param[in] ports - Interface indexes of ports. Must represent MLAG ports.
+ * @param[in] ports_cnt - Number of ports, up to the maximum number of
+ *                        MLAG ports.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - Too many port operations are still pending.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_ports_set(const enum access_cmd access_cmd,
+                   const unsigned long *ports,
+                   const unsigned int ports_cnt)
+{
+    int err = 0;
+    struct mlag_api_ports_set_params *cmd_body = NULL;
+    unsigned int chunk_max = (MLAG_RPC_API_MESSAGE_SIZE_LIMIT -
+                              sizeof(*cmd_body)) / sizeof(unsigned long);
+    unsigned int chunk;
+    unsigned int sent = 0;
+    unsigned int size = 0;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK((access_cmd == ACCESS_CMD_ADD) ||
+                    (access_cmd == ACCESS_CMD_DELETE), -EINVAL);
+    MLAG_BAIL_CHECK(ports != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((ports_cnt > 0) && (ports_cnt <= MLAG_MAX_PORTS_LIMIT),
+                    -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "%s [%u] mlag ports\n",
+             ACCESS_COMMAND_STR(access_cmd), ports_cnt);
+
+    size = sizeof(struct mlag_api_ports_set_params) +
+           chunk_max * sizeof(unsigned long);
+    cmd_body = (struct mlag_api_ports_set_params *)cl_malloc(size);
+    if (cmd_body == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate cmd_body memory\n");
+    }
+
+    /* Each message is queued as an operation of its own */
+    while (sent < ports_cnt) {
+        chunk = ports_cnt - sent;
+        if (chunk > chunk_max) {
+            chunk = chunk_max;
+        }
+        cmd_body->access_cmd = access_cmd;
+        cmd_body->ports_cnt = chunk;
+        memcpy(cmd_body->ports, &ports[sent], chunk * sizeof(unsigned long));
+        size = sizeof(struct mlag_api_ports_set_params) +
+               chunk * sizeof(unsigned long);
+
+        err = mlag_api_send_command_wrapper(MLAG_INTERNAL_API_CMD_PORTS_SET,
+                                            (uint8_t*)cmd_body,
+                                            size,
+                                            NA);
+        MLAG_BAIL_CHECK_NO_MSG(err);
+        sent += chunk;
+    }
+
+bail:
+    if (cmd_body) {
+        cl_free(cmd_body);
+    }
+    return err;
+}
+
+/**
+ * Populates the add/delete progress of the given ports.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in,out] ports_cfg - Ports to query. In: port_id of each entry.
+ *                            Out: state of each entry.
+ * @param[in] ports_cnt - Number of entries in ports_cfg.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_ports_cfg_state_get(struct mlag_port_cfg_info *ports_cfg,
+                             const unsigned int ports_cnt)
+{
+    int err = 0;
+    struct mlag_api_ports_cfg_state_get_params *cmd_body = NULL;
+    unsigned int chunk_max = (MLAG_RPC_API_MESSAGE_SIZE_LIMIT -
+                              sizeof(*cmd_body)) /
+                             sizeof(struct mlag_port_cfg_info);
+    unsigned int chunk;
+    unsigned int filled = 0;
+    unsigned int size = 0;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(ports_cfg != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((ports_cnt > 0) && (ports_cnt <= MLAG_MAX_PORTS_LIMIT),
+                    -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Get cfg state of [%u] mlag ports\n",
+             ports_cnt);
+
+    size = sizeof(struct mlag_api_ports_cfg_state_get_params) +
+           chunk_max * sizeof(struct mlag_port_cfg_info);
+    cmd_body = (struct mlag_api_ports_cfg_state_get_params *)cl_malloc(size);
+    if (cmd_body == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate cmd_body memory\n");
+    }
+
+    while (filled < ports_cnt) {
+        chunk = ports_cnt - filled;
+        if (chunk > chunk_max) {
+            chunk = chunk_max;
+        }
+        cmd_body->ports_cnt = chunk;
+        memcpy(cmd_body->ports_cfg, &ports_cfg[filled],
+               chunk * sizeof(struct mlag_port_cfg_info));
+        size = sizeof(struct mlag_api_ports_cfg_state_get_params) +
+               chunk * sizeof(struct mlag_port_cfg_info);
+
+        err = mlag_api_send_command_wrapper(
+            MLAG_INTERNAL_API_CMD_PORTS_CFG_STATE_GET,
+            (uint8_t*)cmd_body,
+            size,
+            size);
+        MLAG_BAIL_CHECK_NO_MSG(err);
+
+        memcpy(&ports_cfg[filled], cmd_body->ports_cfg,
+               chunk * sizeof(struct mlag_port_cfg_info));
+        filled += chunk;
+    }
+
+bail:
+    if (cmd_body) {
+        cl_free(cmd_body);
+    }
+    return err;
+}
+
 /**
  * Creates/deletes an IPL.
  * This function works synchronously and blocks until the operation is completed.
@@ -1756,6 +2512,565 @@ bail:
     return err;
 }
 
+/**
+ * Opens a cursor on the SW FDB table. The cursor is read page by page
+ * until it returns no more entries, the entries are passed through
+ * shared memory so a full table takes a handful of calls.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] key_filter - Filter types used on the entries -
+ *                         vid / logical port.
+ * @param[out] cursor - Cursor, to be closed by mlag_api_fdb_cursor_close.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - Too many cursors are open.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_fdb_cursor_open(const struct fdb_uc_key_filter *key_filter,
+                         struct mlag_fdb_cursor **cursor)
+{
+    int err = 0;
+    int fd = -1;
+    void *page = MAP_FAILED;
+    struct mlag_api_fdb_cursor_open_params cmd_body;
+    struct mlag_api_fdb_cursor_read_params close_body;
+    struct mlag_fdb_cursor *new_cursor = NULL;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(key_filter != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(cursor != NULL, -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Open FDB cursor\n");
+
+    SAFE_MEMSET(&cmd_body, 0);
+    cmd_body.key_filter = *key_filter;
+    err = mlag_api_send_command_wrapper(MLAG_INTERNAL_API_CMD_FDB_CURSOR_OPEN,
+                                        (uint8_t*) &cmd_body,
+                                        sizeof(cmd_body),
+                                        sizeof(cmd_body));
+    MLAG_BAIL_CHECK_NO_MSG(err);
+    cmd_body.shm_name[MLAG_FDB_CURSOR_SHM_NAME_LEN - 1] = '\0';
+
+    fd = shm_open(cmd_body.shm_name, O_RDONLY, 0);
+    if (fd >= 0) {
+        page = mmap(NULL, cmd_body.capacity *
+                    sizeof(struct fdb_uc_mac_addr_params),
+                    PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (page == MAP_FAILED) {
+        err = -EIO;
+        MLAG_LOG(MLAG_LOG_ERROR, "Failed to map FDB cursor page %s\n",
+                 cmd_body.shm_name);
+        goto close_cursor;
+    }
+
+    new_cursor = (struct mlag_fdb_cursor *)cl_malloc(sizeof(*new_cursor));
+    if (new_cursor == NULL) {
+        err = -ENOMEM;
+        MLAG_LOG(MLAG_LOG_ERROR,
+                 "Failed to allocate FDB cursor memory\n");
+        munmap(page, cmd_body.capacity *
+               sizeof(struct fdb_uc_mac_addr_params));
+        goto close_cursor;
+    }
+    SAFE_MEMSET(new_cursor, 0);
+    new_cursor->cursor_id = cmd_body.cursor_id;
+    new_cursor->page = (struct fdb_uc_mac_addr_params *)page;
+    new_cursor->capacity = cmd_body.capacity;
+    *cursor = new_cursor;
+    goto bail;
+
+close_cursor:
+    close_body.cursor_id = cmd_body.cursor_id;
+    mlag_api_send_command_wrapper(MLAG_INTERNAL_API_CMD_FDB_CURSOR_CLOSE,
+                                  (uint8_t*) &close_body,
+                                  sizeof(close_body), NA);
+
+bail:
+    return err;
+}
+
+/**
+ * Reads the next MAC entries of an FDB cursor.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] cursor - Cursor.
+ * @param[out] mac_list - Mac record array. Pointer to an already allocated memory
+ *                        structure.
+ * @param[in,out] data_cnt - Number of macs to retrieve. On return, the number of
+ *                           macs retrieved, 0 when the cursor reached the end.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOENT - Cursor was closed by MLAG after being idle.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_fdb_cursor_read(struct mlag_fdb_cursor *cursor,
+                         struct fdb_uc_mac_addr_params *mac_list,
+                         unsigned int *data_cnt)
+{
+    int err = 0;
+    unsigned int cnt = 0;
+    unsigned int avail;
+    struct mlag_api_fdb_cursor_read_params cmd_body;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(cursor != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(mac_list != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(data_cnt != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(*data_cnt > 0, -EINVAL);
+
+    while (cnt < *data_cnt) {
+        if (cursor->page_pos == cursor->page_cnt) {
+            if (cursor->eof) {
+                break;
+            }
+            /* current page consumed, let MLAG fill the next one */
+            cmd_body.cursor_id = cursor->cursor_id;
+            cmd_body.data_cnt = 0;
+            cmd_body.eof = FALSE;
+            err = mlag_api_send_command_wrapper(
+                MLAG_INTERNAL_API_CMD_FDB_CURSOR_READ,
+                (uint8_t*) &cmd_body, sizeof(cmd_body),
+                sizeof(cmd_body));
+            MLAG_BAIL_CHECK_NO_MSG(err);
+            MLAG_BAIL_CHECK(cmd_body.data_cnt <= cursor->capacity, -EIO);
+
+            cursor->page_cnt = cmd_body.data_cnt;
+            cursor->page_pos = 0;
+            cursor->eof = cmd_body.eof;
+            continue;
+        }
+
+        avail = cursor->page_cnt - cursor->page_pos;
+        if (avail > (*data_cnt - cnt)) {
+            avail = *data_cnt - cnt;
+        }
+        memcpy(&mac_list[cnt], &cursor->page[cursor->page_pos],
+               avail * sizeof(struct fdb_uc_mac_addr_params));
+        cursor->page_pos += avail;
+        cnt += avail;
+    }
+
+    *data_cnt = cnt;
+
+bail:
+    return err;
+}
+
+/**
+ * Closes an FDB cursor and frees it.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] cursor - Cursor.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ */
+int
+mlag_api_fdb_cursor_close(struct mlag_fdb_cursor *cursor)
+{
+    int err = 0;
+    struct mlag_api_fdb_cursor_read_params cmd_body;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(cursor != NULL, -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Close FDB cursor %u\n", cursor->cursor_id);
+
+    munmap(cursor->page, cursor->capacity *
+           sizeof(struct fdb_uc_mac_addr_params));
+
+    SAFE_MEMSET(&cmd_body, 0);
+    cmd_body.cursor_id = cursor->cursor_id;
+    cl_free(cursor);
+
+    err = mlag_api_send_command_wrapper(MLAG_INTERNAL_API_CMD_FDB_CURSOR_CLOSE,
+                                        (uint8_t*) &cmd_body,
+                                        sizeof(cmd_body), NA);
+    if (err == -ENOENT) {
+        /* already closed by MLAG after being idle */
+        err = 0;
+    }
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+bail:
+    return err;
+}
+
+/*
+ * Receives the eventfd MLAG passes on a subscription socket
+ *
+ * @param[in] sock - listening socket
+ * @param[out] event_fd - eventfd
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+notify_event_fd_recv(int sock, int *event_fd)
+{
+    int err = 0;
+    int conn = -1;
+    char byte;
+    struct iovec iov;
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    char control[CMSG_SPACE(sizeof(int))];
+
+    conn = accept(sock, NULL, NULL);
+    if (conn < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to accept notification socket\n");
+    }
+
+    iov.iov_base = &byte;
+    iov.iov_len = sizeof(byte);
+    SAFE_MEMSET(&msg, 0);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(conn, &msg, MSG_CMSG_CLOEXEC) != sizeof(byte)) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to receive notification eventfd\n");
+    }
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if ((cmsg == NULL) || (cmsg->cmsg_level != SOL_SOCKET) ||
+        (cmsg->cmsg_type != SCM_RIGHTS)) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Notification eventfd is missing\n");
+    }
+    memcpy(event_fd, CMSG_DATA(cmsg), sizeof(int));
+
+bail:
+    if (conn >= 0) {
+        close(conn);
+    }
+    return err;
+}
+
+/**
+ * Subscribes to MLAG notifications. Notifications of the types in the
+ * interest mask are pushed by MLAG to a ring in shared memory, and the
+ * returned eventfd becomes readable when the ring gets notifications,
+ * so the caller can poll it with its other descriptors instead of
+ * polling MLAG.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] interest_mask - Notification types, MLAG_NOTIFY_MASK bits.
+ * @param[out] subscriber - Subscription, to be ended by
+ *                          mlag_api_notify_unsubscribe.
+ * @param[out] event_fd - Descriptor to poll for readability.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - Too many subscribers.
+ * @return -EIO - Network problem or operation failure.
+ */
+int
+mlag_api_notify_subscribe(unsigned int interest_mask,
+                          struct mlag_notify_subscriber **subscriber,
+                          int *event_fd)
+{
+    int err = 0;
+    int sock = -1;
+    int fd = -1;
+    int new_event_fd = -1;
+    void *ring = MAP_FAILED;
+    static unsigned int sock_cnt = 0;
+    struct sockaddr_un addr;
+    struct mlag_api_notify_subscribe_params cmd_body;
+    struct mlag_api_notify_unsubscribe_params unsubscribe_body;
+    struct mlag_notify_subscriber *new_subscriber = NULL;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(interest_mask != 0, -EINVAL);
+    MLAG_BAIL_CHECK((interest_mask & ~MLAG_NOTIFY_MASK_ALL) == 0, -EINVAL);
+    MLAG_BAIL_CHECK(subscriber != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(event_fd != NULL, -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Notification subscribe, mask [0x%x]\n",
+             interest_mask);
+
+    SAFE_MEMSET(&cmd_body, 0);
+    cmd_body.interest_mask = interest_mask;
+    cmd_body.pid = (int)getpid();
+    snprintf(cmd_body.sock_name, sizeof(cmd_body.sock_name),
+             "mlag_notify_sub_%d_%u", cmd_body.pid,
+             __sync_fetch_and_add(&sock_cnt, 1));
+
+    /* MLAG connects to this socket to pass the eventfd, before it
+     * replies, so the connection waits in the backlog
+     */
+    sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to open notification socket\n");
+    }
+    SAFE_MEMSET(&addr, 0);
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path + 1, cmd_body.sock_name,
+            MLAG_NOTIFY_NAME_LEN - 1);
+    if ((bind(sock, (struct sockaddr *)&addr,
+              offsetof(struct sockaddr_un, sun_path) + 1 +
+              strlen(cmd_body.sock_name)) < 0) || (listen(sock, 1) < 0)) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to bind notification socket\n");
+    }
+
+    err = mlag_api_send_command_wrapper(MLAG_INTERNAL_API_CMD_NOTIFY_SUBSCRIBE,
+                                        (uint8_t*) &cmd_body,
+                                        sizeof(cmd_body),
+                                        sizeof(cmd_body));
+    MLAG_BAIL_CHECK_NO_MSG(err);
+    cmd_body.ring_name[MLAG_NOTIFY_NAME_LEN - 1] = '\0';
+
+    err = notify_event_fd_recv(sock, &new_event_fd);
+    if (err) {
+        goto unsubscribe;
+    }
+
+    fd = shm_open(cmd_body.ring_name, O_RDWR, 0);
+    if (fd >= 0) {
+        ring = mmap(NULL, sizeof(struct mlag_notify_ring),
+                    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if ((ring == MAP_FAILED) ||
+        (((struct mlag_notify_ring *)ring)->magic != MLAG_NOTIFY_RING_MAGIC)) {
+        err = -EIO;
+        MLAG_LOG(MLAG_LOG_ERROR, "Failed to map notification ring %s\n",
+                 cmd_body.ring_name);
+        goto unsubscribe;
+    }
+
+    new_subscriber =
+        (struct mlag_notify_subscriber *)cl_malloc(sizeof(*new_subscriber));
+    if (new_subscriber == NULL) {
+        err = -ENOMEM;
+        MLAG_LOG(MLAG_LOG_ERROR,
+                 "Failed to allocate notification subscriber memory\n");
+        goto unsubscribe;
+    }
+    new_subscriber->subscriber_id = cmd_body.subscriber_id;
+    new_subscriber->ring = (struct mlag_notify_ring *)ring;
+    new_subscriber->event_fd = new_event_fd;
+    *subscriber = new_subscriber;
+    *event_fd = new_event_fd;
+    goto bail;
+
+unsubscribe:
+    if (ring != MAP_FAILED) {
+        munmap(ring, sizeof(struct mlag_notify_ring));
+    }
+    if (new_event_fd >= 0) {
+        close(new_event_fd);
+    }
+    unsubscribe_body.subscriber_id = cmd_body.subscriber_id;
+    mlag_api_send_command_wrapper(MLAG_INTERNAL_API_CMD_NOTIFY_UNSUBSCRIBE,
+                                  (uint8_t*) &unsubscribe_body,
+                                  sizeof(unsubscribe_body), NA);
+
+bail:
+    if (sock >= 0) {
+        close(sock);
+    }
+    return err;
+}
+
+/**
+ * Reads the pending notifications of a subscription. It does not
+ * block, it is called when the eventfd of the subscription is readable
+ * and again until it returns no notifications.
+ *
+ * @param[in] subscriber - Subscription.
+ * @param[out] notification_list - Notification array. Pointer to an
+ *                                 already allocated memory structure.
+ * @param[in,out] data_cnt - Number of notifications to retrieve. On
+ *                           return, the number of notifications retrieved.
+ * @param[out] dropped - Optional, notifications dropped so far because
+ *                       the subscriber did not read them in time.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ */
+int
+mlag_api_notify_read(struct mlag_notify_subscriber *subscriber,
+                     struct mlag_notification *notification_list,
+                     unsigned int *data_cnt,
+                     unsigned long long *dropped)
+{
+    int err = 0;
+    uint64_t value;
+    uint64_t head;
+    uint64_t tail;
+    unsigned int cnt = 0;
+    struct mlag_notify_ring *ring;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(subscriber != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(notification_list != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(data_cnt != NULL, -EINVAL);
+
+    ring = subscriber->ring;
+    /* clear the signal first, a notification pushed after it is
+     * either read below or signals again
+     */
+    if (read(subscriber->event_fd, &value, sizeof(value)) < 0) {
+        /* not signaled, the ring may still hold notifications */
+    }
+    __sync_synchronize();
+
+    tail = ring->tail;
+    do {
+        head = ring->head;
+        __sync_synchronize();
+        while ((tail != head) && (cnt < *data_cnt)) {
+            notification_list[cnt++] =
+                ring->entries[tail & (MLAG_NOTIFY_RING_SIZE - 1)];
+            tail++;
+        }
+        __sync_synchronize();
+        ring->tail = tail;
+        /* The pusher signals only if it sees the ring empty. A push that
+         * read the tail before it was stored above did not signal, it is
+         * seen by reading the head again after the store.
+         */
+        __sync_synchronize();
+    } while ((ring->head != tail) && (cnt < *data_cnt));
+
+    *data_cnt = cnt;
+    if (dropped != NULL) {
+        *dropped = ring->dropped;
+    }
+
+bail:
+    return err;
+}
+
+/**
+ * Ends a subscription, closes its eventfd and frees it.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] subscriber - Subscription.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ */
+int
+mlag_api_notify_unsubscribe(struct mlag_notify_subscriber *subscriber)
+{
+    int err = 0;
+    struct mlag_api_notify_unsubscribe_params cmd_body;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(subscriber != NULL, -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Notification unsubscribe [%u]\n",
+             subscriber->subscriber_id);
+
+    munmap(subscriber->ring, sizeof(struct mlag_notify_ring));
+    close(subscriber->event_fd);
+
+    SAFE_MEMSET(&cmd_body, 0);
+    cmd_body.subscriber_id = subscriber->subscriber_id;
+    cl_free(subscriber);
+
+    err = mlag_api_send_command_wrapper(
+        MLAG_INTERNAL_API_CMD_NOTIFY_UNSUBSCRIBE, (uint8_t*) &cmd_body,
+        sizeof(cmd_body), NA);
+    if (err == -ENOENT) {
+        /* already removed by MLAG */
+        err = 0;
+    }
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+bail:
+    return err;
+}
+
+/**
+ * Queues a call of the MLAG API to run asynchronously. Calls run in
+ * parallel by a pool of workers, each on its own connection, so several
+ * requests are in flight at the same time, and each one reports its
+ * result to its completion callback.
+ * This function works asynchronously. It blocks only while the queue is full.
+ *
+ * @param[in] call - Call to run, it makes one or more MLAG API calls and
+ *                   returns the error code to be reported.
+ * @param[in] arg - Argument of the call.
+ * @param[in] done_cb - Optional completion callback, called from a
+ *                      worker thread with the call result.
+ * @param[in] cookie - Argument of the completion callback.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Operation failure.
+ */
+int
+mlag_api_async_submit(mlag_api_async_call_t call, void *arg,
+                      mlag_api_async_cb_t done_cb, void *cookie)
+{
+    int err = 0;
+    unsigned int tail;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(call != NULL, -EINVAL);
+
+    pthread_mutex_lock(&async_queue.mutex);
+    if (!async_queue.started) {
+        err = async_workers_start();
+        if (err) {
+            pthread_mutex_unlock(&async_queue.mutex);
+            goto bail;
+        }
+    }
+    while (async_queue.queued == MLAG_API_ASYNC_QUEUE_SIZE) {
+        pthread_cond_wait(&async_queue.not_full, &async_queue.mutex);
+    }
+    tail = (async_queue.head + async_queue.queued) %
+           MLAG_API_ASYNC_QUEUE_SIZE;
+    async_queue.calls[tail].call = call;
+    async_queue.calls[tail].arg = arg;
+    async_queue.calls[tail].done_cb = done_cb;
+    async_queue.calls[tail].cookie = cookie;
+    async_queue.queued++;
+    async_queue.pending++;
+    pthread_cond_signal(&async_queue.not_empty);
+    pthread_mutex_unlock(&async_queue.mutex);
+
+bail:
+    return err;
+}
+
+/**
+ * Waits until all asynchronous calls queued so far, and their
+ * completion callbacks, are done. Must not be called from a completion
+ * callback.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @return 0 - Operation completed successfully.
+ */
+int
+mlag_api_async_flush(void)
+{
+    pthread_mutex_lock(&async_queue.mutex);
+    while (async_queue.pending != 0) {
+        pthread_cond_wait(&async_queue.idle, &async_queue.mutex);
+    }
+    pthread_mutex_unlock(&async_queue.mutex);
+
+    return 0;
+}
+
 /**
  * Initializes the control learning library.
  * This function works synchronously and blocks until the operation is completed.
@@ -2104,6 +3419,86 @@ bail:
     return err;
 }
 
+/**
+ * Triggers aggregator selection queries of several ports in one operation.
+ * Since MLAG is distributed, this request may involve a remote peer, so
+ * this function works asynchronously. Selections are decided together, up
+ * to as many as fit in one API message, and the response of each one is
+ * guaranteed and issued as a notification, the same as for
+ * mlag_api_lacp_selection_request. Force is not yet supported, and should
+ * be set to 0.
+ *
+ * @param[in] selections - selection queries, request_id of each one will
+ *                         appear in its reply.
+ * @param[in] selections_cnt - Number of selections, up to the maximum number
+ *                             of MLAG ports.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_api_lacp_selections_request(const struct lacp_selection_info *selections,
+                                 const unsigned int selections_cnt)
+{
+    int err = 0;
+    unsigned int i;
+    struct mlag_api_lacp_selections_request_params *cmd_body = NULL;
+    unsigned int chunk_max = (MLAG_RPC_API_MESSAGE_SIZE_LIMIT -
+                              sizeof(*cmd_body)) /
+                             sizeof(struct lacp_selection_info);
+    unsigned int chunk;
+    unsigned int sent = 0;
+    unsigned int size = 0;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(selections != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((selections_cnt > 0) &&
+                    (selections_cnt <= MLAG_MAX_PORTS_LIMIT), -EINVAL);
+    for (i = 0; i < selections_cnt; i++) {
+        MLAG_BAIL_CHECK(selections[i].force == 0, -EINVAL);
+    }
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "lacp selections request of [%u] ports\n",
+             selections_cnt);
+
+    size = sizeof(struct mlag_api_lacp_selections_request_params) +
+           chunk_max * sizeof(struct lacp_selection_info);
+    cmd_body = (struct mlag_api_lacp_selections_request_params *)
+               cl_malloc(size);
+    if (cmd_body == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate cmd_body memory\n");
+    }
+
+    while (sent < selections_cnt) {
+        chunk = selections_cnt - sent;
+        if (chunk > chunk_max) {
+            chunk = chunk_max;
+        }
+        cmd_body->selections_cnt = chunk;
+        memcpy(cmd_body->selections, &selections[sent],
+               chunk * sizeof(struct lacp_selection_info));
+        size = sizeof(struct mlag_api_lacp_selections_request_params) +
+               chunk * sizeof(struct lacp_selection_info);
+
+        err = mlag_api_send_command_wrapper(
+            MLAG_INTERNAL_API_CMD_LACP_SELECTIONS_REQUEST,
+            (uint8_t*)cmd_body,
+            size,
+            NA);
+        MLAG_BAIL_CHECK_NO_MSG(err);
+        sent += chunk;
+    }
+
+bail:
+    if (cmd_body) {
+        cl_free(cmd_body);
+    }
+    return err;
+}
+
 /**
  * Sets the local system ID for LACP PDUs. This API should be called before
  * starting mlag protocol when LACP is enabled.
@@ -0,0 +1,416 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "mlag_snapshot.h"
+#include "mlag_bail.h"
+#include "mlag_defs.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#undef  __MODULE__
+#define __MODULE__ MLAG_API
+
+/* Reads retried while MLAG updates the snapshot */
+#define SNAPSHOT_READ_RETRIES  100000
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+typedef void (*snapshot_copy_func)(const struct mlag_snapshot_state *state,
+                                   void *data);
+
+struct ports_copy_data {
+    struct mlag_port_info *ports;
+    unsigned int max;
+    unsigned int num;
+};
+
+struct peers_copy_data {
+    struct peer_state *peers;
+    unsigned int max;
+    unsigned int num;
+};
+
+struct oper_copy_data {
+    enum protocol_oper_state *protocol_oper_state;
+    enum system_role_state *system_role_state;
+};
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+
+static const struct mlag_snapshot *snapshot = NULL;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ * Runs a copy of the snapshot state until it was not changed by
+ * MLAG while copied
+ *
+ * @param[in] copy - copy function
+ * @param[in] data - copy function data
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -EAGAIN if MLAG did not publish yet, or kept updating
+ */
+static int
+snapshot_read(snapshot_copy_func copy, void *data)
+{
+    int err = 0;
+    int retries;
+    uint32_t seq;
+
+    MLAG_BAIL_CHECK(snapshot != NULL, -EPERM);
+
+    for (retries = 0; retries < SNAPSHOT_READ_RETRIES; retries++) {
+        seq = snapshot->seq;
+        if (seq & 1) {
+            continue;
+        }
+        if (seq == 0) {
+            err = -EAGAIN;
+            goto bail;
+        }
+        __sync_synchronize();
+        copy(&snapshot->state, data);
+        __sync_synchronize();
+        if (snapshot->seq == seq) {
+            goto bail;
+        }
+    }
+    err = -EAGAIN;
+
+bail:
+    return err;
+}
+
+/*
+ * Gets the number of entries to copy. The number in the snapshot is
+ * checked since it may be torn while copied.
+ *
+ * @param[in] num - entries in the snapshot
+ * @param[in] limit - entries the snapshot may hold
+ * @param[in] max - entries asked for
+ *
+ * @return entries to copy
+ */
+static unsigned int
+snapshot_num_clamp(unsigned int num, unsigned int limit, unsigned int max)
+{
+    if (num > limit) {
+        num = limit;
+    }
+    if (num > max) {
+        num = max;
+    }
+
+    return num;
+}
+
+static void
+state_copy(const struct mlag_snapshot_state *state, void *data)
+{
+    struct mlag_snapshot_state *dst = (struct mlag_snapshot_state *)data;
+
+    memcpy(dst, state, offsetof(struct mlag_snapshot_state, ports));
+    dst->ports_num = snapshot_num_clamp(state->ports_num,
+                                        MLAG_SNAPSHOT_MAX_PORTS,
+                                        MLAG_SNAPSHOT_MAX_PORTS);
+    dst->peers_num = snapshot_num_clamp(state->peers_num,
+                                        MLAG_SNAPSHOT_MAX_PEERS,
+                                        MLAG_SNAPSHOT_MAX_PEERS);
+    memcpy(dst->ports, state->ports, dst->ports_num * sizeof(dst->ports[0]));
+}
+
+static void
+ports_copy(const struct mlag_snapshot_state *state, void *data)
+{
+    struct ports_copy_data *copy = (struct ports_copy_data *)data;
+
+    copy->num = snapshot_num_clamp(state->ports_num, MLAG_SNAPSHOT_MAX_PORTS,
+                                   copy->max);
+    memcpy(copy->ports, state->ports, copy->num * sizeof(copy->ports[0]));
+}
+
+static void
+peers_copy(const struct mlag_snapshot_state *state, void *data)
+{
+    struct peers_copy_data *copy = (struct peers_copy_data *)data;
+
+    copy->num = snapshot_num_clamp(state->peers_num, MLAG_SNAPSHOT_MAX_PEERS,
+                                   copy->max);
+    memcpy(copy->peers, state->peers, copy->num * sizeof(copy->peers[0]));
+}
+
+static void
+oper_copy(const struct mlag_snapshot_state *state, void *data)
+{
+    struct oper_copy_data *copy = (struct oper_copy_data *)data;
+
+    *copy->protocol_oper_state = state->protocol_oper_state;
+    *copy->system_role_state = state->system_role_state;
+}
+
+static void
+counters_copy(const struct mlag_snapshot_state *state, void *data)
+{
+    memcpy(data, &state->counters, sizeof(state->counters));
+}
+
+/**
+ * Maps the state snapshot published by MLAG. The getters below read
+ * the mapping and make no system call.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - MLAG does not publish a snapshot.
+ * @return -EPROTO - Snapshot layout version differs.
+ * @return -EIO - Operation failure.
+ */
+int
+mlag_snapshot_open(void)
+{
+    int err = 0;
+    int fd = -1;
+    void *shm = MAP_FAILED;
+
+    if (snapshot != NULL) {
+        goto bail;
+    }
+
+    fd = shm_open(MLAG_SNAPSHOT_SHM_NAME, O_RDONLY, 0);
+    if (fd < 0) {
+        err = (errno == ENOENT) ? -ENOENT : -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to open MLAG snapshot\n");
+    }
+
+    shm = mmap(NULL, sizeof(struct mlag_snapshot), PROT_READ, MAP_SHARED,
+               fd, 0);
+    if (shm == MAP_FAILED) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to map MLAG snapshot\n");
+    }
+
+    if ((((struct mlag_snapshot *)shm)->magic != MLAG_SNAPSHOT_MAGIC) ||
+        (((struct mlag_snapshot *)shm)->version != MLAG_SNAPSHOT_VERSION)) {
+        munmap(shm, sizeof(struct mlag_snapshot));
+        err = -EPROTO;
+        MLAG_BAIL_ERROR_MSG(err, "MLAG snapshot version mismatch\n");
+    }
+
+    snapshot = (const struct mlag_snapshot *)shm;
+
+bail:
+    if (fd >= 0) {
+        close(fd);
+    }
+    return err;
+}
+
+/**
+ * Unmaps the state snapshot.
+ *
+ * @return 0 - Operation completed successfully.
+ */
+int
+mlag_snapshot_close(void)
+{
+    if (snapshot != NULL) {
+        munmap((void *)snapshot, sizeof(struct mlag_snapshot));
+        snapshot = NULL;
+    }
+
+    return 0;
+}
+
+/**
+ * Gets a consistent copy of the whole published state.
+ *
+ * @param[out] state - MLAG state, ports beyond ports_num are not copied.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Snapshot is not open.
+ * @return -EAGAIN - MLAG did not publish yet.
+ */
+int
+mlag_snapshot_state_get(struct mlag_snapshot_state *state)
+{
+    int err = 0;
+
+    MLAG_BAIL_CHECK(state != NULL, -EINVAL);
+
+    err = snapshot_read(state_copy, state);
+
+bail:
+    return err;
+}
+
+/**
+ * Gets the mlag ports state, as mlag_api_ports_state_get.
+ *
+ * @param[out] mlag_ports_information - Mlag ports. Pointer to an already allocated
+ *                                      memory structure.
+ * @param[in,out] mlag_ports_cnt - Number of ports to retrieve. On return, the
+ *                                 number of ports retrieved.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Snapshot is not open.
+ * @return -EAGAIN - MLAG did not publish yet.
+ */
+int
+mlag_snapshot_ports_state_get(struct mlag_port_info *mlag_ports_information,
+                              unsigned int *mlag_ports_cnt)
+{
+    int err = 0;
+    struct ports_copy_data copy;
+
+    MLAG_BAIL_CHECK(mlag_ports_information != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(mlag_ports_cnt != NULL, -EINVAL);
+
+    copy.ports = mlag_ports_information;
+    copy.max = *mlag_ports_cnt;
+    err = snapshot_read(ports_copy, &copy);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    *mlag_ports_cnt = copy.num;
+
+bail:
+    return err;
+}
+
+/**
+ * Gets the peers state, as mlag_api_peers_state_list_get.
+ *
+ * @param[out] peers_list - Peers list state. Pointer to an already allocated
+ *                          memory structure.
+ * @param[in,out] peers_list_cnt - Number of peers to retrieve. On return, the
+ *                                 number of peers retrieved.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Snapshot is not open.
+ * @return -EAGAIN - MLAG did not publish yet.
+ */
+int
+mlag_snapshot_peers_state_list_get(struct peer_state *peers_list,
+                                   unsigned int *peers_list_cnt)
+{
+    int err = 0;
+    struct peers_copy_data copy;
+
+    MLAG_BAIL_CHECK(peers_list != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(peers_list_cnt != NULL, -EINVAL);
+
+    copy.peers = peers_list;
+    copy.max = *peers_list_cnt;
+    err = snapshot_read(peers_copy, &copy);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    *peers_list_cnt = copy.num;
+
+bail:
+    return err;
+}
+
+/**
+ * Gets the protocol operational state and the system role, as
+ * mlag_api_protocol_oper_state_get and mlag_api_system_role_state_get.
+ *
+ * @param[out] protocol_oper_state - Protocol operational state.
+ * @param[out] system_role_state - System role state.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Snapshot is not open.
+ * @return -EAGAIN - MLAG did not publish yet.
+ */
+int
+mlag_snapshot_oper_state_get(enum protocol_oper_state *protocol_oper_state,
+                             enum system_role_state *system_role_state)
+{
+    int err = 0;
+    struct oper_copy_data copy;
+
+    MLAG_BAIL_CHECK(protocol_oper_state != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(system_role_state != NULL, -EINVAL);
+
+    copy.protocol_oper_state = protocol_oper_state;
+    copy.system_role_state = system_role_state;
+    err = snapshot_read(oper_copy, &copy);
+
+bail:
+    return err;
+}
+
+/**
+ * Gets the mlag protocol counters, as mlag_api_counters_get.
+ *
+ * @param[out] counters - Mlag protocol counters.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Snapshot is not open.
+ * @return -EAGAIN - MLAG did not publish yet.
+ */
+int
+mlag_snapshot_counters_get(struct mlag_counters *counters)
+{
+    int err = 0;
+
+    MLAG_BAIL_CHECK(counters != NULL, -EINVAL);
+
+    err = snapshot_read(counters_copy, counters);
+
+bail:
+    return err;
+}
@@ -68,6 +68,9 @@ static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
 static event_disp_fds_t event_fds;
 static cl_thread_t disp_thread;
 
+static int high_prio_events[] =
+{   MLAG_HEALTH_HEARTBEAT_STATE_CHANGE, };
+
 static int medium_prio_events[] =
 {   MLAG_START_EVENT,
     MLAG_STOP_EVENT,
@@ -80,14 +83,10 @@ static int medium_prio_events[] =
     MLAG_MASTER_ELECTION_SWITCH_STATUS_CHANGE_EVENT };
 
 
-static int low_prio_event[] =
-{   MLAG_HEALTH_HEARTBEAT_TICK, };
-
-
 static struct dispatcher_conf health_dispatcher_conf;
 static cmd_db_handle_t *health_cmd_db;
-static handle_t commlib_handle;
-static char health_disp_sys_event_buf[HEALTH_DISP_SYS_EVENT_BUF_SIZE];
+static char health_disp_sys_event_buf[HEALTH_DISP_SYS_EVENT_BUF_SIZE +
+                                     MLAG_EVENT_STAMP_SIZE];
 
 static int
 dispatch_start_event(uint8_t *buffer);
@@ -102,7 +101,7 @@ static int
 dispatch_peer_del_event(uint8_t *buffer);
 
 static int
-dispatch_timer_tick(uint8_t *buffer);
+dispatch_heartbeat_state_change(uint8_t *buffer);
 
 static int
 dispatch_ka_interval_set(uint8_t *buffer);
@@ -124,7 +123,8 @@ static handler_command_t health_dispatcher_commands[] = {
     {MLAG_STOP_EVENT, "Stop event", dispatch_stop_event, NULL },
     {MLAG_PEER_ID_SET_EVENT, "Peer add", dispatch_peer_add_event, NULL },
     {MLAG_PEER_DEL_EVENT, "Peer del", dispatch_peer_del_event, NULL },
-    {MLAG_HEALTH_HEARTBEAT_TICK, "Heartbeat tick", dispatch_timer_tick, NULL },
+    {MLAG_HEALTH_HEARTBEAT_STATE_CHANGE, "Heartbeat state change",
+     dispatch_heartbeat_state_change, NULL },
     {MLAG_HEALTH_KA_INTERVAL_CHANGE, "KA interval change",
      dispatch_ka_interval_set, NULL },
     {MLAG_HEALTH_FSM_TIMER, "Health FSM timer event",
@@ -161,44 +161,6 @@ health_dispatcher_log_verbosity_set(mlag_verbosity_t verbosity)
     LOG_VAR_NAME(__MODULE__) = verbosity;
 }
 
-/*
- *  This function is for handling comm sockets event
- *
- * @param[in] fd - file descriptor
- * @param[in] data - additional info
- *
- * @return 0 if operation completes successfully.
- */
-static int
-health_dispatcher_commlib_handler(int fd, void *data, char *buf, int buf_size)
-{
-    int err = 0, peer_id = 0;
-    uint32_t len = MAX_UDP_PAYLOAD;
-    uint8_t message[MAX_UDP_PAYLOAD];
-    struct addr_info from;
-    UNUSED_PARAM(data);
-    UNUSED_PARAM(buf);
-    UNUSED_PARAM(buf_size);
-
-    err = comm_lib_udp_recv(fd, &from, message, &len);
-    MLAG_BAIL_ERROR_MSG(err, "Failed to receive health udp message from ll\n");
-
-    err =
-        mlag_manager_db_peer_local_index_get(ntohl(from.ipv4_addr), &peer_id);
-    if (err == -ENOENT) {
-        err = 0;
-        goto bail;
-    }
-    MLAG_BAIL_ERROR_MSG(err, "Failed to get local index from IP [0x%x]\n",
-                        ntohl(from.ipv4_addr));
-
-    err = health_manager_recv(peer_id, message, len);
-    MLAG_BAIL_ERROR_MSG(err, "Failed in processing health message\n");
-
-bail:
-    return err;
-}
-
 /*
  *  This function dispatches start event
  *
@@ -278,20 +240,21 @@ bail:
 }
 
 /*
- *  This function dispatches timer tick event
+ *  This function dispatches heartbeat state change event
  *
  * @param[in] buffer - event data
  *
  * @return 0 if operation completes successfully.
  */
 static int
-dispatch_timer_tick(uint8_t *buffer)
+dispatch_heartbeat_state_change(uint8_t *buffer)
 {
     int err = 0;
-    UNUSED_PARAM(buffer);
+    struct heartbeat_state_change_data *state_change =
+        (struct heartbeat_state_change_data *)buffer;
 
-    err = health_manager_timer_event();
-    MLAG_BAIL_ERROR_MSG(err, "Failed to process timer tick\n");
+    err = health_manager_heartbeat_state_change(state_change);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to process heartbeat state change\n");
 
 bail:
     return err;
@@ -361,7 +324,8 @@ dispatch_ka_interval_set(uint8_t *buffer)
     struct ka_interval_change_data *change;
 
     change = (struct ka_interval_change_data *)buffer;
-    err = health_manager_heartbeat_interval_set(change->msec);
+    err = health_manager_heartbeat_interval_set(change->msec,
+                                                change->multiplier);
     MLAG_BAIL_ERROR_MSG(err, "Failed setting heartbeat interval\n");
 
 bail:
@@ -466,7 +430,6 @@ mlag_health_dispatcher_init(void)
 {
     int err = 0;
     cl_status_t cl_err;
-    struct udp_params health_udp_conn;
 
     err = init_command_db(&health_cmd_db);
     MLAG_BAIL_CHECK_NO_MSG(err);
@@ -475,10 +438,9 @@ mlag_health_dispatcher_init(void)
     MLAG_BAIL_CHECK_NO_MSG(err);
 
     err =
-        register_events(&event_fds, NULL, 0, medium_prio_events,
-                        NUM_ELEMS(medium_prio_events),
-                        low_prio_event, NUM_ELEMS(
-                            low_prio_event));
+        register_events(&event_fds, high_prio_events,
+                        NUM_ELEMS(high_prio_events), medium_prio_events,
+                        NUM_ELEMS(medium_prio_events), NULL, 0);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
     HEALTH_DISPATCHER_CONF_SET(0, event_fds.high_fd, 0,
@@ -487,32 +449,15 @@ mlag_health_dispatcher_init(void)
                                health_disp_sys_event_buf,
                                sizeof(health_disp_sys_event_buf));
 
-    health_udp_conn.type = CONN_TYPE_UDP_IP_UC;
-    health_udp_conn.fields.ip_udp_params.connection_role = CONN_SERVER;
-    health_udp_conn.fields.ip_udp_params.is_single_peer = 0;
-    health_udp_conn.fields.ip_udp_params.session_params.msg_type = 0;
-    health_udp_conn.fields.ip_udp_params.session_params.port = htons(
-        HEARTBEAT_PORT);
-    health_udp_conn.fields.ip_udp_params.session_params.s_ipv4_addr = htonl(
-        INADDR_ANY);
-    err = comm_lib_udp_session_start(&commlib_handle, &health_udp_conn);
-    MLAG_BAIL_ERROR_MSG(err, "Failed to start health UDP session\n");
-
     HEALTH_DISPATCHER_CONF_SET(1, event_fds.med_fd, 1,
                                dispatcher_sys_event_handler, health_cmd_db,
                                health_disp_sys_event_buf,
                                sizeof(health_disp_sys_event_buf));
-    HEALTH_DISPATCHER_CONF_SET(2, commlib_handle, 2,
-                               health_dispatcher_commlib_handler, NULL, NULL,
-                               0);
-    HEALTH_DISPATCHER_CONF_SET(3, event_fds.low_fd, 3,
-                               dispatcher_sys_event_handler, health_cmd_db,
-                               health_disp_sys_event_buf,
-                               sizeof(health_disp_sys_event_buf));
     health_dispatcher_conf.handlers_num = HEALTH_DISPATCHER_HANDLERS_NUM;
     strncpy(health_dispatcher_conf.name, "Health", DISPATCHER_NAME_MAX_CHARS);
 
-    err = health_manager_init(commlib_handle);
+    /* Heartbeat Tx/Rx runs in its own thread, see heartbeat_thread.c */
+    err = health_manager_init();
     MLAG_BAIL_CHECK_NO_MSG(err);
 
     /* Open Dispatcher context */
@@ -550,9 +495,6 @@ mlag_health_dispatcher_deinit(void)
     err = deinit_command_db(health_cmd_db);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
-    err = comm_lib_udp_session_stop(commlib_handle);
-    MLAG_BAIL_ERROR_MSG(err, "Failed stopping health UDP session\n");
-
 bail:
     return err;
 }
@@ -32,7 +32,7 @@
 /************************************************
  *  Defines
  ***********************************************/
-#define HEALTH_DISPATCHER_HANDLERS_NUM 4
+#define HEALTH_DISPATCHER_HANDLERS_NUM 2
 
 /************************************************
  *  Macros
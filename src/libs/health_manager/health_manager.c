@@ -40,6 +40,7 @@
 #include <libs/mlag_master_election/mlag_master_election.h>
 #include <errno.h>
 #include "heartbeat.h"
+#include "heartbeat_thread.h"
 #include "health_fsm.h"
 
 /************************************************
@@ -74,14 +75,15 @@
 /************************************************
  *  Local variables
  ***********************************************/
-static cl_timer_t heartbeat_timer;
 static int heartbeat_timer_msec;
+static unsigned int heartbeat_multiplier;
 static health_fsm mlag_health_fsm[MLAG_MAX_PEERS];
 static enum oes_port_oper_state ipl_states[MLAG_MAX_IPLS];
 
 static unsigned long long active_sys_ids[MLAG_MAX_PEERS];
-static int send_sock;
 static int started;
+/* Local system ID sent in heartbeats, set when the module starts */
+static volatile unsigned long long local_sys_id;
 
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
 
@@ -89,8 +91,6 @@ static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
  *  Local function declarations
  ***********************************************/
 
-static void heartbeat_tick_cb(void *data);
-
 /************************************************
  *  Function implementations
  ***********************************************/
@@ -253,7 +253,9 @@ bail:
     return err;
 }
 /*
- * This function handles notification of state change from heartbeat module
+ * This function handles notification of state change from heartbeat module.
+ * It runs in the heartbeat thread and only posts the change, with the
+ * current scheduling jitter, to the health dispatcher.
  *
  * @param[in] peer_id - peer id
  * @param[in] heartbeat_state - new heartbeat state
@@ -265,10 +267,55 @@ health_heartbeat_state_change(int peer_id, unsigned long long sys_id,
                               heartbeat_state_t heartbeat_state)
 {
     int err = 0;
+    struct heartbeat_state_change_data state_change;
+    struct heartbeat_thread_stats thread_stats;
+
+    err = heartbeat_thread_stats_get(&thread_stats);
+    MLAG_BAIL_ERROR_MSG(err, "Failed getting heartbeat thread stats\n");
+
+    state_change.peer_id = peer_id;
+    state_change.system_id = sys_id;
+    state_change.state = heartbeat_state;
+    state_change.jitter_last = thread_stats.jitter_last;
+    state_change.jitter_max = thread_stats.jitter_max;
+
+    err = send_system_event(MLAG_HEALTH_HEARTBEAT_STATE_CHANGE, &state_change,
+                            sizeof(state_change));
+    MLAG_BAIL_ERROR_MSG(err, "Failed in sending heartbeat state event\n");
+
+bail:
+    return;
+}
+
+/**
+ *  This function applies a heartbeat state change to the health
+ *  FSM of the peer
+ *
+ * @param[in] state_change - heartbeat state change event data
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+health_manager_heartbeat_state_change(
+    struct heartbeat_state_change_data *state_change)
+{
+    int err = 0;
+    int peer_id = state_change->peer_id;
+    unsigned long long sys_id = state_change->system_id;
+    heartbeat_state_t heartbeat_state = state_change->state;
+
     ASSERT(peer_id < MLAG_MAX_PEERS);
-    MLAG_LOG(MLAG_LOG_INFO,
-             "Peer [%d] sys_id [%llu] heartbeat state is [%u]\n",
-             peer_id, sys_id, heartbeat_state);
+    MLAG_LOG(MLAG_LOG_NOTICE,
+             "Peer [%d] sys_id [%llu] heartbeat state is [%u], "
+             "jitter last [%" PRIu64 "] max [%" PRIu64 "] usec\n",
+             peer_id, sys_id, heartbeat_state, state_change->jitter_last,
+             state_change->jitter_max);
+
+    if (started == FALSE) {
+        /* Posted before stop, peers were reset since */
+        goto bail;
+    }
+
     if (heartbeat_state == HEARTBEAT_DOWN) {
         err = health_fsm_ka_down_ev(&mlag_health_fsm[peer_id]);
         if (err) {
@@ -286,8 +333,10 @@ health_heartbeat_state_change(int peer_id, unsigned long long sys_id,
                      err);
         }
     }
+    err = 0;
+
 bail:
-    return;
+    return err;
 }
 
 /*
@@ -302,25 +351,19 @@ static int
 health_heartbeat_send_message(int peer_id, heartbeat_payload_t *payload)
 {
     int err = 0;
-    struct addr_info dest;
-    uint32_t dest_ip, len;
+    uint32_t dest_ip;
     uint64_t sys_id;
 
-    err = mlag_manager_db_peer_ip_from_local_index_get(peer_id, &dest_ip);
-    MLAG_BAIL_ERROR_MSG(err, "Failed to get peer [%d] ip\n", peer_id);
+    /* Sent on every tick, so no mlag manager DB access here */
+    dest_ip = heartbeat_thread_peer_ip_get(peer_id);
+    if (dest_ip == 0) {
+        err = -ENOENT;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to get peer [%d] ip\n", peer_id);
+    }
 
-    len = sizeof(*payload);
-    dest.ipv4_addr = htonl(dest_ip);
-    dest.port = htons(HEARTBEAT_PORT);
-    sys_id = mlag_manager_db_local_system_id_get();
+    sys_id = local_sys_id;
     SAFE_MEMCPY(&(payload->system_id), &sys_id);
-    err = comm_lib_udp_send(send_sock, dest, (uint8_t *)payload, &len);
-    if (err != ENOKEY) {
-        goto bail;
-    }
-    else {
-        MLAG_BAIL_ERROR_MSG(err, "Unexpected fault in heartbeat send\n");
-    }
+    err = heartbeat_thread_send(dest_ip, payload);
 
 bail:
     return err;
@@ -338,6 +381,7 @@ health_manager_log_verbosity_set(mlag_verbosity_t verbosity)
 {
     LOG_VAR_NAME(__MODULE__) = verbosity;
     heartbeat_log_verbosity_set(verbosity);
+    heartbeat_thread_log_verbosity_set(verbosity);
 }
 
 /**
@@ -346,25 +390,20 @@ health_manager_log_verbosity_set(mlag_verbosity_t verbosity)
  * @return 0 when successful, otherwise ERROR
  */
 int
-health_manager_init(int send_fd)
+health_manager_init(void)
 {
     int i;
     int err = 0;
-    cl_status_t cl_err;
 
     heartbeat_timer_msec = DEFAULT_HEARTBEAT_MSEC;
-
-    cl_err = cl_timer_init(&heartbeat_timer, heartbeat_tick_cb, NULL);
-    if (cl_err != CL_SUCCESS) {
-        err = -EIO;
-        MLAG_BAIL_ERROR_MSG(err, "Failed to init heartbeat timer\n");
-    }
-
-    send_sock = send_fd;
+    heartbeat_multiplier = DEFAULT_HEARTBEAT_MULTIPLIER;
 
     err = heartbeat_init();
     MLAG_BAIL_ERROR_MSG(err, "Heartbeat init failed\n");
 
+    err = heartbeat_thread_init();
+    MLAG_BAIL_ERROR_MSG(err, "Heartbeat thread init failed\n");
+
     for (i = 0; i < MLAG_MAX_PEERS; i++) {
         err = health_fsm_init(&mlag_health_fsm[i], health_fsm_user_trace,
                               health_sched_func, health_unsched_func);
@@ -394,7 +433,8 @@ health_manager_deinit(void)
 {
     int err = 0;
 
-    cl_timer_destroy(&heartbeat_timer);
+    err = heartbeat_thread_deinit();
+    MLAG_BAIL_ERROR_MSG(err, "Heartbeat thread deinit failed\n");
 
     err = heartbeat_deinit();
     MLAG_BAIL_ERROR_MSG(err, "Heartbeat deinit failed\n");
@@ -413,7 +453,9 @@ int
 health_manager_start(void)
 {
     int err = 0;
-    cl_status_t cl_err;
+
+    /* Set by mlag_start before the start event */
+    local_sys_id = mlag_manager_db_local_system_id_get();
 
     /* register heartbeat notify cb */
     err = heartbeat_register_state_cb(health_heartbeat_state_change);
@@ -426,11 +468,8 @@ health_manager_start(void)
     MLAG_BAIL_ERROR_MSG(err, "Heartbeat start failed\n");
 
     /* start timer for heartbeat time tick */
-    cl_err = cl_timer_start(&heartbeat_timer, heartbeat_timer_msec);
-    if (cl_err != CL_SUCCESS) {
-        err = -EIO;
-        MLAG_BAIL_ERROR_MSG(err, "Failed to start heartbeat timer\n");
-    }
+    err = heartbeat_thread_timer_set(heartbeat_timer_msec);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to start heartbeat timer\n");
 
     started = TRUE;
 
@@ -454,7 +493,8 @@ health_manager_stop(void)
     err = heartbeat_register_state_cb(NULL);
     MLAG_BAIL_ERROR(err);
 
-    cl_timer_stop(&heartbeat_timer);
+    err = heartbeat_thread_timer_set(0);
+    MLAG_BAIL_ERROR(err);
 
     err = heartbeat_stop();
     MLAG_BAIL_ERROR_MSG(err, "Failed to stop heartbeat module\n");
@@ -500,8 +540,18 @@ int
 health_manager_recv(int peer_id, void *msg, int msg_size)
 {
     int err = -ECOMM;
-    ASSERT(msg_size == sizeof(heartbeat_payload_t));
-    return heartbeat_recv(peer_id, (heartbeat_payload_t *)msg);
+    heartbeat_payload_t payload;
+
+    if (msg_size == sizeof(heartbeat_payload_t)) {
+        return heartbeat_recv(peer_id, (heartbeat_payload_t *)msg);
+    }
+
+    /* Legacy peer does not negotiate, assume default timers */
+    ASSERT(msg_size == HEARTBEAT_PAYLOAD_LEGACY_SIZE);
+    memcpy(&payload, msg, HEARTBEAT_PAYLOAD_LEGACY_SIZE);
+    payload.tx_interval = htonl(DEFAULT_HEARTBEAT_MSEC);
+    payload.multiplier = DEFAULT_HEARTBEAT_MULTIPLIER;
+    return heartbeat_recv(peer_id, &payload);
 bail:
     return err;
 }
@@ -513,6 +563,7 @@ bail:
  *
  * @param[in] peer_id - peer index
  * @param[in] ipl_id - related ipl index
+ * @param[in] ip - peer IP, host order
  *
  * @return 0 when successful, otherwise ERROR
  */
@@ -520,7 +571,6 @@ int
 health_manager_peer_add(int peer_id, int ipl_id, uint32_t ip)
 {
     int err = 0;
-    UNUSED_PARAM(ip);
 
     ASSERT(peer_id < MLAG_MAX_PEERS);
 
@@ -537,7 +587,13 @@ health_manager_peer_add(int peer_id, int ipl_id, uint32_t ip)
     err = health_fsm_peer_add_ev(&mlag_health_fsm[peer_id], ipl_id);
     MLAG_BAIL_ERROR_MSG(err, "Failure in health FSM peer add\n");
 
+    /* Heartbeats are sent to it from the first tick of the peer */
+    heartbeat_thread_peer_ip_set(peer_id, ip);
+
     err = heartbeat_peer_add(peer_id);
+    if (err) {
+        heartbeat_thread_peer_ip_set(peer_id, 0);
+    }
     MLAG_BAIL_ERROR_MSG(err, "Failure in heartbeat peer add\n");
 
 bail:
@@ -563,6 +619,8 @@ health_manager_peer_remove(int peer_id)
         goto bail;
     }
 
+    heartbeat_thread_peer_ip_set(peer_id, 0);
+
     /* Unregister mgmt events*/
     err = health_fsm_peer_del_ev(&mlag_health_fsm[peer_id]);
     MLAG_BAIL_ERROR_MSG(err, "Failure in health FSM peer delete\n");
@@ -578,21 +636,30 @@ bail:
  *  This function sets the heartbeat interval
  *
  * @param[in] interval_msec - interval in milliseconds
+ * @param[in] multiplier - detection time multiplier, 0 keeps
+ *       the current multiplier
  *
  * @return 0 when successful, otherwise ERROR
  */
 int
-health_manager_heartbeat_interval_set(unsigned int interval_msec)
+health_manager_heartbeat_interval_set(unsigned int interval_msec,
+                                      unsigned int multiplier)
 {
     int err = 0;
 
-    cl_timer_stop(&heartbeat_timer);
+    if (multiplier == 0) {
+        multiplier = heartbeat_multiplier;
+    }
+
+    err = heartbeat_interval_set(interval_msec, multiplier);
+    MLAG_BAIL_ERROR_MSG(err, "Failed setting heartbeat timers\n");
 
     heartbeat_timer_msec = interval_msec;
+    heartbeat_multiplier = multiplier;
 
     if (started == TRUE) {
-        err = health_manager_timer_event();
-        MLAG_BAIL_ERROR_MSG(err, "Failure in timer event handler\n");
+        err = heartbeat_thread_timer_set(heartbeat_timer_msec);
+        MLAG_BAIL_ERROR_MSG(err, "Failed to restart heartbeat timer\n");
     }
 
 bail:
@@ -603,17 +670,67 @@ bail:
  * This function gets the heartbeat interval.
  *
  * @param[out] interval_msec - Interval in milliseconds.
+ * @param[out] multiplier - Detection time multiplier, may be NULL.
  *
  * @return 0 - Operation completed successfully.
  */
 int
-health_manager_heartbeat_interval_get(unsigned int *interval_msec)
+health_manager_heartbeat_interval_get(unsigned int *interval_msec,
+                                      unsigned int *multiplier)
 {
     int err = 0;
 
     ASSERT(interval_msec != NULL);
 
     *interval_msec = heartbeat_timer_msec;
+    if (multiplier != NULL) {
+        *multiplier = heartbeat_multiplier;
+    }
+    goto bail;
+
+bail:
+    return err;
+}
+
+/**
+ * This function sets the heartbeat thread scheduling.
+ *
+ * @param[in] params - Heartbeat thread priority and CPU.
+ *
+ * @return 0 - Operation completed successfully.
+ */
+int
+health_manager_heartbeat_thread_params_set(
+    const struct mlag_heartbeat_thread_params *params)
+{
+    int err = 0;
+
+    ASSERT(params != NULL);
+
+    err = heartbeat_thread_sched_params_set(params->rt_priority,
+                                            params->cpu);
+    MLAG_BAIL_ERROR_MSG(err, "Failed setting heartbeat thread params\n");
+
+bail:
+    return err;
+}
+
+/**
+ * This function gets the heartbeat thread scheduling.
+ *
+ * @param[out] params - Heartbeat thread priority and CPU.
+ *
+ * @return 0 - Operation completed successfully.
+ */
+int
+health_manager_heartbeat_thread_params_get(
+    struct mlag_heartbeat_thread_params *params)
+{
+    int err = 0;
+
+    ASSERT(params != NULL);
+
+    heartbeat_thread_sched_params_get(&params->rt_priority, &params->cpu);
     goto bail;
 
 bail:
@@ -845,30 +962,6 @@ health_manager_peer_states_get(int peer_states[MLAG_MAX_PEERS])
     return err;
 }
 
-/**
- *  This function handles timeout
- *
- * @return 0 when successful, otherwise ERROR
- */
-int
-health_manager_timer_event(void)
-{
-    int err = 0;
-    cl_status_t cl_err;
-
-    cl_err = cl_timer_start(&heartbeat_timer, heartbeat_timer_msec);
-    if (cl_err != CL_SUCCESS) {
-        err = -EIO;
-        MLAG_BAIL_ERROR(err);
-    }
-
-    err = heartbeat_tick();
-    MLAG_BAIL_ERROR_MSG(err, "Failure in heartbeat tick handling\n");
-
-bail:
-    return err;
-}
-
 /**
  *  This function return health module counters
  *
@@ -939,6 +1032,8 @@ mlag_health_manager_counters_clear(void)
     int err = 0;
     int i = 0;
 
+    heartbeat_thread_stats_clear();
+
     /* assume zero represent local machine */
     for (i = 0; i < MLAG_MAX_PEERS; i++) {
         if (mlag_manager_is_peer_valid(i)) {
@@ -1024,12 +1119,14 @@ health_manager_dump(void (*dump_cb)(const char *, ...))
     uint32_t peer_ip;
     heartbeat_state_t hb_states[MLAG_MAX_PEERS];
     heartbeat_peer_stats_t hb_stats;
+    heartbeat_peer_session_t hb_session;
+    struct heartbeat_thread_stats thread_stats;
     int idx;
     char *hb_states_str[] = {"Inactive", "Down", "Up"};
 
     DUMP_OR_LOG("=================\nHealth manager dump\n=================\n");
-    DUMP_OR_LOG("Started [%d] Heartbeat rate (msec) [%u]\n", started,
-                heartbeat_timer_msec);
+    DUMP_OR_LOG("Started [%d] Heartbeat rate (msec) [%u] multiplier [%u]\n",
+                started, heartbeat_timer_msec, heartbeat_multiplier);
     for (idx = 0; idx < MLAG_MAX_IPLS; idx++) {
         DUMP_OR_LOG("IPL ID [%d] state [%s]\n", idx,
                     (ipl_states[idx] == OES_PORT_UP) ? "Up" : "Down" );
@@ -1070,6 +1167,23 @@ health_manager_dump(void (*dump_cb)(const char *, ...))
         }
     }
     DUMP_OR_LOG("----------------------------------------------------------\n");
+    DUMP_OR_LOG("Heartbeat thread\n");
+    err = heartbeat_thread_stats_get(&thread_stats);
+    if (err) {
+        DUMP_OR_LOG("Failed getting Heartbeat thread stats err [%d]\n", err);
+    }
+    else {
+        DUMP_OR_LOG("Wakeups : %" PRIu64 " overruns : %" PRIu64
+                    " Rx errors : %" PRIu64 " \n", thread_stats.wakeups,
+                    thread_stats.overruns, thread_stats.rx_errors);
+        DUMP_OR_LOG("Jitter last/max (usec) : %" PRIu64 " / %" PRIu64 " \n",
+                    thread_stats.jitter_last, thread_stats.jitter_max);
+        if (thread_stats.wakeups) {
+            DUMP_OR_LOG("Jitter avg (usec) : %" PRIu64 " \n",
+                        thread_stats.jitter_total / thread_stats.wakeups);
+        }
+    }
+    DUMP_OR_LOG("----------------------------------------------------------\n");
     DUMP_OR_LOG("Heartbeat statistics\n");
     for (idx = 1; idx < MLAG_MAX_PEERS; idx++) {
         err = heartbeat_peer_stats_get(idx, &hb_stats);
@@ -1084,27 +1198,25 @@ health_manager_dump(void (*dump_cb)(const char *, ...))
         DUMP_OR_LOG("Rx miss: %" PRIu64 " \n", hb_stats.rx_miss);
         DUMP_OR_LOG("RDI : %" PRIu64 " \n", hb_stats.remote_defect);
         DUMP_OR_LOG("Local defect : %" PRIu64 " \n", hb_stats.local_defect);
+        DUMP_OR_LOG("Rx timeout : %" PRIu64 " \n", hb_stats.rx_timeout);
+        DUMP_OR_LOG("Detect time last/max (msec) : %" PRIu64 " / %" PRIu64
+                    " \n", hb_stats.detect_time_last,
+                    hb_stats.detect_time_max);
+        if (hb_stats.rx_timeout) {
+            DUMP_OR_LOG("Detect time avg (msec) : %" PRIu64 " \n",
+                        hb_stats.detect_time_total / hb_stats.rx_timeout);
+        }
+        err = heartbeat_peer_session_get(idx, &hb_session);
+        if (err) {
+            DUMP_OR_LOG("Failed getting Heartbeat session peer [%d] err [%d]\n",
+                        idx, err);
+            continue;
+        }
+        DUMP_OR_LOG("Remote interval [%u] multiplier [%u]\n",
+                    hb_session.remote_interval, hb_session.remote_multiplier);
+        DUMP_OR_LOG("Negotiated Tx interval [%u] detect time [%u] (msec)\n",
+                    hb_session.tx_interval, hb_session.detect_time);
     }
 
     return err;
 }
-
-/*
- *  This function is the action of timer thread callback
- *
- * @param[in] data - timer event data
- *
- * @return 0 if operation completes successfully.
- */
-static void
-heartbeat_tick_cb(void *data)
-{
-    int err = 0;
-    UNUSED_PARAM(data);
-
-    err = send_system_event(MLAG_HEALTH_HEARTBEAT_TICK, NULL, 0);
-    MLAG_BAIL_ERROR_MSG(err, "Failed in sending time tick event\n");
-
-bail:
-    return;
-}
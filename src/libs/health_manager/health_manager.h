@@ -89,13 +89,12 @@ struct health_counters {
 void health_manager_log_verbosity_set(mlag_verbosity_t verbosity);
 
 /**
- *  This function inits the health module
- *
- *  @param sock - socket for heartbeat sending
+ *  This function inits the health module and starts the
+ *  heartbeat thread
  *
  * @return 0 when successful, otherwise ERROR
  */
-int health_manager_init(int sock);
+int health_manager_init(void);
 
 /**
  *  This function de-inits the health module
@@ -139,6 +138,7 @@ int health_manager_recv(int peer_id, void *msg, int msg_size);
  *
  * @param[in] peer_id - peer index
  * @param[in] ipl_id - related ipl index
+ * @param[in] ip - peer IP, host order
  *
  * @return 0 when successful, otherwise ERROR
  */
@@ -159,20 +159,47 @@ int health_manager_peer_remove(int peer_id);
  *  This function sets the heartbeat interval
  *
  * @param[in] interval_msec - interval in milliseconds
+ * @param[in] multiplier - detection time multiplier, 0 keeps
+ *       the current multiplier
  *
  * @return 0 when successful, otherwise ERROR
  */
-int health_manager_heartbeat_interval_set(unsigned int interval_msec);
+int health_manager_heartbeat_interval_set(unsigned int interval_msec,
+                                          unsigned int multiplier);
 
 /**
  * This function gets the heartbeat interval.
  *
  * @param[out] interval_msec - Interval in milliseconds.
+ * @param[out] multiplier - Detection time multiplier, may be NULL.
+ *
+ * @return 0 - Operation completed successfully.
+ */
+int
+health_manager_heartbeat_interval_get(unsigned int *interval_msec,
+                                      unsigned int *multiplier);
+
+/**
+ * This function sets the heartbeat thread scheduling.
+ *
+ * @param[in] params - Heartbeat thread priority and CPU.
  *
  * @return 0 - Operation completed successfully.
  */
 int
-health_manager_heartbeat_interval_get(unsigned int *interval_msec);
+health_manager_heartbeat_thread_params_set(
+    const struct mlag_heartbeat_thread_params *params);
+
+/**
+ * This function gets the heartbeat thread scheduling.
+ *
+ * @param[out] params - Heartbeat thread priority and CPU.
+ *
+ * @return 0 - Operation completed successfully.
+ */
+int
+health_manager_heartbeat_thread_params_get(
+    struct mlag_heartbeat_thread_params *params);
 
 /**
  *  This function deals with FSM timer event
@@ -263,11 +290,15 @@ enum mgmt_oper_state
 health_manager_mgmt_state_get(int peer_id);
 
 /**
- *  This function handles timeout
+ *  This function applies a heartbeat state change to the health
+ *  FSM of the peer
+ *
+ * @param[in] state_change - heartbeat state change event data
  *
  * @return 0 when successful, otherwise ERROR
  */
-int health_manager_timer_event(void);
+int health_manager_heartbeat_state_change(
+    struct heartbeat_state_change_data *state_change);
 
 /**
  *  This function return peer health module counters
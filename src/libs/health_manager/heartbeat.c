@@ -26,6 +26,9 @@
  */ 
 
 #include <errno.h>
+#include <time.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <complib/cl_mem.h>
 #include <complib/cl_types.h>
 #include <utils/mlag_defs.h>
@@ -42,6 +45,12 @@
 /************************************************
  *  Local Macros
  ***********************************************/
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+/* Heartbeat thread runs Tx, Rx and timeouts, configuration
+ * and counters are accessed from the health dispatcher */
+#define HEARTBEAT_LOCK()   pthread_mutex_lock(&heartbeat_mutex)
+#define HEARTBEAT_UNLOCK() pthread_mutex_unlock(&heartbeat_mutex)
 
 /************************************************
  *  Local Type definitions
@@ -61,7 +70,10 @@ struct peer_hb_info {
     uint8_t remote_defect;
     uint16_t last_rx_seq;
     unsigned long long last_rx_sys_id;
-    uint16_t last_rx_tick;
+    uint64_t last_rx_msec;
+    uint64_t next_tx_msec;
+    uint32_t remote_interval;
+    uint8_t remote_multiplier;
     uint8_t consecutive_count;
     struct heartbeat_peer_stats peer_stats;
 };
@@ -70,12 +82,26 @@ struct heartbeat_db_t {
     heartbeat_state_notifier_t state_notify_cb;
     heartbeat_msg_send_t send_cb;
     uint8_t local_defect;
-    uint16_t ticks;
+    uint32_t interval_msec;
+    uint8_t multiplier;
     struct peer_hb_info peer_data[MLAG_MAX_PEERS];
 };
 
+/* State changes found under the heartbeat lock, notified once it is
+ * released so the callback may take other locks */
+struct heartbeat_notify_list {
+    heartbeat_state_notifier_t notify_cb;
+    int num;
+    struct {
+        int peer_id;
+        unsigned long long system_id;
+        heartbeat_state_t state;
+    } notify[MLAG_MAX_PEERS];
+};
+
 struct heartbeat_db_t *heartbeat_db;
 static int started;
+static pthread_mutex_t heartbeat_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
 /************************************************
@@ -86,6 +112,54 @@ static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
  *  Function implementations
  ***********************************************/
 
+/*
+ *  This function returns monotonic time in milliseconds
+ *
+ * @return current time in msec
+ */
+static uint64_t
+heartbeat_now_msec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/*
+ *  This function returns the negotiated Tx interval of a peer,
+ *  the slower of the local and remote desired intervals
+ *
+ * @param[in] peer - peer heartbeat info
+ *
+ * @return Tx interval in msec
+ */
+static uint32_t
+peer_tx_interval(struct peer_hb_info *peer)
+{
+    return MAX(heartbeat_db->interval_msec, peer->remote_interval);
+}
+
+/*
+ *  This function returns the detection time of a peer, the
+ *  remote multiplier times the negotiated interval. Local
+ *  multiplier is used until peer advertises its own.
+ *
+ * @param[in] peer - peer heartbeat info
+ *
+ * @return detection time in msec
+ */
+static uint32_t
+peer_detect_time(struct peer_hb_info *peer)
+{
+    uint32_t multiplier = peer->remote_multiplier;
+
+    if (multiplier == 0) {
+        multiplier = heartbeat_db->multiplier;
+    }
+    return multiplier * peer_tx_interval(peer);
+}
+
 /*
  *  This function dispatches KA interval set event
  *
@@ -106,6 +180,8 @@ send_heartbeat_message(int peer_id)
     payload.sequence = htons(heartbeat_db->peer_data[peer_id].sequence_num++);
     payload.local_defect = heartbeat_db->local_defect;
     payload.remote_defect = heartbeat_db->peer_data[peer_id].remote_defect;
+    payload.tx_interval = htonl(heartbeat_db->interval_msec);
+    payload.multiplier = heartbeat_db->multiplier;
 
     if (heartbeat_db->send_cb != NULL) {
         err = heartbeat_db->send_cb(peer_id, &payload);
@@ -159,8 +235,9 @@ heartbeat_init(void)
 
     heartbeat_db->send_cb = NULL;
     heartbeat_db->state_notify_cb = NULL;
-    heartbeat_db->ticks = 0;
     heartbeat_db->local_defect = 0;
+    heartbeat_db->interval_msec = DEFAULT_HEARTBEAT_MSEC;
+    heartbeat_db->multiplier = DEFAULT_HEARTBEAT_MULTIPLIER;
 
 bail:
     return err;
@@ -197,8 +274,9 @@ heartbeat_start(void)
     int err = 0;
     int peer_id;
 
-    err = heartbeat_local_defect_set(FALSE);
-    MLAG_BAIL_ERROR(err);
+    HEARTBEAT_LOCK();
+
+    heartbeat_db->local_defect = FALSE;
 
     /* Update all the peers as down */
     for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
@@ -211,7 +289,7 @@ heartbeat_start(void)
     }
     started = TRUE;
 
-bail:
+    HEARTBEAT_UNLOCK();
     return err;
 }
 
@@ -226,9 +304,9 @@ heartbeat_stop(void)
     int err = 0;
     int peer_id;
 
+    HEARTBEAT_LOCK();
 
-    err = heartbeat_local_defect_set(TRUE);
-    MLAG_BAIL_ERROR(err);
+    heartbeat_db->local_defect = TRUE;
 
     /* Update all the peers as down */
     for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
@@ -248,8 +326,8 @@ heartbeat_stop(void)
         }
     }
 
-bail:
     started = FALSE;
+    HEARTBEAT_UNLOCK();
     return err;
 }
 
@@ -266,6 +344,8 @@ int
 heartbeat_peer_add(int peer_id)
 {
     int err = 0;
+
+    HEARTBEAT_LOCK();
     ASSERT(peer_id < MLAG_MAX_PEERS);
     ASSERT(heartbeat_db->peer_data[peer_id].peer_state == HEARTBEAT_INACTIVE);
 
@@ -274,6 +354,7 @@ heartbeat_peer_add(int peer_id)
     heartbeat_db->peer_data[peer_id].remote_defect = TRUE;
 
 bail:
+    HEARTBEAT_UNLOCK();
     return err;
 }
 
@@ -291,10 +372,13 @@ int
 heartbeat_peer_remove(int peer_id)
 {
     int err = 0;
+
+    HEARTBEAT_LOCK();
     ASSERT(peer_id < MLAG_MAX_PEERS);
     heartbeat_db->peer_data[peer_id].peer_state = HEARTBEAT_INACTIVE;
     SAFE_MEMSET(&heartbeat_db->peer_data[peer_id].peer_stats, 0);
 bail:
+    HEARTBEAT_UNLOCK();
     return err;
 }
 
@@ -311,7 +395,9 @@ heartbeat_register_state_cb(heartbeat_state_notifier_t notify_cb)
 {
     int err = 0;
 
+    HEARTBEAT_LOCK();
     heartbeat_db->state_notify_cb = notify_cb;
+    HEARTBEAT_UNLOCK();
 
     return err;
 }
@@ -329,7 +415,9 @@ heartbeat_register_send_cb(heartbeat_msg_send_t send_cb)
 {
     int err = 0;
 
+    HEARTBEAT_LOCK();
     heartbeat_db->send_cb = send_cb;
+    HEARTBEAT_UNLOCK();
 
     return err;
 }
@@ -347,34 +435,44 @@ heartbeat_local_defect_set(uint8_t local_defect)
 {
     int err = 0;
 
+    HEARTBEAT_LOCK();
     heartbeat_db->local_defect = local_defect;
+    HEARTBEAT_UNLOCK();
 
     return err;
 }
 
 /*
- *  This function implements sending HB message to all participating peers
+ *  This function implements sending HB message to all participating
+ *  peers whose negotiated Tx interval has elapsed. Half a local
+ *  interval of slack absorbs tick jitter.
+ *
+ * @param[in] now - current time in msec
  *
  * @return 0 if operation completes successfully.
  */
 static int
-send_to_peers(void)
+send_to_peers(uint64_t now)
 {
     int err = 0;
     int peer_id;
+    struct peer_hb_info *peer;
 
     if (started == FALSE) {
         goto bail;
     }
 
     for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
-        if (heartbeat_db->peer_data[peer_id].peer_state !=
-            HEARTBEAT_INACTIVE) {
-            err = send_heartbeat_message(peer_id);
-            MLAG_BAIL_ERROR_MSG(err,
-                                "Failed to send heartbeat to peer_id %d\n",
-                                peer_id);
+        peer = &heartbeat_db->peer_data[peer_id];
+        if ((peer->peer_state == HEARTBEAT_INACTIVE) ||
+            (now + (heartbeat_db->interval_msec / 2) < peer->next_tx_msec)) {
+            continue;
         }
+        err = send_heartbeat_message(peer_id);
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Failed to send heartbeat to peer_id %d\n",
+                            peer_id);
+        peer->next_tx_msec = now + peer_tx_interval(peer);
     }
 
 bail:
@@ -401,6 +499,84 @@ increment_stats_by_message(int peer_id, heartbeat_payload_t *msg_data)
     }
 }
 
+/*
+ *  This function updates peer timers advertised in a received
+ *  payload. A faster negotiated interval takes effect at once.
+ *
+ * @param[in] peer_id - peer id
+ * @param[in] payload - received payload
+ * @param[in] now - current time in msec
+ *
+ * @return void
+ */
+static void
+update_remote_timers(int peer_id, heartbeat_payload_t *payload, uint64_t now)
+{
+    struct peer_hb_info *peer = &heartbeat_db->peer_data[peer_id];
+    uint32_t remote_interval = ntohl(payload->tx_interval);
+
+    if ((remote_interval == peer->remote_interval) &&
+        (payload->multiplier == peer->remote_multiplier)) {
+        return;
+    }
+
+    peer->remote_interval = remote_interval;
+    peer->remote_multiplier = payload->multiplier;
+    if (peer->next_tx_msec > now + peer_tx_interval(peer)) {
+        peer->next_tx_msec = now + peer_tx_interval(peer);
+    }
+
+    MLAG_LOG(MLAG_LOG_NOTICE,
+             "Peer %d heartbeat interval [%u] multiplier [%u], "
+             "negotiated Tx [%u] detect time [%u] msec\n",
+             peer_id, remote_interval, payload->multiplier,
+             peer_tx_interval(peer), peer_detect_time(peer));
+}
+
+/*
+ *  This function queues a peer state change, to be notified after
+ *  the heartbeat lock is released
+ *
+ * @param[in] list - state changes
+ * @param[in] peer_id - peer id
+ * @param[in] system_id - peer system ID
+ * @param[in] state - new heartbeat state
+ *
+ * @return void
+ */
+static void
+notify_add(struct heartbeat_notify_list *list, int peer_id,
+           unsigned long long system_id, heartbeat_state_t state)
+{
+    list->notify_cb = heartbeat_db->state_notify_cb;
+    if ((list->notify_cb == NULL) || (list->num >= MLAG_MAX_PEERS)) {
+        return;
+    }
+    list->notify[list->num].peer_id = peer_id;
+    list->notify[list->num].system_id = system_id;
+    list->notify[list->num].state = state;
+    list->num++;
+}
+
+/*
+ *  This function notifies queued peer state changes, it is called
+ *  without the heartbeat lock
+ *
+ * @param[in] list - state changes
+ *
+ * @return void
+ */
+static void
+notify_flush(struct heartbeat_notify_list *list)
+{
+    int i;
+
+    for (i = 0; i < list->num; i++) {
+        list->notify_cb(list->notify[i].peer_id, list->notify[i].system_id,
+                        list->notify[i].state);
+    }
+}
+
 /**
  *  This function hands a message from peer to the heartbeat
  *  module
@@ -414,7 +590,12 @@ int
 heartbeat_recv(int peer_id, heartbeat_payload_t *payload)
 {
     int err = 0;
+    uint64_t now = heartbeat_now_msec();
+    struct heartbeat_notify_list notify_list;
 
+    notify_list.num = 0;
+
+    HEARTBEAT_LOCK();
     ASSERT(peer_id < MLAG_MAX_PEERS);
 
     if (started == FALSE) {
@@ -433,6 +614,7 @@ heartbeat_recv(int peer_id, heartbeat_payload_t *payload)
              peer_id, rx_seq, payload->remote_defect, payload->local_defect);
 
     increment_stats_by_message(peer_id, payload);
+    update_remote_timers(peer_id, payload, now);
 
     if (heartbeat_db->peer_data[peer_id].peer_state == HEARTBEAT_DOWN) {
         if ((CALC_DISTANCE_U16(rx_seq,
@@ -448,7 +630,7 @@ heartbeat_recv(int peer_id, heartbeat_payload_t *payload)
         heartbeat_db->peer_data[peer_id].remote_defect = FALSE;
         SAFE_MEMCPY(&(heartbeat_db->peer_data[peer_id].last_rx_sys_id),
                     &(payload->system_id));
-        heartbeat_db->peer_data[peer_id].last_rx_tick = heartbeat_db->ticks;
+        heartbeat_db->peer_data[peer_id].last_rx_msec = now;
 
         MLAG_LOG(MLAG_LOG_DEBUG,
                  "Heartbeat Peer [%d] Down seq [%u] remote [%u] count [%u]\n",
@@ -461,11 +643,9 @@ heartbeat_recv(int peer_id, heartbeat_payload_t *payload)
             MLAG_LOG(MLAG_LOG_NOTICE,
                      "Peer %d changed state to heartbeat Up\n", peer_id);
             heartbeat_db->peer_data[peer_id].peer_state = HEARTBEAT_UP;
-            if (heartbeat_db->state_notify_cb) {
-                heartbeat_db->state_notify_cb(peer_id,
-                                              heartbeat_db->peer_data[peer_id].last_rx_sys_id,
-                                              HEARTBEAT_UP);
-            }
+            notify_add(&notify_list, peer_id,
+                       heartbeat_db->peer_data[peer_id].last_rx_sys_id,
+                       HEARTBEAT_UP);
             heartbeat_db->peer_data[peer_id].consecutive_count = 0;
         }
     }
@@ -475,11 +655,9 @@ heartbeat_recv(int peer_id, heartbeat_payload_t *payload)
              payload->system_id)) {
             heartbeat_db->peer_data[peer_id].peer_state = HEARTBEAT_DOWN;
             heartbeat_db->peer_data[peer_id].remote_defect = TRUE;
-            if (heartbeat_db->state_notify_cb) {
-                heartbeat_db->state_notify_cb(peer_id,
-                                              heartbeat_db->peer_data[peer_id].last_rx_sys_id,
-                                              HEARTBEAT_DOWN);
-            }
+            notify_add(&notify_list, peer_id,
+                       heartbeat_db->peer_data[peer_id].last_rx_sys_id,
+                       HEARTBEAT_DOWN);
             MLAG_LOG(MLAG_LOG_NOTICE,
                      "Peer %d move to Down, remote side reported error\n",
                      peer_id);
@@ -492,53 +670,57 @@ heartbeat_recv(int peer_id, heartbeat_payload_t *payload)
             heartbeat_db->peer_data[peer_id].peer_stats.rx_miss++;
         }
         else {
-            heartbeat_db->peer_data[peer_id].last_rx_tick =
-                heartbeat_db->ticks;
+            heartbeat_db->peer_data[peer_id].last_rx_msec = now;
         }
         heartbeat_db->peer_data[peer_id].last_rx_seq = rx_seq;
     }
 
 bail:
+    HEARTBEAT_UNLOCK();
+    notify_flush(&notify_list);
     return err;
 }
 
 /*
  *  This function checks if timeout has occured for any peer
- *  timeout is defined when more than HEARTBEAT_MESSAGE_THRESHOLD
- *  time ticks has passed since last message received
+ *  timeout is defined when more than the peer detection time has
+ *  passed since last message received
  *
- * @param[in] buffer - event data
+ * @param[in] now - current time in msec
+ * @param[out] notify_list - state changes to notify
  *
  * @return 0 if operation completes successfully.
  */
 static int
-check_for_timeout(void)
+check_for_timeout(uint64_t now, struct heartbeat_notify_list *notify_list)
 {
     int err = 0;
     int peer_id;
+    uint64_t elapsed;
+    struct peer_hb_info *peer;
 
     for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
-        if (heartbeat_db->peer_data[peer_id].peer_state == HEARTBEAT_UP) {
-            if (CALC_DISTANCE_U16(heartbeat_db->ticks,
-                                  heartbeat_db->peer_data[peer_id].last_rx_tick)
-                >
-                HEARTBEAT_MESSAGE_THRESHOLD) {
-                /* Timeout on non-receiving message from peer */
-                MLAG_LOG(MLAG_LOG_DEBUG,
-                         "heartbeat_db->ticks [%u] last_rx_tick [%u], timeout\n", heartbeat_db->ticks,
-                         heartbeat_db->peer_data[peer_id].last_rx_tick);
-                MLAG_LOG(MLAG_LOG_NOTICE,
-                         "Peer %d Move to heartbeat down, timeout\n", peer_id);
-                heartbeat_db->peer_data[peer_id].peer_state = HEARTBEAT_DOWN;
-                heartbeat_db->peer_data[peer_id].remote_defect = TRUE;
-                heartbeat_db->peer_data[peer_id].peer_stats.rx_timeout++;
-                if (heartbeat_db->state_notify_cb) {
-                    heartbeat_db->state_notify_cb(peer_id,
-                                                  heartbeat_db->peer_data[
-                                                      peer_id].last_rx_sys_id,
-                                                  HEARTBEAT_DOWN);
-                }
+        peer = &heartbeat_db->peer_data[peer_id];
+        if (peer->peer_state != HEARTBEAT_UP) {
+            continue;
+        }
+        elapsed = now - peer->last_rx_msec;
+        if (elapsed > peer_detect_time(peer)) {
+            /* Timeout on non-receiving message from peer */
+            MLAG_LOG(MLAG_LOG_NOTICE,
+                     "Peer %d Move to heartbeat down, timeout after [%"
+                     PRIu64 "] msec, detect time [%u]\n",
+                     peer_id, elapsed, peer_detect_time(peer));
+            peer->peer_state = HEARTBEAT_DOWN;
+            peer->remote_defect = TRUE;
+            peer->peer_stats.rx_timeout++;
+            peer->peer_stats.detect_time_last = elapsed;
+            peer->peer_stats.detect_time_total += elapsed;
+            if (elapsed > peer->peer_stats.detect_time_max) {
+                peer->peer_stats.detect_time_max = elapsed;
             }
+            notify_add(notify_list, peer_id, peer->last_rx_sys_id,
+                       HEARTBEAT_DOWN);
         }
     }
 
@@ -555,18 +737,93 @@ int
 heartbeat_tick(void)
 {
     int err;
-    /* Happens every time unit */
-    heartbeat_db->ticks++;
+    /* Happens every local interval */
+    uint64_t now = heartbeat_now_msec();
+    struct heartbeat_notify_list notify_list;
+
+    notify_list.num = 0;
+
+    HEARTBEAT_LOCK();
 
     /* check TO */
-    err = check_for_timeout();
+    err = check_for_timeout(now, &notify_list);
     MLAG_BAIL_ERROR_MSG(err, "Failed on checking peers timeout\n");
 
     /* Send to active peers */
-    err = send_to_peers();
+    err = send_to_peers(now);
     MLAG_BAIL_ERROR_MSG(err, "Failed on sending to peers\n");
 
 bail:
+    HEARTBEAT_UNLOCK();
+    notify_flush(&notify_list);
+    return err;
+}
+
+/**
+ *  This function sets the local heartbeat timers. The interval
+ *  is advertised to peers, the Tx interval used with each peer
+ *  is the slower of the local and remote intervals. A peer is
+ *  timed out after multiplier Tx intervals without heartbeats.
+ *
+ * @param[in] interval_msec - desired Tx interval in msec
+ * @param[in] multiplier - detection time multiplier
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+heartbeat_interval_set(unsigned int interval_msec, unsigned int multiplier)
+{
+    int err = 0;
+    int peer_id;
+    uint64_t now = heartbeat_now_msec();
+    struct peer_hb_info *peer;
+
+    HEARTBEAT_LOCK();
+    ASSERT(interval_msec > 0);
+    ASSERT((multiplier > 0) && (multiplier <= UINT8_MAX));
+
+    heartbeat_db->interval_msec = interval_msec;
+    heartbeat_db->multiplier = multiplier;
+
+    for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
+        peer = &heartbeat_db->peer_data[peer_id];
+        if (peer->next_tx_msec > now + peer_tx_interval(peer)) {
+            peer->next_tx_msec = now + peer_tx_interval(peer);
+        }
+    }
+
+bail:
+    HEARTBEAT_UNLOCK();
+    return err;
+}
+
+/**
+ *  This function returns the negotiated session timers of the
+ *  designated peer
+ *
+ * @param[in] peer_id - peer id
+ * @param[out] session - peer session timers
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+heartbeat_peer_session_get(int peer_id, heartbeat_peer_session_t *session)
+{
+    int err = 0;
+    struct peer_hb_info *peer;
+
+    HEARTBEAT_LOCK();
+    ASSERT(peer_id < MLAG_MAX_PEERS);
+    ASSERT(session != NULL);
+
+    peer = &heartbeat_db->peer_data[peer_id];
+    session->remote_interval = peer->remote_interval;
+    session->remote_multiplier = peer->remote_multiplier;
+    session->tx_interval = peer_tx_interval(peer);
+    session->detect_time = peer_detect_time(peer);
+
+bail:
+    HEARTBEAT_UNLOCK();
     return err;
 }
 
@@ -582,9 +839,11 @@ heartbeat_peer_states_get(heartbeat_state_t states[MLAG_MAX_PEERS])
 {
     int err = 0, peer_id;
 
+    HEARTBEAT_LOCK();
     for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
         states[peer_id] = heartbeat_db->peer_data[peer_id].peer_state;
     }
+    HEARTBEAT_UNLOCK();
 
     return err;
 }
@@ -601,9 +860,12 @@ int
 heartbeat_peer_stats_get(int peer_id, heartbeat_peer_stats_t *stats)
 {
     int err = 0;
+
+    HEARTBEAT_LOCK();
     ASSERT(peer_id < MLAG_MAX_PEERS);
     SAFE_MEMCPY(stats, &heartbeat_db->peer_data[peer_id].peer_stats);
 bail:
+    HEARTBEAT_UNLOCK();
     return err;
 }
 
@@ -618,8 +880,11 @@ int
 heartbeat_peer_stats_clear(int peer_id)
 {
     int err = 0;
+
+    HEARTBEAT_LOCK();
     ASSERT(peer_id < MLAG_MAX_PEERS);
     SAFE_MEMSET(&heartbeat_db->peer_data[peer_id].peer_stats, 0);
 bail:
+    HEARTBEAT_UNLOCK();
     return err;
 }
@@ -29,6 +29,7 @@
 #define MLAG_HEARTBEAT_H_
 
 
+#include <stddef.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -41,6 +42,7 @@
 
 #define DEFAULT_HEARTBEAT_MSEC  1000
 #define HEARTBEAT_MESSAGE_THRESHOLD 3
+#define DEFAULT_HEARTBEAT_MULTIPLIER HEARTBEAT_MESSAGE_THRESHOLD
 
 /************************************************
  *  Macros
@@ -57,8 +59,15 @@ typedef struct __attribute__((__packed__)) heartbeat_payload {
     uint16_t sequence;
     uint8_t local_defect;
     uint8_t remote_defect;
+    /* Negotiation fields, absent in legacy payloads */
+    uint32_t tx_interval; /* desired Tx interval in msec, network order */
+    uint8_t multiplier; /* detection time multiplier */
 } heartbeat_payload_t;
 
+/* Payload size of peers that do not negotiate intervals */
+#define HEARTBEAT_PAYLOAD_LEGACY_SIZE \
+    (offsetof(heartbeat_payload_t, tx_interval))
+
 typedef enum heartbeat_state {
     HEARTBEAT_INACTIVE = 0,
     HEARTBEAT_DOWN = 1,
@@ -77,8 +86,18 @@ typedef struct heartbeat_peer_stats {
     uint64_t rx_timeout;
     uint64_t remote_defect;
     uint64_t local_defect;
+    uint64_t detect_time_last; /* msec from last Rx to timeout */
+    uint64_t detect_time_max;
+    uint64_t detect_time_total;
 }heartbeat_peer_stats_t;
 
+typedef struct heartbeat_peer_session {
+    uint32_t remote_interval; /* advertised by peer, msec */
+    uint8_t remote_multiplier;
+    uint32_t tx_interval; /* negotiated, msec */
+    uint32_t detect_time; /* msec */
+}heartbeat_peer_session_t;
+
 /**
  * Callbcak for state changes
  */
@@ -210,6 +229,32 @@ int heartbeat_register_state_cb(heartbeat_state_notifier_t notify_cb);
  */
 int heartbeat_register_send_cb(heartbeat_msg_send_t send_cb);
 
+/**
+ *  This function sets the local heartbeat timers. The interval
+ *  is advertised to peers, the Tx interval used with each peer
+ *  is the slower of the local and remote intervals. A peer is
+ *  timed out after multiplier Tx intervals without heartbeats.
+ *
+ * @param[in] interval_msec - desired Tx interval in msec
+ * @param[in] multiplier - detection time multiplier
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int heartbeat_interval_set(unsigned int interval_msec,
+                           unsigned int multiplier);
+
+/**
+ *  This function returns the negotiated session timers of the
+ *  designated peer
+ *
+ * @param[in] peer_id - peer id
+ * @param[out] session - peer session timers
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int heartbeat_peer_session_get(int peer_id,
+                               heartbeat_peer_session_t *session);
+
 /**
  *  This function returns states for all peers
  *
@@ -0,0 +1,584 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#define _GNU_SOURCE /* CPU affinity */
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <sched.h>
+#include <poll.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <complib/cl_thread.h>
+#include <utils/mlag_defs.h>
+#include <utils/mlag_log.h>
+#include <utils/mlag_bail.h>
+#include <mlnx_lib/lib_commu.h>
+#include "health_manager.h"
+#include "heartbeat.h"
+#include "heartbeat_thread.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+#undef  __MODULE__
+#define __MODULE__ MLAG_HEALTH
+
+enum heartbeat_thread_fds {
+    HB_FD_SOCK = 0,
+    HB_FD_TIMER,
+    HB_FD_WAKE,
+    HB_FD_NUM
+};
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static int hb_sock = -1;
+static int hb_timer_fd = -1;
+static int hb_wake_fd = -1;
+static volatile int hb_thread_exit;
+static cl_thread_t hb_thread;
+static struct heartbeat_thread_stats hb_thread_stats;
+static pthread_mutex_t hb_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Scheduling parameters, applied by the thread itself when changed */
+static int hb_rt_prio = HEARTBEAT_THREAD_RT_PRIO;
+static int hb_cpu = HEARTBEAT_THREAD_CPU;
+static volatile int hb_sched_changed;
+/* Affinity the thread started with, restored when unpinned */
+static cpu_set_t hb_start_cpus;
+/* Peer IPs by peer index, kept by the health manager so that Rx and
+ * Tx do not take the mlag manager DB lock. 0 marks a free entry. */
+static volatile uint32_t hb_peer_ip[MLAG_MAX_PEERS];
+
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/**
+ *  This function sets module log verbosity level
+ *
+ *  @param verbosity - new log verbosity
+ *
+ * @return void
+ */
+void
+heartbeat_thread_log_verbosity_set(mlag_verbosity_t verbosity)
+{
+    LOG_VAR_NAME(__MODULE__) = verbosity;
+}
+
+/*
+ *  This function applies the configured scheduling policy and
+ *  CPU affinity to the calling thread. Failures are logged and
+ *  the thread keeps running with its current scheduling.
+ *
+ * @return void
+ */
+static void
+heartbeat_thread_sched_set(void)
+{
+    int err = 0;
+    int policy = SCHED_OTHER;
+    int rt_prio, cpu;
+    struct sched_param param;
+    cpu_set_t cpus;
+
+    pthread_mutex_lock(&hb_stats_mutex);
+    rt_prio = hb_rt_prio;
+    cpu = hb_cpu;
+    hb_sched_changed = FALSE;
+    pthread_mutex_unlock(&hb_stats_mutex);
+
+    SAFE_MEMSET(&param, 0);
+    if (rt_prio > 0) {
+        policy = SCHED_FIFO;
+        param.sched_priority = rt_prio;
+    }
+    err = pthread_setschedparam(pthread_self(), policy, &param);
+    if (err) {
+        MLAG_LOG(MLAG_LOG_NOTICE,
+                 "Heartbeat thread priority [%d] not set, err [%d]\n",
+                 rt_prio, err);
+    }
+
+    if (cpu >= 0) {
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+    }
+    else {
+        cpus = hb_start_cpus;
+    }
+    err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (err) {
+        MLAG_LOG(MLAG_LOG_NOTICE,
+                 "Heartbeat thread not pinned to CPU [%d], err [%d]\n",
+                 cpu, err);
+    }
+}
+
+/*
+ *  This function handles heartbeat timer expiration. Jitter is
+ *  the time passed since the expiration that woke us, derived
+ *  from the time left to the next one.
+ *
+ * @return 0 if operation completes successfully.
+ */
+static int
+heartbeat_thread_timer_handle(void)
+{
+    int err = 0;
+    uint64_t expirations = 0;
+    uint64_t period, remaining, jitter;
+    struct itimerspec its;
+
+    if (read(hb_timer_fd, &expirations, sizeof(expirations)) !=
+        sizeof(expirations)) {
+        /* Timer re-armed or disarmed since it woke us */
+        goto bail;
+    }
+
+    if (timerfd_gettime(hb_timer_fd, &its) == 0) {
+        period = ((uint64_t)its.it_interval.tv_sec * 1000000) +
+                 (its.it_interval.tv_nsec / 1000);
+        remaining = ((uint64_t)its.it_value.tv_sec * 1000000) +
+                    (its.it_value.tv_nsec / 1000);
+        jitter = (period > remaining) ? (period - remaining) : 0;
+
+        pthread_mutex_lock(&hb_stats_mutex);
+        hb_thread_stats.wakeups++;
+        hb_thread_stats.overruns += expirations - 1;
+        hb_thread_stats.jitter_last = jitter;
+        hb_thread_stats.jitter_total += jitter;
+        if (jitter > hb_thread_stats.jitter_max) {
+            hb_thread_stats.jitter_max = jitter;
+        }
+        pthread_mutex_unlock(&hb_stats_mutex);
+    }
+
+    err = heartbeat_tick();
+    MLAG_BAIL_ERROR_MSG(err, "Failure in heartbeat tick handling\n");
+
+bail:
+    return err;
+}
+
+/*
+ *  This function receives a heartbeat datagram and hands it to
+ *  the heartbeat module
+ *
+ * @return 0 if operation completes successfully.
+ */
+static int
+heartbeat_thread_rx_handle(void)
+{
+    int err = 0;
+    int peer_id;
+    ssize_t len;
+    uint8_t message[MAX_UDP_PAYLOAD];
+    struct sockaddr_in from;
+    socklen_t from_len = sizeof(from);
+
+    len = recvfrom(hb_sock, message, sizeof(message), 0,
+                   (struct sockaddr *)&from, &from_len);
+    if (len < 0) {
+        pthread_mutex_lock(&hb_stats_mutex);
+        hb_thread_stats.rx_errors++;
+        pthread_mutex_unlock(&hb_stats_mutex);
+        goto bail;
+    }
+
+    for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
+        if ((hb_peer_ip[peer_id] != 0) &&
+            (hb_peer_ip[peer_id] == ntohl(from.sin_addr.s_addr))) {
+            break;
+        }
+    }
+    if (peer_id == MLAG_MAX_PEERS) {
+        /* Not a monitored peer */
+        goto bail;
+    }
+
+    err = health_manager_recv(peer_id, message, len);
+    MLAG_BAIL_ERROR_MSG(err, "Failed in processing health message\n");
+
+bail:
+    return err;
+}
+
+/*
+ *  This function is the heartbeat thread main loop. It serves
+ *  heartbeat Tx, Rx and timeouts without passing through the
+ *  health dispatcher queues.
+ *
+ * @param[in] data - unused
+ *
+ * @return void
+ */
+static void
+heartbeat_thread_routine(void *data)
+{
+    struct pollfd fds[HB_FD_NUM];
+    int i;
+    uint64_t wake;
+    UNUSED_PARAM(data);
+
+    pthread_getaffinity_np(pthread_self(), sizeof(hb_start_cpus),
+                           &hb_start_cpus);
+    heartbeat_thread_sched_set();
+
+    fds[HB_FD_SOCK].fd = hb_sock;
+    fds[HB_FD_TIMER].fd = hb_timer_fd;
+    fds[HB_FD_WAKE].fd = hb_wake_fd;
+    for (i = 0; i < HB_FD_NUM; i++) {
+        fds[i].events = POLLIN;
+    }
+
+    while (hb_thread_exit == FALSE) {
+        if (poll(fds, HB_FD_NUM, -1) < 0) {
+            if (errno != EINTR) {
+                MLAG_LOG(MLAG_LOG_ERROR, "Heartbeat thread poll failed [%d]\n",
+                         errno);
+            }
+            continue;
+        }
+        /* Timer first, so Rx bursts can not starve timeouts */
+        if (fds[HB_FD_TIMER].revents & POLLIN) {
+            heartbeat_thread_timer_handle();
+        }
+        if (fds[HB_FD_SOCK].revents & POLLIN) {
+            heartbeat_thread_rx_handle();
+        }
+        if (fds[HB_FD_WAKE].revents & POLLIN) {
+            if (read(hb_wake_fd, &wake, sizeof(wake)) < 0) {
+                /* Already drained */
+            }
+            if (hb_sched_changed == TRUE) {
+                heartbeat_thread_sched_set();
+            }
+        }
+    }
+}
+
+/*
+ *  This function closes the heartbeat socket, timer and wake fd
+ *
+ * @return void
+ */
+static void
+heartbeat_thread_fds_close(void)
+{
+    if (hb_sock >= 0) {
+        close(hb_sock);
+    }
+    if (hb_timer_fd >= 0) {
+        close(hb_timer_fd);
+    }
+    if (hb_wake_fd >= 0) {
+        close(hb_wake_fd);
+    }
+    hb_sock = -1;
+    hb_timer_fd = -1;
+    hb_wake_fd = -1;
+}
+
+/**
+ *  This function opens the heartbeat socket and timer and
+ *  starts the heartbeat thread. Timer is disarmed until
+ *  heartbeat_thread_timer_set is called.
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+heartbeat_thread_init(void)
+{
+    int err = 0;
+    int opt = 1;
+    struct sockaddr_in addr;
+    cl_status_t cl_err;
+
+    hb_sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (hb_sock < 0) {
+        err = -errno;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to open heartbeat socket\n");
+    }
+    setsockopt(hb_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    opt = HEARTBEAT_IP_TOS;
+    setsockopt(hb_sock, IPPROTO_IP, IP_TOS, &opt, sizeof(opt));
+
+    SAFE_MEMSET(&addr, 0);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(HEARTBEAT_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(hb_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        err = -errno;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to bind heartbeat socket\n");
+    }
+
+    hb_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (hb_timer_fd < 0) {
+        err = -errno;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to create heartbeat timer\n");
+    }
+
+    hb_wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (hb_wake_fd < 0) {
+        err = -errno;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to create heartbeat wake fd\n");
+    }
+
+    SAFE_MEMSET(&hb_thread_stats, 0);
+    hb_thread_exit = FALSE;
+
+    cl_err = cl_thread_init(&hb_thread, heartbeat_thread_routine, NULL, NULL);
+    if (cl_err != CL_SUCCESS) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Could not create heartbeat thread\n");
+    }
+
+bail:
+    if (err) {
+        heartbeat_thread_fds_close();
+    }
+    return err;
+}
+
+/**
+ *  This function stops the heartbeat thread and closes its
+ *  socket and timer
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+heartbeat_thread_deinit(void)
+{
+    int err = 0;
+    uint64_t wake = 1;
+
+    hb_thread_exit = TRUE;
+    if (write(hb_wake_fd, &wake, sizeof(wake)) != sizeof(wake)) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to wake heartbeat thread\n");
+    }
+    cl_thread_destroy(&hb_thread);
+
+bail:
+    heartbeat_thread_fds_close();
+    return err;
+}
+
+/**
+ *  This function arms the heartbeat timer with the given
+ *  period, zero disarms it
+ *
+ * @param[in] interval_msec - tick period in msec
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+heartbeat_thread_timer_set(unsigned int interval_msec)
+{
+    int err = 0;
+    struct itimerspec its;
+
+    its.it_interval.tv_sec = interval_msec / 1000;
+    its.it_interval.tv_nsec = (interval_msec % 1000) * 1000000;
+    its.it_value = its.it_interval;
+
+    if (timerfd_settime(hb_timer_fd, 0, &its, NULL) < 0) {
+        err = -errno;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to set heartbeat timer [%u]\n",
+                            interval_msec);
+    }
+
+bail:
+    return err;
+}
+
+/**
+ *  This function sends a heartbeat datagram over the heartbeat
+ *  socket
+ *
+ * @param[in] ip - destination IP, host order
+ * @param[in] payload - heartbeat payload
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+heartbeat_thread_send(uint32_t ip, heartbeat_payload_t *payload)
+{
+    int err = 0;
+    struct sockaddr_in dest;
+
+    SAFE_MEMSET(&dest, 0);
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(HEARTBEAT_PORT);
+    dest.sin_addr.s_addr = htonl(ip);
+
+    if (sendto(hb_sock, payload, sizeof(*payload), 0,
+               (struct sockaddr *)&dest, sizeof(dest)) < 0) {
+        err = -errno;
+    }
+
+    return err;
+}
+
+/**
+ *  This function sets the heartbeat thread scheduling. A running
+ *  thread applies it on its next wakeup.
+ *
+ * @param[in] rt_prio - SCHED_FIFO priority, 0 for default policy
+ * @param[in] cpu - CPU to pin the thread to, negative for none
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+heartbeat_thread_sched_params_set(int rt_prio, int cpu)
+{
+    int err = 0;
+    uint64_t wake = 1;
+
+    pthread_mutex_lock(&hb_stats_mutex);
+    hb_rt_prio = rt_prio;
+    hb_cpu = cpu;
+    hb_sched_changed = TRUE;
+    pthread_mutex_unlock(&hb_stats_mutex);
+
+    if ((hb_wake_fd >= 0) &&
+        (write(hb_wake_fd, &wake, sizeof(wake)) != sizeof(wake))) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to wake heartbeat thread\n");
+    }
+
+bail:
+    return err;
+}
+
+/**
+ *  This function returns the heartbeat thread scheduling
+ *
+ * @param[out] rt_prio - SCHED_FIFO priority, 0 for default policy
+ * @param[out] cpu - CPU the thread is pinned to, negative for none
+ *
+ * @return void
+ */
+void
+heartbeat_thread_sched_params_get(int *rt_prio, int *cpu)
+{
+    pthread_mutex_lock(&hb_stats_mutex);
+    *rt_prio = hb_rt_prio;
+    *cpu = hb_cpu;
+    pthread_mutex_unlock(&hb_stats_mutex);
+}
+
+/**
+ *  This function sets the IP heartbeats of a peer are received
+ *  from, 0 stops receiving from the peer
+ *
+ * @param[in] peer_id - peer index
+ * @param[in] ip - peer IP, host order
+ *
+ * @return void
+ */
+void
+heartbeat_thread_peer_ip_set(int peer_id, uint32_t ip)
+{
+    if ((peer_id >= 0) && (peer_id < MLAG_MAX_PEERS)) {
+        hb_peer_ip[peer_id] = ip;
+    }
+}
+
+/**
+ *  This function gets the IP heartbeats are sent to a peer
+ *
+ * @param[in] peer_id - peer index
+ *
+ * @return peer IP, host order, 0 if the peer is not monitored
+ */
+uint32_t
+heartbeat_thread_peer_ip_get(int peer_id)
+{
+    if ((peer_id >= 0) && (peer_id < MLAG_MAX_PEERS)) {
+        return hb_peer_ip[peer_id];
+    }
+    return 0;
+}
+
+/**
+ *  This function returns heartbeat thread statistics
+ *
+ * @param[out] stats - timer wakeup statistics
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+heartbeat_thread_stats_get(struct heartbeat_thread_stats *stats)
+{
+    int err = 0;
+
+    ASSERT(stats != NULL);
+
+    pthread_mutex_lock(&hb_stats_mutex);
+    SAFE_MEMCPY(stats, &hb_thread_stats);
+    pthread_mutex_unlock(&hb_stats_mutex);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function clears heartbeat thread statistics
+ *
+ * @return void
+ */
+void
+heartbeat_thread_stats_clear(void)
+{
+    pthread_mutex_lock(&hb_stats_mutex);
+    SAFE_MEMSET(&hb_thread_stats, 0);
+    pthread_mutex_unlock(&hb_stats_mutex);
+}
@@ -0,0 +1,185 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#ifndef MLAG_HEARTBEAT_THREAD_H_
+#define MLAG_HEARTBEAT_THREAD_H_
+
+#include <stdint.h>
+#include <utils/mlag_defs.h>
+#include <utils/mlag_log.h>
+#include "heartbeat.h"
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* Default SCHED_FIFO priority of the heartbeat thread, 0 keeps default
+ * policy. Changed at runtime by heartbeat_thread_sched_params_set. */
+#ifndef HEARTBEAT_THREAD_RT_PRIO
+#define HEARTBEAT_THREAD_RT_PRIO 0
+#endif
+
+/* Default CPU the heartbeat thread is pinned to, negative leaves it
+ * unpinned */
+#ifndef HEARTBEAT_THREAD_CPU
+#define HEARTBEAT_THREAD_CPU (-1)
+#endif
+
+/* DSCP CS6 (network control) for heartbeat datagrams */
+#define HEARTBEAT_IP_TOS 0xC0
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+/* Timer wakeup statistics, jitter is the wakeup lateness in usec */
+struct heartbeat_thread_stats {
+    uint64_t wakeups;
+    uint64_t overruns;
+    uint64_t jitter_last;
+    uint64_t jitter_max;
+    uint64_t jitter_total;
+    uint64_t rx_errors;
+};
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ *  This function sets module log verbosity level
+ *
+ *  @param verbosity - new log verbosity
+ *
+ * @return void
+ */
+void heartbeat_thread_log_verbosity_set(mlag_verbosity_t verbosity);
+
+/**
+ *  This function opens the heartbeat socket and timer and
+ *  starts the heartbeat thread. Timer is disarmed until
+ *  heartbeat_thread_timer_set is called.
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int heartbeat_thread_init(void);
+
+/**
+ *  This function stops the heartbeat thread and closes its
+ *  socket and timer
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int heartbeat_thread_deinit(void);
+
+/**
+ *  This function arms the heartbeat timer with the given
+ *  period, zero disarms it
+ *
+ * @param[in] interval_msec - tick period in msec
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int heartbeat_thread_timer_set(unsigned int interval_msec);
+
+/**
+ *  This function sends a heartbeat datagram over the heartbeat
+ *  socket
+ *
+ * @param[in] ip - destination IP, host order
+ * @param[in] payload - heartbeat payload
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int heartbeat_thread_send(uint32_t ip, heartbeat_payload_t *payload);
+
+/**
+ *  This function sets the heartbeat thread scheduling. A running
+ *  thread applies it on its next wakeup.
+ *
+ * @param[in] rt_prio - SCHED_FIFO priority, 0 for default policy
+ * @param[in] cpu - CPU to pin the thread to, negative for none
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int heartbeat_thread_sched_params_set(int rt_prio, int cpu);
+
+/**
+ *  This function returns the heartbeat thread scheduling
+ *
+ * @param[out] rt_prio - SCHED_FIFO priority, 0 for default policy
+ * @param[out] cpu - CPU the thread is pinned to, negative for none
+ *
+ * @return void
+ */
+void heartbeat_thread_sched_params_get(int *rt_prio, int *cpu);
+
+/**
+ *  This function sets the IP heartbeats of a peer are received
+ *  from, 0 stops receiving from the peer
+ *
+ * @param[in] peer_id - peer index
+ * @param[in] ip - peer IP, host order
+ *
+ * @return void
+ */
+void heartbeat_thread_peer_ip_set(int peer_id, uint32_t ip);
+
+/**
+ *  This function gets the IP heartbeats are sent to a peer
+ *
+ * @param[in] peer_id - peer index
+ *
+ * @return peer IP, host order, 0 if the peer is not monitored
+ */
+uint32_t heartbeat_thread_peer_ip_get(int peer_id);
+
+/**
+ *  This function returns heartbeat thread statistics
+ *
+ * @param[out] stats - timer wakeup statistics
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int heartbeat_thread_stats_get(struct heartbeat_thread_stats *stats);
+
+/**
+ *  This function clears heartbeat thread statistics
+ *
+ * @return void
+ */
+void heartbeat_thread_stats_clear(void);
+
+#endif /* MLAG_HEARTBEAT_THREAD_H_ */
@@ -33,6 +33,7 @@
 #include <errno.h>
 #include <complib/cl_init.h>
 #include <complib/cl_mem.h>
+#include "mlag_common.h"
 #include "lacp_db.h"
 
 /************************************************
@@ -143,8 +144,9 @@ pending_entry_deinit(const cl_pool_item_t * const p_pool_item, void *context)
 }
 
 /**
- *  This function inits lacp DB, it allocates MLAG_MAX_PORTS
- *  port entries in pool
+ *  This function inits lacp DB. The pools hold up to max ports
+ *  entries, entries beyond the default number of ports are
+ *  allocated on demand.
  *
  * @return 0 when successful, otherwise ERROR
  */
@@ -153,9 +155,16 @@ lacp_db_init(void)
 {
     int err = 0;
     cl_status_t cl_status = CL_SUCCESS;
+    uint32_t max_entries = mlag_max_ports_get();
+    uint32_t min_entries = MLAG_MAX_PORTS_DEFAULT;
+
+    if (min_entries > max_entries) {
+        min_entries = max_entries;
+    }
 
     cl_status = cl_qpool_init(&(mlag_lacp_db.port_pool),
-                              MLAG_MAX_PORTS, MLAG_MAX_PORTS, 0,
+                              min_entries, max_entries,
+                              MLAG_MAX_PORTS_DEFAULT,
                               sizeof(struct mlag_lacp_entry), lacp_entry_init,
                               lacp_entry_deinit, NULL );
     if (cl_status != CL_SUCCESS) {
@@ -165,7 +174,8 @@ lacp_db_init(void)
     cl_qmap_init(&(mlag_lacp_db.port_map));
 
     cl_status = cl_qpool_init(&(mlag_lacp_db.pending_pool),
-                              MLAG_MAX_PORTS, MLAG_MAX_PORTS, 0,
+                              min_entries, max_entries,
+                              MLAG_MAX_PORTS_DEFAULT,
                               sizeof(struct lacp_pending_entry),
                               pending_entry_init, pending_entry_deinit, NULL );
     if (cl_status != CL_SUCCESS) {
@@ -347,7 +357,7 @@ bail:
 
 /**
  *  This function sets lacp info in DB, copies info to DB entry
- *  struct
+ *  struct. A new entry gets the next selection table version.
  *
  * @param[in]  port_id - port ID
  * @param[out] lacp_info - the allocated lacp_info
@@ -376,6 +386,12 @@ lacp_db_entry_allocate(unsigned long port_id,
         }
         lacp_entry =
             PARENT_STRUCT(pool_item, struct mlag_lacp_entry, pool_item);
+        /* Version zero is kept for no version */
+        mlag_lacp_db.version++;
+        if (mlag_lacp_db.version == 0) {
+            mlag_lacp_db.version++;
+        }
+        lacp_entry->lacp_info.version = mlag_lacp_db.version;
     }
     else {
         lacp_entry = PARENT_STRUCT(map_item, struct mlag_lacp_entry, map_item);
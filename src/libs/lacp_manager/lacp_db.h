@@ -85,6 +85,7 @@ struct mlag_lacp_data {
     unsigned int partner_key;
     unsigned long long partner_id;
     int peer_state[MLAG_MAX_PEERS];
+    uint32_t version; /* selection table version the binding was made at */
 };
 
 struct mlag_lacp_entry {
@@ -105,6 +106,7 @@ struct lacp_db {
     cl_qmap_t pending_map;
     unsigned long long local_sys_id;
     unsigned long long master_sys_id;
+    uint32_t version; /* bumped whenever a binding is created */
     struct lacp_manager_counters counters;
 };
 
@@ -114,11 +116,13 @@ struct __attribute__((__packed__)) lacp_aggregation_message_data {
     uint16_t response;
     uint16_t force;
     uint16_t select;
-    int mlag_id;
-    unsigned int request_id;
-    unsigned long port_id;
-    unsigned long long partner_id;
-    unsigned int partner_key;
+    int32_t mlag_id;
+    uint32_t request_id;
+    uint64_t port_id;
+    uint64_t partner_id;
+    uint32_t partner_key;
+    uint32_t version; /* request: replica version when answered locally,
+                       * response: version of the master binding */
 };
 
 struct lacp_pending_entry {
@@ -150,8 +154,8 @@ void
 lacp_db_log_verbosity_set(mlag_verbosity_t verbosity);
 
 /**
- *  This function inits port DB, it allocates MLAG_MAX_PORTS
- *  port entries in pool
+ *  This function inits port DB, its pool holds up to the
+ *  maximum number of ports (mlag_max_ports_get)
  *
  * @return 0 when successful, otherwise ERROR
  */
@@ -224,7 +228,7 @@ lacp_db_entry_get(unsigned long port_id, struct mlag_lacp_data **lacp_info);
 
 /**
  *  This function sets lacp info in DB, copies info to DB entry
- *  struct
+ *  struct. A new entry gets the next selection table version.
  *
  * @param[in]  port_id - port ID
  * @param[out] lacp_info - the allocated lacp_info
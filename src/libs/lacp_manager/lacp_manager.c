@@ -27,6 +27,7 @@
 #define LACP_MANAGER_C_
 
 #include <errno.h>
+#include <complib/cl_mem.h>
 #include <utils/mlag_bail.h>
 #include <utils/mlag_defs.h>
 #include <utils/mlag_events.h>
@@ -35,7 +36,9 @@
 #include <libs/mlag_master_election/mlag_master_election.h>
 #include <libs/health_manager/health_manager.h>
 #include "lib_commu.h"
+#include "mlag_common.h"
 #include "mlag_comm_layer_wrapper.h"
+#include "mlag_wire.h"
 #include <libs/mlag_manager/mlag_dispatcher.h>
 #include <libs/port_manager/port_db.h>
 #include <libs/notification_layer/notification_layer.h>
@@ -45,7 +48,6 @@
 
 
 static int rcv_msg_handler(uint8_t *data);
-static int net_order_msg_handler(uint8_t *payload, int oper);
 /************************************************
  *  Global variables
  ***********************************************/
@@ -58,18 +60,76 @@ static int started;
 static int lacp_enabled;
 static enum master_election_switch_status current_role;
 static int use_local_lacp_logic;
+/* Ports to delete on peer down, sized on init to the LACP DB capacity */
+static unsigned long *peer_down_ports;
+static struct lacp_fast_path_counters fast_path_counters;
 static handler_command_t lacp_manager_ibc_msgs[] = {
     {MLAG_LACP_SYNC_MSG, "LACP sync message", rcv_msg_handler,
-     net_order_msg_handler },
+     NULL},
     {MLAG_LACP_SELECTION_EVENT, "Mlag LACP selection event",
-     rcv_msg_handler, net_order_msg_handler },
+     rcv_msg_handler, NULL},
     {MLAG_LACP_RELEASE_EVENT, "Mlag LACP release event",
-     rcv_msg_handler, net_order_msg_handler },
+     rcv_msg_handler, NULL},
+    {MLAG_LACP_SELECTIONS_EVENT, "Mlag LACP selections event",
+     rcv_msg_handler, NULL},
 
 
     {0, "", NULL, NULL}
 };
 
+static const struct mlag_wire_field lacp_sync_wire[] = {
+    MLAG_WIRE_FIELD(struct peer_lacp_sync_message, phase),
+    MLAG_WIRE_FIELD(struct peer_lacp_sync_message, sys_id),
+    MLAG_WIRE_FIELD(struct peer_lacp_sync_message, mlag_id),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field lacp_aggregation_wire[] = {
+    MLAG_WIRE_FIELD(struct lacp_aggregation_message_data, is_response),
+    MLAG_WIRE_FIELD(struct lacp_aggregation_message_data, response),
+    MLAG_WIRE_FIELD(struct lacp_aggregation_message_data, force),
+    MLAG_WIRE_FIELD(struct lacp_aggregation_message_data, select),
+    MLAG_WIRE_FIELD(struct lacp_aggregation_message_data, mlag_id),
+    MLAG_WIRE_FIELD(struct lacp_aggregation_message_data, request_id),
+    MLAG_WIRE_FIELD(struct lacp_aggregation_message_data, port_id),
+    MLAG_WIRE_FIELD(struct lacp_aggregation_message_data, partner_id),
+    MLAG_WIRE_FIELD(struct lacp_aggregation_message_data, partner_key),
+    MLAG_WIRE_FIELD(struct lacp_aggregation_message_data, version),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field lacp_release_wire[] = {
+    MLAG_WIRE_FIELD(struct lacp_aggregator_release_message, port_id),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field lacp_selection_entry_wire[] = {
+    MLAG_WIRE_FIELD(struct lacp_selection_entry, response),
+    MLAG_WIRE_FIELD(struct lacp_selection_entry, force),
+    MLAG_WIRE_FIELD(struct lacp_selection_entry, request_id),
+    MLAG_WIRE_FIELD(struct lacp_selection_entry, port_id),
+    MLAG_WIRE_FIELD(struct lacp_selection_entry, partner_id),
+    MLAG_WIRE_FIELD(struct lacp_selection_entry, partner_key),
+    MLAG_WIRE_FIELD(struct lacp_selection_entry, version),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field lacp_selections_wire[] = {
+    MLAG_WIRE_FIELD(struct lacp_selections_message, is_response),
+    MLAG_WIRE_FIELD(struct lacp_selections_message, mlag_id),
+    MLAG_WIRE_FIELD(struct lacp_selections_message, entry_num),
+    MLAG_WIRE_PORT_STRUCT_ARRAY(struct lacp_selections_message, entries,
+                                entry_num, lacp_selection_entry_wire),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_msg lacp_manager_wire_msgs[] = {
+    MLAG_WIRE_MSG(MLAG_LACP_SYNC_MSG, lacp_sync_wire),
+    MLAG_WIRE_MSG(MLAG_LACP_SELECTION_EVENT, lacp_aggregation_wire),
+    MLAG_WIRE_MSG(MLAG_LACP_RELEASE_EVENT, lacp_release_wire),
+    MLAG_WIRE_MSG(MLAG_LACP_SELECTIONS_EVENT, lacp_selections_wire),
+};
+
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_DEBUG;
 
 /************************************************
@@ -165,137 +225,6 @@ bail:
     return err;
 }
 
-/*
- *  Convert struct between network and host order
- *
- * @param[in,out] data - struct body
- * @param[in] oper - convertion direction
- *
- * @return 0 when successful, otherwise ERROR
- */
-static void
-net_order_lacp_sync_data(
-    struct peer_lacp_sync_message *data, int oper)
-{
-    if (oper == MESSAGE_SENDING) {
-        data->mlag_id = htonl(data->mlag_id);
-        data->phase = htonl(data->phase);
-    }
-    else {
-        data->mlag_id = ntohl(data->mlag_id);
-        data->phase = ntohl(data->phase);
-    }
-}
-
-/*
- *  Convert struct between network and host order
- *
- * @param[in,out] data - struct body
- * @param[in] oper - convertion direction
- *
- * @return 0 when successful, otherwise ERROR
- */
-static void
-net_order_aggregator_release_data(struct lacp_aggregator_release_message *data,
-                                  int oper)
-{
-    if (oper == MESSAGE_SENDING) {
-        data->port_id = htonl(data->port_id);
-    }
-    else {
-        data->port_id = ntohl(data->port_id);
-    }
-}
-
-/*
- *  Convert struct between network and host order
- *
- * @param[in,out] data - struct body
- * @param[in] oper - convertion direction
- *
- * @return 0 when successful, otherwise ERROR
- */
-static void
-net_order_aggregator_selection_data(struct lacp_aggregation_message_data *data,
-                                    int oper)
-{
-    if (oper == MESSAGE_SENDING) {
-        data->force = htons(data->force);
-        data->is_response = htons(data->is_response);
-        data->mlag_id = htonl(data->mlag_id);
-        data->partner_key = htonl(data->partner_key);
-        data->port_id = htonl(data->port_id);
-        data->request_id = htonl(data->request_id);
-        data->response = htons(data->response);
-        data->select = htons(data->select);
-    }
-    else {
-        data->force = ntohs(data->force);
-        data->is_response = ntohs(data->is_response);
-        data->mlag_id = ntohl(data->mlag_id);
-        data->partner_key = ntohl(data->partner_key);
-        data->port_id = ntohl(data->port_id);
-        data->request_id = ntohl(data->request_id);
-        data->response = ntohs(data->response);
-        data->select = ntohs(data->select);
-    }
-}
-
-/*
- *  This function is called to handle network order for IBC message
- *
- * @param[in] payload_data - message body
- * @param[in] oper - on send or receive
- *
- * @return 0 when successful, otherwise ERROR
- */
-static int
-net_order_msg_handler(uint8_t *data, int oper)
-{
-    int err = 0;
-    uint16_t opcode;
-    struct peer_lacp_sync_message *lacp_sync;
-    struct lacp_aggregator_release_message *rel_msg;
-    struct lacp_aggregation_message_data *agg_msg;
-
-    if (oper == MESSAGE_SENDING) {
-        opcode = *(uint16_t*)data;
-        *(uint16_t*)data = htons(opcode);
-    }
-    else {
-        opcode = ntohs(*(uint16_t*)data);
-        *(uint16_t*)data = opcode;
-    }
-
-    MLAG_LOG(MLAG_LOG_DEBUG,
-             "lacp_manager net_order_msg_handler: opcode=%d\n",
-             opcode);
-
-    switch (opcode) {
-    case MLAG_LACP_SYNC_MSG:
-        lacp_sync = (struct peer_lacp_sync_message *) data;
-        net_order_lacp_sync_data(lacp_sync, oper);
-        break;
-    case MLAG_LACP_SELECTION_EVENT:
-        agg_msg = (struct lacp_aggregation_message_data *) data;
-        net_order_aggregator_selection_data(agg_msg, oper);
-        break;
-    case MLAG_LACP_RELEASE_EVENT:
-        rel_msg = (struct lacp_aggregator_release_message *) data;
-        net_order_aggregator_release_data(rel_msg, oper);
-        break;
-
-    default:
-        /* Unknown opcode */
-        err = -ENOENT;
-        MLAG_BAIL_ERROR_MSG(err, "Unknown opcode [%u] in lacp manager\n",
-                            opcode);
-        break;
-    }
-bail:
-    return err;
-}
-
 /*
  *  Handle incoming LACP sync data
  *
@@ -308,8 +237,8 @@ update_lacp_master_attributes(struct peer_lacp_sync_message *lacp_sync)
 {
     int err = 0;
 
-    MLAG_LOG(MLAG_LOG_NOTICE,
-             "got lacp sync id is [%llu]\n", lacp_sync->sys_id);
+    MLAG_LOG(MLAG_LOG_NOTICE, "got lacp sync id is [%llu]\n",
+             (unsigned long long)lacp_sync->sys_id);
 
     if (current_role == SLAVE) {
 
@@ -340,6 +269,7 @@ handle_lacp_sync_msg(struct peer_lacp_sync_message *lacp_sync)
     int err = 0;
     struct mlag_master_election_status me_status;
     struct peer_lacp_sync_message sync_message;
+    unsigned long long sys_id;
 
     ASSERT(lacp_sync != NULL);
 
@@ -351,8 +281,9 @@ handle_lacp_sync_msg(struct peer_lacp_sync_message *lacp_sync)
         /* send sync data if master */
         sync_message.mlag_id = me_status.my_peer_id;
         sync_message.phase = LACP_SYNC_DATA;
-        err = lacp_db_local_system_id_get(&sync_message.sys_id);
+        err = lacp_db_local_system_id_get(&sys_id);
         MLAG_BAIL_ERROR_MSG(err, "Failed getting local actor attributes\n");
+        sync_message.sys_id = sys_id;
 
         /* Send message to master */
         MLAG_LOG(MLAG_LOG_DEBUG,
@@ -420,6 +351,7 @@ rcv_msg_handler(uint8_t *data)
     struct peer_lacp_sync_message *lacp_sync;
     struct lacp_aggregation_message_data *select_req;
     struct lacp_aggregator_release_message *rel_msg;
+    struct lacp_selections_message *selections_msg;
 
     opcode = *((uint16_t*)(payload_data->payload[0]));
 
@@ -454,6 +386,14 @@ rcv_msg_handler(uint8_t *data)
         err = lacp_manager_aggregator_free_handle(rel_msg);
         MLAG_BAIL_ERROR_MSG(err, "Failed to handle aggregation free event\n");
         break;
+    case MLAG_LACP_SELECTIONS_EVENT:
+        selections_msg =
+            (struct lacp_selections_message *) payload_data->payload[0];
+
+        err = lacp_manager_aggregator_selections_handle(selections_msg);
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Failed to handle aggregation selections event\n");
+        break;
     default:
         /* Unknown opcode */
         err = -ENOENT;
@@ -475,6 +415,7 @@ bail:
  * @param[out] response - selected or not
  * @param[out] current_partner_id - currently selected partner id
  * @param[out] current_partner_key - currently selected partner key
+ * @param[out] current_version - version of the current selection
  *
  * @return 0 when successful, otherwise ERROR
  */
@@ -485,7 +426,8 @@ lacp_aggregator_select_logic(int mlag_id,
                              unsigned int partner_key,
                              enum aggregate_select_response *response,
                              unsigned long long *current_partner_id,
-                             unsigned int *current_partner_key)
+                             unsigned int *current_partner_key,
+                             uint32_t *current_version)
 {
     int err = 0;
     int i;
@@ -516,6 +458,7 @@ lacp_aggregator_select_logic(int mlag_id,
     }
     *current_partner_key = lacp_data->partner_key;
     *current_partner_id = lacp_data->partner_id;
+    *current_version = lacp_data->version;
 
 bail:
     return err;
@@ -667,6 +610,103 @@ bail:
     return err;
 }
 
+/*
+ * Sends selection requests of several ports in one message
+ *
+ * @param[in] msg - selections message
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+send_selections_message(struct lacp_selections_message *msg)
+{
+    int err = 0;
+    struct mlag_master_election_status me_status;
+
+    err = mlag_master_election_get_status(&me_status);
+    MLAG_BAIL_ERROR_MSG(err, "Failed getting ME status\n");
+
+    /* send message to logic */
+    msg->mlag_id = me_status.my_peer_id;
+    msg->is_response = FALSE;
+
+    if ((current_role == SLAVE) && (use_local_lacp_logic == TRUE)) {
+        err = send_system_event(MLAG_LACP_SELECTIONS_EVENT, msg,
+                                LACP_SELECTIONS_MSG_SIZE(msg->entry_num));
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Failed in sending MLAG_LACP_SELECTIONS_EVENT event\n");
+    }
+    else {
+        err = lacp_manager_message_send(MLAG_LACP_SELECTIONS_EVENT, msg,
+                                        LACP_SELECTIONS_MSG_SIZE(
+                                            msg->entry_num),
+                                        me_status.master_peer_id,
+                                        PEER_MANAGER);
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Failed sending selection requests of [%u] ports\n",
+                            msg->entry_num);
+    }
+
+bail:
+    return err;
+}
+
+/*
+ * Fills a single port selection from an entry of a selections message
+ *
+ * @param[in] msg - selections message
+ * @param[in] entry - entry of the message
+ * @param[out] request - selection data of the entry port
+ *
+ * @return void
+ */
+static void
+selection_entry_to_request(struct lacp_selections_message *msg,
+                           struct lacp_selection_entry *entry,
+                           struct lacp_aggregation_message_data *request)
+{
+    request->is_response = msg->is_response;
+    request->mlag_id = msg->mlag_id;
+    request->select = TRUE;
+    request->response = entry->response;
+    request->force = entry->force;
+    request->request_id = entry->request_id;
+    request->port_id = entry->port_id;
+    request->partner_id = entry->partner_id;
+    request->partner_key = entry->partner_key;
+    request->version = entry->version;
+}
+
+/*
+ * Notifies the response to a selection request
+ *
+ * @param[in] msg - selection response data
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+notify_selection(struct lacp_aggregation_message_data *msg)
+{
+    int err = 0;
+    struct mlag_notification notify;
+
+    /* fill notification msg */
+    notify.notification_type = MLAG_NOTIFY_AGGREGATOR_RESPONSE;
+    notify.notification_info.agg_response.request_id = msg->request_id;
+    notify.notification_info.agg_response.req_partner_id = msg->partner_id;
+    notify.notification_info.agg_response.req_partner_key = msg->partner_key;
+    notify.notification_info.agg_response.req_port_id = msg->port_id;
+    notify.notification_info.agg_response.response = msg->response;
+
+    err = mlag_notify(&notify);
+    MLAG_BAIL_ERROR_MSG(err,
+                        "Failed to notify response for port [%lu] req [%u]",
+                        msg->port_id, msg->request_id);
+
+bail:
+    return err;
+}
+
 /*
  * Sends notification to reject request
  *
@@ -679,7 +719,6 @@ notify_aggregator_selection_response(struct lacp_aggregation_message_data *msg)
 {
     int err = 0;
     struct lacp_aggregation_message_data *db_req = NULL;
-    struct mlag_notification notify;
 
     /* check if there is a pending request in DB */
     err = lacp_db_pending_request_get(msg->port_id, &db_req);
@@ -693,18 +732,30 @@ notify_aggregator_selection_response(struct lacp_aggregation_message_data *msg)
     }
     MLAG_BAIL_ERROR(err);
 
-    /* fill notification msg */
-    notify.notification_type = MLAG_NOTIFY_AGGREGATOR_RESPONSE;
-    notify.notification_info.agg_response.request_id = msg->request_id;
-    notify.notification_info.agg_response.req_partner_id = msg->partner_id;
-    notify.notification_info.agg_response.req_partner_key = msg->partner_key;
-    notify.notification_info.agg_response.req_port_id = msg->port_id;
-    notify.notification_info.agg_response.response = msg->response;
-
-    err = mlag_notify(&notify);
-    MLAG_BAIL_ERROR_MSG(err,
-                        "Failed to notify response for port [%lu] req [%u]",
-                        msg->port_id, msg->request_id);
+    if (db_req->version != 0) {
+        /* Request was accepted locally. The master confirms it only by
+         * accepting with the binding version it was answered from, any
+         * other answer replaces the local one.
+         */
+        if ((msg->response == LACP_AGGREGATE_ACCEPT) &&
+            (msg->version == db_req->version)) {
+            fast_path_counters.confirmed++;
+        }
+        else {
+            fast_path_counters.revoked++;
+            MLAG_LOG(MLAG_LOG_NOTICE,
+                     "Local selection of port [%lu] req [%u] revoked, "
+                     "version [%u] master version [%u]\n",
+                     msg->port_id, msg->request_id, db_req->version,
+                     msg->version);
+            err = notify_selection(msg);
+            MLAG_BAIL_ERROR(err);
+        }
+    }
+    else {
+        err = notify_selection(msg);
+        MLAG_BAIL_ERROR(err);
+    }
 
     err = lacp_db_pending_request_delete(msg->port_id);
     MLAG_BAIL_ERROR_MSG(err,
@@ -846,12 +897,242 @@ clear_peer(struct mlag_lacp_data *lacp_info, void *data)
         /* Ignore error deliberately */
 
         /* mark for deletion */
+        ASSERT(peer_down->port_num < peer_down->port_max);
         peer_down->ports_to_delete[peer_down->port_num] = lacp_info->port_id;
         peer_down->port_num++;
     }
 
+bail:
     return err;
 }
+
+/*
+ * Checks if the LACP DB holds a replica of the master selection
+ * table, which is the case on a slave using the master logic
+ *
+ * @return TRUE if the LACP DB is a replica, otherwise FALSE
+ */
+static int
+lacp_replica_active(void)
+{
+    return ((current_role == SLAVE) && (use_local_lacp_logic == FALSE));
+}
+
+/*
+ * Updates the replica of the master selection table from a response
+ * of the master. A binding older than the one known is ignored.
+ * The replica is filled only from selection responses, and emptied by
+ * releases. MLAG_LACP_SYNC_MSG does not carry the master table, so right
+ * after sync the replica is empty and requests go to the master.
+ *
+ * @param[in] msg - selection response data
+ *
+ * @return void
+ */
+static void
+lacp_replica_update(struct lacp_aggregation_message_data *msg)
+{
+    int err = 0;
+    int i;
+    struct mlag_lacp_data *replica = NULL;
+
+    if ((lacp_replica_active() == FALSE) || (msg->version == 0)) {
+        goto bail;
+    }
+
+    err = lacp_db_entry_get(msg->port_id, &replica);
+    if ((err == 0) && (replica->version > msg->version)) {
+        goto bail;
+    }
+    if (err == -ENOENT) {
+        err = lacp_db_entry_allocate(msg->port_id, &replica);
+        MLAG_BAIL_ERROR_MSG(err, "Failed to add port [%lu] to LACP replica\n",
+                            msg->port_id);
+        for (i = 0; i < MLAG_MAX_PEERS; i++) {
+            replica->peer_state[i] = FALSE;
+        }
+    }
+    replica->partner_id = msg->partner_id;
+    replica->partner_key = msg->partner_key;
+    replica->version = msg->version;
+
+bail:
+    return;
+}
+
+/*
+ * Checks if a selection response carries a binding older than the one
+ * in the replica, which happens when responses were reordered. Such a
+ * response is dropped and the pending request is sent to the master
+ * again, so it is answered from the current binding.
+ *
+ * @param[in] msg - selection response data
+ *
+ * @return TRUE if the response is stale, otherwise FALSE
+ */
+static int
+lacp_response_stale_check(struct lacp_aggregation_message_data *msg)
+{
+    int err = 0;
+    int stale = FALSE;
+    struct mlag_lacp_data *replica = NULL;
+    struct lacp_aggregation_message_data *db_req = NULL;
+
+    if ((lacp_replica_active() == FALSE) || (msg->version == 0)) {
+        goto bail;
+    }
+
+    err = lacp_db_entry_get(msg->port_id, &replica);
+    if (err || (replica->version <= msg->version)) {
+        goto bail;
+    }
+
+    err = lacp_db_pending_request_get(msg->port_id, &db_req);
+    if (err || (db_req == NULL) ||
+        (db_req->request_id != msg->request_id)) {
+        /* no pending request - ignored anyway */
+        goto bail;
+    }
+
+    stale = TRUE;
+    MLAG_LOG(MLAG_LOG_NOTICE,
+             "Port [%lu] req [%u] response version [%u] older than [%u], "
+             "requesting again\n",
+             msg->port_id, msg->request_id, msg->version, replica->version);
+
+    err = send_selection_message(db_req);
+    if (err) {
+        MLAG_LOG(MLAG_LOG_ERROR,
+                 "Failed to request port [%lu] selection again\n",
+                 msg->port_id);
+    }
+
+bail:
+    return stale;
+}
+
+/*
+ * Checks if a selection request can be answered locally, as the
+ * replica of the master selection table shows the master accepts it.
+ * The replica version is kept in the request, zero if not answered
+ * locally.
+ *
+ * @param[in,out] request - selection request data
+ *
+ * @return void
+ */
+static void
+selection_fast_path_check(struct lacp_aggregation_message_data *request)
+{
+    int err = 0;
+    struct mlag_lacp_data *replica = NULL;
+
+    request->version = 0;
+
+    if (lacp_replica_active() == FALSE) {
+        goto bail;
+    }
+
+    err = lacp_db_entry_get(request->port_id, &replica);
+    if (err) {
+        goto bail;
+    }
+    if ((replica->partner_id == request->partner_id) &&
+        (replica->partner_key == request->partner_key)) {
+        request->version = replica->version;
+    }
+
+bail:
+    return;
+}
+
+/*
+ * Accepts a selection request locally, before the master answers
+ *
+ * @param[in] request - selection request data
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+selection_fast_path_accept(struct lacp_aggregation_message_data *request)
+{
+    int err = 0;
+    struct lacp_aggregation_message_data response = *request;
+
+    response.is_response = TRUE;
+    response.response = LACP_AGGREGATE_ACCEPT;
+
+    err = notify_selection(&response);
+    MLAG_BAIL_ERROR(err);
+
+    fast_path_counters.accepted++;
+
+bail:
+    return err;
+}
+
+/*
+ * Makes a selection request the pending request of its port,
+ * an outstanding request of the port is rejected
+ *
+ * @param[in] request - selection request data
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+pend_selection_request(struct lacp_aggregation_message_data *request)
+{
+    int err = 0;
+    struct lacp_aggregation_message_data *previous_req = NULL;
+
+    /* If there is an outstanding request -> reject it */
+    err = lacp_db_pending_request_get(request->port_id, &previous_req);
+    if (err && (err != -ENOENT)) {
+        MLAG_BAIL_ERROR_MSG(err, "Failed in pending request lookup\n");
+    }
+    else if (err == 0) {
+        previous_req->partner_id = request->partner_id;
+        previous_req->partner_key = request->partner_key;
+        err = reject_pending_request(previous_req);
+        MLAG_BAIL_ERROR(err);
+    }
+
+    /* insert request to pending queue */
+    err = update_pending_selection_queue(request);
+    MLAG_BAIL_ERROR_MSG(err,
+                        "Failed to update pending selection req. queue\n");
+
+    /* check that the port is mlag port, if not avoid DB update*/
+    if (port_db_entry_exist(request->port_id) == FALSE) {
+        err = -ENOENT;
+        MLAG_BAIL_ERROR_MSG(err, "Can not find Port [%lu] in port DB\n",
+                            request->port_id);
+    }
+
+bail:
+    return err;
+}
+
+/*
+ * Rejects a selection request that failed before reaching the logic
+ *
+ * @param[in] request - selection request data
+ *
+ * @return void
+ */
+static void
+reject_failed_request(struct lacp_aggregation_message_data *request)
+{
+    int err = 0;
+
+    err = reject_pending_request(request);
+    if (err) {
+        MLAG_LOG(MLAG_LOG_ERROR,
+                 "Failed in pending req [%u] port [%lu] reject\n",
+                 request->request_id, request->port_id);
+    }
+}
+
 /**
  *  This function sets module log verbosity level
  *
@@ -892,9 +1173,20 @@ lacp_manager_init(insert_to_command_db_func insert_msgs_cb)
     err = insert_msgs_cb(lacp_manager_ibc_msgs);
     MLAG_BAIL_ERROR(err);
 
+    err = mlag_wire_msgs_register(lacp_manager_wire_msgs,
+                                  NUM_ELEMS(lacp_manager_wire_msgs));
+    MLAG_BAIL_ERROR(err);
+
     err = lacp_db_init();
     MLAG_BAIL_ERROR(err);
 
+    peer_down_ports = (unsigned long *)
+                      cl_malloc(mlag_max_ports_get() * sizeof(unsigned long));
+    if (peer_down_ports == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate peer down ports\n");
+    }
+
     started = FALSE;
     lacp_enabled = FALSE;
     current_role = NONE;
@@ -914,6 +1206,11 @@ lacp_manager_deinit(void)
 {
     int err = 0;
 
+    if (peer_down_ports != NULL) {
+        cl_free(peer_down_ports);
+        peer_down_ports = NULL;
+    }
+
     err = lacp_db_deinit();
     MLAG_BAIL_ERROR(err);
 
@@ -1016,6 +1313,8 @@ lacp_manager_peer_state_change(struct peer_state_change_data *state_change)
     if ((current_role == MASTER) && (state_change->state != HEALTH_PEER_UP)) {
         peer_down_data.mlag_id = state_change->mlag_id;
         peer_down_data.port_num = 0;
+        peer_down_data.port_max = mlag_max_ports_get();
+        peer_down_data.ports_to_delete = peer_down_ports;
         /* peer down, clear all active system IDs taken by this peer */
         err = lacp_db_port_foreach(clear_peer, &peer_down_data);
         MLAG_BAIL_ERROR_MSG(err, "Failed to clear peer usage on peer down\n");
@@ -1191,6 +1490,9 @@ bail:
  * When a delete command is used, only port_id parameter is relevant.
  * Force option is given in order to allow
  * releasing currently used key and migrating to the given partner.
+ * On a slave, a query matching the master binding known from earlier
+ * responses is accepted at once. The master then confirms it silently,
+ * or revokes it with a decline notification of the same request.
  *
  * @param[in] request_id - index given by caller that will appear in reply
  * @param[in] port_id - Interface index of port. Must represent MLAG port.
@@ -1208,8 +1510,6 @@ lacp_manager_aggregator_selection_request(unsigned int request_id,
                                           unsigned char force)
 {
     int err = 0;
-    int fail_err = 0;
-    struct lacp_aggregation_message_data *previous_req = NULL;
     struct lacp_aggregation_message_data selection_req;
     int reject_req_on_err = FALSE;
 
@@ -1228,28 +1528,14 @@ lacp_manager_aggregator_selection_request(unsigned int request_id,
     selection_req.force = force;
     reject_req_on_err = TRUE;
 
-    /* If there is an outstanding request -> reject it */
-    err = lacp_db_pending_request_get(port_id, &previous_req);
-    if (err && (err != -ENOENT)) {
-        MLAG_BAIL_ERROR_MSG(err, "Failed in pending request lookup\n");
-    }
-    else if (err == 0) {
-        previous_req->partner_id = partner_id;
-        previous_req->partner_key = partner_key;
-        err = reject_pending_request(previous_req);
-        MLAG_BAIL_ERROR(err);
-    }
+    selection_fast_path_check(&selection_req);
 
-    /* insert request to pending queue */
-    err = update_pending_selection_queue(&selection_req);
-    MLAG_BAIL_ERROR_MSG(err,
-                        "Failed to update pending selection req. queue\n");
+    err = pend_selection_request(&selection_req);
+    MLAG_BAIL_CHECK_NO_MSG(err);
 
-    /* check that the port is mlag port, if not avoid DB update*/
-    if (port_db_entry_exist(port_id) == FALSE) {
-        err = -ENOENT;
-        MLAG_BAIL_ERROR_MSG(err, "Can not find Port [%lu] in port DB\n",
-                            port_id);
+    if (selection_req.version != 0) {
+        err = selection_fast_path_accept(&selection_req);
+        MLAG_BAIL_CHECK_NO_MSG(err);
     }
 
     /* send selection request to master logic */
@@ -1260,12 +1546,7 @@ lacp_manager_aggregator_selection_request(unsigned int request_id,
 
 bail:
     if (err && (reject_req_on_err == TRUE)) {
-        fail_err = reject_pending_request(&selection_req);
-        if (fail_err) {
-            MLAG_LOG(MLAG_LOG_ERROR,
-                     "Failed in pending req [%u] port [%lu] reject\n",
-                     selection_req.request_id, selection_req.port_id);
-        }
+        reject_failed_request(&selection_req);
     }
     return err;
 }
@@ -1335,6 +1616,7 @@ lacp_manager_aggregator_selection_handle(
     int dest_peer, is_free;
     unsigned long long selected_partner_id;
     unsigned int selected_partner_key;
+    uint32_t selected_version;
     struct lacp_aggregator_release_message rel_msg;
 
     if (msg->select == FALSE) {
@@ -1373,14 +1655,26 @@ lacp_manager_aggregator_selection_handle(
         err = lacp_aggregator_select_logic(msg->mlag_id, msg->port_id,
                                            msg->partner_id, msg->partner_key,
                                            &response, &selected_partner_id,
-                                           &selected_partner_key);
+                                           &selected_partner_key,
+                                           &selected_version);
         MLAG_BAIL_ERROR_MSG(err, "Failed in lacp aggregator select logic\n");
 
+        /* The slave checks the returned version, and revokes a local
+         * answer made from another binding than the current one
+         */
+        if ((msg->version != 0) && (msg->version != selected_version)) {
+            MLAG_LOG(MLAG_LOG_NOTICE,
+                     "Port [%lu] answered from replica version [%u] "
+                     "current [%u]\n",
+                     msg->port_id, msg->version, selected_version);
+        }
+
         /* Send response to the selection request */
         msg->is_response = TRUE;
         msg->response = response;
         msg->partner_id = selected_partner_id;
         msg->partner_key = selected_partner_key;
+        msg->version = selected_version;
 
         if ((current_role == SLAVE) && (use_local_lacp_logic == TRUE)) {
             err = send_system_event(MLAG_LACP_SELECTION_EVENT,
@@ -1396,6 +1690,11 @@ lacp_manager_aggregator_selection_handle(
         }
     }
     else {
+        if (lacp_response_stale_check(msg) == TRUE) {
+            goto bail;
+        }
+        lacp_replica_update(msg);
+
         /* notify on response */
         err = notify_aggregator_selection_response(msg);
         MLAG_BAIL_ERROR(err);
@@ -1421,6 +1720,16 @@ lacp_manager_aggregator_free_handle(struct lacp_aggregator_release_message *msg)
         goto bail;
     }
 
+    if (lacp_replica_active() == TRUE) {
+        /* master binding is gone */
+        err = lacp_db_entry_delete(msg->port_id);
+        if (err && (err != -ENOENT)) {
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Failed to remove port [%lu] from LACP replica\n",
+                                msg->port_id);
+        }
+    }
+
     /* notify on response */
     err = notify_aggregator_release(msg);
     MLAG_BAIL_ERROR(err);
@@ -1429,6 +1738,185 @@ bail:
     return err;
 }
 
+/**
+ * Handles selection queries of several ports.
+ * Each query is kept pending as in lacp_manager_aggregator_selection_request,
+ * and all of them are sent to the master logic in one message.
+ *
+ * @param[in] selections - selection queries
+ * @param[in] selections_num - number of selection queries
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+lacp_manager_aggregator_selections_request(
+    const struct lacp_selection_info *selections,
+    unsigned int selections_num)
+{
+    int err = 0;
+    unsigned int i;
+    struct lacp_selections_message *msg = NULL;
+    struct lacp_selection_entry *entry;
+    struct lacp_aggregation_message_data selection_req;
+
+    if (lacp_enabled == FALSE) {
+        MLAG_LOG(MLAG_LOG_NOTICE,
+                 "Request for selections while LACP disabled\n");
+        goto bail;
+    }
+
+    msg = (struct lacp_selections_message *)
+          cl_malloc(LACP_SELECTIONS_MSG_SIZE(selections_num));
+    if (msg == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate selections message\n");
+    }
+    msg->entry_num = 0;
+
+    for (i = 0; i < selections_num; i++) {
+        /* prepare selection request */
+        selection_req.is_response = FALSE;
+        selection_req.response = LACP_AGGREGATE_DECLINE;
+        selection_req.request_id = selections[i].request_id;
+        selection_req.port_id = selections[i].port_id;
+        selection_req.partner_id = selections[i].partner_sys_id;
+        selection_req.partner_key = selections[i].partner_key;
+        selection_req.force = selections[i].force;
+
+        selection_fast_path_check(&selection_req);
+
+        err = pend_selection_request(&selection_req);
+        if (err == 0) {
+            if (selection_req.version != 0) {
+                err = selection_fast_path_accept(&selection_req);
+            }
+        }
+        if (err) {
+            /* Only this port is rejected, the others are still sent */
+            reject_failed_request(&selection_req);
+            continue;
+        }
+
+        entry = &msg->entries[msg->entry_num];
+        entry->response = selection_req.response;
+        entry->force = selection_req.force;
+        entry->request_id = selection_req.request_id;
+        entry->port_id = selection_req.port_id;
+        entry->partner_id = selection_req.partner_id;
+        entry->partner_key = selection_req.partner_key;
+        entry->version = selection_req.version;
+        msg->entry_num++;
+    }
+    err = 0;
+
+    if (msg->entry_num == 0) {
+        goto bail;
+    }
+
+    /* send all selection requests to master logic */
+    err = send_selections_message(msg);
+    if (err) {
+        msg->is_response = TRUE;
+        for (i = 0; i < msg->entry_num; i++) {
+            selection_entry_to_request(msg, &msg->entries[i], &selection_req);
+            reject_failed_request(&selection_req);
+        }
+    }
+    MLAG_BAIL_ERROR_MSG(err, "Failed to send selections of [%u] ports\n",
+                        msg->entry_num);
+
+bail:
+    if (msg != NULL) {
+        cl_free(msg);
+    }
+    return err;
+}
+
+/**
+ * Handles an incoming msg of aggregator selections of several ports.
+ * On the master logic all selections are decided and answered in one
+ * message, on the requester each response is notified.
+ *
+ * @param[in] msg - aggregator selections message
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+lacp_manager_aggregator_selections_handle(struct lacp_selections_message *msg)
+{
+    int err = 0;
+    int notify_err = 0;
+    uint32_t i;
+    enum aggregate_select_response response;
+    unsigned long long selected_partner_id;
+    unsigned int selected_partner_key;
+    uint32_t selected_version;
+    struct lacp_selection_entry *entry;
+    struct lacp_aggregation_message_data selection_resp;
+
+    if (msg->is_response == FALSE) {
+        MLAG_LOG(MLAG_LOG_INFO,
+                 "Aggregator select logic for [%u] ports of peer [%d]\n",
+                 msg->entry_num, msg->mlag_id);
+
+        for (i = 0; i < msg->entry_num; i++) {
+            entry = &msg->entries[i];
+            err = lacp_aggregator_select_logic(msg->mlag_id, entry->port_id,
+                                               entry->partner_id,
+                                               entry->partner_key,
+                                               &response,
+                                               &selected_partner_id,
+                                               &selected_partner_key,
+                                               &selected_version);
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Failed in lacp aggregator select logic\n");
+            entry->response = response;
+            entry->partner_id = selected_partner_id;
+            entry->partner_key = selected_partner_key;
+            entry->version = selected_version;
+        }
+
+        /* Send one response to all the selection requests */
+        msg->is_response = TRUE;
+
+        if ((current_role == SLAVE) && (use_local_lacp_logic == TRUE)) {
+            err = send_system_event(MLAG_LACP_SELECTIONS_EVENT, msg,
+                                    LACP_SELECTIONS_MSG_SIZE(msg->entry_num));
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Failed in sending MLAG_LACP_SELECTIONS_EVENT event\n");
+        }
+        else {
+            err = lacp_manager_message_send(MLAG_LACP_SELECTIONS_EVENT, msg,
+                                            LACP_SELECTIONS_MSG_SIZE(
+                                                msg->entry_num),
+                                            msg->mlag_id, MASTER_LOGIC);
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Failed in selections response sending\n");
+        }
+    }
+    else {
+        /* notify on each response, a failure does not stop the others */
+        for (i = 0; i < msg->entry_num; i++) {
+            selection_entry_to_request(msg, &msg->entries[i],
+                                       &selection_resp);
+            if (lacp_response_stale_check(&selection_resp) == TRUE) {
+                continue;
+            }
+            lacp_replica_update(&selection_resp);
+            notify_err = notify_aggregator_selection_response(&selection_resp);
+            if (notify_err) {
+                err = notify_err;
+                MLAG_LOG(MLAG_LOG_ERROR,
+                         "Failed to notify selection of port [%lu]\n",
+                         selection_resp.port_id);
+            }
+        }
+    }
+
+bail:
+    return err;
+}
+
 /*
  * Dumps specific port info
  *
@@ -1485,6 +1973,7 @@ void
 lacp_manager_counters_clear(void)
 {
     lacp_db_counters_clear();
+    SAFE_MEMSET(&fast_path_counters, 0);
 }
 
 /*
@@ -1506,8 +1995,8 @@ dump_pending_info(struct lacp_aggregation_message_data *request, void *data)
     DUMP_OR_LOG("Pending request ID [%u] port ID [%lu] [0x%lx] \n",
                 request->request_id, request->port_id, request->port_id);
     DUMP_OR_LOG("===========================\n");
-    DUMP_OR_LOG("partner ID [%llu] key [%u]\n", request->partner_id,
-                request->partner_key);
+    DUMP_OR_LOG("partner ID [%llu] key [%u]\n",
+                (unsigned long long)request->partner_id, request->partner_key);
     DUMP_OR_LOG("---------------------------\n");
 
 bail:
@@ -1542,6 +2031,11 @@ lacp_manager_dump(void (*dump_cb)(const char *, ...))
         DUMP_OR_LOG("Tx PDU : %llu \n", counters.tx_lacp_manager);
         DUMP_OR_LOG("Rx PDU : %llu \n", counters.rx_lacp_manager);
     }
+    DUMP_OR_LOG("Local selections : accepted [%llu] confirmed [%llu] "
+                "revoked [%llu]\n",
+                (unsigned long long)fast_path_counters.accepted,
+                (unsigned long long)fast_path_counters.confirmed,
+                (unsigned long long)fast_path_counters.revoked);
     DUMP_OR_LOG("---------------------------\n");
     err = lacp_db_local_system_id_get(&sys_id);
     DUMP_OR_LOG("Local System ID [%llu]\n", sys_id);
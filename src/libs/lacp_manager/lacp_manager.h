@@ -53,7 +53,15 @@
 struct lacp_peer_down_ports_data {
     int mlag_id;
     int port_num;
-    unsigned long ports_to_delete[MLAG_MAX_PORTS];
+    int port_max;
+    unsigned long *ports_to_delete; /* port_max entries */
+};
+
+/* Selections answered locally from the replica of the master table */
+struct lacp_fast_path_counters {
+    uint64_t accepted;
+    uint64_t confirmed; /* confirmed later by the master */
+    uint64_t revoked;   /* revoked later by the master */
 };
 
 
@@ -80,6 +88,10 @@ enum aggregate_select_response {
  *  Macros
  ***********************************************/
 
+/* Size of LACP selections message carrying the given number of ports */
+#define LACP_SELECTIONS_MSG_SIZE(num)                   \
+    (sizeof(struct lacp_selections_message) +           \
+     ((num) * sizeof(struct lacp_selection_entry)))
 
 /************************************************
  *  Type definitions
@@ -87,13 +99,32 @@ enum aggregate_select_response {
 struct __attribute__((__packed__)) peer_lacp_sync_message {
     uint16_t opcode;
     uint32_t phase;
-    unsigned long long sys_id;
-    int mlag_id;
+    uint64_t sys_id;
+    int32_t mlag_id;
 };
 
 struct __attribute__((__packed__)) lacp_aggregator_release_message {
     uint16_t opcode;
-    unsigned long port_id;
+    uint64_t port_id;
+};
+
+struct __attribute__((__packed__)) lacp_selection_entry {
+    uint16_t response;
+    uint16_t force;
+    uint32_t request_id;
+    uint64_t port_id;
+    uint64_t partner_id;
+    uint32_t partner_key;
+    uint32_t version;
+};
+
+/* Selection requests of several ports, or the responses to them */
+struct __attribute__((__packed__)) lacp_selections_message {
+    uint16_t opcode;
+    uint16_t is_response;
+    int32_t mlag_id;
+    uint32_t entry_num;
+    struct lacp_selection_entry entries[]; /* entry_num entries */
 };
 
 /************************************************
@@ -224,6 +255,9 @@ lacp_manager_actor_parameters_get(unsigned long long *actor_sys_id,
  * When a delete command is used, only port_id parameter is relevant.
  * Force option is given in order to allow
  * releasing currently used key and migrating to the given partner.
+ * On a slave, a query matching the master binding known from earlier
+ * responses is accepted at once. The master then confirms it silently,
+ * or revokes it with a decline notification of the same request.
  *
  * @param[in] request_id - index given by caller that will appear in reply
  * @param[in] port_id - Interface index of port. Must represent MLAG port.
@@ -253,6 +287,33 @@ int
 lacp_manager_aggregator_selection_release(unsigned int request_id,
                                           unsigned long port_id);
 
+/**
+ * Handles selection queries of several ports.
+ * Each query is kept pending as in lacp_manager_aggregator_selection_request,
+ * and all of them are sent to the master logic in one message.
+ *
+ * @param[in] selections - selection queries
+ * @param[in] selections_num - number of selection queries
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+lacp_manager_aggregator_selections_request(
+    const struct lacp_selection_info *selections,
+    unsigned int selections_num);
+
+/**
+ * Handles an incoming msg of aggregator selections of several ports.
+ * On the master logic all selections are decided and answered in one
+ * message, on the requester each response is notified.
+ *
+ * @param[in] msg - aggregator selections message
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+lacp_manager_aggregator_selections_handle(struct lacp_selections_message *msg);
+
 
 /**
  * Handles an incoming msg of aggregator selection
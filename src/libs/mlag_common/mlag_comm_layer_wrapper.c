@@ -26,7 +26,9 @@
  */
 
 #include <errno.h>
+#include <time.h>
 #include <complib/cl_timer.h>
+#include <complib/cl_mem.h>
 #include "mlag_log.h"
 #include "mlag_bail.h"
 #include "mlag_defs.h"
@@ -36,6 +38,10 @@
 #include "mlag_master_election.h"
 #include "mlag_manager_db.h"
 #include "mlag_comm_layer_wrapper.h"
+#include "mlag_wire.h"
+#include "mlag_comm_mux.h"
+#include "mlag_compress.h"
+#include <libs/mlag_common/mlag_lock_prof.h>
 
 #undef  __MODULE__
 #define __MODULE__ MLAG_COMM_LAYER_WRAPPER
@@ -53,6 +59,11 @@
                                       } }
 #define DEFAULT_RECONNECT_MSEC 500
 
+/* Channel riding on the connection of the primary mux channel */
+#define MUX_SECONDARY(comm_layer_data)                              \
+    (((comm_layer_data)->mux_channel != MLAG_MUX_CHANNEL_NONE) &&   \
+     ((comm_layer_data)->mux_channel != MLAG_MUX_CHANNEL_PRIMARY))
+
 #define SOCKET_LOCK(comm_layer_data)                                  \
     if (comm_layer_data->protect_socket == SOCKET_PROTECTION) {       \
     	 err = pthread_mutex_lock(&(comm_layer_data->socket_mutex));  \
@@ -82,8 +93,13 @@
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
 static char *wrapper_counters_str[WRAPPER_LAST_COUNTER] = {
     "MSG_TX_CNT",
-    "MSG_RX_CNT"
+    "MSG_RX_CNT",
+    "MSG_RX_WIRE_ERR_CNT"
 };
+/* Messages are encoded and decoded in buffers of the calling thread,
+ * kept for the thread lifetime */
+static __thread struct mlag_wire_buf wire_tx_buf;
+static __thread struct mlag_wire_buf wire_rx_buf;
 
 /************************************************
  *  Local function declarations
@@ -100,6 +116,21 @@ static int tcp_server_handle_notification(
     handle_t new_handle, struct addr_info peer_addr_st, void *data, int rc);
 static void mlag_comm_layer_wrapper_reconnect_timer_cb(
     void* data);
+static int conn_handle_close(
+    struct mlag_comm_layer_wrapper_data *comm_layer_data, int peer_id,
+    handle_t handle);
+static int mux_channel_receive(
+    struct mlag_comm_layer_wrapper_data *comm_layer_data, int fd);
+static int wire_body_decompress(
+    struct mlag_comm_layer_wrapper_data *comm_layer_data,
+    const uint8_t *body, uint32_t length, uint8_t **plain,
+    uint32_t *plain_len);
+static int wire_stamp_strip(
+    uint8_t flags, const uint8_t *body, uint32_t *length,
+    uint64_t *transit_usec);
+static int wire_body_decode(
+    struct mlag_comm_layer_wrapper_data *comm_layer_data, uint8_t **body,
+    uint32_t *length);
 
 /************************************************
  *  Function implementations
@@ -162,6 +193,8 @@ mlag_comm_layer_wrapper_init(
     comm_layer_data->tcp_server_id = INVALID_TCP_SERVER_ID;
     for (i = 0; i < MLAG_MAX_PEERS; i++) {
         comm_layer_data->tcp_sock_handle[i] = 0;
+        comm_layer_data->peer_compress[i] = 0;
+        comm_layer_data->peer_stamp[i] = 0;
     }
     mlag_comm_layer_wrapper_counters_clear(comm_layer_data);
     comm_layer_data->reconnect_timer_msec = DEFAULT_RECONNECT_MSEC;
@@ -174,6 +207,14 @@ mlag_comm_layer_wrapper_init(
         }
     }
 
+    comm_layer_data->mux_channel = mlag_comm_mux_channel_get(tcp_port);
+    if (comm_layer_data->mux_channel != MLAG_MUX_CHANNEL_NONE) {
+        err = mlag_comm_mux_register(comm_layer_data->mux_channel,
+                                     comm_layer_data, tcp_port);
+        MLAG_BAIL_ERROR_MSG(err, "Failed to register mux channel, port %d\n",
+                            tcp_port);
+    }
+
 bail:
     return err;
 }
@@ -193,6 +234,10 @@ mlag_comm_layer_wrapper_deinit(
 {
     int err = 0;
 
+    if (comm_layer_data->mux_channel != MLAG_MUX_CHANNEL_NONE) {
+        mlag_comm_mux_unregister(comm_layer_data->mux_channel);
+    }
+
     if (comm_layer_data->protect_socket == SOCKET_PROTECTION) {
         /*cl_plock_destroy(&(comm_layer_data->socket_mutex));*/
         err = pthread_mutex_destroy(&(comm_layer_data->socket_mutex));
@@ -229,7 +274,13 @@ mlag_comm_layer_wrapper_start(
     clbk_st.clbk_notify_func = tcp_server_handle_notification;
     clbk_st.data = (void*)comm_layer_data;
 
-    if (comm_layer_data->current_switch_status == MASTER) {
+    if (MUX_SECONDARY(comm_layer_data)) {
+        /* Connection is owned by the primary mux channel */
+        MLAG_LOG(MLAG_LOG_NOTICE,
+                 "Mux channel start for tcp port %d\n",
+                 comm_layer_data->tcp_port);
+    }
+    else if (comm_layer_data->current_switch_status == MASTER) {
         /* Open TCP server for L3 interface management messages */
         params.s_ipv4_addr = INADDR_ANY;
         params.port = htons(comm_layer_data->tcp_port);
@@ -287,6 +338,12 @@ mlag_comm_layer_wrapper_start(
     comm_layer_data->reconnect_timer_started = 0;
     comm_layer_data->is_started = 1;
 
+    if (MUX_SECONDARY(comm_layer_data)) {
+        err = mlag_comm_mux_channel_start(comm_layer_data->mux_channel);
+        MLAG_BAIL_ERROR_MSG(err, "Failed to start mux channel, port %d\n",
+                            comm_layer_data->tcp_port);
+    }
+
 bail:
     return err;
 }
@@ -314,8 +371,8 @@ tcp_conn_stop(struct mlag_comm_layer_wrapper_data *comm_layer_data,
         SOCKET_LOCK(comm_layer_data);
         is_locked = 1;
 
-        err = comm_lib_tcp_peer_stop(
-            comm_layer_data->tcp_sock_handle[peer_id]);
+        err = conn_handle_close(comm_layer_data, peer_id,
+                                comm_layer_data->tcp_sock_handle[peer_id]);
         MLAG_BAIL_ERROR_MSG(err, "Failed to stop TCP client session\n");
 
         /* Delete fd from message dispatcher */
@@ -361,9 +418,14 @@ mlag_comm_layer_wrapper_stop(
 
     if (comm_layer_data->current_switch_status == MASTER) {
         if ((cause == SERVER_STOP) &&
-            (comm_layer_data->tcp_server_id != INVALID_TCP_SERVER_ID)) {
+            ((comm_layer_data->tcp_server_id != INVALID_TCP_SERVER_ID) ||
+             MUX_SECONDARY(comm_layer_data))) {
             for (i = 0; i < MLAG_MAX_PEERS; i++) {
                 if (comm_layer_data->tcp_sock_handle[i]) {
+                    if (comm_layer_data->mux_channel ==
+                        MLAG_MUX_CHANNEL_PRIMARY) {
+                        mlag_comm_mux_link_down(i);
+                    }
                     /* Delete fd from message dispatcher */
                     if (comm_layer_data->add_fd_handler) {
                         comm_layer_data->add_fd_handler(
@@ -372,17 +434,24 @@ mlag_comm_layer_wrapper_stop(
                     comm_layer_data->tcp_sock_handle[i] = 0;
                 }
             }
-            SOCKET_LOCK(comm_layer_data);
-            err = comm_lib_tcp_server_session_stop(
-                comm_layer_data->tcp_server_id,
-                handle_array,
-                MAX_CONNECTION_NUM);
-            SOCKET_UNLOCK(comm_layer_data);
-            MLAG_BAIL_ERROR_MSG(err,
-                                "Failed TCP server stop for server id %d, err=%d\n",
-                                comm_layer_data->tcp_server_id, err);
+            if (MUX_SECONDARY(comm_layer_data)) {
+                err = mlag_comm_mux_channel_stop(comm_layer_data->mux_channel,
+                                                 MLAG_MAX_PEERS);
+                MLAG_BAIL_ERROR(err);
+            }
+            else {
+                SOCKET_LOCK(comm_layer_data);
+                err = comm_lib_tcp_server_session_stop(
+                    comm_layer_data->tcp_server_id,
+                    handle_array,
+                    MAX_CONNECTION_NUM);
+                SOCKET_UNLOCK(comm_layer_data);
+                MLAG_BAIL_ERROR_MSG(err,
+                                    "Failed TCP server stop for server id %d, err=%d\n",
+                                    comm_layer_data->tcp_server_id, err);
 
-            comm_layer_data->tcp_server_id = INVALID_TCP_SERVER_ID;
+                comm_layer_data->tcp_server_id = INVALID_TCP_SERVER_ID;
+            }
             comm_layer_data->is_started = 0;
         }
         else if (cause == PEER_STOP) {
@@ -407,6 +476,12 @@ mlag_comm_layer_wrapper_stop(
             cl_timer_destroy(&comm_layer_data->reconnect_timer);
         }
         comm_layer_data->is_started = 0;
+
+        if (MUX_SECONDARY(comm_layer_data)) {
+            err = mlag_comm_mux_channel_stop(comm_layer_data->mux_channel,
+                                             MLAG_MAX_PEERS);
+            MLAG_BAIL_ERROR(err);
+        }
     }
 
 bail:
@@ -470,9 +545,25 @@ mlag_comm_layer_wrapper_message_dispatcher(int fd,
     struct recv_payload_data payload_data;
     int peer_id;
     int is_locked = 0;
+    uint8_t flags = 0;
+    uint8_t version = 0;
+    uint8_t *msg_data = NULL;
+    uint32_t msg_len = 0;
+    uint8_t *plain = NULL;
+    int channel;
+    int i;
+    int stamped = 0;
+    uint64_t transit_usec = 0;
+    uint64_t start_usec = 0;
+    uint16_t opcode = 0;
+
+    if (MUX_SECONDARY(comm_layer_data)) {
+        mux_channel_receive(comm_layer_data, fd);
+        return 0;
+    }
 
-    MLAG_LOG(MLAG_LOG_INFO,
-             "Received message from communication library\n");
+    MLAG_TRACE(MLAG_TRACE_INFO,
+               "Received message from communication library, handle %lld", fd);
 
     memset(&payload_data, 0, sizeof(payload_data));
     memset(&ad_info, 0, sizeof(ad_info));
@@ -500,7 +591,7 @@ mlag_comm_layer_wrapper_message_dispatcher(int fd,
             SOCKET_LOCK(comm_layer_data);
             is_locked = 1;
 
-            err = comm_lib_tcp_peer_stop(fd);
+            err = conn_handle_close(comm_layer_data, peer_id, fd);
             MLAG_BAIL_ERROR_MSG(err, "Failed to stop TCP session\n");
 
             comm_layer_data->tcp_sock_handle[peer_id] = 0;
@@ -534,33 +625,274 @@ mlag_comm_layer_wrapper_message_dispatcher(int fd,
         goto bail;
     }
 
+    /* Strip wire header, receivers see the message body only */
     if (payload_data.payload_len[0] > 0) {
-        if (comm_layer_data->net_order_msg_handler) {
-            comm_layer_data->net_order_msg_handler(
-                (void*)payload_data.payload[0], MESSAGE_RECEIVE);
+        err = mlag_wire_header_check(payload_data.payload[0],
+                                     payload_data.payload_len[0],
+                                     &payload_data.payload_len[0], &flags,
+                                     &version);
+        if (err) {
+            WRAPPER_INC_CNT(comm_layer_data, RX_WIRE_ERR_CNT);
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Dropped message with bad wire header: handle %d\n",
+                                fd);
         }
+        payload_data.payload[0] += MLAG_WIRE_HEADER_SIZE;
+        msg_data = payload_data.payload[0];
+        msg_len = payload_data.payload_len[0];
     }
 
     if (payload_data.jumbo_payload_len > 0) {
-        if (comm_layer_data->net_order_msg_handler) {
-            comm_layer_data->net_order_msg_handler(
-                (void*)payload_data.jumbo_payload, MESSAGE_RECEIVE);
+        err = mlag_wire_header_check(payload_data.jumbo_payload,
+                                     payload_data.jumbo_payload_len,
+                                     &payload_data.jumbo_payload_len, &flags,
+                                     &version);
+        if (err) {
+            WRAPPER_INC_CNT(comm_layer_data, RX_WIRE_ERR_CNT);
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Dropped jumbo message with bad wire header: handle %d\n",
+                                fd);
+        }
+        payload_data.jumbo_payload += MLAG_WIRE_HEADER_SIZE;
+        msg_data = payload_data.jumbo_payload;
+        msg_len = payload_data.jumbo_payload_len;
+    }
+
+    /* Peer advertises compression and stamping on every message */
+    for (i = 0; i < MLAG_MAX_PEERS; i++) {
+        if (comm_layer_data->tcp_sock_handle[i] == fd) {
+            comm_layer_data->peer_compress[i] =
+                ((flags & MLAG_WIRE_FLAG_COMPRESS_CAP) != 0);
+            comm_layer_data->peer_stamp[i] =
+                (MLAG_WIRE_VERSION_MINOR_GET(version) >=
+                 MLAG_WIRE_MINOR_STAMP);
+        }
+    }
+
+    if ((flags & MLAG_WIRE_FLAG_COMPRESSED) && (msg_data != NULL)) {
+        err = wire_body_decompress(comm_layer_data, msg_data, msg_len,
+                                   &plain, &msg_len);
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Dropped message with bad compressed body: handle %d\n",
+                            fd);
+        msg_data = plain;
+        if (payload_data.payload_len[0] > 0) {
+            payload_data.payload[0] = plain;
+            payload_data.payload_len[0] = msg_len;
+        }
+        else {
+            payload_data.jumbo_payload = plain;
+            payload_data.jumbo_payload_len = msg_len;
+        }
+        flags &= ~MLAG_WIRE_FLAG_COMPRESSED;
+    }
+
+    /* Hand messages of other mux channels to their dispatchers */
+    if (comm_layer_data->mux_channel == MLAG_MUX_CHANNEL_PRIMARY) {
+        channel = flags & MLAG_WIRE_FLAG_CHANNEL_MASK;
+        mlag_comm_mux_rx_count(channel, msg_len);
+        if ((channel != MLAG_MUX_CHANNEL_PRIMARY) && (msg_data != NULL)) {
+            err = mlag_manager_db_mlag_peer_id_get(ntohl(ad_info.ipv4_addr),
+                                                   &peer_id);
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Failed to get peer id by peer ip address 0x%08x from mlag manager database\n",
+                                ntohl(ad_info.ipv4_addr));
+            err = mlag_comm_mux_deliver(channel, peer_id, ad_info.ipv4_addr,
+                                        flags, version, msg_data, msg_len);
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Failed to hand message to mux channel %d\n",
+                                channel);
+            goto bail;
+        }
+    }
+
+    if (msg_data) {
+        stamped = wire_stamp_strip(flags, msg_data, &msg_len, &transit_usec);
+        err = wire_body_decode(comm_layer_data, &msg_data, &msg_len);
+        if (err) {
+            WRAPPER_INC_CNT(comm_layer_data, RX_WIRE_ERR_CNT);
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Dropped message with bad body: handle %d\n",
+                                fd);
+        }
+        if (payload_data.payload_len[0] > 0) {
+            payload_data.payload[0] = msg_data;
+            payload_data.payload_len[0] = msg_len;
+        }
+        else {
+            payload_data.jumbo_payload = msg_data;
+            payload_data.jumbo_payload_len = msg_len;
         }
     }
 
     WRAPPER_INC_CNT(comm_layer_data, RX_CNT);
 
+    if (MLAG_EVENT_LATENCY && stamped) {
+        opcode = *((uint16_t *)msg_data);
+        start_usec = mlag_latency_mono_usec();
+    }
     if (comm_layer_data->rcv_msg_handler) {
         comm_layer_data->rcv_msg_handler(&ad_info, &payload_data);
     }
+    if (MLAG_EVENT_LATENCY && stamped) {
+        mlag_latency_record(MLAG_EVENT_LATENCY_IPL_MSG, opcode, transit_usec,
+                            mlag_latency_mono_usec() - start_usec);
+    }
 
 bail:
     if (is_locked) {
     	SOCKET_UNLOCK(comm_layer_data);
     }
+    if (plain) {
+        cl_free(plain);
+    }
     return 0;
 }
 
+/*
+ *  This function closes connection handle. Primary mux channel
+ *  notifies the mux before the socket is closed, other mux channels
+ *  keep their receive fd which belongs to the mux.
+ *
+ * @param[in] comm_layer_data - module specific data
+ * @param[in] peer_id - peer id, -1 if handle was not attached to a peer
+ * @param[in] handle - connection handle
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+conn_handle_close(struct mlag_comm_layer_wrapper_data *comm_layer_data,
+                  int peer_id, handle_t handle)
+{
+    int err = 0;
+
+    if (MUX_SECONDARY(comm_layer_data)) {
+        if (peer_id >= 0) {
+            err = mlag_comm_mux_channel_stop(comm_layer_data->mux_channel,
+                                             peer_id);
+            MLAG_BAIL_ERROR(err);
+        }
+        goto bail;
+    }
+
+    if ((comm_layer_data->mux_channel == MLAG_MUX_CHANNEL_PRIMARY) &&
+        (peer_id >= 0)) {
+        err = mlag_comm_mux_link_down(peer_id);
+        MLAG_BAIL_ERROR(err);
+    }
+
+    err = comm_lib_tcp_peer_stop(handle);
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
+/*
+ *  This function handles message handed by the primary mux channel,
+ *  called from context of the channel dispatcher instead of
+ *  TCP receive
+ *
+ * @param[in] comm_layer_data - module specific data
+ * @param[in] fd - channel receive fd
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+mux_channel_receive(struct mlag_comm_layer_wrapper_data *comm_layer_data,
+                    int fd)
+{
+    int err = 0;
+    int i;
+    int is_locked = 0;
+    struct mlag_mux_rx_msg *msg = NULL;
+    struct addr_info ad_info;
+    struct recv_payload_data payload_data;
+    uint8_t *msg_data;
+    uint32_t msg_len;
+    int stamped;
+    uint64_t transit_usec = 0;
+    uint64_t start_usec = 0;
+    uint16_t opcode = 0;
+
+    err = mlag_comm_mux_receive(comm_layer_data->mux_channel, fd, &msg);
+    MLAG_BAIL_ERROR(err);
+    if (msg == NULL) {
+        goto bail;
+    }
+
+    if (msg->length == 0) {
+        /* Primary connection lost, the primary channel reconnects */
+        MLAG_LOG(MLAG_LOG_NOTICE,
+                 "Mux connection lost: tcp port %d, peer id %d\n",
+                 comm_layer_data->tcp_port, msg->peer_id);
+
+        SOCKET_LOCK(comm_layer_data);
+        is_locked = 1;
+        comm_layer_data->tcp_sock_handle[msg->peer_id] = 0;
+        for (i = 0; i < MLAG_MAX_PEERS; i++) {
+            if (comm_layer_data->tcp_sock_handle[i] == fd) {
+                break;
+            }
+        }
+        /* Delete fd from message dispatcher when no peer uses it */
+        if ((i == MLAG_MAX_PEERS) && comm_layer_data->add_fd_handler) {
+            comm_layer_data->add_fd_handler(fd, COMM_FD_DEL);
+        }
+        SOCKET_UNLOCK(comm_layer_data);
+        is_locked = 0;
+        goto bail;
+    }
+
+    comm_layer_data->peer_compress[msg->peer_id] =
+        ((msg->flags & MLAG_WIRE_FLAG_COMPRESS_CAP) != 0);
+    comm_layer_data->peer_stamp[msg->peer_id] =
+        (MLAG_WIRE_VERSION_MINOR_GET(msg->version) >= MLAG_WIRE_MINOR_STAMP);
+    stamped = wire_stamp_strip(msg->flags, msg->data, &msg->length,
+                               &transit_usec);
+
+    msg_data = msg->data;
+    msg_len = msg->length;
+    err = wire_body_decode(comm_layer_data, &msg_data, &msg_len);
+    if (err) {
+        WRAPPER_INC_CNT(comm_layer_data, RX_WIRE_ERR_CNT);
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Dropped mux message with bad body: peer id %d\n",
+                            msg->peer_id);
+    }
+
+    memset(&payload_data, 0, sizeof(payload_data));
+    memset(&ad_info, 0, sizeof(ad_info));
+    ad_info.ipv4_addr = msg->ipv4_addr;
+    ad_info.port = htons(comm_layer_data->tcp_port);
+    payload_data.payload[0] = msg_data;
+    payload_data.payload_len[0] = msg_len;
+    payload_data.msg_num_recv = 1;
+
+    WRAPPER_INC_CNT(comm_layer_data, RX_CNT);
+
+    if (MLAG_EVENT_LATENCY && stamped) {
+        opcode = *((uint16_t *)msg_data);
+        start_usec = mlag_latency_mono_usec();
+    }
+    if (comm_layer_data->rcv_msg_handler) {
+        comm_layer_data->rcv_msg_handler(&ad_info, &payload_data);
+    }
+    if (MLAG_EVENT_LATENCY && stamped) {
+        mlag_latency_record(MLAG_EVENT_LATENCY_IPL_MSG, opcode, transit_usec,
+                            mlag_latency_mono_usec() - start_usec);
+    }
+
+bail:
+    if (is_locked) {
+        SOCKET_UNLOCK(comm_layer_data);
+    }
+    if (msg) {
+        cl_free(msg);
+    }
+    return err;
+}
+
 /*
  *  This function is tcp server socket handle notification called
  *  upon connection established with client from context of comm library
@@ -635,7 +967,7 @@ mlag_comm_layer_wrapper_connection_notification(
                  comm_layer_data->tcp_port,
                  comm_layer_data->dest_ip_addr);
         SOCKET_LOCK(comm_layer_data);
-        err = comm_lib_tcp_peer_stop(new_handle);
+        err = conn_handle_close(comm_layer_data, -1, new_handle);
         SOCKET_UNLOCK(comm_layer_data);
         MLAG_BAIL_ERROR(err);
         goto bail;
@@ -679,7 +1011,7 @@ mlag_comm_layer_wrapper_connection_notification(
                      new_handle);
 
             SOCKET_LOCK(comm_layer_data);
-            err = comm_lib_tcp_peer_stop(new_handle);
+            err = conn_handle_close(comm_layer_data, -1, new_handle);
             SOCKET_UNLOCK(comm_layer_data);
             MLAG_BAIL_ERROR(err);
 
@@ -701,6 +1033,8 @@ mlag_comm_layer_wrapper_connection_notification(
                  ntohl(ipv4_addr), ntohs(port), peer_id, new_handle);
 
         comm_layer_data->tcp_sock_handle[peer_id] = new_handle;
+        comm_layer_data->peer_compress[peer_id] = 0;
+        comm_layer_data->peer_stamp[peer_id] = 0;
 
         /* Save ip adrress of accepted client to comm_layer_data wrapper */
         comm_layer_data->dest_ip_addr = ntohl(ipv4_addr);
@@ -709,9 +1043,340 @@ mlag_comm_layer_wrapper_connection_notification(
         if (comm_layer_data->add_fd_handler) {
             comm_layer_data->add_fd_handler(new_handle, COMM_FD_ADD);
         }
+
+        /* Other mux channels ride on this connection */
+        if (comm_layer_data->mux_channel == MLAG_MUX_CHANNEL_PRIMARY) {
+            err = mlag_comm_mux_link_up(peer_id, new_handle, ipv4_addr);
+            MLAG_BAIL_ERROR(err);
+        }
+    }
+
+bail:
+    return err;
+}
+
+/*
+ *  This function returns header flags of messages sent by wrapper
+ *
+ * @param[in] comm_layer_data - module specific data
+ *
+ * @return wire header flags
+ */
+static uint8_t
+wire_flags(struct mlag_comm_layer_wrapper_data *comm_layer_data)
+{
+    uint8_t flags = mlag_comm_mux_wire_flags(comm_layer_data->mux_channel);
+
+    if (MLAG_IPL_COMPRESS) {
+        flags |= MLAG_WIRE_FLAG_COMPRESS_CAP;
+    }
+    return flags;
+}
+
+/*
+ *  This function allocates wire message, from the mux when
+ *  wrapper is multiplexed
+ *
+ * @param[in] comm_layer_data - module specific data
+ * @param[in] length - wire message length including header
+ * @param[out] mux_msg - mux message holding wire message, or NULL
+ *
+ * @return wire message, NULL if out of memory
+ */
+static uint8_t *
+wire_msg_alloc(struct mlag_comm_layer_wrapper_data *comm_layer_data,
+               uint32_t length, struct mlag_mux_tx_msg **mux_msg)
+{
+    *mux_msg = NULL;
+    if (comm_layer_data->mux_channel != MLAG_MUX_CHANNEL_NONE) {
+        *mux_msg = mlag_comm_mux_msg_alloc(length);
+        return (*mux_msg != NULL) ? (*mux_msg)->data : NULL;
+    }
+    return (uint8_t *)cl_malloc(length);
+}
+
+/*
+ *  This function frees wire message allocated by wire_msg_alloc,
+ *  the send buffer of the thread is kept
+ *
+ * @param[in] wire_msg - wire message
+ * @param[in] mux_msg - mux message holding wire message, or NULL
+ *
+ * @return void
+ */
+static void
+wire_msg_free(uint8_t *wire_msg, struct mlag_mux_tx_msg *mux_msg)
+{
+    if (mux_msg) {
+        cl_free(mux_msg);
+    }
+    else if (wire_msg && (wire_msg != wire_tx_buf.data)) {
+        cl_free(wire_msg);
+    }
+}
+
+/*
+ *  This function encodes message body by its registered schema. A
+ *  message without schema is copied and converted by the network
+ *  order handler of the module.
+ *
+ * @param[in] comm_layer_data - module specific data
+ * @param[in] payload - message in host order
+ * @param[in] payload_len - message length
+ * @param[out] body - encoded body, at least payload_len bytes
+ * @param[out] body_len - encoded body length
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+wire_body_encode(struct mlag_comm_layer_wrapper_data *comm_layer_data,
+                 const uint8_t *payload, uint32_t payload_len, uint8_t *body,
+                 uint32_t *body_len)
+{
+    int err = 0;
+
+    err = mlag_wire_msg_encode(payload, payload_len, body, body_len);
+    if (err == -ENOENT) {
+        err = 0;
+        memcpy(body, payload, payload_len);
+        *body_len = payload_len;
+        if (comm_layer_data->net_order_msg_handler) {
+            comm_layer_data->net_order_msg_handler(body, MESSAGE_SENDING);
+        }
+    }
+    return err;
+}
+
+/*
+ *  This function decodes received message body into the receive
+ *  buffer of the thread. A message without schema is converted in
+ *  place by the network order handler of the module.
+ *
+ * @param[in] comm_layer_data - module specific data
+ * @param[in,out] body - received body, decoded message on return
+ * @param[in,out] length - body length, decoded message length on return
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+wire_body_decode(struct mlag_comm_layer_wrapper_data *comm_layer_data,
+                 uint8_t **body, uint32_t *length)
+{
+    int err = 0;
+    uint32_t msg_len = 0;
+
+    err = mlag_wire_msg_decode(*body, *length, &wire_rx_buf, &msg_len);
+    if (err == -ENOENT) {
+        err = 0;
+        if (comm_layer_data->net_order_msg_handler) {
+            comm_layer_data->net_order_msg_handler(*body, MESSAGE_RECEIVE);
+        }
+        goto bail;
+    }
+    MLAG_BAIL_ERROR(err);
+
+    *body = wire_rx_buf.data;
+    *length = msg_len;
+
+bail:
+    return err;
+}
+
+/*
+ *  This function returns CPU time consumed by calling thread
+ *
+ * @return time in microseconds
+ */
+static uint64_t
+thread_cpu_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+/*
+ *  This function writes the send stamp trailer of a message body
+ *
+ * @param[out] trailer - MLAG_WIRE_STAMP_SIZE bytes following the body
+ *
+ * @return void
+ */
+static void
+wire_stamp_set(uint8_t *trailer)
+{
+    uint64_t usec = mlag_latency_wall_usec();
+    int i;
+
+    for (i = MLAG_WIRE_STAMP_SIZE - 1; i >= 0; i--) {
+        trailer[i] = (uint8_t)usec;
+        usec >>= 8;
+    }
+}
+
+/*
+ *  This function strips the send stamp trailer of a message body.
+ *  Peer clocks are not synchronized, so transit time includes
+ *  their offset.
+ *
+ * @param[in] flags - wire header flags
+ * @param[in] body - message body
+ * @param[in,out] length - message body length
+ * @param[out] transit_usec - time since the message was sent
+ *
+ * @return 1 if the body was stamped, otherwise 0
+ */
+static int
+wire_stamp_strip(uint8_t flags, const uint8_t *body, uint32_t *length,
+                 uint64_t *transit_usec)
+{
+    uint64_t sent_usec = 0;
+    uint64_t now_usec;
+    uint32_t i;
+
+    if (!(flags & MLAG_WIRE_FLAG_STAMPED) ||
+        (*length < MLAG_WIRE_STAMP_SIZE)) {
+        return 0;
+    }
+    *length -= MLAG_WIRE_STAMP_SIZE;
+    for (i = 0; i < MLAG_WIRE_STAMP_SIZE; i++) {
+        sent_usec = (sent_usec << 8) | body[*length + i];
+    }
+    now_usec = mlag_latency_wall_usec();
+    *transit_usec = (now_usec > sent_usec) ? (now_usec - sent_usec) : 0;
+    return 1;
+}
+
+/*
+ *  This function replaces wire message body by its compressed form.
+ *  Compressed body is the original body length in network order
+ *  followed by a single LZ4 block. Message is left as is when it
+ *  does not compress.
+ *
+ * @param[in] comm_layer_data - module specific data
+ * @param[in,out] wire_msg - wire message
+ * @param[in,out] mux_msg - mux message holding wire message, or NULL
+ * @param[in,out] wire_len - wire message length including header
+ *
+ * @return void
+ */
+static void
+wire_msg_compress(struct mlag_comm_layer_wrapper_data *comm_layer_data,
+                  uint8_t **wire_msg, struct mlag_mux_tx_msg **mux_msg,
+                  uint32_t *wire_len)
+{
+    int err = 0;
+    uint32_t body_len = *wire_len - MLAG_WIRE_HEADER_SIZE;
+    uint32_t comp_len = 0;
+    uint32_t orig_len = htonl(body_len);
+    uint32_t comp_size = sizeof(orig_len) + MLAG_COMPRESS_BOUND(body_len);
+    struct mlag_mux_tx_msg *comp_mux_msg = NULL;
+    uint8_t *comp_msg;
+    uint8_t flags;
+    uint64_t start;
+
+    comp_msg = wire_msg_alloc(comm_layer_data,
+                              MLAG_WIRE_HEADER_SIZE + comp_size,
+                              &comp_mux_msg);
+    if (comp_msg == NULL) {
+        return;
+    }
+
+    start = thread_cpu_usec();
+    err = mlag_compress(*wire_msg + MLAG_WIRE_HEADER_SIZE, body_len,
+                        comp_msg + MLAG_WIRE_HEADER_SIZE + sizeof(orig_len),
+                        comp_size - sizeof(orig_len), &comp_len);
+    __sync_fetch_and_add(&comm_layer_data->compress_counters.tx_usec,
+                         thread_cpu_usec() - start);
+    comp_len += sizeof(orig_len);
+
+    if (err || (comp_len >= body_len)) {
+        wire_msg_free(comp_msg, comp_mux_msg);
+        return;
+    }
+
+    flags = ((struct mlag_wire_header *)*wire_msg)->flags;
+    mlag_wire_header_set((struct mlag_wire_header *)comp_msg, comp_len,
+                         flags | MLAG_WIRE_FLAG_COMPRESSED);
+    memcpy(comp_msg + MLAG_WIRE_HEADER_SIZE, &orig_len, sizeof(orig_len));
+    if (comp_mux_msg) {
+        comp_mux_msg->length = MLAG_WIRE_HEADER_SIZE + comp_len;
     }
 
+    __sync_fetch_and_add(&comm_layer_data->compress_counters.tx_msgs, 1);
+    __sync_fetch_and_add(&comm_layer_data->compress_counters.tx_bytes_in,
+                         body_len);
+    __sync_fetch_and_add(&comm_layer_data->compress_counters.tx_bytes_out,
+                         comp_len);
+
+    wire_msg_free(*wire_msg, *mux_msg);
+    *wire_msg = comp_msg;
+    *mux_msg = comp_mux_msg;
+    *wire_len = MLAG_WIRE_HEADER_SIZE + comp_len;
+}
+
+/*
+ *  This function decompresses message body built by
+ *  wire_msg_compress
+ *
+ * @param[in] comm_layer_data - module specific data
+ * @param[in] body - compressed body
+ * @param[in] length - compressed body length
+ * @param[out] plain - decompressed body, to be freed by cl_free
+ * @param[out] plain_len - decompressed body length
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+wire_body_decompress(struct mlag_comm_layer_wrapper_data *comm_layer_data,
+                     const uint8_t *body, uint32_t length, uint8_t **plain,
+                     uint32_t *plain_len)
+{
+    int err = 0;
+    uint32_t orig_len;
+    uint64_t start;
+
+    *plain = NULL;
+    if (length < sizeof(orig_len)) {
+        err = -EPROTO;
+        MLAG_BAIL_ERROR_MSG(err, "Compressed body too short [%u]\n", length);
+    }
+    memcpy(&orig_len, body, sizeof(orig_len));
+    orig_len = ntohl(orig_len);
+    if ((orig_len == 0) || (orig_len > MLAG_COMPRESS_MAX_LEN)) {
+        err = -EPROTO;
+        MLAG_BAIL_ERROR_MSG(err, "Bad decompressed length [%u]\n", orig_len);
+    }
+
+    *plain = (uint8_t *)cl_malloc(orig_len);
+    if (*plain == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate %u bytes\n", orig_len);
+    }
+
+    start = thread_cpu_usec();
+    err = mlag_decompress(body + sizeof(orig_len), length - sizeof(orig_len),
+                          *plain, orig_len);
+    __sync_fetch_and_add(&comm_layer_data->compress_counters.rx_usec,
+                         thread_cpu_usec() - start);
+    MLAG_BAIL_ERROR(err);
+
+    __sync_fetch_and_add(&comm_layer_data->compress_counters.rx_msgs, 1);
+    __sync_fetch_and_add(&comm_layer_data->compress_counters.rx_bytes_in,
+                         length);
+    __sync_fetch_and_add(&comm_layer_data->compress_counters.rx_bytes_out,
+                         orig_len);
+    *plain_len = orig_len;
+
 bail:
+    if (err) {
+        __sync_fetch_and_add(&comm_layer_data->compress_counters.rx_errors, 1);
+        if (*plain) {
+            cl_free(*plain);
+            *plain = NULL;
+        }
+    }
     return err;
 }
 
@@ -732,32 +1397,89 @@ message_send(struct mlag_comm_layer_wrapper_data *comm_layer_data,
              uint8_t *payload, uint32_t payload_len)
 {
     int err = 0;
-    uint32_t payload_len_sent = payload_len;
+    uint32_t stamp_len = 0;
+    uint32_t body_len = 0;
+    uint32_t payload_len_sent;
     handle_t conn_handle = -1;
     int is_locked = 0;
+    uint8_t *wire_msg = NULL;
+    struct mlag_mux_tx_msg *mux_msg = NULL;
+    uint8_t flags = wire_flags(comm_layer_data);
+
+    if (MLAG_EVENT_LATENCY && comm_layer_data->peer_stamp[dest_peer_id]) {
+        stamp_len = MLAG_WIRE_STAMP_SIZE;
+        flags |= MLAG_WIRE_FLAG_STAMPED;
+    }
+    payload_len_sent = MLAG_WIRE_HEADER_SIZE + payload_len + stamp_len;
 
-    MLAG_LOG(MLAG_LOG_INFO,
-             "Send tcp message with opcode %d, destination peer id %d, length %d, handle %d\n",
-             opcode, dest_peer_id, payload_len,
-             comm_layer_data->tcp_sock_handle[dest_peer_id]);
+    MLAG_TRACE(MLAG_TRACE_INFO,
+               "Send tcp message with opcode %llu, destination peer id %llu, length %llu, handle %lld",
+               opcode, dest_peer_id, payload_len,
+               comm_layer_data->tcp_sock_handle[dest_peer_id]);
 
     /* Set opcode to the message body */
     *((uint16_t*)payload) = (uint16_t)opcode;
 
+    /* Build wire message: header followed by body encoded at its actual
+     * length, which is never longer than the payload. The mux queues
+     * its own copy, other messages are built in the send buffer of the
+     * thread. Caller payload is left in host order. */
+    if (comm_layer_data->mux_channel != MLAG_MUX_CHANNEL_NONE) {
+        mux_msg = mlag_comm_mux_msg_alloc(payload_len_sent);
+        wire_msg = (mux_msg != NULL) ? mux_msg->data : NULL;
+    }
+    else if (mlag_wire_buf_reserve(&wire_tx_buf, payload_len_sent) == 0) {
+        wire_msg = wire_tx_buf.data;
+    }
+    if (wire_msg == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate wire message, length %u\n",
+                            payload_len_sent);
+    }
+    err = wire_body_encode(comm_layer_data, payload, payload_len,
+                           wire_msg + MLAG_WIRE_HEADER_SIZE, &body_len);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to encode message with opcode %d\n",
+                        opcode);
+    if (stamp_len) {
+        wire_stamp_set(wire_msg + MLAG_WIRE_HEADER_SIZE + body_len);
+    }
+    mlag_wire_header_set((struct mlag_wire_header *)wire_msg,
+                         body_len + stamp_len, flags);
+    payload_len_sent = MLAG_WIRE_HEADER_SIZE + body_len + stamp_len;
+    if (mux_msg) {
+        mux_msg->length = payload_len_sent;
+    }
+
+    if (MLAG_IPL_COMPRESS && comm_layer_data->peer_compress[dest_peer_id] &&
+        (body_len >= MLAG_COMPRESS_THRESHOLD)) {
+        wire_msg_compress(comm_layer_data, &wire_msg, &mux_msg,
+                          &payload_len_sent);
+    }
+
     SOCKET_LOCK(comm_layer_data);
     is_locked = 1;
 
     conn_handle = comm_layer_data->tcp_sock_handle[dest_peer_id];
 
-    /* Send via communication library interface */
-    if (conn_handle) {
-    	if (comm_layer_data->net_order_msg_handler) {
-            comm_layer_data->net_order_msg_handler((void*)payload,
-                                                   MESSAGE_SENDING);
-        }
+    /* Queue on the primary mux connection, sent by the mux thread */
+    if (conn_handle && mux_msg) {
+        SOCKET_UNLOCK(comm_layer_data);
+        is_locked = 0;
+
+        err = mlag_comm_mux_send(comm_layer_data->mux_channel, dest_peer_id,
+                                 mux_msg);
+        mux_msg = NULL;
+        wire_msg = NULL;
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Failed to queue mux message with opcode %d, destination peer id %d\n",
+                            opcode, dest_peer_id);
 
+        WRAPPER_INC_CNT(comm_layer_data, TX_CNT);
+    }
+    /* Send via communication library interface */
+    else if (conn_handle) {
         err = comm_lib_tcp_send_blocking(
-        		conn_handle, payload, &payload_len_sent);
+        		conn_handle, wire_msg, &payload_len_sent);
 
         SOCKET_UNLOCK(comm_layer_data);
         is_locked = 0;
@@ -800,12 +1522,6 @@ message_send(struct mlag_comm_layer_wrapper_data *comm_layer_data,
             goto bail;
         }
 
-        /* return the pointer back to previous state */
-        if (comm_layer_data->net_order_msg_handler) {
-            comm_layer_data->net_order_msg_handler((void*)payload,
-                                                   MESSAGE_RECEIVE);
-        }
-
         WRAPPER_INC_CNT(comm_layer_data, TX_CNT);
     }
     else {
@@ -819,6 +1535,7 @@ bail:
 	if (is_locked) {
 		SOCKET_UNLOCK(comm_layer_data);
 	}
+    wire_msg_free(wire_msg, mux_msg);
     return err;
 }
 
@@ -931,9 +1648,51 @@ mlag_comm_layer_wrapper_counters_clear(
     struct mlag_comm_layer_wrapper_data *comm_layer_data)
 {
     SAFE_MEMSET(&comm_layer_data->counters, 0);
+    SAFE_MEMSET(&comm_layer_data->compress_counters, 0);
+    if (comm_layer_data->mux_channel == MLAG_MUX_CHANNEL_PRIMARY) {
+        mlag_comm_mux_counters_clear();
+    }
     return 0;
 }
 
+/*
+ *  This function prints compression counters, ratio is
+ *  compressed size in percents of the original size
+ *
+ * @param[in] comm_layer_data - module specific data
+ * @param[in] dump_cb - callback for dumping, if NULL, log it
+ *
+ * @return void
+ */
+static void
+wrapper_compress_counters_print(
+    struct mlag_comm_layer_wrapper_data *comm_layer_data,
+    void (*dump_cb)(const char *, ...))
+{
+    struct wrapper_compress_counters *cnt =
+        &comm_layer_data->compress_counters;
+
+    DUMP_OR_LOG("compression %s, threshold %u bytes\n",
+                (MLAG_IPL_COMPRESS) ? "enabled" : "disabled",
+                MLAG_COMPRESS_THRESHOLD);
+    DUMP_OR_LOG("TX compressed msgs = %llu, bytes %llu -> %llu (%llu%%), "
+                "cpu %llu usec\n",
+                (unsigned long long)cnt->tx_msgs,
+                (unsigned long long)cnt->tx_bytes_in,
+                (unsigned long long)cnt->tx_bytes_out,
+                (unsigned long long)((cnt->tx_bytes_in) ?
+                                     (cnt->tx_bytes_out * 100) /
+                                     cnt->tx_bytes_in : 0),
+                (unsigned long long)cnt->tx_usec);
+    DUMP_OR_LOG("RX compressed msgs = %llu, bytes %llu -> %llu, "
+                "cpu %llu usec, errors %llu\n",
+                (unsigned long long)cnt->rx_msgs,
+                (unsigned long long)cnt->rx_bytes_in,
+                (unsigned long long)cnt->rx_bytes_out,
+                (unsigned long long)cnt->rx_usec,
+                (unsigned long long)cnt->rx_errors);
+}
+
 /**
  *  This function prints comm layer wrapper counters to log
  *
@@ -959,6 +1718,10 @@ mlag_comm_layer_wrapper_print_counters(
                     comm_layer_data->counters.counter[i]);
         }
     }
+    wrapper_compress_counters_print(comm_layer_data, dump_cb);
+    if (comm_layer_data->mux_channel == MLAG_MUX_CHANNEL_PRIMARY) {
+        mlag_comm_mux_print(dump_cb);
+    }
     return 0;
 }
 
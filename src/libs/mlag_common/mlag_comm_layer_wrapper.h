@@ -79,6 +79,7 @@ typedef int (*add_fd_handler_t)(handle_t new_handle, int state);
 enum wrapper_coounters {
     TX_CNT = 0,
     RX_CNT,
+    RX_WIRE_ERR_CNT,
     WRAPPER_LAST_COUNTER
 };
 
@@ -86,17 +87,34 @@ struct wrapper_counters {
     int counter[WRAPPER_LAST_COUNTER];
 };
 
+/* Updated with __sync atomics, compression runs out of the socket lock */
+struct wrapper_compress_counters {
+    uint64_t tx_msgs;
+    uint64_t tx_bytes_in;  /* before compression */
+    uint64_t tx_bytes_out; /* after compression */
+    uint64_t tx_usec;      /* thread CPU time spent compressing */
+    uint64_t rx_msgs;
+    uint64_t rx_bytes_in;  /* compressed */
+    uint64_t rx_bytes_out; /* after decompression */
+    uint64_t rx_usec;
+    uint64_t rx_errors;
+};
+
 struct mlag_comm_layer_wrapper_data {
     int is_started;
     enum master_election_switch_status current_switch_status;
     uint32_t dest_ip_addr;
     uint16_t tcp_port;
     uint16_t tcp_server_id;
+    int mux_channel; /* MLAG_MUX_CHANNEL_NONE unless multiplexed */
     handle_t tcp_sock_handle[MLAG_MAX_PEERS];
     rcv_msg_handler_t rcv_msg_handler;
     add_fd_handler_t add_fd_handler;
     net_order_msg_handler_t net_order_msg_handler;
+    uint8_t peer_compress[MLAG_MAX_PEERS]; /* peer accepts compression */
+    uint8_t peer_stamp[MLAG_MAX_PEERS]; /* peer accepts stamped bodies */
     struct wrapper_counters counters;
+    struct wrapper_compress_counters compress_counters;
     cl_timer_t reconnect_timer;
     int reconnect_timer_msec;
     int reconnect_timer_started;
@@ -0,0 +1,1006 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <complib/cl_mem.h>
+#include <complib/cl_thread.h>
+#include "mlag_log.h"
+#include "mlag_bail.h"
+#include "mlag_defs.h"
+#include "mlag_events.h"
+#include "lib_commu.h"
+#include "mlag_common.h"
+#include "mlag_master_election.h"
+#include "mlag_comm_layer_wrapper.h"
+#include "mlag_wire.h"
+#include "mlag_comm_mux.h"
+
+#undef  __MODULE__
+#define __MODULE__ MLAG_COMM_LAYER_WRAPPER
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+#define MUX_CHANNEL_VALID(channel) \
+    (((channel) >= 0) && ((channel) < MLAG_MUX_CHANNEL_NUM))
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+struct mux_channel {
+    int registered;
+    int started;
+    void *wrapper;
+    uint16_t tcp_port;
+    enum mlag_mux_priority prio;
+    int rx_fd[2]; /* doorbell, readable while rx queue is not empty */
+    struct mlag_mux_rx_msg *rx_head; /* handoff from primary channel */
+    struct mlag_mux_rx_msg *rx_tail;
+    int notified[MLAG_MAX_PEERS];
+    struct mlag_mux_counters counters;
+};
+
+struct mux_lane {
+    struct mlag_mux_tx_msg *head;
+    struct mlag_mux_tx_msg *tail;
+};
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+
+static char *mux_channel_str[MLAG_MUX_CHANNEL_NUM] = {
+    "mlag",
+    "mac sync",
+    "tunneling"
+};
+
+static struct mux_channel mux_channels[MLAG_MUX_CHANNEL_NUM] = {
+    [MLAG_MUX_CHANNEL_MLAG] = { .prio = MLAG_MUX_PRIO_CONTROL,
+                                .tcp_port = MLAG_DISPATCHER_TCP_PORT },
+    [MLAG_MUX_CHANNEL_MAC_SYNC] = { .prio = MLAG_MUX_PRIO_BULK,
+                                    .tcp_port = MAC_SYNC_TCP_PORT },
+    [MLAG_MUX_CHANNEL_TUNNELING] = { .prio = MLAG_MUX_PRIO_CONTROL,
+                                     .tcp_port = TUNNELING_PORT },
+};
+
+/* Protects registration */
+static pthread_mutex_t mux_reg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int mux_reg_count;
+
+/* Protects primary connection state and channel notifications */
+static pthread_mutex_t mux_link_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t mux_link_ipv4[MLAG_MAX_PEERS];
+static uint32_t mux_link_session[MLAG_MAX_PEERS];
+
+/* Protects connection handles, held by sender thread during
+ * transmission. Taken after link mutex. */
+static pthread_mutex_t mux_tx_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int mux_link_handle[MLAG_MAX_PEERS];
+
+/* Protects transmit lanes, channel receive queues and counters */
+static pthread_mutex_t mux_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mux_queue_cond = PTHREAD_COND_INITIALIZER;
+static struct mux_lane mux_lanes[MLAG_MUX_PRIO_NUM];
+static int mux_thread_exit;
+static cl_thread_t mux_thread;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/**
+ *  This function maps wrapper tcp port to mux channel
+ *
+ * @param[in] tcp_port - wrapper tcp port
+ *
+ * @return channel, MLAG_MUX_CHANNEL_NONE if mux is disabled
+ *         or port is not multiplexed
+ */
+int
+mlag_comm_mux_channel_get(uint16_t tcp_port)
+{
+    int channel;
+
+    if (!MLAG_IPL_MUX) {
+        return MLAG_MUX_CHANNEL_NONE;
+    }
+    for (channel = 0; channel < MLAG_MUX_CHANNEL_NUM; channel++) {
+        if (mux_channels[channel].tcp_port == tcp_port) {
+            return channel;
+        }
+    }
+    return MLAG_MUX_CHANNEL_NONE;
+}
+
+/**
+ *  This function returns wire header flags of a channel
+ *
+ * @param[in] channel - mux channel
+ *
+ * @return wire header flags
+ */
+uint8_t
+mlag_comm_mux_wire_flags(int channel)
+{
+    uint8_t flags;
+
+    if (!MUX_CHANNEL_VALID(channel)) {
+        return 0;
+    }
+    flags = channel & MLAG_WIRE_FLAG_CHANNEL_MASK;
+    if (mux_channels[channel].prio == MLAG_MUX_PRIO_BULK) {
+        flags |= MLAG_WIRE_FLAG_BULK;
+    }
+    return flags;
+}
+
+/*
+ *  This function posts connection notification of channel towards
+ *  peer. Called with link mutex held.
+ *
+ * @param[in] channel - mux channel
+ * @param[in] peer_id - peer id
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+mux_channel_notify(int channel, int peer_id)
+{
+    int err = 0;
+    struct mux_channel *chan = &mux_channels[channel];
+    struct tcp_conn_notification_event_data ev;
+
+    ev.new_handle = chan->rx_fd[0];
+    ev.port = htons(chan->tcp_port);
+    ev.ipv4_addr = mux_link_ipv4[peer_id];
+    ev.data = chan->wrapper;
+    ev.rc = 0;
+
+    MLAG_LOG(MLAG_LOG_NOTICE,
+             "Mux channel %s connected to peer %d\n",
+             mux_channel_str[channel], peer_id);
+
+    /* Handled in context of channel dispatcher */
+    err = send_system_event(MLAG_CONN_NOTIFY_EVENT, &ev, sizeof(ev));
+    MLAG_BAIL_ERROR_MSG(err,
+                        "Failed in sending mux connection notification\n");
+    chan->notified[peer_id] = 1;
+
+bail:
+    return err;
+}
+
+/*
+ *  This function queues message to channel. Queue is not bounded,
+ *  so a slow channel never blocks the primary channel receive and
+ *  never loses a message. Channel receive fd is signaled when the
+ *  queue turns non empty. Called with link mutex held.
+ *
+ * @param[in] channel - mux channel
+ * @param[in] msg - message, owned by the channel on return
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+mux_channel_post(int channel, struct mlag_mux_rx_msg *msg)
+{
+    int err = 0;
+    uint8_t bell = 1;
+    struct mux_channel *chan = &mux_channels[channel];
+
+    msg->next = NULL;
+
+    pthread_mutex_lock(&mux_queue_mutex);
+    if (chan->rx_tail) {
+        chan->rx_tail->next = msg;
+    }
+    else {
+        chan->rx_head = msg;
+        /* Doorbell holds a single byte, write can not block */
+        if (write(chan->rx_fd[1], &bell, sizeof(bell)) != sizeof(bell)) {
+            err = -errno;
+        }
+    }
+    chan->rx_tail = msg;
+    chan->counters.rx_queue_depth++;
+    if (chan->counters.rx_queue_depth > chan->counters.rx_queue_depth_max) {
+        chan->counters.rx_queue_depth_max = chan->counters.rx_queue_depth;
+    }
+    pthread_mutex_unlock(&mux_queue_mutex);
+
+    /* Message stays queued, it is read on next doorbell */
+    MLAG_BAIL_ERROR_MSG(err, "Mux channel %s doorbell failed\n",
+                        mux_channel_str[channel]);
+
+bail:
+    return err;
+}
+
+/*
+ *  This function frees messages queued to channel.
+ *  Called with queue mutex held.
+ *
+ * @param[in] chan - mux channel
+ *
+ * @return void
+ */
+static void
+mux_channel_rx_flush(struct mux_channel *chan)
+{
+    struct mlag_mux_rx_msg *msg;
+
+    while (chan->rx_head) {
+        msg = chan->rx_head;
+        chan->rx_head = msg->next;
+        cl_free(msg);
+    }
+    chan->rx_tail = NULL;
+    chan->counters.rx_queue_depth = 0;
+}
+
+/*
+ *  This function frees messages of all lanes, or of given peer only
+ *  Called with queue mutex held.
+ *
+ * @param[in] peer_id - peer id, or MLAG_MAX_PEERS for all peers
+ *
+ * @return void
+ */
+static void
+mux_lanes_flush(int peer_id)
+{
+    int prio;
+    struct mlag_mux_tx_msg **msg;
+    struct mlag_mux_tx_msg *del;
+
+    for (prio = 0; prio < MLAG_MUX_PRIO_NUM; prio++) {
+        msg = &mux_lanes[prio].head;
+        mux_lanes[prio].tail = NULL;
+        while (*msg) {
+            if ((peer_id == MLAG_MAX_PEERS) || ((*msg)->peer_id == peer_id)) {
+                del = *msg;
+                *msg = del->next;
+                mux_channels[del->channel].counters.tx_drops++;
+                mux_channels[del->channel].counters.queue_depth--;
+                cl_free(del);
+            }
+            else {
+                mux_lanes[prio].tail = *msg;
+                msg = &(*msg)->next;
+            }
+        }
+    }
+}
+
+/*
+ *  This function sends single message on the primary connection
+ *
+ * @param[in] msg - message
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+mux_msg_transmit(struct mlag_mux_tx_msg *msg)
+{
+    int err = 0;
+    uint32_t len = msg->length;
+
+    pthread_mutex_lock(&mux_tx_mutex);
+    if (mux_link_handle[msg->peer_id] == 0) {
+        err = -ENOTCONN;
+    }
+    else {
+        err = comm_lib_tcp_send_blocking(mux_link_handle[msg->peer_id],
+                                         msg->data, &len);
+    }
+    pthread_mutex_unlock(&mux_tx_mutex);
+
+    /* Connection loss is handled by the primary channel receive path */
+    MLAG_BAIL_ERROR_MSG(err,
+                        "Mux failed to send %s message to peer %d, err %d\n",
+                        mux_channel_str[msg->channel], msg->peer_id, err);
+
+bail:
+    return err;
+}
+
+/*
+ *  Mux sender thread, drains control lane ahead of bulk lane
+ *
+ * @param[in] data - unused
+ *
+ * @return void
+ */
+static void
+mux_thread_routine(void *data)
+{
+    int err = 0;
+    int prio;
+    struct mlag_mux_tx_msg *msg;
+    struct mlag_mux_counters *counters;
+
+    UNUSED_PARAM(data);
+
+    while (TRUE) {
+        pthread_mutex_lock(&mux_queue_mutex);
+        while (!mux_thread_exit &&
+               (mux_lanes[MLAG_MUX_PRIO_CONTROL].head == NULL) &&
+               (mux_lanes[MLAG_MUX_PRIO_BULK].head == NULL)) {
+            pthread_cond_wait(&mux_queue_cond, &mux_queue_mutex);
+        }
+        if (mux_thread_exit) {
+            pthread_mutex_unlock(&mux_queue_mutex);
+            break;
+        }
+        prio = (mux_lanes[MLAG_MUX_PRIO_CONTROL].head != NULL) ?
+               MLAG_MUX_PRIO_CONTROL : MLAG_MUX_PRIO_BULK;
+        msg = mux_lanes[prio].head;
+        mux_lanes[prio].head = msg->next;
+        if (mux_lanes[prio].head == NULL) {
+            mux_lanes[prio].tail = NULL;
+        }
+        mux_channels[msg->channel].counters.queue_depth--;
+        pthread_mutex_unlock(&mux_queue_mutex);
+
+        err = mux_msg_transmit(msg);
+
+        pthread_mutex_lock(&mux_queue_mutex);
+        counters = &mux_channels[msg->channel].counters;
+        if (err) {
+            counters->tx_drops++;
+        }
+        else {
+            counters->tx_msgs++;
+            counters->tx_bytes += msg->length;
+        }
+        pthread_mutex_unlock(&mux_queue_mutex);
+        cl_free(msg);
+    }
+}
+
+/*
+ *  This function starts mux sender thread
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+mux_init(void)
+{
+    int err = 0;
+    cl_status_t cl_err;
+
+    memset(mux_lanes, 0, sizeof(mux_lanes));
+    memset(mux_link_handle, 0, sizeof(mux_link_handle));
+    mux_thread_exit = FALSE;
+
+    cl_err = cl_thread_init(&mux_thread, mux_thread_routine, NULL, NULL);
+    if (cl_err != CL_SUCCESS) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Could not create mux sender thread\n");
+    }
+
+bail:
+    return err;
+}
+
+/*
+ *  This function stops mux sender thread and drops queued messages
+ *
+ * @return void
+ */
+static void
+mux_deinit(void)
+{
+    pthread_mutex_lock(&mux_queue_mutex);
+    mux_thread_exit = TRUE;
+    pthread_cond_signal(&mux_queue_cond);
+    pthread_mutex_unlock(&mux_queue_mutex);
+
+    cl_thread_destroy(&mux_thread);
+
+    pthread_mutex_lock(&mux_queue_mutex);
+    mux_lanes_flush(MLAG_MAX_PEERS);
+    pthread_mutex_unlock(&mux_queue_mutex);
+}
+
+/**
+ *  This function registers channel wrapper. First registration
+ *  starts the mux sender thread.
+ *
+ * @param[in] channel - mux channel
+ * @param[in] wrapper - channel comm layer wrapper data
+ * @param[in] tcp_port - channel tcp port, reported in notifications
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+mlag_comm_mux_register(int channel, void *wrapper, uint16_t tcp_port)
+{
+    int err = 0;
+    struct mux_channel *chan;
+
+    ASSERT(MUX_CHANNEL_VALID(channel));
+    chan = &mux_channels[channel];
+
+    pthread_mutex_lock(&mux_reg_mutex);
+
+    if (chan->registered) {
+        err = -EEXIST;
+        MLAG_BAIL_ERROR_MSG(err, "Mux channel %s already registered\n",
+                            mux_channel_str[channel]);
+    }
+
+    chan->rx_fd[0] = -1;
+    chan->rx_fd[1] = -1;
+    if (channel != MLAG_MUX_CHANNEL_PRIMARY) {
+        if (pipe(chan->rx_fd) < 0) {
+            err = -errno;
+            MLAG_BAIL_ERROR_MSG(err, "Failed to open mux channel %s fd\n",
+                                mux_channel_str[channel]);
+        }
+        fcntl(chan->rx_fd[0], F_SETFL, O_NONBLOCK);
+        fcntl(chan->rx_fd[1], F_SETFL, O_NONBLOCK);
+    }
+    chan->rx_head = NULL;
+    chan->rx_tail = NULL;
+
+    if (mux_reg_count == 0) {
+        err = mux_init();
+        MLAG_BAIL_ERROR(err);
+    }
+    mux_reg_count++;
+
+    chan->wrapper = wrapper;
+    chan->tcp_port = tcp_port;
+    chan->started = 0;
+    memset(chan->notified, 0, sizeof(chan->notified));
+    SAFE_MEMSET(&chan->counters, 0);
+    chan->registered = 1;
+
+    MLAG_LOG(MLAG_LOG_NOTICE, "Mux channel %s registered, tcp port %u\n",
+             mux_channel_str[channel], tcp_port);
+
+bail:
+    if (err && (err != -EEXIST) && (chan->rx_fd[0] >= 0)) {
+        close(chan->rx_fd[0]);
+        close(chan->rx_fd[1]);
+    }
+    pthread_mutex_unlock(&mux_reg_mutex);
+    return err;
+}
+
+/**
+ *  This function unregisters channel wrapper. Last unregistration
+ *  stops the mux sender thread.
+ *
+ * @param[in] channel - mux channel
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+mlag_comm_mux_unregister(int channel)
+{
+    int err = 0;
+    struct mux_channel *chan;
+
+    ASSERT(MUX_CHANNEL_VALID(channel));
+    chan = &mux_channels[channel];
+
+    pthread_mutex_lock(&mux_reg_mutex);
+
+    if (!chan->registered) {
+        goto out;
+    }
+
+    pthread_mutex_lock(&mux_link_mutex);
+    chan->registered = 0;
+    chan->started = 0;
+    pthread_mutex_unlock(&mux_link_mutex);
+
+    /* Free messages never read by the channel */
+    pthread_mutex_lock(&mux_queue_mutex);
+    mux_channel_rx_flush(chan);
+    pthread_mutex_unlock(&mux_queue_mutex);
+
+    if (chan->rx_fd[0] >= 0) {
+        close(chan->rx_fd[0]);
+        close(chan->rx_fd[1]);
+        chan->rx_fd[0] = -1;
+        chan->rx_fd[1] = -1;
+    }
+
+    mux_reg_count--;
+    if (mux_reg_count == 0) {
+        mux_deinit();
+    }
+
+out:
+    pthread_mutex_unlock(&mux_reg_mutex);
+bail:
+    return err;
+}
+
+/**
+ *  This function is called when primary TCP connection with peer
+ *  is established. Started channels are notified of the connection.
+ *
+ * @param[in] peer_id - peer id
+ * @param[in] handle - TCP socket handle
+ * @param[in] ipv4_addr - peer ip address in network order
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+mlag_comm_mux_link_up(int peer_id, int handle, uint32_t ipv4_addr)
+{
+    int err = 0;
+    int channel;
+
+    ASSERT((peer_id >= 0) && (peer_id < MLAG_MAX_PEERS));
+
+    pthread_mutex_lock(&mux_link_mutex);
+
+    pthread_mutex_lock(&mux_tx_mutex);
+    mux_link_handle[peer_id] = handle;
+    pthread_mutex_unlock(&mux_tx_mutex);
+    mux_link_ipv4[peer_id] = ipv4_addr;
+    /* Messages handed off on previous connection are discarded */
+    mux_link_session[peer_id]++;
+
+    for (channel = 0; channel < MLAG_MUX_CHANNEL_NUM; channel++) {
+        if ((channel == MLAG_MUX_CHANNEL_PRIMARY) ||
+            !mux_channels[channel].started) {
+            continue;
+        }
+        err = mux_channel_notify(channel, peer_id);
+        if (err) {
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&mux_link_mutex);
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function is called before primary TCP connection with peer
+ *  is closed. Waits for message in transmission, drops queued
+ *  messages and notifies channels of connection loss.
+ *
+ * @param[in] peer_id - peer id
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+mlag_comm_mux_link_down(int peer_id)
+{
+    int err = 0;
+    int channel;
+    struct mlag_mux_rx_msg *msg;
+
+    ASSERT((peer_id >= 0) && (peer_id < MLAG_MAX_PEERS));
+
+    pthread_mutex_lock(&mux_link_mutex);
+
+    /* Wait for message in transmission */
+    pthread_mutex_lock(&mux_tx_mutex);
+    mux_link_handle[peer_id] = 0;
+    pthread_mutex_unlock(&mux_tx_mutex);
+
+    pthread_mutex_lock(&mux_queue_mutex);
+    mux_lanes_flush(peer_id);
+    pthread_mutex_unlock(&mux_queue_mutex);
+
+    for (channel = 0; channel < MLAG_MUX_CHANNEL_NUM; channel++) {
+        if (!mux_channels[channel].notified[peer_id]) {
+            continue;
+        }
+        mux_channels[channel].notified[peer_id] = 0;
+
+        msg = (struct mlag_mux_rx_msg *)cl_malloc(sizeof(*msg));
+        if (msg == NULL) {
+            err = -ENOMEM;
+            continue;
+        }
+        msg->session = mux_link_session[peer_id];
+        msg->peer_id = peer_id;
+        msg->ipv4_addr = mux_link_ipv4[peer_id];
+        msg->flags = 0;
+        msg->length = 0;
+        mux_channel_post(channel, msg);
+    }
+
+    pthread_mutex_unlock(&mux_link_mutex);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to notify mux channels on peer %d\n",
+                        peer_id);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function marks channel as started. Channel is notified of
+ *  primary connections already established.
+ *
+ * @param[in] channel - mux channel
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+mlag_comm_mux_channel_start(int channel)
+{
+    int err = 0;
+    int peer_id;
+    struct mux_channel *chan;
+
+    ASSERT(MUX_CHANNEL_VALID(channel));
+    chan = &mux_channels[channel];
+
+    pthread_mutex_lock(&mux_link_mutex);
+
+    chan->started = 1;
+    for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
+        if ((channel == MLAG_MUX_CHANNEL_PRIMARY) ||
+            (mux_link_handle[peer_id] == 0) || chan->notified[peer_id]) {
+            continue;
+        }
+        err = mux_channel_notify(channel, peer_id);
+        if (err) {
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&mux_link_mutex);
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function stops channel towards single peer or all peers
+ *
+ * @param[in] channel - mux channel
+ * @param[in] peer_id - peer id, or MLAG_MAX_PEERS for all peers.
+ *                      Stopping all peers marks channel as stopped.
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+mlag_comm_mux_channel_stop(int channel, int peer_id)
+{
+    int err = 0;
+    struct mux_channel *chan;
+
+    ASSERT(MUX_CHANNEL_VALID(channel));
+    ASSERT((peer_id >= 0) && (peer_id <= MLAG_MAX_PEERS));
+    chan = &mux_channels[channel];
+
+    pthread_mutex_lock(&mux_link_mutex);
+    if (peer_id == MLAG_MAX_PEERS) {
+        chan->started = 0;
+        memset(chan->notified, 0, sizeof(chan->notified));
+    }
+    else {
+        chan->notified[peer_id] = 0;
+    }
+    pthread_mutex_unlock(&mux_link_mutex);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function allocates outgoing message
+ *
+ * @param[in] length - wire message length including header
+ *
+ * @return message, NULL if out of memory
+ */
+struct mlag_mux_tx_msg *
+mlag_comm_mux_msg_alloc(uint32_t length)
+{
+    struct mlag_mux_tx_msg *msg;
+
+    msg = (struct mlag_mux_tx_msg *)cl_malloc(sizeof(*msg) + length);
+    if (msg != NULL) {
+        msg->next = NULL;
+        msg->length = length;
+    }
+    return msg;
+}
+
+/**
+ *  This function queues message for transmission on the primary
+ *  connection. Control messages are sent ahead of bulk messages.
+ *  Message is owned by the mux after this call.
+ *
+ * @param[in] channel - mux channel
+ * @param[in] peer_id - destination peer id
+ * @param[in] msg - message allocated by mlag_comm_mux_msg_alloc
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+mlag_comm_mux_send(int channel, int peer_id, struct mlag_mux_tx_msg *msg)
+{
+    int err = 0;
+    struct mux_channel *chan;
+    struct mux_lane *lane;
+
+    if (!MUX_CHANNEL_VALID(channel) ||
+        (peer_id < 0) || (peer_id >= MLAG_MAX_PEERS)) {
+        cl_free(msg);
+        err = -EINVAL;
+        MLAG_BAIL_ERROR_MSG(err, "Mux send to channel %d peer %d\n",
+                            channel, peer_id);
+    }
+    chan = &mux_channels[channel];
+    lane = &mux_lanes[chan->prio];
+
+    msg->channel = channel;
+    msg->peer_id = peer_id;
+    msg->next = NULL;
+
+    pthread_mutex_lock(&mux_queue_mutex);
+    if (lane->tail) {
+        lane->tail->next = msg;
+    }
+    else {
+        lane->head = msg;
+    }
+    lane->tail = msg;
+    chan->counters.queue_depth++;
+    if (chan->counters.queue_depth > chan->counters.queue_depth_max) {
+        chan->counters.queue_depth_max = chan->counters.queue_depth;
+    }
+    pthread_cond_signal(&mux_queue_cond);
+    pthread_mutex_unlock(&mux_queue_mutex);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function accounts message received on the primary connection
+ *
+ * @param[in] channel - mux channel
+ * @param[in] length - message body length
+ *
+ * @return void
+ */
+void
+mlag_comm_mux_rx_count(int channel, uint32_t length)
+{
+    if (!MUX_CHANNEL_VALID(channel)) {
+        return;
+    }
+    pthread_mutex_lock(&mux_queue_mutex);
+    mux_channels[channel].counters.rx_msgs++;
+    mux_channels[channel].counters.rx_bytes += length;
+    pthread_mutex_unlock(&mux_queue_mutex);
+}
+
+/**
+ *  This function hands message received on the primary connection
+ *  to the channel it belongs to. Message body is copied.
+ *  Message is accounted by mlag_comm_mux_rx_count.
+ *
+ * @param[in] channel - mux channel
+ * @param[in] peer_id - source peer id
+ * @param[in] ipv4_addr - source ip address in network order
+ * @param[in] flags - wire header flags
+ * @param[in] version - wire header version
+ * @param[in] body - message body in network order
+ * @param[in] length - message body length
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+mlag_comm_mux_deliver(int channel, int peer_id, uint32_t ipv4_addr,
+                      uint8_t flags, uint8_t version, uint8_t *body,
+                      uint32_t length)
+{
+    int err = 0;
+    struct mlag_mux_rx_msg *msg = NULL;
+
+    if (!MUX_CHANNEL_VALID(channel) ||
+        (channel == MLAG_MUX_CHANNEL_PRIMARY) ||
+        (peer_id < 0) || (peer_id >= MLAG_MAX_PEERS)) {
+        err = -EPROTO;
+        MLAG_BAIL_ERROR_MSG(err, "Mux message for channel %d peer %d\n",
+                            channel, peer_id);
+    }
+
+    msg = (struct mlag_mux_rx_msg *)cl_malloc(sizeof(*msg) + length);
+    if (msg == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate mux message, length %u\n",
+                            length);
+    }
+    msg->peer_id = peer_id;
+    msg->ipv4_addr = ipv4_addr;
+    msg->flags = flags;
+    msg->version = version;
+    msg->length = length;
+    memcpy(msg->data, body, length);
+
+    pthread_mutex_lock(&mux_link_mutex);
+    msg->session = mux_link_session[peer_id];
+    if (mux_channels[channel].registered) {
+        err = mux_channel_post(channel, msg);
+    }
+    else {
+        cl_free(msg);
+        err = -ENOENT;
+    }
+    pthread_mutex_unlock(&mux_link_mutex);
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function reads message handed to channel. Messages of
+ *  previous primary connections are discarded.
+ *
+ * @param[in] channel - mux channel
+ * @param[in] fd - channel receive fd
+ * @param[out] msg - message to be freed by cl_free, NULL if discarded
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+mlag_comm_mux_receive(int channel, int fd, struct mlag_mux_rx_msg **msg)
+{
+    int err = 0;
+    uint8_t bell;
+    struct mux_channel *chan;
+
+    ASSERT(MUX_CHANNEL_VALID(channel));
+    ASSERT(msg != NULL);
+    chan = &mux_channels[channel];
+
+    pthread_mutex_lock(&mux_queue_mutex);
+    *msg = chan->rx_head;
+    if (*msg != NULL) {
+        chan->rx_head = (*msg)->next;
+        chan->counters.rx_queue_depth--;
+    }
+    if (chan->rx_head == NULL) {
+        chan->rx_tail = NULL;
+        /* Queue drained, fd is not readable until next post */
+        if (read(fd, &bell, sizeof(bell)) < 0) {
+            /* Already cleared */
+        }
+    }
+    pthread_mutex_unlock(&mux_queue_mutex);
+    if (*msg == NULL) {
+        goto bail;
+    }
+
+    pthread_mutex_lock(&mux_link_mutex);
+    if ((*msg)->session != mux_link_session[(*msg)->peer_id]) {
+        MLAG_LOG(MLAG_LOG_INFO,
+                 "Mux channel %s dropped message of previous connection\n",
+                 mux_channel_str[channel]);
+        cl_free(*msg);
+        *msg = NULL;
+    }
+    pthread_mutex_unlock(&mux_link_mutex);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function clears mux counters
+ *
+ * @return void
+ */
+void
+mlag_comm_mux_counters_clear(void)
+{
+    int channel;
+    struct mlag_mux_counters *counters;
+
+    pthread_mutex_lock(&mux_queue_mutex);
+    for (channel = 0; channel < MLAG_MUX_CHANNEL_NUM; channel++) {
+        counters = &mux_channels[channel].counters;
+        counters->tx_msgs = 0;
+        counters->tx_bytes = 0;
+        counters->tx_drops = 0;
+        counters->rx_msgs = 0;
+        counters->rx_bytes = 0;
+        counters->queue_depth_max = counters->queue_depth;
+        counters->rx_queue_depth_max = counters->rx_queue_depth;
+    }
+    pthread_mutex_unlock(&mux_queue_mutex);
+}
+
+/**
+ *  This function prints mux channels and counters
+ *
+ * @param[in] dump_cb - callback for dumping, if NULL, log it
+ *
+ * @return void
+ */
+void
+mlag_comm_mux_print(void (*dump_cb)(const char *, ...))
+{
+    int channel;
+    struct mlag_mux_counters counters[MLAG_MUX_CHANNEL_NUM];
+
+    pthread_mutex_lock(&mux_queue_mutex);
+    for (channel = 0; channel < MLAG_MUX_CHANNEL_NUM; channel++) {
+        counters[channel] = mux_channels[channel].counters;
+    }
+    pthread_mutex_unlock(&mux_queue_mutex);
+
+    DUMP_OR_LOG("IPL mux channels:\n");
+    DUMP_OR_LOG("%-10s %-8s %10s %12s %8s %10s %12s %6s %6s %8s %6s\n",
+                "channel", "prio", "tx msgs", "tx bytes", "tx drop",
+                "rx msgs", "rx bytes", "queue", "max", "rx queue", "max");
+    for (channel = 0; channel < MLAG_MUX_CHANNEL_NUM; channel++) {
+        DUMP_OR_LOG("%-10s %-8s %10llu %12llu %8llu %10llu %12llu "
+                    "%6u %6u %8u %6u\n",
+                    mux_channel_str[channel],
+                    (mux_channels[channel].prio == MLAG_MUX_PRIO_BULK) ?
+                    "bulk" : "control",
+                    (unsigned long long)counters[channel].tx_msgs,
+                    (unsigned long long)counters[channel].tx_bytes,
+                    (unsigned long long)counters[channel].tx_drops,
+                    (unsigned long long)counters[channel].rx_msgs,
+                    (unsigned long long)counters[channel].rx_bytes,
+                    counters[channel].queue_depth,
+                    counters[channel].queue_depth_max,
+                    counters[channel].rx_queue_depth,
+                    counters[channel].rx_queue_depth_max);
+    }
+    DUMP_OR_LOG("\n");
+}
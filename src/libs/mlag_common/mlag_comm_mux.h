@@ -0,0 +1,269 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#ifndef MLAG_COMM_MUX_H_
+#define MLAG_COMM_MUX_H_
+
+#include <stdint.h>
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* Carry all IPL channels on the mlag dispatcher TCP connection.
+ * Both peers must be built with the same setting. */
+#ifndef MLAG_IPL_MUX
+#define MLAG_IPL_MUX 0
+#endif
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+enum mlag_mux_channel {
+    MLAG_MUX_CHANNEL_NONE = -1,
+    MLAG_MUX_CHANNEL_MLAG = 0, /* owns the TCP connection */
+    MLAG_MUX_CHANNEL_MAC_SYNC,
+    MLAG_MUX_CHANNEL_TUNNELING,
+    MLAG_MUX_CHANNEL_NUM
+};
+
+#define MLAG_MUX_CHANNEL_PRIMARY MLAG_MUX_CHANNEL_MLAG
+
+enum mlag_mux_priority {
+    MLAG_MUX_PRIO_CONTROL = 0,
+    MLAG_MUX_PRIO_BULK,
+    MLAG_MUX_PRIO_NUM
+};
+
+struct mlag_mux_counters {
+    uint64_t tx_msgs;
+    uint64_t tx_bytes;
+    uint64_t tx_drops;
+    uint64_t rx_msgs;
+    uint64_t rx_bytes;
+    uint32_t queue_depth;
+    uint32_t queue_depth_max;
+    uint32_t rx_queue_depth;
+    uint32_t rx_queue_depth_max;
+};
+
+/* Outgoing wire message, header included */
+struct mlag_mux_tx_msg {
+    struct mlag_mux_tx_msg *next;
+    int channel;
+    int peer_id;
+    uint32_t length;
+    uint8_t data[];
+};
+
+/* Message handed from the primary channel to another channel.
+ * Zero length marks connection loss. */
+struct mlag_mux_rx_msg {
+    struct mlag_mux_rx_msg *next;
+    uint32_t session;
+    int peer_id;
+    uint32_t ipv4_addr; /* network order */
+    uint8_t flags;      /* wire header flags */
+    uint8_t version;    /* wire header version */
+    uint32_t length;
+    uint8_t data[];
+};
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ *  This function maps wrapper tcp port to mux channel
+ *
+ * @param[in] tcp_port - wrapper tcp port
+ *
+ * @return channel, MLAG_MUX_CHANNEL_NONE if mux is disabled
+ *         or port is not multiplexed
+ */
+int mlag_comm_mux_channel_get(uint16_t tcp_port);
+
+/**
+ *  This function returns wire header flags of a channel
+ *
+ * @param[in] channel - mux channel
+ *
+ * @return wire header flags
+ */
+uint8_t mlag_comm_mux_wire_flags(int channel);
+
+/**
+ *  This function registers channel wrapper. First registration
+ *  starts the mux sender thread.
+ *
+ * @param[in] channel - mux channel
+ * @param[in] wrapper - channel comm layer wrapper data
+ * @param[in] tcp_port - channel tcp port, reported in notifications
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int mlag_comm_mux_register(int channel, void *wrapper, uint16_t tcp_port);
+
+/**
+ *  This function unregisters channel wrapper. Last unregistration
+ *  stops the mux sender thread.
+ *
+ * @param[in] channel - mux channel
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int mlag_comm_mux_unregister(int channel);
+
+/**
+ *  This function is called when primary TCP connection with peer
+ *  is established. Started channels are notified of the connection.
+ *
+ * @param[in] peer_id - peer id
+ * @param[in] handle - TCP socket handle
+ * @param[in] ipv4_addr - peer ip address in network order
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int mlag_comm_mux_link_up(int peer_id, int handle, uint32_t ipv4_addr);
+
+/**
+ *  This function is called before primary TCP connection with peer
+ *  is closed. Waits for message in transmission, drops queued
+ *  messages and notifies channels of connection loss.
+ *
+ * @param[in] peer_id - peer id
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int mlag_comm_mux_link_down(int peer_id);
+
+/**
+ *  This function marks channel as started. Channel is notified of
+ *  primary connections already established.
+ *
+ * @param[in] channel - mux channel
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int mlag_comm_mux_channel_start(int channel);
+
+/**
+ *  This function stops channel towards single peer or all peers
+ *
+ * @param[in] channel - mux channel
+ * @param[in] peer_id - peer id, or MLAG_MAX_PEERS for all peers.
+ *                      Stopping all peers marks channel as stopped.
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int mlag_comm_mux_channel_stop(int channel, int peer_id);
+
+/**
+ *  This function allocates outgoing message
+ *
+ * @param[in] length - wire message length including header
+ *
+ * @return message, NULL if out of memory
+ */
+struct mlag_mux_tx_msg * mlag_comm_mux_msg_alloc(uint32_t length);
+
+/**
+ *  This function queues message for transmission on the primary
+ *  connection. Control messages are sent ahead of bulk messages.
+ *  Message is owned by the mux after this call.
+ *
+ * @param[in] channel - mux channel
+ * @param[in] peer_id - destination peer id
+ * @param[in] msg - message allocated by mlag_comm_mux_msg_alloc
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int mlag_comm_mux_send(int channel, int peer_id, struct mlag_mux_tx_msg *msg);
+
+/**
+ *  This function accounts message received on the primary connection
+ *
+ * @param[in] channel - mux channel
+ * @param[in] length - message body length
+ *
+ * @return void
+ */
+void mlag_comm_mux_rx_count(int channel, uint32_t length);
+
+/**
+ *  This function hands message received on the primary connection
+ *  to the channel it belongs to. Message body is copied.
+ *  Message is accounted by mlag_comm_mux_rx_count.
+ *
+ * @param[in] channel - mux channel
+ * @param[in] peer_id - source peer id
+ * @param[in] ipv4_addr - source ip address in network order
+ * @param[in] flags - wire header flags
+ * @param[in] version - wire header version
+ * @param[in] body - message body in network order
+ * @param[in] length - message body length
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int mlag_comm_mux_deliver(int channel, int peer_id, uint32_t ipv4_addr,
+                          uint8_t flags, uint8_t version, uint8_t *body,
+                          uint32_t length);
+
+/**
+ *  This function reads message handed to channel. Messages of
+ *  previous primary connections are discarded. Channel receive fd
+ *  is readable as long as messages are queued to the channel.
+ *
+ * @param[in] channel - mux channel
+ * @param[in] fd - channel receive fd
+ * @param[out] msg - message to be freed by cl_free, NULL if discarded
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int mlag_comm_mux_receive(int channel, int fd, struct mlag_mux_rx_msg **msg);
+
+/**
+ *  This function clears mux counters
+ *
+ * @return void
+ */
+void mlag_comm_mux_counters_clear(void);
+
+/**
+ *  This function prints mux channels and counters
+ *
+ * @param[in] dump_cb - callback for dumping, if NULL, log it
+ *
+ * @return void
+ */
+void mlag_comm_mux_print(void (*dump_cb)(const char *, ...));
+
+#endif /* MLAG_COMM_MUX_H_ */
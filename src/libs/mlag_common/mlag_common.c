@@ -32,6 +32,7 @@
 #include <signal.h>
 #include <dlfcn.h>
 #include <errno.h>
+#include <string.h>
 #include <complib/cl_init.h>
 #include <complib/cl_timer.h>
 #include <complib/cl_mem.h>
@@ -43,6 +44,7 @@
 #include <utils/mlag_defs.h>
 #include <mlnx_lib/lib_event_disp.h>
 #include "mlag_common.h"
+#include <libs/mlag_common/mlag_lock_prof.h>
 
 /************************************************
  *  Local Defines
@@ -51,6 +53,9 @@
 #undef  __MODULE__
 #define __MODULE__ MLAG_COMMON
 
+/* Stamped events up to this size are built on the stack */
+#define EVENT_STAMP_STACK_SIZE 512
+
 /************************************************
  *  Local Macros
  ***********************************************/
@@ -69,6 +74,7 @@
  ***********************************************/
 
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+static uint32_t mlag_max_ports = MLAG_MAX_PORTS_DEFAULT;
 
 /************************************************
  *  Local function declarations
@@ -193,6 +199,53 @@ bail:
     return err;
 }
 
+/*
+ *  This function sends a system event prefixed by its enqueue stamp
+ *
+ * @param[in] event_id - event ID
+ * @param[in] data - pointer to data start
+ * @param[in] data_size - data size in bytes
+ *
+ * @return 0 if operation completes successfully.
+ * @return EIO for communication error
+ */
+static int
+stamped_event_send(int event_id, void *data, int data_size)
+{
+    event_disp_status_t event_status;
+    int err = 0;
+    uint64_t stack_buf[EVENT_STAMP_STACK_SIZE / sizeof(uint64_t)];
+    uint8_t *buf = (uint8_t *)stack_buf;
+    int size = MLAG_EVENT_STAMP_SIZE + data_size;
+    struct mlag_event_stamp stamp;
+
+    if (size > (int)sizeof(stack_buf)) {
+        buf = (uint8_t *)cl_malloc(size);
+        if (buf == NULL) {
+            err = -ENOMEM;
+            MLAG_BAIL_ERROR_MSG(err, "Failed to allocate event [%u]\n",
+                                event_id);
+        }
+    }
+    stamp.enqueue_usec = mlag_latency_mono_usec();
+    memcpy(buf, &stamp, MLAG_EVENT_STAMP_SIZE);
+    memcpy(buf + MLAG_EVENT_STAMP_SIZE, data, data_size);
+
+    event_status = event_disp_api_generate_event_no_copy(event_id, buf,
+                                                         size);
+    if (event_status != EVENT_DISP_STATUS_SUCCESS) {
+        err = -EIO;
+        MLAG_BAIL_NOCHECK_MSG("Failed to generate event [%u] err [%u]\n",
+                              event_id, event_status);
+    }
+
+bail:
+    if ((buf != NULL) && (buf != (uint8_t *)stack_buf)) {
+        cl_free(buf);
+    }
+    return err;
+}
+
 /**
  *  This function send a system event
  *
@@ -209,6 +262,10 @@ send_system_event(int event_id, void *data, int data_size)
     event_disp_status_t event_status;
     int err = 0;
 
+    if (MLAG_EVENT_LATENCY) {
+        return stamped_event_send(event_id, data, data_size);
+    }
+
     event_status = event_disp_api_generate_event_no_copy(event_id, data,
                                                          data_size);
     if (event_status != EVENT_DISP_STATUS_SUCCESS) {
@@ -242,6 +299,9 @@ dispatcher_sys_event_handler(int fd, void *data, char *mlag_event,
     event_disp_status_t event_status;
     handler_command_t cmd_data;
     cmd_db_handle_t *cmd_db_handle = NULL;
+    struct mlag_event_stamp stamp;
+    uint64_t start_usec = 0;
+    uint64_t end_usec;
 
     ASSERT(data != NULL);
     cmd_db_handle = (cmd_db_handle_t *)data;
@@ -254,6 +314,12 @@ dispatcher_sys_event_handler(int fd, void *data, char *mlag_event,
                             event_status);
     }
 
+    /* Handlers see the event only */
+    if (MLAG_EVENT_LATENCY) {
+        memcpy(&stamp, mlag_event, MLAG_EVENT_STAMP_SIZE);
+        mlag_event += MLAG_EVENT_STAMP_SIZE;
+    }
+
     MLAG_LOG(MLAG_LOG_DEBUG, "Received event [%d]\n",
              *(unsigned short*)mlag_event);
 
@@ -267,7 +333,17 @@ dispatcher_sys_event_handler(int fd, void *data, char *mlag_event,
         MLAG_LOG(MLAG_LOG_NOTICE, "Empty function\n");
         goto bail;
     }
+    if (MLAG_EVENT_LATENCY) {
+        start_usec = mlag_latency_mono_usec();
+    }
     err = cmd_data.func((uint8_t *)mlag_event);
+    if (MLAG_EVENT_LATENCY) {
+        end_usec = mlag_latency_mono_usec();
+        mlag_latency_record(MLAG_EVENT_LATENCY_SYS_EVENT, cmd_data.cmd_id,
+                            (start_usec > stamp.enqueue_usec) ?
+                            (start_usec - stamp.enqueue_usec) : 0,
+                            end_usec - start_usec);
+    }
     if (err != -ECANCELED) {
         MLAG_BAIL_ERROR(err);
     }
@@ -569,3 +645,40 @@ bail:
     return err;
 }
 
+/**
+ *  This function sets the maximum number of mLAG ports. Port DBs,
+ *  port vectors and port message buffers are sized by it on init,
+ *  so it must be called before the mLAG modules are initialized.
+ *
+ * @param[in] max_ports - maximum number of mLAG ports
+ *
+ * @return 0 if operation completes successfully.
+ * @return -EINVAL if max_ports is out of range
+ */
+int
+mlag_max_ports_set(uint32_t max_ports)
+{
+    int err = 0;
+
+    if ((max_ports == 0) || (max_ports > MLAG_MAX_PORTS_LIMIT)) {
+        err = -EINVAL;
+        MLAG_BAIL_ERROR_MSG(err, "Invalid max ports %u, range is 1..%u\n",
+                            max_ports, MLAG_MAX_PORTS_LIMIT);
+    }
+
+    mlag_max_ports = max_ports;
+
+bail:
+    return err;
+}
+
+/**
+ *  This function returns the maximum number of mLAG ports
+ *
+ * @return maximum number of mLAG ports
+ */
+uint32_t
+mlag_max_ports_get(void)
+{
+    return mlag_max_ports;
+}
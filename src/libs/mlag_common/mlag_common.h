@@ -31,6 +31,8 @@
 #include <mlnx_lib/lib_event_disp.h>
 #include <complib/cl_map.h>
 #include <complib/cl_passivelock.h>
+#include <libs/mlag_common/mlag_latency.h>
+#include <libs/mlag_common/mlag_trace.h>
 
 /************************************************
  *  Defines
@@ -257,4 +259,25 @@ int get_command(cmd_db_handle_t *db_handle, int cmd_id,
 int
 dispatch_deinit_event(uint8_t *buffer);
 
+/**
+ *  This function sets the maximum number of mLAG ports. Port DBs,
+ *  port vectors and port message buffers are sized by it on init,
+ *  so it must be called before the mLAG modules are initialized.
+ *
+ * @param[in] max_ports - maximum number of mLAG ports
+ *
+ * @return 0 if operation completes successfully.
+ * @return -EINVAL if max_ports is out of range
+ */
+int
+mlag_max_ports_set(uint32_t max_ports);
+
+/**
+ *  This function returns the maximum number of mLAG ports
+ *
+ * @return maximum number of mLAG ports
+ */
+uint32_t
+mlag_max_ports_get(void);
+
 #endif /* MLAG_COMMON_H_ */
@@ -0,0 +1,340 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#include <errno.h>
+#include <string.h>
+#include <utils/mlag_log.h>
+#include <utils/mlag_bail.h>
+#include <utils/mlag_defs.h>
+#include "mlag_compress.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#undef  __MODULE__
+#define __MODULE__ MLAG_COMPRESS
+
+/* LZ4 block format limits */
+#define MIN_MATCH     4
+#define LAST_LITERALS 5  /* last bytes are always literals */
+#define MF_LIMIT      12 /* last match starts before this distance from end */
+#define MAX_OFFSET    65535
+#define RUN_MASK      15
+#define HASH_LOG      12
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+#define HASH(seq) (((seq) * 2654435761U) >> (32 - HASH_LOG))
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  Read 4 unaligned bytes
+ *
+ * @param[in] p - buffer
+ *
+ * @return value
+ */
+static inline uint32_t
+read32(const uint8_t *p)
+{
+    uint32_t val;
+
+    memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+/*
+ *  Write length continuation bytes of a token nibble
+ *
+ * @param[in,out] op - output position
+ * @param[in] oend - output end
+ * @param[in] len - length above RUN_MASK
+ *
+ * @return 0 when successful, -ENOSPC if output is full
+ */
+static int
+write_run(uint8_t **op, const uint8_t *oend, uint32_t len)
+{
+    for (; len >= 255; len -= 255) {
+        if (*op >= oend) {
+            return -ENOSPC;
+        }
+        *(*op)++ = 255;
+    }
+    if (*op >= oend) {
+        return -ENOSPC;
+    }
+    *(*op)++ = (uint8_t)len;
+    return 0;
+}
+
+/*
+ *  Write one sequence: literals optionally followed by a match
+ *
+ * @param[in,out] op - output position
+ * @param[in] oend - output end
+ * @param[in] lit - literals
+ * @param[in] lit_len - literals length
+ * @param[in] offset - match offset, 0 for last sequence
+ * @param[in] match_len - match length
+ *
+ * @return 0 when successful, -ENOSPC if output is full
+ */
+static int
+write_sequence(uint8_t **op, const uint8_t *oend, const uint8_t *lit,
+               uint32_t lit_len, uint32_t offset, uint32_t match_len)
+{
+    int err = 0;
+    uint8_t *token;
+    uint32_t ml = (offset) ? match_len - MIN_MATCH : 0;
+
+    if (*op >= oend) {
+        return -ENOSPC;
+    }
+    token = (*op)++;
+    *token = (uint8_t)(((lit_len < RUN_MASK) ? lit_len : RUN_MASK) << 4);
+    if (lit_len >= RUN_MASK) {
+        err = write_run(op, oend, lit_len - RUN_MASK);
+        if (err) {
+            return err;
+        }
+    }
+    if ((uint32_t)(oend - *op) < lit_len) {
+        return -ENOSPC;
+    }
+    memcpy(*op, lit, lit_len);
+    *op += lit_len;
+
+    if (offset == 0) {
+        return 0;
+    }
+
+    if (oend - *op < 2) {
+        return -ENOSPC;
+    }
+    *(*op)++ = (uint8_t)(offset & 0xFF);
+    *(*op)++ = (uint8_t)(offset >> 8);
+    *token |= (uint8_t)((ml < RUN_MASK) ? ml : RUN_MASK);
+    if (ml >= RUN_MASK) {
+        err = write_run(op, oend, ml - RUN_MASK);
+    }
+    return err;
+}
+
+/**
+ *  This function compresses a buffer as a single LZ4 block
+ *
+ * @param[in] src - data to compress
+ * @param[in] src_len - data length
+ * @param[out] dst - compressed block
+ * @param[in] dst_size - compressed block buffer size
+ * @param[out] dst_len - compressed block length
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOSPC if compressed block does not fit dst
+ */
+int
+mlag_compress(const uint8_t *src, uint32_t src_len,
+              uint8_t *dst, uint32_t dst_size, uint32_t *dst_len)
+{
+    int err = 0;
+    uint32_t table[1 << HASH_LOG];
+    uint32_t ip = 0;
+    uint32_t anchor = 0;
+    uint32_t ref;
+    uint32_t seq;
+    uint32_t h;
+    uint32_t match_len;
+    uint8_t *op = dst;
+    const uint8_t *oend = dst + dst_size;
+
+    memset(table, 0, sizeof(table));
+
+    if (src_len > MF_LIMIT) {
+        while (ip < src_len - MF_LIMIT) {
+            seq = read32(src + ip);
+            h = HASH(seq);
+            ref = table[h];
+            table[h] = ip;
+            if ((ref >= ip) || (ip - ref > MAX_OFFSET) ||
+                (read32(src + ref) != seq)) {
+                ip++;
+                continue;
+            }
+
+            match_len = MIN_MATCH;
+            while ((ip + match_len < src_len - LAST_LITERALS) &&
+                   (src[ref + match_len] == src[ip + match_len])) {
+                match_len++;
+            }
+
+            err = write_sequence(&op, oend, src + anchor, ip - anchor,
+                                 ip - ref, match_len);
+            if (err) {
+                goto bail;
+            }
+            ip += match_len;
+            anchor = ip;
+        }
+    }
+
+    err = write_sequence(&op, oend, src + anchor, src_len - anchor, 0, 0);
+    if (err) {
+        goto bail;
+    }
+    *dst_len = (uint32_t)(op - dst);
+
+bail:
+    return err;
+}
+
+/*
+ *  Read length continuation bytes of a token nibble
+ *
+ * @param[in] src - compressed block
+ * @param[in] src_len - compressed block length
+ * @param[in,out] ip - input position
+ * @param[in,out] len - length
+ *
+ * @return 0 when successful, -EPROTO if block is truncated
+ */
+static int
+read_run(const uint8_t *src, uint32_t src_len, uint32_t *ip, uint32_t *len)
+{
+    uint8_t byte;
+
+    do {
+        if ((*ip >= src_len) || (*len > MLAG_COMPRESS_MAX_LEN)) {
+            return -EPROTO;
+        }
+        byte = src[(*ip)++];
+        *len += byte;
+    } while (byte == 255);
+    return 0;
+}
+
+/**
+ *  This function decompresses a single LZ4 block
+ *
+ * @param[in] src - compressed block
+ * @param[in] src_len - compressed block length
+ * @param[out] dst - decompressed data
+ * @param[in] dst_len - expected decompressed length
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -EPROTO if block is malformed or length differs
+ */
+int
+mlag_decompress(const uint8_t *src, uint32_t src_len,
+                uint8_t *dst, uint32_t dst_len)
+{
+    int err = 0;
+    uint32_t ip = 0;
+    uint32_t op = 0;
+    uint32_t len;
+    uint32_t offset;
+    uint8_t token;
+
+    while (ip < src_len) {
+        token = src[ip++];
+
+        len = token >> 4;
+        if (len == RUN_MASK) {
+            err = read_run(src, src_len, &ip, &len);
+            MLAG_BAIL_ERROR_MSG(err, "Truncated literal length\n");
+        }
+        if ((len > src_len - ip) || (len > dst_len - op)) {
+            err = -EPROTO;
+            MLAG_BAIL_ERROR_MSG(err, "Literals [%u] overrun block\n", len);
+        }
+        memcpy(dst + op, src + ip, len);
+        ip += len;
+        op += len;
+
+        /* Last sequence has no match */
+        if (ip == src_len) {
+            break;
+        }
+
+        if (src_len - ip < 2) {
+            err = -EPROTO;
+            MLAG_BAIL_ERROR_MSG(err, "Truncated match offset\n");
+        }
+        offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        if ((offset == 0) || (offset > op)) {
+            err = -EPROTO;
+            MLAG_BAIL_ERROR_MSG(err, "Bad match offset [%u]\n", offset);
+        }
+
+        len = token & RUN_MASK;
+        if (len == RUN_MASK) {
+            err = read_run(src, src_len, &ip, &len);
+            MLAG_BAIL_ERROR_MSG(err, "Truncated match length\n");
+        }
+        len += MIN_MATCH;
+        if (len > dst_len - op) {
+            err = -EPROTO;
+            MLAG_BAIL_ERROR_MSG(err, "Match [%u] overruns output\n", len);
+        }
+        /* Match may overlap its own output */
+        for (; len > 0; len--, op++) {
+            dst[op] = dst[op - offset];
+        }
+    }
+
+    if (op != dst_len) {
+        err = -EPROTO;
+        MLAG_BAIL_ERROR_MSG(err, "Decompressed length [%u] expected [%u]\n",
+                            op, dst_len);
+    }
+
+bail:
+    return err;
+}
@@ -0,0 +1,95 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#ifndef MLAG_COMPRESS_H_
+#define MLAG_COMPRESS_H_
+
+#include <stdint.h>
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* Advertise and use compression of IPL messages.
+ * Compressed messages are always accepted. */
+#ifndef MLAG_IPL_COMPRESS
+#define MLAG_IPL_COMPRESS 0
+#endif
+
+/* Messages with shorter body are sent as is */
+#ifndef MLAG_COMPRESS_THRESHOLD
+#define MLAG_COMPRESS_THRESHOLD 1024
+#endif
+
+/* Largest decompressed body accepted */
+#define MLAG_COMPRESS_MAX_LEN (16 * 1024 * 1024)
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/* Worst case compressed length of incompressible data */
+#define MLAG_COMPRESS_BOUND(len) ((len) + ((len) / 255) + 16)
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ *  This function compresses a buffer as a single LZ4 block
+ *
+ * @param[in] src - data to compress
+ * @param[in] src_len - data length
+ * @param[out] dst - compressed block
+ * @param[in] dst_size - compressed block buffer size
+ * @param[out] dst_len - compressed block length
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOSPC if compressed block does not fit dst
+ */
+int mlag_compress(const uint8_t *src, uint32_t src_len,
+                  uint8_t *dst, uint32_t dst_size, uint32_t *dst_len);
+
+/**
+ *  This function decompresses a single LZ4 block
+ *
+ * @param[in] src - compressed block
+ * @param[in] src_len - compressed block length
+ * @param[out] dst - decompressed data
+ * @param[in] dst_len - expected decompressed length
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -EPROTO if block is malformed or length differs
+ */
+int mlag_decompress(const uint8_t *src, uint32_t src_len,
+                    uint8_t *dst, uint32_t dst_len);
+
+#endif /* MLAG_COMPRESS_H_ */
@@ -0,0 +1,304 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <string.h>
+#include <time.h>
+#include <utils/mlag_log.h>
+#include <utils/mlag_bail.h>
+#include <utils/mlag_defs.h>
+#include <utils/mlag_events.h>
+#include "mlag_latency.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#undef  __MODULE__
+#define __MODULE__ MLAG_LATENCY
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+
+static const char *latency_source_str[MLAG_EVENT_LATENCY_SOURCE_NUM] = {
+    "event",
+    "IPL",
+};
+
+/* Opcodes are unique, each one is handled by a single dispatcher */
+static struct mlag_event_latency
+    latency_db[MLAG_EVENT_LATENCY_SOURCE_NUM][MLAG_EVENTS_NUM];
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  This function returns the histogram bucket of a sample
+ *
+ * @param[in] usec - sample
+ *
+ * @return bucket index
+ */
+static inline int
+latency_bucket(uint64_t usec)
+{
+    int bucket;
+
+    if (usec == 0) {
+        return 0;
+    }
+    bucket = 64 - __builtin_clzll(usec);
+    return (bucket < MLAG_EVENT_LATENCY_BUCKETS) ?
+           bucket : (MLAG_EVENT_LATENCY_BUCKETS - 1);
+}
+
+/*
+ *  This function raises a maximum, concurrent callers keep the
+ *  largest sample
+ *
+ * @param[in,out] max - maximum
+ * @param[in] usec - sample
+ *
+ * @return void
+ */
+static inline void
+latency_max_set(unsigned long long *max, uint64_t usec)
+{
+    unsigned long long cur = *max;
+
+    while ((usec > cur) &&
+           !__sync_bool_compare_and_swap(max, cur, usec)) {
+        cur = *max;
+    }
+}
+
+/*
+ *  This function returns the upper bound of the bucket holding the
+ *  given percentile of a histogram
+ *
+ * @param[in] hist - histogram
+ * @param[in] count - samples in histogram
+ * @param[in] percent - percentile
+ *
+ * @return bucket upper bound in usec
+ */
+static unsigned long long
+latency_percentile(const unsigned long long *hist, unsigned long long count,
+                   unsigned int percent)
+{
+    int i;
+    unsigned long long sum = 0;
+    unsigned long long target = (count * percent + 99) / 100;
+
+    for (i = 0; i < MLAG_EVENT_LATENCY_BUCKETS - 1; i++) {
+        sum += hist[i];
+        if (sum >= target) {
+            break;
+        }
+    }
+    return 1ULL << i;
+}
+
+/**
+ *  This function returns the monotonic time system events are
+ *  stamped with
+ *
+ * @return time in microseconds
+ */
+uint64_t
+mlag_latency_mono_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+/**
+ *  This function returns the wall clock time IPL messages are stamped
+ *  with, peers compare it to their own clock
+ *
+ * @return time in microseconds
+ */
+uint64_t
+mlag_latency_wall_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+/**
+ *  This function records the latency of a dispatched command. It takes
+ *  no lock and may be called by all dispatchers.
+ *
+ * @param[in] source - command source
+ * @param[in] opcode - command opcode
+ * @param[in] queue_usec - time from enqueue until handler start
+ * @param[in] handler_usec - handler run time
+ *
+ * @return void
+ */
+void
+mlag_latency_record(enum mlag_event_latency_source source,
+                    uint16_t opcode, uint64_t queue_usec,
+                    uint64_t handler_usec)
+{
+    struct mlag_event_latency *latency;
+
+    if ((source >= MLAG_EVENT_LATENCY_SOURCE_NUM) ||
+        (opcode >= MLAG_EVENTS_NUM)) {
+        return;
+    }
+    latency = &latency_db[source][opcode];
+
+    __sync_fetch_and_add(&latency->count, 1);
+    __sync_fetch_and_add(&latency->queue_hist[latency_bucket(queue_usec)], 1);
+    __sync_fetch_and_add(
+        &latency->handler_hist[latency_bucket(handler_usec)], 1);
+    latency_max_set(&latency->queue_max_usec, queue_usec);
+    latency_max_set(&latency->handler_max_usec, handler_usec);
+}
+
+/**
+ *  This function gets the latency of the opcodes dispatched so far,
+ *  ordered by source and opcode
+ *
+ * @param[in] start - number of leading entries to skip
+ * @param[out] latency_list - latency per opcode and source
+ * @param[in,out] latency_cnt - list size, on return the number of
+ *                              entries filled
+ *
+ * @return void
+ */
+void
+mlag_latency_get(unsigned int start, struct mlag_event_latency *latency_list,
+                 unsigned int *latency_cnt)
+{
+    int source, opcode;
+    unsigned int cnt = 0;
+
+    for (source = 0; source < MLAG_EVENT_LATENCY_SOURCE_NUM; source++) {
+        for (opcode = 0; opcode < MLAG_EVENTS_NUM; opcode++) {
+            if (latency_db[source][opcode].count == 0) {
+                continue;
+            }
+            if (start > 0) {
+                start--;
+                continue;
+            }
+            if (cnt == *latency_cnt) {
+                goto out;
+            }
+            latency_list[cnt] = latency_db[source][opcode];
+            latency_list[cnt].opcode = opcode;
+            latency_list[cnt].source = source;
+            cnt++;
+        }
+    }
+
+out:
+    *latency_cnt = cnt;
+}
+
+/**
+ *  This function clears the latency histograms
+ *
+ * @return void
+ */
+void
+mlag_latency_clear(void)
+{
+    memset(latency_db, 0, sizeof(latency_db));
+}
+
+/**
+ *  This function dumps the latency of the opcodes dispatched so far
+ *
+ * @param[in] dump_cb - callback for dumping, if NULL, log will be used
+ *
+ * @return void
+ */
+void
+mlag_latency_dump(void (*dump_cb)(const char *, ...))
+{
+    int source, opcode;
+    struct mlag_event_latency *latency;
+
+    DUMP_OR_LOG("=================\nDispatcher latency\n"
+                "=================\n");
+    if (!MLAG_EVENT_LATENCY) {
+        DUMP_OR_LOG("Not measured, build with --enable-event-latency\n");
+        return;
+    }
+    DUMP_OR_LOG("%-6s %-6s %-10s %-28s %-28s\n", "source", "opcode",
+                "count", "queue usec p50/p99/max",
+                "handler usec p50/p99/max");
+    for (source = 0; source < MLAG_EVENT_LATENCY_SOURCE_NUM; source++) {
+        for (opcode = 0; opcode < MLAG_EVENTS_NUM; opcode++) {
+            latency = &latency_db[source][opcode];
+            if (latency->count == 0) {
+                continue;
+            }
+            DUMP_OR_LOG("%-6s %-6d %-10llu %8llu %8llu %10llu "
+                        "%8llu %8llu %10llu\n",
+                        latency_source_str[source], opcode, latency->count,
+                        latency_percentile(latency->queue_hist,
+                                           latency->count, 50),
+                        latency_percentile(latency->queue_hist,
+                                           latency->count, 99),
+                        latency->queue_max_usec,
+                        latency_percentile(latency->handler_hist,
+                                           latency->count, 50),
+                        latency_percentile(latency->handler_hist,
+                                           latency->count, 99),
+                        latency->handler_max_usec);
+        }
+    }
+    DUMP_OR_LOG("Percentiles are bucket upper bounds, IPL queue delay "
+                "includes the peers clock offset\n");
+}
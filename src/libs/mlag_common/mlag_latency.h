@@ -0,0 +1,131 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef MLAG_LATENCY_H_
+#define MLAG_LATENCY_H_
+
+#include <stdint.h>
+#include <mlag_api_defs.h>
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* Queue delay and handler time of dispatched commands are measured.
+ * When not set, events and IPL messages carry no stamp and the
+ * measurement is compiled out. */
+#ifndef MLAG_EVENT_LATENCY
+#define MLAG_EVENT_LATENCY 0
+#endif
+
+/* Stamp prepended to system events */
+#if MLAG_EVENT_LATENCY
+#define MLAG_EVENT_STAMP_SIZE (sizeof(struct mlag_event_stamp))
+#else
+#define MLAG_EVENT_STAMP_SIZE 0
+#endif
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+struct mlag_event_stamp {
+    uint64_t enqueue_usec; /* monotonic */
+};
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ *  This function returns the monotonic time system events are
+ *  stamped with
+ *
+ * @return time in microseconds
+ */
+uint64_t mlag_latency_mono_usec(void);
+
+/**
+ *  This function returns the wall clock time IPL messages are stamped
+ *  with, peers compare it to their own clock
+ *
+ * @return time in microseconds
+ */
+uint64_t mlag_latency_wall_usec(void);
+
+/**
+ *  This function records the latency of a dispatched command. It takes
+ *  no lock and may be called by all dispatchers.
+ *
+ * @param[in] source - command source
+ * @param[in] opcode - command opcode
+ * @param[in] queue_usec - time from enqueue until handler start
+ * @param[in] handler_usec - handler run time
+ *
+ * @return void
+ */
+void mlag_latency_record(enum mlag_event_latency_source source,
+                         uint16_t opcode, uint64_t queue_usec,
+                         uint64_t handler_usec);
+
+/**
+ *  This function gets the latency of the opcodes dispatched so far,
+ *  ordered by source and opcode
+ *
+ * @param[in] start - number of leading entries to skip
+ * @param[out] latency_list - latency per opcode and source
+ * @param[in,out] latency_cnt - list size, on return the number of
+ *                              entries filled
+ *
+ * @return void
+ */
+void mlag_latency_get(unsigned int start,
+                      struct mlag_event_latency *latency_list,
+                      unsigned int *latency_cnt);
+
+/**
+ *  This function clears the latency histograms
+ *
+ * @return void
+ */
+void mlag_latency_clear(void);
+
+/**
+ *  This function dumps the latency of the opcodes dispatched so far
+ *
+ * @param[in] dump_cb - callback for dumping, if NULL, log will be used
+ *
+ * @return void
+ */
+void mlag_latency_dump(void (*dump_cb)(const char *, ...));
+
+#endif /* MLAG_LATENCY_H_ */
@@ -0,0 +1,365 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#define MLAG_LOCK_PROF_C_
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <utils/mlag_log.h>
+#include <utils/mlag_bail.h>
+#include <utils/mlag_defs.h>
+#include "mlag_lock_prof.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#undef  __MODULE__
+#define __MODULE__ MLAG_LOCK_PROF
+
+/* Call sites dumped, most waited first */
+#define LOCK_PROF_DUMP_MAX 256
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+/* Lock held by the calling thread */
+struct held_lock {
+    void *lock;
+    struct mlag_lock_site *site;
+    uint64_t start_nsec;
+};
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+
+/* Registered call sites, sites are only added */
+static struct mlag_lock_site *volatile lock_sites = NULL;
+
+static __thread struct held_lock held_locks[MLAG_LOCK_PROF_HELD_MAX];
+static __thread int held_num = 0;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  This function returns the monotonic time
+ *
+ * @return time in nanoseconds
+ */
+static uint64_t
+lock_prof_nsec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+/*
+ *  This function adds a call site to the registered sites, once
+ *
+ * @param[in] site - call site
+ *
+ * @return void
+ */
+static void
+site_register(struct mlag_lock_site *site)
+{
+    struct mlag_lock_site *head;
+
+    if (site->registered ||
+        !__sync_bool_compare_and_swap(&site->registered, 0, 1)) {
+        return;
+    }
+    do {
+        head = lock_sites;
+        site->next = head;
+    } while (!__sync_bool_compare_and_swap(&lock_sites, head, site));
+}
+
+/*
+ *  This function accounts an acquisition and starts timing the hold
+ *
+ * @param[in] lock - acquired lock
+ * @param[in] site - call site
+ * @param[in] wait_nsec - time waited for the lock
+ * @param[in] contended - TRUE if the lock was held by another thread
+ *
+ * @return void
+ */
+static void
+lock_acquired(void *lock, struct mlag_lock_site *site, uint64_t wait_nsec,
+              int contended)
+{
+    site_register(site);
+    __sync_fetch_and_add(&site->acquired, 1);
+    if (contended) {
+        __sync_fetch_and_add(&site->contended, 1);
+    }
+    __sync_fetch_and_add(&site->wait_nsec, wait_nsec);
+
+    if (held_num < MLAG_LOCK_PROF_HELD_MAX) {
+        held_locks[held_num].lock = lock;
+        held_locks[held_num].site = site;
+        held_locks[held_num].start_nsec = lock_prof_nsec();
+        held_num++;
+    }
+}
+
+/*
+ *  This function ends timing the hold of a lock, locks may be
+ *  released in any order
+ *
+ * @param[in] lock - released lock
+ * @param[in] end_nsec - release time
+ *
+ * @return void
+ */
+static void
+lock_released(void *lock, uint64_t end_nsec)
+{
+    struct mlag_lock_site *site;
+    uint64_t hold_nsec;
+    uint64_t max;
+    int i;
+
+    for (i = held_num - 1; i >= 0; i--) {
+        if (held_locks[i].lock == lock) {
+            break;
+        }
+    }
+    if (i < 0) {
+        return;
+    }
+    site = held_locks[i].site;
+    hold_nsec = end_nsec - held_locks[i].start_nsec;
+    memmove(&held_locks[i], &held_locks[i + 1],
+            (held_num - i - 1) * sizeof(held_locks[0]));
+    held_num--;
+
+    max = site->hold_max_nsec;
+    while ((hold_nsec > max) &&
+           !__sync_bool_compare_and_swap(&site->hold_max_nsec, max,
+                                         hold_nsec)) {
+        max = site->hold_max_nsec;
+    }
+}
+
+/**
+ *  This function acquires a passive lock and profiles the acquisition
+ *
+ * @param[in] lock - passive lock
+ * @param[in] site - call site, acquired exclusively if site is exclusive
+ *
+ * @return void
+ */
+void
+mlag_lock_prof_plock_acquire(cl_plock_t *lock, struct mlag_lock_site *site)
+{
+    uint64_t start = lock_prof_nsec();
+    uint64_t wait_nsec;
+
+    if (site->exclusive) {
+        cl_plock_excl_acquire(lock);
+    }
+    else {
+        cl_plock_acquire(lock);
+    }
+    wait_nsec = lock_prof_nsec() - start;
+    lock_acquired(lock, site, wait_nsec,
+                  (wait_nsec >= MLAG_LOCK_PROF_CONTENDED_NSEC));
+}
+
+/**
+ *  This function releases a passive lock and accounts its hold time
+ *
+ * @param[in] lock - passive lock
+ *
+ * @return void
+ */
+void
+mlag_lock_prof_plock_release(cl_plock_t *lock)
+{
+    uint64_t end = lock_prof_nsec();
+
+    cl_plock_release(lock);
+    lock_released(lock, end);
+}
+
+/**
+ *  This function locks a mutex and profiles the acquisition
+ *
+ * @param[in] mutex - mutex
+ * @param[in] site - call site
+ *
+ * @return pthread_mutex_lock return value
+ */
+int
+mlag_lock_prof_mutex_lock(pthread_mutex_t *mutex, struct mlag_lock_site *site)
+{
+    uint64_t start = lock_prof_nsec();
+    int contended = 0;
+    int err;
+
+    err = pthread_mutex_trylock(mutex);
+    if (err == EBUSY) {
+        contended = 1;
+        err = pthread_mutex_lock(mutex);
+    }
+    if (err == 0) {
+        lock_acquired(mutex, site, lock_prof_nsec() - start, contended);
+    }
+    return err;
+}
+
+/**
+ *  This function unlocks a mutex and accounts its hold time
+ *
+ * @param[in] mutex - mutex
+ *
+ * @return pthread_mutex_unlock return value
+ */
+int
+mlag_lock_prof_mutex_unlock(pthread_mutex_t *mutex)
+{
+    uint64_t end = lock_prof_nsec();
+    int err;
+
+    err = pthread_mutex_unlock(mutex);
+    if (err == 0) {
+        lock_released(mutex, end);
+    }
+    return err;
+}
+
+/**
+ *  This function clears the profile of all call sites
+ *
+ * @return void
+ */
+void
+mlag_lock_prof_clear(void)
+{
+    struct mlag_lock_site *site;
+
+    for (site = lock_sites; site != NULL; site = site->next) {
+        site->acquired = 0;
+        site->contended = 0;
+        site->wait_nsec = 0;
+        site->hold_max_nsec = 0;
+    }
+}
+
+/*
+ *  This function orders call sites by descending wait time
+ *
+ * @param[in] a - call site
+ * @param[in] b - call site
+ *
+ * @return qsort order
+ */
+static int
+site_wait_cmp(const void *a, const void *b)
+{
+    const struct mlag_lock_site *site_a =
+        *(const struct mlag_lock_site * const *)a;
+    const struct mlag_lock_site *site_b =
+        *(const struct mlag_lock_site * const *)b;
+
+    if (site_a->wait_nsec == site_b->wait_nsec) {
+        return 0;
+    }
+    return (site_a->wait_nsec < site_b->wait_nsec) ? 1 : -1;
+}
+
+/**
+ *  This function dumps the profiled call sites, most waited first
+ *
+ * @param[in] dump_cb - callback for dumping, if NULL, log will be used
+ *
+ * @return void
+ */
+void
+mlag_lock_prof_dump(void (*dump_cb)(const char *, ...))
+{
+    static struct mlag_lock_site *dump_sites[LOCK_PROF_DUMP_MAX];
+    struct mlag_lock_site *site;
+    const char *file;
+    int num = 0;
+    int i;
+
+    DUMP_OR_LOG("=================\nLock contention\n"
+                "=================\n");
+    if (!MLAG_LOCK_PROFILE) {
+        DUMP_OR_LOG("Not measured, build with --enable-lock-profile\n");
+        return;
+    }
+
+    for (site = lock_sites; (site != NULL) && (num < LOCK_PROF_DUMP_MAX);
+         site = site->next) {
+        dump_sites[num++] = site;
+    }
+    qsort(dump_sites, num, sizeof(dump_sites[0]), site_wait_cmp);
+
+    DUMP_OR_LOG("%-28s %-36s %-6s %-10s %-10s %-12s %-10s\n", "site",
+                "lock", "mode", "acquired", "contended", "wait usec",
+                "max hold usec");
+    for (i = 0; i < num; i++) {
+        site = dump_sites[i];
+        file = strrchr(site->file, '/');
+        file = (file != NULL) ? (file + 1) : site->file;
+        DUMP_OR_LOG("%-22s:%-5d %-36s %-6s %-10llu %-10llu %-12llu "
+                    "%-10llu\n", file, site->line, site->lock_name,
+                    site->exclusive ? "excl" : "shared",
+                    (unsigned long long)site->acquired,
+                    (unsigned long long)site->contended,
+                    (unsigned long long)(site->wait_nsec / 1000),
+                    (unsigned long long)(site->hold_max_nsec / 1000));
+    }
+    DUMP_OR_LOG("Passive lock waits of %u nsec or more count as "
+                "contended\n", MLAG_LOCK_PROF_CONTENDED_NSEC);
+}
@@ -0,0 +1,162 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef MLAG_LOCK_PROF_H_
+#define MLAG_LOCK_PROF_H_
+
+/* Locks are redefined below, so their declarations come first */
+#include <stdint.h>
+#include <pthread.h>
+#include <complib/cl_passivelock.h>
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* Locks of the files including this header are profiled per call
+ * site. When not set, locks are used as is. */
+#ifndef MLAG_LOCK_PROFILE
+#define MLAG_LOCK_PROFILE 0
+#endif
+
+/* Passive locks have no try operation, a wait at least this long
+ * counts as contended */
+#define MLAG_LOCK_PROF_CONTENDED_NSEC 1000
+
+/* Locks a thread may hold at the same time, holds beyond are not
+ * timed */
+#define MLAG_LOCK_PROF_HELD_MAX       8
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+#if MLAG_LOCK_PROFILE && !defined(MLAG_LOCK_PROF_C_)
+
+/* Call site, registered on first acquisition */
+#define MLAG_LOCK_SITE(lock, exclusive)                               \
+    ({ static struct mlag_lock_site site_ =                           \
+       { __FILE__, __LINE__, #lock, exclusive, NULL, 0, 0, 0, 0, 0 }; \
+       &site_; })
+
+#define cl_plock_acquire(lock) \
+    mlag_lock_prof_plock_acquire((lock), MLAG_LOCK_SITE(lock, 0))
+#define cl_plock_excl_acquire(lock) \
+    mlag_lock_prof_plock_acquire((lock), MLAG_LOCK_SITE(lock, 1))
+#define cl_plock_release(lock) \
+    mlag_lock_prof_plock_release(lock)
+#define pthread_mutex_lock(mutex) \
+    mlag_lock_prof_mutex_lock((mutex), MLAG_LOCK_SITE(mutex, 1))
+#define pthread_mutex_unlock(mutex) \
+    mlag_lock_prof_mutex_unlock(mutex)
+
+#endif
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+/**
+ * mlag_lock_site struct holds the profile of the acquisitions of a
+ * lock at one call site. Hold time is accounted to the site the lock
+ * was acquired at.
+ */
+struct mlag_lock_site {
+    const char *file;
+    int line;
+    const char *lock_name;
+    int exclusive;
+    struct mlag_lock_site *next;
+    volatile int registered;
+    uint64_t acquired;
+    uint64_t contended;
+    uint64_t wait_nsec;
+    uint64_t hold_max_nsec;
+};
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ *  This function acquires a passive lock and profiles the acquisition
+ *
+ * @param[in] lock - passive lock
+ * @param[in] site - call site, acquired exclusively if site is exclusive
+ *
+ * @return void
+ */
+void mlag_lock_prof_plock_acquire(cl_plock_t *lock,
+                                  struct mlag_lock_site *site);
+
+/**
+ *  This function releases a passive lock and accounts its hold time
+ *
+ * @param[in] lock - passive lock
+ *
+ * @return void
+ */
+void mlag_lock_prof_plock_release(cl_plock_t *lock);
+
+/**
+ *  This function locks a mutex and profiles the acquisition
+ *
+ * @param[in] mutex - mutex
+ * @param[in] site - call site
+ *
+ * @return pthread_mutex_lock return value
+ */
+int mlag_lock_prof_mutex_lock(pthread_mutex_t *mutex,
+                              struct mlag_lock_site *site);
+
+/**
+ *  This function unlocks a mutex and accounts its hold time
+ *
+ * @param[in] mutex - mutex
+ *
+ * @return pthread_mutex_unlock return value
+ */
+int mlag_lock_prof_mutex_unlock(pthread_mutex_t *mutex);
+
+/**
+ *  This function clears the profile of all call sites
+ *
+ * @return void
+ */
+void mlag_lock_prof_clear(void);
+
+/**
+ *  This function dumps the profiled call sites, most waited first
+ *
+ * @param[in] dump_cb - callback for dumping, if NULL, log will be used
+ *
+ * @return void
+ */
+void mlag_lock_prof_dump(void (*dump_cb)(const char *, ...));
+
+#endif /* MLAG_LOCK_PROF_H_ */
@@ -0,0 +1,277 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <complib/cl_mem.h>
+#include <utils/mlag_log.h>
+#include <utils/mlag_bail.h>
+#include <utils/mlag_defs.h>
+#include "mlag_state_publisher.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#undef  __MODULE__
+#define __MODULE__ MLAG_STATE_PUBLISHER
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+
+static struct mlag_snapshot *snapshot = NULL;
+/* state is collected here, and copied to the snapshot under seqlock */
+static struct mlag_snapshot_state *staging = NULL;
+static mlag_state_collect_func collect_func = NULL;
+
+static pthread_t publisher_thread;
+static pthread_mutex_t publisher_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t publisher_cond = PTHREAD_COND_INITIALIZER;
+static int publisher_changed = FALSE;
+static int publisher_stop = FALSE;
+static int publisher_running = FALSE;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  This function copies the staged state to the snapshot. Readers
+ *  retry while seq is odd or changed during their copy.
+ *
+ * @return void
+ */
+static void
+snapshot_publish(void)
+{
+    unsigned int ports_num = staging->ports_num;
+
+    if (ports_num > MLAG_SNAPSHOT_MAX_PORTS) {
+        ports_num = MLAG_SNAPSHOT_MAX_PORTS;
+    }
+    staging->publish_count = snapshot->state.publish_count + 1;
+
+    snapshot->seq++;
+    __sync_synchronize();
+    memcpy(&snapshot->state, staging,
+           offsetof(struct mlag_snapshot_state, ports));
+    snapshot->state.ports_num = ports_num;
+    memcpy(snapshot->state.ports, staging->ports,
+           ports_num * sizeof(staging->ports[0]));
+    __sync_synchronize();
+    snapshot->seq++;
+}
+
+/*
+ *  This function collects and publishes the state on each change and
+ *  at least once a period
+ *
+ * @param[in] data - unused
+ *
+ * @return NULL
+ */
+static void *
+publisher_thread_func(void *data)
+{
+    int err;
+    struct timespec deadline;
+
+    UNUSED_PARAM(data);
+
+    pthread_mutex_lock(&publisher_mutex);
+    while (!publisher_stop) {
+        if (!publisher_changed) {
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += MLAG_STATE_PUBLISH_PERIOD_MSEC / 1000;
+            deadline.tv_nsec +=
+                (MLAG_STATE_PUBLISH_PERIOD_MSEC % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&publisher_cond, &publisher_mutex,
+                                   &deadline);
+            if (publisher_stop) {
+                break;
+            }
+        }
+        publisher_changed = FALSE;
+        pthread_mutex_unlock(&publisher_mutex);
+
+        memset(staging, 0, offsetof(struct mlag_snapshot_state, ports));
+        staging->ports_num = MLAG_SNAPSHOT_MAX_PORTS;
+        err = collect_func(staging);
+        if (err) {
+            MLAG_LOG(MLAG_LOG_DEBUG, "State collection failed, err %d\n",
+                     err);
+        }
+        else {
+            snapshot_publish();
+        }
+
+        pthread_mutex_lock(&publisher_mutex);
+    }
+    pthread_mutex_unlock(&publisher_mutex);
+
+    return NULL;
+}
+
+/**
+ *  This function creates the snapshot shared memory region and starts
+ *  the publisher thread. The state is collected in this thread, so
+ *  monitoring readers never reach the control plane.
+ *
+ * @param[in] collect - state collection function
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+mlag_state_publisher_init(mlag_state_collect_func collect)
+{
+    int err = 0;
+    int fd = -1;
+    void *shm = MAP_FAILED;
+
+    ASSERT(collect != NULL);
+
+    staging = (struct mlag_snapshot_state *)cl_malloc(sizeof(*staging));
+    if (staging == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate state staging\n");
+    }
+
+    fd = shm_open(MLAG_SNAPSHOT_SHM_NAME, O_RDWR | O_CREAT | O_TRUNC,
+                  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to create state snapshot\n");
+    }
+    if (ftruncate(fd, sizeof(struct mlag_snapshot)) < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to size state snapshot\n");
+    }
+    shm = mmap(NULL, sizeof(struct mlag_snapshot), PROT_READ | PROT_WRITE,
+               MAP_SHARED, fd, 0);
+    if (shm == MAP_FAILED) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to map state snapshot\n");
+    }
+    snapshot = (struct mlag_snapshot *)shm;
+    snapshot->magic = MLAG_SNAPSHOT_MAGIC;
+    snapshot->version = MLAG_SNAPSHOT_VERSION;
+    /* seq 0 tells readers nothing was published yet */
+    snapshot->seq = 0;
+
+    collect_func = collect;
+    publisher_stop = FALSE;
+    publisher_changed = TRUE;
+    if (pthread_create(&publisher_thread, NULL, publisher_thread_func,
+                       NULL) != 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to start state publisher\n");
+    }
+    publisher_running = TRUE;
+
+bail:
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (err) {
+        mlag_state_publisher_deinit();
+    }
+    return err;
+}
+
+/**
+ *  This function stops the publisher thread and removes the snapshot
+ *
+ * @return void
+ */
+void
+mlag_state_publisher_deinit(void)
+{
+    if (publisher_running) {
+        pthread_mutex_lock(&publisher_mutex);
+        publisher_stop = TRUE;
+        pthread_cond_signal(&publisher_cond);
+        pthread_mutex_unlock(&publisher_mutex);
+        pthread_join(publisher_thread, NULL);
+        publisher_running = FALSE;
+    }
+    if (snapshot != NULL) {
+        munmap(snapshot, sizeof(struct mlag_snapshot));
+        snapshot = NULL;
+        shm_unlink(MLAG_SNAPSHOT_SHM_NAME);
+    }
+    if (staging != NULL) {
+        cl_free(staging);
+        staging = NULL;
+    }
+}
+
+/**
+ *  This function notifies the publisher that state changed, the
+ *  snapshot is refreshed right away instead of on the next period.
+ *  It does not block, and may be called with module locks taken.
+ *
+ * @return void
+ */
+void
+mlag_state_publisher_changed(void)
+{
+    pthread_mutex_lock(&publisher_mutex);
+    if (!publisher_changed) {
+        publisher_changed = TRUE;
+        pthread_cond_signal(&publisher_cond);
+    }
+    pthread_mutex_unlock(&publisher_mutex);
+}
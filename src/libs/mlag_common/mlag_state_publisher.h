@@ -0,0 +1,84 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MLAG_STATE_PUBLISHER_H_
+#define MLAG_STATE_PUBLISHER_H_
+
+#include <mlag_snapshot.h>
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* State is published at least this often, and on every change */
+#ifndef MLAG_STATE_PUBLISH_PERIOD_MSEC
+#define MLAG_STATE_PUBLISH_PERIOD_MSEC 1000
+#endif
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+/* Collects the state to publish */
+typedef int (*mlag_state_collect_func)(struct mlag_snapshot_state *state);
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ *  This function creates the snapshot shared memory region and starts
+ *  the publisher thread. The state is collected in this thread, so
+ *  monitoring readers never reach the control plane.
+ *
+ * @param[in] collect - state collection function
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int mlag_state_publisher_init(mlag_state_collect_func collect);
+
+/**
+ *  This function stops the publisher thread and removes the snapshot
+ *
+ * @return void
+ */
+void mlag_state_publisher_deinit(void);
+
+/**
+ *  This function notifies the publisher that state changed, the
+ *  snapshot is refreshed right away instead of on the next period.
+ *  It does not block, and may be called with module locks taken.
+ *
+ * @return void
+ */
+void mlag_state_publisher_changed(void);
+
+#endif /* MLAG_STATE_PUBLISHER_H_ */
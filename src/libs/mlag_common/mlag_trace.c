@@ -0,0 +1,231 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <complib/cl_mem.h>
+#include <utils/mlag_log.h>
+#include <utils/mlag_bail.h>
+#include <utils/mlag_defs.h>
+#include "mlag_trace.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#undef  __MODULE__
+#define __MODULE__ MLAG_TRACE
+
+#define TRACE_MSG_LEN 256
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+struct trace_entry {
+    const struct mlag_trace_fmt *fmt;
+    uint64_t nsec;
+    uint64_t args[MLAG_TRACE_ARGS_MAX];
+};
+
+/* Ring of a thread, written by its thread only */
+struct trace_ring {
+    struct trace_ring *next;
+    int tid;
+    volatile uint64_t head;
+    struct trace_entry entries[MLAG_TRACE_RING_SIZE];
+};
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+
+static const char *trace_level_str[] = {
+    "", "NOTICE", "INFO", "DEBUG",
+};
+
+/* Rings of all threads, rings are only added */
+static struct trace_ring *volatile trace_rings = NULL;
+static __thread struct trace_ring *thread_ring = NULL;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  This function allocates the ring of the calling thread
+ *
+ * @return ring, NULL if out of memory
+ */
+static struct trace_ring *
+trace_ring_create(void)
+{
+    struct trace_ring *ring;
+
+    ring = (struct trace_ring *)cl_malloc(sizeof(*ring));
+    if (ring == NULL) {
+        return NULL;
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->tid = (int)syscall(SYS_gettid);
+
+    do {
+        ring->next = trace_rings;
+    } while (!__sync_bool_compare_and_swap(&trace_rings, ring->next, ring));
+
+    thread_ring = ring;
+    return ring;
+}
+
+/**
+ *  This function records a trace point in the ring of the calling
+ *  thread, the ring is allocated on first use. Oldest entries are
+ *  overwritten. It takes no lock.
+ *
+ * @param[in] fmt - trace point format
+ * @param[in] args - MLAG_TRACE_ARGS_MAX arguments
+ *
+ * @return void
+ */
+void
+mlag_trace_write(const struct mlag_trace_fmt *fmt, const uint64_t *args)
+{
+    struct trace_ring *ring = thread_ring;
+    struct trace_entry *entry;
+    struct timespec ts;
+
+    if (ring == NULL) {
+        ring = trace_ring_create();
+        if (ring == NULL) {
+            return;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    entry = &ring->entries[ring->head & (MLAG_TRACE_RING_SIZE - 1)];
+    entry->fmt = fmt;
+    entry->nsec = ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+    memcpy(entry->args, args, sizeof(entry->args));
+
+    /* Entry is complete before it is published */
+    __sync_synchronize();
+    ring->head++;
+}
+
+/*
+ *  This function dumps the ring of a thread. Entries are copied
+ *  first, those the thread may have overwritten meanwhile are skipped.
+ *
+ * @param[in] ring - thread ring
+ * @param[in] copy - buffer of MLAG_TRACE_RING_SIZE entries
+ * @param[in] dump_cb - callback for dumping, if NULL, log will be used
+ *
+ * @return void
+ */
+static void
+trace_ring_dump(struct trace_ring *ring, struct trace_entry *copy,
+                void (*dump_cb)(const char *, ...))
+{
+    char msg[TRACE_MSG_LEN];
+    struct trace_entry *entry;
+    uint64_t head, base, first, idx;
+
+    head = ring->head;
+    __sync_synchronize();
+    base = (head > MLAG_TRACE_RING_SIZE) ? (head - MLAG_TRACE_RING_SIZE) : 0;
+    for (idx = base; idx < head; idx++) {
+        copy[idx - base] = ring->entries[idx & (MLAG_TRACE_RING_SIZE - 1)];
+    }
+    __sync_synchronize();
+
+    /* Slot of index ring->head - size may be under write */
+    first = base;
+    if (ring->head + 1 > base + MLAG_TRACE_RING_SIZE) {
+        first = ring->head + 1 - MLAG_TRACE_RING_SIZE;
+    }
+
+    DUMP_OR_LOG("Thread %d, %llu trace points\n", ring->tid,
+                (unsigned long long)head);
+    for (idx = first; idx < head; idx++) {
+        entry = &copy[idx - base];
+        snprintf(msg, sizeof(msg), entry->fmt->fmt,
+                 (unsigned long long)entry->args[0],
+                 (unsigned long long)entry->args[1],
+                 (unsigned long long)entry->args[2],
+                 (unsigned long long)entry->args[3]);
+        DUMP_OR_LOG("%llu.%09llu %-6s %s[%d]- %s: %s\n",
+                    (unsigned long long)(entry->nsec / 1000000000),
+                    (unsigned long long)(entry->nsec % 1000000000),
+                    trace_level_str[entry->fmt->level], entry->fmt->module,
+                    entry->fmt->line, entry->fmt->func, msg);
+    }
+}
+
+/**
+ *  This function decodes and dumps the rings of all threads, oldest
+ *  entries first
+ *
+ * @param[in] dump_cb - callback for dumping, if NULL, log will be used
+ *
+ * @return void
+ */
+void
+mlag_trace_dump(void (*dump_cb)(const char *, ...))
+{
+    struct trace_ring *ring;
+    struct trace_entry *copy;
+
+    DUMP_OR_LOG("=================\nTrace\n=================\n");
+
+    copy = (struct trace_entry *)cl_malloc(MLAG_TRACE_RING_SIZE *
+                                           sizeof(*copy));
+    if (copy == NULL) {
+        DUMP_OR_LOG("Failed to allocate trace dump buffer\n");
+        return;
+    }
+    for (ring = trace_rings; ring != NULL; ring = ring->next) {
+        trace_ring_dump(ring, copy, dump_cb);
+    }
+    cl_free(copy);
+}
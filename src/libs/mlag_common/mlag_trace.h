@@ -0,0 +1,117 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef MLAG_TRACE_H_
+#define MLAG_TRACE_H_
+
+#include <stdint.h>
+#include <utils/mlag_log.h>
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* Trace levels */
+#define MLAG_TRACE_NOTICE    1
+#define MLAG_TRACE_INFO      2
+#define MLAG_TRACE_DEBUG     3
+
+/* Trace points of higher levels are compiled out */
+#ifndef MLAG_TRACE_LEVEL_MAX
+#define MLAG_TRACE_LEVEL_MAX MLAG_TRACE_DEBUG
+#endif
+
+#define MLAG_TRACE_ARGS_MAX  4
+/* Trace entries kept per thread, a power of 2 */
+#define MLAG_TRACE_RING_SIZE 4096
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/* Records a trace point in the ring of the calling thread. Only the
+ * format descriptor and up to MLAG_TRACE_ARGS_MAX integer arguments
+ * are stored, formatting is done when the rings are dumped. The format
+ * must use 64 bit conversions only (%llu, %lld, %llx).
+ * Arguments are converted to uint64_t: signed ones keep their value
+ * when printed with %lld only, pointers must be cast to uintptr_t and
+ * printed with %llx.
+ */
+#define MLAG_TRACE(level, fmt, arg ...)                                   \
+    do {                                                                  \
+        static const struct mlag_trace_fmt trace_fmt_ =                   \
+        { level, __LINE__, QUOTEME(__MODULE__), __FUNCTION__, fmt };      \
+        if ((level) <= MLAG_TRACE_LEVEL_MAX) {                            \
+            mlag_trace_write(&trace_fmt_,                                 \
+                             (const uint64_t[MLAG_TRACE_ARGS_MAX]){ arg }); \
+        }                                                                 \
+    } while (0)
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+/**
+ * mlag_trace_fmt struct describes a trace point. It is built at
+ * compile time, its address is the format id stored in the rings.
+ */
+struct mlag_trace_fmt {
+    int level;
+    int line;
+    const char *module;
+    const char *func;
+    const char *fmt;
+};
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ *  This function records a trace point in the ring of the calling
+ *  thread, the ring is allocated on first use. Oldest entries are
+ *  overwritten. It takes no lock.
+ *
+ * @param[in] fmt - trace point format
+ * @param[in] args - MLAG_TRACE_ARGS_MAX arguments
+ *
+ * @return void
+ */
+void mlag_trace_write(const struct mlag_trace_fmt *fmt, const uint64_t *args);
+
+/**
+ *  This function decodes and dumps the rings of all threads, oldest
+ *  entries first
+ *
+ * @param[in] dump_cb - callback for dumping, if NULL, log will be used
+ *
+ * @return void
+ */
+void mlag_trace_dump(void (*dump_cb)(const char *, ...));
+
+#endif /* MLAG_TRACE_H_ */
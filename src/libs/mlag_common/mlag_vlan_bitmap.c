@@ -0,0 +1,445 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#include <errno.h>
+#include <string.h>
+#include <endian.h>
+#include <utils/mlag_log.h>
+#include <utils/mlag_bail.h>
+#include <utils/mlag_defs.h>
+#include <utils/mlag_events.h>
+#include "mlag_vlan_bitmap.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#undef  __MODULE__
+#define __MODULE__ MLAG_VLAN_BITMAP
+
+#define VLAN_BITMAP_ID_NUM  (VLAN_BITMAP_WORDS * VLAN_BITMAP_WORD_BITS)
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/**
+ *  This function returns next vlan id set in bitmap
+ *
+ * @param[in] bmp - vlan bitmap
+ * @param[in] vlan_id - vlan id to start search from
+ *
+ * @return vlan id, -1 if no more vlans are set
+ */
+int
+vlan_bitmap_next(const struct vlan_bitmap *bmp, int vlan_id)
+{
+    int idx;
+    uint64_t word;
+
+    if ((vlan_id < 0) || (vlan_id >= VLAN_BITMAP_ID_NUM)) {
+        return -1;
+    }
+
+    idx = VLAN_BITMAP_WORD(vlan_id);
+    word = bmp->words[idx] & (~0ULL << (vlan_id % VLAN_BITMAP_WORD_BITS));
+    while (word == 0) {
+        if (++idx == VLAN_BITMAP_WORDS) {
+            return -1;
+        }
+        word = bmp->words[idx];
+    }
+
+    return (idx * VLAN_BITMAP_WORD_BITS) + __builtin_ctzll(word);
+}
+
+/**
+ *  This function returns number of vlans set in bitmap
+ *
+ * @param[in] bmp - vlan bitmap
+ *
+ * @return number of vlans
+ */
+int
+vlan_bitmap_count(const struct vlan_bitmap *bmp)
+{
+    int idx;
+    int cnt = 0;
+
+    for (idx = 0; idx < VLAN_BITMAP_WORDS; idx++) {
+        cnt += __builtin_popcountll(bmp->words[idx]);
+    }
+
+    return cnt;
+}
+
+/**
+ *  This function adds a vlan with its state to vlan states set
+ *
+ * @param[in,out] vlans - vlan states
+ * @param[in] vlan_id - vlan id
+ * @param[in] is_up - 1 if vlan is up (VLAN_UP or VLAN_GLOBAL_UP)
+ *
+ * @return void
+ */
+void
+vlan_state_bitmap_set(struct vlan_state_bitmap *vlans,
+                      unsigned short vlan_id, int is_up)
+{
+    VLAN_BITMAP_SET(&vlans->mask, vlan_id);
+    if (is_up) {
+        VLAN_BITMAP_SET(&vlans->up, vlan_id);
+    }
+    else {
+        VLAN_BITMAP_CLR(&vlans->up, vlan_id);
+    }
+}
+
+/*
+ *  Set vlan ids in range [start, end) using whole words where possible
+ *
+ * @param[in,out] bmp - vlan bitmap
+ * @param[in] start - first vlan id
+ * @param[in] end - vlan id following the range
+ *
+ * @return void
+ */
+static void
+vlan_bitmap_range_set(struct vlan_bitmap *bmp, int start, int end)
+{
+    int idx;
+    int last_idx;
+    uint64_t first_mask, last_mask;
+
+    if (start >= end) {
+        return;
+    }
+
+    idx = VLAN_BITMAP_WORD(start);
+    last_idx = VLAN_BITMAP_WORD(end - 1);
+    first_mask = ~0ULL << (start % VLAN_BITMAP_WORD_BITS);
+    last_mask = ~0ULL >> (VLAN_BITMAP_WORD_BITS - 1 -
+                          ((end - 1) % VLAN_BITMAP_WORD_BITS));
+
+    if (idx == last_idx) {
+        bmp->words[idx] |= first_mask & last_mask;
+        return;
+    }
+
+    bmp->words[idx++] |= first_mask;
+    for (; idx < last_idx; idx++) {
+        bmp->words[idx] = ~0ULL;
+    }
+    bmp->words[last_idx] |= last_mask;
+}
+
+/*
+ *  Count runs of consecutive carried vlans with the same state.
+ *  A run starts where previous vlan is not carried or has other state.
+ *
+ * @param[in] vlans - vlan states
+ *
+ * @return number of runs
+ */
+static int
+vlan_state_runs_count(const struct vlan_state_bitmap *vlans)
+{
+    int idx;
+    int cnt = 0;
+    uint64_t mask, up, prev_mask, prev_up;
+    uint64_t carry_mask = 0, carry_up = 0;
+
+    for (idx = 0; idx < VLAN_BITMAP_WORDS; idx++) {
+        mask = vlans->mask.words[idx];
+        up = vlans->up.words[idx] & mask;
+        prev_mask = (mask << 1) | carry_mask;
+        prev_up = (up << 1) | carry_up;
+        cnt += __builtin_popcountll(mask & (~prev_mask | (up ^ prev_up)));
+        carry_mask = mask >> (VLAN_BITMAP_WORD_BITS - 1);
+        carry_up = up >> (VLAN_BITMAP_WORD_BITS - 1);
+    }
+
+    return cnt;
+}
+
+/*
+ *  Find end of run starting at given vlan: first vlan that is either
+ *  not carried or has other state
+ *
+ * @param[in] vlans - vlan states
+ * @param[in] start - first vlan of the run
+ * @param[in] is_up - state of the run
+ *
+ * @return vlan id following the run
+ */
+static int
+vlan_state_run_end(const struct vlan_state_bitmap *vlans, int start,
+                   int is_up)
+{
+    int idx = VLAN_BITMAP_WORD(start);
+    uint64_t breaks;
+
+    breaks = ~vlans->mask.words[idx] |
+             (is_up ? ~vlans->up.words[idx] : vlans->up.words[idx]);
+    breaks &= ~0ULL << (start % VLAN_BITMAP_WORD_BITS);
+    while (breaks == 0) {
+        if (++idx == VLAN_BITMAP_WORDS) {
+            return VLAN_BITMAP_ID_NUM;
+        }
+        breaks = ~vlans->mask.words[idx] |
+                 (is_up ? ~vlans->up.words[idx] : vlans->up.words[idx]);
+    }
+
+    return (idx * VLAN_BITMAP_WORD_BITS) + __builtin_ctzll(breaks);
+}
+
+/*
+ *  Copy bitmap words in little endian order, so bit N is bit N % 8
+ *  of byte N / 8 on every host
+ *
+ * @param[out] buf - destination buffer
+ * @param[in] bmp - vlan bitmap
+ *
+ * @return void
+ */
+static void
+vlan_bitmap_put(uint8_t *buf, const struct vlan_bitmap *bmp)
+{
+    int idx;
+    uint64_t word;
+
+    for (idx = 0; idx < VLAN_BITMAP_WORDS; idx++) {
+        word = htole64(bmp->words[idx]);
+        memcpy(buf + idx * sizeof(word), &word, sizeof(word));
+    }
+}
+
+/*
+ *  Read bitmap words stored by vlan_bitmap_put
+ *
+ * @param[out] bmp - vlan bitmap
+ * @param[in] buf - source buffer
+ *
+ * @return void
+ */
+static void
+vlan_bitmap_get(struct vlan_bitmap *bmp, const uint8_t *buf)
+{
+    int idx;
+    uint64_t word;
+
+    for (idx = 0; idx < VLAN_BITMAP_WORDS; idx++) {
+        memcpy(&word, buf + idx * sizeof(word), sizeof(word));
+        bmp->words[idx] = le64toh(word);
+    }
+}
+
+/**
+ *  This function encodes vlan states into vlan state change event.
+ *  The smallest of bitmap and run length encodings is selected.
+ *  The encoding is byte order independent, so the event may be sent
+ *  both locally and to peers.
+ *
+ * @param[in] vlans - vlan states
+ * @param[out] ev - event, opcode and peer_id are left untouched
+ * @param[out] ev_len - event length to send
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+vlan_state_encode(const struct vlan_state_bitmap *vlans,
+                  struct vlan_state_change_event_data *ev, int *ev_len)
+{
+    int err = 0;
+    int idx;
+    int runs_cnt;
+    int start, end;
+    int is_up;
+    unsigned int bitmap_len;
+    uint64_t any_up = 0, any_down = 0;
+    struct vlan_state_run run;
+
+    ASSERT(vlans);
+    ASSERT(ev);
+    ASSERT(ev_len);
+
+    for (idx = 0; idx < VLAN_BITMAP_WORDS; idx++) {
+        any_up |= vlans->mask.words[idx] & vlans->up.words[idx];
+        any_down |= vlans->mask.words[idx] & ~vlans->up.words[idx];
+    }
+
+    ev->vlans_arr_cnt = vlan_bitmap_count(&vlans->mask);
+    runs_cnt = vlan_state_runs_count(vlans);
+    bitmap_len = (any_up && any_down) ?
+                 (2 * VLAN_BITMAP_SIZE) : VLAN_BITMAP_SIZE;
+
+    if ((runs_cnt * sizeof(run)) < bitmap_len) {
+        ev->encoding = VLAN_STATE_ENC_RLE;
+        ev->data_len = runs_cnt * sizeof(run);
+        idx = 0;
+        VLAN_BITMAP_FOREACH(&vlans->mask, start) {
+            is_up = VLAN_BITMAP_TEST(&vlans->up, start);
+            end = vlan_state_run_end(vlans, start, is_up);
+            run.vlan_id = htole16(start);
+            run.vlans_cnt = htole16(end - start);
+            run.vlan_state = is_up ? VLAN_UP : VLAN_DOWN;
+            memcpy(ev->data + idx * sizeof(run), &run, sizeof(run));
+            idx++;
+            /* continue search after the run */
+            start = end - 1;
+        }
+    }
+    else if (!any_down) {
+        ev->encoding = VLAN_STATE_ENC_UP_BITMAP;
+        ev->data_len = VLAN_BITMAP_SIZE;
+        vlan_bitmap_put(ev->data, &vlans->mask);
+    }
+    else if (!any_up) {
+        ev->encoding = VLAN_STATE_ENC_DOWN_BITMAP;
+        ev->data_len = VLAN_BITMAP_SIZE;
+        vlan_bitmap_put(ev->data, &vlans->mask);
+    }
+    else {
+        ev->encoding = VLAN_STATE_ENC_BITMAP;
+        ev->data_len = 2 * VLAN_BITMAP_SIZE;
+        vlan_bitmap_put(ev->data, &vlans->mask);
+        vlan_bitmap_put(ev->data + VLAN_BITMAP_SIZE, &vlans->up);
+    }
+
+    *ev_len = sizeof(struct vlan_state_change_base_event_data) +
+              ev->data_len;
+
+bail:
+    return err;
+}
+
+/**
+ *  This function decodes vlan states from vlan state change event
+ *
+ * @param[in] ev - event
+ * @param[out] vlans - vlan states
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -EINVAL if event data is malformed
+ */
+int
+vlan_state_decode(const struct vlan_state_change_event_data *ev,
+                  struct vlan_state_bitmap *vlans)
+{
+    int err = 0;
+    int idx;
+    int runs_cnt;
+    int start, end;
+    struct vlan_state_run run;
+
+    ASSERT(ev);
+    ASSERT(vlans);
+
+    memset(vlans, 0, sizeof(*vlans));
+
+    switch (ev->encoding) {
+    case VLAN_STATE_ENC_UP_BITMAP:
+    case VLAN_STATE_ENC_DOWN_BITMAP:
+        if (ev->data_len != VLAN_BITMAP_SIZE) {
+            err = -EINVAL;
+            MLAG_BAIL_ERROR_MSG(err, "Invalid vlan bitmap length %u\n",
+                                ev->data_len);
+        }
+        vlan_bitmap_get(&vlans->mask, ev->data);
+        if (ev->encoding == VLAN_STATE_ENC_UP_BITMAP) {
+            SAFE_MEMCPY(&vlans->up, &vlans->mask);
+        }
+        break;
+    case VLAN_STATE_ENC_BITMAP:
+        if (ev->data_len != 2 * VLAN_BITMAP_SIZE) {
+            err = -EINVAL;
+            MLAG_BAIL_ERROR_MSG(err, "Invalid vlan bitmap length %u\n",
+                                ev->data_len);
+        }
+        vlan_bitmap_get(&vlans->mask, ev->data);
+        vlan_bitmap_get(&vlans->up, ev->data + VLAN_BITMAP_SIZE);
+        for (idx = 0; idx < VLAN_BITMAP_WORDS; idx++) {
+            vlans->up.words[idx] &= vlans->mask.words[idx];
+        }
+        break;
+    case VLAN_STATE_ENC_RLE:
+        if ((ev->data_len % sizeof(run)) ||
+            (ev->data_len > VLAN_STATE_ENC_MAX_LEN)) {
+            err = -EINVAL;
+            MLAG_BAIL_ERROR_MSG(err, "Invalid vlan runs length %u\n",
+                                ev->data_len);
+        }
+        runs_cnt = ev->data_len / sizeof(run);
+        for (idx = 0; idx < runs_cnt; idx++) {
+            memcpy(&run, ev->data + idx * sizeof(run), sizeof(run));
+            start = le16toh(run.vlan_id);
+            end = start + le16toh(run.vlans_cnt);
+            if ((end > VLAN_BITMAP_ID_NUM) ||
+                ((run.vlan_state != VLAN_UP) &&
+                 (run.vlan_state != VLAN_DOWN))) {
+                err = -EINVAL;
+                MLAG_BAIL_ERROR_MSG(err,
+                                    "Invalid vlan run: vlan %d, count %d, state %u\n",
+                                    start, end - start, run.vlan_state);
+            }
+            vlan_bitmap_range_set(&vlans->mask, start, end);
+            if (run.vlan_state == VLAN_UP) {
+                vlan_bitmap_range_set(&vlans->up, start, end);
+            }
+        }
+        break;
+    default:
+        err = -EINVAL;
+        MLAG_BAIL_ERROR_MSG(err, "Unknown vlan state encoding %u\n",
+                            ev->encoding);
+        break;
+    }
+
+bail:
+    return err;
+}
@@ -0,0 +1,135 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#ifndef MLAG_VLAN_BITMAP_H_
+#define MLAG_VLAN_BITMAP_H_
+
+#include <stdint.h>
+#include <utils/mlag_events.h>
+
+/************************************************
+ *  Defines
+ ***********************************************/
+#define VLAN_BITMAP_WORD_BITS  64
+#define VLAN_BITMAP_WORDS      ((MLAG_VLAN_ID_MAX + 1) / VLAN_BITMAP_WORD_BITS)
+
+/************************************************
+ *  Macros
+ ***********************************************/
+#define VLAN_BITMAP_WORD(vlan_id) ((vlan_id) / VLAN_BITMAP_WORD_BITS)
+#define VLAN_BITMAP_BIT(vlan_id)  (1ULL << ((vlan_id) % VLAN_BITMAP_WORD_BITS))
+
+#define VLAN_BITMAP_SET(bmp, vlan_id) \
+    ((bmp)->words[VLAN_BITMAP_WORD(vlan_id)] |= VLAN_BITMAP_BIT(vlan_id))
+#define VLAN_BITMAP_CLR(bmp, vlan_id) \
+    ((bmp)->words[VLAN_BITMAP_WORD(vlan_id)] &= ~VLAN_BITMAP_BIT(vlan_id))
+#define VLAN_BITMAP_TEST(bmp, vlan_id) \
+    (((bmp)->words[VLAN_BITMAP_WORD(vlan_id)] & VLAN_BITMAP_BIT(vlan_id)) != 0)
+
+/* Iterate over vlan ids set in bitmap */
+#define VLAN_BITMAP_FOREACH(bmp, vlan_id)                  \
+    for ((vlan_id) = vlan_bitmap_next((bmp), 0);           \
+         (vlan_id) >= 0;                                   \
+         (vlan_id) = vlan_bitmap_next((bmp), (vlan_id) + 1))
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+struct vlan_bitmap {
+    uint64_t words[VLAN_BITMAP_WORDS];
+};
+
+/* Set of vlans with states: vlans set in mask are carried,
+ * up holds their state (bit set - up, clear - down) */
+struct vlan_state_bitmap {
+    struct vlan_bitmap mask;
+    struct vlan_bitmap up;
+};
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ *  This function returns next vlan id set in bitmap
+ *
+ * @param[in] bmp - vlan bitmap
+ * @param[in] vlan_id - vlan id to start search from
+ *
+ * @return vlan id, -1 if no more vlans are set
+ */
+int vlan_bitmap_next(const struct vlan_bitmap *bmp, int vlan_id);
+
+/**
+ *  This function returns number of vlans set in bitmap
+ *
+ * @param[in] bmp - vlan bitmap
+ *
+ * @return number of vlans
+ */
+int vlan_bitmap_count(const struct vlan_bitmap *bmp);
+
+/**
+ *  This function adds a vlan with its state to vlan states set
+ *
+ * @param[in,out] vlans - vlan states
+ * @param[in] vlan_id - vlan id
+ * @param[in] is_up - 1 if vlan is up (VLAN_UP or VLAN_GLOBAL_UP)
+ *
+ * @return void
+ */
+void vlan_state_bitmap_set(struct vlan_state_bitmap *vlans,
+                           unsigned short vlan_id, int is_up);
+
+/**
+ *  This function encodes vlan states into vlan state change event.
+ *  The smallest of bitmap and run length encodings is selected.
+ *  The encoding is byte order independent, so the event may be sent
+ *  both locally and to peers.
+ *
+ * @param[in] vlans - vlan states
+ * @param[out] ev - event, opcode and peer_id are left untouched
+ * @param[out] ev_len - event length to send
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int vlan_state_encode(const struct vlan_state_bitmap *vlans,
+                      struct vlan_state_change_event_data *ev, int *ev_len);
+
+/**
+ *  This function decodes vlan states from vlan state change event
+ *
+ * @param[in] ev - event
+ * @param[out] vlans - vlan states
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -EINVAL if event data is malformed
+ */
+int vlan_state_decode(const struct vlan_state_change_event_data *ev,
+                      struct vlan_state_bitmap *vlans);
+
+#endif /* MLAG_VLAN_BITMAP_H_ */
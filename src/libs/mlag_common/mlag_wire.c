@@ -0,0 +1,729 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#include <errno.h>
+#include <string.h>
+#include <endian.h>
+#include <arpa/inet.h>
+#include <complib/cl_mem.h>
+#include <utils/mlag_log.h>
+#include <utils/mlag_bail.h>
+#include <utils/mlag_defs.h>
+#include <utils/mlag_events.h>
+#include "lib_commu.h"
+#include "mlag_common.h"
+#include "mlag_master_election.h"
+#include "mlag_comm_layer_wrapper.h"
+#include "mlag_wire.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#undef  __MODULE__
+#define __MODULE__ MLAG_WIRE
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+#define WIRE_MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define WIRE_MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+/* Registered message schemas by opcode */
+static const struct mlag_wire_msg *wire_msgs[MLAG_EVENTS_NUM];
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  Swap a single element in place. Messages are packed so the element
+ *  is accessed through memcpy. Elements of other widths are opaque.
+ *
+ * @param[in,out] elem - element
+ * @param[in] width - element size in bytes
+ * @param[in] oper - conversion direction
+ *
+ * @return void
+ */
+static void
+wire_elem_net_order(uint8_t *elem, uint32_t width, int oper)
+{
+    uint16_t val16;
+    uint32_t val32;
+    uint64_t val64;
+
+    switch (width) {
+    case sizeof(uint16_t):
+        memcpy(&val16, elem, sizeof(val16));
+        val16 = (oper == MESSAGE_SENDING) ? htons(val16) : ntohs(val16);
+        memcpy(elem, &val16, sizeof(val16));
+        break;
+    case sizeof(uint32_t):
+        memcpy(&val32, elem, sizeof(val32));
+        val32 = (oper == MESSAGE_SENDING) ? htonl(val32) : ntohl(val32);
+        memcpy(elem, &val32, sizeof(val32));
+        break;
+    case sizeof(uint64_t):
+        memcpy(&val64, elem, sizeof(val64));
+        val64 = (oper == MESSAGE_SENDING) ? htobe64(val64) : be64toh(val64);
+        memcpy(elem, &val64, sizeof(val64));
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ *  Read array count in host order
+ *
+ * @param[in] data - structure body
+ * @param[in] field - array field
+ *
+ * @return number of elements, 0 if count is negative
+ */
+static uint32_t
+wire_array_count(const uint8_t *data, const struct mlag_wire_field *field)
+{
+    int64_t count = 0;
+    int8_t val8;
+    int16_t val16;
+    int32_t val32;
+
+    switch (field->count_width) {
+    case sizeof(int8_t):
+        memcpy(&val8, data + field->count_offset, sizeof(val8));
+        count = val8;
+        break;
+    case sizeof(int16_t):
+        memcpy(&val16, data + field->count_offset, sizeof(val16));
+        count = val16;
+        break;
+    case sizeof(int32_t):
+        memcpy(&val32, data + field->count_offset, sizeof(val32));
+        count = val32;
+        break;
+    default:
+        memcpy(&count, data + field->count_offset, sizeof(count));
+        break;
+    }
+
+    if (count < 0) {
+        count = 0;
+    }
+    if (count > 0xFFFFFFFFLL) {
+        count = 0xFFFFFFFFLL;
+    }
+    return (uint32_t)count;
+}
+
+/*
+ *  Return maximal number of elements of an array
+ *
+ * @param[in] field - array field
+ * @param[in] room - bytes left for the array, bounds runs of elements
+ *
+ * @return array capacity
+ */
+static uint32_t
+wire_array_capacity(const struct mlag_wire_field *field, uint32_t room)
+{
+    if (field->capacity == MLAG_WIRE_CAPACITY_PORTS) {
+        return mlag_max_ports_get();
+    }
+    if (field->capacity == MLAG_WIRE_CAPACITY_MSG) {
+        return room / field->width;
+    }
+    return field->capacity;
+}
+
+/*
+ *  Convert a single element, by its schema when it is a structure
+ *
+ * @param[in] field - element field
+ * @param[in,out] elem - element
+ * @param[in] oper - conversion direction
+ *
+ * @return void
+ */
+static void
+wire_field_elem_net_order(const struct mlag_wire_field *field, uint8_t *elem,
+                          int oper)
+{
+    if (field->elem_fields) {
+        mlag_wire_net_order(field->elem_fields, elem, oper);
+    }
+    else {
+        wire_elem_net_order(elem, field->width, oper);
+    }
+}
+
+/*
+ *  Convert arrays or scalars of a structure
+ *
+ * @param[in] fields - schema
+ * @param[in,out] data - structure body
+ * @param[in] oper - conversion direction
+ * @param[in] arrays - 1 to convert arrays, 0 to convert scalars
+ *
+ * @return void
+ */
+static void
+wire_fields_net_order(const struct mlag_wire_field *fields, uint8_t *data,
+                      int oper, int arrays)
+{
+    const struct mlag_wire_field *field;
+    uint32_t count;
+    uint32_t idx;
+    uint8_t *elem;
+
+    for (field = fields; field->width != 0; field++) {
+        elem = data + field->offset;
+        if (field->capacity == 1) {
+            if (!arrays) {
+                wire_field_elem_net_order(field, elem, oper);
+            }
+            continue;
+        }
+        if (!arrays) {
+            continue;
+        }
+        count = wire_array_count(data, field);
+        if ((field->capacity != MLAG_WIRE_CAPACITY_MSG) &&
+            (count > wire_array_capacity(field, 0))) {
+            MLAG_LOG(MLAG_LOG_NOTICE,
+                     "Array count %u exceeds capacity %u, clamped\n",
+                     count, wire_array_capacity(field, 0));
+            count = wire_array_capacity(field, 0);
+        }
+        for (idx = 0; idx < count; idx++, elem += field->width) {
+            wire_field_elem_net_order(field, elem, oper);
+        }
+    }
+}
+
+/**
+ *  This function converts a structure between host and network order
+ *  according to its schema. Arrays are converted up to their count
+ *  member only.
+ *
+ * @param[in] fields - schema, terminated by MLAG_WIRE_FIELDS_END
+ * @param[in,out] data - structure body
+ * @param[in] oper - conversion direction (enum message_operation)
+ *
+ * @return void
+ */
+void
+mlag_wire_net_order(const struct mlag_wire_field *fields, uint8_t *data,
+                    int oper)
+{
+    /* Array counts must be read while they are in host order */
+    if (oper == MESSAGE_SENDING) {
+        wire_fields_net_order(fields, data, oper, 1);
+        wire_fields_net_order(fields, data, oper, 0);
+    }
+    else {
+        wire_fields_net_order(fields, data, oper, 0);
+        wire_fields_net_order(fields, data, oper, 1);
+    }
+}
+
+/*
+ *  Return the field with the lowest offset above a given one, schemas
+ *  do not have to list fields in structure order
+ *
+ * @param[in] fields - schema
+ * @param[in] prev - previous field, NULL for the first one
+ *
+ * @return next field, NULL when there are no more fields
+ */
+static const struct mlag_wire_field *
+wire_field_next(const struct mlag_wire_field *fields,
+                const struct mlag_wire_field *prev)
+{
+    const struct mlag_wire_field *field;
+    const struct mlag_wire_field *next = NULL;
+
+    for (field = fields; field->width != 0; field++) {
+        if (prev && (field->offset <= prev->offset)) {
+            continue;
+        }
+        if ((next == NULL) || (field->offset < next->offset)) {
+            next = field;
+        }
+    }
+    return next;
+}
+
+/*
+ *  Check a message schema can be encoded: fields do not overlap, an
+ *  array is the last field, array counts precede their arrays and
+ *  element schemas hold scalars only. Arrays are sent up to their count,
+ *  so a field after one would be encoded at a varying position.
+ *
+ * @param[in] msg - message schema
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+wire_msg_check(const struct mlag_wire_msg *msg)
+{
+    int err = 0;
+    const struct mlag_wire_field *field = NULL;
+    const struct mlag_wire_field *elem;
+    const struct mlag_wire_field *array = NULL;
+    uint32_t end = sizeof(uint16_t); /* opcode */
+
+    if (msg->fields == NULL) {
+        goto bail;
+    }
+    while ((field = wire_field_next(msg->fields, field)) != NULL) {
+        if (array != NULL) {
+            err = -EINVAL;
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Opcode %u: field at %u follows array at %u\n",
+                                msg->opcode, field->offset, array->offset);
+        }
+        if (field->offset < end) {
+            err = -EINVAL;
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Opcode %u: field at %u overlaps previous field\n",
+                                msg->opcode, field->offset);
+        }
+        end = field->offset + field->width;
+        if (field->capacity == 1) {
+            continue;
+        }
+        array = field;
+        if (field->count_offset + field->count_width > field->offset) {
+            err = -EINVAL;
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Opcode %u: count of array at %u follows it\n",
+                                msg->opcode, field->offset);
+        }
+        if (field->elem_fields) {
+            for (elem = field->elem_fields; elem->width != 0; elem++) {
+                if (elem->capacity != 1) {
+                    err = -EINVAL;
+                    MLAG_BAIL_ERROR_MSG(err,
+                                        "Opcode %u: array element at %u holds an array\n",
+                                        msg->opcode, field->offset);
+                }
+            }
+        }
+    }
+
+bail:
+    return err;
+}
+
+/**
+ *  This function registers message schemas of a module. Messages
+ *  with a registered schema are encoded by mlag_wire_msg_encode,
+ *  others are sent as is.
+ *
+ * @param[in] msgs - module message schemas
+ * @param[in] msgs_num - number of message schemas
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -EINVAL if a schema is malformed
+ */
+int
+mlag_wire_msgs_register(const struct mlag_wire_msg *msgs, int msgs_num)
+{
+    int err = 0;
+    int idx;
+
+    for (idx = 0; idx < msgs_num; idx++) {
+        if (msgs[idx].opcode >= MLAG_EVENTS_NUM) {
+            err = -EINVAL;
+            MLAG_BAIL_ERROR_MSG(err, "Opcode %u out of range\n",
+                                msgs[idx].opcode);
+        }
+        err = wire_msg_check(&msgs[idx]);
+        MLAG_BAIL_ERROR(err);
+        wire_msgs[msgs[idx].opcode] = &msgs[idx];
+    }
+
+bail:
+    return err;
+}
+
+/*
+ *  Return registered schema of a message
+ *
+ * @param[in] msg - message, starting with the opcode in given order
+ * @param[in] oper - MESSAGE_SENDING if opcode is in host order
+ * @param[out] opcode - opcode in host order
+ *
+ * @return schema, NULL if opcode has no schema
+ */
+static const struct mlag_wire_msg *
+wire_msg_schema(const uint8_t *msg, int oper, uint16_t *opcode)
+{
+    uint16_t code;
+
+    memcpy(&code, msg, sizeof(code));
+    if (oper != MESSAGE_SENDING) {
+        code = ntohs(code);
+    }
+    *opcode = code;
+    if (code >= MLAG_EVENTS_NUM) {
+        return NULL;
+    }
+    return wire_msgs[code];
+}
+
+/**
+ *  This function encodes a message into its wire form. Scalars are
+ *  converted to network order and arrays are sent up to their count
+ *  member only, so the encoded body is never longer than the message.
+ *
+ * @param[in] msg - message in host order, starting with the opcode
+ * @param[in] msg_len - message length
+ * @param[out] buf - encoded body, at least msg_len bytes
+ * @param[out] buf_len - encoded body length
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOENT if opcode has no schema, buf is not written
+ * @return -EINVAL if an array count exceeds the message
+ */
+int
+mlag_wire_msg_encode(const uint8_t *msg, uint32_t msg_len, uint8_t *buf,
+                     uint32_t *buf_len)
+{
+    int err = 0;
+    const struct mlag_wire_msg *schema;
+    const struct mlag_wire_field *field = NULL;
+    uint16_t opcode;
+    uint32_t pos = sizeof(opcode);
+    uint32_t out;
+    uint32_t len;
+    uint32_t count;
+    uint32_t idx;
+
+    if (msg_len < sizeof(opcode)) {
+        err = -EINVAL;
+        MLAG_BAIL_ERROR_MSG(err, "Message too short [%u]\n", msg_len);
+    }
+    schema = wire_msg_schema(msg, MESSAGE_SENDING, &opcode);
+    if (schema == NULL) {
+        err = -ENOENT;
+        goto bail;
+    }
+    opcode = htons(opcode);
+    memcpy(buf, &opcode, sizeof(opcode));
+    out = sizeof(opcode);
+
+    while ((schema->fields != NULL) && (pos < msg_len) &&
+           ((field = wire_field_next(schema->fields, field)) != NULL)) {
+        /* Members without schema are sent as is */
+        len = WIRE_MIN(field->offset, msg_len) - pos;
+        memcpy(buf + out, msg + pos, len);
+        out += len;
+        pos += len;
+        if (pos == msg_len) {
+            break;
+        }
+
+        if (field->capacity == 1) {
+            len = WIRE_MIN(field->width, msg_len - pos);
+            memcpy(buf + out, msg + pos, len);
+            if (len == field->width) {
+                wire_field_elem_net_order(field, buf + out, MESSAGE_SENDING);
+            }
+            out += len;
+            pos += len;
+            continue;
+        }
+
+        count = wire_array_count(msg, field);
+        if ((count > wire_array_capacity(field, msg_len - pos)) ||
+            ((uint64_t)count * field->width > msg_len - pos)) {
+            err = -EINVAL;
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Opcode %u: array count %u exceeds message length %u\n",
+                                ntohs(opcode), count, msg_len);
+        }
+        memcpy(buf + out, msg + pos, count * field->width);
+        for (idx = 0; idx < count; idx++, out += field->width) {
+            wire_field_elem_net_order(field, buf + out, MESSAGE_SENDING);
+        }
+        /* Unused elements of fixed arrays are not sent */
+        if (MLAG_WIRE_CAPACITY_FLEX(field->capacity)) {
+            pos += count * field->width;
+        }
+        else {
+            pos = WIRE_MIN(msg_len, pos + field->capacity * field->width);
+        }
+    }
+
+    memcpy(buf + out, msg + pos, msg_len - pos);
+    out += msg_len - pos;
+    *buf_len = out;
+
+bail:
+    return err;
+}
+
+/**
+ *  This function makes sure the buffer holds at least size bytes,
+ *  content is kept
+ *
+ * @param[in,out] wire_buf - buffer
+ * @param[in] size - required size
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOMEM if buffer could not be grown
+ */
+int
+mlag_wire_buf_reserve(struct mlag_wire_buf *wire_buf, uint32_t size)
+{
+    int err = 0;
+    uint8_t *data;
+    uint32_t new_size;
+
+    if (size <= wire_buf->size) {
+        goto bail;
+    }
+    new_size = WIRE_MAX(size, 2 * wire_buf->size);
+    data = (uint8_t *)cl_malloc(new_size);
+    if (data == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to grow wire buffer to %u bytes\n",
+                            new_size);
+    }
+    if (wire_buf->data) {
+        memcpy(data, wire_buf->data, wire_buf->size);
+        cl_free(wire_buf->data);
+    }
+    wire_buf->data = data;
+    wire_buf->size = new_size;
+
+bail:
+    return err;
+}
+
+/**
+ *  This function decodes a wire body encoded by mlag_wire_msg_encode
+ *  back into the host message layout
+ *
+ * @param[in] buf - encoded body
+ * @param[in] buf_len - encoded body length
+ * @param[in,out] msg - decoded message, grown as needed
+ * @param[out] msg_len - decoded message length
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOENT if opcode has no schema, msg is not written
+ * @return -EPROTO if body does not match the schema
+ * @return -ENOMEM if msg could not be grown
+ */
+int
+mlag_wire_msg_decode(const uint8_t *buf, uint32_t buf_len,
+                     struct mlag_wire_buf *msg, uint32_t *msg_len)
+{
+    int err = 0;
+    const struct mlag_wire_msg *schema;
+    const struct mlag_wire_field *field = NULL;
+    uint16_t opcode;
+    uint32_t in = sizeof(opcode);
+    uint32_t pos;
+    uint32_t len;
+    uint32_t count;
+    uint32_t idx;
+
+    if (buf_len < sizeof(opcode)) {
+        err = -EPROTO;
+        MLAG_BAIL_ERROR_MSG(err, "Message too short [%u]\n", buf_len);
+    }
+    schema = wire_msg_schema(buf, MESSAGE_RECEIVE, &opcode);
+    if (schema == NULL) {
+        err = -ENOENT;
+        goto bail;
+    }
+    /* Decoded message is at least as long as the encoded one */
+    err = mlag_wire_buf_reserve(msg, buf_len);
+    MLAG_BAIL_ERROR(err);
+    memcpy(msg->data, &opcode, sizeof(opcode));
+    pos = sizeof(opcode);
+
+    while ((schema->fields != NULL) && (in < buf_len) &&
+           ((field = wire_field_next(schema->fields, field)) != NULL)) {
+        len = WIRE_MIN(field->offset - pos, buf_len - in);
+        err = mlag_wire_buf_reserve(msg, pos + len + (buf_len - in));
+        MLAG_BAIL_ERROR(err);
+        memcpy(msg->data + pos, buf + in, len);
+        in += len;
+        pos += len;
+        if (in == buf_len) {
+            break;
+        }
+
+        if (field->capacity == 1) {
+            len = WIRE_MIN(field->width, buf_len - in);
+            memcpy(msg->data + pos, buf + in, len);
+            if (len == field->width) {
+                wire_field_elem_net_order(field, msg->data + pos,
+                                          MESSAGE_RECEIVE);
+            }
+            in += len;
+            pos += len;
+            continue;
+        }
+
+        count = wire_array_count(msg->data, field);
+        if ((count > wire_array_capacity(field, buf_len - in)) ||
+            ((uint64_t)count * field->width > buf_len - in)) {
+            err = -EPROTO;
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Opcode %u: array count %u exceeds received length %u\n",
+                                opcode, count, buf_len);
+        }
+        len = count * field->width;
+        if (!MLAG_WIRE_CAPACITY_FLEX(field->capacity)) {
+            len = field->capacity * field->width;
+        }
+        err = mlag_wire_buf_reserve(msg, pos + len + (buf_len - in));
+        MLAG_BAIL_ERROR(err);
+        memcpy(msg->data + pos, buf + in, count * field->width);
+        for (idx = 0; idx < count; idx++, pos += field->width) {
+            wire_field_elem_net_order(field, msg->data + pos,
+                                      MESSAGE_RECEIVE);
+        }
+        in += count * field->width;
+        /* Unused elements of fixed arrays are zeroed */
+        if (!MLAG_WIRE_CAPACITY_FLEX(field->capacity)) {
+            memset(msg->data + pos, 0,
+                   (field->capacity - count) * field->width);
+            pos += (field->capacity - count) * field->width;
+        }
+    }
+
+    err = mlag_wire_buf_reserve(msg, pos + (buf_len - in));
+    MLAG_BAIL_ERROR(err);
+    memcpy(msg->data + pos, buf + in, buf_len - in);
+    *msg_len = pos + (buf_len - in);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function fills the header of an outgoing message
+ *
+ * @param[out] header - message header
+ * @param[in] length - message length not including the header
+ * @param[in] flags - header flags
+ *
+ * @return void
+ */
+void
+mlag_wire_header_set(struct mlag_wire_header *header, uint32_t length,
+                     uint8_t flags)
+{
+    header->magic = htons(MLAG_WIRE_MAGIC);
+    header->version = MLAG_WIRE_VERSION;
+    header->flags = flags;
+    header->length = htonl(length);
+}
+
+/**
+ *  This function validates the header of an incoming message
+ *
+ * @param[in] buf - received buffer, starting with the header
+ * @param[in] buf_len - received buffer length
+ * @param[out] length - message length not including the header
+ * @param[out] flags - header flags, may be NULL
+ * @param[out] version - header version, may be NULL
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -EPROTO if header is malformed or major version differs
+ */
+int
+mlag_wire_header_check(const uint8_t *buf, uint32_t buf_len,
+                       uint32_t *length, uint8_t *flags, uint8_t *version)
+{
+    int err = 0;
+    struct mlag_wire_header header;
+
+    if (buf_len < MLAG_WIRE_HEADER_SIZE) {
+        err = -EPROTO;
+        MLAG_BAIL_ERROR_MSG(err, "Message too short [%u] for wire header\n",
+                            buf_len);
+    }
+
+    memcpy(&header, buf, sizeof(header));
+    header.magic = ntohs(header.magic);
+    header.length = ntohl(header.length);
+
+    if (header.magic != MLAG_WIRE_MAGIC) {
+        err = -EPROTO;
+        MLAG_BAIL_ERROR_MSG(err, "Bad wire header magic [0x%04x]\n",
+                            header.magic);
+    }
+    if (MLAG_WIRE_VERSION_MAJOR_GET(header.version) !=
+        MLAG_WIRE_VERSION_MAJOR) {
+        err = -EPROTO;
+        MLAG_BAIL_ERROR_MSG(err, "Unsupported wire version [%u.%u]\n",
+                            MLAG_WIRE_VERSION_MAJOR_GET(header.version),
+                            header.version & 0xF);
+    }
+    if (header.length != buf_len - MLAG_WIRE_HEADER_SIZE) {
+        err = -EPROTO;
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Wire header length [%u] mismatch, received [%u]\n",
+                            header.length,
+                            (uint32_t)(buf_len - MLAG_WIRE_HEADER_SIZE));
+    }
+
+    *length = header.length;
+    if (flags) {
+        *flags = header.flags;
+    }
+    if (version) {
+        *version = header.version;
+    }
+
+bail:
+    return err;
+}
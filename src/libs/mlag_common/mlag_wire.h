@@ -0,0 +1,260 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#ifndef MLAG_WIRE_H_
+#define MLAG_WIRE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/************************************************
+ *  Defines
+ ***********************************************/
+#define MLAG_WIRE_MAGIC           0x4D4C /* "ML" */
+#define MLAG_WIRE_VERSION_MAJOR   4
+#define MLAG_WIRE_VERSION_MINOR   1
+#define MLAG_WIRE_VERSION \
+    ((MLAG_WIRE_VERSION_MAJOR << 4) | MLAG_WIRE_VERSION_MINOR)
+#define MLAG_WIRE_VERSION_MAJOR_GET(version) (((version) >> 4) & 0xF)
+#define MLAG_WIRE_VERSION_MINOR_GET(version) ((version) & 0xF)
+
+/* First minor version that accepts stamped bodies */
+#define MLAG_WIRE_MINOR_STAMP     1
+/* Send stamp trailer, wall clock usec in network order */
+#define MLAG_WIRE_STAMP_SIZE      sizeof(uint64_t)
+
+#define MLAG_WIRE_HEADER_SIZE     (sizeof(struct mlag_wire_header))
+
+/* Header flags */
+#define MLAG_WIRE_FLAG_CHANNEL_MASK  0x0F /* mux channel */
+#define MLAG_WIRE_FLAG_BULK          0x10 /* mux bulk priority */
+#define MLAG_WIRE_FLAG_COMPRESSED    0x20 /* body is compressed */
+#define MLAG_WIRE_FLAG_COMPRESS_CAP  0x40 /* sender accepts compressed bodies */
+#define MLAG_WIRE_FLAG_STAMPED       0x80 /* body ends with send stamp */
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/* Scalar member, converted according to its width */
+#define MLAG_WIRE_FIELD(type, member)                    \
+    { offsetof(type, member), sizeof(((type *)0)->member), \
+      1, 0, 0, NULL }
+
+/* Array member, only the first <count_member> elements are converted */
+#define MLAG_WIRE_ARRAY(type, member, count_member)                       \
+    { offsetof(type, member), sizeof(((type *)0)->member[0]),             \
+      NUM_ELEMS(((type *)0)->member), offsetof(type, count_member),       \
+      sizeof(((type *)0)->count_member), NULL }
+
+/* Array of structures, each element is converted by the given schema */
+#define MLAG_WIRE_STRUCT_ARRAY(type, member, count_member, elem_fields)   \
+    { offsetof(type, member), sizeof(((type *)0)->member[0]),             \
+      NUM_ELEMS(((type *)0)->member), offsetof(type, count_member),       \
+      sizeof(((type *)0)->count_member), elem_fields }
+
+/* Capacity of a flexible array member, bounded by the runtime maximum
+ * of mLAG ports (mlag_max_ports_get)
+ */
+#define MLAG_WIRE_CAPACITY_PORTS  0xFFFFFFFF
+/* Capacity of a run of elements, bounded by the message length only */
+#define MLAG_WIRE_CAPACITY_MSG    0xFFFFFFFE
+
+#define MLAG_WIRE_CAPACITY_FLEX(capacity)       \
+    (((capacity) == MLAG_WIRE_CAPACITY_PORTS) || \
+     ((capacity) == MLAG_WIRE_CAPACITY_MSG))
+
+/* Flexible array of ports, only the first <count_member> elements are
+ * converted
+ */
+#define MLAG_WIRE_PORT_ARRAY(type, member, count_member)                  \
+    { offsetof(type, member), sizeof(((type *)0)->member[0]),             \
+      MLAG_WIRE_CAPACITY_PORTS, offsetof(type, count_member),             \
+      sizeof(((type *)0)->count_member), NULL }
+
+/* Flexible array of port structures */
+#define MLAG_WIRE_PORT_STRUCT_ARRAY(type, member, count_member, elem_fields) \
+    { offsetof(type, member), sizeof(((type *)0)->member[0]),                \
+      MLAG_WIRE_CAPACITY_PORTS, offsetof(type, count_member),                \
+      sizeof(((type *)0)->count_member), elem_fields }
+
+/* Run of structures starting at a single element member, as used by
+ * messages sent with a number of entries appended to the first one
+ */
+#define MLAG_WIRE_STRUCT_RUN(type, member, count_member, elem_fields)     \
+    { offsetof(type, member), sizeof(((type *)0)->member),                \
+      MLAG_WIRE_CAPACITY_MSG, offsetof(type, count_member),               \
+      sizeof(((type *)0)->count_member), elem_fields }
+
+#define MLAG_WIRE_FIELDS_END { 0, 0, 0, 0, 0, NULL }
+
+/* Message schema, the opcode is handled by the codec itself */
+#define MLAG_WIRE_MSG(opcode, fields) { opcode, fields }
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+#pragma pack(push,1)
+
+/* Header prepended to every message sent on the IPL */
+struct mlag_wire_header {
+    uint16_t magic;
+    uint8_t version;   /* major in upper nibble, minor in lower */
+    uint8_t flags;     /* MLAG_WIRE_FLAG_* */
+    uint32_t length;   /* message length not including the header */
+};
+
+#pragma pack(pop)
+
+struct mlag_wire_field {
+    uint32_t offset;
+    uint32_t width;        /* element size in bytes */
+    uint32_t capacity;     /* 1 for scalars, MLAG_WIRE_CAPACITY_PORTS or
+                            * MLAG_WIRE_CAPACITY_MSG for flexible arrays */
+    uint32_t count_offset; /* valid when capacity > 1 */
+    uint32_t count_width;
+    const struct mlag_wire_field *elem_fields; /* scalars only */
+};
+
+struct mlag_wire_msg {
+    uint16_t opcode;
+    const struct mlag_wire_field *fields;
+};
+
+/* Buffer grown on demand by the codec, owned by its user */
+struct mlag_wire_buf {
+    uint8_t *data;
+    uint32_t size;
+};
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ *  This function converts a structure between host and network order
+ *  according to its schema. Arrays are converted up to their count
+ *  member only.
+ *
+ * @param[in] fields - schema, terminated by MLAG_WIRE_FIELDS_END
+ * @param[in,out] data - structure body
+ * @param[in] oper - conversion direction (enum message_operation)
+ *
+ * @return void
+ */
+void mlag_wire_net_order(const struct mlag_wire_field *fields,
+                         uint8_t *data, int oper);
+
+/**
+ *  This function registers message schemas of a module. Messages
+ *  with a registered schema are encoded by mlag_wire_msg_encode,
+ *  others are sent as is.
+ *
+ * @param[in] msgs - module message schemas
+ * @param[in] msgs_num - number of message schemas
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -EINVAL if a schema is malformed
+ */
+int mlag_wire_msgs_register(const struct mlag_wire_msg *msgs, int msgs_num);
+
+/**
+ *  This function encodes a message into its wire form. Scalars are
+ *  converted to network order and arrays are sent up to their count
+ *  member only, so the encoded body is never longer than the message.
+ *
+ * @param[in] msg - message in host order, starting with the opcode
+ * @param[in] msg_len - message length
+ * @param[out] buf - encoded body, at least msg_len bytes
+ * @param[out] buf_len - encoded body length
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOENT if opcode has no schema, buf is not written
+ * @return -EINVAL if an array count exceeds the message
+ */
+int mlag_wire_msg_encode(const uint8_t *msg, uint32_t msg_len, uint8_t *buf,
+                         uint32_t *buf_len);
+
+/**
+ *  This function decodes a wire body encoded by mlag_wire_msg_encode
+ *  back into the host message layout
+ *
+ * @param[in] buf - encoded body
+ * @param[in] buf_len - encoded body length
+ * @param[in,out] msg - decoded message, grown as needed
+ * @param[out] msg_len - decoded message length
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOENT if opcode has no schema, msg is not written
+ * @return -EPROTO if body does not match the schema
+ * @return -ENOMEM if msg could not be grown
+ */
+int mlag_wire_msg_decode(const uint8_t *buf, uint32_t buf_len,
+                         struct mlag_wire_buf *msg, uint32_t *msg_len);
+
+/**
+ *  This function makes sure the buffer holds at least size bytes,
+ *  content is kept
+ *
+ * @param[in,out] wire_buf - buffer
+ * @param[in] size - required size
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOMEM if buffer could not be grown
+ */
+int mlag_wire_buf_reserve(struct mlag_wire_buf *wire_buf, uint32_t size);
+
+/**
+ *  This function fills the header of an outgoing message
+ *
+ * @param[out] header - message header
+ * @param[in] length - message length not including the header
+ * @param[in] flags - header flags
+ *
+ * @return void
+ */
+void mlag_wire_header_set(struct mlag_wire_header *header, uint32_t length,
+                          uint8_t flags);
+
+/**
+ *  This function validates the header of an incoming message
+ *
+ * @param[in] buf - received buffer, starting with the header
+ * @param[in] buf_len - received buffer length
+ * @param[out] length - message length not including the header
+ * @param[out] flags - header flags, may be NULL
+ * @param[out] version - header version, may be NULL
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -EPROTO if header is malformed or major version differs
+ */
+int mlag_wire_header_check(const uint8_t *buf, uint32_t buf_len,
+                           uint32_t *length, uint8_t *flags,
+                           uint8_t *version);
+
+#endif /* MLAG_WIRE_H_ */
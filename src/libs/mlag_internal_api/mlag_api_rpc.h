@@ -32,6 +32,8 @@
 #include "mlag_defs.h"
 #include "mlag_api_defs.h"
 #include <complib/sx_rpc.h>
+#include "mlag_fdb_cursor.h"
+#include <libs/notification_layer/notification_layer.h>
 
 /************************************************
  *  Defines
@@ -85,6 +87,21 @@ enum mlag_internal_api_cmd {
     MLAG_INTERNAL_API_CMD_LACP_SYS_ID_SET,
     MLAG_INTERNAL_API_CMD_LACP_ACTOR_PARAMS_GET,
     MLAG_INTERNAL_API_CMD_LACP_SELECT_REQUEST,
+    MLAG_INTERNAL_API_CMD_KEEPALIVE_PARAMS_SET,
+    MLAG_INTERNAL_API_CMD_KEEPALIVE_PARAMS_GET,
+    MLAG_INTERNAL_API_CMD_PORTS_SET,
+    MLAG_INTERNAL_API_CMD_PORTS_CFG_STATE_GET,
+    MLAG_INTERNAL_API_CMD_LACP_SELECTIONS_REQUEST,
+    MLAG_INTERNAL_API_CMD_FDB_CURSOR_OPEN,
+    MLAG_INTERNAL_API_CMD_FDB_CURSOR_READ,
+    MLAG_INTERNAL_API_CMD_FDB_CURSOR_CLOSE,
+    MLAG_INTERNAL_API_CMD_NOTIFY_SUBSCRIBE,
+    MLAG_INTERNAL_API_CMD_NOTIFY_UNSUBSCRIBE,
+    MLAG_INTERNAL_API_CMD_EVENT_LATENCY_GET,
+    MLAG_INTERNAL_API_CMD_HEARTBEAT_THREAD_PARAMS_SET,
+    MLAG_INTERNAL_API_CMD_HEARTBEAT_THREAD_PARAMS_GET,
+    MLAG_INTERNAL_API_CMD_IGMP_PARAMS_SET,
+    MLAG_INTERNAL_API_CMD_IGMP_PARAMS_GET,
 };
 
 /************************************************
@@ -222,6 +239,25 @@ struct mlag_api_port_set_params {
     const unsigned long port_id;
 };
 
+/**
+ * mlag_api_ports_set_params structure is used to store
+ * mlag_api_ports_set function parameters.
+ */
+struct mlag_api_ports_set_params {
+    enum access_cmd access_cmd;
+    unsigned int ports_cnt;
+    unsigned long ports[0];
+};
+
+/**
+ * mlag_api_ports_cfg_state_get_params structure is used to store
+ * mlag_api_ports_cfg_state_get function parameters.
+ */
+struct mlag_api_ports_cfg_state_get_params {
+    unsigned int ports_cnt;
+    struct mlag_port_cfg_info ports_cfg[0];
+};
+
 /**
  * mlag_api_ipl_set_params structure is used to store
  * mlag_api_ipl_set function parameters.
@@ -350,6 +386,67 @@ struct mlag_api_lacp_selection_request_params {
     unsigned char force;
 };
 
+/**
+ * mlag_api_lacp_selections_request_params structure is used to store
+ * mlag_api_lacp_selections_request function parameters.
+ */
+struct mlag_api_lacp_selections_request_params {
+    unsigned int selections_cnt;
+    struct lacp_selection_info selections[0];
+};
+
+/**
+ * mlag_api_fdb_cursor_open_params structure is used to store
+ * mlag_api_fdb_cursor_open function parameters.
+ */
+struct mlag_api_fdb_cursor_open_params {
+    struct fdb_uc_key_filter key_filter;
+    unsigned int cursor_id;
+    unsigned int capacity;
+    char shm_name[MLAG_FDB_CURSOR_SHM_NAME_LEN];
+};
+
+/**
+ * mlag_api_fdb_cursor_read_params structure is used to store
+ * mlag_api_fdb_cursor_read and mlag_api_fdb_cursor_close function
+ * parameters.
+ */
+struct mlag_api_fdb_cursor_read_params {
+    unsigned int cursor_id;
+    unsigned int data_cnt;
+    int eof;
+};
+
+/**
+ * mlag_api_notify_subscribe_params structure is used to store
+ * mlag_api_notify_subscribe function parameters.
+ */
+struct mlag_api_notify_subscribe_params {
+    uint32_t interest_mask;
+    int pid;
+    char sock_name[MLAG_NOTIFY_NAME_LEN];
+    unsigned int subscriber_id;
+    char ring_name[MLAG_NOTIFY_NAME_LEN];
+};
+
+/**
+ * mlag_api_notify_unsubscribe_params structure is used to store
+ * mlag_api_notify_unsubscribe function parameters.
+ */
+struct mlag_api_notify_unsubscribe_params {
+    unsigned int subscriber_id;
+};
+
+/**
+ * mlag_api_event_latency_get_params structure is used to store
+ * mlag_api_event_latency_get function parameters.
+ */
+struct mlag_api_event_latency_get_params {
+    unsigned int start;
+    unsigned int latency_cnt;
+    struct mlag_event_latency latency_list[0];
+};
+
 /************************************************
  *  Global variables
  ***********************************************/
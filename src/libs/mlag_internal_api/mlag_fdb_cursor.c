@@ -0,0 +1,376 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mlag_log.h"
+#include "mlag_bail.h"
+#include "mlag_defs.h"
+#include "mlag_fdb_cursor.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#undef  __MODULE__
+#define __MODULE__ MLAG_INTERNAL_API
+
+/* ctrl_learn returns at most this many entries per call */
+#define FDB_CURSOR_CHUNK_MAX   32768
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/* Cursor id holds the table index in the low byte, and a generation
+ * above it so a stale id of a reused cursor is not accepted
+ */
+#define FDB_CURSOR_ID(idx, gen)   (((gen) << 8) | (idx))
+#define FDB_CURSOR_IDX(id)        ((id) & 0xff)
+
+#define FDB_CURSOR_PAGE_SIZE \
+    (MLAG_FDB_CURSOR_PAGE_MAX * sizeof(struct fdb_uc_mac_addr_params))
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+struct fdb_cursor {
+    int in_use;
+    unsigned int id;
+    struct fdb_uc_key_filter key_filter;
+    /* last entry read, the next read continues after it */
+    struct fdb_uc_mac_addr_params last;
+    int started;
+    int eof;
+    time_t last_used;
+    char shm_name[MLAG_FDB_CURSOR_SHM_NAME_LEN];
+    struct fdb_uc_mac_addr_params *page;
+};
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) =
+    MLAG_VERBOSITY_LEVEL_NOTICE;
+
+static struct fdb_cursor fdb_cursors[MLAG_FDB_CURSORS_MAX];
+static unsigned int fdb_cursor_gen = 0;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ * Gets an open cursor by its id
+ *
+ * @param[in] cursor_id - cursor id
+ *
+ * @return cursor, NULL if it is not open
+ */
+static struct fdb_cursor *
+fdb_cursor_get(unsigned int cursor_id)
+{
+    struct fdb_cursor *cursor = NULL;
+    unsigned int idx = FDB_CURSOR_IDX(cursor_id);
+
+    if (idx < MLAG_FDB_CURSORS_MAX) {
+        cursor = &fdb_cursors[idx];
+        if (!cursor->in_use || (cursor->id != cursor_id)) {
+            cursor = NULL;
+        }
+    }
+
+    return cursor;
+}
+
+/*
+ * Releases the cursor and its shared memory page
+ *
+ * @param[in] cursor - cursor
+ *
+ * @return void
+ */
+static void
+fdb_cursor_release(struct fdb_cursor *cursor)
+{
+    if (cursor->page != NULL) {
+        munmap(cursor->page, FDB_CURSOR_PAGE_SIZE);
+    }
+    if (cursor->shm_name[0] != '\0') {
+        shm_unlink(cursor->shm_name);
+    }
+    SAFE_MEMSET(cursor, 0);
+}
+
+/*
+ * Creates the shared memory page of the cursor
+ *
+ * @param[in] cursor - cursor
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+fdb_cursor_page_create(struct fdb_cursor *cursor)
+{
+    int err = 0;
+    int fd = -1;
+    void *page = NULL;
+
+    snprintf(cursor->shm_name, sizeof(cursor->shm_name),
+             "/mlag_fdb_cursor_%d_%u", (int)getpid(),
+             FDB_CURSOR_IDX(cursor->id));
+
+    fd = shm_open(cursor->shm_name, O_RDWR | O_CREAT | O_TRUNC,
+                  S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to create FDB cursor page %s\n",
+                            cursor->shm_name);
+    }
+
+    if (ftruncate(fd, FDB_CURSOR_PAGE_SIZE) < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to size FDB cursor page %s\n",
+                            cursor->shm_name);
+    }
+
+    page = mmap(NULL, FDB_CURSOR_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+    if (page == MAP_FAILED) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to map FDB cursor page %s\n",
+                            cursor->shm_name);
+    }
+    cursor->page = page;
+
+bail:
+    if (fd >= 0) {
+        close(fd);
+    }
+    return err;
+}
+
+/**
+ * Opens a cursor on the SW FDB table. The cursor keeps its position
+ * between reads and owns a shared memory page, the reads fill it and
+ * the client maps it to fetch the entries.
+ *
+ * @param[in] key_filter - vid / logical port filter, applied when the
+ *                         entries are read
+ * @param[out] cursor_id - cursor id, to be passed to read and close
+ * @param[out] shm_name - name of the shared memory page, of
+ *                        MLAG_FDB_CURSOR_SHM_NAME_LEN bytes
+ * @param[out] capacity - MAC entries the page holds
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - All cursors are in use.
+ * @return -EIO - Operation failure.
+ */
+int
+mlag_fdb_cursor_open(const struct fdb_uc_key_filter *key_filter,
+                     unsigned int *cursor_id, char *shm_name,
+                     unsigned int *capacity)
+{
+    int err = 0;
+    unsigned int idx;
+    time_t now = time(NULL);
+    struct fdb_cursor *cursor = NULL;
+
+    MLAG_BAIL_CHECK(key_filter != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(cursor_id != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(shm_name != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(capacity != NULL, -EINVAL);
+
+    for (idx = 0; idx < MLAG_FDB_CURSORS_MAX; idx++) {
+        if (fdb_cursors[idx].in_use &&
+            ((now - fdb_cursors[idx].last_used) > MLAG_FDB_CURSOR_IDLE_SEC)) {
+            /* client went away without closing it */
+            MLAG_LOG(MLAG_LOG_NOTICE, "FDB cursor %u idle, closed\n",
+                     fdb_cursors[idx].id);
+            fdb_cursor_release(&fdb_cursors[idx]);
+        }
+        if ((cursor == NULL) && !fdb_cursors[idx].in_use) {
+            cursor = &fdb_cursors[idx];
+        }
+    }
+    if (cursor == NULL) {
+        err = -ENOSPC;
+        MLAG_BAIL_ERROR_MSG(err, "No free FDB cursor\n");
+    }
+
+    idx = cursor - fdb_cursors;
+    fdb_cursor_gen = (fdb_cursor_gen + 1) & 0xffffff;
+    cursor->id = FDB_CURSOR_ID(idx, fdb_cursor_gen);
+    cursor->key_filter = *key_filter;
+    cursor->last_used = now;
+
+    err = fdb_cursor_page_create(cursor);
+    if (err) {
+        fdb_cursor_release(cursor);
+        goto bail;
+    }
+    cursor->in_use = TRUE;
+
+    *cursor_id = cursor->id;
+    strncpy(shm_name, cursor->shm_name, MLAG_FDB_CURSOR_SHM_NAME_LEN);
+    *capacity = MLAG_FDB_CURSOR_PAGE_MAX;
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "FDB cursor %u opened, page %s\n",
+             cursor->id, cursor->shm_name);
+
+bail:
+    return err;
+}
+
+/**
+ * Reads the next page of the cursor into its shared memory page.
+ *
+ * @param[in] cursor_id - cursor id
+ * @param[out] data_cnt - MAC entries in the page
+ * @param[out] eof - TRUE if no entries follow this page
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - Cursor is not open.
+ * @return -EIO - Operation failure.
+ */
+int
+mlag_fdb_cursor_read(unsigned int cursor_id, unsigned int *data_cnt,
+                     int *eof)
+{
+    int err = 0;
+    unsigned int filled = 0;
+    unsigned int chunk;
+    unsigned short cnt;
+    enum oes_access_cmd access_cmd;
+    struct fdb_cursor *cursor = fdb_cursor_get(cursor_id);
+
+    MLAG_BAIL_CHECK(data_cnt != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(eof != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(cursor != NULL, -ENOENT);
+
+    cursor->last_used = time(NULL);
+
+    while (!cursor->eof && (filled < MLAG_FDB_CURSOR_PAGE_MAX)) {
+        chunk = MLAG_FDB_CURSOR_PAGE_MAX - filled;
+        if (chunk > FDB_CURSOR_CHUNK_MAX) {
+            chunk = FDB_CURSOR_CHUNK_MAX;
+        }
+        cnt = chunk;
+        if (cursor->started) {
+            /* get next takes its key from the first entry */
+            cursor->page[filled] = cursor->last;
+            access_cmd = OES_ACCESS_CMD_GET_NEXT;
+        }
+        else {
+            access_cmd = OES_ACCESS_CMD_GET_FIRST;
+        }
+
+        err = ctrl_learn_api_uc_mac_addr_get(access_cmd,
+                                             &cursor->key_filter,
+                                             &cursor->page[filled],
+                                             &cnt, 1);
+        if (err == -ENOENT) {
+            err = 0;
+            cnt = 0;
+        }
+        if (err) {
+            err = -EIO;
+            MLAG_BAIL_ERROR_MSG(err, "Failed to read FDB cursor %u\n",
+                                cursor_id);
+        }
+        if (cnt == 0) {
+            cursor->eof = TRUE;
+            break;
+        }
+
+        cursor->started = TRUE;
+        filled += cnt;
+        cursor->last = cursor->page[filled - 1];
+    }
+
+    *data_cnt = filled;
+    *eof = cursor->eof;
+
+bail:
+    return err;
+}
+
+/**
+ * Closes the cursor and removes its shared memory page.
+ *
+ * @param[in] cursor_id - cursor id
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - Cursor is not open.
+ */
+int
+mlag_fdb_cursor_close(unsigned int cursor_id)
+{
+    int err = 0;
+    struct fdb_cursor *cursor = fdb_cursor_get(cursor_id);
+
+    MLAG_BAIL_CHECK(cursor != NULL, -ENOENT);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "FDB cursor %u closed\n", cursor_id);
+    fdb_cursor_release(cursor);
+
+bail:
+    return err;
+}
+
+/**
+ * Closes all cursors. Called when the RPC layer is de-initialized.
+ *
+ * @return void
+ */
+void
+mlag_fdb_cursor_deinit(void)
+{
+    int idx;
+
+    for (idx = 0; idx < MLAG_FDB_CURSORS_MAX; idx++) {
+        if (fdb_cursors[idx].in_use) {
+            fdb_cursor_release(&fdb_cursors[idx]);
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MLAG_FDB_CURSOR_H_
+#define MLAG_FDB_CURSOR_H_
+
+#include <mlnx_lib/lib_ctrl_learn.h>
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* Cursors open at the same time */
+#define MLAG_FDB_CURSORS_MAX           4
+/* MAC entries in the shared memory page of a cursor */
+#define MLAG_FDB_CURSOR_PAGE_MAX       65536
+/* Unused cursor is reclaimed by the next open after this time */
+#define MLAG_FDB_CURSOR_IDLE_SEC       60
+/* Length of the shared memory page name, including NUL */
+#define MLAG_FDB_CURSOR_SHM_NAME_LEN   32
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ * Opens a cursor on the SW FDB table. The cursor keeps its position
+ * between reads and owns a shared memory page, the reads fill it and
+ * the client maps it to fetch the entries.
+ *
+ * @param[in] key_filter - vid / logical port filter, applied when the
+ *                         entries are read
+ * @param[out] cursor_id - cursor id, to be passed to read and close
+ * @param[out] shm_name - name of the shared memory page, of
+ *                        MLAG_FDB_CURSOR_SHM_NAME_LEN bytes
+ * @param[out] capacity - MAC entries the page holds
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - All cursors are in use.
+ * @return -EIO - Operation failure.
+ */
+int
+mlag_fdb_cursor_open(const struct fdb_uc_key_filter *key_filter,
+                     unsigned int *cursor_id, char *shm_name,
+                     unsigned int *capacity);
+
+/**
+ * Reads the next page of the cursor into its shared memory page.
+ *
+ * @param[in] cursor_id - cursor id
+ * @param[out] data_cnt - MAC entries in the page
+ * @param[out] eof - TRUE if no entries follow this page
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - Cursor is not open.
+ * @return -EIO - Operation failure.
+ */
+int
+mlag_fdb_cursor_read(unsigned int cursor_id, unsigned int *data_cnt,
+                     int *eof);
+
+/**
+ * Closes the cursor and removes its shared memory page.
+ *
+ * @param[in] cursor_id - cursor id
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - Cursor is not open.
+ */
+int
+mlag_fdb_cursor_close(unsigned int cursor_id);
+
+/**
+ * Closes all cursors. Called when the RPC layer is de-initialized.
+ *
+ * @return void
+ */
+void
+mlag_fdb_cursor_deinit(void);
+
+#endif /* MLAG_FDB_CURSOR_H_ */
@@ -30,6 +30,7 @@
 #include "mlag_internal_api.h"
 #include "mlag_bail.h"
 #include "mlag_api_rpc.h"
+#include "mlag_fdb_cursor.h"
 #include <errno.h>
 #include <arpa/inet.h>
 #include <mlnx_lib/lib_ctrl_learn.h>
@@ -165,6 +166,38 @@ sx_rpc_api_command_t mlag_api_command_id[] = {
       mlag_internal_api_lacp_actor_parameters_get, SX_RPC_API_CMD_PRIO_HIGH },
     { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_LACP_SELECT_REQUEST),
       mlag_internal_api_lacp_selection_request, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_KEEPALIVE_PARAMS_SET),
+      mlag_internal_api_keepalive_params_set, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_KEEPALIVE_PARAMS_GET),
+      mlag_internal_api_keepalive_params_get, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_PORTS_SET),
+      mlag_internal_api_ports_set, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_PORTS_CFG_STATE_GET),
+      mlag_internal_api_ports_cfg_state_get, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_LACP_SELECTIONS_REQUEST),
+      mlag_internal_api_lacp_selections_request, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_FDB_CURSOR_OPEN),
+      mlag_internal_api_fdb_cursor_open, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_FDB_CURSOR_READ),
+      mlag_internal_api_fdb_cursor_read, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_FDB_CURSOR_CLOSE),
+      mlag_internal_api_fdb_cursor_close, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_NOTIFY_SUBSCRIBE),
+      mlag_internal_api_notify_subscribe, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_NOTIFY_UNSUBSCRIBE),
+      mlag_internal_api_notify_unsubscribe, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_EVENT_LATENCY_GET),
+      mlag_internal_api_event_latency_get, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_HEARTBEAT_THREAD_PARAMS_SET),
+      mlag_internal_api_heartbeat_thread_params_set,
+      SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_HEARTBEAT_THREAD_PARAMS_GET),
+      mlag_internal_api_heartbeat_thread_params_get,
+      SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_IGMP_PARAMS_SET),
+      mlag_internal_api_igmp_params_set, SX_RPC_API_CMD_PRIO_HIGH },
+    { COMMAND_ID_REPLICA(MLAG_INTERNAL_API_CMD_IGMP_PARAMS_GET),
+      mlag_internal_api_igmp_params_get, SX_RPC_API_CMD_PRIO_HIGH },
 };
 /************************************************
  *  Local variables
@@ -340,6 +373,9 @@ mlag_rpc_deinit()
 
     MLAG_LOG(MLAG_LOG_DEBUG, "Mlag rpc deinit\n");
 
+    mlag_fdb_cursor_deinit();
+    mlag_notify_deinit();
+
     err = sx_rpc_api_rpc_command_db_deinit();
     if (err != SX_RPC_STATUS_SUCCESS) {
         err = -EIO;
@@ -1032,6 +1068,258 @@ bail:
     return err;
 }
 
+/**
+ * Specifies the keep-alive interval in milliseconds and the detection
+ * multiplier.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_keepalive_params_set(uint8_t *rcv_msg_body,
+                                       uint32_t rcv_len,
+                                       uint8_t **snd_body,
+                                       uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_RPC_POINTER_PARAM_AND_CHECK(struct mlag_keepalive_params, rpc_param);
+
+    /* validate parameter */
+    MLAG_BAIL_CHECK((rpc_param->interval_msec >=
+                     MLAG_KEEPALIVE_INTERVAL_MSEC_MIN) &&
+                    (rpc_param->interval_msec <=
+                     MLAG_KEEPALIVE_INTERVAL_MSEC_MAX), -EINVAL);
+    MLAG_BAIL_CHECK((rpc_param->multiplier >= MLAG_KEEPALIVE_MULTIPLIER_MIN) &&
+                    (rpc_param->multiplier <= MLAG_KEEPALIVE_MULTIPLIER_MAX),
+                    -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "Keep-alive params set. msec [%u] multiplier [%u]\n",
+             rpc_param->interval_msec, rpc_param->multiplier);
+
+    err = mlag_keepalive_params_set(rpc_param);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    RETURN_EMPTY_REPLY(snd_body, snd_len);
+
+bail:
+    return err;
+}
+
+/**
+ * Populates the current keep-alive interval in milliseconds and the
+ * detection multiplier.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_keepalive_params_get(uint8_t *rcv_msg_body,
+                                       uint32_t rcv_len,
+                                       uint8_t **snd_body,
+                                       uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_RPC_POINTER_PARAM_AND_CHECK(struct mlag_keepalive_params, rpc_param);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Get keep-alive params\n");
+
+    err = mlag_keepalive_params_get(rpc_param);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "Keepalive params msec [%u] multiplier [%u]\n",
+             rpc_param->interval_msec, rpc_param->multiplier);
+
+    (*snd_body) = (uint8_t *)(rpc_param);
+    (*snd_len) = sizeof(*rpc_param);
+
+bail:
+    return err;
+}
+
+/**
+ * Sets the scheduling of the heartbeat thread.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_heartbeat_thread_params_set(uint8_t *rcv_msg_body,
+                                              uint32_t rcv_len,
+                                              uint8_t **snd_body,
+                                              uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_RPC_POINTER_PARAM_AND_CHECK(struct mlag_heartbeat_thread_params,
+                                     rpc_param);
+
+    /* validate parameter */
+    MLAG_BAIL_CHECK((rpc_param->rt_priority >= 0) &&
+                    (rpc_param->rt_priority <=
+                     MLAG_HEARTBEAT_THREAD_RT_PRIO_MAX), -EINVAL);
+    MLAG_BAIL_CHECK((rpc_param->cpu >= -1) &&
+                    (rpc_param->cpu <= MLAG_HEARTBEAT_THREAD_CPU_MAX),
+                    -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "Heartbeat thread params set. priority [%d] cpu [%d]\n",
+             rpc_param->rt_priority, rpc_param->cpu);
+
+    err = mlag_heartbeat_thread_params_set(rpc_param);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    RETURN_EMPTY_REPLY(snd_body, snd_len);
+
+bail:
+    return err;
+}
+
+/**
+ * Populates the current scheduling of the heartbeat thread.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_heartbeat_thread_params_get(uint8_t *rcv_msg_body,
+                                              uint32_t rcv_len,
+                                              uint8_t **snd_body,
+                                              uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_RPC_POINTER_PARAM_AND_CHECK(struct mlag_heartbeat_thread_params,
+                                     rpc_param);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Get heartbeat thread params\n");
+
+    err = mlag_heartbeat_thread_params_get(rpc_param);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    (*snd_body) = (uint8_t *)(rpc_param);
+    (*snd_len) = sizeof(*rpc_param);
+
+bail:
+    return err;
+}
+
+/**
+ * Sets the tunneled IGMP suppression parameters.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_igmp_params_set(uint8_t *rcv_msg_body,
+                               uint32_t rcv_len,
+                               uint8_t **snd_body,
+                               uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_RPC_POINTER_PARAM_AND_CHECK(struct mlag_igmp_params, rpc_param);
+
+    /* validate parameter */
+    MLAG_BAIL_CHECK((rpc_param->suppress_window_msec <=
+                     MLAG_IGMP_SUPPRESS_WINDOW_MSEC_MAX), -EINVAL);
+    MLAG_BAIL_CHECK((rpc_param->rate_limit <= MLAG_IGMP_RATE_LIMIT_MAX),
+                    -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "IGMP params set. suppress window [%u] rate limit [%u]\n",
+             rpc_param->suppress_window_msec, rpc_param->rate_limit);
+
+    err = mlag_igmp_params_set(rpc_param);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    RETURN_EMPTY_REPLY(snd_body, snd_len);
+
+bail:
+    return err;
+}
+
+/**
+ * Populates the tunneled IGMP suppression parameters in use.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_igmp_params_get(uint8_t *rcv_msg_body,
+                               uint32_t rcv_len,
+                               uint8_t **snd_body,
+                               uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_RPC_POINTER_PARAM_AND_CHECK(struct mlag_igmp_params, rpc_param);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Get IGMP params\n");
+
+    err = mlag_igmp_params_get(rpc_param);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    (*snd_body) = (uint8_t *)(rpc_param);
+    (*snd_len) = sizeof(*rpc_param);
+
+bail:
+    return err;
+}
+
 /**
  * Adds/deletes MLAG port.
  * This function works asynchronously. After verifying its arguments are valid,
@@ -1074,6 +1362,119 @@ bail:
     return err;
 }
 
+/**
+ * Adds/deletes several MLAG ports in one operation.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - Too many port operations are still pending.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_ports_set(uint8_t *rcv_msg_body,
+                            uint32_t rcv_len,
+                            uint8_t **snd_body,
+                            uint32_t *snd_len)
+{
+    int err = 0;
+    struct mlag_api_ports_set_params *ports_set_params = NULL;
+
+    err = check_message_size_less(rcv_len,
+                                  sizeof(struct mlag_api_ports_set_params));
+    MLAG_BAIL_ERROR(err);
+    ports_set_params = (struct mlag_api_ports_set_params *)rcv_msg_body;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(ports_set_params != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((ports_set_params->ports_cnt > 0) &&
+                    (ports_set_params->ports_cnt <= MLAG_MAX_PORTS_LIMIT),
+                    -EINVAL);
+    err = check_message_size_equal(rcv_len,
+                                   sizeof(struct mlag_api_ports_set_params) +
+                                   (ports_set_params->ports_cnt *
+                                    sizeof(unsigned long)));
+    MLAG_BAIL_ERROR(err);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "%s [%u] mlag ports\n",
+             ACCESS_COMMAND_STR(ports_set_params->access_cmd),
+             ports_set_params->ports_cnt);
+
+    err = mlag_ports_set(ports_set_params->access_cmd,
+                         ports_set_params->ports,
+                         ports_set_params->ports_cnt);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    RETURN_EMPTY_REPLY(snd_body, snd_len);
+
+bail:
+    return err;
+}
+
+/**
+ * Populates the add/delete progress of the given ports.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_ports_cfg_state_get(uint8_t *rcv_msg_body,
+                                      uint32_t rcv_len,
+                                      uint8_t **snd_body,
+                                      uint32_t *snd_len)
+{
+    int err = 0;
+    struct mlag_api_ports_cfg_state_get_params *cfg_state_params = NULL;
+
+    err = check_message_size_less(rcv_len,
+                                  sizeof(struct
+                                         mlag_api_ports_cfg_state_get_params));
+    MLAG_BAIL_ERROR(err);
+    cfg_state_params =
+        (struct mlag_api_ports_cfg_state_get_params *)rcv_msg_body;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(cfg_state_params != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((cfg_state_params->ports_cnt > 0) &&
+                    (cfg_state_params->ports_cnt <= MLAG_MAX_PORTS_LIMIT),
+                    -EINVAL);
+    err = check_message_size_equal(
+        rcv_len,
+        sizeof(struct mlag_api_ports_cfg_state_get_params) +
+        (cfg_state_params->ports_cnt * sizeof(struct mlag_port_cfg_info)));
+    MLAG_BAIL_ERROR(err);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Get cfg state of [%u] mlag ports\n",
+             cfg_state_params->ports_cnt);
+
+    err = mlag_ports_cfg_state_get(cfg_state_params->ports_cfg,
+                                   cfg_state_params->ports_cnt);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    (*snd_body) = (uint8_t *)(cfg_state_params);
+    (*snd_len) = rcv_len;
+
+bail:
+    return err;
+}
+
 /**
  * Creates/deletes an IPL.
  * This function works synchronously and blocks until the operation is completed.
@@ -1857,6 +2258,255 @@ bail:
     return err;
 }
 
+/**
+ * Opens a cursor on the SW FDB table, pages of MAC entries are read
+ * through it into shared memory.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - All cursors are in use.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_fdb_cursor_open(uint8_t *rcv_msg_body,
+                                  uint32_t rcv_len,
+                                  uint8_t **snd_body,
+                                  uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_STRUCT_AND_CHECK(fdb_cursor_open_params);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Open FDB cursor\n");
+
+    BAIL_MLAG_NOT_INIT();
+
+    err = mlag_fdb_cursor_open(&fdb_cursor_open_params->key_filter,
+                               &fdb_cursor_open_params->cursor_id,
+                               fdb_cursor_open_params->shm_name,
+                               &fdb_cursor_open_params->capacity);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    (*snd_body) = (uint8_t *)fdb_cursor_open_params;
+    (*snd_len) = sizeof(*fdb_cursor_open_params);
+
+bail:
+    return err;
+}
+
+/**
+ * Reads the next page of MAC entries of an FDB cursor into its shared
+ * memory.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - Cursor is not open.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_fdb_cursor_read(uint8_t *rcv_msg_body,
+                                  uint32_t rcv_len,
+                                  uint8_t **snd_body,
+                                  uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_STRUCT_AND_CHECK(fdb_cursor_read_params);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Read FDB cursor %u\n",
+             fdb_cursor_read_params->cursor_id);
+
+    BAIL_MLAG_NOT_INIT();
+
+    err = mlag_fdb_cursor_read(fdb_cursor_read_params->cursor_id,
+                               &fdb_cursor_read_params->data_cnt,
+                               &fdb_cursor_read_params->eof);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    (*snd_body) = (uint8_t *)fdb_cursor_read_params;
+    (*snd_len) = sizeof(*fdb_cursor_read_params);
+
+bail:
+    return err;
+}
+
+/**
+ * Closes an FDB cursor.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - Cursor is not open.
+ */
+int
+mlag_internal_api_fdb_cursor_close(uint8_t *rcv_msg_body,
+                                   uint32_t rcv_len,
+                                   uint8_t **snd_body,
+                                   uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_STRUCT_AND_CHECK(fdb_cursor_read_params);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Close FDB cursor %u\n",
+             fdb_cursor_read_params->cursor_id);
+
+    err = mlag_fdb_cursor_close(fdb_cursor_read_params->cursor_id);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    RETURN_EMPTY_REPLY(snd_body, snd_len);
+
+bail:
+    return err;
+}
+
+/**
+ * Adds a notification subscriber. The eventfd of the subscriber is
+ * passed on the unix socket it listens on, before the reply.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - All subscribers are in use.
+ * @return -EIO - Operation failure.
+ */
+int
+mlag_internal_api_notify_subscribe(uint8_t *rcv_msg_body,
+                                   uint32_t rcv_len,
+                                   uint8_t **snd_body,
+                                   uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_STRUCT_AND_CHECK(notify_subscribe_params);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Notification subscribe, pid [%d]\n",
+             notify_subscribe_params->pid);
+
+    notify_subscribe_params->sock_name[MLAG_NOTIFY_NAME_LEN - 1] = '\0';
+    err = mlag_notify_subscribe(notify_subscribe_params->interest_mask,
+                                notify_subscribe_params->pid,
+                                notify_subscribe_params->sock_name,
+                                &notify_subscribe_params->subscriber_id,
+                                notify_subscribe_params->ring_name);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    (*snd_body) = (uint8_t *)notify_subscribe_params;
+    (*snd_len) = sizeof(*notify_subscribe_params);
+
+bail:
+    return err;
+}
+
+/**
+ * Removes a notification subscriber.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - Subscriber does not exist.
+ */
+int
+mlag_internal_api_notify_unsubscribe(uint8_t *rcv_msg_body,
+                                     uint32_t rcv_len,
+                                     uint8_t **snd_body,
+                                     uint32_t *snd_len)
+{
+    int err = 0;
+    INIT_STRUCT_AND_CHECK(notify_unsubscribe_params);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "Notification unsubscribe [%u]\n",
+             notify_unsubscribe_params->subscriber_id);
+
+    err = mlag_notify_unsubscribe(notify_unsubscribe_params->subscriber_id);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    RETURN_EMPTY_REPLY(snd_body, snd_len);
+
+bail:
+    return err;
+}
+
+/**
+ * Gets the dispatcher latency histograms per opcode.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_event_latency_get(uint8_t *rcv_msg_body,
+                                    uint32_t rcv_len,
+                                    uint8_t **snd_body,
+                                    uint32_t *snd_len)
+{
+    int err = 0;
+    struct mlag_api_event_latency_get_params *latency_get_params = NULL;
+    err = check_message_size_less(rcv_len,
+                                  sizeof(struct mlag_api_event_latency_get_params));
+    MLAG_BAIL_ERROR(err);
+    latency_get_params =
+        (struct mlag_api_event_latency_get_params *)rcv_msg_body;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(latency_get_params != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(latency_get_params->latency_cnt > 0, -EINVAL);
+    MLAG_BAIL_CHECK(latency_get_params->latency_cnt <=
+                    (rcv_len - sizeof(*latency_get_params)) /
+                    sizeof(struct mlag_event_latency), -EINVAL);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "Get event latency from [%u], entries number is [%u]\n",
+             latency_get_params->start, latency_get_params->latency_cnt);
+
+    err = mlag_event_latency_get(latency_get_params->start,
+                                 latency_get_params->latency_list,
+                                 &(latency_get_params->latency_cnt));
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    (*snd_body) = (uint8_t *)(latency_get_params);
+    (*snd_len) = sizeof(struct mlag_api_event_latency_get_params) +
+                 (latency_get_params->latency_cnt *
+                  sizeof(struct mlag_event_latency));
+
+bail:
+    return err;
+}
+
 /**
  * Initializes the control learning library.
  * This function works synchronously and blocks until the operation is completed.
@@ -2320,4 +2970,61 @@ bail:
     return err;
 }
 
+/**
+ * Triggers aggregator selection queries of several ports in one operation.
+ * Since MLAG is distributed, this request may involve a remote peer, so
+ * this function works asynchronously. The response of each selection is
+ * guaranteed and it is issued as a notification when it is available.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_lacp_selections_request(uint8_t *rcv_msg_body,
+                                          uint32_t rcv_len,
+                                          uint8_t **snd_body,
+                                          uint32_t *snd_len)
+{
+    int err = 0;
+    struct mlag_api_lacp_selections_request_params *selections_params = NULL;
+
+    err = check_message_size_less(
+        rcv_len, sizeof(struct mlag_api_lacp_selections_request_params));
+    MLAG_BAIL_ERROR(err);
+    selections_params =
+        (struct mlag_api_lacp_selections_request_params *)rcv_msg_body;
+
+    /* validate parameters */
+    MLAG_BAIL_CHECK(selections_params != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((selections_params->selections_cnt > 0) &&
+                    (selections_params->selections_cnt <=
+                     MLAG_MAX_PORTS_LIMIT), -EINVAL);
+    err = check_message_size_equal(
+        rcv_len,
+        sizeof(struct mlag_api_lacp_selections_request_params) +
+        (selections_params->selections_cnt *
+         sizeof(struct lacp_selection_info)));
+    MLAG_BAIL_ERROR(err);
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "lacp selections request of [%u] ports\n",
+             selections_params->selections_cnt);
+
+    err = mlag_lacp_selections_request(selections_params->selections,
+                                       selections_params->selections_cnt);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    RETURN_EMPTY_REPLY(snd_body, snd_len);
+
+bail:
+    return err;
+}
+
 
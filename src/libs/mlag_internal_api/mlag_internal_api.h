@@ -367,6 +367,134 @@ mlag_internal_api_keepalive_interval_get(uint8_t *rcv_msg_body,
                                          uint32_t rcv_len, uint8_t **snd_body,
                                          uint32_t *snd_len);
 
+/**
+ * Specifies the keep-alive interval in milliseconds and the detection
+ * multiplier.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_keepalive_params_set(uint8_t *rcv_msg_body,
+                                       uint32_t rcv_len, uint8_t **snd_body,
+                                       uint32_t *snd_len);
+
+/**
+ * Populates the current keep-alive interval in milliseconds and the
+ * detection multiplier.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_keepalive_params_get(uint8_t *rcv_msg_body,
+                                       uint32_t rcv_len, uint8_t **snd_body,
+                                       uint32_t *snd_len);
+
+/**
+ * Sets the scheduling of the heartbeat thread.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_heartbeat_thread_params_set(uint8_t *rcv_msg_body,
+                                              uint32_t rcv_len,
+                                              uint8_t **snd_body,
+                                              uint32_t *snd_len);
+
+/**
+ * Populates the current scheduling of the heartbeat thread.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_heartbeat_thread_params_get(uint8_t *rcv_msg_body,
+                                              uint32_t rcv_len,
+                                              uint8_t **snd_body,
+                                              uint32_t *snd_len);
+
+/**
+ * Sets the tunneled IGMP suppression parameters.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_igmp_params_set(uint8_t *rcv_msg_body,
+                               uint32_t rcv_len,
+                               uint8_t **snd_body,
+                               uint32_t *snd_len);
+
+/**
+ * Populates the tunneled IGMP suppression parameters in use.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_igmp_params_get(uint8_t *rcv_msg_body,
+                               uint32_t rcv_len,
+                               uint8_t **snd_body,
+                               uint32_t *snd_len);
+
 /**
  * Adds/deletes MLAG port.
  * This function works asynchronously. After verifying its arguments are valid,
@@ -387,6 +515,46 @@ int
 mlag_internal_api_port_set(uint8_t *rcv_msg_body, uint32_t rcv_len,
                            uint8_t **snd_body, uint32_t *snd_len);
 
+/**
+ * Adds/deletes several MLAG ports in one operation.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - Too many port operations are still pending.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_ports_set(uint8_t *rcv_msg_body, uint32_t rcv_len,
+                            uint8_t **snd_body, uint32_t *snd_len);
+
+/**
+ * Populates the add/delete progress of the given ports.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_ports_cfg_state_get(uint8_t *rcv_msg_body, uint32_t rcv_len,
+                                      uint8_t **snd_body, uint32_t *snd_len);
+
 /**
  * Creates/deletes an IPL.
  * This function works synchronously and blocks until the operation is completed.
@@ -928,6 +1096,142 @@ mlag_internal_api_lacp_selection_request(uint8_t *rcv_msg_body,
                                          uint32_t rcv_len, uint8_t **snd_body,
                                          uint32_t *snd_len);
 
+/**
+ * Triggers aggregator selection queries of several ports in one operation.
+ * Since MLAG is distributed, this request may involve a remote peer, so
+ * this function works asynchronously. The response of each selection is
+ * guaranteed and it is issued as a notification when it is available.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_lacp_selections_request(uint8_t *rcv_msg_body,
+                                          uint32_t rcv_len,
+                                          uint8_t **snd_body,
+                                          uint32_t *snd_len);
+
+/**
+ * Opens a cursor on the SW FDB table, pages of MAC entries are read
+ * through it into shared memory.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - All cursors are in use.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_fdb_cursor_open(uint8_t *rcv_msg_body, uint32_t rcv_len,
+                                  uint8_t **snd_body, uint32_t *snd_len);
+
+/**
+ * Reads the next page of MAC entries of an FDB cursor into its shared
+ * memory.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - Cursor is not open.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_fdb_cursor_read(uint8_t *rcv_msg_body, uint32_t rcv_len,
+                                  uint8_t **snd_body, uint32_t *snd_len);
+
+/**
+ * Closes an FDB cursor.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - Cursor is not open.
+ */
+int
+mlag_internal_api_fdb_cursor_close(uint8_t *rcv_msg_body, uint32_t rcv_len,
+                                   uint8_t **snd_body, uint32_t *snd_len);
+
+/**
+ * Adds a notification subscriber. The eventfd of the subscriber is
+ * passed on the unix socket it listens on, before the reply.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -ENOSPC - All subscribers are in use.
+ * @return -EIO - Operation failure.
+ */
+int
+mlag_internal_api_notify_subscribe(uint8_t *rcv_msg_body, uint32_t rcv_len,
+                                   uint8_t **snd_body, uint32_t *snd_len);
+
+/**
+ * Removes a notification subscriber.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOENT - Subscriber does not exist.
+ */
+int
+mlag_internal_api_notify_unsubscribe(uint8_t *rcv_msg_body, uint32_t rcv_len,
+                                     uint8_t **snd_body, uint32_t *snd_len);
+
+/**
+ * Gets the dispatcher latency histograms per opcode.
+ * This function works synchronously and blocks until the operation is completed.
+ *
+ * @param[in] rcv_msg_body - Contains the necessary parameters.
+ *                           Pointer to an already allocated memory structure.
+ * @param[in] rcv_len - Receive bytes.
+ * @param[out] snd_body - Response content.
+ * @param[out] snd_len - Response size.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_internal_api_event_latency_get(uint8_t *rcv_msg_body, uint32_t rcv_len,
+                                    uint8_t **snd_body, uint32_t *snd_len);
+
 /**
  * Initializes the RPC layer.
  * This function works synchronously and blocks until the operation is completed.
@@ -47,6 +47,7 @@
 #include "mlag_l3_interface_master_logic.h"
 #include "mlag_master_election.h"
 #include "mlag_comm_layer_wrapper.h"
+#include "mlag_wire.h"
 #include "mlag_manager.h"
 
 /************************************************
@@ -61,7 +62,6 @@
  *  Local Type definitions
  ***********************************************/
 static int rcv_msg_handler(uint8_t *data);
-static int net_order_msg_handler(uint8_t *data, int oper);
 
 /************************************************
  *  Global variables
@@ -79,20 +79,45 @@ static enum master_election_switch_status current_switch_status;
 
 static handler_command_t mlag_l3_interface_ibc_msgs[] = {
     {MLAG_L3_SYNC_START_EVENT, "L3 sync start event",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_L3_SYNC_FINISH_EVENT, "L3 sync finish event",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_L3_INTERFACE_MASTER_SYNC_DONE_EVENT, "L3 master sync done event",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_L3_INTERFACE_VLAN_LOCAL_STATE_CHANGE_FROM_PEER_EVENT,
      "Vlan local state change event from peer",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT,
      "Vlan global state change event",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {0, "", NULL, NULL}
 };
 
+static const struct mlag_wire_field l3_sync_event_wire[] = {
+    MLAG_WIRE_FIELD(struct sync_event_data, peer_id),
+    MLAG_WIRE_FIELD(struct sync_event_data, sync_type),
+    MLAG_WIRE_FIELD(struct sync_event_data, state),
+    MLAG_WIRE_FIELDS_END
+};
+
+/* Encoded vlan states are byte order independent */
+static const struct mlag_wire_field vlan_state_change_wire[] = {
+    MLAG_WIRE_FIELD(struct vlan_state_change_event_data, peer_id),
+    MLAG_WIRE_FIELD(struct vlan_state_change_event_data, vlans_arr_cnt),
+    MLAG_WIRE_FIELD(struct vlan_state_change_event_data, data_len),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_msg l3_interface_wire_msgs[] = {
+    MLAG_WIRE_MSG(MLAG_L3_SYNC_START_EVENT, l3_sync_event_wire),
+    MLAG_WIRE_MSG(MLAG_L3_SYNC_FINISH_EVENT, l3_sync_event_wire),
+    MLAG_WIRE_MSG(MLAG_L3_INTERFACE_MASTER_SYNC_DONE_EVENT, NULL),
+    MLAG_WIRE_MSG(MLAG_L3_INTERFACE_VLAN_LOCAL_STATE_CHANGE_FROM_PEER_EVENT,
+                  vlan_state_change_wire),
+    MLAG_WIRE_MSG(MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT,
+                  vlan_state_change_wire),
+};
+
 /************************************************
  *  Local function declarations
  ***********************************************/
@@ -153,6 +178,10 @@ mlag_l3_interface_init(insert_to_command_db_func insert_msgs)
     err = insert_msgs(mlag_l3_interface_ibc_msgs);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
+    err = mlag_wire_msgs_register(l3_interface_wire_msgs,
+                                  NUM_ELEMS(l3_interface_wire_msgs));
+    MLAG_BAIL_ERROR(err);
+
     err = mlag_l3_interface_peer_init();
     MLAG_BAIL_ERROR_MSG(err, "Failed in peer init, err=%d\n", err);
 
@@ -583,105 +612,6 @@ bail:
     return err;
 }
 
-/*
- *  This function is called to handle network order for IBC message
- *
- * @param[in] payload_data - message body
- * @param[in] oper - on send or receive
- *
- * @return 0 when successful, otherwise ERROR
- */
-static int
-net_order_msg_handler(uint8_t *data, int oper)
-{
-    int err = 0;
-    uint16_t opcode;
-    int i;
-
-    if (oper == MESSAGE_SENDING) {
-        opcode = *(uint16_t*)data;
-        *(uint16_t*)data = htons(opcode);
-    }
-    else {
-        opcode = ntohs(*(uint16_t*)data);
-        *(uint16_t*)data = opcode;
-    }
-
-    switch (opcode) {
-    case MLAG_L3_SYNC_START_EVENT: {
-        struct sync_event_data *ev =
-            (struct sync_event_data*)data;
-        if (oper == MESSAGE_SENDING) {
-            ev->peer_id = htons(ev->peer_id);
-            ev->state = htons(ev->state);
-        }
-        else {
-            ev->peer_id = ntohs(ev->peer_id);
-            ev->state = ntohs(ev->state);
-        }
-    }
-    break;
-    case MLAG_L3_SYNC_FINISH_EVENT: {
-        struct sync_event_data *ev =
-            (struct sync_event_data*)data;
-        if (oper == MESSAGE_SENDING) {
-            ev->peer_id = htons(ev->peer_id);
-            ev->state = htons(ev->state);
-        }
-        else {
-            ev->peer_id = ntohs(ev->peer_id);
-            ev->state = ntohs(ev->state);
-        }
-    }
-    break;
-    case MLAG_L3_INTERFACE_MASTER_SYNC_DONE_EVENT:
-        /* nothing to do */
-        break;
-    case MLAG_L3_INTERFACE_VLAN_LOCAL_STATE_CHANGE_FROM_PEER_EVENT: {
-        struct vlan_state_change_event_data *ev =
-            (struct vlan_state_change_event_data*)data;
-        if (oper == MESSAGE_SENDING) {
-            ev->peer_id = htons(ev->peer_id);
-            for (i = 0; i < ev->vlans_arr_cnt; i++) {
-                ev->vlan_data[i].vlan_id = htons(ev->vlan_data[i].vlan_id);
-            }
-        }
-        else {
-            ev->peer_id = ntohs(ev->peer_id);
-            for (i = 0; i < ev->vlans_arr_cnt; i++) {
-                ev->vlan_data[i].vlan_id = ntohs(ev->vlan_data[i].vlan_id);
-            }
-        }
-    }
-    break;
-    case MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT: {
-        struct vlan_state_change_event_data *ev =
-            (struct vlan_state_change_event_data*)data;
-        if (oper == MESSAGE_SENDING) {
-            ev->peer_id = htons(ev->peer_id);
-            for (i = 0; i < ev->vlans_arr_cnt; i++) {
-                ev->vlan_data[i].vlan_id = htons(ev->vlan_data[i].vlan_id);
-            }
-        }
-        else {
-            ev->peer_id = ntohs(ev->peer_id);
-            for (i = 0; i < ev->vlans_arr_cnt; i++) {
-                ev->vlan_data[i].vlan_id = ntohs(ev->vlan_data[i].vlan_id);
-            }
-        }
-    }
-    break;
-    default:
-        /* Unknown opcode */
-        MLAG_LOG(MLAG_LOG_NOTICE,
-                 "Unknown event %d in network ordering handler\n",
-                 opcode);
-        break;
-    }
-
-    return err;
-}
-
 /**
  *  This function handles vlan local state change event
  *
@@ -51,6 +51,7 @@
 #include "mlnx_lib/lib_commu.h"
 #include "mlag_comm_layer_wrapper.h"
 #include "mlag_dispatcher.h"
+#include "mlag_vlan_bitmap.h"
 
 /************************************************
  *  Local Defines
@@ -79,9 +80,14 @@ extern char *l3_interface_vlan_local_state_str[];
 static int is_started;
 static int is_inited;
 static enum mlag_manager_peer_state peer_state[MLAG_MAX_PEERS];
-static enum vlan_state vlan_peer_state[VLAN_N_VID][MLAG_MAX_PEERS];
-static enum l3_interface_vlan_global_state vlan_global_state[VLAN_N_VID];
+/* Vlans in up state per peer and global, bit per vlan id */
+static struct vlan_bitmap vlan_peer_up[MLAG_MAX_PEERS];
+static struct vlan_bitmap vlan_global_up;
+/* Vlan ids handled by master logic: 1..VLAN_N_VID-1 */
+static struct vlan_bitmap vlan_valid;
 static struct vlan_state_change_event_data vlan_state_change_event;
+static struct vlan_state_bitmap vlan_states;
+static struct vlan_state_bitmap vlan_changes;
 
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
 
@@ -126,7 +132,7 @@ int
 mlag_l3_interface_master_logic_init(void)
 {
     int err = 0;
-    int i, j;
+    int i;
 
     if (is_inited) {
         err = ECANCELED;
@@ -138,17 +144,15 @@ mlag_l3_interface_master_logic_init(void)
 
     is_started = 0;
     is_inited = 1;
-    for (i = 0; i < MLAG_MAX_PEERS; i++) {
-        peer_state[i] = PEER_DOWN;
-    }
-    for (i = 0; i < VLAN_N_VID; i++) {
-        vlan_global_state[i] = VLAN_GLOBAL_DOWN;
+    SAFE_MEMSET(&vlan_valid, 0);
+    for (i = 1; i < VLAN_N_VID; i++) {
+        VLAN_BITMAP_SET(&vlan_valid, i);
     }
     for (i = 0; i < MLAG_MAX_PEERS; i++) {
-        for (j = 0; j < VLAN_N_VID; j++) {
-            vlan_peer_state[j][i] = VLAN_DOWN;
-        }
+        peer_state[i] = PEER_DOWN;
     }
+    SAFE_MEMSET(&vlan_global_up, 0);
+    memset(vlan_peer_up, 0, sizeof(vlan_peer_up));
 
 bail:
     return err;
@@ -190,7 +194,7 @@ int
 mlag_l3_interface_master_logic_start(uint8_t *data)
 {
     int err = 0;
-    int i, j;
+    int i;
     UNUSED_PARAM(data);
 
     if (!is_inited) {
@@ -205,14 +209,8 @@ mlag_l3_interface_master_logic_start(uint8_t *data)
     for (i = 0; i < MLAG_MAX_PEERS; i++) {
         peer_state[i] = PEER_DOWN;
     }
-    for (i = 0; i < VLAN_N_VID; i++) {
-        vlan_global_state[i] = VLAN_GLOBAL_DOWN;
-    }
-    for (i = 0; i < MLAG_MAX_PEERS; i++) {
-        for (j = 0; j < VLAN_N_VID; j++) {
-            vlan_peer_state[j][i] = VLAN_DOWN;
-        }
-    }
+    SAFE_MEMSET(&vlan_global_up, 0);
+    memset(vlan_peer_up, 0, sizeof(vlan_peer_up));
 
 bail:
     return err;
@@ -243,43 +241,86 @@ bail:
     return err;
 }
 
-/**
- *  This function calculates global vlan state and
- *  set it into master logic data base
+/*
+ *  This function encodes global vlan state changes collected in
+ *  vlan_changes and sends them to peers
  *
- * @param[in] vlan_id - vlan id
+ * @param[in] peer_id - peer id to put into the event
+ * @param[in] dest_peer_id - destination peer id,
+ *                           MLAG_MAX_PEERS for all peers not in down state
  *
  * @return 0 when successful, otherwise ERROR
  */
-int
-mlag_l3_interface_master_logic_calc_global_state(
-    unsigned short vlan_id, int *is_changed)
+static int
+vlan_global_state_changes_send(int peer_id, int dest_peer_id)
 {
+    int err = 0;
     int i;
+    int ev_len = 0;
 
-    *is_changed = 0;
+    err = vlan_state_encode(&vlan_changes, &vlan_state_change_event,
+                            &ev_len);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to encode vlan global states\n");
+
+    vlan_state_change_event.opcode =
+        MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT;
+    vlan_state_change_event.peer_id = peer_id;
 
     for (i = 0; i < MLAG_MAX_PEERS; i++) {
-        if ((vlan_peer_state[vlan_id][i] == VLAN_UP) &&
-            (peer_state[i] == PEER_ENABLE)) {
-            /* Global vlan up */
-            if (vlan_global_state[vlan_id] == VLAN_GLOBAL_DOWN) {
-                /* changed */
-                vlan_global_state[vlan_id] = VLAN_GLOBAL_UP;
-                *is_changed = 1;
-            }
-            break;
+        if (((dest_peer_id == MLAG_MAX_PEERS) && (peer_state[i] != PEER_DOWN))
+            || (i == dest_peer_id)) {
+            err = mlag_dispatcher_message_send(
+                MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT,
+                &vlan_state_change_event, ev_len, i, MASTER_LOGIC);
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Failed in sending MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT, err %d\n",
+                                err);
         }
     }
-    if (i == MLAG_MAX_PEERS) {
-        /* Global vlan down */
-        if (vlan_global_state[vlan_id] == VLAN_GLOBAL_UP) {
-            /* changed */
-            vlan_global_state[vlan_id] = VLAN_GLOBAL_DOWN;
-            *is_changed = 1;
+
+bail:
+    return err;
+}
+
+/*
+ *  This function calculates global state of given vlans: vlan is
+ *  globally up if it is up on any enabled peer. Global state is
+ *  updated and vlans whose global state changed are added
+ *  to vlan_changes.
+ *
+ * @param[in] vlans - vlans to calculate
+ *
+ * @return number of changed vlans
+ */
+static int
+vlan_global_state_calc(const struct vlan_bitmap *vlans)
+{
+    int i, peer;
+    int changed_cnt = 0;
+    uint64_t up, changed;
+
+    for (i = 0; i < VLAN_BITMAP_WORDS; i++) {
+        if (vlans->words[i] == 0) {
+            continue;
+        }
+        up = 0;
+        for (peer = 0; peer < MLAG_MAX_PEERS; peer++) {
+            if (peer_state[peer] == PEER_ENABLE) {
+                up |= vlan_peer_up[peer].words[i];
+            }
         }
+        changed = (up ^ vlan_global_up.words[i]) & vlans->words[i];
+        if (changed == 0) {
+            continue;
+        }
+        vlan_global_up.words[i] ^= changed;
+        vlan_changes.mask.words[i] |= changed;
+        vlan_changes.up.words[i] = (vlan_changes.up.words[i] & ~changed) |
+                                   (vlan_global_up.words[i] & changed);
+        changed_cnt += __builtin_popcountll(changed);
     }
-    return 0;
+
+    return changed_cnt;
 }
 
 /**
@@ -295,10 +336,9 @@ mlag_l3_interface_master_logic_vlan_state_change(
     struct vlan_state_change_event_data *data)
 {
     int err = 0;
-    int i, j;
-    int is_global_vlan_state_changed;
-    int ev_len = 0;
-    unsigned short vlan_id;
+    int i;
+    uint64_t mask;
+    struct vlan_bitmap *peer_up;
 
     ASSERT(data);
 
@@ -306,52 +346,41 @@ mlag_l3_interface_master_logic_vlan_state_change(
         err = ECANCELED;
         MLAG_BAIL_ERROR_MSG(err, "vlan state change called before start\n");
     }
+    if (!((data->peer_id >= 0) && (data->peer_id < MLAG_MAX_PEERS))) {
+        err = -EINVAL;
+        MLAG_BAIL_ERROR_MSG(err, "Invalid peer id %d in vlan state change\n",
+                            data->peer_id);
+    }
 
     MLAG_LOG(MLAG_LOG_INFO, "vlan state change with number vlans %d\n",
              data->vlans_arr_cnt);
 
     mlag_l3_interface_inc_cnt(VLAN_LOCAL_STATE_EVENTS_RCVD_FROM_PEER);
 
-    for (i = 0, j = 0; i < data->vlans_arr_cnt; i++) {
-        vlan_id = data->vlan_data[i].vlan_id;
-        /* Save to DB and do not change global state if peer is not enabled */
-        vlan_peer_state[vlan_id][data->peer_id] =
-            data->vlan_data[i].vlan_state;
-
-        /* If peer enabled check on global state change for vlan */
-        if (peer_state[data->peer_id] == PEER_ENABLE) {
-            mlag_l3_interface_master_logic_calc_global_state(
-                vlan_id, &is_global_vlan_state_changed);
-
-            if (is_global_vlan_state_changed) {
-                /* Send MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT
-                 * to all peers in PEER_ENABLE and PEER_TX_ENABLE states
-                 */
-                vlan_state_change_event.vlan_data[j].vlan_id = vlan_id;
-                vlan_state_change_event.vlan_data[j].vlan_state =
-                    vlan_global_state[vlan_id];
-                j++;
-            }
-        }
+    err = vlan_state_decode(data, &vlan_states);
+    MLAG_BAIL_ERROR_MSG(err, "Invalid vlan states encoding from peer %d\n",
+                        data->peer_id);
+
+    /* Save to DB, global state is not changed if peer is not enabled */
+    peer_up = &vlan_peer_up[data->peer_id];
+    for (i = 0; i < VLAN_BITMAP_WORDS; i++) {
+        mask = vlan_states.mask.words[i] & vlan_valid.words[i];
+        vlan_states.mask.words[i] = mask;
+        peer_up->words[i] = (peer_up->words[i] & ~mask) |
+                            (vlan_states.up.words[i] & mask);
     }
 
-    if (j > 0) {
-        ev_len = sizeof(struct vlan_state_change_base_event_data) +
-                 sizeof(vlan_state_change_event.vlan_data[0]) * j;
-        vlan_state_change_event.opcode =
-            MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT;
-        vlan_state_change_event.peer_id = data->peer_id;
-        vlan_state_change_event.vlans_arr_cnt = j;
-        for (i = 0; i < MLAG_MAX_PEERS; i++) {
-            if (peer_state[i] != PEER_DOWN) {
-                err = mlag_dispatcher_message_send(
-                    MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT,
-                    &vlan_state_change_event, ev_len, i, MASTER_LOGIC);
-                MLAG_BAIL_ERROR_MSG(err,
-                                    "Failed in sending MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT, err %d\n",
-                                    err);
-            }
-        }
+    if (peer_state[data->peer_id] != PEER_ENABLE) {
+        goto bail;
+    }
+
+    SAFE_MEMSET(&vlan_changes, 0);
+    if (vlan_global_state_calc(&vlan_states.mask) > 0) {
+        /* Send MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT
+         * to all peers in PEER_ENABLE and PEER_TX_ENABLE states
+         */
+        err = vlan_global_state_changes_send(data->peer_id, MLAG_MAX_PEERS);
+        MLAG_BAIL_ERROR(err);
     }
 
 bail:
@@ -369,9 +398,7 @@ int
 mlag_l3_interface_master_logic_sync_start(struct sync_event_data *data)
 {
     int err = 0;
-    int i, j;
     struct sync_event_data ev1;
-    int ev_len = 0;
 
     ASSERT(data);
 
@@ -395,32 +422,14 @@ mlag_l3_interface_master_logic_sync_start(struct sync_event_data *data)
      * For each vlan in global up state send
      * MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT to given peer only
      */
-    for (i = 1, j = 0; i < VLAN_N_VID; i++) {
-        if (vlan_global_state[i] == VLAN_GLOBAL_UP) {
-            /* Send MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT
-             * to the peer in sync */
-            vlan_state_change_event.vlan_data[j].vlan_id = i;
-            vlan_state_change_event.vlan_data[j].vlan_state = VLAN_GLOBAL_UP;
-            j++;
-        }
-    }
-
-    if (j > 0) {
-        ev_len = sizeof(struct vlan_state_change_base_event_data) +
-                 sizeof(vlan_state_change_event.vlan_data[0]) * j;
-        vlan_state_change_event.opcode =
-            MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT;
-        vlan_state_change_event.peer_id = data->peer_id;
-        vlan_state_change_event.vlans_arr_cnt = j;
+    SAFE_MEMCPY(&vlan_changes.mask, &vlan_global_up);
+    SAFE_MEMCPY(&vlan_changes.up, &vlan_global_up);
 
+    if (vlan_bitmap_next(&vlan_changes.mask, 0) >= 0) {
         /* Send MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT
          * to the peer in sync */
-        err = mlag_dispatcher_message_send(
-            MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT,
-            &vlan_state_change_event, ev_len, data->peer_id, MASTER_LOGIC);
-        MLAG_BAIL_ERROR_MSG(err,
-                            "Failed in sending MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT, err %d\n",
-                            err);
+        err = vlan_global_state_changes_send(data->peer_id, data->peer_id);
+        MLAG_BAIL_ERROR(err);
     }
 
     /* Set peer state to tx enable in order to enable sending
@@ -499,9 +508,6 @@ int
 mlag_l3_interface_master_logic_peer_enable(struct peer_state_change_data *data)
 {
     int err = 0;
-    int i, j;
-    int is_global_vlan_state_changed;
-    int ev_len = 0;
 
     ASSERT(data);
 
@@ -529,39 +535,13 @@ mlag_l3_interface_master_logic_peer_enable(struct peer_state_change_data *data)
      * For each vlan calculate global state and if changed send
      * MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT to all peers
      */
-    for (i = 1, j = 0; i < VLAN_N_VID; i++) {
-        mlag_l3_interface_master_logic_calc_global_state(
-            i, &is_global_vlan_state_changed);
-
-        if (is_global_vlan_state_changed) {
-            /* Send MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT
-             * to all peers in PEER_ENABLE and PEER_TX_ENABLE states
-             */
-            vlan_state_change_event.vlan_data[j].vlan_id = i;
-            vlan_state_change_event.vlan_data[j].vlan_state =
-                vlan_global_state[i];
-            j++;
-        }
-    }
-
-    if (j > 0) {
-        ev_len = sizeof(struct vlan_state_change_base_event_data) +
-                 sizeof(vlan_state_change_event.vlan_data[0]) * j;
-        vlan_state_change_event.opcode =
-            MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT;
-        vlan_state_change_event.peer_id = data->mlag_id;
-        vlan_state_change_event.vlans_arr_cnt = j;
-
-        for (i = 0; i < MLAG_MAX_PEERS; i++) {
-            if (peer_state[i] != PEER_DOWN) {
-                err = mlag_dispatcher_message_send(
-                    MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT,
-                    &vlan_state_change_event, ev_len, i, MASTER_LOGIC);
-                MLAG_BAIL_ERROR_MSG(err,
-                                    "Failed in sending MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT, err %d\n",
-                                    err);
-            }
-        }
+    SAFE_MEMSET(&vlan_changes, 0);
+    if (vlan_global_state_calc(&vlan_valid) > 0) {
+        /* Send MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT
+         * to all peers in PEER_ENABLE and PEER_TX_ENABLE states
+         */
+        err = vlan_global_state_changes_send(data->mlag_id, MLAG_MAX_PEERS);
+        MLAG_BAIL_ERROR(err);
     }
 
 bail:
@@ -581,10 +561,8 @@ mlag_l3_interface_master_logic_peer_status_change(
     struct peer_state_change_data *data)
 {
     int err = 0;
-    int i, j;
-    int is_global_vlan_state_changed;
     uint16_t ipl_vlan_id = mlag_l3_interface_peer_get_ipl_vlan_id();
-    int ev_len;
+    struct vlan_bitmap vlans;
 
     /* Master Logic updates peer status to down.
      * In vlan database set peer status to default value (down) for each vlan.
@@ -592,46 +570,21 @@ mlag_l3_interface_master_logic_peer_status_change(
      */
     peer_state[data->mlag_id] = PEER_DOWN;
 
-    for (i = 1, j = 0; i < VLAN_N_VID; i++) {
-        if (i == ipl_vlan_id) {
-            vlan_peer_state[i][data->mlag_id] = VLAN_DOWN;
-            continue;
-        }
+    SAFE_MEMSET(&vlan_peer_up[data->mlag_id], 0);
 
-        vlan_peer_state[i][data->mlag_id] = VLAN_DOWN;
-
-        mlag_l3_interface_master_logic_calc_global_state(
-            i, &is_global_vlan_state_changed);
-
-        if (is_global_vlan_state_changed) {
-            /* Send MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT
-             * to all peers in PEER_ENABLE or PEER_TX_ENABLE states
-             */
-            vlan_state_change_event.vlan_data[j].vlan_id = i;
-            vlan_state_change_event.vlan_data[j].vlan_state =
-                vlan_global_state[i];
-            j++;
-        }
+    /* Global state of ipl vlan is kept */
+    SAFE_MEMCPY(&vlans, &vlan_valid);
+    if (ipl_vlan_id < VLAN_N_VID) {
+        VLAN_BITMAP_CLR(&vlans, ipl_vlan_id);
     }
 
-    if (j > 0) {
-        ev_len = sizeof(struct vlan_state_change_base_event_data) +
-                 sizeof(vlan_state_change_event.vlan_data[0]) * j;
-        vlan_state_change_event.opcode =
-            MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT;
-        vlan_state_change_event.peer_id = data->mlag_id;
-        vlan_state_change_event.vlans_arr_cnt = j;
-
-        for (i = 0; i < MLAG_MAX_PEERS; i++) {
-            if (peer_state[i] != PEER_DOWN) {
-                err = mlag_dispatcher_message_send(
-                    MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT,
-                    &vlan_state_change_event, ev_len, i, MASTER_LOGIC);
-                MLAG_BAIL_ERROR_MSG(err,
-                                    "Failed in sending MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT, err %d\n",
-                                    err);
-            }
-        }
+    SAFE_MEMSET(&vlan_changes, 0);
+    if (vlan_global_state_calc(&vlans) > 0) {
+        /* Send MLAG_L3_INTERFACE_VLAN_GLOBAL_STATE_CHANGE_EVENT
+         * to all peers in PEER_ENABLE or PEER_TX_ENABLE states
+         */
+        err = vlan_global_state_changes_send(data->mlag_id, MLAG_MAX_PEERS);
+        MLAG_BAIL_ERROR(err);
     }
 
 bail:
@@ -704,11 +657,11 @@ mlag_l3_interface_master_logic_print(void (*dump_cb)(const char *, ...))
             if (dump_cb == NULL) {
                 MLAG_LOG(MLAG_LOG_NOTICE,
                          "peer %d. %s\n", j,
-                         (vlan_peer_state[i][j] == VLAN_DOWN) ? "DOWN" : "UP");
+                         VLAN_BITMAP_TEST(&vlan_peer_up[j], i) ? "UP" : "DOWN");
             }
             else {
                 dump_cb("peer %d. %s\n", j,
-                        (vlan_peer_state[i][j] == VLAN_DOWN) ? "DOWN" : "UP");
+                        VLAN_BITMAP_TEST(&vlan_peer_up[j], i) ? "UP" : "DOWN");
             }
         }
     }
@@ -720,13 +673,9 @@ mlag_l3_interface_master_logic_print(void (*dump_cb)(const char *, ...))
         dump_cb("\n");
         dump_cb("vlans in global up state: \n");
     }
-    for (i = 1, total_cnt = 0; i < VLAN_N_VID; i++) {
-        if (vlan_global_state[i] == VLAN_GLOBAL_UP) {
-            total_cnt++;
-        }
-    }
+    total_cnt = vlan_bitmap_count(&vlan_global_up);
     for (i = 1, cnt = 0, tmp = 0; i < VLAN_N_VID; i++) {
-        if (vlan_global_state[i] == VLAN_GLOBAL_UP) {
+        if (VLAN_BITMAP_TEST(&vlan_global_up, i)) {
             if ((++cnt > 100) &&
                 (cnt < (total_cnt - 100))) {
                 continue;
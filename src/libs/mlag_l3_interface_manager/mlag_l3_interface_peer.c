@@ -47,6 +47,7 @@
 #include "mlnx_lib/lib_commu.h"
 #include "mlag_comm_layer_wrapper.h"
 #include "mlag_dispatcher.h"
+#include "mlag_vlan_bitmap.h"
 #include "service_layer.h"
 #include "mlag_topology.h"
 
@@ -81,8 +82,9 @@ static int is_peer_start;
 static int is_master_sync_done;
 static unsigned long ipl_ifindex;
 static unsigned short ipl_vlan_id;
-static uint8_t ipl_vlan_list[VLAN_N_VID];
+static struct vlan_bitmap ipl_vlans;
 static unsigned short sl_vlan_list[VLAN_N_VID];
+static struct vlan_state_bitmap vlan_states;
 
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
 
@@ -127,7 +129,6 @@ int
 mlag_l3_interface_peer_init(void)
 {
     int err = 0;
-    int i;
 
     if (is_inited) {
         err = ECANCELED;
@@ -142,9 +143,7 @@ mlag_l3_interface_peer_init(void)
     ipl_ifindex = 0;
     ipl_vlan_id = 0;
     is_master_sync_done = 0;
-    for (i = 0; i < VLAN_N_VID; i++) {
-        ipl_vlan_list[i] = 0;
-    }
+    SAFE_MEMSET(&ipl_vlans, 0);
 
 bail:
     return err;
@@ -183,7 +182,6 @@ int
 mlag_l3_interface_peer_start(uint8_t *data)
 {
     int err = 0;
-    int i;
     UNUSED_PARAM(data);
 
     if (!is_inited) {
@@ -197,9 +195,7 @@ mlag_l3_interface_peer_start(uint8_t *data)
     is_started = 1;
     is_peer_start = 0;
     is_master_sync_done = 0;
-    for (i = 0; i < VLAN_N_VID; i++) {
-        ipl_vlan_list[i] = 0;
-    }
+    SAFE_MEMSET(&ipl_vlans, 0);
 
     /* Configure IPL as member of vlan of ipl l3 interface for control messages */
     if ((ipl_vlan_id > 0) &&
@@ -230,7 +226,7 @@ mlag_l3_interface_peer_start(uint8_t *data)
                             "Failed to set ipl vlan membership, err=%d, ipl=%lu, vlan_id=%d\n",
                             err, ipl_ifindex, ipl_vlan_id);
 
-        ipl_vlan_list[ipl_vlan_id] = 1;
+        VLAN_BITMAP_SET(&ipl_vlans, ipl_vlan_id);
         mlag_l3_interface_inc_cnt(ADD_IPL_TO_VLAN_EVENTS_SENT);
     }
 
@@ -269,14 +265,14 @@ mlag_l3_interface_peer_stop(uint8_t *data)
         goto bail;
     }
     /* Remove IPL from all vlans */
-    for (i = 1; i < VLAN_N_VID; i++) {
-        if (ipl_vlan_list[i]) {
-            /* Remove IPL from vlan */
-            ipl_vlan_list[i] = 0;
-            sl_vlan_list[num_vlans_to_del++] = i;
-            mlag_l3_interface_inc_cnt(DEL_IPL_FROM_VLAN_EVENTS_SENT);
+    VLAN_BITMAP_FOREACH(&ipl_vlans, i) {
+        if (i == 0) {
+            continue;
         }
+        sl_vlan_list[num_vlans_to_del++] = i;
+        mlag_l3_interface_inc_cnt(DEL_IPL_FROM_VLAN_EVENTS_SENT);
     }
+    SAFE_MEMSET(&ipl_vlans, 0);
 
     if (num_vlans_to_del) {
         err = sl_api_ipl_vlan_membership_action(OES_ACCESS_CMD_DELETE,
@@ -349,11 +345,11 @@ mlag_l3_interface_peer_ipl_port_set(struct ipl_port_set_event_data *data)
         /* Remove ipl port from ipl vlan due to disconnect of IPL from port-channel */
         /* Check if IPL is a member of the vlan */
         if ((ipl_vlan_id != 0) &&
-            (ipl_vlan_list[ipl_vlan_id] == 1)) {
+            VLAN_BITMAP_TEST(&ipl_vlans, ipl_vlan_id)) {
             MLAG_LOG(MLAG_LOG_NOTICE,
                      "mlag internal delete vlan %d from ipl vlan list\n",
                      ipl_vlan_id);
-            ipl_vlan_list[ipl_vlan_id] = 0;
+            VLAN_BITMAP_CLR(&ipl_vlans, ipl_vlan_id);
         }
     }
     else {
@@ -366,7 +362,7 @@ mlag_l3_interface_peer_ipl_port_set(struct ipl_port_set_event_data *data)
         /* Connect port-channel to ipl */
         /* If ipl vlan is not configured on ipl yet configure it here */
         if ((ipl_vlan_id != 0) &&
-            (ipl_vlan_list[ipl_vlan_id] == 0)) {
+            !VLAN_BITMAP_TEST(&ipl_vlans, ipl_vlan_id)) {
             MLAG_LOG(MLAG_LOG_NOTICE, "Add ipl=%d to ipl vlan=%d\n",
                      data->ifindex, ipl_vlan_id);
 
@@ -377,7 +373,7 @@ mlag_l3_interface_peer_ipl_port_set(struct ipl_port_set_event_data *data)
             MLAG_BAIL_ERROR_MSG(err,
                                 "Failed to add ipl vlan membership: ipl=%d, ipl_vlan=%d, err=%d\n",
                                 data->ifindex, ipl_vlan_id, err);
-            ipl_vlan_list[ipl_vlan_id] = 1;
+            VLAN_BITMAP_SET(&ipl_vlans, ipl_vlan_id);
             mlag_l3_interface_inc_cnt(ADD_IPL_TO_VLAN_EVENTS_SENT);
         }
         else {
@@ -430,7 +426,7 @@ mlag_l3_interface_peer_vlan_interface_add(struct peer_conf_event_data *data)
 
     /* Check if IPL is not a member of the vlan */
     if ((ipl_vlan_id != 0) &&
-        (ipl_vlan_list[ipl_vlan_id] == 0)) {
+        !VLAN_BITMAP_TEST(&ipl_vlans, ipl_vlan_id)) {
         /* Add IPL to vlan */
         err = mlag_topology_ipl_port_get(0, &ipl_ifindex);
         MLAG_BAIL_ERROR_MSG(err,
@@ -447,7 +443,7 @@ mlag_l3_interface_peer_vlan_interface_add(struct peer_conf_event_data *data)
                             "Failed to add ipl %lu to vlan interface %d, err %d\n",
                             ipl_ifindex, ipl_vlan_id, err);
 
-        ipl_vlan_list[ipl_vlan_id] = 1;
+        VLAN_BITMAP_SET(&ipl_vlans, ipl_vlan_id);
         mlag_l3_interface_inc_cnt(ADD_IPL_TO_VLAN_EVENTS_SENT);
     }
 
@@ -476,8 +472,8 @@ mlag_l3_interface_peer_vlan_interface_del()
 
     /* Check if IPL is not a member of the vlan */
     if ((ipl_vlan_id != 0) &&
-        (ipl_vlan_list[ipl_vlan_id] == 1)) {
-        ipl_vlan_list[ipl_vlan_id] = 0;
+        VLAN_BITMAP_TEST(&ipl_vlans, ipl_vlan_id)) {
+        VLAN_BITMAP_CLR(&ipl_vlans, ipl_vlan_id);
     }
 
 bail:
@@ -568,7 +564,6 @@ mlag_l3_interface_peer_vlan_local_state_change(
     int err = 0;
     int ev_len = 0;
     struct mlag_master_election_status master_election_current_status;
-    int i;
 
     ASSERT(data);
 
@@ -594,17 +589,14 @@ mlag_l3_interface_peer_vlan_local_state_change(
                             data->vlans_arr_cnt);
     }
 
-    for (i = 0; i < data->vlans_arr_cnt; i++) {
-        if (!(((data->vlan_data[i].vlan_id > 0) &&
-               (data->vlan_data[i].vlan_id < VLAN_N_VID)) &&
-              ((data->vlan_data[i].vlan_state == VLAN_DOWN) ||
-               (data->vlan_data[i].vlan_state == VLAN_UP)))) {
-            MLAG_BAIL_ERROR_MSG(EINVAL,
-                                "Invalid vlan parameters: vlan id=%d, vlan state=%s",
-                                data->vlan_data[i].vlan_id,
-                                (data->vlan_data[i].vlan_state ==
-                                 VLAN_UP) ? "up" : "down");
-        }
+    /* Vlan states are forwarded encoded, decode only to validate.
+     * The bitmap holds ids up to MLAG_VLAN_ID_MAX only, decode rejects
+     * higher ones. */
+    err = vlan_state_decode(data, &vlan_states);
+    MLAG_BAIL_ERROR_MSG(err, "Invalid vlan states encoding\n");
+    if (VLAN_BITMAP_TEST(&vlan_states.mask, 0)) {
+        err = -EINVAL;
+        MLAG_BAIL_ERROR_MSG(err, "Invalid vlan id in vlan states\n");
     }
 
     mlag_l3_interface_inc_cnt(VLAN_LOCAL_STATE_EVENTS_RCVD);
@@ -617,7 +609,7 @@ mlag_l3_interface_peer_vlan_local_state_change(
                         err);
 
     ev_len = sizeof(struct vlan_state_change_base_event_data) +
-             sizeof(data->vlan_data[0]) * data->vlans_arr_cnt;
+             data->data_len;
 
     data->peer_id = master_election_current_status.my_peer_id;
 
@@ -645,9 +637,11 @@ mlag_l3_interface_peer_vlan_global_state_change(
 {
     int err = 0;
     int i;
-    unsigned short vlan_id;
+    int vlan_id;
     int num_vlans_to_add = 0;
     int num_vlans_to_del = 0;
+    struct vlan_bitmap vlans_to_add;
+    struct vlan_bitmap vlans_to_del;
 
     ASSERT(data);
 
@@ -668,28 +662,36 @@ mlag_l3_interface_peer_vlan_global_state_change(
 
     mlag_l3_interface_inc_cnt(VLAN_GLOBAL_STATE_EVENTS_RCVD);
 
-    for (i = 0; i < data->vlans_arr_cnt; i++) {
-        vlan_id = data->vlan_data[i].vlan_id;
-        if (data->vlan_data[i].vlan_state == VLAN_GLOBAL_DOWN) {
-            /* Check if IPL is a member of the vlan */
-            if (ipl_vlan_list[vlan_id] == 1) {
-                /* Remove IPL from vlan */
-                /* Do not remove vlan of mlag control messages interface from ipl */
-                if (vlan_id != ipl_vlan_id) {
-                    ipl_vlan_list[vlan_id] = 0;
-                    sl_vlan_list[num_vlans_to_del++] = vlan_id;
-                    mlag_l3_interface_inc_cnt(DEL_IPL_FROM_VLAN_EVENTS_SENT);
-                }
-                else {
-                    MLAG_LOG(MLAG_LOG_NOTICE,
-                             "ignored ipl vlan %d, state=%s\n",
-                             vlan_id,
-                             l3_interface_vlan_global_state_str[data->vlan_data
-                                                                [i].
-                                                                vlan_state]);
-                }
-            }
+    err = vlan_state_decode(data, &vlan_states);
+    MLAG_BAIL_ERROR_MSG(err, "Invalid vlan global states encoding\n");
+
+    /* Only vlans whose IPL membership changes are pushed to the
+     * service layer. Vlan of mlag control messages interface is
+     * never removed from IPL. */
+    for (i = 0; i < VLAN_BITMAP_WORDS; i++) {
+        vlans_to_del.words[i] = vlan_states.mask.words[i] &
+                                ~vlan_states.up.words[i] &
+                                ipl_vlans.words[i];
+        vlans_to_add.words[i] = vlan_states.mask.words[i] &
+                                vlan_states.up.words[i] &
+                                ~ipl_vlans.words[i];
+    }
+    if (VLAN_BITMAP_TEST(&vlans_to_del, ipl_vlan_id)) {
+        VLAN_BITMAP_CLR(&vlans_to_del, ipl_vlan_id);
+        MLAG_LOG(MLAG_LOG_NOTICE,
+                 "ignored ipl vlan %d, state=%s\n",
+                 ipl_vlan_id,
+                 l3_interface_vlan_global_state_str[VLAN_GLOBAL_DOWN]);
+    }
+
+    VLAN_BITMAP_FOREACH(&vlans_to_del, vlan_id) {
+        if (vlan_id >= VLAN_N_VID) {
+            break;
         }
+        /* Remove IPL from vlan */
+        VLAN_BITMAP_CLR(&ipl_vlans, vlan_id);
+        sl_vlan_list[num_vlans_to_del++] = vlan_id;
+        mlag_l3_interface_inc_cnt(DEL_IPL_FROM_VLAN_EVENTS_SENT);
     }
     if (num_vlans_to_del) {
         err = sl_api_ipl_vlan_membership_action(OES_ACCESS_CMD_DELETE,
@@ -700,17 +702,14 @@ mlag_l3_interface_peer_vlan_global_state_change(
                             err);
     }
 
-    for (i = 0; i < data->vlans_arr_cnt; i++) {
-        vlan_id = data->vlan_data[i].vlan_id;
-        if (data->vlan_data[i].vlan_state == VLAN_GLOBAL_UP) {
-            /* Check if IPL is not a member of the vlan */
-            if (ipl_vlan_list[vlan_id] == 0) {
-                /* Add IPL to vlan */
-                ipl_vlan_list[vlan_id] = 1;
-                sl_vlan_list[num_vlans_to_add++] = vlan_id;
-                mlag_l3_interface_inc_cnt(ADD_IPL_TO_VLAN_EVENTS_SENT);
-            }
+    VLAN_BITMAP_FOREACH(&vlans_to_add, vlan_id) {
+        if (vlan_id >= VLAN_N_VID) {
+            break;
         }
+        /* Add IPL to vlan */
+        VLAN_BITMAP_SET(&ipl_vlans, vlan_id);
+        sl_vlan_list[num_vlans_to_add++] = vlan_id;
+        mlag_l3_interface_inc_cnt(ADD_IPL_TO_VLAN_EVENTS_SENT);
     }
     if (num_vlans_to_add) {
         err = sl_api_ipl_vlan_membership_action(OES_ACCESS_CMD_ADD,
@@ -772,12 +771,12 @@ mlag_l3_interface_peer_print(void (*dump_cb)(const char *, ...))
     }
 
     for (i = 1, total_cnt = 0; i < VLAN_N_VID; i++) {
-        if (ipl_vlan_list[i]) {
+        if (VLAN_BITMAP_TEST(&ipl_vlans, i)) {
             total_cnt++;
         }
     }
     for (i = 1, cnt = 0, tmp = 0; i < VLAN_N_VID; i++) {
-        if (ipl_vlan_list[i]) {
+        if (VLAN_BITMAP_TEST(&ipl_vlans, i)) {
             if ((++cnt > 100) &&
                 (cnt < (total_cnt - 100))) {
                 continue;
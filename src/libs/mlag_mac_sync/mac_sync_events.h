@@ -118,7 +118,7 @@ struct mac_sync_multiple_learn_event_data {
 
 struct mac_sync_global_reject_event_data {
     uint16_t opcode;
-    struct mac_sync_learn_event_data * learn_msg;
+    struct mac_sync_learn_event_data learn_msg;
     int error_cause;
 };
 
@@ -109,7 +109,8 @@ static cl_thread_t mac_sync_thread;
 static cmd_db_handle_t *mac_sync_cmd_db;
 static event_disp_fds_t event_fds;
 static struct dispatcher_conf mac_sync_dispatcher_conf;
-static char mac_sync_disp_sys_event_buf[MAC_SYNC_DISP_SYS_EVENT_BUF_SIZE];
+static char mac_sync_disp_sys_event_buf[MAC_SYNC_DISP_SYS_EVENT_BUF_SIZE +
+                                        MLAG_EVENT_STAMP_SIZE];
 
 static int medium_prio_events[] = {
     MLAG_CONN_NOTIFY_EVENT,
@@ -476,8 +477,8 @@ dispatch_mpo_port_deleted_event(uint8_t *data)
     }
 
 bail:
-    /* Signal port delete done to Internal API module */
-    err = mlag_manager_port_delete_done();
+    /* Complete port delete requested by Internal API module */
+    err = mlag_manager_port_delete_done(ev->port, ev->status);
     if (err) {
         MLAG_LOG(MLAG_LOG_WARNING,
                  "Failed in sending port [%lu] delete done event\n",
@@ -934,9 +935,9 @@ rcv_msg_handler(struct addr_info *ad_info,
     MLAG_BAIL_ERROR_MSG(err, "Command [%d] not found in cmd db\n",
                         opcode);
 
-    MLAG_LOG(MLAG_LOG_INFO,
-             "%s (opcode=%d) received by mac sync dispatcher from remote switch, payload length %d\n",
-             cmd_data.name, opcode, len);
+    MLAG_TRACE(MLAG_TRACE_INFO,
+               "opcode %llu received by mac sync dispatcher from remote switch, payload length %lld",
+               opcode, len);
 
     if (cmd_data.func == NULL) {
         MLAG_LOG(MLAG_LOG_NOTICE, "Empty function\n");
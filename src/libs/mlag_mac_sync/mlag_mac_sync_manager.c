@@ -46,8 +46,10 @@
 #include "mlag_master_election.h"
 #include "lib_commu.h"
 #include "mlag_comm_layer_wrapper.h"
+#include "mlag_wire.h"
 #include "mlag_mac_sync_dispatcher.h"
 #include "mlag_manager.h"
+#include <libs/notification_layer/notification_layer.h>
 
 #undef  __MODULE__
 #define __MODULE__ MLAG_MAC_SYNC_MANAGER
@@ -65,8 +67,6 @@
  ***********************************************/
 static int
 rcv_msg_handler(uint8_t *payload_data);
-static int
-net_order_msg_handler(uint8_t *data, int oper);
 
 /************************************************
  *  Global variables
@@ -82,36 +82,144 @@ static enum master_election_switch_status current_switch_status;
 
 static handler_command_t mac_sync_ibc_msgs[] = {
     {MLAG_MAC_SYNC_ALL_FDB_GET_EVENT,     "FDB get event", rcv_msg_handler,
-     net_order_msg_handler},
+     NULL},
     {MLAG_MAC_SYNC_ALL_FDB_EXPORT_EVENT,  "FDB export event", rcv_msg_handler,
-     net_order_msg_handler},
+     NULL},
     {MLAG_MAC_SYNC_SYNC_FINISH_EVENT,     "Mac sync Finish", rcv_msg_handler,
-     net_order_msg_handler},
+     NULL},
     {MLAG_MAC_SYNC_MASTER_SYNC_DONE_EVENT, "Mac sync Master Done to peer",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_MAC_SYNC_LOCAL_LEARNED_EVENT,   "Mac sync Local learn",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_MAC_SYNC_LOCAL_AGED_EVENT,      "Mac sync Local age",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_MAC_SYNC_GLOBAL_LEARNED_EVENT,  "Mac sync Global learn",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_MAC_SYNC_GLOBAL_AGED_EVENT,     "Mac sync Global age",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_MAC_SYNC_GLOBAL_REJECTED_EVENT, "Mac sync Global rejected",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_MAC_SYNC_GLOBAL_FLUSH_PEER_SENDS_START_EVENT,
      "Mac Sync Start Global flush from peer",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_MAC_SYNC_GLOBAL_FLUSH_MASTER_SENDS_START_EVENT,
      "Mac Sync Start Global flush from master",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
     {MLAG_MAC_SYNC_GLOBAL_FLUSH_ACK_EVENT,
      "Mac Sync Start Global flush ACK from peer",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
 
     {0, "", NULL, NULL}
 };
 
+static const struct mlag_wire_field mac_sync_learn_wire[] = {
+    MLAG_WIRE_FIELD(struct mac_sync_learn_event_data, mac_params.vid),
+    MLAG_WIRE_FIELD(struct mac_sync_learn_event_data, mac_params.log_port),
+    MLAG_WIRE_FIELD(struct mac_sync_learn_event_data, mac_params.entry_type),
+    MLAG_WIRE_FIELD(struct mac_sync_learn_event_data, port_cookie),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field mac_sync_age_wire[] = {
+    MLAG_WIRE_FIELD(struct mac_sync_age_event_data, mac_params.vid),
+    MLAG_WIRE_FIELD(struct mac_sync_age_event_data, mac_params.log_port),
+    MLAG_WIRE_FIELD(struct mac_sync_age_event_data, mac_params.entry_type),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field mac_sync_mac_wire[] = {
+    MLAG_WIRE_FIELD(struct mac_sync_mac_params, vid),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field mac_sync_multiple_learn_wire[] = {
+    MLAG_WIRE_FIELD(struct mac_sync_multiple_learn_event_data, num_msg),
+    MLAG_WIRE_STRUCT_RUN(struct mac_sync_multiple_learn_event_data, msg,
+                         num_msg, mac_sync_learn_wire),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field mac_sync_multiple_age_wire[] = {
+    MLAG_WIRE_FIELD(struct mac_sync_fixed_age_event_data, num_msg),
+    MLAG_WIRE_STRUCT_RUN(struct mac_sync_fixed_age_event_data, msg,
+                         num_msg, mac_sync_age_wire),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field mac_sync_fdb_export_wire[] = {
+    MLAG_WIRE_FIELD(struct mac_sync_master_fdb_export_event_data,
+                    num_entries),
+    MLAG_WIRE_STRUCT_RUN(struct mac_sync_master_fdb_export_event_data, entry,
+                         num_entries, mac_sync_learn_wire),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field mac_sync_sync_event_wire[] = {
+    MLAG_WIRE_FIELD(struct sync_event_data, peer_id),
+    MLAG_WIRE_FIELD(struct sync_event_data, sync_type),
+    MLAG_WIRE_FIELD(struct sync_event_data, state),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field mac_sync_global_reject_wire[] = {
+    MLAG_WIRE_FIELD(struct mac_sync_global_reject_event_data,
+                    learn_msg.mac_params.vid),
+    MLAG_WIRE_FIELD(struct mac_sync_global_reject_event_data,
+                    learn_msg.mac_params.log_port),
+    MLAG_WIRE_FIELD(struct mac_sync_global_reject_event_data,
+                    learn_msg.mac_params.entry_type),
+    MLAG_WIRE_FIELD(struct mac_sync_global_reject_event_data,
+                    learn_msg.port_cookie),
+    MLAG_WIRE_FIELD(struct mac_sync_global_reject_event_data, error_cause),
+    MLAG_WIRE_FIELDS_END
+};
+
+/* Flush filter is a control learning structure, its members are listed
+ * by name so that the wire form does not depend on its layout */
+#define MAC_SYNC_FLUSH_FILTER_WIRE(type)                                   \
+    MLAG_WIRE_FIELD(type, gen_data.filter.filter_by_vid),                  \
+    MLAG_WIRE_FIELD(type, gen_data.filter.vid),                            \
+    MLAG_WIRE_FIELD(type, gen_data.filter.filter_by_log_port),             \
+    MLAG_WIRE_FIELD(type, gen_data.filter.log_port)
+
+static const struct mlag_wire_field mac_sync_flush_start_wire[] = {
+    MAC_SYNC_FLUSH_FILTER_WIRE(
+        struct mac_sync_flush_peer_sends_start_event_data),
+    MLAG_WIRE_FIELD(struct mac_sync_flush_peer_sends_start_event_data,
+                    number_mac_params),
+    MLAG_WIRE_STRUCT_RUN(struct mac_sync_flush_peer_sends_start_event_data,
+                         mac_params, number_mac_params, mac_sync_mac_wire),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field mac_sync_flush_ack_wire[] = {
+    MAC_SYNC_FLUSH_FILTER_WIRE(struct mac_sync_flush_peer_ack_event_data),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_msg mac_sync_wire_msgs[] = {
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_ALL_FDB_GET_EVENT, NULL),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_ALL_FDB_EXPORT_EVENT,
+                  mac_sync_fdb_export_wire),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_SYNC_FINISH_EVENT, mac_sync_sync_event_wire),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_MASTER_SYNC_DONE_EVENT,
+                  mac_sync_sync_event_wire),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_LOCAL_LEARNED_EVENT,
+                  mac_sync_multiple_learn_wire),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_LOCAL_AGED_EVENT, mac_sync_multiple_age_wire),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_GLOBAL_LEARNED_EVENT,
+                  mac_sync_multiple_learn_wire),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_GLOBAL_AGED_EVENT, mac_sync_multiple_age_wire),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_GLOBAL_REJECTED_EVENT,
+                  mac_sync_global_reject_wire),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_GLOBAL_FLUSH_PEER_SENDS_START_EVENT,
+                  mac_sync_flush_start_wire),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_GLOBAL_FLUSH_MASTER_SENDS_START_EVENT,
+                  mac_sync_flush_start_wire),
+    MLAG_WIRE_MSG(MLAG_MAC_SYNC_GLOBAL_FLUSH_ACK_EVENT,
+                  mac_sync_flush_ack_wire),
+};
+
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
 
 /************************************************
@@ -175,6 +283,9 @@ mlag_mac_sync_init(insert_to_command_db_func insert_msgs)
     err = insert_msgs(mac_sync_ibc_msgs);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
+    err = mlag_wire_msgs_register(mac_sync_wire_msgs, NUM_ELEMS(mac_sync_wire_msgs));
+    MLAG_BAIL_ERROR(err);
+
     err = mlag_mac_sync_master_logic_init();
     MLAG_BAIL_ERROR(err);
 
@@ -518,67 +629,6 @@ bail:
     return err;
 }
 
-/*
- *  This function is called to handle network order for IBC message
- *
- * @param[in] payload_data - message body
- * @param[in] oper - on send or receive
- *
- * @return 0 when successful, otherwise ERROR
- */
-static int
-net_order_msg_handler(uint8_t *data, int oper)
-{
-    int err = 0;
-    uint16_t opcode;
-    ASSERT(data);
-    if (oper == MESSAGE_SENDING) {
-        opcode = *(uint16_t*)data;
-        *(uint16_t*)data = htons(opcode);
-    }
-    else {
-        opcode = ntohs(*(uint16_t*)data);
-        *(uint16_t*)data = opcode;
-    }
-
-    switch (opcode) {
-    case MLAG_MAC_SYNC_ALL_FDB_GET_EVENT:
-        break;
-    case MLAG_MAC_SYNC_ALL_FDB_EXPORT_EVENT:
-        break;
-    case MLAG_MAC_SYNC_SYNC_FINISH_EVENT:
-        break;
-    case MLAG_MAC_SYNC_MASTER_SYNC_DONE_EVENT:
-        break;
-    /* LOCAL, GLOBAL MAC SYNC EVENTS*/
-    case MLAG_MAC_SYNC_LOCAL_LEARNED_EVENT:
-        break;
-    case MLAG_MAC_SYNC_LOCAL_AGED_EVENT:
-        break;
-    case MLAG_MAC_SYNC_GLOBAL_LEARNED_EVENT:
-        break;
-    case MLAG_MAC_SYNC_GLOBAL_AGED_EVENT:
-        break;
-    case MLAG_MAC_SYNC_GLOBAL_REJECTED_EVENT:
-        break;
-    /* Global flush related IBC messages*/
-    case MLAG_MAC_SYNC_GLOBAL_FLUSH_PEER_SENDS_START_EVENT:
-        break;
-    case MLAG_MAC_SYNC_GLOBAL_FLUSH_MASTER_SENDS_START_EVENT:
-        break;
-    case MLAG_MAC_SYNC_GLOBAL_FLUSH_ACK_EVENT:
-        break;
-    default:
-        /* Unknown opcode */
-        MLAG_LOG(MLAG_LOG_NOTICE,
-                 "Unknown event %d in network ordering handler\n",
-                 opcode);
-        break;
-    }
-bail:
-    return err;
-}
-
 /**
  *  This function handles peer status change event
  *
@@ -674,10 +724,37 @@ mlag_mac_sync_peer_start_event(struct peer_state_change_data *data)
     err = mlag_mac_sync_peer_mngr_peer_start(data);
     MLAG_BAIL_ERROR(err);
 
+    mlag_mac_sync_milestone_notify(data->mlag_id, MLAG_MAC_SYNC_PEER_START);
+
 bail:
     return err;
 }
 
+/**
+ *  This function notifies subscribers of the MAC sync progress of a peer
+ *
+ * @param[in] peer_id - peer index
+ * @param[in] milestone - MAC sync milestone reached
+ *
+ * @return void
+ */
+void
+mlag_mac_sync_milestone_notify(int peer_id,
+                               enum mlag_mac_sync_milestone milestone)
+{
+    struct mlag_notification notify;
+
+    SAFE_MEMSET(&notify, 0);
+    notify.notification_type = MLAG_NOTIFY_MAC_SYNC_MILESTONE;
+    notify.notification_info.mac_sync.mlag_id = peer_id;
+    notify.notification_info.mac_sync.milestone = milestone;
+    if (mlag_notify(&notify)) {
+        MLAG_LOG(MLAG_LOG_ERROR,
+                 "Failed to notify MAC sync milestone of peer [%d]\n",
+                 peer_id);
+    }
+}
+
 
 /**
  *  This function handles fdb get event
@@ -228,6 +228,17 @@ int mlag_mac_sync_peer_status_change(struct peer_state_change_data *data);
  */
 int mlag_mac_sync_peer_start_event(struct peer_state_change_data *data);
 
+/**
+ *  This function notifies subscribers of the MAC sync progress of a peer
+ *
+ * @param[in] peer_id - peer index
+ * @param[in] milestone - MAC sync milestone reached
+ *
+ * @return void
+ */
+void mlag_mac_sync_milestone_notify(int peer_id,
+                                    enum mlag_mac_sync_milestone milestone);
+
 /**
  *  This function handles fdb get event
  *
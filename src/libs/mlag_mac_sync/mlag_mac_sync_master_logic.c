@@ -708,6 +708,8 @@ mlag_mac_sync_master_logic_sync_finish(struct sync_event_data *data)
 
     MLAG_BAIL_ERROR_MSG(err, "Failed to send event peer_done, err %d\n", err);
 
+    mlag_mac_sync_milestone_notify(data->peer_id, MLAG_MAC_SYNC_PEER_DONE);
+
 bail:
     return err;
 }
@@ -807,18 +809,19 @@ mlag_mac_sync_master_logic_global_flush_start(uint8_t *data)
         goto bail;
     }
 
-    if (inc_msg->port_num > MLAG_MAX_PORTS) {
+    if ((inc_msg->port_num < 0) ||
+        ((uint32_t)inc_msg->port_num > mlag_max_ports_get())) {
         err = -EPERM;
         MLAG_BAIL_ERROR_MSG(err, "Global flush start: illegal port, err %d \n",
                             err);
     }
 
     for (i = 0; i < inc_msg->port_num; i++) {
-        if (inc_msg->state[i] == MLAG_PORT_GLOBAL_DOWN) {
+        if (inc_msg->ports[i].state == MLAG_PORT_GLOBAL_DOWN) {
             msg.gen_data.filter.filter_by_log_port =
                 FDB_KEY_FILTER_FIELD_VALID;
             msg.gen_data.filter.filter_by_vid = FDB_KEY_FILTER_FIELD_NOT_VALID;
-            msg.gen_data.filter.log_port = inc_msg->port_id[i];
+            msg.gen_data.filter.log_port = inc_msg->ports[i].port_id;
             msg.gen_data.non_mlag_port_flush = 0;
             msg.gen_data.peer_originator = 0;
             msg.number_mac_params = 0;
@@ -1223,9 +1226,9 @@ _master_process_local_learn_cb(void* user_data)
     gl_buff.opcode = MLAG_MAC_SYNC_GLOBAL_LEARNED_EVENT;
 
 
-    MLAG_LOG(MLAG_LOG_INFO,
-             "master receives local learn %d messages, orig %d \n",
-             msg->num_msg, msg->msg[0].originator_peer_id );
+    MLAG_TRACE(MLAG_TRACE_INFO,
+               "master receives local learn %llu messages, orig %llu",
+               msg->num_msg, msg->msg[0].originator_peer_id);
 
     for (i = 0; i < msg->num_msg; i++) {
         memcpy(&mac_entry.mac_addr_params, &msg->msg[i].mac_params,
@@ -2091,7 +2094,7 @@ _local_learn_update_master_and_peers(struct master_logic_data *master_data,
         /* Send Global reject message to originator peer */
         struct mac_sync_global_reject_event_data *rej_msg =
             (struct mac_sync_global_reject_event_data *)msg_data;
-        /*rej_msg->learn_msg->opcode = MLAG_MAC_SYNC_GLOBAL_REJECTED_EVENT;*/
+        /*rej_msg->learn_msg.opcode = MLAG_MAC_SYNC_GLOBAL_REJECTED_EVENT;*/
 
         err = mlag_mac_sync_dispatcher_message_send(
             MLAG_MAC_SYNC_GLOBAL_REJECTED_EVENT, (void *)rej_msg,
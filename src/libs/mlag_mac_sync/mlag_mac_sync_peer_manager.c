@@ -1523,8 +1523,8 @@ mlag_mac_sync_peer_mngr_global_reject(void *data)
 
 
     MLAG_LOG(MLAG_LOG_NOTICE, "on static MAC :type %d, port %d, cause %d \n",
-             msg->learn_msg->mac_params.entry_type,
-             (int)msg->learn_msg->mac_params.log_port,
+             msg->learn_msg.mac_params.entry_type,
+             (int)msg->learn_msg.mac_params.log_port,
              msg->error_cause);
 bail:
     return err;
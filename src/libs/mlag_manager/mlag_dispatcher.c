@@ -27,6 +27,7 @@
 #include <errno.h>
 #include <complib/cl_thread.h>
 #include <complib/cl_init.h>
+#include <complib/cl_mem.h>
 #include <mlag_api_defs.h>
 #include <utils/mlag_log.h>
 #include <utils/mlag_bail.h>
@@ -65,6 +66,7 @@
 #define MLAG_DISPATCHER_CONF_RESET(index) \
     DISPATCHER_CONF_RESET(mlag_dispatcher_conf, index)
 
+/* Base size, port events add room for the maximum number of ports */
 #define MLAG_DISP_SYS_EVENT_BUF_SIZE 16000
 
 /************************************************
@@ -92,6 +94,8 @@ static int dispatch_l3_sync_start_event(uint8_t *data);
 static int dispatch_l3_sync_finish_event(uint8_t *data);
 static int dispatch_port_oper_state_change_event(uint8_t *data);
 static int dispatch_peer_port_oper_state_change_event(uint8_t *data);
+static int dispatch_ports_oper_state_change_event(uint8_t *data);
+static int dispatch_peer_ports_oper_state_change_event(uint8_t *data);
 static int dispatch_reload_delay_expired_event(uint8_t *data);
 static int dispatch_port_global_state_change_event(uint8_t *data);
 static int dispatch_port_sync_data(uint8_t *data);
@@ -107,6 +111,8 @@ static int dispatch_port_mode_set_event(uint8_t *data);
 static int dispatch_lacp_sys_id_set(uint8_t *data);
 static int dispatch_lacp_selection_request(uint8_t *data);
 static int dispatch_lacp_selection_event(uint8_t *data);
+static int dispatch_lacp_selections_request(uint8_t *data);
+static int dispatch_lacp_selections_event(uint8_t *data);
 static int dispatch_lacp_release_event(uint8_t *data);
 static int dispatch_lacp_sys_id_update_event(uint8_t *data);
 
@@ -123,7 +129,8 @@ static cl_thread_t disp_thread;
 static cmd_db_handle_t *mlag_cmd_db;
 static event_disp_fds_t event_fds;
 static struct dispatcher_conf mlag_dispatcher_conf;
-static char mlag_disp_sys_event_buf[MLAG_DISP_SYS_EVENT_BUF_SIZE];
+static char *mlag_disp_sys_event_buf;
+static int mlag_disp_sys_event_buf_size;
 
 static int medium_prio_events[] = {
     MLAG_START_EVENT,
@@ -149,6 +156,8 @@ static int medium_prio_events[] = {
     MLAG_PORT_CFG_EVENT,
     MLAG_PORT_OPER_STATE_CHANGE_EVENT,
     MLAG_PEER_PORT_OPER_STATE_CHANGE,
+    MLAG_PORTS_OPER_STATE_CHANGE_EVENT,
+    MLAG_PEER_PORTS_OPER_STATE_CHANGE,
     MLAG_PORT_GLOBAL_STATE_EVENT,
     MLAG_PORTS_SYNC_DATA,
     MLAG_PORTS_UPDATE_EVENT,
@@ -165,6 +174,8 @@ static int medium_prio_events[] = {
     MLAG_LACP_SELECTION_EVENT,
     MLAG_LACP_RELEASE_EVENT,
     MLAG_LACP_SYS_ID_UPDATE_EVENT,
+    MLAG_LACP_SELECTIONS_REQUEST,
+    MLAG_LACP_SELECTIONS_EVENT,
 };
 
 
@@ -218,6 +229,10 @@ static handler_command_t mlag_dispatcher_commands[] = {
      dispatch_port_oper_state_change_event, NULL },
     {MLAG_PEER_PORT_OPER_STATE_CHANGE, "Peer port oper state change",
      dispatch_peer_port_oper_state_change_event, NULL },
+    {MLAG_PORTS_OPER_STATE_CHANGE_EVENT, "Ports oper state change",
+     dispatch_ports_oper_state_change_event, NULL },
+    {MLAG_PEER_PORTS_OPER_STATE_CHANGE, "Peer ports oper state change",
+     dispatch_peer_ports_oper_state_change_event, NULL },
     {MLAG_PEER_RELOAD_DELAY_EXPIRED, "Reload delay expired",
      dispatch_reload_delay_expired_event, NULL },
     {MLAG_PORT_GLOBAL_STATE_EVENT, "Port global state change",
@@ -250,6 +265,10 @@ static handler_command_t mlag_dispatcher_commands[] = {
       dispatch_lacp_release_event, NULL },
      {MLAG_LACP_SYS_ID_UPDATE_EVENT, "Mlag LACP system id update event",
       dispatch_lacp_sys_id_update_event, NULL },
+    {MLAG_LACP_SELECTIONS_REQUEST, "Mlag lacp selections request",
+     dispatch_lacp_selections_request, NULL},
+    {MLAG_LACP_SELECTIONS_EVENT, "Mlag LACP selections event",
+     dispatch_lacp_selections_event, NULL },
      {0, "", NULL, NULL}
 };
 
@@ -445,14 +464,14 @@ dispatch_port_cfg_event(uint8_t *data)
 
     if (port_cfg->del_ports == FALSE) {
         err = port_manager_mlag_ports_add(port_cfg->ports, port_cfg->port_num);
+        /* Add completes here, delete completes once all modules are done */
+        mlag_manager_port_cfg_done(port_cfg->ports, port_cfg->port_num,
+                                   (err ? MLAG_PORT_CFG_STATE_FAILED :
+                                    MLAG_PORT_CFG_STATE_ADDED));
     }
     else {
-        if (port_cfg->port_num != 1) {
-            MLAG_LOG(MLAG_LOG_NOTICE,
-                     "port number to delete is %d, supported only one port\n",
-                     port_cfg->port_num);
-        }
-        err = port_manager_mlag_port_delete(port_cfg->ports[0]);
+        err = port_manager_mlag_ports_delete(port_cfg->ports,
+                                             port_cfg->port_num);
     }
     MLAG_BAIL_ERROR_MSG(err, "Port configuration handling failed\n");
 
@@ -756,6 +775,27 @@ bail:
     return err;
 }
 
+/*
+ *  This function dispatches batched peer ports oper status change event
+ *
+ * @param data - event data
+ *
+ * @return int as error code.
+ */
+static int
+dispatch_peer_ports_oper_state_change_event(uint8_t *data)
+{
+    int err = 0;
+    struct peer_port_oper_sync_message *oper_sync =
+        (struct peer_port_oper_sync_message *)data;
+
+    err = port_manager_peer_ports_oper_state_change(oper_sync);
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
 /*
  *  This function dispatches reload delay timer expiration event
  *
@@ -791,8 +831,7 @@ dispatch_port_global_state_change_event(uint8_t *data)
 
     port_states = (struct port_global_state_event_data *)data;
 
-    err = port_manager_global_oper_state_set(port_states->port_id,
-                                             port_states->state,
+    err = port_manager_global_oper_state_set(port_states->ports,
                                              port_states->port_num);
     MLAG_BAIL_ERROR(err);
 
@@ -848,6 +887,28 @@ bail:
     return err;
 }
 
+/*
+ *  This function dispatches batched port oper status change event
+ *
+ * @param data - event data
+ *
+ * @return int as error code.
+ */
+static int
+dispatch_ports_oper_state_change_event(uint8_t *data)
+{
+    int err = 0;
+    struct ports_oper_state_change_data *oper_chg =
+        (struct ports_oper_state_change_data *)data;
+
+    err = port_manager_local_ports_oper_state_set(oper_chg->ports,
+                                                  oper_chg->port_num);
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
 /*
  *  This function dispatches L3 interface local sync done event
  *
@@ -1151,9 +1212,9 @@ rcv_msg_handler(struct addr_info *ad_info,
     err = get_command(cmd_db_handle, opcode, &cmd_data);
     MLAG_BAIL_ERROR_MSG(err, "Command [%d] not found in cmd db\n", opcode);
 
-    MLAG_LOG(MLAG_LOG_INFO,
-             "%s (opcode=%d) received by mlag dispatcher from remote switch, payload length %d\n",
-             cmd_data.name, opcode, len);
+    MLAG_TRACE(MLAG_TRACE_INFO,
+               "opcode %llu received by mlag dispatcher from remote switch, payload length %lld",
+               opcode, len);
 
     if (cmd_data.func == NULL) {
         MLAG_LOG(MLAG_LOG_NOTICE, "Empty function\n");
@@ -1506,6 +1567,16 @@ mlag_dispatcher_init(void)
         mlag_dispatcher_conf.handler[i].buf_size = 0;
     }
 
+    mlag_disp_sys_event_buf_size = MLAG_DISP_SYS_EVENT_BUF_SIZE +
+                                   MLAG_EVENT_STAMP_SIZE +
+                                   PEER_PORT_OPER_SYNC_MSG_SIZE(
+                                       mlag_max_ports_get());
+    mlag_disp_sys_event_buf = (char *)cl_malloc(mlag_disp_sys_event_buf_size);
+    if (mlag_disp_sys_event_buf == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate system event buffer\n");
+    }
+
     err = init_command_db(&mlag_cmd_db);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
@@ -1518,13 +1589,13 @@ mlag_dispatcher_init(void)
                              dispatcher_sys_event_handler,
                              mlag_cmd_db,
                              mlag_disp_sys_event_buf,
-                             sizeof(mlag_disp_sys_event_buf));
+                             mlag_disp_sys_event_buf_size);
     MLAG_DISPATCHER_CONF_SET(SYS_EVENTS_LOW_FD_INDEX, event_fds.med_fd,
                              MEDIUM_PRIORITY,
                              dispatcher_sys_event_handler,
                              mlag_cmd_db,
                              mlag_disp_sys_event_buf,
-                             sizeof(mlag_disp_sys_event_buf));
+                             mlag_disp_sys_event_buf_size);
 
     if (setsockopt(event_fds.high_fd, SOL_SOCKET, SO_SNDBUF, &sndbuf,
                    sizeof(sndbuf)) < 0) {
@@ -1619,6 +1690,11 @@ mlag_dispatcher_deinit(void)
                  "mlag dispatcher ibc commands DB deinit failed\n");
     }
 
+    if (mlag_disp_sys_event_buf != NULL) {
+        cl_free(mlag_disp_sys_event_buf);
+        mlag_disp_sys_event_buf = NULL;
+    }
+
     return err;
 }
 
@@ -1815,3 +1891,48 @@ dispatch_lacp_selection_event(uint8_t *data)
 bail:
     return err;
 }
+
+/*
+ *  This function dispatches lacp aggregator selections request of
+ *  several ports
+ *
+ *  @param[in] data - pointer to wrapper data structure
+ *
+ * @return int as error code.
+ */
+static int
+dispatch_lacp_selections_request(uint8_t *data)
+{
+    int err = 0;
+    struct lacp_selections_request_event_data *request =
+        (struct lacp_selections_request_event_data *) data;
+
+    err = lacp_manager_aggregator_selections_request(request->selections,
+                                                     request->selections_num);
+    MLAG_BAIL_ERROR_MSG(err, "Failed handling LACP selections request\n");
+
+bail:
+    return err;
+}
+
+/*
+ *  This function dispatches lacp aggregator selections of several
+ *  ports, request on master or response on the requester
+ *
+ *  @param[in] data - pointer to wrapper data structure
+ *
+ * @return int as error code.
+ */
+static int
+dispatch_lacp_selections_event(uint8_t *data)
+{
+    int err = 0;
+    struct lacp_selections_message *msg =
+        (struct lacp_selections_message *) data;
+
+    err = lacp_manager_aggregator_selections_handle(msg);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to handle aggregation selections event\n");
+
+bail:
+    return err;
+}
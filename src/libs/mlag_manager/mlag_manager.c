@@ -29,6 +29,8 @@
 #include <complib/cl_init.h>
 #include <complib/cl_timer.h>
 #include <complib/cl_event.h>
+#include <complib/cl_mem.h>
+#include <complib/cl_spinlock.h>
 #include <utils/mlag_log.h>
 #include "lib_commu.h"
 #include <utils/mlag_events.h>
@@ -36,11 +38,15 @@
 #include <libs/port_manager/port_manager.h>
 #include <libs/health_manager/health_manager.h>
 #include <libs/mlag_topology/mlag_topology.h>
+#include <libs/service_layer/service_layer.h>
+#include <libs/notification_layer/notification_layer.h>
 #include "mlag_manager.h"
 #include "mlag_manager_db.h"
 #include "mlag_peering_fsm.h"
 #include "mlag_common.h"
+#include "mlag_state_publisher.h"
 #include "mlag_comm_layer_wrapper.h"
+#include "mlag_wire.h"
 #include "mlag_dispatcher.h"
 
 /************************************************
@@ -57,16 +63,23 @@
  *  Local Macros
  ***********************************************/
 #define MLAG_MANAGER_STOP_TIMEOUT 5000000 /* 5 sec */
-#define MLAG_MANAGER_PORT_DELETE_DONE_TIMEOUT 5000000 /* 5 sec */
+#define MLAG_MANAGER_PORT_DELETE_DONE_TIMEOUT 5000 /* 5 sec */
+#define MLAG_MANAGER_PORT_DELETE_TICK 1000 /* 1 sec */
 
 /************************************************
  *  Local Type definitions
  ***********************************************/
-static int
-rcv_msg_handler(uint8_t *data);
+/* Add/delete progress of a port configured through mlag_ports_set */
+struct port_cfg_entry {
+    cl_map_item_t map_item;
+    unsigned long port_id;
+    enum mlag_port_cfg_state state;
+    /* Ticks left until a pending delete is completed without the modules */
+    uint32_t delete_ticks;
+};
 
 static int
-net_order_msg_handler(uint8_t *data, int oper);
+rcv_msg_handler(uint8_t *data);
 
 /************************************************
  *  Global variables
@@ -77,13 +90,24 @@ net_order_msg_handler(uint8_t *data, int oper);
 
 static handler_command_t mlag_mngr_ibc_msgs[] = {
     {MLAG_PEER_START_EVENT, "Peer start event", rcv_msg_handler,
-     net_order_msg_handler },
+     NULL},
     {MLAG_PEER_ENABLE_EVENT, "Peer Enable event", rcv_msg_handler,
-     net_order_msg_handler},
+     NULL},
 
     {0, "", NULL, NULL}
 };
 
+static const struct mlag_wire_field peer_state_change_wire[] = {
+    MLAG_WIRE_FIELD(struct peer_state_change_data, mlag_id),
+    MLAG_WIRE_FIELD(struct peer_state_change_data, state),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_msg mlag_manager_wire_msgs[] = {
+    MLAG_WIRE_MSG(MLAG_PEER_START_EVENT, peer_state_change_wire),
+    MLAG_WIRE_MSG(MLAG_PEER_ENABLE_EVENT, peer_state_change_wire),
+};
+
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_DEBUG;
 
 static int current_role = NONE;
@@ -99,11 +123,24 @@ struct mlag_manager_counters counters;
 
 cl_event_t stop_done_cl_event;
 static int stop_done_states;
-cl_event_t port_delete_done_cl_event;
+static struct port_cfg_entry *port_cfg_entries;
+static uint32_t port_cfg_entries_num;
+/* Entries in use, keyed by port id */
+static cl_qmap_t port_cfg_map;
+/* Next entry to consider for allocation */
+static uint32_t port_cfg_alloc_idx;
+static uint32_t port_cfg_delete_pending;
+static cl_spinlock_t port_cfg_lock;
+static cl_timer_t port_delete_timer;
+static int port_delete_timer_running;
+/* Ports whose delete timed out, used only from the timer callback */
+static unsigned long *port_delete_expired;
 
 /************************************************
  *  Local function declarations
  ***********************************************/
+static void
+port_delete_timer_cb(void *data);
 
 /************************************************
  *  Function implementations
@@ -255,74 +292,6 @@ bail:
     return err;
 }
 
-/*
- *  Convert struct between network and host order
- *
- * @param[in] data - struct body
- * @param[in] oper - conversion direction
- *
- * @return 0 when successful, otherwise ERROR
- */
-static void
-net_order_peer_state_change_data(struct peer_state_change_data *data, int oper)
-{
-    if (oper == MESSAGE_SENDING) {
-        data->mlag_id = htonl(data->mlag_id);
-        data->state = htonl(data->state);
-    }
-    else {
-        data->mlag_id = ntohl(data->mlag_id);
-        data->state = ntohl(data->state);
-    }
-}
-
-/*
- *  This function is called to handle network order for IBC message
- *
- * @param[in] payload_data - message body
- * @param[in] oper - on send or receive
- *
- * @return 0 when successful, otherwise ERROR
- */
-static int
-net_order_msg_handler(uint8_t *data, int oper)
-{
-    int err = 0;
-    uint16_t opcode;
-    struct peer_state_change_data *state_change;
-
-    if (oper == MESSAGE_SENDING) {
-        opcode = *(uint16_t*)data;
-        *(uint16_t*)data = htons(opcode);
-    }
-    else {
-        opcode = ntohs(*(uint16_t*)data);
-        *(uint16_t*)data = opcode;
-    }
-
-    switch (opcode) {
-    case MLAG_PEER_START_EVENT:
-        state_change =
-            (struct peer_state_change_data *) (data);
-        net_order_peer_state_change_data(state_change, oper);
-        break;
-    case MLAG_PEER_ENABLE_EVENT:
-        state_change =
-            (struct peer_state_change_data *) (data);
-        net_order_peer_state_change_data(state_change, oper);
-        break;
-    default:
-        /* Unknown opcode */
-        err = -ENOENT;
-        MLAG_BAIL_ERROR_MSG(err, "Unknown opcode [%u] in mlag manager\n",
-                            opcode);
-        break;
-    }
-
-bail:
-    return err;
-}
-
 /*
  * This function sets the whether the peer get enabled event.
  *
@@ -360,6 +329,29 @@ peer_state_set(uint32_t *state_vector, int peer_id, uint32_t state)
     *state_vector |= ((state & 1) << peer_id);
 }
 
+/*
+ *  This function notifies subscribers of a peer state change
+ *
+ * @param[in] peer_id - peer index
+ * @param[in] state - peer state
+ *
+ * @return void
+ */
+static void
+peer_state_notify(int peer_id, enum mlag_peer_state state)
+{
+    struct mlag_notification notify;
+
+    SAFE_MEMSET(&notify, 0);
+    notify.notification_type = MLAG_NOTIFY_PEER_STATE_CHANGE;
+    notify.notification_info.peer_state.mlag_id = peer_id;
+    notify.notification_info.peer_state.peer_state = state;
+    if (mlag_notify(&notify)) {
+        MLAG_LOG(MLAG_LOG_ERROR, "Failed to notify peer [%d] state\n",
+                 peer_id);
+    }
+}
+
 /*
  *  This function implements timer event handling
  *  for reload delay timer
@@ -452,6 +444,7 @@ peer_sync_done_cb(int peer_id)
                               sizeof(peer_en));
         MLAG_BAIL_ERROR_MSG(err,
                             "Failed in sending peer enable event\n");
+        peer_state_notify(peer_id, MLAG_PEER_UP);
     }
 
     /* Immediately open new ports when active slave becomes Standalone */
@@ -487,6 +480,10 @@ mlag_manager_init(insert_to_command_db_func insert_msgs_cb)
     err = insert_msgs_cb(mlag_mngr_ibc_msgs);
     MLAG_BAIL_ERROR(err);
 
+    err = mlag_wire_msgs_register(mlag_manager_wire_msgs,
+                                  NUM_ELEMS(mlag_manager_wire_msgs));
+    MLAG_BAIL_ERROR(err);
+
     err = mlag_manager_db_init();
     MLAG_BAIL_ERROR_MSG(err, "Failed to init mlag manager DB\n");
 
@@ -506,12 +503,40 @@ mlag_manager_init(insert_to_command_db_func insert_msgs_cb)
     }
     stop_done_states = 0;
 
-    cl_event_construct(&port_delete_done_cl_event);
+    cl_err = cl_timer_init(&port_delete_timer, port_delete_timer_cb, NULL);
+    if (cl_err != CL_SUCCESS) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to init port delete timer\n");
+    }
+    port_delete_timer_running = FALSE;
 
-    cl_err = cl_event_init(&port_delete_done_cl_event, FALSE);
-    if (cl_err == CL_ERROR) {
-        err = cl_err;
-        MLAG_BAIL_ERROR_MSG(err, "Failed to init port delete_done cl_event\n");
+    cl_err = cl_spinlock_init(&port_cfg_lock);
+    if (cl_err != CL_SUCCESS) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to init port cfg lock\n");
+    }
+
+    /* Keep completed entries of about as many ports as may be pending */
+    port_cfg_entries_num = 2 * mlag_max_ports_get();
+    port_cfg_entries = (struct port_cfg_entry *)
+                       cl_malloc(port_cfg_entries_num *
+                                 sizeof(struct port_cfg_entry));
+    if (port_cfg_entries == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate port cfg entries\n");
+    }
+    memset(port_cfg_entries, 0,
+           port_cfg_entries_num * sizeof(struct port_cfg_entry));
+    cl_qmap_init(&port_cfg_map);
+    port_cfg_alloc_idx = 0;
+    port_cfg_delete_pending = 0;
+
+    port_delete_expired = (unsigned long *)
+                          cl_malloc(port_cfg_entries_num *
+                                    sizeof(unsigned long));
+    if (port_delete_expired == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate port delete list\n");
     }
 
     for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
@@ -543,7 +568,19 @@ mlag_manager_deinit(void)
     cl_timer_destroy(&reload_delay_timer);
 
     cl_event_destroy(&stop_done_cl_event);
-    cl_event_destroy(&port_delete_done_cl_event);
+
+    /* The timer callback uses the port cfg entries */
+    cl_timer_destroy(&port_delete_timer);
+
+    if (port_delete_expired != NULL) {
+        cl_free(port_delete_expired);
+        port_delete_expired = NULL;
+    }
+    if (port_cfg_entries != NULL) {
+        cl_free(port_cfg_entries);
+        port_cfg_entries = NULL;
+    }
+    cl_spinlock_destroy(&port_cfg_lock);
 
     return err;
 }
@@ -732,11 +769,20 @@ mlag_manager_role_change(int previous_role, int new_role)
 {
     int err = 0;
     struct mlag_master_election_status me_status;
+    struct mlag_notification notify;
 
     MLAG_LOG(MLAG_LOG_NOTICE, "Role change from [%d] to [%d] \n",
              previous_role, new_role);
     current_role = new_role;
 
+    /* Role values match the system role states */
+    SAFE_MEMSET(&notify, 0);
+    notify.notification_type = MLAG_NOTIFY_ROLE_CHANGE;
+    notify.notification_info.role_change.previous_role = previous_role;
+    notify.notification_info.role_change.role = new_role;
+    err = mlag_notify(&notify);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to notify role change\n");
+
     err = mlag_master_election_get_status(&me_status);
     MLAG_BAIL_ERROR_MSG(err, "Failed getting ME status\n");
 
@@ -759,6 +805,7 @@ mlag_manager_role_change(int previous_role, int new_role)
     }
 
 bail:
+    mlag_state_publisher_changed();
     return err;
 }
 
@@ -776,6 +823,7 @@ mlag_manager_peer_status_change(struct peer_state_change_data *state_change)
 
     if (state_change->state == HEALTH_PEER_UP) {
         peer_state_set(&peer_states, state_change->mlag_id, TRUE);
+        peer_state_notify(state_change->mlag_id, MLAG_PEER_PEERING);
         err = mlag_peering_fsm_peer_up_ev(&peering_fsm[state_change->mlag_id]);
         MLAG_BAIL_ERROR_MSG(err, "Failed to start peering with peer [%d]\n",
                             state_change->mlag_id);
@@ -785,6 +833,7 @@ mlag_manager_peer_status_change(struct peer_state_change_data *state_change)
              (state_change->state == HEALTH_PEER_COMM_DOWN)) {
         /* Peer down */
         peer_state_set(&peer_states, state_change->mlag_id, FALSE);
+        peer_state_notify(state_change->mlag_id, MLAG_PEER_DOWN);
         /* unset slave global variable peer enable event */
         err = mlag_manager_peer_enable_event_set(FALSE);
         MLAG_BAIL_ERROR(err);
@@ -800,6 +849,7 @@ mlag_manager_peer_status_change(struct peer_state_change_data *state_change)
     }
 
 bail:
+    mlag_state_publisher_changed();
     return err;
 }
 
@@ -1342,60 +1392,312 @@ bail:
     return err;
 }
 
-/**
- * This function waits for port delete process done
+/*
+ * This function finds the tracking entry of a port.
+ * Called with port_cfg_lock held.
+ *
+ * @param[in] port_id - port id
+ *
+ * @return entry, NULL if the port is not tracked
+ */
+static struct port_cfg_entry *
+port_cfg_entry_get(unsigned long port_id)
+{
+    cl_map_item_t *map_item;
+
+    map_item = cl_qmap_get(&port_cfg_map, (uint64_t)port_id);
+    if (map_item == cl_qmap_end(&port_cfg_map)) {
+        return NULL;
+    }
+    return PARENT_STRUCT(map_item, struct port_cfg_entry, map_item);
+}
+
+/*
+ * This function gets an entry to track a port not tracked yet. Entries
+ * are taken round robin, skipping those of pending operations, so the
+ * entry of the oldest completed operation is reused first.
+ * Called with port_cfg_lock held.
+ *
+ * @param[in] port_id - port id
+ *
+ * @return entry, NULL if all entries are pending
+ */
+static struct port_cfg_entry *
+port_cfg_entry_alloc(unsigned long port_id)
+{
+    uint32_t i;
+    struct port_cfg_entry *entry;
+
+    for (i = 0; i < port_cfg_entries_num; i++) {
+        entry = &port_cfg_entries[port_cfg_alloc_idx];
+        port_cfg_alloc_idx = (port_cfg_alloc_idx + 1) % port_cfg_entries_num;
+        if ((entry->state == MLAG_PORT_CFG_STATE_ADD_PENDING) ||
+            (entry->state == MLAG_PORT_CFG_STATE_DELETE_PENDING)) {
+            continue;
+        }
+        if (entry->state != MLAG_PORT_CFG_STATE_NONE) {
+            cl_qmap_remove_item(&port_cfg_map, &entry->map_item);
+        }
+        entry->port_id = port_id;
+        entry->state = MLAG_PORT_CFG_STATE_NONE;
+        cl_qmap_insert(&port_cfg_map, (uint64_t)port_id, &entry->map_item);
+        return entry;
+    }
+
+    return NULL;
+}
+
+/*
+ * This function sets the state of a tracking entry, an entry set to
+ * MLAG_PORT_CFG_STATE_NONE is released. Called with port_cfg_lock held.
+ *
+ * @param[in] entry - tracking entry
+ * @param[in] state - new state
+ *
+ * @return void
+ */
+static void
+port_cfg_entry_state_set(struct port_cfg_entry *entry,
+                         enum mlag_port_cfg_state state)
+{
+    if (entry->state == MLAG_PORT_CFG_STATE_DELETE_PENDING) {
+        port_cfg_delete_pending--;
+    }
+    if (state == MLAG_PORT_CFG_STATE_DELETE_PENDING) {
+        port_cfg_delete_pending++;
+        /* The first tick may come right away */
+        entry->delete_ticks = (MLAG_MANAGER_PORT_DELETE_DONE_TIMEOUT /
+                               MLAG_MANAGER_PORT_DELETE_TICK) + 1;
+    }
+    if ((state == MLAG_PORT_CFG_STATE_NONE) &&
+        (entry->state != MLAG_PORT_CFG_STATE_NONE)) {
+        cl_qmap_remove_item(&port_cfg_map, &entry->map_item);
+    }
+    entry->state = state;
+}
+
+/*
+ * This function destroys a deleted port in the service layer
+ *
+ * @param[in] port_id - deleted port
  *
  * @return 0 - Operation completed successfully.
  */
-int
-mlag_manager_wait_for_port_delete_done(void)
+static int
+port_cfg_port_destroy(unsigned long port_id)
 {
     int err = 0;
-    cl_status_t cl_err = CL_SUCCESS;
+    struct port_cfg_entry *entry;
 
-    MLAG_LOG(MLAG_LOG_NOTICE,
-             "Waiting for port delete done event\n");
+    err = sl_api_port_set(OES_ACCESS_CMD_DESTROY, port_id);
+    if (err) {
+        cl_spinlock_acquire(&port_cfg_lock);
+        entry = port_cfg_entry_get(port_id);
+        if ((entry != NULL) &&
+            (entry->state == MLAG_PORT_CFG_STATE_DELETED)) {
+            port_cfg_entry_state_set(entry, MLAG_PORT_CFG_STATE_FAILED);
+        }
+        cl_spinlock_release(&port_cfg_lock);
+    }
+    MLAG_BAIL_ERROR_MSG(err, "Failed to destroy port [%lu]\n", port_id);
 
-    cl_err = cl_event_wait_on(&port_delete_done_cl_event,
-                              MLAG_MANAGER_PORT_DELETE_DONE_TIMEOUT, 1);
-    if (cl_err == CL_TIMEOUT) {
-        err = cl_err;
+bail:
+    return err;
+}
+
+/*
+ *  This function implements timer event handling for pending port
+ *  deletes. A port whose delete done event did not arrive within
+ *  MLAG_MANAGER_PORT_DELETE_DONE_TIMEOUT is destroyed anyway.
+ *
+ * @param[in] data - timer event data
+ *
+ * @return void
+ */
+static void
+port_delete_timer_cb(void *data)
+{
+    uint32_t i;
+    uint32_t expired_num = 0;
+    int restart;
+    struct port_cfg_entry *entry;
+    UNUSED_PARAM(data);
+
+    cl_spinlock_acquire(&port_cfg_lock);
+    for (i = 0; i < port_cfg_entries_num; i++) {
+        entry = &port_cfg_entries[i];
+        if (entry->state != MLAG_PORT_CFG_STATE_DELETE_PENDING) {
+            continue;
+        }
+        entry->delete_ticks--;
+        if (entry->delete_ticks == 0) {
+            port_cfg_entry_state_set(entry, MLAG_PORT_CFG_STATE_DELETED);
+            port_delete_expired[expired_num++] = entry->port_id;
+        }
+    }
+    port_delete_timer_running = (port_cfg_delete_pending > 0);
+    restart = port_delete_timer_running;
+    cl_spinlock_release(&port_cfg_lock);
+
+    for (i = 0; i < expired_num; i++) {
         MLAG_LOG(MLAG_LOG_WARNING,
-                 "Timeout in waiting on port delete done event\n");
-        goto bail;
+                 "Timeout in waiting on port [%lu] delete done event\n",
+                 port_delete_expired[i]);
+        port_cfg_port_destroy(port_delete_expired[i]);
     }
-    if (cl_err == CL_ERROR) {
-        err = cl_err;
-        MLAG_BAIL_ERROR_MSG(err,
-                            "Failed in waiting for port delete done event, err=%d\n",
-                            err);
+
+    if (restart) {
+        cl_timer_start(&port_delete_timer, MLAG_MANAGER_PORT_DELETE_TICK);
+    }
+}
+
+/**
+ * This function marks ports as pending add or delete
+ *
+ * @param[in] ports - ports array
+ * @param[in] ports_cnt - number of ports
+ * @param[in] is_delete - TRUE for delete, FALSE for add
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -ENOSPC - No entry left to track the ports.
+ */
+int
+mlag_manager_port_cfg_pending_set(const unsigned long *ports,
+                                  unsigned int ports_cnt, int is_delete)
+{
+    int err = 0;
+    int start_timer = FALSE;
+    unsigned int i, j;
+    struct port_cfg_entry *entry;
+
+    cl_spinlock_acquire(&port_cfg_lock);
+    for (i = 0; i < ports_cnt; i++) {
+        entry = port_cfg_entry_get(ports[i]);
+        if (entry == NULL) {
+            entry = port_cfg_entry_alloc(ports[i]);
+        }
+        if (entry == NULL) {
+            err = -ENOSPC;
+            break;
+        }
+        port_cfg_entry_state_set(entry,
+                                 (is_delete ?
+                                  MLAG_PORT_CFG_STATE_DELETE_PENDING :
+                                  MLAG_PORT_CFG_STATE_ADD_PENDING));
+    }
+    if (err) {
+        /* The request is rejected as a whole */
+        for (j = 0; j < i; j++) {
+            entry = port_cfg_entry_get(ports[j]);
+            if (entry != NULL) {
+                port_cfg_entry_state_set(entry, MLAG_PORT_CFG_STATE_NONE);
+            }
+        }
     }
+    if ((port_cfg_delete_pending > 0) && (port_delete_timer_running == FALSE)) {
+        port_delete_timer_running = TRUE;
+        start_timer = TRUE;
+    }
+    cl_spinlock_release(&port_cfg_lock);
+    MLAG_BAIL_ERROR_MSG(err, "No room to track port [%lu] configuration\n",
+                        ports[i]);
 
 bail:
+    if (start_timer) {
+        cl_timer_start(&port_delete_timer, MLAG_MANAGER_PORT_DELETE_TICK);
+    }
     return err;
 }
 
 /**
- * This function handles port delete done event
+ * This function sets the completion state of ports
+ *
+ * @param[in] ports - ports array
+ * @param[in] ports_cnt - number of ports
+ * @param[in] state - completion state
+ *
+ * @return void
+ */
+void
+mlag_manager_port_cfg_done(const unsigned long *ports,
+                           unsigned int ports_cnt,
+                           enum mlag_port_cfg_state state)
+{
+    unsigned int i;
+    struct port_cfg_entry *entry;
+
+    cl_spinlock_acquire(&port_cfg_lock);
+    for (i = 0; i < ports_cnt; i++) {
+        entry = port_cfg_entry_get(ports[i]);
+        if (entry != NULL) {
+            port_cfg_entry_state_set(entry, state);
+        }
+    }
+    cl_spinlock_release(&port_cfg_lock);
+}
+
+/**
+ * This function gets the add/delete progress of ports
+ *
+ * @param[in,out] ports_cfg - In: port_id of each entry.
+ *                            Out: state of each entry.
+ * @param[in] ports_cnt - number of entries
+ *
+ * @return void
+ */
+void
+mlag_manager_port_cfg_state_get(struct mlag_port_cfg_info *ports_cfg,
+                                unsigned int ports_cnt)
+{
+    unsigned int i;
+    struct port_cfg_entry *entry;
+
+    cl_spinlock_acquire(&port_cfg_lock);
+    for (i = 0; i < ports_cnt; i++) {
+        entry = port_cfg_entry_get(ports_cfg[i].port_id);
+        ports_cfg[i].state = (entry != NULL) ? entry->state :
+                             MLAG_PORT_CFG_STATE_NONE;
+    }
+    cl_spinlock_release(&port_cfg_lock);
+}
+
+/**
+ * This function handles port delete done event. Once all modules
+ * released the port it is destroyed in the service layer, unless the
+ * delete timed out and the port was destroyed already.
+ *
+ * @param[in] port_id - deleted port
+ * @param[in] status - 1 if port deleted successfully, 0 otherwise
  *
  * @return 0 - Operation completed successfully.
  */
 int
-mlag_manager_port_delete_done(void)
+mlag_manager_port_delete_done(unsigned long port_id, int status)
 {
     int err = 0;
-    cl_status_t cl_err = CL_SUCCESS;
+    struct port_cfg_entry *entry;
 
     MLAG_LOG(MLAG_LOG_NOTICE,
-             "Port delete done event accepted\n");
-
-    cl_err = cl_event_signal(&port_delete_done_cl_event);
-    if (cl_err == CL_ERROR) {
-        err = cl_err;
-        MLAG_BAIL_ERROR_MSG(err,
-                            "Failed to signal port delete_done cl_event, err=%d\n",
-                            err);
+             "Port [%lu] delete done event accepted, status [%d]\n",
+             port_id, status);
+
+    cl_spinlock_acquire(&port_cfg_lock);
+    entry = port_cfg_entry_get(port_id);
+    if ((entry != NULL) &&
+        (entry->state != MLAG_PORT_CFG_STATE_DELETE_PENDING)) {
+        cl_spinlock_release(&port_cfg_lock);
+        MLAG_LOG(MLAG_LOG_NOTICE,
+                 "Port [%lu] delete is not pending, not destroyed\n",
+                 port_id);
+        goto bail;
     }
+    if (entry != NULL) {
+        port_cfg_entry_state_set(entry, MLAG_PORT_CFG_STATE_DELETED);
+    }
+    cl_spinlock_release(&port_cfg_lock);
+
+    err = port_cfg_port_destroy(port_id);
+    MLAG_BAIL_ERROR(err);
 
 bail:
     return err;
@@ -1413,13 +1715,14 @@ mlag_manager_peer_enable(struct peer_state_change_data *data)
 {
     int err = 0;
 
-    UNUSED_PARAM(data);
-
     /* set slave global variable peer enable event */
     err = mlag_manager_peer_enable_event_set(TRUE);
     MLAG_BAIL_ERROR(err);
 
+    peer_state_notify(data->mlag_id, MLAG_PEER_UP);
+
 bail:
+    mlag_state_publisher_changed();
     return err;
 }
 
@@ -312,20 +312,57 @@ mlag_manager_stop_done_handle(uint8_t *event);
 
 
 /**
- * This function waits for port delete process done
+ * This function marks ports as pending add or delete
+ *
+ * @param[in] ports - ports array
+ * @param[in] ports_cnt - number of ports
+ * @param[in] is_delete - TRUE for delete, FALSE for add
  *
  * @return 0 - Operation completed successfully.
+ * @return -ENOSPC - No entry left to track the ports.
  */
 int
-mlag_manager_wait_for_port_delete_done(void);
+mlag_manager_port_cfg_pending_set(const unsigned long *ports,
+                                  unsigned int ports_cnt, int is_delete);
+
+/**
+ * This function sets the completion state of ports
+ *
+ * @param[in] ports - ports array
+ * @param[in] ports_cnt - number of ports
+ * @param[in] state - completion state
+ *
+ * @return void
+ */
+void
+mlag_manager_port_cfg_done(const unsigned long *ports,
+                           unsigned int ports_cnt,
+                           enum mlag_port_cfg_state state);
 
 /**
- * This function handles port delete done event
+ * This function gets the add/delete progress of ports
+ *
+ * @param[in,out] ports_cfg - In: port_id of each entry.
+ *                            Out: state of each entry.
+ * @param[in] ports_cnt - number of entries
+ *
+ * @return void
+ */
+void
+mlag_manager_port_cfg_state_get(struct mlag_port_cfg_info *ports_cfg,
+                                unsigned int ports_cnt);
+
+/**
+ * This function handles port delete done event. Once all modules
+ * released the port it is destroyed in the service layer.
+ *
+ * @param[in] port_id - deleted port
+ * @param[in] status - 1 if port deleted successfully, 0 otherwise
  *
  * @return 0 - Operation completed successfully.
  */
 int
-mlag_manager_port_delete_done(void);
+mlag_manager_port_delete_done(unsigned long port_id, int status);
 
 
 /**
@@ -32,6 +32,7 @@
 #include <utils/mlag_defs.h>
 #include <mlag_manager_db.h>
 #include "mlag_manager.h"
+#include <libs/mlag_common/mlag_lock_prof.h>
 
 /************************************************
  *  Global variables
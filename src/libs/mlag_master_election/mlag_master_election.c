@@ -42,6 +42,7 @@
 #include "mlag_master_election.h"
 #include "mlag_master_election_fsm.h"
 #include "health_manager.h"
+#include <libs/mlag_common/mlag_lock_prof.h>
 
 /************************************************
  *  Local Defines
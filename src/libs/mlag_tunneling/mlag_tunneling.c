@@ -26,8 +26,12 @@
  */
 
 #include <errno.h>
+#include <stddef.h>
+#include <poll.h>
+#include <time.h>
 #include <complib/cl_init.h>
 #include <complib/cl_thread.h>
+#include <complib/cl_mem.h>
 #include <net/ethernet.h>
 #include <utils/mlag_log.h>
 #include <utils/mlag_bail.h>
@@ -41,6 +45,7 @@
 #include "health_manager.h"
 #include "mlag_master_election.h"
 #include "mlag_comm_layer_wrapper.h"
+#include "mlag_wire.h"
 #include "mlag_topology.h"
 #include "mlag_api_defs.h"
 #include "mlag_tunneling.h"
@@ -54,11 +59,34 @@
 
 #define MAX_PACKET_SIZE 9600
 
+/* Trapped packets drained per wakeup and sent to the peer as one message */
+#define TUNNEL_BATCH_MAX_PKTS 64
+#define TUNNEL_BATCH_BUF_SIZE (32 * 1024)
+
 #define TUNNEL_DISP_SYS_EVENT_BUF_SIZE 1500
 
+/* Recently forwarded reports, power of 2 */
+#define TUNNEL_REPORT_TABLE_SIZE 4096
+#define TUNNEL_REPORT_PROBE_MAX  8
+
 /************************************************
  *  Local Macros
  ***********************************************/
+#define IGMP_WRAPPER_HDR_SIZE \
+    offsetof(struct igmp_packet_wrapper, packet_buffer)
+
+/* Batch entry lengths are padded to a multiple of 8 bytes. Entries follow
+ * the packed batch header, so they are not 8 bytes aligned in the message
+ * and are only accessed through the packed structures.
+ */
+#define TUNNEL_BATCH_ALIGN(len) (((len) + 7) & ~7UL)
+
+#define TUNNEL_BATCH_ENTRY_SIZE(pkt_size) \
+    TUNNEL_BATCH_ALIGN(IGMP_WRAPPER_HDR_SIZE + (pkt_size))
+
+#define TUNNEL_TRAP_TYPE_STR(type) ((TUNNEL_TRAP_TYPE_NUM > (type)) ? \
+                                    tunnel_trap_type_str[(type)] : \
+                                    "Unknown")
 
 /************************************************
  *  Local Type definitions
@@ -68,16 +96,71 @@ struct tunneling_counters {
     unsigned long long sent_queries;
     unsigned long long received_from_peer;
     unsigned long long sent_to_peer;
+    unsigned long long sent_batches;
+    unsigned long long received_batches;
+    unsigned long long max_batch;
+    unsigned long long dropped_from_peer;
 };
 
 struct __attribute__((__packed__)) igmp_packet_wrapper {
-    int opcode;
+    uint16_t opcode;
     int sending_peer_id;
     struct sl_trap_receive_info receive_info;
     unsigned long pkt_size;
     uint8_t packet_buffer[MAX_PACKET_SIZE];
 };
 
+enum tunnel_trap_type {
+    TUNNEL_TRAP_QUERY,
+    TUNNEL_TRAP_V1_REPORT,
+    TUNNEL_TRAP_V2_REPORT,
+    TUNNEL_TRAP_V2_LEAVE,
+    TUNNEL_TRAP_OTHER,
+    TUNNEL_TRAP_TYPE_NUM
+};
+
+struct tunnel_trap_counters {
+    unsigned long long forwarded;
+    unsigned long long suppressed_dup;  /* duplicate report in window */
+    unsigned long long suppressed_rate; /* out of tokens */
+};
+
+/* Token bucket, one second worth of packets deep. Tokens are kept in
+ * thousandths so that refill is done with msec resolution.
+ */
+struct tunnel_token_bucket {
+    uint64_t tokens;
+    uint64_t last_msec;
+};
+
+/* A report forwarded to peer, free when last_msec is 0 */
+struct tunnel_report_entry {
+    uint32_t group;
+    uint16_t vlan;
+    unsigned long port_id;
+    uint64_t last_msec;
+};
+
+/* MLAG_TUNNELING_IGMP_BATCH_MESSAGE is this header followed by pkt_num
+ * igmp_packet_wrapper entries, each holding pkt_size bytes of packet and
+ * padded to TUNNEL_BATCH_ENTRY_SIZE. Entries are kept in network order.
+ */
+struct __attribute__((__packed__)) igmp_batch_header {
+    uint16_t opcode;
+    int sending_peer_id;
+    uint32_t pkt_num;
+    uint32_t batch_len; /* bytes of entries following the header */
+};
+
+/* Peer lookups done once per connection rather than per packet */
+struct tunnel_peer_cache {
+    int valid;
+    uint32_t ipv4_addr; /* network order, as reported by comm library */
+    int mlag_id;
+    int ipl_valid;
+    unsigned long ipl_ifindex;
+};
+
 enum {
     TERMINATE_HANDLE,
     EVENTS_HANDLE,
@@ -103,6 +186,9 @@ tunnel_dispatch_peer_state_change_event(uint8_t *buffer);
 static int
 tunnel_dispatch_port_state_change(uint8_t *buffer);
 
+static int
+tunnel_dispatch_ports_state_change(uint8_t *buffer);
+
 static int
 tunnel_dispatch_status_change(uint8_t *buffer);
 
@@ -115,6 +201,9 @@ tunnel_dispatch_start(uint8_t *buffer);
 static int
 tunnel_dispatch_stop(uint8_t *buffer);
 
+static int
+tunnel_dispatch_igmp_params_set(uint8_t *buffer);
+
 static int
 tunnel_dispatch_reconnect_event(uint8_t *data);
 
@@ -133,8 +222,10 @@ static int medium_prio_events[] =
     MLAG_CONN_NOTIFY_EVENT,
     MLAG_RECONNECT_EVENT,
     MLAG_PORT_OPER_STATE_CHANGE_EVENT,
+    MLAG_PORTS_OPER_STATE_CHANGE_EVENT,
     MLAG_START_EVENT,
-    MLAG_STOP_EVENT
+    MLAG_STOP_EVENT,
+    MLAG_TUNNELING_IGMP_PARAMS_SET
 };
 
 static event_disp_fds_t tunnel_event_fds;
@@ -156,14 +247,19 @@ static handler_command_t tunnel_dispatcher_commands[] = {
      tunnel_dispatch_reconnect_event, NULL},
     {MLAG_PORT_OPER_STATE_CHANGE_EVENT, "Port oper state change event",
      tunnel_dispatch_port_state_change, NULL},
+    {MLAG_PORTS_OPER_STATE_CHANGE_EVENT, "Ports oper state change event",
+     tunnel_dispatch_ports_state_change, NULL},
     {MLAG_START_EVENT, "Start event", tunnel_dispatch_start, NULL},
     {MLAG_STOP_EVENT, "Stop event", tunnel_dispatch_stop, NULL},
+    {MLAG_TUNNELING_IGMP_PARAMS_SET, "IGMP params set",
+     tunnel_dispatch_igmp_params_set, NULL},
     {0, "", NULL, NULL}
 };
 
 static struct dispatcher_conf tunnel_dispatcher_conf;
 
-static char tunnel_disp_sys_event_buf[TUNNEL_DISP_SYS_EVENT_BUF_SIZE];
+static char *tunnel_disp_sys_event_buf;
+static uint32_t tunnel_disp_sys_event_buf_size;
 
 static struct tunneling_counters counters;
 
@@ -173,10 +269,62 @@ static unsigned int peer_connected;
 
 static int sl_fd;
 
-/* This parameter will be used only from the tunneling thread, and therefore
- * can be a singleton.
+/* Trapped packets are received straight into this buffer, back to back
+ * behind the batch header, and sent to the peer from there. It is used only
+ * from the tunneling thread, and therefore can be a singleton.
  */
-static struct igmp_packet_wrapper curr_packet;
+static uint64_t batch_buf[TUNNEL_BATCH_BUF_SIZE / sizeof(uint64_t)];
+
+/* Used only from the tunneling thread as well */
+static struct tunnel_peer_cache peer_cache[MLAG_MAX_PEERS];
+
+/* Suppression state, used only from the tunneling thread */
+static struct tunnel_report_entry report_table[TUNNEL_REPORT_TABLE_SIZE];
+static struct tunnel_token_bucket trap_bucket[TUNNEL_TRAP_TYPE_NUM];
+static struct tunnel_trap_counters trap_counters[TUNNEL_TRAP_TYPE_NUM];
+static unsigned int suppress_window_msec =
+    MLAG_IGMP_SUPPRESS_WINDOW_MSEC_DEFAULT;
+static unsigned int rate_limit = MLAG_IGMP_RATE_LIMIT_DEFAULT;
+
+static char *tunnel_trap_type_str[] = {
+    "Query",
+    "V1 report",
+    "V2 report",
+    "V2 leave",
+    "Other",
+};
+
+/* Trap info and size of a packet, single messages and batch entries */
+#define TUNNEL_PKT_WIRE_FIELDS                                                \
+    MLAG_WIRE_FIELD(struct igmp_packet_wrapper, receive_info.l2_trap_id),     \
+    MLAG_WIRE_FIELD(struct igmp_packet_wrapper, receive_info.source_port_id), \
+    MLAG_WIRE_FIELD(struct igmp_packet_wrapper, receive_info.is_mlag),        \
+    MLAG_WIRE_FIELD(struct igmp_packet_wrapper, pkt_size)
+
+/* Batch entries are converted by the tunneling itself, the wrapper
+ * converts the batch header only */
+static const struct mlag_wire_field tunnel_entry_wire[] = {
+    TUNNEL_PKT_WIRE_FIELDS,
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field tunnel_pkt_wire[] = {
+    MLAG_WIRE_FIELD(struct igmp_packet_wrapper, sending_peer_id),
+    TUNNEL_PKT_WIRE_FIELDS,
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field tunnel_batch_wire[] = {
+    MLAG_WIRE_FIELD(struct igmp_batch_header, sending_peer_id),
+    MLAG_WIRE_FIELD(struct igmp_batch_header, pkt_num),
+    MLAG_WIRE_FIELD(struct igmp_batch_header, batch_len),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_msg tunnel_wire_msgs[] = {
+    MLAG_WIRE_MSG(MLAG_TUNNELING_IGMP_MESSAGE, tunnel_pkt_wire),
+    MLAG_WIRE_MSG(MLAG_TUNNELING_IGMP_BATCH_MESSAGE, tunnel_batch_wire),
+};
 
 struct sl_api_ctrl_pkt_data igmp_query_pkt_data;
 
@@ -236,6 +384,163 @@ bail:
     return err;
 }
 
+/*
+ *  This function returns cached lookups of the peer on the other end
+ *  of the connection, the entry is filled on first use.
+ *
+ * @param[in] ipv4_addr - peer ip address, network order
+ * @param[out] peer - cache entry of the peer
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+tunnel_peer_cache_get(uint32_t ipv4_addr, struct tunnel_peer_cache **peer)
+{
+    int err = 0;
+    int i;
+    int mlag_id;
+
+    for (i = 0; i < MLAG_MAX_PEERS; i++) {
+        if (peer_cache[i].valid && (peer_cache[i].ipv4_addr == ipv4_addr)) {
+            *peer = &peer_cache[i];
+            goto bail;
+        }
+    }
+
+    err = mlag_manager_db_mlag_peer_id_get(ntohl(ipv4_addr), &mlag_id);
+    MLAG_BAIL_ERROR(err);
+    MLAG_BAIL_CHECK((mlag_id >= 0) && (mlag_id < MLAG_MAX_PEERS), -EINVAL);
+
+    *peer = &peer_cache[mlag_id];
+    memset(*peer, 0, sizeof(**peer));
+    (*peer)->ipv4_addr = ipv4_addr;
+    (*peer)->mlag_id = mlag_id;
+    (*peer)->valid = 1;
+
+bail:
+    return err;
+}
+
+/*
+ *  This function invalidates the peer lookups cache
+ *
+ * @param[in] mlag_id - peer to invalidate, MLAG_MAX_PEERS for all
+ *
+ * @return void
+ */
+static void
+tunnel_peer_cache_reset(int mlag_id)
+{
+    if ((mlag_id >= 0) && (mlag_id < MLAG_MAX_PEERS)) {
+        peer_cache[mlag_id].valid = 0;
+    }
+    else {
+        memset(peer_cache, 0, sizeof(peer_cache));
+    }
+}
+
+/*
+ *  This function sends a packet received from peer back to the HW
+ *
+ * @param[in] peer - cached lookups of the sending peer
+ * @param[in] packet_wrapper - packet in host order
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+tunnel_pkt_inject(struct tunnel_peer_cache *peer,
+                  struct igmp_packet_wrapper *packet_wrapper)
+{
+    int err = 0;
+    unsigned long ifindex;
+
+    counters.received_from_peer++;
+
+    if (!packet_wrapper->receive_info.is_mlag) {
+        if (!peer->ipl_valid) {
+            /* TODO: Currently, we support only a single IPL with ID 0 */
+            err = mlag_topology_ipl_port_get(0, &peer->ipl_ifindex);
+            MLAG_BAIL_ERROR(err);
+            peer->ipl_valid = 1;
+        }
+        ifindex = peer->ipl_ifindex;
+    }
+    else {
+        ifindex = packet_wrapper->receive_info.source_port_id;
+    }
+
+    MLAG_TRACE(MLAG_TRACE_DEBUG,
+               "sending packet from mlag_id %lld to ifindex %llu",
+               peer->mlag_id, ifindex);
+
+    err = pkt_send_loopback_wrapper(packet_wrapper, ifindex);
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
+/*
+ *  This function injects all packets of a batch received from peer,
+ *  packets are sent to the HW in place out of the received message.
+ *
+ * @param[in] peer - cached lookups of the sending peer
+ * @param[in] msg - batch message, header already in host order
+ * @param[in] msg_len - message length
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+tunnel_batch_inject(struct tunnel_peer_cache *peer, uint8_t *msg,
+                    uint32_t msg_len)
+{
+    int err = 0;
+    int ret;
+    struct igmp_batch_header *batch = (struct igmp_batch_header *)msg;
+    struct igmp_packet_wrapper *packet_wrapper;
+    uint8_t *pos = msg + sizeof(*batch);
+    uint32_t left;
+    uint32_t i;
+
+    MLAG_BAIL_CHECK(msg_len >= sizeof(*batch), -EINVAL);
+    left = msg_len - sizeof(*batch);
+    MLAG_BAIL_CHECK(batch->batch_len <= left, -EINVAL);
+    left = batch->batch_len;
+
+    counters.received_batches++;
+
+    for (i = 0; i < batch->pkt_num; i++) {
+        if (left < IGMP_WRAPPER_HDR_SIZE) {
+            break;
+        }
+        packet_wrapper = (struct igmp_packet_wrapper *)pos;
+        mlag_wire_net_order(tunnel_entry_wire, pos, MESSAGE_RECEIVE);
+        if ((packet_wrapper->pkt_size > MAX_PACKET_SIZE) ||
+            (TUNNEL_BATCH_ENTRY_SIZE(packet_wrapper->pkt_size) > left)) {
+            break;
+        }
+        pos += TUNNEL_BATCH_ENTRY_SIZE(packet_wrapper->pkt_size);
+        left -= TUNNEL_BATCH_ENTRY_SIZE(packet_wrapper->pkt_size);
+
+        /* Keep on with the rest of the batch, report the last failure */
+        ret = tunnel_pkt_inject(peer, packet_wrapper);
+        if (ret) {
+            err = ret;
+        }
+    }
+
+    if (i < batch->pkt_num) {
+        counters.dropped_from_peer += batch->pkt_num - i;
+        err = -EINVAL;
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Malformed IGMP batch from peer %d: packet %u/%u\n",
+                            peer->mlag_id, i, batch->pkt_num);
+    }
+
+bail:
+    return err;
+}
+
 /*
  *  This function is called to handle received message from peer
  *
@@ -250,53 +555,319 @@ rcv_from_peer_msg_handler(struct addr_info *ad_info,
                           struct recv_payload_data *payload_data)
 {
     int err = 0;
-    unsigned int i;
-    unsigned long ifindex;
+    struct tunnel_peer_cache *peer = NULL;
+    struct igmp_packet_wrapper *packet_wrapper;
+    uint8_t *msg;
+    uint32_t msg_len;
 
     MLAG_BAIL_CHECK(ad_info != NULL, -EINVAL);
     MLAG_BAIL_CHECK(payload_data != NULL, -EINVAL);
 
-    MLAG_LOG(MLAG_LOG_DEBUG, "received %d packets from peer\n",
-             payload_data->msg_num_recv);
+    if (payload_data->jumbo_payload_len > 0) {
+        msg = payload_data->jumbo_payload;
+        msg_len = payload_data->jumbo_payload_len;
+    }
+    else {
+        msg = payload_data->payload[0];
+        msg_len = payload_data->payload_len[0];
+    }
+    MLAG_BAIL_CHECK(msg_len >= sizeof(struct igmp_batch_header), -EINVAL);
+
+    err = tunnel_peer_cache_get(ad_info->ipv4_addr, &peer);
+    MLAG_BAIL_ERROR(err);
 
-    for (i = 0; i < payload_data->msg_num_recv; i++) {
-        struct igmp_packet_wrapper *packet_wrapper =
-            (struct igmp_packet_wrapper *)payload_data->payload[i];
-        int mlag_id;
+    MLAG_TRACE(MLAG_TRACE_DEBUG,
+               "received message from peer %lld with len %llu",
+               peer->mlag_id, msg_len);
 
-        err =
-            mlag_manager_db_mlag_peer_id_get(ntohl(ad_info->ipv4_addr),
-                                             &mlag_id);
+    if (((struct igmp_batch_header *)msg)->opcode ==
+        MLAG_TUNNELING_IGMP_BATCH_MESSAGE) {
+        err = tunnel_batch_inject(peer, msg, msg_len);
+        MLAG_BAIL_ERROR(err);
+    }
+    else {
+        /* Single packet, sent by peers that do not batch */
+        packet_wrapper = (struct igmp_packet_wrapper *)msg;
+        if ((msg_len < IGMP_WRAPPER_HDR_SIZE) ||
+            (packet_wrapper->pkt_size > MAX_PACKET_SIZE) ||
+            (msg_len < IGMP_WRAPPER_HDR_SIZE + packet_wrapper->pkt_size)) {
+            counters.dropped_from_peer++;
+            err = -EINVAL;
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Malformed IGMP packet from peer %d, len %u\n",
+                                peer->mlag_id, msg_len);
+        }
+        err = tunnel_pkt_inject(peer, packet_wrapper);
         MLAG_BAIL_ERROR(err);
+    }
 
-        MLAG_LOG(MLAG_LOG_DEBUG, "Packet[%d] from peer %d with len %d\n",
-                 i, mlag_id, payload_data->payload_len[i]);
+bail:
+    return err;
+}
+
+/*
+ *  This function returns monotonic time
+ *
+ * @return current time in msec
+ */
+static uint64_t
+tunnel_now_msec(void)
+{
+    struct timespec ts;
 
-        counters.received_from_peer++;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
 
-        if (!packet_wrapper->receive_info.is_mlag) {
-            /* TODO: Currently, we support only a single IPL with ID 0 */
-            err = mlag_topology_ipl_port_get(0, &ifindex);
-            MLAG_BAIL_ERROR(err);
+/*
+ *  This function maps trap ID, registered per IGMP type, to
+ *  suppression type
+ *
+ * @param[in] l2_trap_id - trap ID of the packet
+ *
+ * @return trap type
+ */
+static enum tunnel_trap_type
+tunnel_trap_type_get(int l2_trap_id)
+{
+    switch (l2_trap_id) {
+    case OES_PACKET_IGMP_TYPE_QUERY:
+        return TUNNEL_TRAP_QUERY;
+    case OES_PACKET_IGMP_TYPE_V1_REPORT:
+        return TUNNEL_TRAP_V1_REPORT;
+    case OES_PACKET_IGMP_TYPE_V2_REPORT:
+        return TUNNEL_TRAP_V2_REPORT;
+    case OES_PACKET_IGMP_TYPE_V2_LEAVE:
+        return TUNNEL_TRAP_V2_LEAVE;
+    default:
+        return TUNNEL_TRAP_OTHER;
+    }
+}
+
+/*
+ *  This function extracts VLAN and group address of a trapped
+ *  IGMP frame
+ *
+ * @param[in] pkt - the frame, starting with the ethernet header
+ * @param[in] pkt_size - frame length
+ * @param[out] group - IGMP group address, host order
+ * @param[out] vlan - VLAN ID of the frame, 0 if untagged
+ *
+ * @return 0 when successful, -EINVAL if frame is not IGMP over IPv4
+ */
+static int
+tunnel_igmp_parse(const uint8_t *pkt, unsigned long pkt_size,
+                  uint32_t *group, uint16_t *vlan)
+{
+    uint16_t ether_type;
+    uint16_t tci;
+    unsigned long offset = ETHER_HDR_LEN;
+    unsigned long ip_hdr_len;
+
+    if (pkt_size < ETHER_HDR_LEN) {
+        return -EINVAL;
+    }
+    memcpy(&ether_type, pkt + ETHER_ADDR_LEN * 2, sizeof(ether_type));
+    *vlan = 0;
+
+    if (ntohs(ether_type) == ETHERTYPE_VLAN) {
+        if (pkt_size < offset + 4) {
+            return -EINVAL;
         }
-        else {
-            ifindex = packet_wrapper->receive_info.source_port_id;
+        memcpy(&tci, pkt + offset, sizeof(tci));
+        memcpy(&ether_type, pkt + offset + sizeof(tci), sizeof(ether_type));
+        *vlan = ntohs(tci) & 0xFFF;
+        offset += 4;
+    }
+
+    /* IPv4 header carrying IGMP, then IGMP group after type,
+     * max response time and checksum */
+    if ((ntohs(ether_type) != ETHERTYPE_IP) || (pkt_size < offset + 20) ||
+        (pkt[offset + 9] != IGMP_PROTO)) {
+        return -EINVAL;
+    }
+    ip_hdr_len = (pkt[offset] & 0x0F) * 4;
+    offset += ip_hdr_len;
+    if ((ip_hdr_len < 20) || (pkt_size < offset + 8)) {
+        return -EINVAL;
+    }
+    memcpy(group, pkt + offset + 4, sizeof(*group));
+    *group = ntohl(*group);
+
+    return 0;
+}
+
+/*
+ *  This function looks a report up in the table of forwarded reports
+ *
+ * @param[in] group - IGMP group address
+ * @param[in] vlan - VLAN ID
+ * @param[in] port_id - ingress port
+ * @param[out] free_entry - entry to record the report in if not found,
+ *                          the oldest of its probe sequence
+ *
+ * @return the report entry, NULL if not found
+ */
+static struct tunnel_report_entry *
+tunnel_report_lookup(uint32_t group, uint16_t vlan, unsigned long port_id,
+                     struct tunnel_report_entry **free_entry)
+{
+    struct tunnel_report_entry *entry;
+    uint32_t hash;
+    int i;
+
+    hash = (group * 2654435761U) ^ ((uint32_t)vlan << 16) ^ (uint32_t)port_id;
+    hash ^= hash >> 15;
+
+    *free_entry = NULL;
+    for (i = 0; i < TUNNEL_REPORT_PROBE_MAX; i++) {
+        entry = &report_table[(hash + i) & (TUNNEL_REPORT_TABLE_SIZE - 1)];
+        if (entry->last_msec && (entry->group == group) &&
+            (entry->vlan == vlan) && (entry->port_id == port_id)) {
+            return entry;
+        }
+        if ((*free_entry == NULL) ||
+            (entry->last_msec < (*free_entry)->last_msec)) {
+            *free_entry = entry;
         }
+    }
 
-        MLAG_LOG(MLAG_LOG_DEBUG,
-                 "sending packet %d/%d: mlag_id %d to ifindex %lu\n",
-                 i, payload_data->msg_num_recv, mlag_id, ifindex);
+    return NULL;
+}
 
-        err = pkt_send_loopback_wrapper(packet_wrapper, ifindex);
-        MLAG_BAIL_ERROR(err);
+/*
+ *  This function takes a token of the trap type bucket
+ *
+ * @param[in] type - trap type
+ * @param[in] now - current time in msec
+ *
+ * @return 1 if bucket is empty, otherwise 0
+ */
+static int
+tunnel_rate_check(enum tunnel_trap_type type, uint64_t now)
+{
+    struct tunnel_token_bucket *bucket = &trap_bucket[type];
+    uint64_t depth = (uint64_t)rate_limit * 1000;
+
+    if (bucket->last_msec == 0) {
+        bucket->tokens = depth;
+    }
+    else {
+        bucket->tokens += (now - bucket->last_msec) * rate_limit;
+        if (bucket->tokens > depth) {
+            bucket->tokens = depth;
+        }
     }
+    bucket->last_msec = now;
 
-bail:
-    return err;
+    if (bucket->tokens < 1000) {
+        return 1;
+    }
+    bucket->tokens -= 1000;
+
+    return 0;
+}
+
+/*
+ *  This function decides if a packet trapped from HW should be
+ *  forwarded to peer, and counts the decision
+ *
+ * @param[in] packet_wrapper - trapped packet
+ *
+ * @return 1 if the packet should be dropped, otherwise 0
+ */
+static int
+tunnel_pkt_suppress(struct igmp_packet_wrapper *packet_wrapper)
+{
+    enum tunnel_trap_type type;
+    struct tunnel_report_entry *entry = NULL;
+    struct tunnel_report_entry *free_entry = NULL;
+    uint64_t now = tunnel_now_msec();
+    uint32_t group = 0;
+    uint16_t vlan = 0;
+    int is_report;
+
+    type = tunnel_trap_type_get(packet_wrapper->receive_info.l2_trap_id);
+
+    /* Queries are rate limited only, frames which cannot be parsed
+     * are passed on to peer as before */
+    is_report = (type != TUNNEL_TRAP_QUERY) && (type != TUNNEL_TRAP_OTHER) &&
+                (tunnel_igmp_parse(packet_wrapper->packet_buffer,
+                                   packet_wrapper->pkt_size,
+                                   &group, &vlan) == 0);
+    if (is_report) {
+        entry = tunnel_report_lookup(
+            group, vlan, packet_wrapper->receive_info.source_port_id,
+            &free_entry);
+        if (entry && (type != TUNNEL_TRAP_V2_LEAVE) &&
+            (now - entry->last_msec < suppress_window_msec)) {
+            trap_counters[type].suppressed_dup++;
+            return 1;
+        }
+    }
+
+    if (tunnel_rate_check(type, now)) {
+        trap_counters[type].suppressed_rate++;
+        return 1;
+    }
+
+    /* Record forwarded report, a leave forgets it so that the next
+     * join is not delayed */
+    if (is_report) {
+        if (type == TUNNEL_TRAP_V2_LEAVE) {
+            if (entry) {
+                entry->last_msec = 0;
+            }
+        }
+        else {
+            if (entry == NULL) {
+                entry = free_entry;
+                entry->group = group;
+                entry->vlan = vlan;
+                entry->port_id = packet_wrapper->receive_info.source_port_id;
+            }
+            entry->last_msec = now;
+        }
+    }
+
+    trap_counters[type].forwarded++;
+    return 0;
+}
+
+/*
+ *  This function clears suppression state, done whenever the tunnel
+ *  goes up or down
+ *
+ * @return void
+ */
+static void
+tunnel_suppress_reset(void)
+{
+    memset(report_table, 0, sizeof(report_table));
+    memset(trap_bucket, 0, sizeof(trap_bucket));
+}
+
+/*
+ *  This function checks if more trapped packets wait on the HW fd
+ *
+ * @return 1 if a packet can be received without blocking, otherwise 0
+ */
+static int
+tunnel_hw_pkt_pending(void)
+{
+    struct pollfd pfd;
+
+    pfd.fd = sl_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    return ((poll(&pfd, 1, 0) > 0) && (pfd.revents & POLLIN));
 }
 
 /*
- *  This function is called to handle received message from hw
+ *  This function is called to handle received message from hw.
+ *  Packets trapped behind the one which woke us up are drained too,
+ *  and all are sent to peer as a single message.
  *
  * @param[in] fd - the file descriptor
  * @param[in] data - the data (not used)
@@ -311,47 +882,116 @@ rcv_from_hw_msg_handler(int fd,
 {
     int err = 0;
     int peer;
+    struct igmp_batch_header *batch = (struct igmp_batch_header *)batch_buf;
+    struct igmp_packet_wrapper *packet_wrapper;
+    uint8_t *first = (uint8_t *)(batch + 1);
+    uint8_t *tail = first;
+    uint8_t *end = (uint8_t *)batch_buf + sizeof(batch_buf);
+    uint8_t *pos;
+    uint8_t *msg;
+    uint32_t msg_len;
+    uint32_t pkt_num = 0;
+    uint32_t rcv_num = 0;
+    enum mlag_events opcode;
 
     UNUSED_PARAM(data);
     UNUSED_PARAM(msg_buf);
     UNUSED_PARAM(buf_size);
     ASSERT(fd == sl_fd);
 
-    curr_packet.pkt_size = MAX_PACKET_SIZE;
-    err = sl_api_pkt_receive(sl_fd,
-                             &curr_packet.receive_info,
-                             curr_packet.packet_buffer,
-                             &curr_packet.pkt_size);
-    MLAG_BAIL_ERROR_MSG(err, "Failed to receive packet from HW. Err=%d\n",
-                        err);
+    do {
+        packet_wrapper = (struct igmp_packet_wrapper *)tail;
+        memset(packet_wrapper, 0, IGMP_WRAPPER_HDR_SIZE);
+        packet_wrapper->pkt_size = MAX_PACKET_SIZE;
+        err = sl_api_pkt_receive(sl_fd,
+                                 &packet_wrapper->receive_info,
+                                 packet_wrapper->packet_buffer,
+                                 &packet_wrapper->pkt_size);
+        if (err && pkt_num) {
+            /* Send what was already drained */
+            MLAG_LOG(MLAG_LOG_ERROR,
+                     "Failed to receive packet %u from HW. Err=%d\n",
+                     pkt_num, err);
+            err = 0;
+            break;
+        }
+        MLAG_BAIL_ERROR_MSG(err, "Failed to receive packet from HW. Err=%d\n",
+                            err);
+        rcv_num++;
+        if (packet_wrapper->pkt_size > MAX_PACKET_SIZE) {
+            MLAG_LOG(MLAG_LOG_ERROR, "Dropped oversized packet from HW, "
+                     "size=%lu\n", packet_wrapper->pkt_size);
+            continue;
+        }
+
+        MLAG_TRACE(MLAG_TRACE_DEBUG, "Received packet from HW, size=%llu",
+                   packet_wrapper->pkt_size);
 
-    MLAG_LOG(MLAG_LOG_DEBUG, "Received packet from HW, size=%lu\n",
-             curr_packet.pkt_size);
+        counters.received_from_hw++;
+
+        /* Suppressed packet slot is reused by the next one */
+        if (tunnel_pkt_suppress(packet_wrapper)) {
+            continue;
+        }
+        tail += TUNNEL_BATCH_ENTRY_SIZE(packet_wrapper->pkt_size);
+        pkt_num++;
+    } while ((rcv_num < TUNNEL_BATCH_MAX_PKTS) &&
+             ((uint32_t)(end - tail) >=
+              IGMP_WRAPPER_HDR_SIZE + MAX_PACKET_SIZE) &&
+             tunnel_hw_pkt_pending());
+
+    if (pkt_num == 0) {
+        goto bail;
+    }
+    if (pkt_num > counters.max_batch) {
+        counters.max_batch = pkt_num;
+    }
 
-    counters.received_from_hw++;
+    if (pkt_num == 1) {
+        /* A lone packet goes in the single packet format, which the
+         * wrapper converts to network order */
+        opcode = MLAG_TUNNELING_IGMP_MESSAGE;
+        msg = first;
+        msg_len = IGMP_WRAPPER_HDR_SIZE +
+                  ((struct igmp_packet_wrapper *)first)->pkt_size;
+    }
+    else {
+        opcode = MLAG_TUNNELING_IGMP_BATCH_MESSAGE;
+        memset(batch, 0, sizeof(*batch));
+        batch->opcode = opcode;
+        batch->pkt_num = pkt_num;
+        batch->batch_len = tail - first;
+        msg = (uint8_t *)batch;
+        msg_len = tail - (uint8_t *)batch;
+
+        /* Entries go in network order as is, only the header is swapped
+         * by the wrapper */
+        pos = first;
+        while (pos < tail) {
+            packet_wrapper = (struct igmp_packet_wrapper *)pos;
+            mlag_wire_net_order(tunnel_entry_wire, pos, MESSAGE_SENDING);
+            pos += TUNNEL_BATCH_ENTRY_SIZE(packet_wrapper->pkt_size);
+        }
+    }
 
     /* Send to all peers (there is only one active peer) */
     for (peer = 0; peer < MLAG_MAX_PEERS; peer++) {
         if (comm_layer_wrapper.tcp_sock_handle[peer]) {
-            uint32_t packet_size =
-                sizeof(curr_packet) - MAX_PACKET_SIZE + curr_packet.pkt_size;
-
-            MLAG_LOG(MLAG_LOG_DEBUG, "sending packet (size=%d) from HW to peer %d:"
-                     " sending peer ID %d,  is_mlag %u, trap %d, source port %lu\n",
-                     packet_size, peer, curr_packet.sending_peer_id,
-                     curr_packet.receive_info.is_mlag,
-                     curr_packet.receive_info.l2_trap_id,
-                     curr_packet.receive_info.source_port_id);
+            MLAG_TRACE(MLAG_TRACE_DEBUG, "sending %llu packets (size=%llu) "
+                       "from HW to peer %llu", pkt_num, msg_len, peer);
             err = mlag_comm_layer_wrapper_message_send(&comm_layer_wrapper,
-                                                       MLAG_TUNNELING_IGMP_MESSAGE,
-                                                       (uint8_t *)&curr_packet,
-                                                       packet_size,
+                                                       opcode,
+                                                       msg,
+                                                       msg_len,
                                                        peer,
                                                        MASTER_LOGIC);
             MLAG_BAIL_ERROR_MSG(err,
                                 "Failed to send message to peer %d, err= %d\n",
                                 peer, err);
-            counters.sent_to_peer++;
+            counters.sent_to_peer += pkt_num;
+            if (opcode == MLAG_TUNNELING_IGMP_BATCH_MESSAGE) {
+                counters.sent_batches++;
+            }
         }
     }
 
@@ -430,6 +1070,9 @@ tunnel_activate(void)
 
     counters.received_from_peer = 0;
     counters.sent_to_peer = 0;
+    counters.sent_batches = 0;
+    counters.received_batches = 0;
+    counters.dropped_from_peer = 0;
 
     if (!peer_connected) {
         peer_connected = 1;
@@ -437,6 +1080,8 @@ tunnel_activate(void)
         err = sl_api_trap_fd_open(&sl_fd);
         MLAG_BAIL_ERROR_MSG(err, "failed to open socket, err=%d\n", err);
 
+        tunnel_suppress_reset();
+
         err = tunnel_trap_igmp(OES_ACCESS_CMD_ENABLE);
         MLAG_BAIL_ERROR_MSG(err, "failed to register IGMP trap, err=%d\n",
                             err);
@@ -466,6 +1111,9 @@ tunnel_deactivate(void)
 {
     int err = 0;
 
+    tunnel_peer_cache_reset(MLAG_MAX_PEERS);
+    tunnel_suppress_reset();
+
     if (peer_connected) {
         peer_connected = 0;
 
@@ -517,6 +1165,9 @@ tunnel_dispatch_conn_notify_event(uint8_t *data)
                      "Received connection notification from peer %d, rc = %d\n",
                      mlag_id, ev->rc);
 
+            /* New connection, look the peer up again on first packet */
+            tunnel_peer_cache_reset(mlag_id);
+
             if (comm_layer_wrapper.current_switch_status == SLAVE) {
                 MLAG_LOG(MLAG_LOG_NOTICE, "Tunneling slave connected\n");
             }
@@ -565,39 +1216,34 @@ add_fd_handler(handle_t new_handle, int state)
 }
 
 /*
- * This function is called by the communication wrapper to swap the data
+ *  This function sends an IGMP v2 query on a port
  *
- * @param[in/out] payload - the data that should be swap
- * @param[in] oper - send or receive - determine if we should do hton or ntoh
+ * @param[in] port_id - port to send the query on
  *
  * @return 0 if operation completes successfully.
  */
 static int
-tunneling_net_order_msg(uint8_t *payload,
-                        enum message_operation oper)
+tunnel_igmp_query_send(unsigned long port_id)
 {
     int err = 0;
-    struct igmp_packet_wrapper *igmp = (struct igmp_packet_wrapper *)payload;
-
-    ASSERT(igmp != NULL);
-
-    /* Only one type of payload is supported: IGMP */
-    if (oper == MESSAGE_SENDING) {
-        igmp->opcode = htonl(igmp->opcode);
-        igmp->sending_peer_id = htonl(igmp->sending_peer_id);
-        igmp->receive_info.l2_trap_id = htonl(igmp->receive_info.l2_trap_id);
-        igmp->receive_info.source_port_id =
-            htonl(igmp->receive_info.source_port_id);
-        igmp->receive_info.is_mlag = htonl(igmp->receive_info.is_mlag);
-    }
-    else {
-        igmp->opcode = ntohl(igmp->opcode);
-        igmp->sending_peer_id = ntohl(igmp->sending_peer_id);
-        igmp->receive_info.l2_trap_id = ntohl(igmp->receive_info.l2_trap_id);
-        igmp->receive_info.source_port_id =
-            ntohl(igmp->receive_info.source_port_id);
-        igmp->receive_info.is_mlag = ntohl(igmp->receive_info.is_mlag);
-    }
+
+    igmp_query_pkt_data.l2_pkt_type = OES_PACKET_IGMP_TYPE_QUERY;
+    igmp_query_pkt_data.ctrl_pkt.igmp_ctrl_pkt_data.system_mac_id =
+        mlag_manager_db_local_system_id_get();
+
+    err = sl_api_ctrl_pkt_send(
+        sl_fd,
+        &igmp_query_pkt_data,
+        sizeof(igmp_query_pkt_data.ctrl_pkt.igmp_ctrl_pkt_data
+               .query_packet),
+        port_id);
+    MLAG_BAIL_ERROR(err);
+
+    MLAG_LOG(MLAG_LOG_DEBUG,
+             "Successfully sent IGMPv2 query on port %lu\n", port_id);
+
+    counters.sent_queries++;
+
 bail:
     return err;
 }
@@ -628,23 +1274,42 @@ tunnel_dispatch_port_state_change(uint8_t *buffer)
                                             == MLAG_PORT_OPER_UP)
         && peer_connected) {
         /* Send an IGMP v2 Query */
-        igmp_query_pkt_data.l2_pkt_type = OES_PACKET_IGMP_TYPE_QUERY;
-        igmp_query_pkt_data.ctrl_pkt.igmp_ctrl_pkt_data.system_mac_id =
-            mlag_manager_db_local_system_id_get();
-
-        err = sl_api_ctrl_pkt_send(
-            sl_fd,
-            &igmp_query_pkt_data,
-            sizeof(igmp_query_pkt_data.ctrl_pkt.igmp_ctrl_pkt_data
-                   .query_packet),
-            state_change->port_id);
+        err = tunnel_igmp_query_send(state_change->port_id);
         MLAG_BAIL_ERROR(err);
+    }
+
+bail:
+    return err;
+}
 
-        MLAG_LOG(MLAG_LOG_DEBUG,
-                 "Successfully sent IGMPv2 query on port %lu\n",
-                 state_change->port_id);
+/*
+ *  This function dispatches batched port state change event. An IGMP query
+ *  is sent on each port that came up.
+ *
+ * @param[in] buffer - event data
+ *
+ * @return 0 if operation completes successfully.
+ * @return -EINVAL if a received parameter is null
+ */
+static int
+tunnel_dispatch_ports_state_change(uint8_t *buffer)
+{
+    int err = 0;
+    int i;
+    struct ports_oper_state_change_data *state_change =
+        (struct ports_oper_state_change_data *)buffer;
+    MLAG_BAIL_CHECK(state_change != NULL, -EINVAL);
+
+    if ((!igmp_enabled) || (!peer_connected)) {
+        goto bail;
+    }
 
-        counters.sent_queries++;
+    /* Batched events never carry the IPL */
+    for (i = 0; i < state_change->port_num; i++) {
+        if (state_change->ports[i].state == MLAG_PORT_OPER_UP) {
+            err = tunnel_igmp_query_send(state_change->ports[i].port_id);
+            MLAG_BAIL_ERROR(err);
+        }
     }
 
 bail:
@@ -839,6 +1504,62 @@ void
 mlag_tunneling_clear_counters(void)
 {
     SAFE_MEMSET(&counters, 0);
+    memset(trap_counters, 0, sizeof(trap_counters));
+}
+
+/**
+ * Populates the tunneled IGMP suppression parameters
+ *
+ * @param[out] params - Suppression window and rate limit in use
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ */
+int
+mlag_tunneling_igmp_params_get(struct mlag_igmp_params *params)
+{
+    int err = 0;
+
+    MLAG_BAIL_CHECK(params, -EINVAL);
+
+    params->suppress_window_msec = suppress_window_msec;
+    params->rate_limit = rate_limit;
+
+bail:
+    return err;
+}
+
+/*
+ *  This function sets the tunneled IGMP suppression parameters. It runs in
+ *  the tunneling thread, so the suppression state needs no locking.
+ *
+ * @param[in] buffer - Event data, a member set to 0 selects its default
+ *
+ * @return -EINVAL - If any input parameter is invalid.
+ */
+static int
+tunnel_dispatch_igmp_params_set(uint8_t *buffer)
+{
+    int err = 0;
+    struct igmp_params_set_data *data = (struct igmp_params_set_data *)buffer;
+
+    MLAG_BAIL_CHECK(data, -EINVAL);
+
+    suppress_window_msec = data->params.suppress_window_msec;
+    if (suppress_window_msec == 0) {
+        suppress_window_msec = MLAG_IGMP_SUPPRESS_WINDOW_MSEC_DEFAULT;
+    }
+    rate_limit = data->params.rate_limit;
+    if (rate_limit == 0) {
+        rate_limit = MLAG_IGMP_RATE_LIMIT_DEFAULT;
+    }
+
+    MLAG_LOG(MLAG_LOG_NOTICE,
+             "IGMP suppress window [%u] msec, rate limit [%u] pps\n",
+             suppress_window_msec, rate_limit);
+
+bail:
+    return err;
 }
 
 /*
@@ -985,28 +1706,44 @@ mlag_tunneling_init(void)
     strncpy(tunnel_dispatcher_conf.name, "Tunneling",
             DISPATCHER_NAME_MAX_CHARS);
 
+    /* Batched port events carry up to the maximum number of ports */
+    tunnel_disp_sys_event_buf_size = TUNNEL_DISP_SYS_EVENT_BUF_SIZE +
+                                     MLAG_EVENT_STAMP_SIZE +
+                                     PORTS_OPER_STATE_CHANGE_EVENT_SIZE(
+        mlag_max_ports_get());
+    tunnel_disp_sys_event_buf =
+        (char *)cl_malloc(tunnel_disp_sys_event_buf_size);
+    if (tunnel_disp_sys_event_buf == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate tunneling event buffer\n");
+    }
+
     err = init_command_db(&tunnel_cmd_db);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
     err = insert_to_command_db(tunnel_cmd_db, tunnel_dispatcher_commands);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
+    err = mlag_wire_msgs_register(tunnel_wire_msgs,
+                                  NUM_ELEMS(tunnel_wire_msgs));
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
     /* deinit event */
     DISPATCHER_CONF_SET(tunnel_dispatcher_conf, TERMINATE_HANDLE,
                         tunnel_event_fds.high_fd,
                         HIGH_PRIORITY, dispatcher_sys_event_handler,
                         tunnel_cmd_db, tunnel_disp_sys_event_buf,
-                        sizeof(tunnel_disp_sys_event_buf));
+                        tunnel_disp_sys_event_buf_size);
     DISPATCHER_CONF_SET(tunnel_dispatcher_conf, EVENTS_HANDLE,
                         tunnel_event_fds.med_fd,
                         MEDIUM_PRIORITY, dispatcher_sys_event_handler,
                         tunnel_cmd_db, tunnel_disp_sys_event_buf,
-                        sizeof(tunnel_disp_sys_event_buf));
+                        tunnel_disp_sys_event_buf_size);
 
     err = mlag_comm_layer_wrapper_init(&comm_layer_wrapper,
                                        TUNNELING_PORT,
                                        rcv_from_peer_msg_handler,
-                                       tunneling_net_order_msg,
+                                       NULL,
                                        add_fd_handler,
                                        NO_SOCKET_PROTECTION);
     MLAG_BAIL_CHECK_NO_MSG(err);
@@ -1048,6 +1785,10 @@ mlag_tunneling_deinit(void)
     MLAG_BAIL_CHECK_NO_MSG(err);
 
 bail:
+    if (tunnel_disp_sys_event_buf != NULL) {
+        cl_free(tunnel_disp_sys_event_buf);
+        tunnel_disp_sys_event_buf = NULL;
+    }
     return err;
 }
 
@@ -1063,6 +1804,7 @@ int
 mlag_tunneling_dump(void (*dump_cb)(const char *, ...))
 {
     int err = 0;
+    int i;
 
     DUMP_OR_LOG(
         "===================\nMlag Tunneling Dump\n===================\n");
@@ -1072,6 +1814,21 @@ mlag_tunneling_dump(void (*dump_cb)(const char *, ...))
     DUMP_OR_LOG("Sent queries:     %llu\n", counters.sent_queries);
     DUMP_OR_LOG("Received:         %llu\n", counters.received_from_peer);
     DUMP_OR_LOG("Sent:             %llu\n", counters.sent_to_peer);
+    DUMP_OR_LOG("Sent batches:     %llu\n", counters.sent_batches);
+    DUMP_OR_LOG("Received batches: %llu\n", counters.received_batches);
+    DUMP_OR_LOG("Largest batch:    %llu\n", counters.max_batch);
+    DUMP_OR_LOG("Dropped from peer: %llu\n", counters.dropped_from_peer);
+
+    DUMP_OR_LOG("\nSuppression window %u msec, rate limit %u pps\n",
+                suppress_window_msec, rate_limit);
+    DUMP_OR_LOG("%-10s %-12s %-12s %-12s\n", "Type", "Forwarded",
+                "Duplicate", "Rate limited");
+    for (i = 0; i < TUNNEL_TRAP_TYPE_NUM; i++) {
+        DUMP_OR_LOG("%-10s %-12llu %-12llu %-12llu\n",
+                    TUNNEL_TRAP_TYPE_STR(i), trap_counters[i].forwarded,
+                    trap_counters[i].suppressed_dup,
+                    trap_counters[i].suppressed_rate);
+    }
 
     DUMP_OR_LOG("\n");
     return err;
@@ -89,6 +89,17 @@ mlag_tunneling_counters_get(struct mlag_counters *counters);
 void
 mlag_tunneling_clear_counters(void);
 
+/**
+ * Populates the tunneled IGMP suppression parameters
+ *
+ * @param[out] params - Suppression window and rate limit in use
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ */
+int
+mlag_tunneling_igmp_params_get(struct mlag_igmp_params *params);
+
 /**
  *  This function inits all tunneling sub-module
  *
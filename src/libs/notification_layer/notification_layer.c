@@ -27,10 +27,37 @@
 
 #define NOTIFICATION_LAYER_C_
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <utils/mlag_bail.h>
 #include <utils/mlag_defs.h>
 #include <utils/mlag_events.h>
 #include "notification_layer.h"
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+/* Subscriber of notifications */
+struct notify_subscriber {
+    int in_use;
+    unsigned int id;
+    int pid;
+    uint32_t interest_mask;
+    int event_fd;
+    char ring_name[MLAG_NOTIFY_NAME_LEN];
+    struct mlag_notify_ring *ring;
+};
+
 /************************************************
  *  Global variables
  ***********************************************/
@@ -44,7 +71,18 @@ static const char *mlag_notification_str[MLAG_NOTIFY_LAST] = {
     "Aggregator Response",
     "Aggregator Release",
     "System Id change",
+    "Port oper state change",
+    "Peer state change",
+    "Role change",
+    "MAC sync milestone",
 };
+
+static struct notify_subscriber subscribers[MLAG_NOTIFY_SUBSCRIBERS_MAX];
+/* interests of all subscribers, read without lock to skip the rest */
+static volatile uint32_t subscribers_mask = 0;
+static unsigned int subscriber_gen = 0;
+/* serializes the writers of the rings and the subscribers table */
+static pthread_mutex_t subscribers_mutex = PTHREAD_MUTEX_INITIALIZER;
 /************************************************
  *  Local function declarations
  ***********************************************/
@@ -53,6 +91,204 @@ static const char *mlag_notification_str[MLAG_NOTIFY_LAST] = {
  *  Function implementations
  ***********************************************/
 
+/*
+ * Updates the interests of all subscribers, called with the
+ * subscribers locked
+ *
+ * @return void
+ */
+static void
+subscribers_mask_update(void)
+{
+    int i;
+    uint32_t mask = 0;
+
+    for (i = 0; i < MLAG_NOTIFY_SUBSCRIBERS_MAX; i++) {
+        if (subscribers[i].in_use) {
+            mask |= subscribers[i].interest_mask;
+        }
+    }
+    subscribers_mask = mask;
+}
+
+/*
+ * Releases a subscriber and its ring, called with the subscribers
+ * locked
+ *
+ * @param[in] sub - subscriber
+ *
+ * @return void
+ */
+static void
+subscriber_release(struct notify_subscriber *sub)
+{
+    if (sub->ring != NULL) {
+        munmap(sub->ring, sizeof(struct mlag_notify_ring));
+    }
+    if (sub->ring_name[0] != '\0') {
+        shm_unlink(sub->ring_name);
+    }
+    if (sub->event_fd >= 0) {
+        close(sub->event_fd);
+    }
+    SAFE_MEMSET(sub, 0);
+    sub->event_fd = -1;
+    subscribers_mask_update();
+}
+
+/*
+ * Creates the ring of a subscriber in shared memory
+ *
+ * @param[in] sub - subscriber
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+subscriber_ring_create(struct notify_subscriber *sub)
+{
+    int err = 0;
+    int fd = -1;
+    void *ring = MAP_FAILED;
+
+    snprintf(sub->ring_name, sizeof(sub->ring_name),
+             "/mlag_notify_%d_%u", (int)getpid(), sub->id & 0xff);
+
+    fd = shm_open(sub->ring_name, O_RDWR | O_CREAT | O_TRUNC,
+                  S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to create notification ring %s\n",
+                            sub->ring_name);
+    }
+    if (ftruncate(fd, sizeof(struct mlag_notify_ring)) < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to size notification ring %s\n",
+                            sub->ring_name);
+    }
+    ring = mmap(NULL, sizeof(struct mlag_notify_ring),
+                PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ring == MAP_FAILED) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to map notification ring %s\n",
+                            sub->ring_name);
+    }
+    sub->ring = (struct mlag_notify_ring *)ring;
+    sub->ring->magic = MLAG_NOTIFY_RING_MAGIC;
+    sub->ring->version = MLAG_NOTIFY_RING_VERSION;
+    sub->ring->size = MLAG_NOTIFY_RING_SIZE;
+    sub->ring->interest_mask = sub->interest_mask;
+
+bail:
+    if (fd >= 0) {
+        close(fd);
+    }
+    return err;
+}
+
+/*
+ * Passes the eventfd of a subscriber to the subscriber process, on
+ * the abstract unix socket it listens on
+ *
+ * @param[in] sub - subscriber
+ * @param[in] sock_name - socket name
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+subscriber_event_fd_send(struct notify_subscriber *sub, const char *sock_name)
+{
+    int err = 0;
+    int sock = -1;
+    char byte = 0;
+    struct sockaddr_un addr;
+    struct iovec iov;
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    char control[CMSG_SPACE(sizeof(int))];
+
+    sub->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sub->event_fd < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to create notification eventfd\n");
+    }
+
+    sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to open subscriber socket\n");
+    }
+    SAFE_MEMSET(&addr, 0);
+    addr.sun_family = AF_UNIX;
+    /* abstract name, sun_path starts with NUL */
+    strncpy(addr.sun_path + 1, sock_name, MLAG_NOTIFY_NAME_LEN - 1);
+    if (connect(sock, (struct sockaddr *)&addr,
+                offsetof(struct sockaddr_un, sun_path) + 1 +
+                strnlen(sock_name, MLAG_NOTIFY_NAME_LEN - 1)) < 0) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to connect subscriber socket\n");
+    }
+
+    iov.iov_base = &byte;
+    iov.iov_len = sizeof(byte);
+    SAFE_MEMSET(&msg, 0);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &sub->event_fd, sizeof(int));
+    if (sendmsg(sock, &msg, MSG_NOSIGNAL) != sizeof(byte)) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to pass subscriber eventfd\n");
+    }
+
+bail:
+    if (sock >= 0) {
+        close(sock);
+    }
+    return err;
+}
+
+/*
+ * Pushes a notification to the ring of a subscriber, called with the
+ * subscribers locked. The subscriber is signaled only if it may have
+ * seen the ring empty. The head is published before the tail is read,
+ * and the reader stores the tail before it reads the head again, so
+ * either this push sees the stored tail and signals, or the reader
+ * sees the new head and keeps draining.
+ *
+ * @param[in] sub - subscriber
+ * @param[in] notification - notification
+ *
+ * @return void
+ */
+static void
+subscriber_push(struct notify_subscriber *sub,
+                struct mlag_notification *notification)
+{
+    struct mlag_notify_ring *ring = sub->ring;
+    uint64_t head = ring->head;
+    uint64_t one = 1;
+
+    if ((head - ring->tail) >= MLAG_NOTIFY_RING_SIZE) {
+        ring->dropped++;
+        return;
+    }
+    ring->entries[head & (MLAG_NOTIFY_RING_SIZE - 1)] = *notification;
+    __sync_synchronize();
+    ring->head = head + 1;
+    __sync_synchronize();
+    if (ring->tail == head) {
+        if (write(sub->event_fd, &one, sizeof(one)) < 0) {
+            MLAG_LOG(MLAG_LOG_DEBUG, "Subscriber [%u] signal failed\n",
+                     sub->id);
+        }
+    }
+}
+
 /**
  * Used for dispatching mlag protocol notification
  *
@@ -64,6 +300,8 @@ int
 mlag_notify(struct mlag_notification *notification)
 {
     int err = 0;
+    int i;
+    uint32_t type_mask;
 
     MLAG_LOG(MLAG_LOG_DEBUG, "mlag_notify [%s]\n",
              mlag_notification_str[notification->notification_type]);
@@ -82,5 +320,141 @@ mlag_notify(struct mlag_notification *notification)
                  notification->notification_info.agg_release.port_id);
     }
 
+    type_mask = MLAG_NOTIFY_MASK(notification->notification_type);
+    if (!(subscribers_mask & type_mask)) {
+        goto bail;
+    }
+
+    pthread_mutex_lock(&subscribers_mutex);
+    for (i = 0; i < MLAG_NOTIFY_SUBSCRIBERS_MAX; i++) {
+        if (subscribers[i].in_use &&
+            (subscribers[i].interest_mask & type_mask)) {
+            subscriber_push(&subscribers[i], notification);
+        }
+    }
+    pthread_mutex_unlock(&subscribers_mutex);
+
+bail:
+    return err;
+}
+
+/**
+ * Adds a subscriber. Its ring is created in shared memory, and the
+ * eventfd signaled when the ring gets notifications is passed to the
+ * subscriber on the unix socket it listens on.
+ *
+ * @param[in] interest_mask - notification types, MLAG_NOTIFY_MASK bits
+ * @param[in] pid - subscriber process id, dead subscribers are removed
+ * @param[in] sock_name - abstract unix socket name the subscriber listens on
+ * @param[out] subscriber_id - subscriber id
+ * @param[out] ring_name - ring shared memory name, MLAG_NOTIFY_NAME_LEN bytes
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOSPC if all subscribers are in use
+ */
+int
+mlag_notify_subscribe(uint32_t interest_mask, int pid, const char *sock_name,
+                      unsigned int *subscriber_id, char *ring_name)
+{
+    int err = 0;
+    int i;
+    struct notify_subscriber *sub = NULL;
+
+    MLAG_BAIL_CHECK(sock_name != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(subscriber_id != NULL, -EINVAL);
+    MLAG_BAIL_CHECK(ring_name != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((interest_mask & ~MLAG_NOTIFY_MASK_ALL) == 0, -EINVAL);
+
+    pthread_mutex_lock(&subscribers_mutex);
+    for (i = 0; i < MLAG_NOTIFY_SUBSCRIBERS_MAX; i++) {
+        if (subscribers[i].in_use && (kill(subscribers[i].pid, 0) < 0) &&
+            (errno == ESRCH)) {
+            MLAG_LOG(MLAG_LOG_NOTICE,
+                     "Subscriber [%u] process is gone, removed\n",
+                     subscribers[i].id);
+            subscriber_release(&subscribers[i]);
+        }
+        if ((sub == NULL) && !subscribers[i].in_use) {
+            sub = &subscribers[i];
+        }
+    }
+    if (sub == NULL) {
+        pthread_mutex_unlock(&subscribers_mutex);
+        err = -ENOSPC;
+        MLAG_BAIL_ERROR_MSG(err, "No free notification subscriber\n");
+    }
+
+    subscriber_gen = (subscriber_gen + 1) & 0xffffff;
+    sub->id = (subscriber_gen << 8) | (sub - subscribers);
+    sub->pid = pid;
+    sub->interest_mask = interest_mask;
+    sub->event_fd = -1;
+    err = subscriber_ring_create(sub);
+    if (!err) {
+        err = subscriber_event_fd_send(sub, sock_name);
+    }
+    if (err) {
+        subscriber_release(sub);
+    }
+    else {
+        sub->in_use = TRUE;
+        subscribers_mask_update();
+        *subscriber_id = sub->id;
+        strncpy(ring_name, sub->ring_name, MLAG_NOTIFY_NAME_LEN);
+        MLAG_LOG(MLAG_LOG_NOTICE,
+                 "Subscriber [%u] added, pid [%d] mask [0x%x]\n",
+                 sub->id, pid, interest_mask);
+    }
+    pthread_mutex_unlock(&subscribers_mutex);
+
+bail:
+    return err;
+}
+
+/**
+ * Removes a subscriber and its ring.
+ *
+ * @param[in] subscriber_id - subscriber id
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOENT if the subscriber does not exist
+ */
+int
+mlag_notify_unsubscribe(unsigned int subscriber_id)
+{
+    int err = 0;
+    unsigned int idx = subscriber_id & 0xff;
+
+    pthread_mutex_lock(&subscribers_mutex);
+    if ((idx >= MLAG_NOTIFY_SUBSCRIBERS_MAX) || !subscribers[idx].in_use ||
+        (subscribers[idx].id != subscriber_id)) {
+        err = -ENOENT;
+    }
+    else {
+        subscriber_release(&subscribers[idx]);
+        MLAG_LOG(MLAG_LOG_NOTICE, "Subscriber [%u] removed\n",
+                 subscriber_id);
+    }
+    pthread_mutex_unlock(&subscribers_mutex);
+
     return err;
 }
+
+/**
+ * Removes all subscribers.
+ *
+ * @return void
+ */
+void
+mlag_notify_deinit(void)
+{
+    int i;
+
+    pthread_mutex_lock(&subscribers_mutex);
+    for (i = 0; i < MLAG_NOTIFY_SUBSCRIBERS_MAX; i++) {
+        if (subscribers[i].in_use) {
+            subscriber_release(&subscribers[i]);
+        }
+    }
+    pthread_mutex_unlock(&subscribers_mutex);
+}
@@ -29,6 +29,8 @@
 #ifndef NOTIFICATION_LAYER_H_
 #define NOTIFICATION_LAYER_H_
 
+#include <stdint.h>
+#include <mlag_api_defs.h>
 
 #ifdef NOTIFICATION_LAYER_C_
 /************************************************
@@ -47,12 +49,21 @@
  *  Local Type definitions
  ***********************************************/
 
-
 #endif
 /************************************************
  *  Defines
  ***********************************************/
 
+/* Subscribers served at the same time */
+#define MLAG_NOTIFY_SUBSCRIBERS_MAX 8
+
+#define MLAG_NOTIFY_RING_MAGIC      0x4d4c4e52
+#define MLAG_NOTIFY_RING_VERSION    1
+/* Notifications a subscriber ring holds, a power of 2 */
+#define MLAG_NOTIFY_RING_SIZE       1024
+/* Length of ring and socket names, including NUL */
+#define MLAG_NOTIFY_NAME_LEN        32
+
 /************************************************
  *  Macros
  ***********************************************/
@@ -62,65 +73,20 @@
  ***********************************************/
 
 /**
- * mlag_notification_type enum is used to define
- * possible notifications coming from MLAG protocol
- */
-enum mlag_notification_type {
-    MLAG_NOTIFY_AGGREGATOR_RESPONSE,
-    MLAG_NOTIFY_AGGREGATOR_RELEASE,
-    MLAG_NOTIFY_LACP_SYSTEM_ID_CHANGE,
-    MLAG_NOTIFY_LAST
-};
-
-/**
- * mlag_lacp_aggregator_response struct contains
- * response information for LACP aggregator requests
- * issued
- */
-struct mlag_lacp_aggregator_response {
-    unsigned int request_id;
-    unsigned int response;
-    unsigned long req_port_id;
-    unsigned long long req_partner_id;
-    unsigned int req_partner_key;
-};
-
-/**
- * mlag_lacp_aggregator_release struct is
- * used for notifying aggregator information
- * for a certain port is no longer valid
+ * mlag_notify_ring struct is the shared memory ring of a subscriber.
+ * MLAG is the only writer of head and the entries, the subscriber is
+ * the only writer of tail, so neither side takes a lock. When the ring
+ * is full, notifications are dropped and counted.
  */
-struct mlag_lacp_aggregator_release {
-    unsigned long port_id;
-};
-
-/**
- * mlag_lacp_aggregator_release struct is
- * used for notifying aggregator information
- * for a certain port is no longer valid
- */
-struct mlag_lacp_sys_id_change {
-    unsigned char active;
-    unsigned long long system_id;
-};
-
-/**
- * mlag_notification_info union contains
- * different types of notification data fields
- */
-union mlag_notification_info {
-    struct mlag_lacp_aggregator_response agg_response;
-    struct mlag_lacp_aggregator_release agg_release;
-    struct mlag_lacp_sys_id_change sys_id_change;
-};
-
-/**
- * mlag_notification struct contains
- * MLAG notifications attributes
- */
-struct mlag_notification {
-    enum mlag_notification_type notification_type;
-    union mlag_notification_info notification_info;
+struct mlag_notify_ring {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t interest_mask;
+    volatile uint64_t head;
+    volatile uint64_t tail;
+    volatile uint64_t dropped;
+    struct mlag_notification entries[MLAG_NOTIFY_RING_SIZE];
 };
 
 /************************************************
@@ -141,6 +107,43 @@ struct mlag_notification {
 int
 mlag_notify(struct mlag_notification *mlag_notification);
 
+/**
+ * Adds a subscriber. Its ring is created in shared memory, and the
+ * eventfd signaled when the ring gets notifications is passed to the
+ * subscriber on the unix socket it listens on.
+ *
+ * @param[in] interest_mask - notification types, MLAG_NOTIFY_MASK bits
+ * @param[in] pid - subscriber process id, dead subscribers are removed
+ * @param[in] sock_name - abstract unix socket name the subscriber listens on
+ * @param[out] subscriber_id - subscriber id
+ * @param[out] ring_name - ring shared memory name, MLAG_NOTIFY_NAME_LEN bytes
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOSPC if all subscribers are in use
+ */
+int
+mlag_notify_subscribe(uint32_t interest_mask, int pid, const char *sock_name,
+                      unsigned int *subscriber_id, char *ring_name);
+
+/**
+ * Removes a subscriber and its ring.
+ *
+ * @param[in] subscriber_id - subscriber id
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOENT if the subscriber does not exist
+ */
+int
+mlag_notify_unsubscribe(unsigned int subscriber_id);
+
+/**
+ * Removes all subscribers.
+ *
+ * @return void
+ */
+void
+mlag_notify_deinit(void);
+
 
 
 #endif /* NOTIFICATION_LAYER_H_ */
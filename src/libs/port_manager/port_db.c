@@ -33,7 +33,9 @@
 #include <errno.h>
 #include <complib/cl_init.h>
 #include <complib/cl_mem.h>
+#include "mlag_common.h"
 #include "port_db.h"
+#include <libs/mlag_common/mlag_lock_prof.h>
 
 /************************************************
  *  Global variables
@@ -91,6 +93,7 @@ port_entry_init(void *const p_object,
         goto bail;
     }
 
+    port_entry->modified = FALSE;
     *pp_pool_item = &(port_entry->pool_item);
 
 bail:
@@ -116,6 +119,41 @@ port_entry_deinit(const cl_pool_item_t * const p_pool_item,
     cl_plock_destroy(&port_entry->port_lock);
 }
 
+/*
+ *  This function notifies a change of a port entry, called with
+ *  the entry locked exclusive
+ *
+ * @param[in] port_entry - port entry
+ *
+ * @return void
+ */
+static void
+port_entry_changed(struct mlag_port_entry *port_entry)
+{
+    port_entry->modified = FALSE;
+    if (mlag_port_db.change_cb != NULL) {
+        mlag_port_db.change_cb(&(port_entry->port_info), NULL);
+    }
+}
+
+/**
+ *  This function sets the functions notified on port entry changes.
+ *  change_cb is called, under the port lock, whenever an entry that
+ *  was locked exclusive is released, remove_cb when an entry is
+ *  deleted.
+ *
+ * @param[in] change_cb - called on entry change, may be NULL
+ * @param[in] remove_cb - called on entry delete, may be NULL
+ *
+ * @return void
+ */
+void
+port_db_change_notify_set(port_db_pfn_t change_cb, port_db_pfn_t remove_cb)
+{
+    mlag_port_db.change_cb = change_cb;
+    mlag_port_db.remove_cb = remove_cb;
+}
+
 /**
  *  This function applies a function on each port item
  *
@@ -137,6 +175,41 @@ port_db_foreach(port_db_pfn_t apply_port_func, void *data)
         port_entry = PARENT_STRUCT(map_item, struct mlag_port_entry, map_item);
         cl_plock_excl_acquire(&port_entry->port_lock);
         err = apply_port_func(&(port_entry->port_info), data);
+        port_entry_changed(port_entry);
+        cl_plock_release(&port_entry->port_lock);
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Failed to apply func on port db element err [%d]\n",
+                            err);
+        map_item = cl_qmap_next(map_item);
+    }
+
+bail:
+    return err;
+}
+
+/**
+ *  This function applies a read only function on each port item.
+ *  Port entries are held with a shared lock, so the applied
+ *  function must not modify the port data
+ *
+ * @param[in] apply_port_func - function pointer
+ * @param[in] data -  data for the applied function
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+port_db_foreach_read(port_db_pfn_t apply_port_func, void *data)
+{
+    int err = 0;
+    cl_map_item_t *map_item;
+    struct mlag_port_entry *port_entry;
+    const cl_map_item_t *map_end = NULL;
+    map_item = cl_qmap_head(&(mlag_port_db.port_map));
+    map_end = cl_qmap_end(&(mlag_port_db.port_map));
+    while (map_item != map_end) {
+        port_entry = PARENT_STRUCT(map_item, struct mlag_port_entry, map_item);
+        cl_plock_acquire(&port_entry->port_lock);
+        err = apply_port_func(&(port_entry->port_info), data);
         cl_plock_release(&port_entry->port_lock);
         MLAG_BAIL_ERROR_MSG(err,
                             "Failed to apply func on port db element err [%d]\n",
@@ -169,8 +242,9 @@ map_item_deinit(struct mlag_port_entry *port_entry)
 }
 
 /**
- *  This function inits port DB, it allocates MLAG_MAX_PORTS
- *  port entries in pool
+ *  This function inits port DB. The pool holds up to max ports
+ *  entries per peer, entries beyond the default number of ports
+ *  are allocated on demand.
  *
  * @return 0 when successful, otherwise ERROR
  */
@@ -179,17 +253,24 @@ port_db_init(void)
 {
     int err = 0;
     cl_status_t cl_status = CL_SUCCESS;
+    uint32_t max_entries = MLAG_MAX_PEERS * mlag_max_ports_get();
+    uint32_t min_entries = MLAG_MAX_PEERS * MLAG_MAX_PORTS_DEFAULT;
+
+    if (min_entries > max_entries) {
+        min_entries = max_entries;
+    }
 
     cl_status = cl_qpool_init(&(mlag_port_db.port_pool),
-                              MLAG_MAX_PEERS * MLAG_MAX_PORTS,
-                              MLAG_MAX_PEERS * MLAG_MAX_PORTS,
-                              0, sizeof(struct mlag_port_entry),
+                              min_entries, max_entries,
+                              MLAG_MAX_PORTS_DEFAULT,
+                              sizeof(struct mlag_port_entry),
                               port_entry_init, port_entry_deinit, NULL );
     if (cl_status != CL_SUCCESS) {
         err = -ENOMEM;
         MLAG_BAIL_ERROR_MSG(err, "Failed to Init port pool\n");
     }
     cl_qmap_init(&(mlag_port_db.port_map));
+    SAFE_MEMSET(&mlag_port_db.dense_index, 0);
 
 bail:
     return err;
@@ -219,6 +300,7 @@ port_db_deinit(void)
     }
 
     cl_qmap_remove_all(&(mlag_port_db.port_map));
+    SAFE_MEMSET(&mlag_port_db.dense_index, 0);
 
     cl_qpool_destroy(&(mlag_port_db.port_pool));
 
@@ -227,7 +309,9 @@ bail:
 }
 
 /*
- *  This function gets port entry pointer from DB,
+ *  This function gets port entry pointer from DB, ports in the
+ *  dense ifindex range are taken from the direct index, others
+ *  are looked up in the map
  *
  * @param[in] port_id - port ID
  *
@@ -239,6 +323,11 @@ port_entry_get(unsigned long port_id)
     cl_map_item_t *map_item = NULL;
     struct mlag_port_entry *port_entry = NULL;
 
+    if (PORT_DB_IS_DENSE(port_id)) {
+        port_entry = PORT_DB_DENSE_SLOT(port_id);
+        goto bail;
+    }
+
     map_item = cl_qmap_get(&(mlag_port_db.port_map), (uint64_t)port_id);
 
     if (map_item != cl_qmap_end(&(mlag_port_db.port_map))) {
@@ -329,6 +418,40 @@ port_db_entry_lock(unsigned long port_id, struct mlag_port_data **port_info)
     }
 
     cl_plock_excl_acquire(&port_entry->port_lock);
+    port_entry->modified = TRUE;
+    *port_info = &port_entry->port_info;
+
+bail:
+    return err;
+}
+
+/**
+ *  This function gets port info from DB for reading, port_info
+ *  passed as pointer to DB, and port is locked shared. Caller
+ *  must not modify port info and releases it by port_db_entry_unlock
+ *
+ * @param[in] port_id - port ID
+ * @param[out] port_info -  pointer to port info
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return ENOENT if port entry no found
+ */
+int
+port_db_entry_read_lock(unsigned long port_id,
+                        struct mlag_port_data **port_info)
+{
+    struct mlag_port_entry *port_entry = NULL;
+    int err = 0;
+
+    ASSERT(port_info != NULL);
+
+    port_entry = port_entry_get(port_id);
+    if (port_entry == NULL) {
+        err = -ENOENT;
+        goto bail;
+    }
+
+    cl_plock_acquire(&port_entry->port_lock);
     *port_info = &port_entry->port_info;
 
 bail:
@@ -348,16 +471,17 @@ port_db_entry_unlock(unsigned long port_id)
 {
     int err = 0;
     struct mlag_port_entry *port_entry;
-    cl_map_item_t *map_item = NULL;
 
-    map_item = cl_qmap_get(&(mlag_port_db.port_map),
-                           (uint64_t)port_id);
-    if (map_item == cl_qmap_end(&(mlag_port_db.port_map))) {
+    port_entry = port_entry_get(port_id);
+    if (port_entry == NULL) {
         err = -ENOENT;
         goto bail;
     }
-    port_entry = PARENT_STRUCT(map_item, struct mlag_port_entry, map_item);
 
+    /* Only the exclusive holder sets modified, readers leave it clear */
+    if (port_entry->modified == TRUE) {
+        port_entry_changed(port_entry);
+    }
     cl_plock_release(&port_entry->port_lock);
 
 bail:
@@ -381,13 +505,11 @@ port_db_entry_allocate(unsigned long port_id,
     int err = 0;
     cl_pool_item_t *pool_item = NULL;
     struct mlag_port_entry *port_entry;
-    cl_map_item_t *map_item = NULL;
 
     ASSERT(port_info != NULL);
 
-    map_item = cl_qmap_get(&(mlag_port_db.port_map),
-                           (uint64_t)port_id);
-    if (map_item == cl_qmap_end(&(mlag_port_db.port_map))) {
+    port_entry = port_entry_get(port_id);
+    if (port_entry == NULL) {
         pool_item = cl_qpool_get(&(mlag_port_db.port_pool));
         if (pool_item == NULL) {
             err = -ENOSPC;
@@ -396,15 +518,17 @@ port_db_entry_allocate(unsigned long port_id,
         port_entry =
             PARENT_STRUCT(pool_item, struct mlag_port_entry, pool_item);
     }
-    else {
-        port_entry = PARENT_STRUCT(map_item, struct mlag_port_entry, map_item);
-    }
 
     *port_info = &(port_entry->port_info);
     cl_plock_excl_acquire(&port_entry->port_lock);
+    port_entry->modified = TRUE;
+    /* Map keeps all entries ordered for walks, dense index is for lookup */
     cl_qmap_insert(&(mlag_port_db.port_map),
                    (uint64_t)(port_id),
                    &(port_entry->map_item));
+    if (PORT_DB_IS_DENSE(port_id)) {
+        PORT_DB_DENSE_SLOT(port_id) = port_entry;
+    }
 
 bail:
     return err;
@@ -430,9 +554,15 @@ port_db_entry_delete(unsigned long port_id)
         err = -ENOENT;
         goto bail;
     }
+    if (PORT_DB_IS_DENSE(port_id)) {
+        PORT_DB_DENSE_SLOT(port_id) = NULL;
+    }
 
     /* Clear entry */
     port_entry = PARENT_STRUCT(map_item, struct mlag_port_entry, map_item);
+    if (mlag_port_db.remove_cb != NULL) {
+        mlag_port_db.remove_cb(&(port_entry->port_info), NULL);
+    }
 
     /* return to pool */
     cl_qpool_put(&(mlag_port_db.port_pool), &(port_entry->pool_item));
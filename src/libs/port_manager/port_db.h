@@ -37,6 +37,7 @@
 #include "port_peer_remote.h"
 #include "port_master_logic.h"
 #include "port_manager.h"
+#include "port_failover.h"
 
 #ifdef PORT_DB_C_
 
@@ -46,9 +47,23 @@
 
 #undef  __MODULE__
 #define __MODULE__ PORT_MANAGER
+
+/* mLAG port ifindexes are allocated from a dense range, entries within
+ * it are indexed directly, ports outside it are found through the map
+ */
+#define PORT_DB_DENSE_FIRST_IFINDEX 29000
+#define PORT_DB_DENSE_LAST_IFINDEX 30001
+#define PORT_DB_DENSE_SIZE \
+    (PORT_DB_DENSE_LAST_IFINDEX - PORT_DB_DENSE_FIRST_IFINDEX + 1)
+
 /************************************************
  *  Local Macros
  ***********************************************/
+#define PORT_DB_IS_DENSE(port_id) \
+    (((port_id) >= PORT_DB_DENSE_FIRST_IFINDEX) && \
+     ((port_id) <= PORT_DB_DENSE_LAST_IFINDEX))
+#define PORT_DB_DENSE_SLOT(port_id) \
+    (mlag_port_db.dense_index[(port_id) - PORT_DB_DENSE_FIRST_IFINDEX])
 
 
 /************************************************
@@ -58,6 +73,9 @@
 struct port_db {
     cl_qpool_t port_pool;
     cl_qmap_t port_map;
+    struct mlag_port_entry *dense_index[PORT_DB_DENSE_SIZE];
+    int (*change_cb)(struct mlag_port_data *, void *);
+    int (*remove_cb)(struct mlag_port_data *, void *);
     int peer_state[MLAG_MAX_PEERS];
     struct port_manager_counters counters;
 };
@@ -92,12 +110,15 @@ struct mlag_port_data {
     struct port_peer_local peer_local_fsm;
     struct port_peer_remote peer_remote_fsm;
     struct port_master_logic port_master_fsm;
+    /* position in the failover plan lists, owned by port_failover */
+    uint32_t failover_slot[MLAG_MAX_PEERS][PORT_FAILOVER_ACTION_NUM];
 };
 
 struct mlag_port_entry {
     cl_pool_item_t pool_item;
     cl_map_item_t map_item;
     cl_plock_t port_lock;
+    int modified; /* locked exclusive since last unlock */
     struct mlag_port_data port_info;
 };
 
@@ -122,8 +143,8 @@ typedef int (*port_db_pfn_t)(struct mlag_port_data *, void *);
 void port_db_log_verbosity_set(mlag_verbosity_t verbosity);
 
 /**
- *  This function inits port DB, it allocates MLAG_MAX_PORTS
- *  port entries in pool
+ *  This function inits port DB, its pool holds up to the
+ *  maximum number of ports (mlag_max_ports_get)
  *
  * @return 0 when successful, otherwise ERROR
  */
@@ -159,6 +180,20 @@ int port_db_entry_exist(unsigned long port_id);
 int port_db_entry_lock(unsigned long port_id,
                        struct mlag_port_data **port_info);
 
+/**
+ *  This function gets port info from DB for reading, port_info
+ *  passed as pointer to DB, and port is locked shared. Caller
+ *  must not modify port info and releases it by port_db_entry_unlock
+ *
+ * @param[in] port_id - port ID
+ * @param[out] port_info -  pointer to port info
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return ENOENT if port entry no found
+ */
+int port_db_entry_read_lock(unsigned long port_id,
+                            struct mlag_port_data **port_info);
+
 /**
  *  This function unlocks port entry in DB
  *
@@ -202,6 +237,32 @@ int port_db_entry_delete(unsigned long port_id);
  */
 int port_db_foreach(port_db_pfn_t apply_port_func, void *data);
 
+/**
+ *  This function sets the functions notified on port entry changes.
+ *  change_cb is called, under the port lock, whenever an entry that
+ *  was locked exclusive is released, remove_cb when an entry is
+ *  deleted.
+ *
+ * @param[in] change_cb - called on entry change, may be NULL
+ * @param[in] remove_cb - called on entry delete, may be NULL
+ *
+ * @return void
+ */
+void port_db_change_notify_set(port_db_pfn_t change_cb,
+                               port_db_pfn_t remove_cb);
+
+/**
+ *  This function applies a read only function on each port item.
+ *  Port entries are held with a shared lock, so the applied
+ *  function must not modify the port data
+ *
+ * @param[in] apply_port_func - function pointer
+ * @param[in] data -  data for the applied function
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int port_db_foreach_read(port_db_pfn_t apply_port_func, void *data);
+
 /**
  *  This function gets port's per selected peer configuration
  *  state
@@ -0,0 +1,604 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define PORT_FAILOVER_C_
+#include <errno.h>
+#include <time.h>
+#include <utils/mlag_log.h>
+#include <utils/mlag_bail.h>
+#include <utils/mlag_defs.h>
+#include <complib/cl_mem.h>
+#include <complib/cl_spinlock.h>
+#include <libs/mlag_manager/mlag_manager.h>
+#include <libs/mlag_manager/mlag_manager_db.h>
+#include <libs/mlag_topology/mlag_topology.h>
+#include "mlag_common.h"
+#include "port_db.h"
+#include "port_failover.h"
+#include "service_layer.h"
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
+
+/* Plan per peer down and action. Ports keep their position in each list
+ * (failover_slot) so a port change updates the plan in constant time.
+ * Port changes update the plan from any thread that unlocks a port, so
+ * the plan and the role are protected by failover_lock. The lock is
+ * taken inside port locks, never the other way around.
+ */
+static struct port_failover_list
+    failover_plan[MLAG_MAX_PEERS][PORT_FAILOVER_ACTION_NUM];
+static uint32_t failover_max;
+static int failover_is_master;
+static cl_spinlock_t failover_lock;
+
+/* Port IDs of the plan being applied, per action */
+static unsigned long *failover_ports[PORT_FAILOVER_ACTION_NUM];
+static uint32_t failover_ports_num[PORT_FAILOVER_ACTION_NUM];
+static uint64_t failover_start_usec;
+static uint64_t failover_plan_usec;
+
+static struct port_failover_counters failover_counters;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/**
+ *  This function sets module log verbosity level
+ *
+ *  @param verbosity - new log verbosity
+ *
+ * @return void
+ */
+void
+port_failover_log_verbosity_set(mlag_verbosity_t verbosity)
+{
+    LOG_VAR_NAME(__MODULE__) = verbosity;
+}
+
+/*
+ *  This function returns monotonic time
+ *
+ * @return current time in usec
+ */
+static uint64_t
+failover_now_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+/*
+ *  This function checks if a peer down causes the given action on
+ *  a port. The conditions follow the transitions of the remote and
+ *  master FSMs on peer_down_ev, after the peer bit is cleared.
+ *
+ * @param[in] port_info - port info
+ * @param[in] peer_id - local index of the peer
+ * @param[in] action - failover action
+ * @param[in] peer_states - peers state vector
+ * @param[in] is_master - TRUE if the port manager acts as master
+ *
+ * @return TRUE if the action is needed, otherwise FALSE
+ */
+static int
+port_action_needed(struct mlag_port_data *port_info, int peer_id,
+                   enum port_failover_action action, uint32_t peer_states,
+                   int is_master)
+{
+    uint32_t mask = ~(1 << peer_id);
+    uint32_t conf = port_info->peers_conf_state & mask;
+    uint32_t oper = port_info->peers_oper_state & mask;
+
+    if (action == PORT_FAILOVER_ISOLATE) {
+        /* remote FSM leaves remote fault when all remaining remotes
+         * are up, local state is cleared as in is_all_remotes_up
+         */
+        return (peer_id != mlag_manager_db_local_peer_id_get()) &&
+               port_peer_remote_remote_fault_in(&port_info->peer_remote_fsm)
+               && (port_info->peer_remote_fsm.isolated == FALSE) &&
+               ((conf >> 1) == (oper >> 1));
+    }
+
+    /* master FSM leaves global up when no enabled peer is oper up */
+    return is_master &&
+           port_master_logic_global_up_in(&port_info->port_master_fsm) &&
+           ((peer_states & mask & oper) == 0);
+}
+
+/*
+ *  This function removes a port from a plan list.
+ *  Called with failover_lock held.
+ *
+ * @param[in] port_info - port info
+ * @param[in] peer_id - local index of the peer
+ * @param[in] action - failover action
+ *
+ * @return void
+ */
+static void
+plan_port_remove(struct mlag_port_data *port_info, int peer_id,
+                 enum port_failover_action action)
+{
+    struct port_failover_list *list = &failover_plan[peer_id][action];
+    uint32_t slot = port_info->failover_slot[peer_id][action];
+    struct mlag_port_data *moved;
+
+    if ((slot >= list->num) || (list->ports[slot] != port_info)) {
+        return;
+    }
+
+    list->num--;
+    moved = list->ports[list->num];
+    list->ports[slot] = moved;
+    moved->failover_slot[peer_id][action] = slot;
+}
+
+/*
+ *  This function adds a port to a plan list, if not already there.
+ *  Called with failover_lock held.
+ *
+ * @param[in] port_info - port info
+ * @param[in] peer_id - local index of the peer
+ * @param[in] action - failover action
+ *
+ * @return 0 if operation completes successfully.
+ * @return -ENOSPC if the plan is full
+ */
+static int
+plan_port_add(struct mlag_port_data *port_info, int peer_id,
+              enum port_failover_action action)
+{
+    int err = 0;
+    struct port_failover_list *list = &failover_plan[peer_id][action];
+    uint32_t slot = port_info->failover_slot[peer_id][action];
+
+    if ((slot < list->num) && (list->ports[slot] == port_info)) {
+        goto bail;
+    }
+    if (list->num == failover_max) {
+        err = -ENOSPC;
+        goto bail;
+    }
+
+    port_info->failover_slot[peer_id][action] = list->num;
+    list->ports[list->num] = port_info;
+    list->num++;
+
+bail:
+    return err;
+}
+
+/*
+ *  This function updates the plan of a port after it was changed,
+ *  called by port DB under the port lock
+ *
+ * @param[in] port_info - port info
+ * @param[in] data - unused
+ *
+ * @return 0 if operation completes successfully.
+ */
+static int
+port_failover_port_update(struct mlag_port_data *port_info, void *data)
+{
+    int err = 0;
+    int peer_id;
+    int action;
+    uint32_t peer_states;
+
+    UNUSED_PARAM(data);
+
+    err = port_db_peer_state_vector_get(&peer_states);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to get peers state vector\n");
+
+    cl_spinlock_acquire(&failover_lock);
+    for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
+        for (action = 0; action < PORT_FAILOVER_ACTION_NUM; action++) {
+            if (port_action_needed(port_info, peer_id, action,
+                                   peer_states, failover_is_master)) {
+                err = plan_port_add(port_info, peer_id, action);
+                if (err) {
+                    break;
+                }
+            }
+            else {
+                plan_port_remove(port_info, peer_id, action);
+            }
+        }
+        if (err) {
+            break;
+        }
+    }
+    cl_spinlock_release(&failover_lock);
+    MLAG_BAIL_ERROR_MSG(err, "Failover plan full, port [%lu]\n",
+                        port_info->port_id);
+
+bail:
+    return err;
+}
+
+/*
+ *  This function removes a port from the plan, called by port DB
+ *  when the port is deleted
+ *
+ * @param[in] port_info - port info
+ * @param[in] data - unused
+ *
+ * @return 0 if operation completes successfully.
+ */
+static int
+port_failover_port_remove(struct mlag_port_data *port_info, void *data)
+{
+    int peer_id;
+    int action;
+
+    UNUSED_PARAM(data);
+
+    cl_spinlock_acquire(&failover_lock);
+    for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
+        for (action = 0; action < PORT_FAILOVER_ACTION_NUM; action++) {
+            plan_port_remove(port_info, peer_id, action);
+        }
+    }
+    cl_spinlock_release(&failover_lock);
+
+    return 0;
+}
+
+/**
+ *  This function inits the failover plan, sized for the maximum
+ *  number of ports. The plan follows port DB changes from now on.
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+port_failover_init(void)
+{
+    int err = 0;
+    int peer_id;
+    int action;
+    cl_status_t cl_err;
+
+    failover_max = mlag_max_ports_get();
+    failover_is_master = FALSE;
+    SAFE_MEMSET(&failover_counters, 0);
+
+    cl_err = cl_spinlock_init(&failover_lock);
+    if (cl_err != CL_SUCCESS) {
+        err = -EIO;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to init failover lock\n");
+    }
+
+    for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
+        for (action = 0; action < PORT_FAILOVER_ACTION_NUM; action++) {
+            failover_plan[peer_id][action].num = 0;
+            failover_plan[peer_id][action].ports =
+                (struct mlag_port_data **)cl_malloc(
+                    failover_max * sizeof(struct mlag_port_data *));
+            if (failover_plan[peer_id][action].ports == NULL) {
+                err = -ENOMEM;
+                MLAG_BAIL_ERROR_MSG(err, "Failed to allocate failover plan\n");
+            }
+        }
+    }
+    for (action = 0; action < PORT_FAILOVER_ACTION_NUM; action++) {
+        failover_ports_num[action] = 0;
+        failover_ports[action] =
+            (unsigned long *)cl_malloc(failover_max * sizeof(unsigned long));
+        if (failover_ports[action] == NULL) {
+            err = -ENOMEM;
+            MLAG_BAIL_ERROR_MSG(err, "Failed to allocate failover ports\n");
+        }
+    }
+
+    port_db_change_notify_set(port_failover_port_update,
+                              port_failover_port_remove);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function deinits the failover plan
+ *
+ * @return void
+ */
+void
+port_failover_deinit(void)
+{
+    int peer_id;
+    int action;
+
+    port_db_change_notify_set(NULL, NULL);
+
+    for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
+        for (action = 0; action < PORT_FAILOVER_ACTION_NUM; action++) {
+            if (failover_plan[peer_id][action].ports != NULL) {
+                cl_free(failover_plan[peer_id][action].ports);
+                failover_plan[peer_id][action].ports = NULL;
+            }
+            failover_plan[peer_id][action].num = 0;
+        }
+    }
+    for (action = 0; action < PORT_FAILOVER_ACTION_NUM; action++) {
+        if (failover_ports[action] != NULL) {
+            cl_free(failover_ports[action]);
+            failover_ports[action] = NULL;
+        }
+    }
+    cl_spinlock_destroy(&failover_lock);
+}
+
+/**
+ *  This function rebuilds the failover plan of all ports. It is
+ *  needed when a change that is not per port, such as role or peer
+ *  state, affects the plan.
+ *
+ * @param[in] is_master - TRUE if the port manager acts as master
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+port_failover_plan_build(int is_master)
+{
+    int err = 0;
+    int peer_id;
+    int action;
+
+    cl_spinlock_acquire(&failover_lock);
+    failover_is_master = is_master;
+    for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
+        for (action = 0; action < PORT_FAILOVER_ACTION_NUM; action++) {
+            failover_plan[peer_id][action].num = 0;
+        }
+    }
+    cl_spinlock_release(&failover_lock);
+
+    err = port_db_foreach_read(port_failover_port_update, NULL);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to build failover plan\n");
+
+bail:
+    return err;
+}
+
+/*
+ *  This function copies the port IDs of a plan list, so the plan may
+ *  change while it is applied
+ *
+ * @param[in] peer_id - local index of the peer
+ * @param[in] action - failover action
+ *
+ * @return number of ports
+ */
+static uint32_t
+plan_ports_copy(int peer_id, enum port_failover_action action)
+{
+    struct port_failover_list *list = &failover_plan[peer_id][action];
+    uint32_t idx;
+
+    cl_spinlock_acquire(&failover_lock);
+    for (idx = 0; idx < list->num; idx++) {
+        failover_ports[action][idx] = list->ports[idx]->port_id;
+    }
+    failover_ports_num[action] = list->num;
+    cl_spinlock_release(&failover_lock);
+
+    return failover_ports_num[action];
+}
+
+/*
+ *  This function marks the port FSMs of an applied action, so peer
+ *  down handling does not call the service layer again for them
+ *
+ * @param[in] action - failover action
+ * @param[in] value - mark value
+ *
+ * @return void
+ */
+static void
+plan_ports_mark(enum port_failover_action action, int value)
+{
+    int err = 0;
+    uint32_t idx;
+    unsigned long port_id;
+    struct mlag_port_data *port_info;
+
+    for (idx = 0; idx < failover_ports_num[action]; idx++) {
+        port_id = failover_ports[action][idx];
+        err = port_db_entry_lock(port_id, &port_info);
+        if (err) {
+            /* Port deleted meanwhile */
+            continue;
+        }
+        if (action == PORT_FAILOVER_ISOLATE) {
+            port_info->peer_remote_fsm.isolated = value;
+        }
+        else {
+            port_info->port_master_fsm.oper_down_sent = value;
+        }
+        port_db_entry_unlock(port_id);
+    }
+}
+
+/**
+ *  This function applies the failover plan of the given peer as
+ *  one service layer operation per action, and marks the port FSMs
+ *  so the peer down handling that follows does not repeat it.
+ *  It must be followed by port_failover_end.
+ *
+ * @param[in] peer_id - local index of the peer that went down
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+port_failover_start(int peer_id)
+{
+    int err = 0;
+    int sl_err;
+    unsigned int ipl_id;
+    unsigned long ipl_port_id;
+
+    failover_start_usec = failover_now_usec();
+    failover_ports_num[PORT_FAILOVER_ISOLATE] = 0;
+    failover_ports_num[PORT_FAILOVER_OPER_DOWN] = 0;
+
+    ASSERT((peer_id >= 0) && (peer_id < MLAG_MAX_PEERS));
+
+    if (plan_ports_copy(peer_id, PORT_FAILOVER_ISOLATE) > 0) {
+        sl_err = mlag_topology_redirect_ipl_id_get(&ipl_id, &ipl_port_id);
+        if (sl_err == 0) {
+            sl_err = sl_api_ports_isolation_set(
+                OES_ACCESS_CMD_ADD, failover_ports[PORT_FAILOVER_ISOLATE],
+                failover_ports_num[PORT_FAILOVER_ISOLATE], ipl_port_id);
+        }
+        if (sl_err) {
+            /* Leave it to the remote FSMs */
+            MLAG_LOG(MLAG_LOG_NOTICE,
+                     "Failover isolation of [%u] ports not applied [%d]\n",
+                     failover_ports_num[PORT_FAILOVER_ISOLATE], sl_err);
+            failover_ports_num[PORT_FAILOVER_ISOLATE] = 0;
+        }
+        plan_ports_mark(PORT_FAILOVER_ISOLATE, TRUE);
+    }
+
+    if (plan_ports_copy(peer_id, PORT_FAILOVER_OPER_DOWN) > 0) {
+        sl_err = sl_api_ports_oper_status_trigger(
+            failover_ports[PORT_FAILOVER_OPER_DOWN],
+            failover_ports_num[PORT_FAILOVER_OPER_DOWN], OES_PORT_DOWN);
+        if (sl_err) {
+            /* Leave it to the master FSMs */
+            MLAG_LOG(MLAG_LOG_NOTICE,
+                     "Failover oper down of [%u] ports not applied [%d]\n",
+                     failover_ports_num[PORT_FAILOVER_OPER_DOWN], sl_err);
+            failover_ports_num[PORT_FAILOVER_OPER_DOWN] = 0;
+        }
+        plan_ports_mark(PORT_FAILOVER_OPER_DOWN, TRUE);
+    }
+
+    failover_plan_usec = failover_now_usec() - failover_start_usec;
+
+bail:
+    return err;
+}
+
+/**
+ *  This function ends the failover of the given peer, once peer
+ *  down handling of all ports is done, and updates the latency
+ *  counters
+ *
+ * @param[in] peer_id - local index of the peer that went down
+ *
+ * @return void
+ */
+void
+port_failover_end(int peer_id)
+{
+    uint64_t total_usec;
+
+    /* Master FSMs that did not reach global down keep no mark */
+    plan_ports_mark(PORT_FAILOVER_OPER_DOWN, FALSE);
+
+    total_usec = failover_now_usec() - failover_start_usec;
+
+    failover_counters.events++;
+    failover_counters.last_ports =
+        failover_ports_num[PORT_FAILOVER_ISOLATE] +
+        failover_ports_num[PORT_FAILOVER_OPER_DOWN];
+    failover_counters.last_plan_usec = failover_plan_usec;
+    failover_counters.last_total_usec = total_usec;
+    if (failover_plan_usec > failover_counters.max_plan_usec) {
+        failover_counters.max_plan_usec = failover_plan_usec;
+    }
+    if (total_usec > failover_counters.max_total_usec) {
+        failover_counters.max_total_usec = total_usec;
+    }
+
+    MLAG_LOG(MLAG_LOG_NOTICE,
+             "Peer [%d] failover: [%u] ports in plan applied in [%llu] usec, "
+             "done in [%llu] usec\n", peer_id, failover_counters.last_ports,
+             (unsigned long long)failover_plan_usec,
+             (unsigned long long)total_usec);
+}
+
+/**
+ *  This function gets the failover counters
+ *
+ * @param[out] counters - failover counters
+ *
+ * @return void
+ */
+void
+port_failover_counters_get(struct port_failover_counters *counters)
+{
+    *counters = failover_counters;
+}
+
+/**
+ *  This function dumps the failover plan size and counters
+ *
+ * @param[in] dump_cb - callback for dumping, if NULL, log will be used
+ *
+ * @return void
+ */
+void
+port_failover_dump(void (*dump_cb)(const char *, ...))
+{
+    int peer_id;
+    uint32_t isolate_num;
+    uint32_t oper_down_num;
+
+    DUMP_OR_LOG("Failover plan:\n");
+    for (peer_id = 0; peer_id < MLAG_MAX_PEERS; peer_id++) {
+        cl_spinlock_acquire(&failover_lock);
+        isolate_num = failover_plan[peer_id][PORT_FAILOVER_ISOLATE].num;
+        oper_down_num = failover_plan[peer_id][PORT_FAILOVER_OPER_DOWN].num;
+        cl_spinlock_release(&failover_lock);
+        DUMP_OR_LOG("peer [%d] isolate [%u] oper down [%u]\n", peer_id,
+                    isolate_num, oper_down_num);
+    }
+    DUMP_OR_LOG("events [%u] last ports [%u]\n", failover_counters.events,
+                failover_counters.last_ports);
+    DUMP_OR_LOG("last plan [%llu] usec total [%llu] usec\n",
+                (unsigned long long)failover_counters.last_plan_usec,
+                (unsigned long long)failover_counters.last_total_usec);
+    DUMP_OR_LOG("max plan [%llu] usec total [%llu] usec\n",
+                (unsigned long long)failover_counters.max_plan_usec,
+                (unsigned long long)failover_counters.max_total_usec);
+}
@@ -0,0 +1,175 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PORT_FAILOVER_H_
+#define PORT_FAILOVER_H_
+
+#include <utils/mlag_log.h>
+#include <utils/mlag_defs.h>
+
+#ifdef PORT_FAILOVER_C_
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#undef  __MODULE__
+#define __MODULE__ PORT_MANAGER
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+/* Ports affected by one action of one peer down */
+struct port_failover_list {
+    uint32_t num;
+    struct mlag_port_data **ports;
+};
+
+#endif
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+/* Service layer actions a peer down causes on a port */
+enum port_failover_action {
+    /* Remote fault is cleared, port is isolated again from the IPL */
+    PORT_FAILOVER_ISOLATE = 0,
+    /* Master only, port global state goes down */
+    PORT_FAILOVER_OPER_DOWN = 1,
+    PORT_FAILOVER_ACTION_NUM
+};
+
+struct port_failover_counters {
+    uint32_t events;
+    uint32_t last_ports;       /* ports handled by the last plan */
+    uint64_t last_plan_usec;   /* peer down until plan applied */
+    uint64_t last_total_usec;  /* peer down until all ports handled */
+    uint64_t max_plan_usec;
+    uint64_t max_total_usec;
+};
+
+struct mlag_port_data;
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ *  This function sets module log verbosity level
+ *
+ *  @param verbosity - new log verbosity
+ *
+ * @return void
+ */
+void port_failover_log_verbosity_set(mlag_verbosity_t verbosity);
+
+/**
+ *  This function inits the failover plan, sized for the maximum
+ *  number of ports. The plan follows port DB changes from now on.
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int port_failover_init(void);
+
+/**
+ *  This function deinits the failover plan
+ *
+ * @return void
+ */
+void port_failover_deinit(void);
+
+/**
+ *  This function rebuilds the failover plan of all ports. It is
+ *  needed when a change that is not per port, such as role or peer
+ *  state, affects the plan.
+ *
+ * @param[in] is_master - TRUE if the port manager acts as master
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int port_failover_plan_build(int is_master);
+
+/**
+ *  This function applies the failover plan of the given peer as
+ *  one service layer operation per action, and marks the port FSMs
+ *  so the peer down handling that follows does not repeat it.
+ *  It must be followed by port_failover_end.
+ *
+ * @param[in] peer_id - local index of the peer that went down
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int port_failover_start(int peer_id);
+
+/**
+ *  This function ends the failover of the given peer, once peer
+ *  down handling of all ports is done, and updates the latency
+ *  counters
+ *
+ * @param[in] peer_id - local index of the peer that went down
+ *
+ * @return void
+ */
+void port_failover_end(int peer_id);
+
+/**
+ *  This function gets the failover counters
+ *
+ * @param[out] counters - failover counters
+ *
+ * @return void
+ */
+void port_failover_counters_get(struct port_failover_counters *counters);
+
+/**
+ *  This function dumps the failover plan size and counters
+ *
+ * @param[in] dump_cb - callback for dumping, if NULL, log will be used
+ *
+ * @return void
+ */
+void port_failover_dump(void (*dump_cb)(const char *, ...));
+
+#endif /* PORT_FAILOVER_H_ */
@@ -34,14 +34,19 @@
 #include <utils/mlag_bail.h>
 #include <utils/mlag_defs.h>
 #include <errno.h>
+#include <complib/cl_mem.h>
 #include <libs/mlag_manager/mlag_manager.h>
 #include <libs/mlag_manager/mlag_manager_db.h>
 #include <libs/health_manager/health_manager.h>
 #include <libs/mlag_master_election/mlag_master_election.h>
+#include <libs/notification_layer/notification_layer.h>
 #include "lib_commu.h"
 #include "mlag_common.h"
+#include "mlag_state_publisher.h"
 #include "mlag_comm_layer_wrapper.h"
+#include "mlag_wire.h"
 #include "port_db.h"
+#include "port_failover.h"
 #include "port_manager.h"
 #include <libs/mlag_manager/mlag_dispatcher.h>
 #include "service_layer.h"
@@ -61,30 +66,94 @@ static int current_role;
 static uint8_t my_mlag_id;
 static int in_split_brain;
 static int started;
+/* Ports to delete on peer down, sized on init to the port DB capacity */
+static unsigned long *peer_down_ports;
+static int peer_down_ports_max;
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_NOTICE;
 
 
 static handler_command_t port_manager_ibc_msgs[] = {
     {MLAG_PORT_GLOBAL_STATE_EVENT, "Port global state change event",
-     rcv_msg_handler, net_order_msg_handler },
+     rcv_msg_handler, NULL},
     {MLAG_PORTS_SYNC_DATA, "Port sync message", rcv_msg_handler,
-     net_order_msg_handler },
+     NULL},
     {MLAG_PORTS_UPDATE_EVENT, "Port update message", rcv_msg_handler,
-     net_order_msg_handler },
+     NULL},
     {MLAG_PORTS_SYNC_FINISH_EVENT, "Port sync done", rcv_msg_handler,
-     net_order_msg_handler },
+     NULL},
     {MLAG_PORTS_OPER_UPDATE, "Ports oper update message", rcv_msg_handler,
-     net_order_msg_handler},
+     NULL},
     {MLAG_PORTS_OPER_SYNC_DONE, "Port oper state sync done", rcv_msg_handler,
-     net_order_msg_handler },
+     NULL},
     {MLAG_PEER_PORT_OPER_STATE_CHANGE, "Port state change event",
-     rcv_msg_handler, net_order_msg_handler},
+     rcv_msg_handler, NULL},
+    {MLAG_PEER_PORTS_OPER_STATE_CHANGE, "Ports state change event",
+     rcv_msg_handler, NULL},
 
     {0, "", NULL, NULL}
 };
+
+static const struct mlag_wire_field port_state_entry_wire[] = {
+    MLAG_WIRE_FIELD(struct port_state_entry, port_id),
+    MLAG_WIRE_FIELD(struct port_state_entry, state),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field port_global_state_wire[] = {
+    MLAG_WIRE_FIELD(struct port_global_state_event_data, port_num),
+    MLAG_WIRE_PORT_STRUCT_ARRAY(struct port_global_state_event_data, ports,
+                                port_num, port_state_entry_wire),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field peer_port_sync_wire[] = {
+    MLAG_WIRE_FIELD(struct peer_port_sync_message, port_num),
+    MLAG_WIRE_FIELD(struct peer_port_sync_message, del_ports),
+    MLAG_WIRE_FIELD(struct peer_port_sync_message, mlag_id),
+    MLAG_WIRE_PORT_ARRAY(struct peer_port_sync_message, port_id, port_num),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field peer_port_oper_sync_wire[] = {
+    MLAG_WIRE_FIELD(struct peer_port_oper_sync_message, port_num),
+    MLAG_WIRE_FIELD(struct peer_port_oper_sync_message, mlag_id),
+    MLAG_WIRE_PORT_STRUCT_ARRAY(struct peer_port_oper_sync_message, ports,
+                                port_num, port_state_entry_wire),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field sync_event_wire[] = {
+    MLAG_WIRE_FIELD(struct sync_event_data, peer_id),
+    MLAG_WIRE_FIELD(struct sync_event_data, sync_type),
+    MLAG_WIRE_FIELD(struct sync_event_data, state),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_field port_oper_state_change_wire[] = {
+    MLAG_WIRE_FIELD(struct port_oper_state_change_data, mlag_id),
+    MLAG_WIRE_FIELD(struct port_oper_state_change_data, port_id),
+    MLAG_WIRE_FIELD(struct port_oper_state_change_data, is_ipl),
+    MLAG_WIRE_FIELD(struct port_oper_state_change_data, state),
+    MLAG_WIRE_FIELDS_END
+};
+
+static const struct mlag_wire_msg port_manager_wire_msgs[] = {
+    MLAG_WIRE_MSG(MLAG_PORT_GLOBAL_STATE_EVENT, port_global_state_wire),
+    MLAG_WIRE_MSG(MLAG_PORTS_SYNC_DATA, peer_port_sync_wire),
+    MLAG_WIRE_MSG(MLAG_PORTS_UPDATE_EVENT, peer_port_sync_wire),
+    MLAG_WIRE_MSG(MLAG_PORTS_OPER_UPDATE, peer_port_oper_sync_wire),
+    MLAG_WIRE_MSG(MLAG_PORTS_OPER_SYNC_DONE, NULL),
+    MLAG_WIRE_MSG(MLAG_PORTS_SYNC_FINISH_EVENT, sync_event_wire),
+    MLAG_WIRE_MSG(MLAG_PEER_PORT_OPER_STATE_CHANGE,
+                  port_oper_state_change_wire),
+    MLAG_WIRE_MSG(MLAG_PEER_PORTS_OPER_STATE_CHANGE,
+                  peer_port_oper_sync_wire),
+};
 /************************************************
  *  Local function declarations
  ***********************************************/
+static enum mlag_port_oper_state
+port_state_get(struct mlag_port_data *port_info);
 
 /************************************************
  *  Function implementations
@@ -333,6 +402,35 @@ bail:
     return err;
 }
 
+/*
+ *  This function validates the port count of a received port message
+ *  against the maximum number of ports and the received length
+ *
+ * @param[in] opcode - message opcode
+ * @param[in] port_num - number of ports in message
+ * @param[in] msg_size - message size expected for port_num ports
+ * @param[in] msg_len - received message length
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -EMSGSIZE if message is malformed
+ */
+static int
+port_msg_size_check(uint16_t opcode, uint32_t port_num, size_t msg_size,
+                    uint32_t msg_len)
+{
+    int err = 0;
+
+    if ((port_num > mlag_max_ports_get()) || (msg_len < msg_size)) {
+        err = -EMSGSIZE;
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Bad port message opcode [%u]: ports [%u] len [%u]\n",
+                            opcode, port_num, msg_len);
+    }
+
+bail:
+    return err;
+}
+
 /*
  *  This function is called to handle IBC message
  *
@@ -344,17 +442,26 @@ static int
 rcv_msg_handler(uint8_t *data)
 {
     int err = 0;
-    uint32_t idx;
-    int local_peer_index;
     struct recv_payload_data *payload_data = (struct recv_payload_data*) data;
     uint16_t opcode;
+    uint8_t *msg;
+    uint32_t msg_len;
     struct port_global_state_event_data *port_states;
     struct port_oper_state_change_data *oper_change;
     struct peer_port_sync_message *port_sync;
     struct peer_port_oper_sync_message *oper_sync;
     struct sync_event_data *sync_event;
 
-    opcode = *((uint16_t*)(payload_data->payload[0]));
+    /* Port messages of many ports arrive as jumbo */
+    if (payload_data->jumbo_payload_len > 0) {
+        msg = payload_data->jumbo_payload;
+        msg_len = payload_data->jumbo_payload_len;
+    }
+    else {
+        msg = payload_data->payload[0];
+        msg_len = payload_data->payload_len[0];
+    }
+    opcode = *((uint16_t*)msg);
 
     if (started == FALSE) {
         goto bail;
@@ -367,286 +474,82 @@ rcv_msg_handler(uint8_t *data)
 
     switch (opcode) {
     case MLAG_PORT_GLOBAL_STATE_EVENT:
-        port_states =
-            (struct port_global_state_event_data *)payload_data->payload[0];
-        err = port_manager_global_oper_state_set(port_states->port_id,
-                                                 port_states->state,
+        port_states = (struct port_global_state_event_data *)msg;
+        err = port_msg_size_check(opcode, (uint32_t)port_states->port_num,
+                                  PORT_GLOBAL_STATE_EVENT_SIZE(
+                                      (uint32_t)port_states->port_num),
+                                  msg_len);
+        MLAG_BAIL_CHECK_NO_MSG(err);
+        err = port_manager_global_oper_state_set(port_states->ports,
                                                  port_states->port_num);
         MLAG_BAIL_ERROR_MSG(err, "Failed to handle ports global state\n");
         break;
     case MLAG_PORTS_SYNC_DATA:
-        port_sync = (struct peer_port_sync_message *)payload_data->payload[0];
+        port_sync = (struct peer_port_sync_message *)msg;
         MLAG_LOG(MLAG_LOG_NOTICE,
                  "port manager sync data received: del_ports [%d] ports_num [%u]\n",
                  port_sync->del_ports, port_sync->port_num);
+        err = port_msg_size_check(opcode, port_sync->port_num,
+                                  PEER_PORT_SYNC_MSG_SIZE(port_sync->port_num),
+                                  msg_len);
+        MLAG_BAIL_CHECK_NO_MSG(err);
 
         err = port_manager_port_sync(port_sync);
         MLAG_BAIL_ERROR_MSG(err, "Failed handling port sync data\n");
         break;
     case MLAG_PORTS_UPDATE_EVENT:
-        port_sync = (struct peer_port_sync_message *)payload_data->payload[0];
+        port_sync = (struct peer_port_sync_message *)msg;
         MLAG_LOG(MLAG_LOG_NOTICE,
                  "port manager sync data received: del_ports [%d] ports_num [%u]\n",
                  port_sync->del_ports, port_sync->port_num);
+        err = port_msg_size_check(opcode, port_sync->port_num,
+                                  PEER_PORT_SYNC_MSG_SIZE(port_sync->port_num),
+                                  msg_len);
+        MLAG_BAIL_CHECK_NO_MSG(err);
         err = port_manager_port_update(port_sync);
         MLAG_BAIL_ERROR_MSG(err, "Failed handling ports update event\n");
         break;
     case MLAG_PORTS_OPER_UPDATE:
-        oper_sync =
-            (struct peer_port_oper_sync_message*) payload_data->payload[0];
+        oper_sync = (struct peer_port_oper_sync_message*)msg;
 
         MLAG_LOG(MLAG_LOG_NOTICE,
                  "port manager oper sync data: ports_num [%u] \n",
                  oper_sync->port_num);
+        err = port_msg_size_check(opcode, oper_sync->port_num,
+                                  PEER_PORT_OPER_SYNC_MSG_SIZE(
+                                      oper_sync->port_num),
+                                  msg_len);
+        MLAG_BAIL_CHECK_NO_MSG(err);
 
-        err = mlag_manager_db_local_index_from_mlag_id_get(oper_sync->mlag_id,
-                                                           &local_peer_index);
+        err = port_manager_peer_ports_oper_state_change(oper_sync);
         MLAG_BAIL_ERROR_MSG(err, "Failed handling ports oper update\n");
-
-        for (idx = 0; idx < oper_sync->port_num; idx++) {
-            if (oper_sync->oper_state[idx] == MLAG_PORT_OPER_UP) {
-                err = port_manager_peer_port_up(local_peer_index,
-                                                oper_sync->port_id[idx]);
-            }
-            else {
-                err =
-                    port_manager_peer_port_down(local_peer_index,
-                                                oper_sync->port_id[idx]);
-            }
-            MLAG_BAIL_ERROR_MSG(err,
-                                "Failed handling port [%lu] state update\n",
-                                oper_sync->port_id[idx]);
-        }
         break;
     case MLAG_PORTS_OPER_SYNC_DONE:
         err = port_manager_oper_sync_done();
         MLAG_BAIL_ERROR_MSG(err, "Failed handling port oper sync done msg\n");
         break;
     case MLAG_PORTS_SYNC_FINISH_EVENT:
-        sync_event = (struct sync_event_data*)payload_data->payload[0];
+        sync_event = (struct sync_event_data*)msg;
         err = port_manager_sync_finish(sync_event);
         MLAG_BAIL_ERROR_MSG(err, "Failed handling port sync finish msg\n");
         break;
     case MLAG_PEER_PORT_OPER_STATE_CHANGE:
-        oper_change =
-            (struct port_oper_state_change_data*) payload_data->payload[0];
+        oper_change = (struct port_oper_state_change_data*)msg;
         ASSERT(oper_change->is_ipl == FALSE);
 
         err = port_manager_peer_oper_state_change(oper_change);
         MLAG_BAIL_ERROR_MSG(err, "Failed handling peer oper state change\n");
         break;
-    default:
-        /* Unknown opcode */
-        err = -ENOENT;
-        MLAG_BAIL_ERROR_MSG(err, "Unknown opcode [%u] in port manager\n",
-                            opcode);
-        break;
-    }
-
-bail:
-    return err;
-}
-
-/*
- *  Convert struct between network and host order
- *
- * @param[in] data - struct body
- * @param[in] oper - convertion direction
- *
- * @return 0 when successful, otherwise ERROR
- */
-static void
-net_order_port_global_state_event_data(
-    struct port_global_state_event_data *data, int oper)
-{
-    int idx;
-    if (oper == MESSAGE_SENDING) {
-        for (idx = 0; idx < MLAG_MAX_PORTS; idx++) {
-            data->port_id[idx] = htonl(data->port_id[idx]);
-            data->state[idx] = htonl(data->state[idx]);
-        }
-        data->port_num = htonl(data->port_num);
-    }
-    else {
-        for (idx = 0; idx < MLAG_MAX_PORTS; idx++) {
-            data->port_id[idx] = ntohl(data->port_id[idx]);
-            data->state[idx] = ntohl(data->state[idx]);
-        }
-        data->port_num = ntohl(data->port_num);
-    }
-}
-
-/*
- *  Convert struct between network and host order
- *
- * @param[in] data - struct body
- * @param[in] oper - convertion direction
- *
- * @return 0 when successful, otherwise ERROR
- */
-static void
-net_order_peer_port_sync_message(struct peer_port_sync_message *data, int oper)
-{
-    int idx;
-    if (oper == MESSAGE_SENDING) {
-        data->del_ports = htonl(data->del_ports);
-        data->mlag_id = htonl(data->mlag_id);
-        for (idx = 0; idx < MLAG_MAX_PORTS; idx++) {
-            data->port_id[idx] = htonl(data->port_id[idx]);
-        }
-        data->port_num = htonl(data->port_num);
-    }
-    else {
-        data->del_ports = ntohl(data->del_ports);
-        data->mlag_id = ntohl(data->mlag_id);
-        for (idx = 0; idx < MLAG_MAX_PORTS; idx++) {
-            data->port_id[idx] = ntohl(data->port_id[idx]);
-        }
-        data->port_num = ntohl(data->port_num);
-    }
-}
-
-/**
- *  Convert struct between network and host order
- *
- * @param[in] data - struct body
- * @param[in] oper - convertion direction
- *
- * @return 0 when successful, otherwise ERROR
- */
-static void
-net_order_peer_port_oper_sync_message(struct peer_port_oper_sync_message *data,
-                                      int oper)
-{
-    int idx;
-    if (oper == MESSAGE_SENDING) {
-        data->mlag_id = htonl(data->mlag_id);
-        for (idx = 0; idx < MLAG_MAX_PORTS; idx++) {
-            data->port_id[idx] = htonl(data->port_id[idx]);
-            data->oper_state[idx] = htonl(data->oper_state[idx]);
-        }
-        data->port_num = htonl(data->port_num);
-    }
-    else {
-        data->mlag_id = ntohl(data->mlag_id);
-        for (idx = 0; idx < MLAG_MAX_PORTS; idx++) {
-            data->port_id[idx] = ntohl(data->port_id[idx]);
-            data->oper_state[idx] = ntohl(data->oper_state[idx]);
-        }
-        data->port_num = ntohl(data->port_num);
-    }
-}
-
-/**
- *  Convert struct between network and host order
- *
- * @param[in] data - struct body
- * @param[in] oper - convertion direction
- *
- * @return 0 when successful, otherwise ERROR
- */
-static void
-net_order_sync_event_data(struct sync_event_data *data, int oper)
-{
-    if (oper == MESSAGE_SENDING) {
-        data->peer_id = htonl(data->peer_id);
-        data->state = htonl(data->state);
-        data->sync_type = htonl(data->sync_type);
-    }
-    else {
-        data->peer_id = ntohl(data->peer_id);
-        data->state = ntohl(data->state);
-        data->sync_type = ntohl(data->sync_type);
-    }
-}
-
-/**
- *  Convert struct between network and host order
- *
- * @param[in] data - struct body
- * @param[in] oper - convertion direction
- *
- * @return 0 when successful, otherwise ERROR
- */
-static void
-net_order_port_oper_state_change_data(struct port_oper_state_change_data *data,
-                                      int oper)
-{
-    if (oper == MESSAGE_SENDING) {
-        data->mlag_id = htonl(data->mlag_id);
-        data->state = htonl(data->state);
-        data->is_ipl = htonl(data->is_ipl);
-        data->port_id = htonl(data->port_id);
-    }
-    else {
-        data->mlag_id = ntohl(data->mlag_id);
-        data->state = ntohl(data->state);
-        data->is_ipl = ntohl(data->is_ipl);
-        data->port_id = ntohl(data->port_id);
-    }
-}
-
-/*
- *  This function is called to handle network order for IBC message
- *
- * @param[in] payload_data - message body
- * @param[in] oper - on send or receive
- *
- * @return 0 when successful, otherwise ERROR
- */
-static int
-net_order_msg_handler(uint8_t *data, int oper)
-{
-    int err = 0;
-    uint16_t opcode;
-    struct port_global_state_event_data *port_states;
-    struct port_oper_state_change_data *oper_change;
-    struct peer_port_sync_message *port_sync;
-    struct peer_port_oper_sync_message *oper_sync;
-    struct sync_event_data *sync_event;
-
-    if (oper == MESSAGE_SENDING) {
-        opcode = *(uint16_t*)data;
-        *(uint16_t*)data = htons(opcode);
-    }
-    else {
-        opcode = ntohs(*(uint16_t*)data);
-        *(uint16_t*)data = opcode;
-    }
-
-    MLAG_LOG(MLAG_LOG_INFO,
-             "port_manager net_order_msg_handler: opcode=%d\n",
-             opcode);
+    case MLAG_PEER_PORTS_OPER_STATE_CHANGE:
+        oper_sync = (struct peer_port_oper_sync_message*)msg;
+        err = port_msg_size_check(opcode, oper_sync->port_num,
+                                  PEER_PORT_OPER_SYNC_MSG_SIZE(
+                                      oper_sync->port_num),
+                                  msg_len);
+        MLAG_BAIL_CHECK_NO_MSG(err);
 
-    switch (opcode) {
-    case MLAG_PORT_GLOBAL_STATE_EVENT:
-        port_states =
-            (struct port_global_state_event_data *) data;
-        net_order_port_global_state_event_data(port_states, oper);
-        break;
-    case MLAG_PORTS_SYNC_DATA:
-        port_sync = (struct peer_port_sync_message *) data;
-        net_order_peer_port_sync_message(port_sync, oper);
-        break;
-    case MLAG_PORTS_UPDATE_EVENT:
-        port_sync = (struct peer_port_sync_message *) data;
-        net_order_peer_port_sync_message(port_sync, oper);
-        break;
-    case MLAG_PORTS_OPER_UPDATE:
-        oper_sync = (struct peer_port_oper_sync_message*) data;
-        net_order_peer_port_oper_sync_message(oper_sync, oper);
-        break;
-    case MLAG_PORTS_OPER_SYNC_DONE:
-        /* Do nothing */
-        break;
-    case MLAG_PORTS_SYNC_FINISH_EVENT:
-        sync_event = (struct sync_event_data*) data;
-        net_order_sync_event_data(sync_event, oper);
-        break;
-    case MLAG_PEER_PORT_OPER_STATE_CHANGE:
-        oper_change =
-            (struct port_oper_state_change_data*) data;
-        net_order_port_oper_state_change_data(oper_change, oper);
+        err = port_manager_peer_ports_oper_state_change(oper_sync);
+        MLAG_BAIL_ERROR_MSG(err, "Failed handling peer ports oper change\n");
         break;
     default:
         /* Unknown opcode */
@@ -655,6 +558,7 @@ net_order_msg_handler(uint8_t *data, int oper)
                             opcode);
         break;
     }
+
 bail:
     return err;
 }
@@ -677,11 +581,18 @@ port_peer_oper_sync_msg_prepare(struct mlag_port_data *port_info, void *data)
 
     if (port_peer_state_get(port_info->peers_oper_state,
                             oper_sync->mlag_id) == TRUE) {
-        oper_sync->port_id[oper_sync->port_num] = port_info->port_id;
-        oper_sync->oper_state[oper_sync->port_num] = OES_PORT_UP;
+        /* Message is sized for the maximum number of ports */
+        if (oper_sync->port_num >= mlag_max_ports_get()) {
+            err = -ENOSPC;
+            MLAG_BAIL_ERROR_MSG(err, "Port [%lu] exceeds max ports\n",
+                                port_info->port_id);
+        }
+        oper_sync->ports[oper_sync->port_num].port_id = port_info->port_id;
+        oper_sync->ports[oper_sync->port_num].state = OES_PORT_UP;
         oper_sync->port_num++;
     }
 
+bail:
     return err;
 }
 
@@ -703,10 +614,17 @@ port_peer_sync_msg_prepare(struct mlag_port_data *port_info, void *data)
     sync_message->del_ports = FALSE;
     if (port_peer_state_get(port_info->peers_conf_state,
                             sync_message->mlag_id) == TRUE) {
+        /* Message is sized for the maximum number of ports */
+        if (sync_message->port_num >= mlag_max_ports_get()) {
+            err = -ENOSPC;
+            MLAG_BAIL_ERROR_MSG(err, "Port [%lu] exceeds max ports\n",
+                                port_info->port_id);
+        }
         sync_message->port_id[sync_message->port_num] = port_info->port_id;
         sync_message->port_num++;
     }
 
+bail:
     return err;
 }
 
@@ -747,6 +665,7 @@ create_new_port(unsigned long port_id, struct mlag_port_data **port_info)
     (*port_info)->port_master_fsm.port_id = port_id;
     (*port_info)->port_master_fsm.message_send_func =
         port_manager_message_send;
+    (*port_info)->port_master_fsm.oper_down_sent = FALSE;
     (*port_info)->port_id = port_id;
 
 bail:
@@ -902,12 +821,19 @@ send_port_conf_sync_message(int current_peer_id, int dest_mlag_id)
     int err = 0;
     int src_mlag_id;
     uint32_t i;
-    struct peer_port_sync_message sync_message;
+    uint32_t msg_size;
+    struct peer_port_sync_message *sync_message;
 
-    sync_message.port_num = 0;
-    sync_message.mlag_id = current_peer_id;
+    sync_message = (struct peer_port_sync_message *)
+                   cl_malloc(PEER_PORT_SYNC_MSG_SIZE(mlag_max_ports_get()));
+    if (sync_message == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate ports sync message\n");
+    }
+    sync_message->port_num = 0;
+    sync_message->mlag_id = current_peer_id;
 
-    err = port_db_foreach(port_peer_sync_msg_prepare, &sync_message);
+    err = port_db_foreach_read(port_peer_sync_msg_prepare, sync_message);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
     err = mlag_manager_db_mlag_id_from_local_index_get(current_peer_id,
@@ -915,28 +841,31 @@ send_port_conf_sync_message(int current_peer_id, int dest_mlag_id)
     MLAG_BAIL_ERROR_MSG(err,
                         "Failed getting mlag id for peer local index [%d]\n",
                         current_peer_id);
-    sync_message.mlag_id = src_mlag_id;
-    sync_message.del_ports = FALSE;
+    sync_message->mlag_id = src_mlag_id;
+    sync_message->del_ports = FALSE;
+    msg_size = PEER_PORT_SYNC_MSG_SIZE(sync_message->port_num);
     /* Send message to peer */
     MLAG_LOG(MLAG_LOG_DEBUG,
              "Peer [%d] ports sync send to peer (%u ports) msg_size [%u]:\n",
-             src_mlag_id, sync_message.port_num,
-             (uint32_t)sizeof(sync_message));
-    for (i = 0; i < sync_message.port_num; i++) {
-        MLAG_LOG(MLAG_LOG_DEBUG, "[%lu]\n ", sync_message.port_id[i]);
+             src_mlag_id, sync_message->port_num, msg_size);
+    for (i = 0; i < sync_message->port_num; i++) {
+        MLAG_LOG(MLAG_LOG_DEBUG, "[%lu]\n ", sync_message->port_id[i]);
     }
 
-    if (sync_message.port_num > 0) {
+    if (sync_message->port_num > 0) {
         /* Send to master logic sync message */
         err = port_manager_message_send(MLAG_PORTS_SYNC_DATA,
-                                        &sync_message,
-                                        sizeof(sync_message),
+                                        sync_message,
+                                        msg_size,
                                         dest_mlag_id,
                                         MASTER_LOGIC);
         MLAG_BAIL_ERROR_MSG(err, "Failed in sending ports sync message \n");
     }
 
 bail:
+    if (sync_message != NULL) {
+        cl_free(sync_message);
+    }
     return err;
 }
 
@@ -954,12 +883,20 @@ send_port_oper_sync_message(int current_peer_id, int dest_mlag_id)
     int err = 0;
     int src_mlag_id;
     uint32_t i;
-    struct peer_port_oper_sync_message oper_sync;
+    uint32_t msg_size;
+    struct peer_port_oper_sync_message *oper_sync;
 
-    oper_sync.port_num = 0;
-    oper_sync.mlag_id = current_peer_id;
+    oper_sync = (struct peer_port_oper_sync_message *)
+                cl_malloc(PEER_PORT_OPER_SYNC_MSG_SIZE(mlag_max_ports_get()));
+    if (oper_sync == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Failed to allocate ports oper sync message\n");
+    }
+    oper_sync->port_num = 0;
+    oper_sync->mlag_id = current_peer_id;
 
-    err = port_db_foreach(port_peer_oper_sync_msg_prepare, &oper_sync);
+    err = port_db_foreach_read(port_peer_oper_sync_msg_prepare, oper_sync);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
     err = mlag_manager_db_mlag_id_from_local_index_get(current_peer_id,
@@ -967,22 +904,23 @@ send_port_oper_sync_message(int current_peer_id, int dest_mlag_id)
     MLAG_BAIL_ERROR_MSG(err,
                         "Failed getting mlag id for peer local index [%d]\n",
                         current_peer_id);
-    oper_sync.mlag_id = src_mlag_id;
+    oper_sync->mlag_id = src_mlag_id;
+    msg_size = PEER_PORT_OPER_SYNC_MSG_SIZE(oper_sync->port_num);
 
     /* Send message to peer */
     MLAG_LOG(MLAG_LOG_DEBUG,
              "Peer [%d] ports oper sync send to peer (%u ports) msg_size [%u]:\n",
-             src_mlag_id, oper_sync.port_num, (uint32_t)sizeof(oper_sync));
-    for (i = 0; i < oper_sync.port_num; i++) {
+             src_mlag_id, oper_sync->port_num, msg_size);
+    for (i = 0; i < oper_sync->port_num; i++) {
         MLAG_LOG(MLAG_LOG_DEBUG, "port [%lu] oper [%d]\n ",
-                 oper_sync.port_id[i], oper_sync.oper_state[i]);
+                 oper_sync->ports[i].port_id, oper_sync->ports[i].state);
     }
 
-    if (oper_sync.port_num > 0) {
+    if (oper_sync->port_num > 0) {
         /* Send to master logic sync message */
         err = port_manager_message_send(MLAG_PORTS_OPER_UPDATE,
-                                        &oper_sync,
-                                        sizeof(oper_sync),
+                                        oper_sync,
+                                        msg_size,
                                         dest_mlag_id,
                                         MASTER_LOGIC);
         MLAG_BAIL_ERROR_MSG(err,
@@ -990,6 +928,9 @@ send_port_oper_sync_message(int current_peer_id, int dest_mlag_id)
     }
 
 bail:
+    if (oper_sync != NULL) {
+        cl_free(oper_sync);
+    }
     return err;
 }
 
@@ -1068,6 +1009,9 @@ port_manager_port_sync(struct peer_port_sync_message *port_sync)
 
         err = port_db_peer_state_set(peer_local_id, PM_PEER_TX_ENABLED);
         MLAG_BAIL_ERROR_MSG(err, "Failed setting peer state\n");
+
+        err = port_failover_plan_build(IS_MASTER());
+        MLAG_BAIL_CHECK_NO_MSG(err);
     }
     if (current_role != SLAVE) {
         /* Notify end of ports sync */
@@ -1117,6 +1061,7 @@ port_manager_log_verbosity_set(mlag_verbosity_t verbosity)
 {
     LOG_VAR_NAME(__MODULE__) = verbosity;
     port_db_log_verbosity_set(verbosity);
+    port_failover_log_verbosity_set(verbosity);
     port_peer_remote_log_verbosity_set(verbosity);
     port_peer_local_log_verbosity_set(verbosity);
     port_master_logic_log_verbosity_set(verbosity);
@@ -1148,9 +1093,30 @@ port_manager_init(insert_to_command_db_func insert_msgs_cb)
     err = insert_msgs_cb(port_manager_ibc_msgs);
     MLAG_BAIL_ERROR(err);
 
+    err = mlag_wire_msgs_register(port_manager_wire_msgs,
+                                  NUM_ELEMS(port_manager_wire_msgs));
+    MLAG_BAIL_ERROR(err);
+
     err = port_db_init();
     MLAG_BAIL_ERROR(err);
 
+    peer_down_ports_max = MLAG_MAX_PEERS * mlag_max_ports_get();
+    peer_down_ports = (unsigned long *)
+                      cl_malloc(peer_down_ports_max * sizeof(unsigned long));
+    if (peer_down_ports == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate peer down ports\n");
+    }
+
+    err = port_master_logic_batch_init();
+    MLAG_BAIL_ERROR(err);
+
+    err = port_failover_init();
+    MLAG_BAIL_ERROR(err);
+
+    MLAG_LOG(MLAG_LOG_NOTICE, "Port manager max ports [%u]\n",
+             mlag_max_ports_get());
+
 bail:
     return err;
 }
@@ -1165,6 +1131,15 @@ port_manager_deinit(void)
 {
     int err = 0;
 
+    if (peer_down_ports != NULL) {
+        cl_free(peer_down_ports);
+        peer_down_ports = NULL;
+    }
+
+    port_master_logic_batch_deinit();
+
+    port_failover_deinit();
+
     err = port_db_deinit();
     MLAG_BAIL_ERROR(err);
 
@@ -1280,12 +1255,12 @@ port_manager_mlag_ports_add(unsigned long *mlag_ports, int port_num)
 {
     int err = 0;
     int i, peer_id;
-    struct peer_port_sync_message port_sync;
+    struct peer_port_sync_message *port_sync = NULL;
     struct mlag_port_data *port_info;
     struct mlag_master_election_status me_status;
 
     ASSERT(mlag_ports != NULL);
-    ASSERT(port_num < MLAG_MAX_PORTS);
+    ASSERT((port_num >= 0) && ((uint32_t)port_num <= mlag_max_ports_get()));
 
     for (i = 0; i < port_num; i++) {
         err = port_db_entry_lock(mlag_ports[i], &port_info);
@@ -1319,22 +1294,33 @@ port_manager_mlag_ports_add(unsigned long *mlag_ports, int port_num)
         err = mlag_master_election_get_status(&me_status);
         MLAG_BAIL_ERROR_MSG(err, "Failed getting ME status\n");
 
+        port_sync = (struct peer_port_sync_message *)
+                    cl_malloc(PEER_PORT_SYNC_MSG_SIZE(port_num));
+        if (port_sync == NULL) {
+            err = -ENOMEM;
+            MLAG_BAIL_ERROR_MSG(err, "Failed to allocate ports sync message\n");
+        }
+
         /* If master is up then send peer start */
-        port_sync.mlag_id = me_status.my_peer_id;
-        port_sync.port_num = port_num;
-        port_sync.del_ports = FALSE;
+        port_sync->mlag_id = me_status.my_peer_id;
+        port_sync->port_num = port_num;
+        port_sync->del_ports = FALSE;
         for (i = 0; i < port_num; i++) {
-            port_sync.port_id[i] = mlag_ports[i];
+            port_sync->port_id[i] = mlag_ports[i];
         }
 
         /* Notify master on new ports */
         err = port_manager_message_send(MLAG_PORTS_UPDATE_EVENT,
-                                        &port_sync, sizeof(port_sync),
-                                        port_sync.mlag_id, PEER_MANAGER);
+                                        port_sync,
+                                        PEER_PORT_SYNC_MSG_SIZE(port_num),
+                                        port_sync->mlag_id, PEER_MANAGER);
         MLAG_BAIL_ERROR_MSG(err, "Failed in sending ports sync message \n");
     }
 
 bail:
+    if (port_sync != NULL) {
+        cl_free(port_sync);
+    }
     return err;
 }
 
@@ -1365,23 +1351,21 @@ bail:
     return err;
 }
 
-/**
- *  This function deletes configured local port
+/*
+ *  This function removes a configured local port from the local peer
+ *  logic
  *
  * @param[in] mlag_port - port to delete
  *
  * @return 0 if operation completes successfully.
+ * @return -ENOENT if port is not configured
  */
-int
-port_manager_mlag_port_delete(unsigned long mlag_port)
+static int
+local_port_delete(unsigned long mlag_port)
 {
     int err = 0;
     int peer_id;
-    int port_delete_status = 1;
-    uint32_t states;
-    struct peer_port_sync_message port_sync;
     struct mlag_port_data *port_info;
-    struct mlag_master_election_status me_status;
 
     MLAG_LOG(MLAG_LOG_NOTICE,
              "Delete port [%lu] procedure started\n", mlag_port);
@@ -1391,8 +1375,6 @@ port_manager_mlag_port_delete(unsigned long mlag_port)
         /* ignore port that was not found */
         MLAG_LOG(MLAG_LOG_NOTICE,
                  "mlag port %lu is not found in db\n", mlag_port);
-        port_delete_status = 0;
-        err = 0;
         goto bail;
     }
     MLAG_BAIL_ERROR_MSG(err, "Failed in getting port [%lu]\n",
@@ -1414,48 +1396,153 @@ port_manager_mlag_port_delete(unsigned long mlag_port)
     MLAG_BAIL_ERROR_MSG(err,
                         "Failed to unlock port [%lu]\n", mlag_port);
 
-    if (started == TRUE) {
-        /* Notify master logic on deleted port */
+bail:
+    return err;
+}
+
+/*
+ *  This function removes a deleted port from DB when no master logic
+ *  is present to do it
+ *
+ * @param[in] mlag_port - deleted port
+ *
+ * @return 0 if operation completes successfully.
+ */
+static int
+local_port_db_remove(unsigned long mlag_port)
+{
+    int err = 0;
+    uint32_t states;
+
+    err = port_db_peer_conf_state_vector_get(mlag_port, &states);
+    MLAG_BAIL_ERROR_MSG(err,
+                        "Failed to get peer conf state vector for port [%lu]\n",
+                        mlag_port);
+    if (states == 0) {
+        /* Delete port from DB */
+        err = port_db_entry_delete(mlag_port);
+        MLAG_BAIL_ERROR_MSG(err,
+                            "Failed to remove port [%lu] from DB\n",
+                            mlag_port);
+    }
+
+bail:
+    return err;
+}
+
+/**
+ *  This function deletes configured local port
+ *
+ * @param[in] mlag_port - port to delete
+ *
+ * @return 0 if operation completes successfully.
+ */
+int
+port_manager_mlag_port_delete(unsigned long mlag_port)
+{
+    return port_manager_mlag_ports_delete(&mlag_port, 1);
+}
+
+/**
+ *  This function deletes configured local ports. Master logic is
+ *  notified on all deleted ports in one message, a deleted event is
+ *  sent for each port.
+ *
+ * @param[in] mlag_ports - array of ports to delete
+ * @param[in] port_num - number of ports to delete
+ *
+ * @return 0 if operation completes successfully.
+ */
+int
+port_manager_mlag_ports_delete(unsigned long *mlag_ports, int port_num)
+{
+    int err = 0;
+    int ports_err = 0;
+    int i, status;
+    int *port_status = NULL;
+    struct peer_port_sync_message *port_sync = NULL;
+    struct mlag_master_election_status me_status;
+
+    ASSERT(mlag_ports != NULL);
+    ASSERT((port_num >= 0) && ((uint32_t)port_num <= mlag_max_ports_get()));
+
+    if (port_num == 0) {
+        goto bail;
+    }
+
+    port_status = (int *)cl_malloc(port_num * sizeof(int));
+    port_sync = (struct peer_port_sync_message *)
+                cl_malloc(PEER_PORT_SYNC_MSG_SIZE(port_num));
+    if ((port_status == NULL) || (port_sync == NULL)) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate ports delete data\n");
+    }
+
+    port_sync->port_num = 0;
+    for (i = 0; i < port_num; i++) {
+        port_status[i] = 0;
+        err = local_port_delete(mlag_ports[i]);
+        if (err == 0) {
+            port_status[i] = 1;
+            port_sync->port_id[port_sync->port_num++] = mlag_ports[i];
+        }
+        else if ((err != -ENOENT) && (ports_err == 0)) {
+            ports_err = err;
+        }
+    }
+    err = 0;
+
+    if ((started == TRUE) && (port_sync->port_num > 0)) {
+        /* Notify master logic on deleted ports */
         err = mlag_master_election_get_status(&me_status);
         MLAG_BAIL_ERROR_MSG(err, "Failed getting ME status\n");
 
-        /* If master is up then send peer start */
-        port_sync.mlag_id = me_status.my_peer_id;
-        port_sync.port_num = 1;
-        port_sync.del_ports = TRUE;
-        port_sync.port_id[0] = mlag_port;
+        port_sync->mlag_id = me_status.my_peer_id;
+        port_sync->del_ports = TRUE;
 
         /* Notify master on deleted ports */
         err = port_manager_message_send(MLAG_PORTS_UPDATE_EVENT,
-                                        &port_sync, sizeof(port_sync),
-                                        port_sync.mlag_id, PEER_MANAGER);
+                                        port_sync,
+                                        PEER_PORT_SYNC_MSG_SIZE(
+                                            port_sync->port_num),
+                                        port_sync->mlag_id, PEER_MANAGER);
         MLAG_BAIL_ERROR_MSG(err, "Failed in sending ports sync message\n");
     }
 
     /* When no master logic present we need to delete ports ourselves */
     if ((started == FALSE) || (current_role == SLAVE)) {
-        err = port_db_peer_conf_state_vector_get(mlag_port,
-                                                 &states);
-        MLAG_BAIL_ERROR_MSG(err,
-                            "Failed to get peer conf state vector for port [%lu]\n",
-                            mlag_port);
-        if (states == 0) {
-            /* Delete port from DB */
-            err = port_db_entry_delete(mlag_port);
-            MLAG_BAIL_ERROR_MSG(err,
-                                "Failed to remove port [%lu] from DB\n",
-                                mlag_port);
+        for (i = 0; i < port_num; i++) {
+            if (port_status[i] == 0) {
+                continue;
+            }
+            err = local_port_db_remove(mlag_ports[i]);
+            if (err) {
+                port_status[i] = 0;
+                if (ports_err == 0) {
+                    ports_err = err;
+                }
+            }
         }
+        err = 0;
     }
 
 bail:
-    if (err) {
-        port_delete_status = 0;
+    for (i = 0; i < port_num; i++) {
+        status = ((err == 0) && (port_status != NULL)) ? port_status[i] : 0;
+        MLAG_LOG(MLAG_LOG_NOTICE,
+                 "Sending port deleted event for port=%lu status=%d\n",
+                 mlag_ports[i], status);
+        send_port_deleted_event(mlag_ports[i], status);
+    }
+    if (err == 0) {
+        err = ports_err;
+    }
+    if (port_status != NULL) {
+        cl_free(port_status);
+    }
+    if (port_sync != NULL) {
+        cl_free(port_sync);
     }
-    MLAG_LOG(MLAG_LOG_NOTICE,
-             "Sending port deleted event for port=%lu status=%d\n",
-             mlag_port, port_delete_status);
-    send_port_deleted_event(mlag_port, port_delete_status);
     return err;
 }
 
@@ -1476,7 +1563,7 @@ port_manager_peer_mlag_ports_add(int peer_id, unsigned long *mlag_ports,
     struct mlag_port_data *port_info;
 
     ASSERT(mlag_ports != NULL);
-    ASSERT(port_num < MLAG_MAX_PORTS);
+    ASSERT((port_num >= 0) && ((uint32_t)port_num <= mlag_max_ports_get()));
     ASSERT(peer_id < MLAG_MAX_PEERS);
 
     for (i = 0; i < port_num; i++) {
@@ -1528,7 +1615,7 @@ port_manager_peer_mlag_ports_delete(int peer_id, unsigned long *mlag_ports,
     struct mlag_port_data *port_info;
 
     ASSERT(mlag_ports != NULL);
-    ASSERT(port_num < MLAG_MAX_PORTS);
+    ASSERT((port_num >= 0) && ((uint32_t)port_num <= mlag_max_ports_get()));
     ASSERT(peer_id < MLAG_MAX_PEERS);
 
     for (i = 0; i < port_num; i++) {
@@ -1601,105 +1688,118 @@ bail:
  *  Global oper state is set by the MLAG master port logic
  *  Down means that there are no active links for the mlag port
  *
- * @param[in] mlag_ports - array of ports
- * @param[in] new_states - port states, expected the same length
- *       as ports array
- * @param[in] port_num - number of ports in the arrays above
+ * @param[in] ports - array of port and global state pairs
+ * @param[in] port_num - number of entries in the array above
  *
  * @return 0 if operation completes successfully.
  */
 int
-port_manager_global_oper_state_set(unsigned long *mlag_ports, int *oper_states,
+port_manager_global_oper_state_set(struct port_state_entry *ports,
                                    int port_num)
 {
     int i, err = 0;
     struct mlag_port_data *port_info;
+    struct mlag_notification notify;
 
-    ASSERT(mlag_ports != NULL);
-    ASSERT(oper_states != NULL);
-    ASSERT(port_num < MLAG_MAX_PORTS);
+    ASSERT(ports != NULL);
+    ASSERT((port_num >= 0) && ((uint32_t)port_num <= mlag_max_ports_get()));
 
     if (started == FALSE) {
         goto bail;
     }
 
+    SAFE_MEMSET(&notify, 0);
+    notify.notification_type = MLAG_NOTIFY_PORT_OPER_STATE_CHANGE;
+
     for (i = 0; i < port_num; i++) {
-        err = port_db_entry_lock(mlag_ports[i], &port_info);
+        err = port_db_entry_lock(ports[i].port_id, &port_info);
         /* Ignore If port not found */
         if (err == -ENOENT) {
             err = 0;
             continue;
         }
         MLAG_BAIL_ERROR_MSG(err, " port [%lu] not found in DB\n",
-                            mlag_ports[i]);
+                            ports[i].port_id);
 
         /* Update logic */
-        switch (oper_states[i]) {
+        switch (ports[i].state) {
         case MLAG_PORT_GLOBAL_DISABLED:
             MLAG_LOG(MLAG_LOG_NOTICE,
-                     "Port [%lu] global state is [Disabled]\n", mlag_ports[i]);
-            err = port_admin_state_set(port_info, oper_states[i]);
+                     "Port [%lu] global state is [Disabled]\n",
+                     ports[i].port_id);
+            err = port_admin_state_set(port_info, ports[i].state);
             if (err) {
-                port_db_entry_unlock(mlag_ports[i]);
+                port_db_entry_unlock(ports[i].port_id);
                 MLAG_BAIL_ERROR_MSG(err,
                                     "Failed in port [%lu] global disable \n",
-                                    mlag_ports[i]);
+                                    ports[i].port_id);
             }
             break;
         case MLAG_PORT_GLOBAL_DOWN:
             MLAG_LOG(MLAG_LOG_NOTICE,
-                     "Port [%lu] global state is [Down]\n", mlag_ports[i]);
+                     "Port [%lu] global state is [Down]\n",
+                     ports[i].port_id);
             err = port_peer_local_port_global_down(&port_info->peer_local_fsm);
             if (err) {
-                port_db_entry_unlock(mlag_ports[i]);
+                port_db_entry_unlock(ports[i].port_id);
                 MLAG_BAIL_ERROR_MSG(err,
                                     "Failed in port [%lu] global down in peer local FSM\n",
-                                    mlag_ports[i]);
+                                    ports[i].port_id);
             }
             err =
                 port_peer_remote_port_global_down(&port_info->peer_remote_fsm);
             if (err) {
-                port_db_entry_unlock(mlag_ports[i]);
+                port_db_entry_unlock(ports[i].port_id);
                 MLAG_BAIL_ERROR_MSG(err,
                                     "Failed in port [%lu] global down to peer remote FSM\n",
-                                    mlag_ports[i]);
+                                    ports[i].port_id);
             }
             break;
         case MLAG_PORT_GLOBAL_ENABLED:
             MLAG_LOG(MLAG_LOG_NOTICE,
-                     "Port [%lu] global state is [Enabled]\n", mlag_ports[i]);
-            err = port_admin_state_set(port_info, oper_states[i]);
+                     "Port [%lu] global state is [Enabled]\n",
+                     ports[i].port_id);
+            err = port_admin_state_set(port_info, ports[i].state);
             if (err) {
-                port_db_entry_unlock(mlag_ports[i]);
+                port_db_entry_unlock(ports[i].port_id);
                 MLAG_BAIL_ERROR_MSG(err,
                                     "Failed in port [%lu] global enable \n",
-                                    mlag_ports[i]);
+                                    ports[i].port_id);
             }
             break;
         case MLAG_PORT_GLOBAL_UP:
             MLAG_LOG(MLAG_LOG_NOTICE,
-                     "Port [%lu] global state is [Up]\n", mlag_ports[i]);
+                     "Port [%lu] global state is [Up]\n",
+                     ports[i].port_id);
             err = port_peer_local_port_global_up(&port_info->peer_local_fsm);
             if (err) {
-                port_db_entry_unlock(mlag_ports[i]);
+                port_db_entry_unlock(ports[i].port_id);
                 MLAG_BAIL_ERROR_MSG(err,
                                     "Failed in port [%lu] global up in peer local FSM\n",
-                                    mlag_ports[i]);
+                                    ports[i].port_id);
             }
             err = port_peer_remote_port_global_en(&port_info->peer_remote_fsm);
             if (err) {
-                port_db_entry_unlock(mlag_ports[i]);
+                port_db_entry_unlock(ports[i].port_id);
                 MLAG_BAIL_ERROR_MSG(err,
                                     "Failed in port [%lu] global enable to peer remote FSM\n",
-                                    mlag_ports[i]);
+                                    ports[i].port_id);
             }
             break;
         default:
             break;
         }
-        err = port_db_entry_unlock(mlag_ports[i]);
+        notify.notification_info.port_state.port_id = ports[i].port_id;
+        notify.notification_info.port_state.port_oper_state =
+            port_state_get(port_info);
+        err = port_db_entry_unlock(ports[i].port_id);
         MLAG_BAIL_ERROR(err);
+
+        err = mlag_notify(&notify);
+        MLAG_BAIL_ERROR_MSG(err, "Failed to notify port [%lu] state\n",
+                            ports[i].port_id);
     }
+    mlag_state_publisher_changed();
 bail:
     return err;
 }
@@ -1725,7 +1825,7 @@ port_manager_port_admin_state_set(unsigned long *mlag_ports, int *admin_states,
 
     ASSERT(mlag_ports != NULL);
     ASSERT(admin_states != NULL);
-    ASSERT(port_num < MLAG_MAX_PORTS);
+    ASSERT((port_num >= 0) && ((uint32_t)port_num <= mlag_max_ports_get()));
 
     if (started == FALSE) {
         goto bail;
@@ -1913,6 +2013,167 @@ bail:
     return err;
 }
 
+/**
+ *  This function handles a batch of local port oper state changes.
+ *  All ports are updated in one pass and a single
+ *  MLAG_PEER_PORTS_OPER_STATE_CHANGE is sent to the master.
+ *
+ * @param[in] ports - (port, OES state) pairs
+ * @param[in] port_num - number of ports
+ *
+ * @return 0 if operation completes successfully.
+ */
+int
+port_manager_local_ports_oper_state_set(struct port_state_entry *ports,
+                                        int port_num)
+{
+    int err = 0;
+    int idx;
+    int is_up;
+    unsigned long mlag_port;
+    struct mlag_port_data *port_info;
+    struct peer_port_oper_sync_message *oper_sync = NULL;
+    struct mlag_master_election_status me_status;
+
+    if ((started == FALSE) || (port_num == 0)) {
+        goto bail;
+    }
+    ASSERT((port_num > 0) && ((uint32_t)port_num <= mlag_max_ports_get()));
+
+    oper_sync = (struct peer_port_oper_sync_message *)
+                cl_malloc(PEER_PORT_OPER_SYNC_MSG_SIZE(port_num));
+    if (oper_sync == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate ports oper message\n");
+    }
+    oper_sync->port_num = 0;
+
+    for (idx = 0; idx < port_num; idx++) {
+        mlag_port = ports[idx].port_id;
+        is_up = (ports[idx].state == OES_PORT_UP);
+
+        err = port_db_entry_lock(mlag_port, &port_info);
+        if (err == -ENOENT) {
+            /* Not an mlag port, nothing to notify */
+            MLAG_LOG(MLAG_LOG_DEBUG, "port [%lu] not found in DB\n",
+                     mlag_port);
+            err = 0;
+            continue;
+        }
+        MLAG_BAIL_ERROR_MSG(err, "Failed to lock port [%lu]\n", mlag_port);
+
+        /* Update DB */
+        port_peer_state_set(&(port_info->peers_oper_state),
+                            mlag_manager_db_local_peer_id_get(), is_up);
+
+        /* Update logic */
+        if (is_up) {
+            err = port_peer_local_port_up_ev(&port_info->peer_local_fsm);
+        }
+        else {
+            err = port_peer_local_port_down_ev(&port_info->peer_local_fsm);
+        }
+        if (err) {
+            port_db_entry_unlock(mlag_port);
+            MLAG_BAIL_ERROR_MSG(err,
+                                "Failed in port [%lu] oper state in peer local FSM\n",
+                                mlag_port);
+        }
+
+        err = port_db_entry_unlock(mlag_port);
+        MLAG_BAIL_ERROR(err);
+
+        oper_sync->ports[oper_sync->port_num].port_id = mlag_port;
+        oper_sync->ports[oper_sync->port_num].state =
+            (is_up ? MLAG_PORT_OPER_UP : MLAG_PORT_OPER_DOWN);
+        oper_sync->port_num++;
+    }
+
+    if (oper_sync->port_num == 0) {
+        goto bail;
+    }
+
+    MLAG_LOG(MLAG_LOG_DEBUG, "[%u] ports local state changed\n",
+             oper_sync->port_num);
+
+    /* Notify master logic on new states */
+    err = mlag_master_election_get_status(&me_status);
+    MLAG_BAIL_ERROR_MSG(err, "Failed getting ME status\n");
+
+    oper_sync->mlag_id = me_status.my_peer_id;
+
+    err = port_manager_message_send(MLAG_PEER_PORTS_OPER_STATE_CHANGE,
+                                    oper_sync,
+                                    PEER_PORT_OPER_SYNC_MSG_SIZE(
+                                        oper_sync->port_num),
+                                    oper_sync->mlag_id, PEER_MANAGER);
+    MLAG_BAIL_ERROR_MSG(err,
+                        "Failed in sending ports oper state message \n");
+
+bail:
+    if (oper_sync != NULL) {
+        cl_free(oper_sync);
+    }
+    return err;
+}
+
+/**
+ *  This function handles a batch of peer port oper state changes.
+ *  Resulting global states are sent as one aggregated message.
+ *
+ * @param[in] oper_sync - peer ports oper state message
+ *
+ * @return 0 if operation completes successfully.
+ */
+int
+port_manager_peer_ports_oper_state_change(
+    struct peer_port_oper_sync_message *oper_sync)
+{
+    int err = 0;
+    int batch_err;
+    uint32_t idx;
+    int local_peer_index;
+
+    if (started == FALSE) {
+        goto bail;
+    }
+
+    err = mlag_manager_db_local_index_from_mlag_id_get(oper_sync->mlag_id,
+                                                       &local_peer_index);
+    MLAG_BAIL_ERROR_MSG(err, "Failed getting local index from mlag id [%d]",
+                        oper_sync->mlag_id);
+
+    MLAG_LOG(MLAG_LOG_NOTICE, "Peer [%d] oper change of [%u] ports\n",
+             oper_sync->mlag_id, oper_sync->port_num);
+
+    port_master_logic_batch_start();
+    for (idx = 0; idx < oper_sync->port_num; idx++) {
+        if (oper_sync->ports[idx].state == MLAG_PORT_OPER_UP) {
+            err = port_manager_peer_port_up(local_peer_index,
+                                            oper_sync->ports[idx].port_id);
+        }
+        else {
+            err = port_manager_peer_port_down(local_peer_index,
+                                              oper_sync->ports[idx].port_id);
+        }
+        if (err == -ENOENT) {
+            /* Port deleted meanwhile */
+            err = 0;
+        }
+        if (err) {
+            break;
+        }
+    }
+    batch_err = port_master_logic_batch_end();
+    MLAG_BAIL_ERROR_MSG(err, "Failed handling peer port [%lu] oper change",
+                        oper_sync->ports[idx].port_id);
+    err = batch_err;
+    MLAG_BAIL_ERROR_MSG(err, "Failed sending ports global state\n");
+
+bail:
+    return err;
+}
+
 /*
  *  This function handles peer down notification logic.
  *
@@ -1939,6 +2200,7 @@ port_peer_down_event_handle(struct mlag_port_data *port_info, void *data)
 
     if (states == 0) {
         /* Mark for deletion */
+        ASSERT(peer_down_data->port_num < peer_down_data->port_max);
         peer_down_data->ports_to_delete[peer_down_data->port_num] =
             port_info->port_id;
         peer_down_data->port_num++;
@@ -2109,7 +2371,9 @@ static int
 port_peer_down(int mlag_id)
 {
     int err = 0;
+    int batch_err, plan_err;
     int i, peer_id;
+    int failover_started = FALSE;
     struct peer_down_ports_data peer_down_data;
 
     ASSERT(mlag_id < MLAG_MAX_PEERS);
@@ -2127,11 +2391,26 @@ port_peer_down(int mlag_id)
     err = port_db_peer_state_set(peer_id, PM_PEER_DOWN);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
+    /* Redirect traffic first using the precomputed plan, the FSMs
+     * below then skip what the plan already applied. From here on
+     * every exit ends the failover and rebuilds the plan.
+     */
+    failover_started = TRUE;
+    err = port_failover_start(peer_id);
+    MLAG_BAIL_ERROR_MSG(err, "Failed applying peer [%d] failover plan\n",
+                        peer_id);
+
     peer_down_data.peer_id = peer_id;
     peer_down_data.port_num = 0;
+    peer_down_data.port_max = peer_down_ports_max;
+    peer_down_data.ports_to_delete = peer_down_ports;
 
+    port_master_logic_batch_start();
     err = port_db_foreach(port_peer_down_event_handle, &peer_down_data);
+    batch_err = port_master_logic_batch_end();
     MLAG_BAIL_CHECK_NO_MSG(err);
+    err = batch_err;
+    MLAG_BAIL_ERROR_MSG(err, "Failed sending ports global state\n");
 
     /* clear ports that are not configured in any peer */
     for (i = 0; i < peer_down_data.port_num; i++) {
@@ -2143,6 +2422,17 @@ port_peer_down(int mlag_id)
     }
 
 bail:
+    if (failover_started) {
+        port_failover_end(peer_id);
+        plan_err = port_failover_plan_build(IS_MASTER());
+        if (plan_err) {
+            MLAG_LOG(MLAG_LOG_ERROR,
+                     "Failed building failover plan, err [%d]\n", plan_err);
+            if (err == 0) {
+                err = plan_err;
+            }
+        }
+    }
     return err;
 }
 
@@ -2304,6 +2594,9 @@ port_manager_peer_enable(int mlag_peer_id)
     err = port_db_foreach(port_peer_enable_event_handle, &peer_id);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
+    err = port_failover_plan_build(IS_MASTER());
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
 bail:
     return err;
 }
@@ -2323,7 +2616,8 @@ port_manager_peer_start(int mlag_peer_id)
     int err = 0;
     int peer_id;
     uint32_t i;
-    struct peer_port_sync_message sync_message;
+    uint32_t msg_size;
+    struct peer_port_sync_message *sync_message = NULL;
 
     ASSERT(mlag_peer_id < MLAG_MAX_PEERS);
 
@@ -2345,30 +2639,39 @@ port_manager_peer_start(int mlag_peer_id)
     MLAG_LOG(MLAG_LOG_DEBUG, "Peer start mlag_id [%d] peer_id [%d]\n",
              mlag_peer_id, peer_id);
 
-    sync_message.port_num = 0;
-    sync_message.mlag_id = peer_id;
+    sync_message = (struct peer_port_sync_message *)
+                   cl_malloc(PEER_PORT_SYNC_MSG_SIZE(mlag_max_ports_get()));
+    if (sync_message == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate ports sync message\n");
+    }
+    sync_message->port_num = 0;
+    sync_message->mlag_id = peer_id;
 
-    err = port_db_foreach(port_peer_sync_msg_prepare, &sync_message);
+    err = port_db_foreach_read(port_peer_sync_msg_prepare, sync_message);
     MLAG_BAIL_CHECK_NO_MSG(err);
 
-    sync_message.mlag_id = mlag_peer_id;
-    sync_message.del_ports = FALSE;
+    sync_message->mlag_id = mlag_peer_id;
+    sync_message->del_ports = FALSE;
+    msg_size = PEER_PORT_SYNC_MSG_SIZE(sync_message->port_num);
     /* Send message to master */
     MLAG_LOG(MLAG_LOG_DEBUG,
              "Port peer [%d] sync send to master (%u ports) msg_size [%u]:\n",
-             sync_message.mlag_id, sync_message.port_num,
-             (uint32_t) sizeof(sync_message));
-    for (i = 0; i < sync_message.port_num; i++) {
-        MLAG_LOG(MLAG_LOG_DEBUG, "[%lu]\n ", sync_message.port_id[i]);
+             sync_message->mlag_id, sync_message->port_num, msg_size);
+    for (i = 0; i < sync_message->port_num; i++) {
+        MLAG_LOG(MLAG_LOG_DEBUG, "[%lu]\n ", sync_message->port_id[i]);
     }
 
     /* Send to master logic sync message */
     err = port_manager_message_send(MLAG_PORTS_SYNC_DATA,
-                                    &sync_message, sizeof(sync_message),
+                                    sync_message, msg_size,
                                     mlag_peer_id, PEER_MANAGER);
     MLAG_BAIL_ERROR_MSG(err, "Failed in sending ports sync message \n");
 
 bail:
+    if (sync_message != NULL) {
+        cl_free(sync_message);
+    }
     return err;
 }
 
@@ -2415,6 +2718,9 @@ port_manager_role_change(int new_role)
         MLAG_BAIL_ERROR_MSG(err, "Failed starting port manager module\n");
     }
 
+    err = port_failover_plan_build(IS_MASTER());
+    MLAG_BAIL_ERROR_MSG(err, "Failed building failover plan\n");
+
 bail:
     return err;
 }
@@ -2516,7 +2822,7 @@ port_manager_mlag_ports_get(unsigned long *mlag_ports,
     data.port_num = 0;
     *port_num = 0;
 
-    err = port_db_foreach(ports_state_update, &data);
+    err = port_db_foreach_read(ports_state_update, &data);
     MLAG_BAIL_CHECK_NO_MSG(err);
     *port_num = data.port_num;
 
@@ -2544,8 +2850,8 @@ port_manager_mlag_port_get(unsigned long port_id,
 
     ASSERT(port_info != NULL);
 
-    err = port_db_entry_lock(port_id,
-                             &port_entry_info);
+    err = port_db_entry_read_lock(port_id,
+                                  &port_entry_info);
     if (err) {
         MLAG_LOG(MLAG_LOG_ERROR, "Failed gets port information\n");
 
@@ -2752,7 +3058,9 @@ port_manager_dump(void (*dump_cb)(const char *, ...))
     DUMP_OR_LOG("---------------------------\n");
     DUMP_OR_LOG("Peers states [0x%x]\n", peer_states);
     DUMP_OR_LOG("---------------------------\n");
-    err = port_db_foreach(dump_ports_info, dump_cb);
+    port_failover_dump(dump_cb);
+    DUMP_OR_LOG("---------------------------\n");
+    err = port_db_foreach_read(dump_ports_info, dump_cb);
     MLAG_BAIL_ERROR(err);
 
 bail:
@@ -2803,7 +3111,7 @@ port_manager_port_mode_get(unsigned long port_id,
 
     ASSERT(port_mode != NULL);
 
-    err = port_db_entry_lock(port_id, &port_info);
+    err = port_db_entry_read_lock(port_id, &port_info);
     MLAG_BAIL_ERROR_MSG(err, "port [%lu] not found\n", port_id);
 
     *port_mode = port_info->port_mode;
@@ -43,8 +43,6 @@
 static int
 rcv_msg_handler(uint8_t *payload_data);
 
-static int
-net_order_msg_handler(uint8_t *data, int oper);
 /************************************************
  *  Local Macros
  ***********************************************/
@@ -66,7 +64,8 @@ struct ports_get_data {
 struct peer_down_ports_data {
     int peer_id;
     int port_num;
-    unsigned long ports_to_delete[MLAG_MAX_PORTS];
+    int port_max;
+    unsigned long *ports_to_delete; /* port_max entries */
 };
 
 #endif
@@ -83,6 +82,13 @@ struct peer_down_ports_data {
  *  Macros
  ***********************************************/
 
+/* Size of peer port messages carrying the given number of ports */
+#define PEER_PORT_SYNC_MSG_SIZE(num)                    \
+    (sizeof(struct peer_port_sync_message) +            \
+     ((num) * sizeof(uint64_t)))
+#define PEER_PORT_OPER_SYNC_MSG_SIZE(num)               \
+    (sizeof(struct peer_port_oper_sync_message) +       \
+     ((num) * sizeof(struct port_state_entry)))
 
 /************************************************
  *  Type definitions
@@ -119,16 +125,15 @@ struct __attribute__((__packed__)) peer_port_sync_message {
     uint16_t opcode;
     uint32_t port_num;
     uint32_t del_ports;     /* add or delete */
-    int mlag_id;
-    unsigned long port_id[MLAG_MAX_PORTS];
+    int32_t mlag_id;
+    uint64_t port_id[];     /* port_num entries */
 };
 
 struct __attribute__((__packed__)) peer_port_oper_sync_message {
     uint16_t opcode;
     uint32_t port_num;
-    int mlag_id;
-    int oper_state[MLAG_MAX_PORTS];
-    unsigned long port_id[MLAG_MAX_PORTS];
+    int32_t mlag_id;
+    struct port_state_entry ports[]; /* port_num entries */
 };
 /************************************************
  *  Global variables
@@ -204,6 +209,18 @@ int port_manager_mlag_ports_add(unsigned long *mlag_ports, int port_num);
  */
 int port_manager_mlag_port_delete(unsigned long mlag_port);
 
+/**
+ *  This function deletes configured local ports. Master logic is
+ *  notified on all deleted ports in one message, a deleted event is
+ *  sent for each port.
+ *
+ * @param[in] mlag_ports - array of ports to delete
+ * @param[in] port_num - number of ports to delete
+ *
+ * @return 0 if operation completes successfully.
+ */
+int port_manager_mlag_ports_delete(unsigned long *mlag_ports, int port_num);
+
 /**
  *  This function handles remote peers ports configuration
  *
@@ -233,15 +250,13 @@ int port_manager_peer_mlag_ports_delete(int peer_id, unsigned long *mlag_ports,
  *  Global oper state is set by the MLAG master port logic
  *  Down means that there are no active links for th
  *
- * @param[in] mlag_ports - array of ports
- * @param[in] new_states - port states, expected the same length
- *       as ports aray
- * @param[in] port_num - number of ports in the arrays above
+ * @param[in] ports - array of port and global state pairs
+ * @param[in] port_num - number of entries in the array above
  *
  * @return 0 if operation completes successfully.
  */
-int port_manager_global_oper_state_set(unsigned long *mlag_ports,
-                                       int *oper_states, int port_num);
+int port_manager_global_oper_state_set(struct port_state_entry *ports,
+                                       int port_num);
 
 /**
  *  This function handles global admin state notification
@@ -288,6 +303,30 @@ int port_manager_local_port_down(unsigned long mlag_port);
 int port_manager_peer_oper_state_change(
     struct port_oper_state_change_data *oper_chg);
 
+/**
+ *  This function handles a batch of local port oper state changes.
+ *  All ports are updated in one pass and a single
+ *  MLAG_PEER_PORTS_OPER_STATE_CHANGE is sent to the master.
+ *
+ * @param[in] ports - (port, OES state) pairs
+ * @param[in] port_num - number of ports
+ *
+ * @return 0 if operation completes successfully.
+ */
+int port_manager_local_ports_oper_state_set(struct port_state_entry *ports,
+                                            int port_num);
+
+/**
+ *  This function handles a batch of peer port oper state changes.
+ *  Resulting global states are sent as one aggregated message.
+ *
+ * @param[in] oper_sync - peer ports oper state message
+ *
+ * @return 0 if operation completes successfully.
+ */
+int port_manager_peer_ports_oper_state_change(
+    struct peer_port_oper_sync_message *oper_sync);
+
 /**
  *  This function handles peer state change notification.
  *
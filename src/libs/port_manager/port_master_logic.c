@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <ctype.h>
+#include <complib/cl_mem.h>
 #include <mlag_api_defs.h>
 #include <oes_types.h>
 #include "lib_commu.h"
@@ -62,6 +63,20 @@
 
 static mlag_verbosity_t LOG_VAR_NAME(__MODULE__) = MLAG_VERBOSITY_LEVEL_DEBUG;
 
+/* Global states and forwarded oper states collected while a batch is open */
+struct global_state_batch {
+    int open;
+    uint32_t max;
+    send_message_cb send_func;
+    struct port_global_state_event_data *msg;
+    struct peer_port_oper_sync_message *fwd;
+};
+
+static struct global_state_batch global_batch;
+
+static int
+forward_to_peers(send_message_cb send_func, enum mlag_events opcode,
+                 void *msg, uint32_t payload_size, int self_id);
 static int
 is_all_peers_active();
 static int
@@ -680,12 +695,13 @@ static  int port_state_chg (port_master_logic  * fsm, int parameter, struct fsm_
 /*
  * This function sends new global state to all remote peers
  *
+ * @param[in] send_func - message send function
  * @param[in] msg - port global state change message
  *
  * @return 0 if operation completes successfully.
  */
 static int
-send_global_state_to_remote_peers(port_master_logic *fsm,
+send_global_state_to_remote_peers(send_message_cb send_func,
                                   struct port_global_state_event_data *msg)
 {
     int err = 0;
@@ -702,12 +718,13 @@ send_global_state_to_remote_peers(port_master_logic *fsm,
                                                                &mlag_id);
             MLAG_BAIL_ERROR_MSG(err, "Failed to get mlag id from index [%d]",
                                 current_peer);
-            MLAG_LOG(MLAG_LOG_DEBUG, "Send global [%d] to mlag_id [%d]\n",
-                     msg->state[0], mlag_id);
-            if (fsm->message_send_func != NULL) {
-                err = fsm->message_send_func(MLAG_PORT_GLOBAL_STATE_EVENT, msg,
-                                             sizeof(*msg), mlag_id,
-                                             MASTER_LOGIC);
+            MLAG_LOG(MLAG_LOG_DEBUG,
+                     "Send global [%d] of [%d] ports to mlag_id [%d]\n",
+                     msg->ports[0].state, msg->port_num, mlag_id);
+            if (send_func != NULL) {
+                err = send_func(MLAG_PORT_GLOBAL_STATE_EVENT, msg,
+                                PORT_GLOBAL_STATE_EVENT_SIZE(msg->port_num),
+                                mlag_id, MASTER_LOGIC);
                 MLAG_BAIL_ERROR_MSG(err, "Failed sending MLAG_PORT_GLOBAL_STATE_EVENT\n");
             }
         }
@@ -716,6 +733,171 @@ send_global_state_to_remote_peers(port_master_logic *fsm,
 bail:
     return err;
 }
+
+/*
+ * This function sends the collected global states and empties the batch
+ *
+ * @return 0 if operation completes successfully.
+ */
+static int
+global_batch_flush(void)
+{
+    int err = 0;
+    struct port_global_state_event_data *msg = global_batch.msg;
+    struct peer_port_oper_sync_message *fwd = global_batch.fwd;
+
+    if ((fwd != NULL) && (fwd->port_num > 0)) {
+        err = forward_to_peers(global_batch.send_func,
+                               MLAG_PEER_PORTS_OPER_STATE_CHANGE, fwd,
+                               PEER_PORT_OPER_SYNC_MSG_SIZE(fwd->port_num),
+                               fwd->mlag_id);
+        fwd->port_num = 0;
+        MLAG_BAIL_ERROR_MSG(err, "Failed forwarding batched oper states\n");
+    }
+
+    if ((msg == NULL) || (msg->port_num == 0)) {
+        goto bail;
+    }
+
+    err = send_system_event(MLAG_PORT_GLOBAL_STATE_EVENT, msg,
+                            PORT_GLOBAL_STATE_EVENT_SIZE(msg->port_num));
+    MLAG_BAIL_ERROR_MSG(err, "Failed sending batched global states event\n");
+
+    err = send_global_state_to_remote_peers(global_batch.send_func, msg);
+    MLAG_BAIL_ERROR_MSG(err, "Failed sending batched global states to peers\n");
+
+bail:
+    if (msg != NULL) {
+        msg->port_num = 0;
+    }
+    return err;
+}
+
+/*
+ * This function notifies new global state of a port locally and to all
+ * remote peers, or adds it to the batch when a batch is open
+ *
+ * @param[in] fsm - fsm pointer
+ * @param[in] state - new global state
+ *
+ * @return 0 if operation completes successfully.
+ */
+static int
+global_state_send(port_master_logic *fsm, enum mlag_global_port_state state)
+{
+    int err = 0;
+    uint8_t port_state_buf[PORT_GLOBAL_STATE_EVENT_SIZE(1)];
+    struct port_global_state_event_data *port_state =
+        (struct port_global_state_event_data *)port_state_buf;
+    struct port_global_state_event_data *msg = global_batch.msg;
+
+    if (global_batch.open && (msg != NULL)) {
+        if ((uint32_t)msg->port_num == global_batch.max) {
+            err = global_batch_flush();
+            MLAG_BAIL_CHECK_NO_MSG(err);
+        }
+        msg->ports[msg->port_num].port_id = fsm->port_id;
+        msg->ports[msg->port_num].state = state;
+        msg->port_num++;
+        global_batch.send_func = fsm->message_send_func;
+        goto bail;
+    }
+
+    port_state->port_num = 1;
+    port_state->ports[0].port_id = fsm->port_id;
+    port_state->ports[0].state = state;
+    err = send_system_event(MLAG_PORT_GLOBAL_STATE_EVENT, port_state,
+                            sizeof(port_state_buf));
+    MLAG_BAIL_ERROR_MSG(err, "Failed sending port global state event\n");
+
+    err = send_global_state_to_remote_peers(fsm->message_send_func,
+                                            port_state);
+    MLAG_BAIL_ERROR_MSG(err, "Failed sending global state to peers\n");
+
+bail:
+    return err;
+}
+
+/**
+ *  This function allocates the global state batch, sized for the
+ *  maximum number of ports
+ *
+ * @return 0 if operation completes successfully.
+ */
+int
+port_master_logic_batch_init(void)
+{
+    int err = 0;
+
+    global_batch.open = FALSE;
+    global_batch.send_func = NULL;
+    global_batch.max = mlag_max_ports_get();
+    global_batch.msg = (struct port_global_state_event_data *)
+                       cl_malloc(PORT_GLOBAL_STATE_EVENT_SIZE(
+                                     global_batch.max));
+    global_batch.fwd = (struct peer_port_oper_sync_message *)
+                       cl_malloc(PEER_PORT_OPER_SYNC_MSG_SIZE(
+                                     global_batch.max));
+    if ((global_batch.msg == NULL) || (global_batch.fwd == NULL)) {
+        port_master_logic_batch_deinit();
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate global state batch\n");
+    }
+    global_batch.msg->port_num = 0;
+    global_batch.fwd->port_num = 0;
+
+bail:
+    return err;
+}
+
+/**
+ *  This function frees the global state batch
+ *
+ * @return void
+ */
+void
+port_master_logic_batch_deinit(void)
+{
+    if (global_batch.msg != NULL) {
+        cl_free(global_batch.msg);
+        global_batch.msg = NULL;
+    }
+    if (global_batch.fwd != NULL) {
+        cl_free(global_batch.fwd);
+        global_batch.fwd = NULL;
+    }
+    global_batch.open = FALSE;
+}
+
+/**
+ *  This function opens a global state batch. Until the batch is
+ *  closed, global state changes of all ports are collected and sent
+ *  as one port_global_state_event_data locally and to each peer, and
+ *  forwarded peer oper states are sent as one
+ *  MLAG_PEER_PORTS_OPER_STATE_CHANGE.
+ *
+ * @return void
+ */
+void
+port_master_logic_batch_start(void)
+{
+    global_batch.open = TRUE;
+}
+
+/**
+ *  This function closes the global state batch and sends the
+ *  collected global states
+ *
+ * @return 0 if operation completes successfully.
+ */
+int
+port_master_logic_batch_end(void)
+{
+    global_batch.open = FALSE;
+
+    return global_batch_flush();
+}
+
 /*
  * This function is called as reaction to peer up event
  * it updates the remote peer that the port is globally enabled
@@ -732,33 +914,35 @@ port_global_en(port_master_logic  * fsm, int parameter,
 {
     int err = 0;
     int mlag_id;
-    struct port_global_state_event_data msg;
+    uint8_t msg_buf[PORT_GLOBAL_STATE_EVENT_SIZE(1)];
+    struct port_global_state_event_data *msg =
+        (struct port_global_state_event_data *)msg_buf;
     SET_EVENT(port_master_logic, peer_active_ev);
 
 
-    msg.port_id[0] = fsm->port_id;
-    msg.port_num = 1;
-    msg.state[0] = MLAG_PORT_GLOBAL_ENABLED;
+    msg->ports[0].port_id = fsm->port_id;
+    msg->port_num = 1;
+    msg->ports[0].state = MLAG_PORT_GLOBAL_ENABLED;
 
     err = mlag_manager_db_mlag_id_from_local_index_get(ev->peer_id, &mlag_id);
     MLAG_BAIL_ERROR_MSG(err, "Failed to get mlag id from local index [%d]\n",
                         ev->peer_id);
 
     if (fsm->message_send_func != NULL) {
-        err = fsm->message_send_func(MLAG_PORT_GLOBAL_STATE_EVENT, &msg,
-                                     sizeof(msg), mlag_id, MASTER_LOGIC);
+        err = fsm->message_send_func(MLAG_PORT_GLOBAL_STATE_EVENT, msg,
+                                     sizeof(msg_buf), mlag_id, MASTER_LOGIC);
         MLAG_BAIL_ERROR_MSG(err, "Failed sending MLAG_PORT_GLOBAL_ENABLED msg\n");
     }
 
     /* Send state message */
-    msg.state[0] = MLAG_PORT_GLOBAL_DOWN;
+    msg->ports[0].state = MLAG_PORT_GLOBAL_DOWN;
     if (parameter == OES_PORT_UP) {
-        msg.state[0] = MLAG_PORT_GLOBAL_UP;
+        msg->ports[0].state = MLAG_PORT_GLOBAL_UP;
     }
 
     if (fsm->message_send_func != NULL) {
-        err = fsm->message_send_func(MLAG_PORT_GLOBAL_STATE_EVENT, &msg,
-                                     sizeof(msg), mlag_id, MASTER_LOGIC);
+        err = fsm->message_send_func(MLAG_PORT_GLOBAL_STATE_EVENT, msg,
+                                     sizeof(msg_buf), mlag_id, MASTER_LOGIC);
         MLAG_BAIL_ERROR_MSG(err, "Failed sending oper MLAG_PORT_GLOBAL_STATE_EVENT msg\n");
     }
 
@@ -767,16 +951,20 @@ bail:
 }
 
 /*
- * This function forwards peer oper state change notification to other peers
+ * This function forwards a message to all peers except the local and
+ * origin peers
  *
- * @param[in] msg - peer port oper state change message
+ * @param[in] send_func - message send function
+ * @param[in] opcode - message opcode
+ * @param[in] msg - message
+ * @param[in] payload_size - message size
+ * @param[in] self_id - mlag id of origin peer
  *
  * @return 0 if operation completes successfully.
  */
 static int
-forward_msg_to_peers(port_master_logic  * fsm, enum mlag_events opcode,
-                     void *msg, uint32_t payload_size,
-                     int self_id)
+forward_to_peers(send_message_cb send_func, enum mlag_events opcode,
+                 void *msg, uint32_t payload_size, int self_id)
 {
     int err = 0;
     int current_peer = 0;
@@ -794,9 +982,9 @@ forward_msg_to_peers(port_master_logic  * fsm, enum mlag_events opcode,
                                                                &mlag_id);
             MLAG_BAIL_ERROR_MSG(err, "Failed to get mlag id for local index [%d",
                                 current_peer);
-            if ((mlag_id != self_id) && (fsm->message_send_func != NULL)) {
-                err = fsm->message_send_func(opcode, msg, payload_size,
-                                             mlag_id, MASTER_LOGIC);
+            if ((mlag_id != self_id) && (send_func != NULL)) {
+                err = send_func(opcode, msg, payload_size, mlag_id,
+                                MASTER_LOGIC);
                 MLAG_BAIL_ERROR_MSG(err, "Failed to forward msg opcode [%d] to peers\n",
                                 opcode);
             }
@@ -807,6 +995,22 @@ bail:
     return err;
 }
 
+/*
+ * This function forwards peer oper state change notification to other peers
+ *
+ * @param[in] msg - peer port oper state change message
+ *
+ * @return 0 if operation completes successfully.
+ */
+static int
+forward_msg_to_peers(port_master_logic  * fsm, enum mlag_events opcode,
+                     void *msg, uint32_t payload_size,
+                     int self_id)
+{
+    return forward_to_peers(fsm->message_send_func, opcode, msg,
+                            payload_size, self_id);
+}
+
 /*
  * This function is called on entry to disabled state
  *
@@ -820,19 +1024,10 @@ disabled_entry_func(port_master_logic *fsm, struct fsm_event_base *ev)
 {
     int err = 0;
     UNUSED_PARAM(ev);
-    struct port_global_state_event_data port_state;
     /* Send Global Port Disable */
     MLAG_LOG(MLAG_LOG_DEBUG, "Port [%lu] in disable\n", fsm->port_id);
-    port_state.port_num = 1;
-    port_state.port_id[0] = fsm->port_id;
-    port_state.state[0] = MLAG_PORT_GLOBAL_DISABLED;
-    err = send_system_event(MLAG_PORT_GLOBAL_STATE_EVENT, &port_state,
-                            sizeof(port_state));
-    MLAG_BAIL_ERROR_MSG(err, "Failed sending system event MLAG_PORT_GLOBAL_DISABLED\n");
-
-    /* Send to remote peers */
-    err = send_global_state_to_remote_peers(fsm, &port_state);
-    MLAG_BAIL_ERROR_MSG(err, "Failed sending global disable to peers\n");
+    err = global_state_send(fsm, MLAG_PORT_GLOBAL_DISABLED);
+    MLAG_BAIL_ERROR_MSG(err, "Failed sending global disable\n");
 
 bail:
     return err;
@@ -852,24 +1047,20 @@ global_down_entry_func(port_master_logic *fsm, struct fsm_event_base *ev)
     int err = 0;
     int dispatch_err;
     UNUSED_PARAM(ev);
-    struct port_global_state_event_data port_state;
     /* Send Global Port down event*/
     MLAG_LOG(MLAG_LOG_DEBUG, "Port [%lu] in global down\n", fsm->port_id);
-    port_state.port_num = 1;
-    port_state.port_id[0] = fsm->port_id;
-    port_state.state[0] = MLAG_PORT_GLOBAL_DOWN;
-    err = send_system_event(MLAG_PORT_GLOBAL_STATE_EVENT, &port_state,
-                            sizeof(port_state));
-    MLAG_BAIL_ERROR_MSG(err, "Failed in sending port global state down event\n");
-
-    dispatch_err = sl_api_port_oper_status_trigger(fsm->port_id, OES_PORT_DOWN);
-    if (dispatch_err) {
-        MLAG_LOG(MLAG_LOG_INFO, "MLAG operstate-changed event dispatcher failed for port %ld\n", fsm->port_id);
+    err = global_state_send(fsm, MLAG_PORT_GLOBAL_DOWN);
+    MLAG_BAIL_ERROR_MSG(err, "Failed in sending port global state down\n");
+
+    if (fsm->oper_down_sent == FALSE) {
+        dispatch_err = sl_api_port_oper_status_trigger(fsm->port_id,
+                                                       OES_PORT_DOWN);
+        if (dispatch_err) {
+            MLAG_LOG(MLAG_LOG_INFO, "MLAG operstate-changed event dispatcher failed for port %ld\n", fsm->port_id);
+        }
     }
+    fsm->oper_down_sent = FALSE;
 
-    err = send_global_state_to_remote_peers(fsm, &port_state);
-    MLAG_BAIL_ERROR_MSG(err, "Failed in sending global down to peers\n");
-    
 bail:
     return err;
 }
@@ -888,24 +1079,16 @@ global_up_entry_func(port_master_logic *fsm, struct fsm_event_base *ev)
     int err = 0;
     int dispatch_err;
     UNUSED_PARAM(ev);
-    struct port_global_state_event_data port_state;
     /* Send Global Port down event*/
     MLAG_LOG(MLAG_LOG_DEBUG, "Port [%lu] in global up\n", fsm->port_id);
-    port_state.port_num = 1;
-    port_state.port_id[0] = fsm->port_id;
-    port_state.state[0] = MLAG_PORT_GLOBAL_UP;
-    err = send_system_event(MLAG_PORT_GLOBAL_STATE_EVENT, &port_state,
-                            sizeof(port_state));
-    MLAG_BAIL_ERROR_MSG(err, "Failed in sending port global up state event\n");
+    err = global_state_send(fsm, MLAG_PORT_GLOBAL_UP);
+    MLAG_BAIL_ERROR_MSG(err, "Failed in sending port global up state\n");
 
     dispatch_err = sl_api_port_oper_status_trigger(fsm->port_id, OES_PORT_UP);
     if (dispatch_err) {
         MLAG_LOG(MLAG_LOG_INFO, "MLAG operstate-changed event dispatcher failed for port %ld\n", fsm->port_id);
     }
 
-    err = send_global_state_to_remote_peers(fsm, &port_state);
-    MLAG_BAIL_ERROR_MSG(err, "Failed in sending port global up to peers\n");
-    
 bail:
     return err;
 }
@@ -926,18 +1109,11 @@ port_enable(port_master_logic  * fsm, int parameter,
     int err = 0;
     UNUSED_PARAM(event);
     UNUSED_PARAM(parameter);
-    struct port_global_state_event_data port_state;
     /* Send Global Port Enable*/
     MLAG_LOG(MLAG_LOG_DEBUG, "Port [%lu] moves to Global enable\n",
              fsm->port_id);
-    port_state.port_num = 1;
-    port_state.port_id[0] = fsm->port_id;
-    port_state.state[0] = MLAG_PORT_GLOBAL_ENABLED;
-    err = send_system_event(MLAG_PORT_GLOBAL_STATE_EVENT, &port_state,
-                            sizeof(port_state));
-    MLAG_BAIL_ERROR_MSG(err, "Failed in sending port global enabled state event\n");
-    err = send_global_state_to_remote_peers(fsm, &port_state);
-    MLAG_BAIL_ERROR_MSG(err, "Failed in sending port global enabled to peers\n");
+    err = global_state_send(fsm, MLAG_PORT_GLOBAL_ENABLED);
+    MLAG_BAIL_ERROR_MSG(err, "Failed in sending port global enabled state\n");
 
 bail:
     return err;
@@ -958,24 +1134,26 @@ port_conf_chg(port_master_logic  * fsm, int parameter,
 {
     int err = 0;
     SET_EVENT(port_master_logic, port_up_ev);
-    struct peer_port_sync_message port_chg;
+    uint8_t port_chg_buf[PEER_PORT_SYNC_MSG_SIZE(1)];
+    struct peer_port_sync_message *port_chg =
+        (struct peer_port_sync_message *)port_chg_buf;
     int mlag_id;
 
     err = mlag_manager_db_mlag_id_from_local_index_get(ev->peer_id, &mlag_id);
     MLAG_BAIL_ERROR_MSG(err, "Failed getting mlag id from local index [%d]\n",
                         ev->peer_id);
 
-    port_chg.port_num = 1;
-    port_chg.del_ports = FALSE;
+    port_chg->port_num = 1;
+    port_chg->del_ports = FALSE;
     if (parameter == PORT_DELETED) {
-        port_chg.del_ports = TRUE;
+        port_chg->del_ports = TRUE;
     }
-    port_chg.port_id[0] = fsm->port_id;
-    port_chg.mlag_id = mlag_id;
+    port_chg->port_id[0] = fsm->port_id;
+    port_chg->mlag_id = mlag_id;
 
     err =
-        forward_msg_to_peers(fsm, MLAG_PORTS_UPDATE_EVENT, &port_chg,
-                             sizeof(port_chg),
+        forward_msg_to_peers(fsm, MLAG_PORTS_UPDATE_EVENT, port_chg,
+                             sizeof(port_chg_buf),
                              mlag_id);
     MLAG_BAIL_ERROR_MSG(err,
                         "Failed in forwarding port configuration message\n");
@@ -1028,12 +1206,29 @@ port_state_chg(port_master_logic  * fsm, int parameter,
     UNUSED_PARAM(parameter);
     SET_EVENT(port_master_logic, port_up_ev);
     struct port_oper_state_change_data oper_state_chg;
+    struct peer_port_oper_sync_message *fwd;
     int mlag_id;
 
     err = mlag_manager_db_mlag_id_from_local_index_get(ev->peer_id, &mlag_id);
     MLAG_BAIL_ERROR_MSG(err, "Failed to get mlag id for local index [%d]\n",
                         ev->peer_id);
 
+    if (global_batch.open && (global_batch.fwd != NULL)) {
+        fwd = global_batch.fwd;
+        if ((fwd->port_num > 0) &&
+            (((uint32_t)fwd->port_num == global_batch.max) ||
+             (fwd->mlag_id != mlag_id))) {
+            err = global_batch_flush();
+            MLAG_BAIL_CHECK_NO_MSG(err);
+        }
+        fwd->mlag_id = mlag_id;
+        fwd->ports[fwd->port_num].port_id = fsm->port_id;
+        fwd->ports[fwd->port_num].state = parameter;
+        fwd->port_num++;
+        global_batch.send_func = fsm->message_send_func;
+        goto bail;
+    }
+
     oper_state_chg.port_id = fsm->port_id;
     oper_state_chg.is_ipl = FALSE;
     oper_state_chg.mlag_id = mlag_id;
@@ -46,6 +46,44 @@ typedef int (*send_message_cb) (enum mlag_events opcode,
                                 uint8_t dest_peer_id,
                                 enum message_originator);
 
+/**
+ *  This function allocates the global state batch, sized for the
+ *  maximum number of ports
+ *
+ * @return 0 if operation completes successfully.
+ */
+int
+port_master_logic_batch_init(void);
+
+/**
+ *  This function frees the global state batch
+ *
+ * @return void
+ */
+void
+port_master_logic_batch_deinit(void);
+
+/**
+ *  This function opens a global state batch. Until the batch is
+ *  closed, global state changes of all ports are collected and sent
+ *  as one port_global_state_event_data locally and to each peer, and
+ *  forwarded peer oper states are sent as one
+ *  MLAG_PEER_PORTS_OPER_STATE_CHANGE.
+ *
+ * @return void
+ */
+void
+port_master_logic_batch_start(void);
+
+/**
+ *  This function closes the global state batch and sends the
+ *  collected global states
+ *
+ * @return 0 if operation completes successfully.
+ */
+int
+port_master_logic_batch_end(void);
+
 /*#$*/
 #include "fsm_tool_framework.h"
 /*----------------------------------------------------------------
@@ -91,6 +129,7 @@ typedef struct port_master_logic
 /*#$*/
     unsigned long port_id;
     send_message_cb message_send_func;
+    int oper_down_sent; /* oper down already triggered by failover plan */
 }port_master_logic;
 
 #endif /* PORT_MASTER_LOGIC_HH */
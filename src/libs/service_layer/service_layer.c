@@ -25,9 +25,12 @@
  * SOFTWARE.
  */ 
 
+#include <errno.h>
 #include <netinet/in.h>
 #include <net/ethernet.h>
+#include <complib/cl_mem.h>
 #include <service_layer.h>
+#include "service_layer_sim.h"
 #include "mlag_log.h"
 #include "mlag_bail.h"
 
@@ -53,6 +56,17 @@
 /************************************************
  *  Local variables
  ***********************************************/
+/* Default backend, accepts all operations without programming */
+static const struct sl_backend_ops sl_null_backend = {
+    .name = "null",
+    .port_ops_apply = NULL,
+    .port_state_get = NULL,
+    .port_redirect_get = NULL,
+    .port_isolate_get = NULL,
+    .ipl_vlan_membership_action = NULL,
+};
+
+static const struct sl_backend_ops *sl_backend = &sl_null_backend;
 
 
 /************************************************
@@ -64,6 +78,86 @@
  *  Function implementations
  ***********************************************/
 
+/*
+ * This function applies a single port operation
+ *
+ * @param[in] op - operation
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+sl_port_op_apply(const struct sl_port_op *op)
+{
+    return sl_api_port_ops_apply(op, 1, NULL);
+}
+
+/**
+ * This function sets the backend that programs the switch.
+ *
+ * @param[in] backend - backend operations, NULL restores the default
+ *                      backend
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+sl_api_backend_set(const struct sl_backend_ops *backend)
+{
+    int err = 0;
+
+    if (backend == NULL) {
+        sl_backend = &sl_null_backend;
+        goto bail;
+    }
+    if (backend->port_ops_apply == NULL) {
+        err = -EINVAL;
+        goto bail;
+    }
+    sl_backend = backend;
+
+bail:
+    return err;
+}
+
+/**
+ * This function applies a batch of port programming operations in
+ * one backend call. Operations are applied in order up to the first
+ * failure.
+ *
+ * @param[in] ops       - operations list
+ * @param[in] ops_num   - number of operations in the list
+ * @param[out] done_num - number of operations applied, may be NULL
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+sl_api_port_ops_apply(const struct sl_port_op *ops,
+                      const unsigned int ops_num,
+                      unsigned int *done_num)
+{
+    int err = 0;
+    unsigned int applied = 0;
+
+    if ((ops == NULL) && (ops_num > 0)) {
+        err = -EINVAL;
+        goto bail;
+    }
+    if (ops_num == 0) {
+        goto bail;
+    }
+    if (sl_backend->port_ops_apply == NULL) {
+        applied = ops_num;
+        goto bail;
+    }
+
+    err = sl_backend->port_ops_apply(ops, ops_num, &applied);
+
+bail:
+    if (done_num != NULL) {
+        *done_num = applied;
+    }
+    return err;
+}
+
 /**
  * This function initialize the service layer data base, and load libraries dynamically.
  *
@@ -76,6 +170,11 @@ sl_api_init(void *log_cb)
 
     UNUSED_PARAM(log_cb);
 
+#ifdef MLAG_SL_SIM
+    sl_sim_latency_set(SL_SIM_CALL_LATENCY_USEC, SL_SIM_OP_LATENCY_USEC);
+    err = sl_api_backend_set(sl_sim_backend_get());
+#endif
+
     goto bail;
 
 bail:
@@ -146,15 +245,14 @@ int
 sl_api_port_set(const enum oes_access_cmd access_cmd,
                 const unsigned long port_id)
 {
-    int err = 0;
-
-    UNUSED_PARAM(port_id);
-    UNUSED_PARAM(access_cmd);
+    struct sl_port_op op;
 
-    goto bail;
+    op.type = SL_PORT_OP_SET;
+    op.access_cmd = access_cmd;
+    op.port_id = port_id;
+    op.data.ipl_port_id = 0;
 
-bail:
-    return err;
+    return sl_port_op_apply(&op);
 }
 
 
@@ -170,15 +268,14 @@ int
 sl_api_port_state_set(const unsigned long port_id,
                       const enum oes_port_admin_state admin_state)
 {
-    int err = 0;
-
-    UNUSED_PARAM(port_id);
-    UNUSED_PARAM(admin_state);
+    struct sl_port_op op;
 
-    goto bail;
+    op.type = SL_PORT_OP_STATE_SET;
+    op.access_cmd = OES_ACCESS_CMD_EDIT;
+    op.port_id = port_id;
+    op.data.admin_state = admin_state;
 
-bail:
-    return err;
+    return sl_port_op_apply(&op);
 }
 
 /**
@@ -195,12 +292,10 @@ sl_api_port_state_get(const unsigned long port_id,
 {
     int err = 0;
 
-    UNUSED_PARAM(port_id);
-    UNUSED_PARAM(admin_state);
+    if (sl_backend->port_state_get != NULL) {
+        err = sl_backend->port_state_get(port_id, admin_state);
+    }
 
-    goto bail;
-
-bail:
     return err;
 }
 
@@ -220,16 +315,14 @@ sl_api_port_redirect_set(const enum oes_access_cmd access_cmd,
                          const unsigned long port_id,
                          const unsigned long redirect_port_id)
 {
-    int err = 0;
+    struct sl_port_op op;
 
-    UNUSED_PARAM(access_cmd);
-    UNUSED_PARAM(port_id);
-    UNUSED_PARAM(redirect_port_id);
-
-    goto bail;
+    op.type = SL_PORT_OP_REDIRECT_SET;
+    op.access_cmd = access_cmd;
+    op.port_id = port_id;
+    op.data.ipl_port_id = redirect_port_id;
 
-bail:
-    return err;
+    return sl_port_op_apply(&op);
 }
 
 
@@ -251,13 +344,11 @@ sl_api_port_redirect_get(const unsigned long port_id,
 {
     int err = 0;
 
-    UNUSED_PARAM(port_id);
-    UNUSED_PARAM(is_redirected);
-    UNUSED_PARAM(redirected_port_id);
-
-    goto bail;
+    if (sl_backend->port_redirect_get != NULL) {
+        err = sl_backend->port_redirect_get(port_id, is_redirected,
+                                            redirected_port_id);
+    }
 
-bail:
     return err;
 }
 
@@ -284,15 +375,42 @@ sl_api_port_isolation_set(const enum oes_access_cmd access_cmd,
                           const unsigned short port_list_len)
 {
     int err = 0;
-
-    UNUSED_PARAM(access_cmd);
-    UNUSED_PARAM(port_id);
-    UNUSED_PARAM(isolated_port_list);
-    UNUSED_PARAM(port_list_len);
-
-    goto bail;
+    struct sl_port_op *ops = NULL;
+    unsigned short i;
+
+    if (port_list_len <= 1) {
+        struct sl_port_op op;
+
+        op.type = SL_PORT_OP_ISOLATION_SET;
+        op.access_cmd = access_cmd;
+        op.port_id = port_id;
+        op.data.ipl_port_id = (port_list_len == 1) ?
+                              isolated_port_list[0] : 0;
+        err = sl_port_op_apply(&op);
+        goto bail;
+    }
+
+    ops = (struct sl_port_op *)cl_malloc(port_list_len * sizeof(*ops));
+    if (ops == NULL) {
+        err = -ENOMEM;
+        goto bail;
+    }
+    for (i = 0; i < port_list_len; i++) {
+        ops[i].type = SL_PORT_OP_ISOLATION_SET;
+        /* CREATE overwrites once, the rest of the list is added */
+        ops[i].access_cmd = access_cmd;
+        if ((access_cmd == OES_ACCESS_CMD_CREATE) && (i > 0)) {
+            ops[i].access_cmd = OES_ACCESS_CMD_ADD;
+        }
+        ops[i].port_id = port_id;
+        ops[i].data.ipl_port_id = isolated_port_list[i];
+    }
+    err = sl_api_port_ops_apply(ops, port_list_len, NULL);
 
 bail:
+    if (ops != NULL) {
+        cl_free(ops);
+    }
     return err;
 }
 
@@ -315,13 +433,11 @@ sl_api_port_isolate_get(const unsigned long port_id,
 {
     int err = 0;
 
-    UNUSED_PARAM(port_id);
-    UNUSED_PARAM(isolated_port_list);
-    UNUSED_PARAM(port_list_len);
+    if (sl_backend->port_isolate_get != NULL) {
+        err = sl_backend->port_isolate_get(port_id, isolated_port_list,
+                                           port_list_len);
+    }
 
-    goto bail;
-
-bail:
     return err;
 }
 
@@ -345,14 +461,12 @@ sl_api_ipl_vlan_membership_action(const enum oes_access_cmd access_cmd,
 {
     int err = 0;
 
-    UNUSED_PARAM(access_cmd);
-    UNUSED_PARAM(ipl_port_id);
-    UNUSED_PARAM(vlan_list);
-    UNUSED_PARAM(vlan_list_len);
-
-    goto bail;
+    if (sl_backend->ipl_vlan_membership_action != NULL) {
+        err = sl_backend->ipl_vlan_membership_action(access_cmd, ipl_port_id,
+                                                     vlan_list,
+                                                     vlan_list_len);
+    }
 
-bail:
     return err;
 }
 
@@ -383,15 +497,102 @@ bail:
  */
 int
 sl_api_port_oper_status_trigger(const unsigned long port_id,
-                                const enum oes_port_oper_state operstate) {
+                                const enum oes_port_oper_state operstate)
+{
+    struct sl_port_op op;
+
+    op.type = SL_PORT_OP_OPER_STATUS_TRIGGER;
+    op.access_cmd = OES_ACCESS_CMD_EDIT;
+    op.port_id = port_id;
+    op.data.oper_state = operstate;
+
+    return sl_port_op_apply(&op);
+}
+
+/**
+ * This function triggers port operational status notification for a
+ * list of ports in one operation.
+ *
+ * @param[in] port_list     - list of MLAG port ids
+ * @param[in] port_list_len - number of ports in the list
+ * @param[in] operstate     - operational state to notify
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+sl_api_ports_oper_status_trigger(const unsigned long *port_list,
+                                 const unsigned short port_list_len,
+                                 const enum oes_port_oper_state operstate)
+{
     int err = 0;
-    
-    UNUSED_PARAM(port_id);
-    UNUSED_PARAM(operstate);
+    struct sl_port_op *ops = NULL;
+    unsigned short i;
+
+    if (port_list_len == 0) {
+        goto bail;
+    }
+    ops = (struct sl_port_op *)cl_malloc(port_list_len * sizeof(*ops));
+    if (ops == NULL) {
+        err = -ENOMEM;
+        goto bail;
+    }
+    for (i = 0; i < port_list_len; i++) {
+        ops[i].type = SL_PORT_OP_OPER_STATUS_TRIGGER;
+        ops[i].access_cmd = OES_ACCESS_CMD_EDIT;
+        ops[i].port_id = port_list[i];
+        ops[i].data.oper_state = operstate;
+    }
+    err = sl_api_port_ops_apply(ops, port_list_len, NULL);
 
-    goto bail;
+bail:
+    if (ops != NULL) {
+        cl_free(ops);
+    }
+    return err;
+}
+
+/**
+ * This function sets the IPL isolation of a list of MLAG ports in one
+ * operation. It has the same effect as calling
+ * sl_api_port_isolation_set for each port with the IPL as isolated port.
+ *
+ * @param[in] access_cmd    - ADD/DELETE
+ * @param[in] port_list     - list of MLAG port ids
+ * @param[in] port_list_len - number of ports in the list
+ * @param[in] ipl_port_id   - the IPL port id
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+sl_api_ports_isolation_set(const enum oes_access_cmd access_cmd,
+                           const unsigned long *port_list,
+                           const unsigned short port_list_len,
+                           const unsigned long ipl_port_id)
+{
+    int err = 0;
+    struct sl_port_op *ops = NULL;
+    unsigned short i;
+
+    if (port_list_len == 0) {
+        goto bail;
+    }
+    ops = (struct sl_port_op *)cl_malloc(port_list_len * sizeof(*ops));
+    if (ops == NULL) {
+        err = -ENOMEM;
+        goto bail;
+    }
+    for (i = 0; i < port_list_len; i++) {
+        ops[i].type = SL_PORT_OP_ISOLATION_SET;
+        ops[i].access_cmd = access_cmd;
+        ops[i].port_id = port_list[i];
+        ops[i].data.ipl_port_id = ipl_port_id;
+    }
+    err = sl_api_port_ops_apply(ops, port_list_len, NULL);
 
 bail:
+    if (ops != NULL) {
+        cl_free(ops);
+    }
     return err;
 }
 
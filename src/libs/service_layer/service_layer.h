@@ -113,6 +113,60 @@ struct sl_api_ctrl_pkt_data {
         union sl_api_ctrl_pkt_types ctrl_pkt;   /**<! ctrl packet data*/
 };
 
+/**
+ * sl_port_op_type enum lists the port programming operations that
+ * can be applied in a batch
+ */
+enum sl_port_op_type {
+    SL_PORT_OP_SET = 0,             /**<! sl_api_port_set */
+    SL_PORT_OP_STATE_SET,           /**<! sl_api_port_state_set */
+    SL_PORT_OP_REDIRECT_SET,        /**<! sl_api_port_redirect_set */
+    SL_PORT_OP_ISOLATION_SET,       /**<! sl_api_port_isolation_set */
+    SL_PORT_OP_OPER_STATUS_TRIGGER, /**<! sl_api_port_oper_status_trigger */
+    SL_PORT_OP_LAST
+};
+
+/**
+ * sl_port_op structure describes one port programming operation,
+ * its parameters are those of the matching single port call
+ */
+struct sl_port_op {
+    enum sl_port_op_type type;
+    enum oes_access_cmd access_cmd;    /**<! SET, REDIRECT and ISOLATION */
+    unsigned long port_id;             /**<! MLAG port id */
+    union {
+        enum oes_port_admin_state admin_state; /**<! STATE_SET */
+        enum oes_port_oper_state oper_state;   /**<! OPER_STATUS_TRIGGER */
+        unsigned long ipl_port_id;     /**<! REDIRECT and ISOLATION */
+    } data;
+};
+
+/**
+ * sl_backend_ops structure is the service layer backend. Every
+ * programming call is passed to port_ops_apply, single port calls as
+ * a batch of one operation.
+ */
+struct sl_backend_ops {
+    const char *name;
+    /* Applies ops in order, stops on first failure, done_num returns
+     * the number of ops applied
+     */
+    int (*port_ops_apply)(const struct sl_port_op *ops,
+                          unsigned int ops_num, unsigned int *done_num);
+    int (*port_state_get)(const unsigned long port_id,
+                          enum oes_port_admin_state *admin_state);
+    int (*port_redirect_get)(const unsigned long port_id,
+                             int *is_redirected,
+                             unsigned long *redirected_port_id);
+    int (*port_isolate_get)(const unsigned long port_id,
+                            unsigned long *isolated_port_list,
+                            unsigned short *port_list_len);
+    int (*ipl_vlan_membership_action)(const enum oes_access_cmd access_cmd,
+                                      const unsigned long ipl_port_id,
+                                      const unsigned short *vlan_list,
+                                      const unsigned short vlan_list_len);
+};
+
 
 /************************************************
  *  Global variables
@@ -159,6 +213,33 @@ sl_api_start(void);
 int
 sl_api_stop(void);
 
+/**
+ * This function sets the backend that programs the switch.
+ *
+ * @param[in] backend - backend operations, NULL restores the default
+ *                      backend
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+sl_api_backend_set(const struct sl_backend_ops *backend);
+
+/**
+ * This function applies a batch of port programming operations in
+ * one backend call. Operations are applied in order up to the first
+ * failure.
+ *
+ * @param[in] ops       - operations list
+ * @param[in] ops_num   - number of operations in the list
+ * @param[out] done_num - number of operations applied, may be NULL
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+sl_api_port_ops_apply(const struct sl_port_op *ops,
+                      const unsigned int ops_num,
+                      unsigned int *done_num);
+
 /**
  * This function CREATEs/DESTROYs a new/existing MLAG ports
  *
@@ -306,6 +387,39 @@ int
 sl_api_port_oper_status_trigger(const unsigned long port_id,
                                 const enum oes_port_oper_state);
 
+/**
+ * This function triggers port operational status notification for a
+ * list of ports in one operation.
+ *
+ * @param[in] port_list     - list of MLAG port ids
+ * @param[in] port_list_len - number of ports in the list
+ * @param[in] operstate     - operational state to notify
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+sl_api_ports_oper_status_trigger(const unsigned long *port_list,
+                                 const unsigned short port_list_len,
+                                 const enum oes_port_oper_state operstate);
+
+/**
+ * This function sets the IPL isolation of a list of MLAG ports in one
+ * operation. It has the same effect as calling
+ * sl_api_port_isolation_set for each port with the IPL as isolated port.
+ *
+ * @param[in] access_cmd    - ADD/DELETE
+ * @param[in] port_list     - list of MLAG port ids
+ * @param[in] port_list_len - number of ports in the list
+ * @param[in] ipl_port_id   - the IPL port id
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+sl_api_ports_isolation_set(const enum oes_access_cmd access_cmd,
+                           const unsigned long *port_list,
+                           const unsigned short port_list_len,
+                           const unsigned long ipl_port_id);
+
 /**
 * This function retrieves the file descriptor of the current open channel
 * used for receiving a packet
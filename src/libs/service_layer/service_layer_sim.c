@@ -0,0 +1,596 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <service_layer.h>
+#include "service_layer_sim.h"
+#include "mlag_log.h"
+#include "mlag_bail.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+/* Open addressing table, twice the ports to keep probes short */
+#define SL_SIM_PORT_TABLE_SIZE (2 * SL_SIM_MAX_PORTS)
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+struct sl_sim_port_slot {
+    int in_use;
+    struct sl_sim_port port;
+};
+
+struct sl_sim_ipl {
+    int in_use;
+    unsigned long ipl_port_id;
+    uint8_t vlans[SL_SIM_MAX_VLANS / 8];
+};
+
+/************************************************
+ *  Global variables
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+static pthread_mutex_t sim_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct sl_sim_port_slot sim_ports[SL_SIM_PORT_TABLE_SIZE];
+static struct sl_sim_ipl sim_ipls[SL_SIM_MAX_IPLS];
+static uint32_t sim_call_usec = SL_SIM_CALL_LATENCY_USEC;
+static uint32_t sim_op_usec = SL_SIM_OP_LATENCY_USEC;
+static struct sl_sim_counters sim_counters;
+
+/************************************************
+ *  Local function declarations
+ ***********************************************/
+static int sim_port_ops_apply(const struct sl_port_op *ops,
+                              unsigned int ops_num, unsigned int *done_num);
+static int sim_port_state_get(const unsigned long port_id,
+                              enum oes_port_admin_state *admin_state);
+static int sim_port_redirect_get(const unsigned long port_id,
+                                 int *is_redirected,
+                                 unsigned long *redirected_port_id);
+static int sim_port_isolate_get(const unsigned long port_id,
+                                unsigned long *isolated_port_list,
+                                unsigned short *port_list_len);
+static int sim_ipl_vlan_membership_action(
+    const enum oes_access_cmd access_cmd, const unsigned long ipl_port_id,
+    const unsigned short *vlan_list, const unsigned short vlan_list_len);
+
+static const struct sl_backend_ops sim_backend = {
+    .name = "sim",
+    .port_ops_apply = sim_port_ops_apply,
+    .port_state_get = sim_port_state_get,
+    .port_redirect_get = sim_port_redirect_get,
+    .port_isolate_get = sim_port_isolate_get,
+    .ipl_vlan_membership_action = sim_ipl_vlan_membership_action,
+};
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ * This function injects the latency of one backend call, called
+ * with the simulator locked so calls are serialized as in hardware
+ *
+ * @param[in] ops_num - number of operations in the call
+ *
+ * @return void
+ */
+static void
+sim_call_delay(unsigned int ops_num)
+{
+    struct timespec ts;
+    uint64_t usec = sim_call_usec + ((uint64_t)sim_op_usec * ops_num);
+
+    sim_counters.calls++;
+    if (usec == 0) {
+        return;
+    }
+    sim_counters.busy_usec += usec;
+    ts.tv_sec = usec / 1000000;
+    ts.tv_nsec = (usec % 1000000) * 1000;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+    }
+}
+
+/*
+ * This function finds the simulated port, optionally adding it
+ *
+ * @param[in] port_id - port id
+ * @param[in] add - add the port if not found
+ *
+ * @return port, NULL if not found or table is full
+ */
+static struct sl_sim_port *
+sim_port_find(unsigned long port_id, int add)
+{
+    uint32_t idx = port_id % SL_SIM_PORT_TABLE_SIZE;
+    uint32_t probe;
+
+    for (probe = 0; probe < SL_SIM_PORT_TABLE_SIZE; probe++) {
+        if (sim_ports[idx].in_use == FALSE) {
+            if (add == FALSE) {
+                break;
+            }
+            memset(&sim_ports[idx], 0, sizeof(sim_ports[idx]));
+            sim_ports[idx].in_use = TRUE;
+            sim_ports[idx].port.port_id = port_id;
+            sim_ports[idx].port.admin_state = OES_PORT_ADMIN_ENABLE;
+            sim_ports[idx].port.oper_state = OES_PORT_DOWN;
+            return &sim_ports[idx].port;
+        }
+        if (sim_ports[idx].port.port_id == port_id) {
+            return &sim_ports[idx].port;
+        }
+        idx = (idx + 1) % SL_SIM_PORT_TABLE_SIZE;
+    }
+
+    return NULL;
+}
+
+/*
+ * This function applies an isolation operation on a simulated port
+ *
+ * @param[in] port - simulated port
+ * @param[in] op - operation
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+sim_isolation_apply(struct sl_sim_port *port, const struct sl_port_op *op)
+{
+    int err = 0;
+    unsigned short i;
+
+    if ((op->access_cmd == OES_ACCESS_CMD_CREATE) ||
+        (op->access_cmd == OES_ACCESS_CMD_DELETE_ALL)) {
+        port->isolated_num = 0;
+        if (op->access_cmd == OES_ACCESS_CMD_DELETE_ALL) {
+            goto bail;
+        }
+    }
+
+    for (i = 0; i < port->isolated_num; i++) {
+        if (port->isolated[i] == op->data.ipl_port_id) {
+            break;
+        }
+    }
+
+    switch (op->access_cmd) {
+    case OES_ACCESS_CMD_CREATE:
+    case OES_ACCESS_CMD_ADD:
+        if (i < port->isolated_num) {
+            goto bail;
+        }
+        if (port->isolated_num == SL_SIM_MAX_ISOLATED) {
+            err = -ENOSPC;
+            goto bail;
+        }
+        port->isolated[port->isolated_num++] = op->data.ipl_port_id;
+        break;
+    case OES_ACCESS_CMD_DELETE:
+        if (i < port->isolated_num) {
+            port->isolated_num--;
+            port->isolated[i] = port->isolated[port->isolated_num];
+        }
+        break;
+    default:
+        err = -EINVAL;
+        break;
+    }
+
+bail:
+    return err;
+}
+
+/*
+ * This function applies one operation on the simulated switch
+ *
+ * @param[in] op - operation
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+sim_port_op_apply(const struct sl_port_op *op)
+{
+    int err = 0;
+    struct sl_sim_port *port;
+
+    port = sim_port_find(op->port_id, TRUE);
+    if (port == NULL) {
+        err = -ENOSPC;
+        goto bail;
+    }
+
+    switch (op->type) {
+    case SL_PORT_OP_SET:
+        if (op->access_cmd == OES_ACCESS_CMD_CREATE) {
+            port->created = TRUE;
+        }
+        else if (op->access_cmd == OES_ACCESS_CMD_DESTROY) {
+            port->created = FALSE;
+            port->redirected = FALSE;
+            port->isolated_num = 0;
+        }
+        else {
+            err = -EINVAL;
+        }
+        break;
+    case SL_PORT_OP_STATE_SET:
+        port->admin_state = op->data.admin_state;
+        break;
+    case SL_PORT_OP_REDIRECT_SET:
+        if (op->access_cmd == OES_ACCESS_CMD_CREATE) {
+            port->redirected = TRUE;
+            port->redirect_port_id = op->data.ipl_port_id;
+        }
+        else if (op->access_cmd == OES_ACCESS_CMD_DESTROY) {
+            port->redirected = FALSE;
+        }
+        else {
+            err = -EINVAL;
+        }
+        break;
+    case SL_PORT_OP_ISOLATION_SET:
+        err = sim_isolation_apply(port, op);
+        break;
+    case SL_PORT_OP_OPER_STATUS_TRIGGER:
+        port->oper_state = op->data.oper_state;
+        port->oper_triggers++;
+        break;
+    default:
+        err = -EINVAL;
+        break;
+    }
+
+bail:
+    return err;
+}
+
+/*
+ * This function applies a batch of operations as one call of the
+ * simulated switch
+ *
+ * @param[in] ops       - operations list
+ * @param[in] ops_num   - number of operations in the list
+ * @param[out] done_num - number of operations applied
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+sim_port_ops_apply(const struct sl_port_op *ops, unsigned int ops_num,
+                   unsigned int *done_num)
+{
+    int err = 0;
+    unsigned int idx;
+
+    pthread_mutex_lock(&sim_mutex);
+
+    sim_call_delay(ops_num);
+    for (idx = 0; idx < ops_num; idx++) {
+        err = sim_port_op_apply(&ops[idx]);
+        if (err) {
+            sim_counters.errors++;
+            break;
+        }
+        sim_counters.ops++;
+    }
+    *done_num = idx;
+
+    pthread_mutex_unlock(&sim_mutex);
+
+    return err;
+}
+
+/*
+ * This function gets the simulated port administrative state
+ *
+ * @param[in] port_id - port id
+ * @param[out] admin_state - port administrative state
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+sim_port_state_get(const unsigned long port_id,
+                   enum oes_port_admin_state *admin_state)
+{
+    int err = 0;
+    struct sl_sim_port *port;
+
+    pthread_mutex_lock(&sim_mutex);
+    sim_call_delay(1);
+    port = sim_port_find(port_id, FALSE);
+    if (port == NULL) {
+        err = -ENOENT;
+        goto bail;
+    }
+    *admin_state = port->admin_state;
+
+bail:
+    pthread_mutex_unlock(&sim_mutex);
+    return err;
+}
+
+/*
+ * This function gets the simulated port redirection
+ *
+ * @param[in] port_id - port id
+ * @param[out] is_redirected - 1 if redirected, else 0
+ * @param[out] redirected_port_id - the IPL port id
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+sim_port_redirect_get(const unsigned long port_id, int *is_redirected,
+                      unsigned long *redirected_port_id)
+{
+    struct sl_sim_port *port;
+
+    pthread_mutex_lock(&sim_mutex);
+    sim_call_delay(1);
+    port = sim_port_find(port_id, FALSE);
+    *is_redirected = FALSE;
+    if ((port != NULL) && (port->redirected == TRUE)) {
+        *is_redirected = TRUE;
+        *redirected_port_id = port->redirect_port_id;
+    }
+    pthread_mutex_unlock(&sim_mutex);
+
+    return 0;
+}
+
+/*
+ * This function gets the simulated port isolation list
+ *
+ * @param[in] port_id - port id
+ * @param[out] isolated_port_list - list of isolated ports
+ * @param[in,out] port_list_len - In: array size, Out: ports in list
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+sim_port_isolate_get(const unsigned long port_id,
+                     unsigned long *isolated_port_list,
+                     unsigned short *port_list_len)
+{
+    struct sl_sim_port *port;
+    unsigned short i;
+    unsigned short num = 0;
+
+    pthread_mutex_lock(&sim_mutex);
+    sim_call_delay(1);
+    port = sim_port_find(port_id, FALSE);
+    if (port != NULL) {
+        for (i = 0; (i < port->isolated_num) && (i < *port_list_len); i++) {
+            isolated_port_list[num++] = port->isolated[i];
+        }
+    }
+    *port_list_len = num;
+    pthread_mutex_unlock(&sim_mutex);
+
+    return 0;
+}
+
+/*
+ * This function adds or removes VLANs of a simulated IPL
+ *
+ * @param[in] access_cmd - ADD/DELETE
+ * @param[in] ipl_port_id - IPL port id
+ * @param[in] vlan_list - VLANs list
+ * @param[in] vlan_list_len - vlan_list length
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+sim_ipl_vlan_membership_action(const enum oes_access_cmd access_cmd,
+                               const unsigned long ipl_port_id,
+                               const unsigned short *vlan_list,
+                               const unsigned short vlan_list_len)
+{
+    int err = 0;
+    struct sl_sim_ipl *ipl = NULL;
+    unsigned short vlan;
+    int i;
+
+    pthread_mutex_lock(&sim_mutex);
+    sim_call_delay(vlan_list_len);
+
+    for (i = 0; i < SL_SIM_MAX_IPLS; i++) {
+        if (sim_ipls[i].in_use && (sim_ipls[i].ipl_port_id == ipl_port_id)) {
+            ipl = &sim_ipls[i];
+            break;
+        }
+    }
+    for (i = 0; (ipl == NULL) && (i < SL_SIM_MAX_IPLS); i++) {
+        if (sim_ipls[i].in_use == FALSE) {
+            ipl = &sim_ipls[i];
+            memset(ipl, 0, sizeof(*ipl));
+            ipl->in_use = TRUE;
+            ipl->ipl_port_id = ipl_port_id;
+        }
+    }
+    if (ipl == NULL) {
+        err = -ENOSPC;
+        sim_counters.errors++;
+        goto bail;
+    }
+
+    for (i = 0; i < vlan_list_len; i++) {
+        vlan = vlan_list[i] % SL_SIM_MAX_VLANS;
+        if (access_cmd == OES_ACCESS_CMD_ADD) {
+            ipl->vlans[vlan / 8] |= (1 << (vlan % 8));
+        }
+        else {
+            ipl->vlans[vlan / 8] &= ~(1 << (vlan % 8));
+        }
+    }
+    sim_counters.ops += vlan_list_len;
+
+bail:
+    pthread_mutex_unlock(&sim_mutex);
+    return err;
+}
+
+/**
+ * This function returns the simulated switch backend, to be set by
+ * sl_api_backend_set
+ *
+ * @return simulated switch backend operations
+ */
+const struct sl_backend_ops *
+sl_sim_backend_get(void)
+{
+    return &sim_backend;
+}
+
+/**
+ * This function sets the latency injected by the simulated switch
+ *
+ * @param[in] call_usec - latency of each backend call
+ * @param[in] op_usec   - latency of each operation in a call
+ *
+ * @return void
+ */
+void
+sl_sim_latency_set(uint32_t call_usec, uint32_t op_usec)
+{
+    pthread_mutex_lock(&sim_mutex);
+    sim_call_usec = call_usec;
+    sim_op_usec = op_usec;
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+/**
+ * This function clears the simulated switch state and counters
+ *
+ * @return void
+ */
+void
+sl_sim_reset(void)
+{
+    pthread_mutex_lock(&sim_mutex);
+    memset(sim_ports, 0, sizeof(sim_ports));
+    memset(sim_ipls, 0, sizeof(sim_ipls));
+    memset(&sim_counters, 0, sizeof(sim_counters));
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+/**
+ * This function gets the simulated state of a port
+ *
+ * @param[in] port_id - port id
+ * @param[out] port   - port state
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOENT if the port was never programmed
+ */
+int
+sl_sim_port_get(unsigned long port_id, struct sl_sim_port *port)
+{
+    int err = 0;
+    struct sl_sim_port *sim_port;
+
+    pthread_mutex_lock(&sim_mutex);
+    sim_port = sim_port_find(port_id, FALSE);
+    if (sim_port == NULL) {
+        err = -ENOENT;
+        goto bail;
+    }
+    *port = *sim_port;
+
+bail:
+    pthread_mutex_unlock(&sim_mutex);
+    return err;
+}
+
+/**
+ * This function checks if a VLAN is a member of a simulated IPL
+ *
+ * @param[in] ipl_port_id - IPL port id
+ * @param[in] vlan_id     - VLAN id
+ *
+ * @return 1 if member, otherwise 0
+ */
+int
+sl_sim_ipl_vlan_is_member(unsigned long ipl_port_id, unsigned short vlan_id)
+{
+    int member = 0;
+    int i;
+
+    vlan_id %= SL_SIM_MAX_VLANS;
+
+    pthread_mutex_lock(&sim_mutex);
+    for (i = 0; i < SL_SIM_MAX_IPLS; i++) {
+        if (sim_ipls[i].in_use && (sim_ipls[i].ipl_port_id == ipl_port_id)) {
+            member = (sim_ipls[i].vlans[vlan_id / 8] >> (vlan_id % 8)) & 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sim_mutex);
+
+    return member;
+}
+
+/**
+ * This function gets the simulated switch counters
+ *
+ * @param[out] counters - counters
+ *
+ * @return void
+ */
+void
+sl_sim_counters_get(struct sl_sim_counters *counters)
+{
+    pthread_mutex_lock(&sim_mutex);
+    *counters = sim_counters;
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+/**
+ * This function clears the simulated switch counters
+ *
+ * @return void
+ */
+void
+sl_sim_counters_clear(void)
+{
+    pthread_mutex_lock(&sim_mutex);
+    memset(&sim_counters, 0, sizeof(sim_counters));
+    pthread_mutex_unlock(&sim_mutex);
+}
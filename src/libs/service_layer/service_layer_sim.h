@@ -0,0 +1,161 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SERVICE_LAYER_SIM_H_
+#define SERVICE_LAYER_SIM_H_
+
+#include <stdint.h>
+#include <service_layer.h>
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* Latency injected by the simulated switch, per backend call and per
+ * operation in it, can be changed at runtime by sl_sim_latency_set
+ */
+#ifndef SL_SIM_CALL_LATENCY_USEC
+#define SL_SIM_CALL_LATENCY_USEC 0
+#endif
+
+#ifndef SL_SIM_OP_LATENCY_USEC
+#define SL_SIM_OP_LATENCY_USEC 0
+#endif
+
+#define SL_SIM_MAX_PORTS      4096
+#define SL_SIM_MAX_ISOLATED   4
+#define SL_SIM_MAX_IPLS       2
+#define SL_SIM_MAX_VLANS      4096
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+/**
+ * sl_sim_port structure holds the state the simulated switch keeps
+ * for one port
+ */
+struct sl_sim_port {
+    unsigned long port_id;
+    int created;
+    enum oes_port_admin_state admin_state;
+    int redirected;
+    unsigned long redirect_port_id;
+    unsigned short isolated_num;
+    unsigned long isolated[SL_SIM_MAX_ISOLATED];
+    enum oes_port_oper_state oper_state;
+    uint32_t oper_triggers;
+};
+
+/**
+ * sl_sim_counters structure counts the work of the simulated switch
+ */
+struct sl_sim_counters {
+    uint64_t calls;     /* backend calls */
+    uint64_t ops;       /* operations applied */
+    uint64_t errors;    /* failed operations */
+    uint64_t busy_usec; /* injected latency */
+};
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ * This function returns the simulated switch backend, to be set by
+ * sl_api_backend_set
+ *
+ * @return simulated switch backend operations
+ */
+const struct sl_backend_ops *
+sl_sim_backend_get(void);
+
+/**
+ * This function sets the latency injected by the simulated switch
+ *
+ * @param[in] call_usec - latency of each backend call
+ * @param[in] op_usec   - latency of each operation in a call
+ *
+ * @return void
+ */
+void
+sl_sim_latency_set(uint32_t call_usec, uint32_t op_usec);
+
+/**
+ * This function clears the simulated switch state and counters
+ *
+ * @return void
+ */
+void
+sl_sim_reset(void);
+
+/**
+ * This function gets the simulated state of a port
+ *
+ * @param[in] port_id - port id
+ * @param[out] port   - port state
+ *
+ * @return 0 when successful, otherwise ERROR
+ * @return -ENOENT if the port was never programmed
+ */
+int
+sl_sim_port_get(unsigned long port_id, struct sl_sim_port *port);
+
+/**
+ * This function checks if a VLAN is a member of a simulated IPL
+ *
+ * @param[in] ipl_port_id - IPL port id
+ * @param[in] vlan_id     - VLAN id
+ *
+ * @return 1 if member, otherwise 0
+ */
+int
+sl_sim_ipl_vlan_is_member(unsigned long ipl_port_id, unsigned short vlan_id);
+
+/**
+ * This function gets the simulated switch counters
+ *
+ * @param[out] counters - counters
+ *
+ * @return void
+ */
+void
+sl_sim_counters_get(struct sl_sim_counters *counters);
+
+/**
+ * This function clears the simulated switch counters
+ *
+ * @return void
+ */
+void
+sl_sim_counters_clear(void);
+
+#endif /* SERVICE_LAYER_SIM_H_ */
@@ -28,6 +28,7 @@
 #define MLAG_CONF_C_
 
 #include <complib/sx_rpc.h>
+#include <complib/cl_mem.h>
 #include "mlag_init.h"
 #include <errno.h>
 #include <mlag_api_defs.h>
@@ -35,6 +36,8 @@
 #include <utils/mlag_bail.h>
 #include <utils/mlag_events.h>
 #include <libs/mlag_common/mlag_common.h>
+#include <libs/mlag_common/mlag_lock_prof.h>
+#include <libs/mlag_common/mlag_vlan_bitmap.h>
 #include <libs/mlag_topology/mlag_topology.h>
 #include "mlag_conf.h"
 #include <libs/port_manager/port_manager.h>
@@ -99,25 +102,48 @@ mlag_ports_state_change_notify(const struct port_state_info *ports_arr,
     int ipl_err_check;
     unsigned long i;
     unsigned int ipl_id;
+    uint32_t batch_max;
     struct port_oper_state_change_data state_change;
+    struct ports_oper_state_change_data *batch = NULL;
 
     BAIL_MLAG_NOT_INIT();
 
     SAFE_MEMSET(&state_change, 0);
 
+    /* Non IPL ports are notified in batches of up to max ports */
+    batch_max = mlag_max_ports_get();
+    batch = (struct ports_oper_state_change_data *)
+            cl_malloc(PORTS_OPER_STATE_CHANGE_EVENT_SIZE(batch_max));
+    if (batch == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate ports state batch\n");
+    }
+    batch->port_num = 0;
+
     for (i = 0; i < ports_arr_cnt; i++) {
-        state_change.port_id = ports_arr[i].port_id;
-        state_change.is_ipl = FALSE;
         ipl_err_check =
             mlag_topology_ipl_port_id_get(ports_arr[i].port_id, &ipl_id);
-        if (ipl_err_check == 0) {
-            state_change.is_ipl = TRUE;
-            err = mlag_topology_ipl_port_state_set(ipl_id,
-                                                   ports_arr[i].port_state);
-            state_change.port_id = ipl_id;
-            MLAG_BAIL_ERROR(err);
+        if (ipl_err_check != 0) {
+            batch->ports[batch->port_num].port_id = ports_arr[i].port_id;
+            batch->ports[batch->port_num].state = ports_arr[i].port_state;
+            batch->port_num++;
+            if ((uint32_t)batch->port_num == batch_max) {
+                err = send_system_event(MLAG_PORTS_OPER_STATE_CHANGE_EVENT,
+                                        batch,
+                                        PORTS_OPER_STATE_CHANGE_EVENT_SIZE(
+                                            batch->port_num));
+                MLAG_BAIL_ERROR(err);
+                batch->port_num = 0;
+            }
+            continue;
         }
 
+        /* IPL state is consumed by the health manager one by one */
+        state_change.is_ipl = TRUE;
+        err = mlag_topology_ipl_port_state_set(ipl_id,
+                                               ports_arr[i].port_state);
+        MLAG_BAIL_ERROR(err);
+        state_change.port_id = ipl_id;
         state_change.state = ports_arr[i].port_state;
         state_change.mlag_id = INVALID_MLAG_PEER_ID;
 
@@ -127,7 +153,17 @@ mlag_ports_state_change_notify(const struct port_state_info *ports_arr,
         MLAG_BAIL_ERROR(err);
     }
 
+    if (batch->port_num > 0) {
+        err = send_system_event(MLAG_PORTS_OPER_STATE_CHANGE_EVENT, batch,
+                                PORTS_OPER_STATE_CHANGE_EVENT_SIZE(
+                                    batch->port_num));
+        MLAG_BAIL_ERROR(err);
+    }
+
 bail:
+    if (batch != NULL) {
+        cl_free(batch);
+    }
     return err;
 }
 
@@ -158,6 +194,7 @@ mlag_vlans_state_change_notify(const struct vlan_state_info *vlans_arr,
     unsigned long i;
     int ev_len = 0;
     static struct vlan_state_change_event_data state_change;
+    static struct vlan_state_bitmap vlans;
 
     BAIL_MLAG_NOT_INIT();
 
@@ -169,15 +206,26 @@ mlag_vlans_state_change_notify(const struct vlan_state_info *vlans_arr,
                             vlans_arr_cnt);
     }
 
-    state_change.opcode = MLAG_L3_INTERFACE_VLAN_LOCAL_STATE_CHANGE_EVENT;
-    state_change.peer_id = 0;
-    state_change.vlans_arr_cnt = vlans_arr_cnt;
+    SAFE_MEMSET(&vlans, 0);
     for (i = 0; i < vlans_arr_cnt; i++) {
-        state_change.vlan_data[i].vlan_id = vlans_arr[i].vlan_id;
-        state_change.vlan_data[i].vlan_state = vlans_arr[i].vlan_state;
+        if (!((vlans_arr[i].vlan_id > 0) &&
+              (vlans_arr[i].vlan_id < MLAG_VLAN_ID_MAX) &&
+              ((vlans_arr[i].vlan_state == VLAN_UP) ||
+               (vlans_arr[i].vlan_state == VLAN_DOWN)))) {
+            err = -EINVAL;
+            MLAG_BAIL_ERROR_MSG(err,
+                                "mlag_vlans_state_change_notify: invalid vlan %u state %u",
+                                vlans_arr[i].vlan_id,
+                                vlans_arr[i].vlan_state);
+        }
+        vlan_state_bitmap_set(&vlans, vlans_arr[i].vlan_id,
+                              (vlans_arr[i].vlan_state == VLAN_UP));
     }
-    ev_len = sizeof(struct vlan_state_change_base_event_data) +
-             sizeof(state_change.vlan_data[0]) * vlans_arr_cnt;
+
+    state_change.opcode = MLAG_L3_INTERFACE_VLAN_LOCAL_STATE_CHANGE_EVENT;
+    state_change.peer_id = 0;
+    err = vlan_state_encode(&vlans, &state_change, &ev_len);
+    MLAG_BAIL_ERROR(err);
 
     err = send_system_event(MLAG_L3_INTERFACE_VLAN_LOCAL_STATE_CHANGE_EVENT,
                             &state_change, ev_len);
@@ -305,6 +353,42 @@ bail:
     return err;
 }
 
+/**
+ * Collects the state published in the monitoring snapshot, with the
+ * getters the API uses. Called by the state publisher thread.
+ *
+ * @param[out] state - MLAG state, ports_num holds the ports capacity.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_state_collect(struct mlag_snapshot_state *state)
+{
+    int err = 0;
+
+    err = mlag_protocol_oper_state_get(&state->protocol_oper_state);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    err = mlag_system_role_state_get(&state->system_role_state);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    state->peers_num = MLAG_SNAPSHOT_MAX_PEERS;
+    err = mlag_peers_state_list_get(state->peers, &state->peers_num);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    err = mlag_counters_get(NULL, 0, &state->counters);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+    err = mlag_ports_state_get(state->ports, &state->ports_num);
+    MLAG_BAIL_CHECK_NO_MSG(err);
+
+bail:
+    return err;
+}
+
 /**
  * Clear the mlag protocol counters.
  * This function works synchronously. It blocks until the operation is completed.
@@ -328,6 +412,38 @@ mlag_counters_clear(void)
     port_manager_counters_clear();
     mlag_mac_sync_counters_clear();
     lacp_manager_counters_clear();
+    mlag_latency_clear();
+    mlag_lock_prof_clear();
+
+bail:
+    return err;
+}
+
+/**
+ * Populates latency_list with the queue delay and handler time
+ * histograms of the dispatched opcodes, ordered by source and opcode.
+ * This function works synchronously. It blocks until the operation is completed.
+ *
+ * @param[in] start - Number of leading entries to skip.
+ * @param[out] latency_list - Latency per opcode. Pointer to an already allocated
+ *                            memory structure.
+ * @param[in,out] latency_cnt - List size. On return, the number of entries
+ *                              retrieved.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_event_latency_get(unsigned int start,
+                       struct mlag_event_latency *latency_list,
+                       unsigned int *latency_cnt)
+{
+    int err = 0;
+
+    BAIL_MLAG_NOT_INIT();
+
+    mlag_latency_get(start, latency_list, latency_cnt);
 
 bail:
     return err;
@@ -356,12 +472,27 @@ mlag_ports_state_get(struct mlag_port_info *mlag_ports_information,
 {
     int err = 0;
     int i, port_num;
-    static unsigned long ports[MLAG_MAX_PORTS];
-    static enum mlag_port_oper_state states[MLAG_MAX_PORTS];
+    unsigned long *ports = NULL;
+    enum mlag_port_oper_state *states = NULL;
 
     BAIL_MLAG_NOT_INIT();
 
-    port_num = *mlag_ports_cnt;
+    /* Port DB holds at most max ports per peer */
+    port_num = MLAG_MAX_PEERS * mlag_max_ports_get();
+    if (*mlag_ports_cnt < (unsigned int)port_num) {
+        port_num = *mlag_ports_cnt;
+    }
+    if (port_num == 0) {
+        goto bail;
+    }
+
+    ports = (unsigned long *)cl_malloc(port_num * sizeof(*ports));
+    states = (enum mlag_port_oper_state *)
+             cl_malloc(port_num * sizeof(*states));
+    if ((ports == NULL) || (states == NULL)) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate ports state vectors\n");
+    }
 
     err = port_manager_mlag_ports_get(ports, states, &port_num);
     MLAG_BAIL_ERROR(err);
@@ -373,6 +504,12 @@ mlag_ports_state_get(struct mlag_port_info *mlag_ports_information,
     *mlag_ports_cnt = port_num;
 
 bail:
+    if (ports != NULL) {
+        cl_free(ports);
+    }
+    if (states != NULL) {
+        cl_free(states);
+    }
     return err;
 }
 
@@ -511,38 +648,101 @@ bail:
 int
 mlag_port_set(const enum access_cmd access_cmd,
               const unsigned long port_id)
+{
+    return mlag_ports_set(access_cmd, &port_id, 1);
+}
+
+/**
+ * Add/Delete several mlag ports.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately. Each port is tracked
+ * until its add/delete completes, see mlag_ports_cfg_state_get.
+ *
+ * @param[in] access_cmd - Add/Delete.
+ * @param[in] ports - Interface indexes of ports. Must represent mlag ports.
+ * @param[in] ports_cnt - Number of ports.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -ENOSPC - Too many port operations are still pending.
+ * @return -EIO - Operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_ports_set(const enum access_cmd access_cmd,
+               const unsigned long *ports, unsigned int ports_cnt)
 {
     int err = 0;
-    struct port_conf_event_data port_set;
+    unsigned int i;
+    struct port_conf_event_data *port_set = NULL;
 
     BAIL_MLAG_NOT_INIT();
 
-    port_set.port_num = 1;
-    port_set.ports[0] = port_id;
+    MLAG_BAIL_CHECK(ports != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((ports_cnt > 0) && (ports_cnt <= mlag_max_ports_get()),
+                    -EINVAL);
 
-    switch (access_cmd) {
-    case ACCESS_CMD_ADD:
-        port_set.del_ports = FALSE;
-        err = send_system_event(MLAG_PORT_CFG_EVENT, &port_set,
-                                sizeof(port_set));
-        MLAG_BAIL_ERROR(err);
-        break;
-    case ACCESS_CMD_DELETE:
-        port_set.del_ports = TRUE;
-        err = send_system_event(MLAG_PORT_CFG_EVENT, &port_set,
-                                sizeof(port_set));
-        MLAG_BAIL_ERROR(err);
+    if ((access_cmd != ACCESS_CMD_ADD) && (access_cmd != ACCESS_CMD_DELETE)) {
+        err = -EPERM;
+        MLAG_BAIL_ERROR_MSG(err, "Unsupported Command [%d]\n", access_cmd);
+    }
 
-        mlag_manager_wait_for_port_delete_done();
+    port_set = (struct port_conf_event_data *)
+               cl_malloc(PORT_CONF_EVENT_SIZE(ports_cnt));
+    if (port_set == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate ports set event\n");
+    }
 
-        err = sl_api_port_set(OES_ACCESS_CMD_DESTROY, port_id);
-        MLAG_BAIL_ERROR(err);
-        break;
-    default:
-        MLAG_BAIL_ERROR_MSG(-EPERM, "Unsupported Command [%d]\n", access_cmd);
-        break;
+    port_set->del_ports = (access_cmd == ACCESS_CMD_DELETE);
+    port_set->port_num = ports_cnt;
+    for (i = 0; i < ports_cnt; i++) {
+        port_set->ports[i] = ports[i];
     }
 
+    /* Completion of each port is reported by the handling modules */
+    err = mlag_manager_port_cfg_pending_set(ports, ports_cnt,
+                                            port_set->del_ports);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to track [%u] ports configuration\n",
+                        ports_cnt);
+
+    err = send_system_event(MLAG_PORT_CFG_EVENT, port_set,
+                            PORT_CONF_EVENT_SIZE(ports_cnt));
+    if (err) {
+        mlag_manager_port_cfg_done(ports, ports_cnt,
+                                   MLAG_PORT_CFG_STATE_FAILED);
+    }
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    if (port_set != NULL) {
+        cl_free(port_set);
+    }
+    return err;
+}
+
+/**
+ * Get add/delete progress of mlag ports.
+ *
+ * @param[in,out] ports_cfg - In: port_id of each entry.
+ *                            Out: state of each entry.
+ * @param[in] ports_cnt - Number of entries.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_ports_cfg_state_get(struct mlag_port_cfg_info *ports_cfg,
+                         unsigned int ports_cnt)
+{
+    int err = 0;
+
+    BAIL_MLAG_NOT_INIT();
+
+    mlag_manager_port_cfg_state_get(ports_cfg, ports_cnt);
+
 bail:
     return err;
 }
@@ -951,7 +1151,8 @@ mlag_reload_delay_get(unsigned int *sec)
     err = mlag_manager_reload_delay_interval_get(sec);
     MLAG_BAIL_ERROR(err);
 
-    *sec = *sec / 1000;
+    /* Sub second intervals must not be reported as 0 */
+    *sec = (*sec + 999) / 1000;
 
 bail:
     return err;
@@ -980,6 +1181,7 @@ mlag_keepalive_interval_set(const unsigned int sec)
     BAIL_MLAG_NOT_INIT();
 
     ka_set.msec = sec * 1000;
+    ka_set.multiplier = 0; /* keep current */
     err =
         send_system_event(MLAG_HEALTH_KA_INTERVAL_CHANGE, &ka_set,
                           sizeof(ka_set));
@@ -991,6 +1193,7 @@ bail:
 
 /**
  * Populates sec with the current value of the interval at which keep-alive messages are issued.
+ * An interval set in milliseconds is rounded up to whole seconds.
  * This function works synchronously. It blocks until the operation is completed.
  *
  * @param[out] sec - The period interval duration.
@@ -1008,10 +1211,180 @@ mlag_keepalive_interval_get(unsigned int *sec)
 
     BAIL_MLAG_NOT_INIT();
 
-    err = health_manager_heartbeat_interval_get(sec);
+    err = health_manager_heartbeat_interval_get(sec, NULL);
+    MLAG_BAIL_ERROR(err);
+
+    /* Sub second intervals must not be reported as 0 */
+    *sec = (*sec + 999) / 1000;
+
+bail:
+    return err;
+}
+
+/**
+ * Specifies the keep-alive interval in milliseconds and the detection
+ * multiplier.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ * @param[in] params - Keep-alive timers.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_keepalive_params_set(const struct mlag_keepalive_params *params)
+{
+    int err = 0;
+    struct ka_interval_change_data ka_set;
+
+    BAIL_MLAG_NOT_INIT();
+
+    ka_set.msec = params->interval_msec;
+    ka_set.multiplier = params->multiplier;
+    err =
+        send_system_event(MLAG_HEALTH_KA_INTERVAL_CHANGE, &ka_set,
+                          sizeof(ka_set));
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
+/**
+ * Populates params with the current keep-alive interval in milliseconds
+ * and detection multiplier.
+ * This function works synchronously. It blocks until the operation is completed.
+ *
+ * @param[out] params - Keep-alive timers.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_keepalive_params_get(struct mlag_keepalive_params *params)
+{
+    int err = 0;
+
+    BAIL_MLAG_NOT_INIT();
+
+    err = health_manager_heartbeat_interval_get(&params->interval_msec,
+                                                &params->multiplier);
     MLAG_BAIL_ERROR(err);
 
-    *sec = *sec / 1000;
+bail:
+    return err;
+}
+
+/**
+ * Sets the scheduling of the heartbeat thread, applied by a running
+ * thread on its next wakeup.
+ * This function works synchronously. It blocks until the operation is completed.
+ *
+ * @param[in] params - Heartbeat thread priority and CPU.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_heartbeat_thread_params_set(
+    const struct mlag_heartbeat_thread_params *params)
+{
+    int err = 0;
+
+    BAIL_MLAG_NOT_INIT();
+
+    err = health_manager_heartbeat_thread_params_set(params);
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
+/**
+ * Populates params with the current scheduling of the heartbeat thread.
+ * This function works synchronously. It blocks until the operation is completed.
+ *
+ * @param[out] params - Heartbeat thread priority and CPU.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_heartbeat_thread_params_get(struct mlag_heartbeat_thread_params *params)
+{
+    int err = 0;
+
+    BAIL_MLAG_NOT_INIT();
+
+    err = health_manager_heartbeat_thread_params_get(params);
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
+/**
+ * Sets the tunneled IGMP suppression parameters.
+ * This function works asynchronously. It queues the operation and returns.
+ *
+ * @param[in] params - Suppression window and rate limit, 0 selects default.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_igmp_params_set(const struct mlag_igmp_params *params)
+{
+    int err = 0;
+    struct igmp_params_set_data igmp_set;
+
+    BAIL_MLAG_NOT_INIT();
+
+    igmp_set.params = *params;
+    err = send_system_event(MLAG_TUNNELING_IGMP_PARAMS_SET, &igmp_set,
+                            sizeof(igmp_set));
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    return err;
+}
+
+/**
+ * Populates params with the tunneled IGMP suppression parameters in use.
+ * This function works synchronously. It blocks until the operation is completed.
+ *
+ * @param[out] params - Suppression window and rate limit.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_igmp_params_get(struct mlag_igmp_params *params)
+{
+    int err = 0;
+
+    BAIL_MLAG_NOT_INIT();
+
+    err = mlag_tunneling_igmp_params_get(params);
+    MLAG_BAIL_ERROR(err);
 
 bail:
     return err;
@@ -1067,6 +1440,10 @@ mlag_dump(char *dump_file_path)
     err = lacp_manager_dump(dump_to_file);
     MLAG_BAIL_ERROR(err);
 
+    mlag_latency_dump(dump_to_file);
+    mlag_lock_prof_dump(dump_to_file);
+    mlag_trace_dump(dump_to_file);
+
 bail:
     if (dump_file) {
         fclose(dump_file);
@@ -1285,3 +1662,52 @@ mlag_lacp_selection_request(enum access_cmd access_cmd,
 bail:
     return err;
 }
+
+/**
+ * Triggers aggregator selection queries of several ports in one operation.
+ * Since MLAG is distributed, this request may involve a remote peer, so
+ * this function works asynchronously. All selections are decided together
+ * and the response of each one is issued as a notification.
+ *
+ * @param[in] selections - selection queries
+ * @param[in] selections_cnt - Number of selections.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_lacp_selections_request(const struct lacp_selection_info *selections,
+                             unsigned int selections_cnt)
+{
+    int err = 0;
+    struct lacp_selections_request_event_data *request = NULL;
+
+    BAIL_MLAG_NOT_INIT();
+
+    MLAG_BAIL_CHECK(selections != NULL, -EINVAL);
+    MLAG_BAIL_CHECK((selections_cnt > 0) &&
+                    (selections_cnt <= mlag_max_ports_get()), -EINVAL);
+
+    request = (struct lacp_selections_request_event_data *)
+              cl_malloc(LACP_SELECTIONS_REQUEST_EVENT_SIZE(selections_cnt));
+    if (request == NULL) {
+        err = -ENOMEM;
+        MLAG_BAIL_ERROR_MSG(err, "Failed to allocate selections request\n");
+    }
+
+    request->selections_num = selections_cnt;
+    memcpy(request->selections, selections,
+           selections_cnt * sizeof(struct lacp_selection_info));
+
+    err = send_system_event(MLAG_LACP_SELECTIONS_REQUEST, request,
+                            LACP_SELECTIONS_REQUEST_EVENT_SIZE(selections_cnt));
+    MLAG_BAIL_ERROR(err);
+
+bail:
+    if (request != NULL) {
+        cl_free(request);
+    }
+    return err;
+}
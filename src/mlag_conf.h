@@ -30,6 +30,7 @@
 #define MLAG_CONF_H_
 
 #include "mlag_api_defs.h"
+#include "mlag_snapshot.h"
 #ifdef MLAG_CONF_C_
 /************************************************
  *  Local Defines
@@ -160,6 +161,20 @@ int
 mlag_counters_get(const unsigned int *ipl_ids, const unsigned int ipl_ids_cnt,
                   struct mlag_counters *counters);
 
+/**
+ * Collects the state published in the monitoring snapshot, with the
+ * getters the API uses. Called by the state publisher thread.
+ *
+ * @param[out] state - MLAG state, ports_num holds the ports capacity.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_state_collect(struct mlag_snapshot_state *state);
+
 /**
  * Clear the mlag protocol counters.
  * This function works synchronously. It blocks until the operation is completed.
@@ -173,6 +188,26 @@ mlag_counters_get(const unsigned int *ipl_ids, const unsigned int ipl_ids_cnt,
 int
 mlag_counters_clear(void);
 
+/**
+ * Populates latency_list with the queue delay and handler time
+ * histograms of the dispatched opcodes, ordered by source and opcode.
+ * This function works synchronously. It blocks until the operation is completed.
+ *
+ * @param[in] start - Number of leading entries to skip.
+ * @param[out] latency_list - Latency per opcode. Pointer to an already allocated
+ *                            memory structure.
+ * @param[in,out] latency_cnt - List size. On return, the number of entries
+ *                              retrieved.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_event_latency_get(unsigned int start,
+                       struct mlag_event_latency *latency_list,
+                       unsigned int *latency_cnt);
+
 /**
  * Populates mlag_ports_information with all the current mlag ports.
  * This function works synchronously. It blocks until the operation is completed.
@@ -281,6 +316,40 @@ mlag_peers_state_list_get(struct peer_state *peers_list,
 int mlag_port_set(const enum access_cmd access_cmd,
                   const unsigned long port_id);
 
+/**
+ * Add/Delete several mlag ports.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately. Each port is tracked
+ * until its add/delete completes, see mlag_ports_cfg_state_get.
+ *
+ * @param[in] access_cmd - Add/Delete.
+ * @param[in] ports - Interface indexes of ports. Must represent mlag ports.
+ * @param[in] ports_cnt - Number of ports.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -ENOSPC - Too many port operations are still pending.
+ * @return -EIO - Operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int mlag_ports_set(const enum access_cmd access_cmd,
+                   const unsigned long *ports, unsigned int ports_cnt);
+
+/**
+ * Get add/delete progress of mlag ports.
+ *
+ * @param[in,out] ports_cfg - In: port_id of each entry.
+ *                            Out: state of each entry.
+ * @param[in] ports_cnt - Number of entries.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int mlag_ports_cfg_state_get(struct mlag_port_cfg_info *ports_cfg,
+                             unsigned int ports_cnt);
+
 /**
  * Create/Delete an IPL.
  * This function works synchronously. It blocks until the operation is completed.
@@ -459,6 +528,7 @@ int mlag_keepalive_interval_set(const unsigned int sec);
 
 /**
  * Populates sec with the current value of the interval at which keep-alive messages are issued.
+ * An interval set in milliseconds is rounded up to whole seconds.
  * This function works synchronously. It blocks until the operation is completed.
  *
  * @param[out] sec - The period interval duration.
@@ -472,6 +542,100 @@ int mlag_keepalive_interval_set(const unsigned int sec);
 int
 mlag_keepalive_interval_get(unsigned int *sec);
 
+/**
+ * Specifies the keep-alive interval in milliseconds and the detection
+ * multiplier.
+ * This function works asynchronously. After verifying its arguments are valid,
+ * it queues the operation and returns immediately.
+ * @param[in] params - Keep-alive timers.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_keepalive_params_set(const struct mlag_keepalive_params *params);
+
+/**
+ * Populates params with the current keep-alive interval in milliseconds
+ * and detection multiplier.
+ * This function works synchronously. It blocks until the operation is completed.
+ *
+ * @param[out] params - Keep-alive timers.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_keepalive_params_get(struct mlag_keepalive_params *params);
+
+/**
+ * Sets the scheduling of the heartbeat thread, applied by a running
+ * thread on its next wakeup.
+ * This function works synchronously. It blocks until the operation is completed.
+ *
+ * @param[in] params - Heartbeat thread priority and CPU.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_heartbeat_thread_params_set(
+    const struct mlag_heartbeat_thread_params *params);
+
+/**
+ * Populates params with the current scheduling of the heartbeat thread.
+ * This function works synchronously. It blocks until the operation is completed.
+ *
+ * @param[out] params - Heartbeat thread priority and CPU.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_heartbeat_thread_params_get(struct mlag_heartbeat_thread_params *params);
+
+/**
+ * Sets the tunneled IGMP suppression parameters.
+ * This function works asynchronously. It queues the operation and returns.
+ *
+ * @param[in] params - Suppression window and rate limit, 0 selects default.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_igmp_params_set(const struct mlag_igmp_params *params);
+
+/**
+ * Populates params with the tunneled IGMP suppression parameters in use.
+ * This function works synchronously. It blocks until the operation is completed.
+ *
+ * @param[out] params - Suppression window and rate limit.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If any input parameter is invalid.
+ * @return -EIO - Operation failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - Initialize the
+ *                  mlag protocol first.
+ */
+int
+mlag_igmp_params_get(struct mlag_igmp_params *params);
+
 /**
  * Generate mlag system dump.
  * This function works synchronously. It blocks until the operation is completed.
@@ -601,4 +765,22 @@ mlag_lacp_selection_request(enum access_cmd access_cmd,
                             unsigned long long partner_sys_id,
                             unsigned int partner_key, unsigned char force);
 
+/**
+ * Triggers aggregator selection queries of several ports in one operation.
+ * Since MLAG is distributed, this request may involve a remote peer, so
+ * this function works asynchronously. All selections are decided together
+ * and the response of each one is issued as a notification.
+ *
+ * @param[in] selections - selection queries
+ * @param[in] selections_cnt - Number of selections.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EINVAL - If an input parameter is invalid.
+ * @return -EIO - Network problem or operation dispatch failure.
+ * @return -EPERM - Operation not permitted - pre-condition failed - initialize MLAG first.
+ */
+int
+mlag_lacp_selections_request(const struct lacp_selection_info *selections,
+                             unsigned int selections_cnt);
+
 #endif /* MLAG_CONF_H_ */
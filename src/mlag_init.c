@@ -44,6 +44,7 @@
 #include <libs/mlag_master_election/mlag_master_election.h>
 #include "libs/mlag_l3_interface_manager/mlag_l3_interface_manager.h"
 #include <libs/mlag_common/mlag_comm_layer_wrapper.h>
+#include <libs/mlag_common/mlag_state_publisher.h>
 #include <libs/mlag_manager/mlag_dispatcher.h>
 #include <libs/mlag_mac_sync/mlag_mac_sync_dispatcher.h>
 #include <libs/port_manager/port_manager.h>
@@ -175,6 +176,10 @@ mlag_init(mlag_log_cb_t log_cb)
 
     mlag_init_state = TRUE;
 
+    /* Publish state for monitoring */
+    err = mlag_state_publisher_init(mlag_state_collect);
+    MLAG_BAIL_ERROR_MSG(err, "Failed to init MLAG state publisher\n");
+
 bail:
     return err;
 }
@@ -199,6 +204,8 @@ mlag_deinit(void)
     err = mlag_stop();
     MLAG_BAIL_ERROR_MSG(err, "Failed to stop mlag protocol\n");
 
+    mlag_state_publisher_deinit();
+
     mlag_init_state = FALSE;
 
     /* Stop inserting API requests to the system */
@@ -80,6 +80,7 @@ static struct option mlag_long_options[] = {
     {"help",        no_argument,            NULL,   'h'             },
     {"verbose",     required_argument,      NULL,   'v'             },
     {"version",     no_argument,            NULL,   MLAG_VERSION    },
+    {"max_ports",   required_argument,      NULL,   MLAG_MAX_PORTS_ARG},
     {0,             0,                      0,      0               }
 };
 
@@ -121,6 +122,7 @@ show_help()
             "\t--debug_lib                      Path to dynamically loaded debug library.\n"
             "\t--logger                         Path to dynamically loaded logging callback.\n"
             "\t--connector                      Path to dynamically loaded connector library.\n"
+            "\t--max_ports=<num>                Maximum number of mLAG ports (default = 64, max = 4096).\n"
             "\t--version                        Report version & exit normally.\n"
             "\t(-h|--help)                      Show this help message & exit normally.\n");
     exit(0);
@@ -315,6 +317,13 @@ parse_args(int argc, char **argv)
         case MLAG_VERSION:
             printf("1.0\n");
             exit(0);
+        case MLAG_MAX_PORTS_ARG:
+            ret = sscanf(optarg, "%u", &mlag_args.max_ports);
+            if ((ret != 1) || (mlag_args.max_ports == 0) ||
+                (mlag_args.max_ports > MLAG_MAX_PORTS_LIMIT)) {
+                show_error();
+            }
+            break;
         case 'v':
             verbose_flag++;
             ret = sscanf(optarg, "%u", &verbosity);
@@ -388,6 +397,11 @@ main(int argc, char **argv)
         mlag_args.debug_cb();
     }
 
+    if (mlag_args.max_ports != 0) {
+        err = mlag_max_ports_set(mlag_args.max_ports);
+        MLAG_BAIL_ERROR_MSG(err, "Failed to set max ports\n");
+    }
+
     err = mlag_init(mlag_args.log_cb);
     MLAG_BAIL_ERROR_MSG(err, "Failed to initialize mlag\n");
 
@@ -36,7 +36,8 @@ enum {
     MLAG_CONNECTOR = 1000,
     MLAG_DEBUG = 1001,
     MLAG_VERSION = 1002,
-    MLAG_LOGGER = 1003
+    MLAG_LOGGER = 1003,
+    MLAG_MAX_PORTS_ARG = 1004
 };
 /************************************************
  *  Macros
@@ -54,6 +55,7 @@ typedef int (*debug_lib_deinit_cb_t)(void);
 
 struct mlag_args_t {
     int verbosity_level;
+    unsigned int max_ports; /* 0 - default */
     mlag_log_cb_t log_cb;
     connector_cb_t connector_cb;
     connector_deinit_cb_t connector_deinit_cb;
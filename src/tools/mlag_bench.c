@@ -0,0 +1,742 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <mlag_api.h>
+#include <mlag_api_defs.h>
+#include <utils/mlag_defs.h>
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#define BENCH_MAX_SIZES 8
+#define BENCH_POLL_INTERVAL_MSEC 10
+#define BENCH_CFG_TIMEOUT_MSEC 60000
+#define BENCH_PEER_TIMEOUT_MSEC 60000
+/* Port state changes are over once none came for this long */
+#define BENCH_QUIET_MSEC 1000
+#define BENCH_NOTIFY_BATCH 64
+/* Ports per API call, well within the API message size limit */
+#define BENCH_PORTS_BATCH 512
+#define BENCH_CALLS_DEFAULT 10000
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+enum bench_option {
+    BENCH_PORTS = 256,
+    BENCH_FIRST_PORT,
+    BENCH_PID,
+    BENCH_IPL,
+    BENCH_CALLS,
+};
+
+enum bench_scenario {
+    BENCH_SCENARIO_PORTS,
+    BENCH_SCENARIO_API,
+};
+
+/* Measurements of one ports scale */
+struct ports_result {
+    unsigned int ports;
+    long long add_msec;
+    long long bytes_per_port;
+    long long failover_msec;
+    long long sync_msec;
+    long long delete_msec;
+};
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+
+static struct option bench_long_options[] = {
+    {"ports",       required_argument,      NULL,   BENCH_PORTS     },
+    {"first_port",  required_argument,      NULL,   BENCH_FIRST_PORT},
+    {"pid",         required_argument,      NULL,   BENCH_PID       },
+    {"ipl",         required_argument,      NULL,   BENCH_IPL       },
+    {"calls",       required_argument,      NULL,   BENCH_CALLS     },
+    {"help",        no_argument,            NULL,   'h'             },
+    {0,             0,                      0,      0               }
+};
+
+static struct bench_args {
+    enum bench_scenario scenario;
+    unsigned int calls;
+    unsigned int sizes[BENCH_MAX_SIZES];
+    unsigned int sizes_num;
+    unsigned long first_port;
+    int pid;
+    int ipl_id; /* -1 - failover and sync are not measured */
+} bench_args;
+
+static struct mlag_notify_subscriber *subscriber;
+static int notify_fd = -1;
+
+/* Asynchronous calls that failed, updated from the API workers */
+static volatile unsigned int async_errors;
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  This function prints usage message
+ *
+ * @return void
+ */
+static void
+show_help()
+{
+    printf( "\tmLAG benchmark.\n"
+            "\t=============================\n"
+            "\tUsage: mlag_bench (ports|api) [options]\n\n"
+            "\tRuns against a started mlag process.\n\n"
+            "\tports: for each scale, adds that many mLAG ports, measures\n"
+            "\tthe add time and the memory per port, optionally the\n"
+            "\tfailover and peer sync time, and deletes the ports. The\n"
+            "\tmlag process must allow the largest scale with --max_ports.\n\n"
+            "\tapi: measures the throughput of a query made with\n"
+            "\tsynchronous calls, and with mlag_api_async_submit.\n\n"
+            "\tOptions:\n"
+            "\t--calls=<n>                      api: number of calls (default = 10000).\n"
+            "\t--ports=<n>[,<n>...]             Scales (default = 64,512,2048).\n"
+            "\t--first_port=<id>                Interface index of the first port (default = 1).\n"
+            "\t--pid=<pid>                      mlag process, to measure its memory.\n"
+            "\t--ipl=<id>                       IPL to unbind and bind again, to measure\n"
+            "\t                                 failover and peer sync. The peer must be up.\n"
+            "\t(-h|--help)                      Show this help message & exit normally.\n");
+    exit(0);
+}
+
+/*
+ *  This function prints error message
+ *
+ * @return void
+ */
+static void
+show_error()
+{
+    fprintf(stderr,
+            "Bad parameter(s). Use --help to get parameters summary\n");
+    exit(1);
+}
+
+/*
+ *  This function parses the command line
+ *
+ * @param[in] argc - arguments number
+ * @param[in] argv - arguments
+ *
+ * @return void
+ */
+static void
+parse_args(int argc, char **argv)
+{
+    int c;
+    int option_index = 0;
+    char *pos, *end;
+
+    bench_args.calls = BENCH_CALLS_DEFAULT;
+    bench_args.sizes[0] = 64;
+    bench_args.sizes[1] = 512;
+    bench_args.sizes[2] = 2048;
+    bench_args.sizes_num = 3;
+    bench_args.first_port = 1;
+    bench_args.pid = 0;
+    bench_args.ipl_id = -1;
+
+    while (TRUE) {
+        c = getopt_long(argc, argv, "h", bench_long_options, &option_index);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+        case BENCH_PORTS:
+            bench_args.sizes_num = 0;
+            pos = optarg;
+            while (*pos != '\0') {
+                if (bench_args.sizes_num == BENCH_MAX_SIZES) {
+                    show_error();
+                }
+                bench_args.sizes[bench_args.sizes_num] =
+                    strtoul(pos, &end, 0);
+                if ((end == pos) ||
+                    (bench_args.sizes[bench_args.sizes_num] == 0) ||
+                    (bench_args.sizes[bench_args.sizes_num] >
+                     MLAG_MAX_PORTS_LIMIT)) {
+                    show_error();
+                }
+                if ((*end != ',') && (*end != '\0')) {
+                    show_error();
+                }
+                bench_args.sizes_num++;
+                pos = (*end == ',') ? end + 1 : end;
+            }
+            break;
+        case BENCH_FIRST_PORT:
+            bench_args.first_port = strtoul(optarg, NULL, 0);
+            break;
+        case BENCH_PID:
+            bench_args.pid = atoi(optarg);
+            break;
+        case BENCH_IPL:
+            bench_args.ipl_id = atoi(optarg);
+            break;
+        case BENCH_CALLS:
+            bench_args.calls = strtoul(optarg, NULL, 0);
+            if (bench_args.calls == 0) {
+                show_error();
+            }
+            break;
+        case 'h':
+            show_help();
+            break;
+        default:
+            show_error();
+            break;
+        }
+    }
+
+    if ((optind != argc - 1) || (bench_args.sizes_num == 0)) {
+        show_error();
+    }
+    if (strcmp(argv[optind], "ports") == 0) {
+        bench_args.scenario = BENCH_SCENARIO_PORTS;
+    }
+    else if (strcmp(argv[optind], "api") == 0) {
+        bench_args.scenario = BENCH_SCENARIO_API;
+    }
+    else {
+        show_error();
+    }
+}
+
+/*
+ *  This function returns a monotonic time stamp
+ *
+ * @return time in msec
+ */
+static long long
+now_msec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((long long)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/*
+ *  This function reads the resident memory of the mlag process
+ *
+ * @return resident memory in KB, -1 if not known
+ */
+static long long
+rss_kb_get(void)
+{
+    char path[64];
+    char line[128];
+    long long rss_kb = -1;
+    FILE *file;
+
+    if (bench_args.pid == 0) {
+        return -1;
+    }
+    snprintf(path, sizeof(path), "/proc/%d/status", bench_args.pid);
+    file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (sscanf(line, "VmRSS: %lld", &rss_kb) == 1) {
+            break;
+        }
+    }
+    fclose(file);
+    return rss_kb;
+}
+
+/*
+ *  This function adds or deletes ports, in chunks of BENCH_PORTS_BATCH
+ *
+ * @param[in] cmd - ACCESS_CMD_ADD or ACCESS_CMD_DELETE
+ * @param[in] ports - ports
+ * @param[in] ports_num - number of ports
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+ports_batch_set(enum access_cmd cmd, unsigned long *ports,
+                unsigned int ports_num)
+{
+    int err = 0;
+    unsigned int i, num;
+
+    for (i = 0; i < ports_num; i += num) {
+        num = ports_num - i;
+        if (num > BENCH_PORTS_BATCH) {
+            num = BENCH_PORTS_BATCH;
+        }
+        err = mlag_api_ports_set(cmd, &ports[i], num);
+        if (err) {
+            break;
+        }
+    }
+    return err;
+}
+
+/*
+ *  This function waits until the add/delete of all ports completed
+ *
+ * @param[in] ports_cfg - ports to wait for
+ * @param[in] ports_num - number of ports
+ * @param[in] done_state - state of a completed port
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+ports_cfg_wait(struct mlag_port_cfg_info *ports_cfg, unsigned int ports_num,
+               enum mlag_port_cfg_state done_state)
+{
+    int err = 0;
+    unsigned int i, num;
+    unsigned int done;
+    long long deadline = now_msec() + BENCH_CFG_TIMEOUT_MSEC;
+
+    while (TRUE) {
+        for (i = 0; i < ports_num; i += num) {
+            num = ports_num - i;
+            if (num > BENCH_PORTS_BATCH) {
+                num = BENCH_PORTS_BATCH;
+            }
+            err = mlag_api_ports_cfg_state_get(&ports_cfg[i], num);
+            if (err) {
+                goto bail;
+            }
+        }
+        done = 0;
+        for (i = 0; i < ports_num; i++) {
+            if (ports_cfg[i].state == MLAG_PORT_CFG_STATE_FAILED) {
+                fprintf(stderr, "Port [%lu] configuration failed\n",
+                        ports_cfg[i].port_id);
+                err = -EIO;
+                goto bail;
+            }
+            if (ports_cfg[i].state == done_state) {
+                done++;
+            }
+        }
+        if (done == ports_num) {
+            break;
+        }
+        if (now_msec() > deadline) {
+            err = -ETIMEDOUT;
+            goto bail;
+        }
+        usleep(BENCH_POLL_INTERVAL_MSEC * 1000);
+    }
+
+bail:
+    return err;
+}
+
+/*
+ *  This function waits for notifications. It returns once the peer
+ *  reaches the given state, and then no port state changed for
+ *  BENCH_QUIET_MSEC.
+ *
+ * @param[in] peer_state - peer state to wait for
+ * @param[out] peer_msec - time the peer state was reached
+ * @param[out] ports_msec - time of the last port state change,
+ *                          peer_msec if none came
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+notify_wait(enum mlag_peer_state peer_state, long long *peer_msec,
+            long long *ports_msec)
+{
+    int err = 0;
+    int peer_reached = FALSE;
+    unsigned int i, cnt;
+    long long now;
+    long long deadline = now_msec() + BENCH_PEER_TIMEOUT_MSEC;
+    struct pollfd pfd;
+    struct mlag_notification notifications[BENCH_NOTIFY_BATCH];
+
+    pfd.fd = notify_fd;
+    pfd.events = POLLIN;
+
+    while (TRUE) {
+        poll(&pfd, 1, BENCH_POLL_INTERVAL_MSEC);
+        do {
+            cnt = BENCH_NOTIFY_BATCH;
+            err = mlag_api_notify_read(subscriber, notifications, &cnt,
+                                       NULL);
+            if (err) {
+                goto bail;
+            }
+            now = now_msec();
+            for (i = 0; i < cnt; i++) {
+                if ((notifications[i].notification_type ==
+                     MLAG_NOTIFY_PEER_STATE_CHANGE) &&
+                    (notifications[i].notification_info.peer_state.peer_state
+                     == peer_state) && (peer_reached == FALSE)) {
+                    peer_reached = TRUE;
+                    *peer_msec = now;
+                    *ports_msec = now;
+                }
+                if ((notifications[i].notification_type ==
+                     MLAG_NOTIFY_PORT_OPER_STATE_CHANGE) &&
+                    (peer_reached == TRUE)) {
+                    *ports_msec = now;
+                }
+            }
+        } while (cnt > 0);
+
+        now = now_msec();
+        if ((peer_reached == TRUE) &&
+            (now - *ports_msec >= BENCH_QUIET_MSEC)) {
+            break;
+        }
+        if ((peer_reached == FALSE) && (now > deadline)) {
+            err = -ETIMEDOUT;
+            goto bail;
+        }
+    }
+
+bail:
+    return err;
+}
+
+/*
+ *  This function measures failover, by unbinding the IPL port, and
+ *  peer sync, by binding it again
+ *
+ * @param[out] result - measurements
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+ipl_flap_measure(struct ports_result *result)
+{
+    int err = 0;
+    unsigned long ipl_port = 0;
+    long long start, peer_msec, ports_msec;
+
+    err = mlag_api_ipl_port_get(bench_args.ipl_id, &ipl_port);
+    if (err) {
+        fprintf(stderr, "Failed to get IPL [%d] port, err [%d]\n",
+                bench_args.ipl_id, err);
+        goto bail;
+    }
+
+    /* Failover lasts until the ports settled after the peer went down */
+    start = now_msec();
+    err = mlag_api_ipl_port_set(ACCESS_CMD_DELETE, bench_args.ipl_id,
+                                ipl_port);
+    if (err) {
+        goto bail;
+    }
+    err = notify_wait(MLAG_PEER_DOWN, &peer_msec, &ports_msec);
+    if (err) {
+        fprintf(stderr, "Peer did not go down, err [%d]\n", err);
+        goto bail;
+    }
+    result->failover_msec = ports_msec - start;
+
+    /* Peer sync lasts until the peer is up again */
+    start = now_msec();
+    err = mlag_api_ipl_port_set(ACCESS_CMD_ADD, bench_args.ipl_id,
+                                ipl_port);
+    if (err) {
+        goto bail;
+    }
+    err = notify_wait(MLAG_PEER_UP, &peer_msec, &ports_msec);
+    if (err) {
+        fprintf(stderr, "Peer did not come up, err [%d]\n", err);
+        goto bail;
+    }
+    result->sync_msec = peer_msec - start;
+
+bail:
+    return err;
+}
+
+/*
+ *  This function runs the ports benchmark of one scale
+ *
+ * @param[in] ports_num - number of ports
+ * @param[out] result - measurements
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+ports_measure(unsigned int ports_num, struct ports_result *result)
+{
+    int err = 0;
+    unsigned int i;
+    long long start, rss_before, rss_after;
+    unsigned long *ports = NULL;
+    struct mlag_port_cfg_info *ports_cfg = NULL;
+
+    memset(result, 0, sizeof(*result));
+    result->ports = ports_num;
+    result->bytes_per_port = -1;
+    result->failover_msec = -1;
+    result->sync_msec = -1;
+
+    ports = (unsigned long *)calloc(ports_num, sizeof(*ports));
+    ports_cfg = (struct mlag_port_cfg_info *)calloc(ports_num,
+                                                    sizeof(*ports_cfg));
+    if ((ports == NULL) || (ports_cfg == NULL)) {
+        err = -ENOMEM;
+        goto bail;
+    }
+    for (i = 0; i < ports_num; i++) {
+        ports[i] = bench_args.first_port + i;
+        ports_cfg[i].port_id = ports[i];
+    }
+
+    rss_before = rss_kb_get();
+    start = now_msec();
+    err = ports_batch_set(ACCESS_CMD_ADD, ports, ports_num);
+    if (err) {
+        fprintf(stderr, "Failed to add [%u] ports, err [%d]\n",
+                ports_num, err);
+        goto bail;
+    }
+    err = ports_cfg_wait(ports_cfg, ports_num, MLAG_PORT_CFG_STATE_ADDED);
+    if (err) {
+        fprintf(stderr, "Add of [%u] ports did not complete, err [%d]\n",
+                ports_num, err);
+        goto bail;
+    }
+    result->add_msec = now_msec() - start;
+    rss_after = rss_kb_get();
+    if ((rss_before >= 0) && (rss_after >= 0)) {
+        result->bytes_per_port = ((rss_after - rss_before) * 1024) /
+                                 ports_num;
+    }
+
+    if (bench_args.ipl_id >= 0) {
+        err = ipl_flap_measure(result);
+        if (err) {
+            goto bail;
+        }
+    }
+
+    start = now_msec();
+    err = ports_batch_set(ACCESS_CMD_DELETE, ports, ports_num);
+    if (err) {
+        fprintf(stderr, "Failed to delete [%u] ports, err [%d]\n",
+                ports_num, err);
+        goto bail;
+    }
+    err = ports_cfg_wait(ports_cfg, ports_num, MLAG_PORT_CFG_STATE_DELETED);
+    if (err) {
+        fprintf(stderr, "Delete of [%u] ports did not complete, err [%d]\n",
+                ports_num, err);
+        goto bail;
+    }
+    result->delete_msec = now_msec() - start;
+
+bail:
+    free(ports);
+    free(ports_cfg);
+    return err;
+}
+
+/*
+ *  This function runs the ports benchmark for all scales
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+ports_bench(void)
+{
+    int err = 0;
+    unsigned int i;
+    struct ports_result result;
+
+    if (bench_args.ipl_id >= 0) {
+        err = mlag_api_notify_subscribe(
+            MLAG_NOTIFY_MASK(MLAG_NOTIFY_PEER_STATE_CHANGE) |
+            MLAG_NOTIFY_MASK(MLAG_NOTIFY_PORT_OPER_STATE_CHANGE),
+            &subscriber, &notify_fd);
+        if (err) {
+            fprintf(stderr, "Failed to subscribe to notifications, "
+                    "err [%d]\n", err);
+            goto bail;
+        }
+    }
+
+    /* -1 is printed for what was not measured */
+    printf("%8s %10s %12s %14s %10s %12s\n", "Ports", "Add msec",
+           "Bytes/port", "Failover msec", "Sync msec", "Delete msec");
+    for (i = 0; i < bench_args.sizes_num; i++) {
+        err = ports_measure(bench_args.sizes[i], &result);
+        if (err) {
+            goto bail;
+        }
+        printf("%8u %10lld %12lld %14lld %10lld %12lld\n", result.ports,
+               result.add_msec, result.bytes_per_port, result.failover_msec,
+               result.sync_msec, result.delete_msec);
+    }
+
+bail:
+    if (subscriber != NULL) {
+        mlag_api_notify_unsubscribe(subscriber);
+    }
+    return err;
+}
+
+/*
+ *  This function is the query measured by the api benchmark
+ *
+ * @param[in] arg - unused
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+api_query(void *arg)
+{
+    enum protocol_oper_state state;
+    (void)arg;
+
+    return mlag_api_protocol_oper_state_get(&state);
+}
+
+/*
+ *  This function is the completion callback of an asynchronous query
+ *
+ * @param[in] err - query result
+ * @param[in] cookie - unused
+ *
+ * @return void
+ */
+static void
+api_query_done(int err, void *cookie)
+{
+    (void)cookie;
+
+    if (err) {
+        __sync_fetch_and_add(&async_errors, 1);
+    }
+}
+
+/*
+ *  This function prints the result of an api benchmark run
+ *
+ * @param[in] mode - run name
+ * @param[in] msec - run duration
+ * @param[in] errors - failed calls
+ *
+ * @return void
+ */
+static void
+api_result_print(const char *mode, long long msec, unsigned int errors)
+{
+    if (msec == 0) {
+        msec = 1;
+    }
+    printf("%8s %10u %10lld %12lld %8u\n", mode, bench_args.calls, msec,
+           ((long long)bench_args.calls * 1000) / msec, errors);
+}
+
+/*
+ *  This function runs the api benchmark. The same query is made with
+ *  synchronous calls, one after the other on one connection, and then
+ *  with asynchronous calls spread on the pooled connections.
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+api_bench(void)
+{
+    int err = 0;
+    unsigned int i;
+    unsigned int errors = 0;
+    long long start;
+
+    printf("%8s %10s %10s %12s %8s\n", "Mode", "Calls", "msec",
+           "Calls/sec", "Errors");
+
+    start = now_msec();
+    for (i = 0; i < bench_args.calls; i++) {
+        if (api_query(NULL)) {
+            errors++;
+        }
+    }
+    api_result_print("sync", now_msec() - start, errors);
+
+    async_errors = 0;
+    start = now_msec();
+    for (i = 0; i < bench_args.calls; i++) {
+        err = mlag_api_async_submit(api_query, NULL, api_query_done, NULL);
+        if (err) {
+            fprintf(stderr, "Failed to submit call [%u], err [%d]\n", i, err);
+            goto bail;
+        }
+    }
+    mlag_api_async_flush();
+    api_result_print("async", now_msec() - start, async_errors);
+
+bail:
+    return err;
+}
+
+int
+main(int argc, char **argv)
+{
+    int err = 0;
+
+    parse_args(argc, argv);
+
+    if (bench_args.scenario == BENCH_SCENARIO_API) {
+        err = api_bench();
+    }
+    else {
+        err = ports_bench();
+    }
+
+    return (err ? 1 : 0);
+}
@@ -0,0 +1,1712 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <dirent.h>
+#include <libgen.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mount.h>
+#include <arpa/inet.h>
+#include <mlag_api.h>
+#include <mlag_api_defs.h>
+#include <mlag_snapshot.h>
+#include <utils/mlag_defs.h>
+#include "mlag_sim.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#define SIM_NODES 2
+/* Network namespace and veth end of node n are SIM_NETNS<n> */
+#define SIM_NETNS "mlag_sim"
+#define SIM_SUBNET "10.200.0."
+#define SIM_IPL_VLAN 4000
+#define SIM_MAC_VLAN 10
+#define SIM_SYSTEM_ID_BASE 0x0002c9a00000ULL
+#define SIM_MAC_BASE 0x0002c9b00000ULL
+/* In the private /tmp of each node */
+#define SIM_CTL_PATH "/tmp/mlag_sim.ctl"
+#define SIM_POLL_INTERVAL_MSEC 10
+#define SIM_START_TIMEOUT_MSEC 30000
+#define SIM_CFG_TIMEOUT_MSEC 60000
+#define SIM_PHASE_TIMEOUT_MSEC 120000
+#define SIM_STOP_TIMEOUT_MSEC 5000
+/* A phase converged once its condition held for this long */
+#define SIM_SETTLE_MSEC 1000
+#define SIM_NOTIFY_BATCH 256
+#define SIM_THREADS_MAX 128
+#define SIM_SCENARIOS_MAX 16
+#define SIM_PORTS_DEFAULT 64
+#define SIM_MACS_DEFAULT 1000
+#define SIM_FLAPS_DEFAULT 10
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+#define SIM_SYSTEM_ID(node) (SIM_SYSTEM_ID_BASE + (node))
+#define SIM_PEER(node) (((node) + 1) % SIM_NODES)
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+enum sim_option {
+    SIM_MLAG = 256,
+    SIM_LIB,
+    SIM_LOG_DIR,
+    SIM_PORTS,
+    SIM_FIRST_PORT,
+    SIM_MACS,
+    SIM_FLAPS,
+};
+
+/* Commands of the parent to the agent of a node */
+enum sim_cmd {
+    SIM_CMD_DAEMON_START,
+    SIM_CMD_DAEMON_KILL,
+    SIM_CMD_CONFIGURE,
+    SIM_CMD_PROTOCOL_START,
+    SIM_CMD_PROTOCOL_STOP,
+    SIM_CMD_IPL_STATE,
+    SIM_CMD_PORTS_STATE,
+    SIM_CMD_MAC_LEARN,
+    SIM_CMD_FDB_FLUSH,
+    SIM_CMD_STATE_GET,
+};
+
+struct sim_cmd_msg {
+    enum sim_cmd cmd;
+    int arg;
+};
+
+/* State of a node as the phases check it */
+struct sim_node_state {
+    int pid; /* 0 if the mlag process is not running */
+    enum system_role_state role;
+    int peer_up;
+    unsigned int ports_num;
+    unsigned int ports_full;
+    struct mlag_sim_ctl_rsp ctl;
+};
+
+struct sim_reply_msg {
+    int err;
+    struct sim_node_state state;
+};
+
+struct sim_node {
+    pid_t agent_pid;
+    int sock;
+    int log_fd;
+};
+
+struct sim_thread_cpu {
+    int tid;
+    char name[16];
+    long long ticks;
+};
+
+/* CPU time of the threads of an mlag process */
+struct sim_cpu {
+    int pid;
+    unsigned int threads_num;
+    struct sim_thread_cpu threads[SIM_THREADS_MAX];
+};
+
+struct sim_phase {
+    const char *name;
+    int (*trigger)(void);
+    int (*converged)(const struct sim_node_state *state);
+};
+
+struct sim_scenario {
+    const char *name;
+    const struct sim_phase *phases;
+    unsigned int phases_num;
+};
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+
+static struct option sim_long_options[] = {
+    {"mlag",        required_argument,      NULL,   SIM_MLAG        },
+    {"lib",         required_argument,      NULL,   SIM_LIB         },
+    {"log_dir",     required_argument,      NULL,   SIM_LOG_DIR     },
+    {"ports",       required_argument,      NULL,   SIM_PORTS       },
+    {"first_port",  required_argument,      NULL,   SIM_FIRST_PORT  },
+    {"macs",        required_argument,      NULL,   SIM_MACS        },
+    {"flaps",       required_argument,      NULL,   SIM_FLAPS       },
+    {"help",        no_argument,            NULL,   'h'             },
+    {0,             0,                      0,      0               }
+};
+
+static struct sim_args {
+    char mlag_path[PATH_MAX];
+    char lib_path[PATH_MAX];
+    const char *log_dir;
+    unsigned int ports_num;
+    unsigned long first_port;
+    unsigned int macs;
+    unsigned int flaps;
+    unsigned int scenarios[SIM_SCENARIOS_MAX];
+    unsigned int scenarios_num;
+} sim_args;
+
+static struct sim_node nodes[SIM_NODES];
+
+/* Set by the phases for the following ones */
+static unsigned int fdb_base[SIM_NODES];
+static int master_node = -1;
+
+/* Agent of a node */
+static int agent_sock = -1;
+static int agent_node;
+static pid_t daemon_pid;
+static unsigned long *agent_ports;
+static struct mlag_port_cfg_info *agent_ports_cfg;
+static unsigned int ipl_id;
+static int snapshot_opened;
+static struct mlag_snapshot_state snapshot_state;
+
+static int trigger_configure(void);
+static int trigger_ipl_down(void);
+static int trigger_ipl_up(void);
+static int trigger_peer_kill(void);
+static int trigger_peer_restart(void);
+static int trigger_mac_learn(void);
+static int trigger_fdb_flush(void);
+static int trigger_ports_flap(void);
+static int trigger_master_stop(void);
+static int trigger_master_start(void);
+static int converged_peers_up(const struct sim_node_state *state);
+static int converged_peers_down(const struct sim_node_state *state);
+static int converged_peer_gone(const struct sim_node_state *state);
+static int converged_macs_learned(const struct sim_node_state *state);
+static int converged_fdb_flushed(const struct sim_node_state *state);
+static int converged_standalone(const struct sim_node_state *state);
+
+static const struct sim_phase peer_up_phases[] = {
+    {"configure",       trigger_configure,      converged_peers_up      },
+};
+
+static const struct sim_phase ipl_flap_phases[] = {
+    {"ipl down",        trigger_ipl_down,       converged_peers_down    },
+    {"ipl up",          trigger_ipl_up,         converged_peers_up      },
+};
+
+static const struct sim_phase peer_reboot_phases[] = {
+    {"peer down",       trigger_peer_kill,      converged_peer_gone     },
+    {"peer up",         trigger_peer_restart,   converged_peers_up      },
+};
+
+static const struct sim_phase mac_storm_phases[] = {
+    {"learn",           trigger_mac_learn,      converged_macs_learned  },
+    {"flush",           trigger_fdb_flush,      converged_fdb_flushed   },
+};
+
+static const struct sim_phase port_flap_phases[] = {
+    {"flap",            trigger_ports_flap,     converged_peers_up      },
+};
+
+static const struct sim_phase switchover_phases[] = {
+    {"master stop",     trigger_master_stop,    converged_standalone    },
+    {"master start",    trigger_master_start,   converged_peers_up      },
+};
+
+/* The first scenario brings the peers up for the others, it always runs */
+static const struct sim_scenario sim_scenarios[] = {
+    {"peer_up", peer_up_phases, NUM_ELEMS(peer_up_phases)},
+    {"ipl_flap", ipl_flap_phases, NUM_ELEMS(ipl_flap_phases)},
+    {"peer_reboot", peer_reboot_phases, NUM_ELEMS(peer_reboot_phases)},
+    {"mac_storm", mac_storm_phases, NUM_ELEMS(mac_storm_phases)},
+    {"port_flap", port_flap_phases, NUM_ELEMS(port_flap_phases)},
+    {"switchover", switchover_phases, NUM_ELEMS(switchover_phases)},
+};
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  This function prints usage message
+ *
+ * @return void
+ */
+static void
+show_help()
+{
+    printf( "\tmLAG two node simulation.\n"
+            "\t=============================\n"
+            "\tUsage: mlag_sim [options] [scenario...]\n\n"
+            "\tRuns two mlag processes, each in a network namespace of its\n"
+            "\town with a private /tmp and /dev/shm, connected by a veth\n"
+            "\tpair that carries the IPL. libmlagsim is preloaded in both,\n"
+            "\tin place of the communication and control learning\n"
+            "\tlibraries. The mlag process must be built with\n"
+            "\t--enable-sl-sim. Needs root and iproute2.\n\n"
+            "\tEach phase of a scenario reports the time to converge, the\n"
+            "\tIPL messages and bytes sent, and the CPU time of each thread\n"
+            "\tof each mlag process.\n\n"
+            "\tScenarios (default = all, peer_up always runs first):\n"
+            "\tpeer_up                          Configure both nodes, until the peers are up.\n"
+            "\tipl_flap                         IPL down and up.\n"
+            "\tpeer_reboot                      Kill node 0 and start it again.\n"
+            "\tmac_storm                        Learn MACs on node 0 and flush them.\n"
+            "\tport_flap                        Flap the ports of node 0.\n"
+            "\tswitchover                       Stop the master protocol and start it again.\n\n"
+            "\tOptions:\n"
+            "\t--mlag=<path>                    mlag process (default = ../mlag from mlag_sim).\n"
+            "\t--lib=<path>                     libmlagsim (default = .libs/libmlagsim.so from mlag_sim).\n"
+            "\t--log_dir=<path>                 Directory of the mlag process output (default = .).\n"
+            "\t--ports=<n>                      Number of mLAG ports (default = 64).\n"
+            "\t--first_port=<id>                Interface index of the first port (default = 1),\n"
+            "\t                                 the IPL port follows the mLAG ports.\n"
+            "\t--macs=<n>                       mac_storm: MACs to learn (default = 1000).\n"
+            "\t--flaps=<n>                      port_flap: down and up rounds (default = 10).\n"
+            "\t(-h|--help)                      Show this help message & exit normally.\n");
+    exit(0);
+}
+
+/*
+ *  This function prints error message
+ *
+ * @return void
+ */
+static void
+show_error()
+{
+    fprintf(stderr,
+            "Bad parameter(s). Use --help to get parameters summary\n");
+    exit(1);
+}
+
+/*
+ *  This function sets the default paths, next to mlag_sim
+ *
+ * @return void
+ */
+static void
+default_paths_set(void)
+{
+    char exe[PATH_MAX];
+    ssize_t len;
+    char *dir;
+
+    len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (len <= 0) {
+        strcpy(exe, ".");
+    }
+    else {
+        exe[len] = '\0';
+    }
+    dir = dirname(exe);
+    snprintf(sim_args.mlag_path, sizeof(sim_args.mlag_path), "%s/../mlag",
+             dir);
+    snprintf(sim_args.lib_path, sizeof(sim_args.lib_path),
+             "%s/.libs/libmlagsim.so", dir);
+}
+
+/*
+ *  This function parses the command line
+ *
+ * @param[in] argc - arguments number
+ * @param[in] argv - arguments
+ *
+ * @return void
+ */
+static void
+parse_args(int argc, char **argv)
+{
+    int c;
+    int option_index = 0;
+    unsigned int i;
+
+    default_paths_set();
+    sim_args.log_dir = ".";
+    sim_args.ports_num = SIM_PORTS_DEFAULT;
+    sim_args.first_port = 1;
+    sim_args.macs = SIM_MACS_DEFAULT;
+    sim_args.flaps = SIM_FLAPS_DEFAULT;
+
+    while (TRUE) {
+        c = getopt_long(argc, argv, "h", sim_long_options, &option_index);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+        case SIM_MLAG:
+            snprintf(sim_args.mlag_path, sizeof(sim_args.mlag_path), "%s",
+                     optarg);
+            break;
+        case SIM_LIB:
+            snprintf(sim_args.lib_path, sizeof(sim_args.lib_path), "%s",
+                     optarg);
+            break;
+        case SIM_LOG_DIR:
+            sim_args.log_dir = optarg;
+            break;
+        case SIM_PORTS:
+            sim_args.ports_num = strtoul(optarg, NULL, 0);
+            if ((sim_args.ports_num == 0) ||
+                (sim_args.ports_num > MLAG_MAX_PORTS_LIMIT)) {
+                show_error();
+            }
+            break;
+        case SIM_FIRST_PORT:
+            sim_args.first_port = strtoul(optarg, NULL, 0);
+            break;
+        case SIM_MACS:
+            sim_args.macs = strtoul(optarg, NULL, 0);
+            if (sim_args.macs == 0) {
+                show_error();
+            }
+            break;
+        case SIM_FLAPS:
+            sim_args.flaps = strtoul(optarg, NULL, 0);
+            if (sim_args.flaps == 0) {
+                show_error();
+            }
+            break;
+        case 'h':
+            show_help();
+            break;
+        default:
+            show_error();
+            break;
+        }
+    }
+
+    /* peer_up first, then the given scenarios in order */
+    sim_args.scenarios[sim_args.scenarios_num++] = 0;
+    if (optind == argc) {
+        for (i = 1; i < NUM_ELEMS(sim_scenarios); i++) {
+            sim_args.scenarios[sim_args.scenarios_num++] = i;
+        }
+    }
+    for (; optind < argc; optind++) {
+        for (i = 0; i < NUM_ELEMS(sim_scenarios); i++) {
+            if (strcmp(argv[optind], sim_scenarios[i].name) == 0) {
+                break;
+            }
+        }
+        if ((i == NUM_ELEMS(sim_scenarios)) ||
+            (sim_args.scenarios_num == SIM_SCENARIOS_MAX)) {
+            show_error();
+        }
+        if (i > 0) {
+            sim_args.scenarios[sim_args.scenarios_num++] = i;
+        }
+    }
+}
+
+/*
+ *  This function returns a monotonic time stamp
+ *
+ * @return time in msec
+ */
+static long long
+now_msec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((long long)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/*
+ *  This function runs a shell command
+ *
+ * @param[in] fmt - command format
+ *
+ * @return 0 when successful, -EIO if the command failed
+ */
+static int
+shell_run(const char *fmt, ...)
+{
+    char cmd[256];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(cmd, sizeof(cmd), fmt, args);
+    va_end(args);
+
+    if (system(cmd) != 0) {
+        fprintf(stderr, "Failed to run [%s]\n", cmd);
+        return -EIO;
+    }
+    return 0;
+}
+
+/*
+ *  This function deletes the network namespaces, with the veth pair
+ *
+ * @return void
+ */
+static void
+net_cleanup(void)
+{
+    int node;
+
+    for (node = 0; node < SIM_NODES; node++) {
+        shell_run("ip netns del %s%d 2>/dev/null || true", SIM_NETNS, node);
+    }
+}
+
+/*
+ *  This function creates a network namespace for each node, connected
+ *  by a veth pair
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+net_setup(void)
+{
+    int err = 0;
+    int node;
+
+    net_cleanup();
+    for (node = 0; node < SIM_NODES; node++) {
+        err = shell_run("ip netns add %s%d", SIM_NETNS, node);
+        if (err) {
+            goto bail;
+        }
+    }
+    err = shell_run("ip link add %s0 netns %s0 type veth peer name %s1 "
+                    "netns %s1", SIM_NETNS, SIM_NETNS, SIM_NETNS, SIM_NETNS);
+    if (err) {
+        goto bail;
+    }
+    for (node = 0; node < SIM_NODES; node++) {
+        err = shell_run("ip -n %s%d addr add %s%d/24 dev %s%d", SIM_NETNS,
+                        node, SIM_SUBNET, node + 1, SIM_NETNS, node);
+        if (err) {
+            goto bail;
+        }
+        err = shell_run("ip -n %s%d link set dev %s%d up", SIM_NETNS, node,
+                        SIM_NETNS, node);
+        if (err) {
+            goto bail;
+        }
+        err = shell_run("ip -n %s%d link set dev lo up", SIM_NETNS, node);
+        if (err) {
+            goto bail;
+        }
+    }
+
+bail:
+    return err;
+}
+
+/*
+ *  This function sets the IPL link state, the veth end of node 0
+ *
+ * @param[in] up - TRUE to set the link up
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+net_ipl_set(int up)
+{
+    return shell_run("ip -n %s0 link set dev %s0 %s", SIM_NETNS, SIM_NETNS,
+                     (up ? "up" : "down"));
+}
+
+/*
+ *  This function moves the agent to the namespaces of its node. /tmp,
+ *  where the API socket is, and /dev/shm, where the notification and
+ *  snapshot regions are, are private to the node.
+ *
+ * @param[in] node - node index
+ *
+ * @return 0 when successful, otherwise -errno
+ */
+static int
+agent_ns_enter(int node)
+{
+    int err = 0;
+    int fd;
+    char path[64];
+
+    snprintf(path, sizeof(path), "/var/run/netns/%s%d", SIM_NETNS, node);
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        err = -errno;
+        goto bail;
+    }
+    if (setns(fd, CLONE_NEWNET) < 0) {
+        err = -errno;
+        close(fd);
+        goto bail;
+    }
+    close(fd);
+
+    if ((unshare(CLONE_NEWNS) < 0) ||
+        (mount("none", "/", NULL, MS_REC | MS_PRIVATE, NULL) < 0) ||
+        (mount("tmpfs", "/tmp", "tmpfs", 0, NULL) < 0) ||
+        (mount("tmpfs", "/dev/shm", "tmpfs", 0, NULL) < 0)) {
+        err = -errno;
+        goto bail;
+    }
+
+bail:
+    return err;
+}
+
+/*
+ *  This function sends a request to the stand-ins of the node's mlag
+ *  process
+ *
+ * @param[in] req - request
+ * @param[out] rsp - reply
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+agent_ctl(const struct mlag_sim_ctl_req *req, struct mlag_sim_ctl_rsp *rsp)
+{
+    int err = 0;
+    int fd;
+    struct sockaddr_un addr;
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) {
+        return -errno;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, SIM_CTL_PATH);
+    if ((connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        (send(fd, req, sizeof(*req), 0) != sizeof(*req)) ||
+        (recv(fd, rsp, sizeof(*rsp), 0) != sizeof(*rsp))) {
+        err = (errno != 0) ? -errno : -EIO;
+        goto bail;
+    }
+    err = rsp->err;
+
+bail:
+    close(fd);
+    return err;
+}
+
+/*
+ *  This function stops the mlag process of the node
+ *
+ * @param[in] sig - SIGTERM to let it deinit, SIGKILL to crash it
+ *
+ * @return void
+ */
+static void
+agent_daemon_stop(int sig)
+{
+    long long deadline = now_msec() + SIM_STOP_TIMEOUT_MSEC;
+
+    /* The snapshot region is truncated by the next mlag process */
+    if (snapshot_opened) {
+        mlag_snapshot_close();
+        snapshot_opened = FALSE;
+    }
+    if (daemon_pid <= 0) {
+        return;
+    }
+
+    kill(daemon_pid, sig);
+    while ((sig != SIGKILL) && (now_msec() < deadline)) {
+        if (waitpid(daemon_pid, NULL, WNOHANG) == daemon_pid) {
+            daemon_pid = 0;
+            return;
+        }
+        usleep(SIM_POLL_INTERVAL_MSEC * 1000);
+    }
+    kill(daemon_pid, SIGKILL);
+    waitpid(daemon_pid, NULL, 0);
+    daemon_pid = 0;
+}
+
+/*
+ *  This function starts the mlag process of the node, with the
+ *  stand-ins preloaded, and waits until its API answers
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+agent_daemon_start(void)
+{
+    int err = 0;
+    pid_t pid;
+    char max_ports[32];
+    long long deadline;
+    enum protocol_oper_state state;
+
+    if (daemon_pid > 0) {
+        return -EBUSY;
+    }
+    snprintf(max_ports, sizeof(max_ports), "--max_ports=%u",
+             sim_args.ports_num);
+
+    pid = fork();
+    if (pid < 0) {
+        return -errno;
+    }
+    if (pid == 0) {
+        dup2(nodes[agent_node].log_fd, STDOUT_FILENO);
+        dup2(nodes[agent_node].log_fd, STDERR_FILENO);
+        setenv("LD_PRELOAD", sim_args.lib_path, 1);
+        setenv(MLAG_SIM_CTL_ENV, SIM_CTL_PATH, 1);
+        execl(sim_args.mlag_path, sim_args.mlag_path, max_ports,
+              (char *)NULL);
+        _exit(127);
+    }
+    daemon_pid = pid;
+
+    deadline = now_msec() + SIM_START_TIMEOUT_MSEC;
+    while (TRUE) {
+        if (waitpid(daemon_pid, NULL, WNOHANG) == daemon_pid) {
+            fprintf(stderr, "Node %d mlag process exited\n", agent_node);
+            daemon_pid = 0;
+            err = -ECHILD;
+            goto bail;
+        }
+        if ((mlag_api_protocol_oper_state_get(&state) == 0) &&
+            (mlag_snapshot_open() == 0)) {
+            snapshot_opened = TRUE;
+            break;
+        }
+        if (now_msec() > deadline) {
+            err = -ETIMEDOUT;
+            goto bail;
+        }
+        usleep(SIM_POLL_INTERVAL_MSEC * 1000);
+    }
+
+bail:
+    if (err) {
+        agent_daemon_stop(SIGKILL);
+    }
+    return err;
+}
+
+/*
+ *  This function notifies a port state for all mLAG ports of the node
+ *
+ * @param[in] state - port state
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+agent_ports_notify(enum oes_port_oper_state state)
+{
+    int err = 0;
+    unsigned int i, num, done;
+    struct port_state_info ports[SIM_NOTIFY_BATCH];
+
+    for (done = 0; done < sim_args.ports_num; done += num) {
+        num = sim_args.ports_num - done;
+        if (num > SIM_NOTIFY_BATCH) {
+            num = SIM_NOTIFY_BATCH;
+        }
+        for (i = 0; i < num; i++) {
+            ports[i].port_id = agent_ports[done + i];
+            ports[i].port_state = state;
+        }
+        err = mlag_api_ports_state_change_notify(ports, num);
+        if (err) {
+            break;
+        }
+    }
+    return err;
+}
+
+/*
+ *  This function notifies the IPL port state of the node
+ *
+ * @param[in] state - port state
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+agent_ipl_notify(enum oes_port_oper_state state)
+{
+    struct port_state_info ipl_port;
+
+    ipl_port.port_id = sim_args.first_port + sim_args.ports_num;
+    ipl_port.port_state = state;
+    return mlag_api_ports_state_change_notify(&ipl_port, 1);
+}
+
+/*
+ *  This function notifies the node is up, as the switch would once
+ *  the protocol started: the IPL and the mLAG ports, the VLANs and the
+ *  peer management link
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+agent_up_notify(void)
+{
+    int err = 0;
+    struct vlan_state_info vlans[2];
+
+    err = agent_ipl_notify(OES_PORT_UP);
+    if (err) {
+        goto bail;
+    }
+    err = agent_ports_notify(OES_PORT_UP);
+    if (err) {
+        goto bail;
+    }
+
+    vlans[0].vlan_state = VLAN_UP;
+    vlans[0].vlan_id = SIM_IPL_VLAN;
+    vlans[1].vlan_state = VLAN_UP;
+    vlans[1].vlan_id = SIM_MAC_VLAN;
+    err = mlag_api_vlans_state_change_notify(vlans, NUM_ELEMS(vlans));
+    if (err) {
+        goto bail;
+    }
+    err = mlag_api_vlans_state_change_sync_finish_notify();
+    if (err) {
+        goto bail;
+    }
+    err = mlag_api_mgmt_peer_state_notify(SIM_SYSTEM_ID(SIM_PEER(agent_node)),
+                                          MGMT_UP);
+
+bail:
+    return err;
+}
+
+/*
+ *  This function starts the protocol and notifies the node is up
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+agent_protocol_start(void)
+{
+    int err = 0;
+    struct mlag_start_params params;
+
+    memset(&params, 0, sizeof(params));
+    err = mlag_api_start(SIM_SYSTEM_ID(agent_node), &params);
+    if (err) {
+        fprintf(stderr, "Node %d failed to start, err [%d]\n", agent_node,
+                err);
+        goto bail;
+    }
+    err = agent_up_notify();
+
+bail:
+    return err;
+}
+
+/*
+ *  This function waits until the add of all mLAG ports completed
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+agent_ports_cfg_wait(void)
+{
+    int err = 0;
+    unsigned int i;
+    long long deadline = now_msec() + SIM_CFG_TIMEOUT_MSEC;
+
+    while (TRUE) {
+        err = mlag_api_ports_cfg_state_get(agent_ports_cfg,
+                                           sim_args.ports_num);
+        if (err) {
+            goto bail;
+        }
+        for (i = 0; i < sim_args.ports_num; i++) {
+            if (agent_ports_cfg[i].state == MLAG_PORT_CFG_STATE_FAILED) {
+                err = -EIO;
+                goto bail;
+            }
+            if (agent_ports_cfg[i].state != MLAG_PORT_CFG_STATE_ADDED) {
+                break;
+            }
+        }
+        if (i == sim_args.ports_num) {
+            break;
+        }
+        if (now_msec() > deadline) {
+            err = -ETIMEDOUT;
+            goto bail;
+        }
+        usleep(SIM_POLL_INTERVAL_MSEC * 1000);
+    }
+
+bail:
+    return err;
+}
+
+/*
+ *  This function configures the node as a fresh mlag process needs it
+ *  and starts the protocol
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+agent_configure(void)
+{
+    int err = 0;
+    struct oes_ip_addr local_ip, peer_ip;
+    char ip[32];
+
+    err = mlag_api_fdb_init(0, NULL);
+    if (err) {
+        goto bail;
+    }
+    err = mlag_api_fdb_start();
+    if (err) {
+        goto bail;
+    }
+
+    err = mlag_api_ipl_set(ACCESS_CMD_CREATE, &ipl_id);
+    if (err) {
+        goto bail;
+    }
+    err = mlag_api_ipl_port_set(ACCESS_CMD_ADD, ipl_id,
+                                sim_args.first_port + sim_args.ports_num);
+    if (err) {
+        goto bail;
+    }
+    /* IPL addresses are in host order */
+    memset(&local_ip, 0, sizeof(local_ip));
+    memset(&peer_ip, 0, sizeof(peer_ip));
+    local_ip.version = OES_IPV4;
+    snprintf(ip, sizeof(ip), SIM_SUBNET "%d", agent_node + 1);
+    local_ip.addr.ipv4.s_addr = ntohl(inet_addr(ip));
+    peer_ip.version = OES_IPV4;
+    snprintf(ip, sizeof(ip), SIM_SUBNET "%d", SIM_PEER(agent_node) + 1);
+    peer_ip.addr.ipv4.s_addr = ntohl(inet_addr(ip));
+    err = mlag_api_ipl_ip_set(ACCESS_CMD_ADD, ipl_id, SIM_IPL_VLAN,
+                              &local_ip, &peer_ip);
+    if (err) {
+        goto bail;
+    }
+
+    err = mlag_api_ports_set(ACCESS_CMD_ADD, agent_ports, sim_args.ports_num);
+    if (err) {
+        goto bail;
+    }
+    err = agent_ports_cfg_wait();
+    if (err) {
+        goto bail;
+    }
+
+    err = agent_protocol_start();
+
+bail:
+    if (err) {
+        fprintf(stderr, "Node %d configuration failed, err [%d]\n",
+                agent_node, err);
+    }
+    return err;
+}
+
+/*
+ *  This function gets the state of the node
+ *
+ * @param[out] state - node state
+ *
+ * @return void
+ */
+static void
+agent_state_get(struct sim_node_state *state)
+{
+    unsigned int i;
+    struct mlag_sim_ctl_req req;
+
+    memset(state, 0, sizeof(*state));
+    state->role = MLAG_NONE;
+    if (daemon_pid <= 0) {
+        return;
+    }
+    state->pid = daemon_pid;
+
+    if (snapshot_opened &&
+        (mlag_snapshot_state_get(&snapshot_state) == 0)) {
+        state->role = snapshot_state.system_role_state;
+        for (i = 0; i < snapshot_state.peers_num; i++) {
+            if ((snapshot_state.peers[i].system_peer_id ==
+                 SIM_SYSTEM_ID(SIM_PEER(agent_node))) &&
+                (snapshot_state.peers[i].peer_state == MLAG_PEER_UP)) {
+                state->peer_up = TRUE;
+            }
+        }
+        state->ports_num = snapshot_state.ports_num;
+        for (i = 0; i < snapshot_state.ports_num; i++) {
+            if (snapshot_state.ports[i].port_oper_state == ACTIVE_FULL) {
+                state->ports_full++;
+            }
+        }
+    }
+
+    /* Statistics are left 0 if the stand-ins do not answer */
+    memset(&req, 0, sizeof(req));
+    req.op = MLAG_SIM_CTL_STATS_GET;
+    agent_ctl(&req, &state->ctl);
+}
+
+/*
+ *  This function runs a command of the parent
+ *
+ * @param[in] msg - command
+ * @param[out] reply - reply
+ *
+ * @return void
+ */
+static void
+agent_cmd_run(const struct sim_cmd_msg *msg, struct sim_reply_msg *reply)
+{
+    struct mlag_sim_ctl_req req;
+    struct mlag_sim_ctl_rsp rsp;
+
+    memset(reply, 0, sizeof(*reply));
+    switch (msg->cmd) {
+    case SIM_CMD_DAEMON_START:
+        reply->err = agent_daemon_start();
+        break;
+    case SIM_CMD_DAEMON_KILL:
+        agent_daemon_stop(SIGKILL);
+        break;
+    case SIM_CMD_CONFIGURE:
+        reply->err = agent_configure();
+        break;
+    case SIM_CMD_PROTOCOL_START:
+        reply->err = agent_protocol_start();
+        break;
+    case SIM_CMD_PROTOCOL_STOP:
+        reply->err = mlag_api_stop();
+        break;
+    case SIM_CMD_IPL_STATE:
+        reply->err = agent_ipl_notify(msg->arg);
+        break;
+    case SIM_CMD_PORTS_STATE:
+        reply->err = agent_ports_notify(msg->arg);
+        break;
+    case SIM_CMD_MAC_LEARN:
+        memset(&req, 0, sizeof(req));
+        req.op = MLAG_SIM_CTL_FDB_LEARN;
+        req.count = msg->arg;
+        req.mac_base = SIM_MAC_BASE;
+        req.first_port = sim_args.first_port;
+        req.ports_num = sim_args.ports_num;
+        req.vid = SIM_MAC_VLAN;
+        reply->err = agent_ctl(&req, &rsp);
+        break;
+    case SIM_CMD_FDB_FLUSH:
+        reply->err = mlag_api_fdb_uc_flush_set(0);
+        break;
+    case SIM_CMD_STATE_GET:
+        agent_state_get(&reply->state);
+        break;
+    default:
+        reply->err = -EINVAL;
+        break;
+    }
+}
+
+/*
+ *  This function is the agent of a node. It runs in the namespaces of
+ *  the node, owns its mlag process and makes its API calls. It exits
+ *  once the parent closes the socket.
+ *
+ * @param[in] node - node index
+ * @param[in] sock - socket to the parent
+ *
+ * @return void
+ */
+static void
+agent_run(int node, int sock)
+{
+    ssize_t ret;
+    unsigned int i;
+    struct sim_cmd_msg msg;
+    struct sim_reply_msg reply;
+
+    agent_node = node;
+    agent_sock = sock;
+
+    memset(&reply, 0, sizeof(reply));
+    agent_ports = (unsigned long *)calloc(sim_args.ports_num,
+                                          sizeof(*agent_ports));
+    agent_ports_cfg = (struct mlag_port_cfg_info *)
+                      calloc(sim_args.ports_num, sizeof(*agent_ports_cfg));
+    if ((agent_ports == NULL) || (agent_ports_cfg == NULL)) {
+        reply.err = -ENOMEM;
+    }
+    else {
+        for (i = 0; i < sim_args.ports_num; i++) {
+            agent_ports[i] = sim_args.first_port + i;
+            agent_ports_cfg[i].port_id = agent_ports[i];
+        }
+        reply.err = agent_ns_enter(node);
+    }
+    /* The first reply tells the agent is ready */
+    send(sock, &reply, sizeof(reply), MSG_NOSIGNAL);
+    if (reply.err) {
+        return;
+    }
+
+    while (TRUE) {
+        ret = recv(sock, &msg, sizeof(msg), 0);
+        if ((ret < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (ret != sizeof(msg)) {
+            break;
+        }
+        agent_cmd_run(&msg, &reply);
+        if (send(sock, &reply, sizeof(reply), MSG_NOSIGNAL) !=
+            sizeof(reply)) {
+            break;
+        }
+    }
+
+    agent_daemon_stop(SIGTERM);
+}
+
+/*
+ *  This function sends a command to the agent of a node
+ *
+ * @param[in] node - node index
+ * @param[in] cmd - command
+ * @param[in] arg - command argument
+ * @param[out] state - node state, may be NULL
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+node_cmd(int node, enum sim_cmd cmd, int arg, struct sim_node_state *state)
+{
+    struct sim_cmd_msg msg;
+    struct sim_reply_msg reply;
+
+    msg.cmd = cmd;
+    msg.arg = arg;
+    if ((send(nodes[node].sock, &msg, sizeof(msg), MSG_NOSIGNAL) !=
+         sizeof(msg)) ||
+        (recv(nodes[node].sock, &reply, sizeof(reply), 0) != sizeof(reply))) {
+        fprintf(stderr, "Node %d agent is gone\n", node);
+        return -EPIPE;
+    }
+    if (state != NULL) {
+        *state = reply.state;
+    }
+    if (reply.err) {
+        fprintf(stderr, "Node %d command [%d] failed, err [%d]\n", node, cmd,
+                reply.err);
+    }
+    return reply.err;
+}
+
+/*
+ *  This function gets the state of all nodes
+ *
+ * @param[out] state - state of each node
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+nodes_state_get(struct sim_node_state *state)
+{
+    int err = 0;
+    int node;
+
+    for (node = 0; node < SIM_NODES; node++) {
+        err = node_cmd(node, SIM_CMD_STATE_GET, 0, &state[node]);
+        if (err) {
+            break;
+        }
+    }
+    return err;
+}
+
+/*
+ *  This function starts the agent of a node and waits until it is in
+ *  the namespaces of the node
+ *
+ * @param[in] node - node index
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+node_start(int node)
+{
+    int err = 0;
+    int i;
+    int sv[2];
+    pid_t pid;
+    char path[PATH_MAX];
+    struct sim_reply_msg reply;
+
+    snprintf(path, sizeof(path), "%s/mlag_sim_node%d.log", sim_args.log_dir,
+             node);
+    nodes[node].log_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC |
+                              O_APPEND | O_CLOEXEC, 0644);
+    if (nodes[node].log_fd < 0) {
+        err = -errno;
+        fprintf(stderr, "Failed to open [%s], err [%d]\n", path, err);
+        goto bail;
+    }
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) {
+        err = -errno;
+        goto bail;
+    }
+
+    pid = fork();
+    if (pid < 0) {
+        err = -errno;
+        close(sv[0]);
+        close(sv[1]);
+        goto bail;
+    }
+    if (pid == 0) {
+        close(sv[0]);
+        for (i = 0; i < node; i++) {
+            close(nodes[i].sock);
+        }
+        agent_run(node, sv[1]);
+        exit(0);
+    }
+    close(sv[1]);
+    nodes[node].agent_pid = pid;
+    nodes[node].sock = sv[0];
+
+    if (recv(nodes[node].sock, &reply, sizeof(reply), 0) != sizeof(reply)) {
+        err = -EPIPE;
+        goto bail;
+    }
+    err = reply.err;
+    if (err) {
+        fprintf(stderr, "Node %d failed to enter its namespaces, err [%d]\n",
+                node, err);
+        goto bail;
+    }
+    err = node_cmd(node, SIM_CMD_DAEMON_START, 0, NULL);
+
+bail:
+    return err;
+}
+
+/*
+ *  This function stops the agent of a node, which stops its mlag
+ *  process
+ *
+ * @param[in] node - node index
+ *
+ * @return void
+ */
+static void
+node_stop(int node)
+{
+    if (nodes[node].agent_pid > 0) {
+        close(nodes[node].sock);
+        waitpid(nodes[node].agent_pid, NULL, 0);
+        nodes[node].agent_pid = 0;
+    }
+    if (nodes[node].log_fd >= 0) {
+        close(nodes[node].log_fd);
+        nodes[node].log_fd = -1;
+    }
+}
+
+/*
+ *  This function reads the CPU time of each thread of an mlag process
+ *
+ * @param[in] pid - mlag process, 0 if not running
+ * @param[out] cpu - CPU time
+ *
+ * @return void
+ */
+static void
+cpu_sample(int pid, struct sim_cpu *cpu)
+{
+    char path[64];
+    char line[512];
+    char *start, *end;
+    long long utime, stime;
+    DIR *dir;
+    FILE *file;
+    struct dirent *ent;
+    struct sim_thread_cpu *thread;
+
+    cpu->pid = pid;
+    cpu->threads_num = 0;
+    if (pid <= 0) {
+        return;
+    }
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    dir = opendir(path);
+    if (dir == NULL) {
+        return;
+    }
+    while (((ent = readdir(dir)) != NULL) &&
+           (cpu->threads_num < SIM_THREADS_MAX)) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/proc/%d/task/%s/stat", pid,
+                 ent->d_name);
+        file = fopen(path, "r");
+        if (file == NULL) {
+            continue;
+        }
+        if (fgets(line, sizeof(line), file) == NULL) {
+            fclose(file);
+            continue;
+        }
+        fclose(file);
+
+        /* tid (name) state ... utime stime, utime is field 14 */
+        start = strchr(line, '(');
+        end = strrchr(line, ')');
+        if ((start == NULL) || (end == NULL) ||
+            (sscanf(end + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+                    "%lld %lld", &utime, &stime) != 2)) {
+            continue;
+        }
+        thread = &cpu->threads[cpu->threads_num++];
+        thread->tid = atoi(ent->d_name);
+        *end = '\0';
+        snprintf(thread->name, sizeof(thread->name), "%s", start + 1);
+        thread->ticks = utime + stime;
+    }
+    closedir(dir);
+}
+
+/*
+ *  This function prints the CPU time the threads of an mlag process
+ *  spent between two samples
+ *
+ * @param[in] node - node index
+ * @param[in] before - first sample
+ * @param[in] after - second sample
+ *
+ * @return void
+ */
+static void
+cpu_print(int node, const struct sim_cpu *before, const struct sim_cpu *after)
+{
+    unsigned int i, j;
+    long long ticks;
+    long long hz = sysconf(_SC_CLK_TCK);
+    int printed = FALSE;
+
+    printf("%27s node%d cpu msec:", "", node);
+    for (i = 0; i < after->threads_num; i++) {
+        ticks = after->threads[i].ticks;
+        /* A restarted process is counted from its start */
+        if (before->pid == after->pid) {
+            for (j = 0; j < before->threads_num; j++) {
+                if (before->threads[j].tid == after->threads[i].tid) {
+                    ticks -= before->threads[j].ticks;
+                    break;
+                }
+            }
+        }
+        if (ticks > 0) {
+            printf(" %s/%d=%lld", after->threads[i].name,
+                   after->threads[i].tid, (ticks * 1000) / hz);
+            printed = TRUE;
+        }
+    }
+    printf("%s\n", (printed ? "" : " none"));
+}
+
+/*
+ *  This function runs a phase. The phase converged when its condition
+ *  last became true, provided it then held for SIM_SETTLE_MSEC. The
+ *  IPL messages and CPU time are counted until it converged.
+ *
+ * @param[in] scenario - scenario of the phase
+ * @param[in] phase - phase
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+phase_run(const struct sim_scenario *scenario, const struct sim_phase *phase)
+{
+    int err = 0;
+    int node;
+    long long start, now;
+    long long converged_msec = -1;
+    unsigned long long msgs = 0, bytes = 0;
+    struct sim_node_state before[SIM_NODES];
+    struct sim_node_state state[SIM_NODES];
+    struct sim_node_state at[SIM_NODES];
+    static struct sim_cpu cpu_before[SIM_NODES];
+    static struct sim_cpu cpu_at[SIM_NODES];
+
+    err = nodes_state_get(before);
+    if (err) {
+        goto bail;
+    }
+    for (node = 0; node < SIM_NODES; node++) {
+        cpu_sample(before[node].pid, &cpu_before[node]);
+    }
+
+    start = now_msec();
+    err = phase->trigger();
+    if (err) {
+        fprintf(stderr, "%s: %s failed, err [%d]\n", scenario->name,
+                phase->name, err);
+        goto bail;
+    }
+
+    while (TRUE) {
+        err = nodes_state_get(state);
+        if (err) {
+            goto bail;
+        }
+        now = now_msec();
+        if (phase->converged(state)) {
+            if (converged_msec < 0) {
+                converged_msec = now;
+                memcpy(at, state, sizeof(at));
+                for (node = 0; node < SIM_NODES; node++) {
+                    cpu_sample(at[node].pid, &cpu_at[node]);
+                }
+            }
+            else if (now - converged_msec >= SIM_SETTLE_MSEC) {
+                break;
+            }
+        }
+        else {
+            converged_msec = -1;
+        }
+        if ((converged_msec < 0) &&
+            (now - start > SIM_PHASE_TIMEOUT_MSEC)) {
+            fprintf(stderr, "%s: %s did not converge\n", scenario->name,
+                    phase->name);
+            err = -ETIMEDOUT;
+            goto bail;
+        }
+        usleep(SIM_POLL_INTERVAL_MSEC * 1000);
+    }
+
+    /* Each message is counted once, by its sender */
+    for (node = 0; node < SIM_NODES; node++) {
+        msgs += at[node].ctl.tx_msgs;
+        bytes += at[node].ctl.tx_bytes;
+        if (at[node].pid == before[node].pid) {
+            msgs -= before[node].ctl.tx_msgs;
+            bytes -= before[node].ctl.tx_bytes;
+        }
+    }
+    printf("%-12s %-14s %10lld %10llu %12llu\n", scenario->name, phase->name,
+           converged_msec - start, msgs, bytes);
+    for (node = 0; node < SIM_NODES; node++) {
+        cpu_print(node, &cpu_before[node], &cpu_at[node]);
+    }
+    fflush(stdout);
+
+bail:
+    return err;
+}
+
+/*
+ *  This function checks a node is up with its peer, with all mLAG
+ *  ports active on both
+ *
+ * @param[in] state - node state
+ *
+ * @return TRUE if the node is up
+ */
+static int
+node_up(const struct sim_node_state *state)
+{
+    return (state->peer_up &&
+            (state->ports_num >= sim_args.ports_num) &&
+            (state->ports_full == state->ports_num));
+}
+
+static int
+converged_peers_up(const struct sim_node_state *state)
+{
+    return (node_up(&state[0]) && node_up(&state[1]) &&
+            (((state[0].role == MLAG_MASTER) &&
+              (state[1].role == MLAG_SLAVE)) ||
+             ((state[0].role == MLAG_SLAVE) &&
+              (state[1].role == MLAG_MASTER))));
+}
+
+static int
+converged_peers_down(const struct sim_node_state *state)
+{
+    return (!state[0].peer_up && !state[1].peer_up);
+}
+
+static int
+converged_peer_gone(const struct sim_node_state *state)
+{
+    return ((state[0].pid == 0) && !state[1].peer_up);
+}
+
+static int
+converged_macs_learned(const struct sim_node_state *state)
+{
+    return ((state[0].ctl.fdb_entries >= fdb_base[0] + sim_args.macs) &&
+            (state[1].ctl.fdb_entries >= fdb_base[1] + sim_args.macs));
+}
+
+static int
+converged_fdb_flushed(const struct sim_node_state *state)
+{
+    return ((state[0].ctl.fdb_entries <= fdb_base[0]) &&
+            (state[1].ctl.fdb_entries <= fdb_base[1]));
+}
+
+static int
+converged_standalone(const struct sim_node_state *state)
+{
+    return (state[SIM_PEER(master_node)].role == MLAG_STANDALONE);
+}
+
+static int
+trigger_configure(void)
+{
+    int err = 0;
+    int node;
+
+    for (node = 0; node < SIM_NODES; node++) {
+        err = node_cmd(node, SIM_CMD_CONFIGURE, 0, NULL);
+        if (err) {
+            break;
+        }
+    }
+    return err;
+}
+
+/*
+ *  This function sets the IPL state, the link and as notified to both
+ *  nodes
+ *
+ * @param[in] state - port state
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+ipl_state_set(enum oes_port_oper_state state)
+{
+    int err = 0;
+    int node;
+
+    err = net_ipl_set(state == OES_PORT_UP);
+    if (err) {
+        goto bail;
+    }
+    for (node = 0; node < SIM_NODES; node++) {
+        err = node_cmd(node, SIM_CMD_IPL_STATE, state, NULL);
+        if (err) {
+            goto bail;
+        }
+    }
+
+bail:
+    return err;
+}
+
+static int
+trigger_ipl_down(void)
+{
+    return ipl_state_set(OES_PORT_DOWN);
+}
+
+static int
+trigger_ipl_up(void)
+{
+    return ipl_state_set(OES_PORT_UP);
+}
+
+static int
+trigger_peer_kill(void)
+{
+    return node_cmd(0, SIM_CMD_DAEMON_KILL, 0, NULL);
+}
+
+static int
+trigger_peer_restart(void)
+{
+    int err = 0;
+
+    err = node_cmd(0, SIM_CMD_DAEMON_START, 0, NULL);
+    if (err) {
+        goto bail;
+    }
+    err = node_cmd(0, SIM_CMD_CONFIGURE, 0, NULL);
+
+bail:
+    return err;
+}
+
+static int
+trigger_mac_learn(void)
+{
+    int err = 0;
+    int node;
+    struct sim_node_state state[SIM_NODES];
+
+    err = nodes_state_get(state);
+    if (err) {
+        goto bail;
+    }
+    for (node = 0; node < SIM_NODES; node++) {
+        fdb_base[node] = state[node].ctl.fdb_entries;
+    }
+    err = node_cmd(0, SIM_CMD_MAC_LEARN, sim_args.macs, NULL);
+
+bail:
+    return err;
+}
+
+static int
+trigger_fdb_flush(void)
+{
+    return node_cmd(0, SIM_CMD_FDB_FLUSH, 0, NULL);
+}
+
+static int
+trigger_ports_flap(void)
+{
+    int err = 0;
+    unsigned int i;
+
+    for (i = 0; i < sim_args.flaps; i++) {
+        err = node_cmd(0, SIM_CMD_PORTS_STATE, OES_PORT_DOWN, NULL);
+        if (err) {
+            break;
+        }
+        err = node_cmd(0, SIM_CMD_PORTS_STATE, OES_PORT_UP, NULL);
+        if (err) {
+            break;
+        }
+    }
+    return err;
+}
+
+static int
+trigger_master_stop(void)
+{
+    int err = 0;
+    int node;
+    struct sim_node_state state[SIM_NODES];
+
+    err = nodes_state_get(state);
+    if (err) {
+        goto bail;
+    }
+    master_node = -1;
+    for (node = 0; node < SIM_NODES; node++) {
+        if (state[node].role == MLAG_MASTER) {
+            master_node = node;
+        }
+    }
+    if (master_node < 0) {
+        fprintf(stderr, "No master to stop\n");
+        err = -ENOENT;
+        goto bail;
+    }
+    err = node_cmd(master_node, SIM_CMD_PROTOCOL_STOP, 0, NULL);
+
+bail:
+    return err;
+}
+
+static int
+trigger_master_start(void)
+{
+    return node_cmd(master_node, SIM_CMD_PROTOCOL_START, 0, NULL);
+}
+
+int
+main(int argc, char **argv)
+{
+    int err = 0;
+    int node;
+    unsigned int i, j;
+    const struct sim_scenario *scenario;
+
+    parse_args(argc, argv);
+
+    if (geteuid() != 0) {
+        fprintf(stderr, "mlag_sim needs root, for the network namespaces\n");
+        return 1;
+    }
+    for (node = 0; node < SIM_NODES; node++) {
+        nodes[node].log_fd = -1;
+    }
+
+    err = net_setup();
+    if (err) {
+        goto bail;
+    }
+    for (node = 0; node < SIM_NODES; node++) {
+        err = node_start(node);
+        if (err) {
+            goto bail;
+        }
+    }
+
+    printf("%-12s %-14s %10s %10s %12s\n", "Scenario", "Phase", "Msec",
+           "IPL msgs", "IPL bytes");
+    for (i = 0; i < sim_args.scenarios_num; i++) {
+        scenario = &sim_scenarios[sim_args.scenarios[i]];
+        for (j = 0; j < scenario->phases_num; j++) {
+            err = phase_run(scenario, &scenario->phases[j]);
+            if (err) {
+                goto bail;
+            }
+        }
+    }
+
+bail:
+    for (node = 0; node < SIM_NODES; node++) {
+        node_stop(node);
+    }
+    net_cleanup();
+    return (err ? 1 : 0);
+}
@@ -0,0 +1,141 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MLAG_SIM_H_
+#define MLAG_SIM_H_
+
+#include <stdint.h>
+
+/*
+ * libmlagsim stands in for the communication and control learning
+ * libraries of an mlag process it is preloaded in. The IPL runs over
+ * kernel TCP sockets and the FDB is kept in memory. mlag_sim drives the
+ * stand-ins of each node through a control socket.
+ */
+
+/************************************************
+ *  Defines
+ ***********************************************/
+
+/* Path of the control socket, the socket is not opened if not set */
+#define MLAG_SIM_CTL_ENV        "MLAG_SIM_CTL"
+/* Number of FDB entries, rounded up to a power of 2 */
+#define MLAG_SIM_FDB_SIZE_ENV   "MLAG_SIM_FDB_SIZE"
+#define MLAG_SIM_FDB_SIZE_DEFAULT 65536
+
+/************************************************
+ *  Macros
+ ***********************************************/
+
+/************************************************
+ *  Type definitions
+ ***********************************************/
+
+enum mlag_sim_ctl_op {
+    MLAG_SIM_CTL_STATS_GET,
+    MLAG_SIM_CTL_FDB_LEARN,
+};
+
+/**
+ * Control socket request. A learn request learns count MACs from
+ * mac_base on, spread round robin on ports_num ports from first_port.
+ */
+struct mlag_sim_ctl_req {
+    uint32_t op;
+    uint32_t count;
+    uint64_t mac_base;
+    uint64_t first_port;
+    uint32_t ports_num;
+    uint16_t vid;
+};
+
+/**
+ * Control socket reply, the stand-in statistics come with every reply.
+ * Messages are those sent and received on the IPL.
+ */
+struct mlag_sim_ctl_rsp {
+    int32_t err;
+    uint32_t fdb_entries;
+    uint64_t tx_msgs;
+    uint64_t tx_bytes;
+    uint64_t rx_msgs;
+    uint64_t rx_bytes;
+};
+
+/************************************************
+ *  Function declarations
+ ***********************************************/
+
+/**
+ * Starts the control socket server, if MLAG_SIM_CTL_ENV is set.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -errno - Failed to open the control socket.
+ */
+int
+sim_ctl_start(void);
+
+/**
+ * Stops the control socket server.
+ *
+ * @return void
+ */
+void
+sim_ctl_stop(void);
+
+/**
+ * Gets the IPL messages statistics of the communication stand-in.
+ *
+ * @param[out] rsp - tx_* and rx_* are set.
+ *
+ * @return void
+ */
+void
+sim_commu_stats_get(struct mlag_sim_ctl_rsp *rsp);
+
+/**
+ * Learns MACs as the switch would, the learns are notified as
+ * learned by no originator.
+ *
+ * @param[in] req - learn request.
+ *
+ * @return 0 - Operation completed successfully.
+ * @return -EPERM - Control learning is not initialized.
+ * @return -ENOSPC - FDB is full.
+ */
+int
+sim_fdb_learn(const struct mlag_sim_ctl_req *req);
+
+/**
+ * Gets the number of FDB entries.
+ *
+ * @return number of entries.
+ */
+uint32_t
+sim_fdb_count(void);
+
+#endif /* MLAG_SIM_H_ */
@@ -0,0 +1,635 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <complib/sx_log.h>
+#include <utils/mlag_defs.h>
+#include "mlag_sim.h"
+
+/*
+ * The stand-ins below are defined with the types the mlag process
+ * passes. The library prototypes are renamed away while included, so
+ * only the structures are taken from the library header.
+ */
+#define comm_lib_init                           sim_lib_comm_lib_init
+#define comm_lib_deinit                         sim_lib_comm_lib_deinit
+#define comm_lib_tcp_server_session_start       sim_lib_server_start
+#define comm_lib_tcp_server_session_stop        sim_lib_server_stop
+#define comm_lib_tcp_client_non_blocking_start  sim_lib_client_start
+#define comm_lib_tcp_peer_stop                  sim_lib_peer_stop
+#define comm_lib_tcp_send_blocking              sim_lib_send_blocking
+#define comm_lib_tcp_recv_blocking              sim_lib_recv_blocking
+#include <mlnx_lib/lib_commu.h>
+#undef comm_lib_init
+#undef comm_lib_deinit
+#undef comm_lib_tcp_server_session_start
+#undef comm_lib_tcp_server_session_stop
+#undef comm_lib_tcp_client_non_blocking_start
+#undef comm_lib_tcp_peer_stop
+#undef comm_lib_tcp_send_blocking
+#undef comm_lib_tcp_recv_blocking
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#define SIM_SERVERS_MAX 4
+#define SIM_FDS_MAX 1024
+#define SIM_LISTEN_BACKLOG 16
+/* Bounds the connect to a peer that is not reachable */
+#define SIM_CONNECT_TIMEOUT_SEC 3
+/* Messages larger than this are taken as a broken stream */
+#define SIM_MSG_SIZE_MAX (16 * 1024 * 1024)
+#define SIM_SEND_LOCKS 16
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+#define SIM_FD_VALID(fd) (((fd) > 0) && ((fd) < SIM_FDS_MAX))
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+struct sim_server {
+    int in_use;
+    int listen_fd;
+    pthread_t thread;
+    struct register_to_new_handle notify;
+};
+
+/* Connect in progress of a client session */
+struct sim_client {
+    struct connection_info conn_info;
+    struct register_to_new_handle notify;
+};
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+
+static pthread_mutex_t sim_commu_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct sim_server servers[SIM_SERVERS_MAX];
+/* Server each connection was accepted by, -1 for client connections */
+static int conn_server[SIM_FDS_MAX];
+static int conn_open[SIM_FDS_MAX];
+/* Peer address of each connection, known after the peer closed it */
+static struct addr_info conn_addr[SIM_FDS_MAX];
+/* Senders of one connection may hold different locks of their own */
+static pthread_mutex_t send_mutex[SIM_SEND_LOCKS] = {
+    [0 ... SIM_SEND_LOCKS - 1] = PTHREAD_MUTEX_INITIALIZER
+};
+static uint64_t tx_msgs;
+static uint64_t tx_bytes;
+static uint64_t rx_msgs;
+static uint64_t rx_bytes;
+
+/* Receive buffer, valid until the next receive of the thread */
+static __thread uint8_t *rx_buf;
+static __thread uint32_t rx_buf_size;
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  This function records a new connection
+ *
+ * @param[in] fd - connection socket
+ * @param[in] server_id - accepting server, -1 for a client connection
+ * @param[in] addr - peer address
+ *
+ * @return 0 when successful, -EMFILE if fd is out of range
+ */
+static int
+conn_add(int fd, int server_id, struct sockaddr_in *addr)
+{
+    int opt = 1;
+
+    if (!SIM_FD_VALID(fd)) {
+        return -EMFILE;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    pthread_mutex_lock(&sim_commu_mutex);
+    conn_open[fd] = 1;
+    conn_server[fd] = server_id;
+    conn_addr[fd].ipv4_addr = addr->sin_addr.s_addr;
+    conn_addr[fd].port = addr->sin_port;
+    pthread_mutex_unlock(&sim_commu_mutex);
+    return 0;
+}
+
+/*
+ *  This function closes a connection
+ *
+ * @param[in] fd - connection socket
+ *
+ * @return void
+ */
+static void
+conn_close(int fd)
+{
+    pthread_mutex_lock(&sim_commu_mutex);
+    if (SIM_FD_VALID(fd) && conn_open[fd]) {
+        conn_open[fd] = 0;
+        shutdown(fd, SHUT_RDWR);
+        close(fd);
+    }
+    pthread_mutex_unlock(&sim_commu_mutex);
+}
+
+/*
+ *  This function reads exactly len bytes
+ *
+ * @param[in] fd - connection socket
+ * @param[out] buf - buffer
+ * @param[in] len - number of bytes
+ *
+ * @return 0 when successful, -ECONNRESET when the peer closed,
+ *         otherwise -errno
+ */
+static int
+read_all(int fd, uint8_t *buf, uint32_t len)
+{
+    ssize_t ret;
+
+    while (len > 0) {
+        ret = recv(fd, buf, len, 0);
+        if (ret == 0) {
+            return -ECONNRESET;
+        }
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        buf += ret;
+        len -= ret;
+    }
+    return 0;
+}
+
+/*
+ *  This function accepts connections of a server session
+ *
+ * @param[in] data - server
+ *
+ * @return NULL
+ */
+static void *
+server_thread(void *data)
+{
+    struct sim_server *server = (struct sim_server *)data;
+    int server_id = server - servers;
+    int fd;
+    struct sockaddr_in addr;
+    socklen_t addr_len;
+
+    while (TRUE) {
+        addr_len = sizeof(addr);
+        fd = accept(server->listen_fd, (struct sockaddr *)&addr, &addr_len);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* The listening socket was shut down */
+            break;
+        }
+        if (conn_add(fd, server_id, &addr)) {
+            close(fd);
+            continue;
+        }
+        server->notify.clbk_notify_func(fd, conn_addr[fd],
+                                        server->notify.data, 0);
+    }
+    return NULL;
+}
+
+/*
+ *  This function connects a client session and notifies the result
+ *
+ * @param[in] data - client, freed here
+ *
+ * @return NULL
+ */
+static void *
+client_thread(void *data)
+{
+    struct sim_client *client = (struct sim_client *)data;
+    int fd;
+    int rc = 0;
+    struct sockaddr_in addr;
+    struct addr_info peer;
+    struct timeval timeout;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = client->conn_info.d_ipv4_addr;
+    addr.sin_port = client->conn_info.d_port;
+    peer.ipv4_addr = addr.sin_addr.s_addr;
+    peer.port = addr.sin_port;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        rc = -errno;
+        goto notify;
+    }
+    timeout.tv_sec = SIM_CONNECT_TIMEOUT_SEC;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        rc = -errno;
+        close(fd);
+        fd = -1;
+        goto notify;
+    }
+    timeout.tv_sec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    rc = conn_add(fd, -1, &addr);
+    if (rc) {
+        close(fd);
+        fd = -1;
+    }
+
+notify:
+    client->notify.clbk_notify_func((fd < 0) ? 0 : fd, peer,
+                                    client->notify.data, rc);
+    free(client);
+    return NULL;
+}
+
+/**
+ *  Stand-in of the library init, starts the control socket
+ *
+ * @param[in] log_cb - unused
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+comm_lib_init(sx_log_cb_t log_cb)
+{
+    UNUSED_PARAM(log_cb);
+
+    return sim_ctl_start();
+}
+
+/**
+ *  Stand-in of the library deinit
+ *
+ * @return 0
+ */
+int
+comm_lib_deinit(void)
+{
+    sim_ctl_stop();
+    return 0;
+}
+
+/**
+ *  Stand-in of TCP server session start. Connections are notified from
+ *  an accept thread of the session.
+ *
+ * @param[in] params - local address and port, in network order
+ * @param[in] clbk - connection notification
+ * @param[out] server_id - session id
+ *
+ * @return 0 when successful, otherwise -errno
+ */
+int
+comm_lib_tcp_server_session_start(struct session_params params,
+                                  struct register_to_new_handle *clbk,
+                                  uint16_t *server_id)
+{
+    int err = 0;
+    int i;
+    int opt = 1;
+    int fd = -1;
+    struct sockaddr_in addr;
+
+    pthread_mutex_lock(&sim_commu_mutex);
+    for (i = 0; i < SIM_SERVERS_MAX; i++) {
+        if (!servers[i].in_use) {
+            break;
+        }
+    }
+    if (i == SIM_SERVERS_MAX) {
+        err = -ENOSPC;
+        goto bail;
+    }
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        err = -errno;
+        goto bail;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = params.s_ipv4_addr;
+    addr.sin_port = params.port;
+    if ((bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        (listen(fd, SIM_LISTEN_BACKLOG) < 0)) {
+        err = -errno;
+        goto bail;
+    }
+
+    servers[i].listen_fd = fd;
+    servers[i].notify = *clbk;
+    err = -pthread_create(&servers[i].thread, NULL, server_thread,
+                          &servers[i]);
+    if (err) {
+        goto bail;
+    }
+    servers[i].in_use = 1;
+    *server_id = i;
+    fd = -1;
+
+bail:
+    pthread_mutex_unlock(&sim_commu_mutex);
+    if (fd >= 0) {
+        close(fd);
+    }
+    return err;
+}
+
+/**
+ *  Stand-in of TCP server session stop, the connections the session
+ *  accepted are closed
+ *
+ * @param[in] server_id - session id
+ * @param[out] handle_arr - closed connections, 0 terminated
+ * @param[in] num - size of handle_arr
+ *
+ * @return 0 when successful, -EINVAL if server_id is not known
+ */
+int
+comm_lib_tcp_server_session_stop(uint16_t server_id, handle_t *handle_arr,
+                                 int num)
+{
+    int fd;
+    int closed = 0;
+
+    if ((server_id >= SIM_SERVERS_MAX) || !servers[server_id].in_use) {
+        return -EINVAL;
+    }
+
+    shutdown(servers[server_id].listen_fd, SHUT_RDWR);
+    pthread_join(servers[server_id].thread, NULL);
+    close(servers[server_id].listen_fd);
+
+    pthread_mutex_lock(&sim_commu_mutex);
+    servers[server_id].in_use = 0;
+    for (fd = 0; fd < SIM_FDS_MAX; fd++) {
+        if (conn_open[fd] && (conn_server[fd] == server_id)) {
+            conn_open[fd] = 0;
+            shutdown(fd, SHUT_RDWR);
+            close(fd);
+            if (closed < num) {
+                handle_arr[closed++] = fd;
+            }
+        }
+    }
+    pthread_mutex_unlock(&sim_commu_mutex);
+
+    while (closed < num) {
+        handle_arr[closed++] = 0;
+    }
+    return 0;
+}
+
+/**
+ *  Stand-in of non blocking TCP client start. The result is notified
+ *  from a thread of the connect, with rc 0 once connected.
+ *
+ * @param[in] conn_info - destination address and port, in network order
+ * @param[in] clbk - connection notification
+ * @param[out] handle - unused, the handle comes with the notification
+ *
+ * @return 0 when successful, otherwise -errno
+ */
+int
+comm_lib_tcp_client_non_blocking_start(struct connection_info *conn_info,
+                                       struct register_to_new_handle *clbk,
+                                       handle_t *handle)
+{
+    int err = 0;
+    pthread_t thread;
+    pthread_attr_t attr;
+    struct sim_client *client;
+
+    UNUSED_PARAM(handle);
+
+    client = (struct sim_client *)malloc(sizeof(*client));
+    if (client == NULL) {
+        return -ENOMEM;
+    }
+    client->conn_info = *conn_info;
+    client->notify = *clbk;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    err = -pthread_create(&thread, &attr, client_thread, client);
+    pthread_attr_destroy(&attr);
+    if (err) {
+        free(client);
+    }
+    return err;
+}
+
+/**
+ *  Stand-in of TCP peer stop, closes a connection
+ *
+ * @param[in] handle - connection
+ *
+ * @return 0
+ */
+int
+comm_lib_tcp_peer_stop(handle_t handle)
+{
+    conn_close(handle);
+    return 0;
+}
+
+/**
+ *  Stand-in of blocking TCP send. A message goes on the stream as its
+ *  length in network order followed by the payload.
+ *
+ * @param[in] handle - connection
+ * @param[in] payload - message
+ * @param[in,out] payload_len - message length, unchanged when sent
+ *
+ * @return 0 when successful, otherwise -errno
+ */
+int
+comm_lib_tcp_send_blocking(handle_t handle, uint8_t *payload,
+                           uint32_t *payload_len)
+{
+    int err = 0;
+    uint32_t len_hdr;
+    size_t left;
+    ssize_t ret;
+    struct iovec iov[2];
+    struct msghdr msg;
+    pthread_mutex_t *mutex = &send_mutex[handle % SIM_SEND_LOCKS];
+
+    len_hdr = htonl(*payload_len);
+    iov[0].iov_base = &len_hdr;
+    iov[0].iov_len = sizeof(len_hdr);
+    iov[1].iov_base = payload;
+    iov[1].iov_len = *payload_len;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    left = sizeof(len_hdr) + *payload_len;
+
+    pthread_mutex_lock(mutex);
+    while (left > 0) {
+        ret = sendmsg(handle, &msg, MSG_NOSIGNAL);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            err = -errno;
+            break;
+        }
+        left -= ret;
+        while ((ret > 0) && (msg.msg_iovlen > 0)) {
+            if ((size_t)ret < msg.msg_iov->iov_len) {
+                msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + ret;
+                msg.msg_iov->iov_len -= ret;
+                ret = 0;
+            }
+            else {
+                ret -= msg.msg_iov->iov_len;
+                msg.msg_iov++;
+                msg.msg_iovlen--;
+            }
+        }
+    }
+    pthread_mutex_unlock(mutex);
+
+    if (err == 0) {
+        __sync_fetch_and_add(&tx_msgs, 1);
+        __sync_fetch_and_add(&tx_bytes, *payload_len);
+    }
+    return err;
+}
+
+/**
+ *  Stand-in of blocking TCP receive, receives one message to a buffer
+ *  of the calling thread
+ *
+ * @param[in] handle - connection
+ * @param[out] addr_info - peer address, also set on failure
+ * @param[out] payload_data - message in payload[0]
+ * @param[in] num - unused, one message is received
+ *
+ * @return 0 when successful, -ECONNRESET when the peer closed,
+ *         otherwise -errno
+ */
+int
+comm_lib_tcp_recv_blocking(handle_t handle, struct addr_info *addr_info,
+                           struct recv_payload_data *payload_data, int num)
+{
+    int err = 0;
+    uint32_t len;
+    uint8_t *buf;
+
+    UNUSED_PARAM(num);
+
+    if (!SIM_FD_VALID(handle)) {
+        return -EBADF;
+    }
+    pthread_mutex_lock(&sim_commu_mutex);
+    *addr_info = conn_addr[handle];
+    pthread_mutex_unlock(&sim_commu_mutex);
+
+    err = read_all(handle, (uint8_t *)&len, sizeof(len));
+    if (err) {
+        goto bail;
+    }
+    len = ntohl(len);
+    if (len > SIM_MSG_SIZE_MAX) {
+        err = -ECONNRESET;
+        goto bail;
+    }
+    if ((len > rx_buf_size) || (rx_buf == NULL)) {
+        buf = (uint8_t *)realloc(rx_buf, (len > 0) ? len : 1);
+        if (buf == NULL) {
+            err = -ENOMEM;
+            goto bail;
+        }
+        rx_buf = buf;
+        rx_buf_size = len;
+    }
+    err = read_all(handle, rx_buf, len);
+    if (err) {
+        goto bail;
+    }
+
+    payload_data->payload[0] = rx_buf;
+    payload_data->payload_len[0] = len;
+    payload_data->jumbo_payload = NULL;
+    payload_data->jumbo_payload_len = 0;
+    payload_data->msg_num_recv = 1;
+
+    __sync_fetch_and_add(&rx_msgs, 1);
+    __sync_fetch_and_add(&rx_bytes, len);
+
+bail:
+    return err;
+}
+
+/**
+ *  This function gets the IPL messages statistics
+ *
+ * @param[out] rsp - tx_* and rx_* are set
+ *
+ * @return void
+ */
+void
+sim_commu_stats_get(struct mlag_sim_ctl_rsp *rsp)
+{
+    rsp->tx_msgs = __sync_fetch_and_add(&tx_msgs, 0);
+    rsp->tx_bytes = __sync_fetch_and_add(&tx_bytes, 0);
+    rsp->rx_msgs = __sync_fetch_and_add(&rx_msgs, 0);
+    rsp->rx_bytes = __sync_fetch_and_add(&rx_bytes, 0);
+}
@@ -0,0 +1,197 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <mlag_api_defs.h>
+#include <utils/mlag_defs.h>
+#include "mlag_sim.h"
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+
+static int ctl_fd = -1;
+static pthread_t ctl_thread;
+static struct sockaddr_un ctl_addr;
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  This function serves the requests of one control connection
+ *
+ * @param[in] fd - connection socket
+ *
+ * @return void
+ */
+static void
+ctl_serve(int fd)
+{
+    ssize_t ret;
+    struct mlag_sim_ctl_req req;
+    struct mlag_sim_ctl_rsp rsp;
+
+    while (TRUE) {
+        ret = recv(fd, &req, sizeof(req), 0);
+        if ((ret < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (ret != sizeof(req)) {
+            break;
+        }
+
+        memset(&rsp, 0, sizeof(rsp));
+        switch (req.op) {
+        case MLAG_SIM_CTL_STATS_GET:
+            break;
+        case MLAG_SIM_CTL_FDB_LEARN:
+            rsp.err = sim_fdb_learn(&req);
+            break;
+        default:
+            rsp.err = -EINVAL;
+            break;
+        }
+        rsp.fdb_entries = sim_fdb_count();
+        sim_commu_stats_get(&rsp);
+
+        if (send(fd, &rsp, sizeof(rsp), MSG_NOSIGNAL) != sizeof(rsp)) {
+            break;
+        }
+    }
+}
+
+/*
+ *  This function accepts control connections, one at a time
+ *
+ * @param[in] data - unused
+ *
+ * @return NULL
+ */
+static void *
+ctl_thread_func(void *data)
+{
+    int fd;
+
+    UNUSED_PARAM(data);
+
+    while (TRUE) {
+        fd = accept(ctl_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* The listening socket was shut down */
+            break;
+        }
+        ctl_serve(fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+/**
+ *  This function starts the control socket server
+ *
+ * @return 0 when successful, otherwise -errno
+ */
+int
+sim_ctl_start(void)
+{
+    int err = 0;
+    const char *path = getenv(MLAG_SIM_CTL_ENV);
+
+    if ((path == NULL) || (ctl_fd >= 0)) {
+        goto bail;
+    }
+    if (strlen(path) >= sizeof(ctl_addr.sun_path)) {
+        err = -ENAMETOOLONG;
+        goto bail;
+    }
+
+    memset(&ctl_addr, 0, sizeof(ctl_addr));
+    ctl_addr.sun_family = AF_UNIX;
+    strcpy(ctl_addr.sun_path, path);
+    /* Left by a process that was killed */
+    unlink(path);
+
+    ctl_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (ctl_fd < 0) {
+        err = -errno;
+        goto bail;
+    }
+    if ((bind(ctl_fd, (struct sockaddr *)&ctl_addr, sizeof(ctl_addr)) < 0) ||
+        (listen(ctl_fd, 1) < 0)) {
+        err = -errno;
+        goto bail;
+    }
+    err = -pthread_create(&ctl_thread, NULL, ctl_thread_func, NULL);
+
+bail:
+    if (err && (ctl_fd >= 0)) {
+        close(ctl_fd);
+        ctl_fd = -1;
+    }
+    return err;
+}
+
+/**
+ *  This function stops the control socket server
+ *
+ * @return void
+ */
+void
+sim_ctl_stop(void)
+{
+    if (ctl_fd < 0) {
+        return;
+    }
+    shutdown(ctl_fd, SHUT_RDWR);
+    pthread_join(ctl_thread, NULL);
+    close(ctl_fd);
+    unlink(ctl_addr.sun_path);
+    ctl_fd = -1;
+}
@@ -0,0 +1,843 @@
+/* Copyright (c) 2014  Mellanox Technologies, Ltd. All rights reserved.
+ *
+ * This software is available to you under BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <net/ethernet.h>
+#include <oes_types.h>
+#include <utils/mlag_defs.h>
+#include "mlag_sim.h"
+
+/*
+ * The stand-ins below are defined with the types the mlag process
+ * passes. The library prototypes are renamed away while included, so
+ * only the structures are taken from the library header.
+ */
+#define ctrl_learn_init                 sim_lib_init
+#define ctrl_learn_deinit               sim_lib_deinit
+#define ctrl_learn_start                sim_lib_start
+#define ctrl_learn_stop                 sim_lib_stop
+#define ctrl_learn_register_notification sim_lib_register_notification
+#define ctrl_learn_unregister_notification_cb sim_lib_unregister_notification
+#define ctrl_learn_register_init_deinit_mac_addr_cookie_cb \
+    sim_lib_register_cookie_cb
+#define ctrl_learn_api_fdb_uc_mac_addr_set sim_lib_mac_addr_set
+#define ctrl_learn_api_uc_mac_addr_get  sim_lib_mac_addr_get
+#define ctrl_learn_api_fdb_uc_flush_set sim_lib_flush_set
+#define ctrl_learn_api_fdb_uc_flush_port_set sim_lib_flush_port_set
+#define ctrl_learn_api_fdb_uc_flush_vid_set sim_lib_flush_vid_set
+#define ctrl_learn_api_fdb_uc_flush_port_vid_set sim_lib_flush_port_vid_set
+#define ctrl_learn_api_get_uc_db_access sim_lib_get_uc_db_access
+#include <mlnx_lib/lib_ctrl_learn.h>
+#undef ctrl_learn_init
+#undef ctrl_learn_deinit
+#undef ctrl_learn_start
+#undef ctrl_learn_stop
+#undef ctrl_learn_register_notification
+#undef ctrl_learn_unregister_notification_cb
+#undef ctrl_learn_register_init_deinit_mac_addr_cookie_cb
+#undef ctrl_learn_api_fdb_uc_mac_addr_set
+#undef ctrl_learn_api_uc_mac_addr_get
+#undef ctrl_learn_api_fdb_uc_flush_set
+#undef ctrl_learn_api_fdb_uc_flush_port_set
+#undef ctrl_learn_api_fdb_uc_flush_vid_set
+#undef ctrl_learn_api_fdb_uc_flush_port_vid_set
+#undef ctrl_learn_api_get_uc_db_access
+
+/************************************************
+ *  Local Defines
+ ***********************************************/
+
+#define SIM_FDB_HASH_MULT 0x9E3779B97F4A7C15ULL
+
+/************************************************
+ *  Local Macros
+ ***********************************************/
+
+#define SIM_FDB_NEXT(idx) (((idx) + 1) & (fdb_size - 1))
+
+/************************************************
+ *  Local Type definitions
+ ***********************************************/
+
+typedef int (*sim_notify_cb_t)(struct ctrl_learn_fdb_notify_data *data,
+                               const void *originator_cookie);
+typedef int (*sim_cookie_cb_t)(enum cookie_op oper, void **cookie);
+typedef int (*sim_db_access_cb_t)(void *data);
+
+enum sim_fdb_slot_state {
+    SIM_FDB_SLOT_FREE = 0,
+    SIM_FDB_SLOT_USED,
+    SIM_FDB_SLOT_DELETED,
+};
+
+/* FDB is an open addressing hash table, iterated in table order */
+struct sim_fdb_slot {
+    enum sim_fdb_slot_state state;
+    uint64_t key;
+    struct fdb_uc_mac_addr_params entry;
+};
+
+/************************************************
+ *  Local variables
+ ***********************************************/
+
+/* Protects the FDB, held by the caller when need_lock is 0 */
+static pthread_mutex_t fdb_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Serializes notifications, taken inside fdb_mutex, never the reverse */
+static pthread_mutex_t notify_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct sim_fdb_slot *fdb;
+static uint32_t fdb_size;
+static uint32_t fdb_count;
+static int fdb_started;
+static sim_notify_cb_t notify_cb;
+static uint32_t notify_batch = CTRL_LEARN_FDB_NOTIFY_SIZE_MAX;
+static sim_cookie_cb_t cookie_cb;
+
+/************************************************
+ *  Function implementations
+ ***********************************************/
+
+/*
+ *  This function makes the FDB key of a MAC
+ *
+ * @param[in] params - MAC entry
+ *
+ * @return key
+ */
+static uint64_t
+fdb_key(const struct oes_fdb_uc_mac_addr_params *params)
+{
+    int i;
+    uint64_t key = params->vid;
+
+    for (i = 0; i < ETH_ALEN; i++) {
+        key = (key << 8) | params->mac_addr.ether_addr_octet[i];
+    }
+    return key;
+}
+
+/*
+ *  This function finds the slot of a key. Called with fdb_mutex held.
+ *
+ * @param[in] key - FDB key
+ *
+ * @return slot index, -1 if the key is not in the FDB
+ */
+static long
+fdb_find(uint64_t key)
+{
+    uint32_t i;
+    uint32_t idx = (uint32_t)((key * SIM_FDB_HASH_MULT) >> 32) &
+                   (fdb_size - 1);
+
+    for (i = 0; i < fdb_size; i++) {
+        if (fdb[idx].state == SIM_FDB_SLOT_FREE) {
+            break;
+        }
+        if ((fdb[idx].state == SIM_FDB_SLOT_USED) && (fdb[idx].key == key)) {
+            return idx;
+        }
+        idx = SIM_FDB_NEXT(idx);
+    }
+    return -1;
+}
+
+/*
+ *  This function adds or updates an entry. Called with fdb_mutex held.
+ *
+ * @param[in] entry - MAC entry
+ *
+ * @return 0 when successful, -ENOSPC if the FDB is full
+ */
+static int
+fdb_add(const struct fdb_uc_mac_addr_params *entry)
+{
+    uint64_t key = fdb_key(&entry->mac_addr_params);
+    long slot = fdb_find(key);
+    uint32_t idx;
+
+    if (slot >= 0) {
+        /* A move keeps the cookie */
+        fdb[slot].entry.mac_addr_params = entry->mac_addr_params;
+        fdb[slot].entry.entry_type = entry->entry_type;
+        return 0;
+    }
+    /* One slot is left free so that lookups end */
+    if (fdb_count + 1 >= fdb_size) {
+        return -ENOSPC;
+    }
+
+    idx = (uint32_t)((key * SIM_FDB_HASH_MULT) >> 32) & (fdb_size - 1);
+    while (fdb[idx].state == SIM_FDB_SLOT_USED) {
+        idx = SIM_FDB_NEXT(idx);
+    }
+    fdb[idx].state = SIM_FDB_SLOT_USED;
+    fdb[idx].key = key;
+    fdb[idx].entry = *entry;
+    fdb[idx].entry.cookie = NULL;
+    if (cookie_cb != NULL) {
+        cookie_cb(COOKIE_OP_INIT, &fdb[idx].entry.cookie);
+    }
+    fdb_count++;
+    return 0;
+}
+
+/*
+ *  This function deletes the entry of a slot. Called with fdb_mutex
+ *  held.
+ *
+ * @param[in] idx - slot index
+ *
+ * @return void
+ */
+static void
+fdb_del(uint32_t idx)
+{
+    if (cookie_cb != NULL) {
+        cookie_cb(COOKIE_OP_DEINIT, &fdb[idx].entry.cookie);
+    }
+    fdb[idx].state = SIM_FDB_SLOT_DELETED;
+    fdb_count--;
+    if (fdb_count == 0) {
+        /* Drop the deleted marks while it is cheap */
+        memset(fdb, 0, fdb_size * sizeof(fdb[0]));
+    }
+}
+
+/*
+ *  This function checks an entry against a key filter
+ *
+ * @param[in] filter - key filter, NULL matches all
+ * @param[in] entry - MAC entry
+ *
+ * @return TRUE if the entry matches
+ */
+static int
+fdb_filter_match(const struct fdb_uc_key_filter *filter,
+                 const struct fdb_uc_mac_addr_params *entry)
+{
+    if (filter == NULL) {
+        return TRUE;
+    }
+    if ((filter->filter_by_vid == FDB_KEY_FILTER_FIELD_VALID) &&
+        (filter->vid != entry->mac_addr_params.vid)) {
+        return FALSE;
+    }
+    if ((filter->filter_by_log_port == FDB_KEY_FILTER_FIELD_VALID) &&
+        (filter->log_port != entry->mac_addr_params.log_port)) {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ *  This function notifies records, the approved ones are applied by the
+ *  caller. Records are approved if nobody is registered.
+ *
+ * @param[in,out] data - records, decisions are set
+ * @param[in] originator_cookie - originator of the change
+ *
+ * @return void
+ */
+static void
+fdb_notify(struct ctrl_learn_fdb_notify_data *data,
+           const void *originator_cookie)
+{
+    pthread_mutex_lock(&notify_mutex);
+    if ((notify_cb != NULL) && fdb_started) {
+        notify_cb(data, originator_cookie);
+    }
+    pthread_mutex_unlock(&notify_mutex);
+}
+
+/*
+ *  This function sets a MAC record of a notification
+ *
+ * @param[in,out] data - notification
+ * @param[in] event_type - learn or age
+ * @param[in] entry - MAC entry
+ *
+ * @return void
+ */
+static void
+fdb_record_add(struct ctrl_learn_fdb_notify_data *data,
+               enum oes_fdb_event_type event_type,
+               const struct fdb_uc_mac_addr_params *entry)
+{
+    uint32_t i = data->records_num++;
+
+    memset(&data->records_arr[i], 0, sizeof(data->records_arr[i]));
+    data->records_arr[i].event_type = event_type;
+    data->records_arr[i].entry_type = entry->entry_type;
+    data->records_arr[i].decision = CTRL_LEARN_NOTIFY_DECISION_APPROVE;
+    data->records_arr[i].oes_event_fdb.fdb_event_data.fdb_entry.fdb_entry =
+        entry->mac_addr_params;
+}
+
+/*
+ *  This function notifies a flush and flushes the matching entries if
+ *  it is approved
+ *
+ * @param[in] event_type - flush type
+ * @param[in] filter - entries to flush
+ * @param[in] originator_cookie - originator of the flush
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+static int
+fdb_flush(enum oes_fdb_event_type event_type,
+          const struct fdb_uc_key_filter *filter,
+          const void *originator_cookie)
+{
+    int err = 0;
+    uint32_t i;
+    struct ctrl_learn_fdb_notify_data *data;
+
+    if (fdb == NULL) {
+        return -EPERM;
+    }
+    data = (struct ctrl_learn_fdb_notify_data *)calloc(1, sizeof(*data));
+    if (data == NULL) {
+        return -ENOMEM;
+    }
+
+    data->records_num = 1;
+    data->records_arr[0].event_type = event_type;
+    data->records_arr[0].decision = CTRL_LEARN_NOTIFY_DECISION_APPROVE;
+    if (event_type == OES_FDB_EVENT_FLUSH_PORT) {
+        data->records_arr[0].oes_event_fdb.fdb_event_data.fdb_port.port =
+            filter->log_port;
+    }
+    else if (event_type == OES_FDB_EVENT_FLUSH_VID) {
+        data->records_arr[0].oes_event_fdb.fdb_event_data.fdb_vid.vid =
+            filter->vid;
+    }
+    else if (event_type == OES_FDB_EVENT_FLUSH_PORT_VID) {
+        data->records_arr[0].oes_event_fdb.fdb_event_data.fdb_port_vid.port =
+            filter->log_port;
+        data->records_arr[0].oes_event_fdb.fdb_event_data.fdb_port_vid.vid =
+            filter->vid;
+    }
+    fdb_notify(data, originator_cookie);
+    if (data->records_arr[0].decision != CTRL_LEARN_NOTIFY_DECISION_APPROVE) {
+        goto bail;
+    }
+
+    pthread_mutex_lock(&fdb_mutex);
+    for (i = 0; (i < fdb_size) && (fdb_count > 0); i++) {
+        if ((fdb[i].state == SIM_FDB_SLOT_USED) &&
+            fdb_filter_match(filter, &fdb[i].entry)) {
+            fdb_del(i);
+        }
+    }
+    pthread_mutex_unlock(&fdb_mutex);
+
+bail:
+    free(data);
+    return err;
+}
+
+/**
+ *  Stand-in of the library init, allocates the FDB
+ *
+ * @param[in] br_id - unused
+ * @param[in] flags - unused
+ * @param[in] logging_cb - unused
+ *
+ * @return 0 when successful, -ENOMEM if the FDB cannot be allocated
+ */
+int
+ctrl_learn_init(int br_id, int flags, ctrl_learn_log_cb logging_cb)
+{
+    int err = 0;
+    const char *env;
+    unsigned long size = MLAG_SIM_FDB_SIZE_DEFAULT;
+
+    UNUSED_PARAM(br_id);
+    UNUSED_PARAM(flags);
+    UNUSED_PARAM(logging_cb);
+
+    pthread_mutex_lock(&fdb_mutex);
+    if (fdb != NULL) {
+        goto bail;
+    }
+    env = getenv(MLAG_SIM_FDB_SIZE_ENV);
+    if (env != NULL) {
+        size = strtoul(env, NULL, 0);
+    }
+    fdb_size = 2;
+    while ((fdb_size < size) && (fdb_size < (1U << 30))) {
+        fdb_size <<= 1;
+    }
+    fdb = (struct sim_fdb_slot *)calloc(fdb_size, sizeof(fdb[0]));
+    if (fdb == NULL) {
+        err = -ENOMEM;
+        goto bail;
+    }
+    fdb_count = 0;
+
+bail:
+    pthread_mutex_unlock(&fdb_mutex);
+    return err;
+}
+
+/**
+ *  Stand-in of the library deinit, frees the FDB
+ *
+ * @return 0
+ */
+int
+ctrl_learn_deinit(void)
+{
+    pthread_mutex_lock(&fdb_mutex);
+    free(fdb);
+    fdb = NULL;
+    fdb_count = 0;
+    fdb_started = FALSE;
+    pthread_mutex_unlock(&fdb_mutex);
+    return 0;
+}
+
+/**
+ *  Stand-in of the library start, notifications are sent once started
+ *
+ * @return 0
+ */
+int
+ctrl_learn_start(void)
+{
+    fdb_started = TRUE;
+    return 0;
+}
+
+/**
+ *  Stand-in of the library stop
+ *
+ * @return 0
+ */
+int
+ctrl_learn_stop(void)
+{
+    fdb_started = FALSE;
+    return 0;
+}
+
+/**
+ *  Stand-in of notification register. Notifications are sent from the
+ *  context of the change, in batches of up to size_threshold records.
+ *
+ * @param[in] params - notification parameters
+ * @param[in] cb - notification callback
+ *
+ * @return 0
+ */
+int
+ctrl_learn_register_notification(struct ctrl_learn_notify_params *params,
+                                 sim_notify_cb_t cb)
+{
+    pthread_mutex_lock(&notify_mutex);
+    notify_batch = CTRL_LEARN_FDB_NOTIFY_SIZE_MAX;
+    if ((params != NULL) && (params->size_threshold > 0) &&
+        (params->size_threshold < CTRL_LEARN_FDB_NOTIFY_SIZE_MAX)) {
+        notify_batch = params->size_threshold;
+    }
+    notify_cb = cb;
+    pthread_mutex_unlock(&notify_mutex);
+    return 0;
+}
+
+/**
+ *  Stand-in of notification unregister
+ *
+ * @return 0
+ */
+int
+ctrl_learn_unregister_notification_cb(void)
+{
+    pthread_mutex_lock(&notify_mutex);
+    notify_cb = NULL;
+    pthread_mutex_unlock(&notify_mutex);
+    return 0;
+}
+
+/**
+ *  Stand-in of the cookie callback register, the callback is called
+ *  when an entry is added and deleted
+ *
+ * @param[in] cb - cookie callback
+ *
+ * @return 0
+ */
+int
+ctrl_learn_register_init_deinit_mac_addr_cookie_cb(sim_cookie_cb_t cb)
+{
+    pthread_mutex_lock(&fdb_mutex);
+    cookie_cb = cb;
+    pthread_mutex_unlock(&fdb_mutex);
+    return 0;
+}
+
+/**
+ *  Stand-in of MAC set. Adds are notified as learns and deletes as
+ *  ages, the approved ones are applied.
+ *
+ * @param[in] access_cmd - OES_ACCESS_CMD_ADD or OES_ACCESS_CMD_DELETE
+ * @param[in] mac_list - MAC entries
+ * @param[in,out] mac_cnt - number of entries, on failure the number
+ *                          of entries processed
+ * @param[in] originator_cookie - originator of the change
+ * @param[in] need_lock - 0 if the caller has the FDB access
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+ctrl_learn_api_fdb_uc_mac_addr_set(enum oes_access_cmd access_cmd,
+                                   struct fdb_uc_mac_addr_params *mac_list,
+                                   unsigned short *mac_cnt,
+                                   void *originator_cookie, int need_lock)
+{
+    int err = 0;
+    long slot;
+    uint32_t i, done, num;
+    enum oes_fdb_event_type event_type;
+    struct ctrl_learn_fdb_notify_data *data = NULL;
+
+    if (access_cmd == OES_ACCESS_CMD_ADD) {
+        event_type = OES_FDB_EVENT_LEARN;
+    }
+    else if (access_cmd == OES_ACCESS_CMD_DELETE) {
+        event_type = OES_FDB_EVENT_AGE;
+    }
+    else {
+        return -EINVAL;
+    }
+    if (fdb == NULL) {
+        return -EPERM;
+    }
+    data = (struct ctrl_learn_fdb_notify_data *)malloc(sizeof(*data));
+    if (data == NULL) {
+        return -ENOMEM;
+    }
+
+    for (done = 0; (done < *mac_cnt) && (err == 0); done += num) {
+        num = *mac_cnt - done;
+        if (num > notify_batch) {
+            num = notify_batch;
+        }
+        data->records_num = 0;
+        for (i = 0; i < num; i++) {
+            fdb_record_add(data, event_type, &mac_list[done + i]);
+        }
+        fdb_notify(data, originator_cookie);
+
+        if (need_lock) {
+            pthread_mutex_lock(&fdb_mutex);
+        }
+        for (i = 0; i < num; i++) {
+            if (data->records_arr[i].decision !=
+                CTRL_LEARN_NOTIFY_DECISION_APPROVE) {
+                continue;
+            }
+            if (access_cmd == OES_ACCESS_CMD_ADD) {
+                err = fdb_add(&mac_list[done + i]);
+                if (err) {
+                    *mac_cnt = done + i;
+                    break;
+                }
+            }
+            else {
+                slot = fdb_find(fdb_key(&mac_list[done + i].mac_addr_params));
+                if (slot >= 0) {
+                    fdb_del(slot);
+                }
+            }
+        }
+        if (need_lock) {
+            pthread_mutex_unlock(&fdb_mutex);
+        }
+    }
+
+    free(data);
+    return err;
+}
+
+/**
+ *  Stand-in of MAC get. GET gets the entry of the key in mac_list[0],
+ *  GET_FIRST the first matching entries and GET_NEXT the matching
+ *  entries after the key in mac_list[0].
+ *
+ * @param[in] access_cmd - GET, GET_FIRST or GET_NEXT
+ * @param[in] key_filter - entries to get, NULL for all
+ * @param[in,out] mac_list - entries
+ * @param[in,out] data_cnt - In: size of mac_list. Out: entries got.
+ * @param[in] need_lock - 0 if the caller has the FDB access
+ *
+ * @return 0 when successful
+ * @return -ENOENT - No entry found by GET or GET_FIRST.
+ */
+int
+ctrl_learn_api_uc_mac_addr_get(enum oes_access_cmd access_cmd,
+                               const struct fdb_uc_key_filter *key_filter,
+                               struct fdb_uc_mac_addr_params *mac_list,
+                               unsigned short *data_cnt, int need_lock)
+{
+    int err = 0;
+    long slot;
+    uint32_t idx = 0;
+    unsigned short cnt = 0;
+
+    if (fdb == NULL) {
+        return -EPERM;
+    }
+    if (need_lock) {
+        pthread_mutex_lock(&fdb_mutex);
+    }
+
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_GET:
+        slot = fdb_find(fdb_key(&mac_list[0].mac_addr_params));
+        if (slot >= 0) {
+            mac_list[0] = fdb[slot].entry;
+            cnt = 1;
+        }
+        goto done;
+    case OES_ACCESS_CMD_GET_FIRST:
+        idx = 0;
+        break;
+    case OES_ACCESS_CMD_GET_NEXT:
+        slot = fdb_find(fdb_key(&mac_list[0].mac_addr_params));
+        if (slot < 0) {
+            /* The entry went away, resume where it was */
+            slot = (uint32_t)((fdb_key(&mac_list[0].mac_addr_params) *
+                               SIM_FDB_HASH_MULT) >> 32) & (fdb_size - 1);
+        }
+        idx = slot + 1;
+        break;
+    default:
+        err = -EINVAL;
+        goto bail;
+    }
+
+    for (; (idx < fdb_size) && (cnt < *data_cnt); idx++) {
+        if ((fdb[idx].state == SIM_FDB_SLOT_USED) &&
+            fdb_filter_match(key_filter, &fdb[idx].entry)) {
+            mac_list[cnt++] = fdb[idx].entry;
+        }
+    }
+
+done:
+    *data_cnt = cnt;
+    if ((cnt == 0) && (access_cmd != OES_ACCESS_CMD_GET_NEXT)) {
+        err = -ENOENT;
+    }
+
+bail:
+    if (need_lock) {
+        pthread_mutex_unlock(&fdb_mutex);
+    }
+    return err;
+}
+
+/**
+ *  Stand-in of flush all
+ *
+ * @param[in] originator_cookie - originator of the flush
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+ctrl_learn_api_fdb_uc_flush_set(void *originator_cookie)
+{
+    return fdb_flush(OES_FDB_EVENT_FLUSH_ALL, NULL, originator_cookie);
+}
+
+/**
+ *  Stand-in of port flush
+ *
+ * @param[in] port - port to flush
+ * @param[in] originator_cookie - originator of the flush
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+ctrl_learn_api_fdb_uc_flush_port_set(unsigned long port,
+                                     void *originator_cookie)
+{
+    struct fdb_uc_key_filter filter;
+
+    memset(&filter, 0, sizeof(filter));
+    filter.filter_by_log_port = FDB_KEY_FILTER_FIELD_VALID;
+    filter.log_port = port;
+    return fdb_flush(OES_FDB_EVENT_FLUSH_PORT, &filter, originator_cookie);
+}
+
+/**
+ *  Stand-in of VLAN flush
+ *
+ * @param[in] vid - VLAN to flush
+ * @param[in] originator_cookie - originator of the flush
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+ctrl_learn_api_fdb_uc_flush_vid_set(unsigned short vid,
+                                    void *originator_cookie)
+{
+    struct fdb_uc_key_filter filter;
+
+    memset(&filter, 0, sizeof(filter));
+    filter.filter_by_vid = FDB_KEY_FILTER_FIELD_VALID;
+    filter.vid = vid;
+    return fdb_flush(OES_FDB_EVENT_FLUSH_VID, &filter, originator_cookie);
+}
+
+/**
+ *  Stand-in of port and VLAN flush
+ *
+ * @param[in] vid - VLAN to flush
+ * @param[in] port - port to flush
+ * @param[in] originator_cookie - originator of the flush
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+ctrl_learn_api_fdb_uc_flush_port_vid_set(unsigned short vid,
+                                         unsigned long port,
+                                         void *originator_cookie)
+{
+    struct fdb_uc_key_filter filter;
+
+    memset(&filter, 0, sizeof(filter));
+    filter.filter_by_vid = FDB_KEY_FILTER_FIELD_VALID;
+    filter.vid = vid;
+    filter.filter_by_log_port = FDB_KEY_FILTER_FIELD_VALID;
+    filter.log_port = port;
+    return fdb_flush(OES_FDB_EVENT_FLUSH_PORT_VID, &filter,
+                     originator_cookie);
+}
+
+/**
+ *  Stand-in of FDB access, the callback runs with the FDB locked
+ *
+ * @param[in] cb - callback
+ * @param[in] data - callback data
+ *
+ * @return callback return code
+ */
+int
+ctrl_learn_api_get_uc_db_access(sim_db_access_cb_t cb, void *data)
+{
+    int err;
+
+    pthread_mutex_lock(&fdb_mutex);
+    err = cb(data);
+    pthread_mutex_unlock(&fdb_mutex);
+    return err;
+}
+
+/**
+ *  This function learns MACs as the switch would
+ *
+ * @param[in] req - learn request
+ *
+ * @return 0 when successful, otherwise ERROR
+ */
+int
+sim_fdb_learn(const struct mlag_sim_ctl_req *req)
+{
+    int err = 0;
+    uint32_t i, j, done, num;
+    uint64_t mac;
+    struct fdb_uc_mac_addr_params *entries = NULL;
+    struct ctrl_learn_fdb_notify_data *data = NULL;
+
+    if ((fdb == NULL) || (req->ports_num == 0)) {
+        return -EPERM;
+    }
+    entries = (struct fdb_uc_mac_addr_params *)
+              calloc(CTRL_LEARN_FDB_NOTIFY_SIZE_MAX, sizeof(*entries));
+    data = (struct ctrl_learn_fdb_notify_data *)malloc(sizeof(*data));
+    if ((entries == NULL) || (data == NULL)) {
+        err = -ENOMEM;
+        goto bail;
+    }
+
+    for (done = 0; (done < req->count) && (err == 0); done += num) {
+        num = req->count - done;
+        if (num > notify_batch) {
+            num = notify_batch;
+        }
+        data->records_num = 0;
+        for (i = 0; i < num; i++) {
+            mac = req->mac_base + done + i;
+            entries[i].entry_type = FDB_UC_AGEABLE;
+            entries[i].mac_addr_params.vid = req->vid;
+            entries[i].mac_addr_params.log_port =
+                req->first_port + ((done + i) % req->ports_num);
+            for (j = 0; j < ETH_ALEN; j++) {
+                entries[i].mac_addr_params.mac_addr.ether_addr_octet[j] =
+                    (mac >> (8 * (ETH_ALEN - 1 - j))) & 0xff;
+            }
+            fdb_record_add(data, OES_FDB_EVENT_LEARN, &entries[i]);
+        }
+        fdb_notify(data, NULL);
+
+        pthread_mutex_lock(&fdb_mutex);
+        for (i = 0; (i < num) && (err == 0); i++) {
+            if (data->records_arr[i].decision ==
+                CTRL_LEARN_NOTIFY_DECISION_APPROVE) {
+                err = fdb_add(&entries[i]);
+            }
+        }
+        pthread_mutex_unlock(&fdb_mutex);
+    }
+
+bail:
+    free(entries);
+    free(data);
+    return err;
+}
+
+/**
+ *  This function gets the number of FDB entries
+ *
+ * @return number of entries
+ */
+uint32_t
+sim_fdb_count(void)
+{
+    uint32_t count;
+
+    pthread_mutex_lock(&fdb_mutex);
+    count = fdb_count;
+    pthread_mutex_unlock(&fdb_mutex);
+    return count;
+}
@@ -32,7 +32,12 @@
 /************************************************
  *  Defines
  ***********************************************/
-#define MLAG_MAX_PORTS          64
+/* Default and upper bound of the runtime maximum of mLAG ports,
+ * see mlag_max_ports_get(). The bound keeps a full port message within
+ * a single IPL message.
+ */
+#define MLAG_MAX_PORTS_DEFAULT  64
+#define MLAG_MAX_PORTS_LIMIT    4096
 #define MLAG_MAX_PEERS          2
 #define MLAG_MAX_IPLS           1
 #define HEALTH_PEER_DOWN_WAIT_TIMER_MS 30000
@@ -37,6 +37,18 @@
  *  Defines
  ***********************************************/
 
+/* One bit per vlan id */
+#define VLAN_BITMAP_SIZE        ((MLAG_VLAN_ID_MAX + 1) / 8)
+/* Encoded vlan states never exceed mask and state bitmaps */
+#define VLAN_STATE_ENC_MAX_LEN  (2 * VLAN_BITMAP_SIZE)
+
+enum vlan_state_encoding {
+    VLAN_STATE_ENC_UP_BITMAP = 0, /* carried vlans bitmap, all up */
+    VLAN_STATE_ENC_DOWN_BITMAP,   /* carried vlans bitmap, all down */
+    VLAN_STATE_ENC_BITMAP,        /* carried vlans bitmap and up bitmap */
+    VLAN_STATE_ENC_RLE,           /* runs of vlans with the same state */
+};
+
 enum mlag_events {
     MLAG_START_EVENT = 0,
     MLAG_STOP_EVENT,
@@ -87,7 +99,7 @@ enum mlag_events {
     /* MLAG_MAC_SYNC_GLOBAL_FLUSH_COMPLETED_EVENT,*/
 
     MLAG_HEALTH_KA_INTERVAL_CHANGE,
-    MLAG_HEALTH_HEARTBEAT_TICK,
+    MLAG_HEALTH_HEARTBEAT_STATE_CHANGE,
     MLAG_HEALTH_FSM_TIMER,
 
     MLAG_MASTER_ELECTION_SWITCH_STATUS_CHANGE_EVENT,
@@ -115,6 +127,16 @@ enum mlag_events {
     MLAG_LACP_RELEASE_EVENT,
     MLAG_LACP_SYS_ID_UPDATE_EVENT,
 
+    MLAG_TUNNELING_IGMP_BATCH_MESSAGE,
+
+    MLAG_PORTS_OPER_STATE_CHANGE_EVENT,
+    MLAG_PEER_PORTS_OPER_STATE_CHANGE,
+
+    MLAG_LACP_SELECTIONS_REQUEST,
+    MLAG_LACP_SELECTIONS_EVENT,
+
+    MLAG_TUNNELING_IGMP_PARAMS_SET,
+
     MLAG_EVENTS_NUM
 };
 
@@ -122,17 +144,37 @@ enum mlag_events {
  *  Macros
  ***********************************************/
 
+/* Size of port events carrying the given number of ports */
+#define PORT_GLOBAL_STATE_EVENT_SIZE(num)               \
+    (sizeof(struct port_global_state_event_data) +      \
+     ((num) * sizeof(struct port_state_entry)))
+#define PORT_CONF_EVENT_SIZE(num)                        \
+    (sizeof(struct port_conf_event_data) +               \
+     ((num) * sizeof(unsigned long)))
+#define PORTS_OPER_STATE_CHANGE_EVENT_SIZE(num)          \
+    (sizeof(struct ports_oper_state_change_data) +       \
+     ((num) * sizeof(struct port_state_entry)))
+
+/* Size of LACP selections request carrying the given number of ports */
+#define LACP_SELECTIONS_REQUEST_EVENT_SIZE(num)          \
+    (sizeof(struct lacp_selections_request_event_data) + \
+     ((num) * sizeof(struct lacp_selection_info)))
+
 /************************************************
  *  Type definitions
  ***********************************************/
 
 #pragma pack(push,1)
 
+struct port_state_entry {
+    uint64_t port_id;
+    int32_t state;
+};
+
 struct port_global_state_event_data {
     uint16_t opcode;
-    int port_num;
-    unsigned long port_id[MLAG_MAX_PORTS];
-    int state[MLAG_MAX_PORTS];
+    int32_t port_num;
+    struct port_state_entry ports[]; /* port_num entries */
 };
 
 struct tcp_conn_notification_event_data {
@@ -151,10 +193,17 @@ struct reconnect_event_data {
 
 struct port_oper_state_change_data {
     uint16_t opcode;
-    int mlag_id;
-    unsigned long port_id;
-    int is_ipl;
-    int state;
+    int32_t mlag_id;
+    uint64_t port_id;
+    int32_t is_ipl;
+    int32_t state;
+};
+
+/* Oper state changes of several non IPL ports, states are OES states */
+struct ports_oper_state_change_data {
+    uint16_t opcode;
+    int32_t port_num;
+    struct port_state_entry ports[]; /* port_num entries */
 };
 
 struct peer_conf_event_data {
@@ -173,8 +222,8 @@ struct conf_ipl_ip_event_data {
 
 struct peer_state_change_data {
     uint16_t opcode;
-    int mlag_id;        /* Peer global ID */
-    int state;
+    int32_t mlag_id;        /* Peer global ID */
+    int32_t state;
 };
 
 struct mgmt_oper_state_change_data {
@@ -187,7 +236,7 @@ struct port_conf_event_data {
     uint16_t opcode;
     int del_ports;
     int port_num;
-    unsigned long ports[MLAG_MAX_PORTS];
+    unsigned long ports[]; /* port_num entries */
 };
 
 
@@ -209,9 +258,19 @@ struct reload_delay_change_data {
     unsigned int msec;
 };
 
+struct heartbeat_state_change_data {
+    uint16_t opcode;
+    int peer_id;
+    unsigned long long system_id;
+    int state; /* heartbeat_state_t */
+    uint64_t jitter_last; /* heartbeat thread wakeup lateness, usec */
+    uint64_t jitter_max;
+};
+
 struct ka_interval_change_data {
     uint16_t opcode;
     unsigned int msec;
+    unsigned int multiplier; /* 0 keeps current multiplier */
 };
 
 struct port_mode_set_event_data {
@@ -236,24 +295,36 @@ struct ipl_port_set_event_data {
     uint32_t ifindex;
 };
 
+struct vlan_state_run {
+    uint16_t vlan_id;   /* little endian */
+    uint16_t vlans_cnt; /* little endian */
+    uint8_t vlan_state;
+};
+
 struct vlan_state_change_base_event_data {
     uint16_t opcode;
-    int peer_id;
-    int vlans_arr_cnt;
+    int32_t peer_id;
+    int32_t vlans_arr_cnt;  /* number of carried vlans */
+    uint8_t encoding;       /* enum vlan_state_encoding */
+    uint16_t data_len;
 };
 
+/* Vlan states are encoded by vlan_state_encode() in a byte order
+ * independent form, see mlag_vlan_bitmap.h */
 struct vlan_state_change_event_data {
     uint16_t opcode;
-    int peer_id;
-    int vlans_arr_cnt;
-    struct vlan_state_info vlan_data[MLAG_VLAN_ID_MAX + 1];
+    int32_t peer_id;
+    int32_t vlans_arr_cnt;  /* number of carried vlans */
+    uint8_t encoding;       /* enum vlan_state_encoding */
+    uint16_t data_len;
+    uint8_t data[VLAN_STATE_ENC_MAX_LEN];
 };
 
 struct sync_event_data {
     uint16_t opcode;
-    int peer_id;
-    int sync_type;
-    int state; /* 0 -start, 1 - finish */
+    int32_t peer_id;
+    int32_t sync_type;
+    int32_t state; /* 0 -start, 1 - finish */
 };
 
 struct timer_event_data {
@@ -266,6 +337,11 @@ struct start_event_data {
     struct mlag_start_params start_params;
 };
 
+struct igmp_params_set_data {
+    uint16_t opcode;
+    struct mlag_igmp_params params;
+};
+
 struct lacp_sys_id_set_data {
     uint16_t opcode;
     unsigned long long sys_id;
@@ -281,6 +357,12 @@ struct lacp_selection_request_event_data {
     unsigned char force;
 };
 
+struct lacp_selections_request_event_data {
+    uint16_t opcode;
+    unsigned int selections_num;
+    struct lacp_selection_info selections[]; /* selections_num entries */
+};
+
 #pragma pack(pop)
 
 /************************************************